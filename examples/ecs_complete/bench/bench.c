@@ -0,0 +1,281 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime, getrusage
+#include "bench.h"
+#include "../components/spatial.h"
+#include "../systems/core_systems.h"
+#include "../systems/frame_arena.h"
+#include "../systems/memory_tracker.h"
+#include "../systems/observers.h"
+#include "../systems/prefabs.h"
+#include "../systems/file_loader.h"
+#include "../systems/impostor.h"
+#include "../systems/text_lod.h"
+#include "../systems/world_stats.h"
+#include "../systems/layout.h"
+#include "../systems/collision.h"
+#include "../systems/picking.h"
+#include "../systems/syntax.h"
+#include "../systems/include_graph.h"
+#include "../systems/symbol_index.h"
+#include "../systems/search_index.h"
+#include "../systems/fuzzy_finder.h"
+#include "../systems/workspace.h"
+#include "../systems/autosave.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+static void BenchJsonKey(BenchContext *ctx, const char *key) {
+    if (ctx->needs_comma[ctx->depth]) {
+        fputc(',', ctx->out);
+    }
+    ctx->needs_comma[ctx->depth] = true;
+    fprintf(ctx->out, "\n%*s", ctx->depth * 2, "");
+    if (key) {
+        fprintf(ctx->out, "\"%s\": ", key);
+    }
+}
+
+static void BenchJsonOpen(BenchContext *ctx, const char *key, char bracket) {
+    BenchJsonKey(ctx, key);
+    fputc(bracket, ctx->out);
+    if (ctx->depth + 1 < BENCH_JSON_MAX_DEPTH) {
+        ctx->depth++;
+    }
+    ctx->needs_comma[ctx->depth] = false;
+}
+
+static void BenchJsonClose(BenchContext *ctx, char bracket) {
+    if (ctx->depth > 0) {
+        ctx->depth--;
+    }
+    fprintf(ctx->out, "\n%*s%c", ctx->depth * 2, "", bracket);
+}
+
+void BenchJsonBeginObject(BenchContext *ctx, const char *key) {
+    BenchJsonOpen(ctx, key, '{');
+}
+
+void BenchJsonEndObject(BenchContext *ctx) {
+    BenchJsonClose(ctx, '}');
+}
+
+void BenchJsonBeginArray(BenchContext *ctx, const char *key) {
+    BenchJsonOpen(ctx, key, '[');
+}
+
+void BenchJsonEndArray(BenchContext *ctx) {
+    BenchJsonClose(ctx, ']');
+}
+
+void BenchJsonInt(BenchContext *ctx, const char *key, int64_t value) {
+    BenchJsonKey(ctx, key);
+    fprintf(ctx->out, "%lld", (long long)value);
+}
+
+void BenchJsonDouble(BenchContext *ctx, const char *key, double value) {
+    BenchJsonKey(ctx, key);
+    if (isfinite(value)) {
+        fprintf(ctx->out, "%.6f", value);
+    } else {
+        fputs("null", ctx->out);  // JSON has no inf/nan
+    }
+}
+
+void BenchJsonString(BenchContext *ctx, const char *key, const char *value) {
+    BenchJsonKey(ctx, key);
+    fputc('"', ctx->out);
+    for (const char *c = value; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', ctx->out);
+            fputc(*c, ctx->out);
+        } else if ((unsigned char)*c < 0x20) {
+            fprintf(ctx->out, "\\u%04x", (unsigned char)*c);
+        } else {
+            fputc(*c, ctx->out);
+        }
+    }
+    fputc('"', ctx->out);
+}
+
+void BenchJsonBool(BenchContext *ctx, const char *key, bool value) {
+    BenchJsonKey(ctx, key);
+    fputs(value ? "true" : "false", ctx->out);
+}
+
+double BenchNowMs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+long BenchMaxRssKb(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;  // Bytes on macOS
+#else
+    return usage.ru_maxrss;         // Kilobytes on Linux
+#endif
+}
+
+// Same module setup as the editor, minus the window and the renderer
+ecs_world_t *BenchCreateEditorWorld(BenchContext *ctx) {
+    ecs_world_t *world = ecs_init();
+
+    RegisterSpatialComponents(world);
+    RegisterCoreSystems(world);
+    RegisterFrameArena(world);
+    RegisterMemoryTracker(world);
+    RegisterObservers(world);
+    RegisterWorldStats(world);
+    RegisterImpostorSystems(world);
+    RegisterTextLODSystems(world);
+    RegisterLayoutSystems(world);
+    RegisterCollisionSystems(world);
+    RegisterPickingSystems(world);
+    RegisterSyntaxSystems(world);
+    RegisterIncludeGraph(world);
+    RegisterSymbolIndex(world);
+    RegisterSearchIndex(world);
+    RegisterFuzzyFinder(world);
+    RegisterWorkspace(world);
+    RegisterAutosave(world);
+    CreatePrefabs(world);
+
+    // Hashed runs need a layout that advances identically every time
+    if (ctx->record_path || ctx->input_path) {
+        LayoutSettings *layout = ecs_singleton_get_mut(world, LayoutSettings);
+        layout->fixed_iterations = 1;
+    }
+
+    ecs_entity_t camera_entity = ecs_new(world);
+    ecs_set_name(world, camera_entity, "MainCamera");
+    ecs_set(world, camera_entity, CameraController, {
+        .target = {0.0f, 0.0f, 0.0f},
+        .distance = 20.0f,
+        .pitch = 30.0f,
+        .yaw = 45.0f,
+        .move_speed = 10.0f,
+        .rotation_speed = 0.5f,
+        .mode = 0
+    });
+
+    ecs_entity_t editor = ecs_new(world);
+    ecs_set_name(world, editor, "Editor");
+    ecs_set(world, editor, EditorState, {
+        .current_mode = 0,
+        .previous_mode = 0,
+        .mode_transition = false,
+        .focused_entity = 0
+    });
+
+    return world;
+}
+
+// Representative C lines: mixed indent, keywords, comments and directives
+static const char *bench_line_templates[] = {
+    "#include <stdio.h>",
+    "// Helper %d: accumulate values into the counter",
+    "static int counter_%d = 0;",
+    "int function_%d(int value) {",
+    "    if (value > %d) {",
+    "        return value * 2;",
+    "    }",
+    "    for (int i = 0; i < %d; i++) {",
+    "        counter_%d += i * value;",
+    "    }",
+    "    return value + counter_%d;",
+    "}",
+};
+
+void BenchSynthesizeFiles(ecs_world_t *world, int files, int lines, ecs_entity_t *out_files) {
+    const int template_count = sizeof(bench_line_templates) / sizeof(bench_line_templates[0]);
+    const float line_spacing = 1.5f;
+    int columns = (int)ceilf(sqrtf((float)files));
+    if (columns < 1) {
+        columns = 1;
+    }
+
+    for (int f = 0; f < files; f++) {
+        char filepath[64];
+        snprintf(filepath, sizeof(filepath), "bench_file_%05d.c", f);
+
+        // Files laid out on a grid in the XZ plane
+        Vector3 origin = {(f % columns) * 15.0f, 0.0f, (f / columns) * 15.0f};
+        ecs_entity_t file_entity = CreateFileContainer(world, filepath, origin);
+        if (out_files) {
+            out_files[f] = file_entity;
+        }
+
+        for (int l = 0; l < lines; l++) {
+            char text[128];
+            snprintf(text, sizeof(text), bench_line_templates[l % template_count], l);
+            Vector3 position = {origin.x, origin.y - (l + 1) * line_spacing, origin.z};
+            CreatePhantomFromLine(world, text, l, filepath, position, file_entity);
+        }
+    }
+}
+
+char *BenchSynthesizeSource(int lines, size_t *out_length) {
+    const int template_count = sizeof(bench_line_templates) / sizeof(bench_line_templates[0]);
+    size_t capacity = (size_t)(lines > 0 ? lines : 1) * 64;
+    char *text = malloc(capacity);
+    size_t length = 0;
+    for (int l = 0; text && l < lines; l++) {
+        char line[128];
+        int line_length = snprintf(line, sizeof(line), bench_line_templates[l % template_count], l);
+        if (length + (size_t)line_length + 1 > capacity) {
+            capacity *= 2;
+            char *grown = realloc(text, capacity);
+            if (!grown) {
+                free(text);
+                return NULL;
+            }
+            text = grown;
+        }
+        memcpy(text + length, line, (size_t)line_length);
+        length += (size_t)line_length;
+        text[length++] = '\n';
+    }
+    *out_length = length;
+    return text;
+}
+
+char *BenchReadFile(const char *path, size_t *out_length) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char *text = size >= 0 ? malloc((size_t)size + 1) : NULL;
+    size_t length = text ? fread(text, 1, (size_t)size, file) : 0;
+    fclose(file);
+    *out_length = length;
+    return text;
+}
+
+void BenchWriteWorldCounts(BenchContext *ctx, ecs_world_t *world) {
+    BenchJsonBeginObject(ctx, "entities");
+    BenchJsonInt(ctx, "all", ecs_count_id(world, EcsAny));
+    const WorldStats *stats = ecs_singleton_get(world, WorldStats);
+    if (stats) {
+        BenchJsonInt(ctx, "spatial", stats->spatial_count);
+        BenchJsonInt(ctx, "text", stats->text_count);
+        BenchJsonInt(ctx, "visible", stats->visible_count);
+        BenchJsonInt(ctx, "selected", stats->selected_count);
+    }
+    const TextLODStats *lod = ecs_singleton_get(world, TextLODStats);
+    if (lod) {
+        BenchJsonInt(ctx, "lod_glyphs", lod->tier_counts[TEXT_LOD_GLYPHS]);
+        BenchJsonInt(ctx, "lod_silhouette", lod->tier_counts[TEXT_LOD_SILHOUETTE]);
+        BenchJsonInt(ctx, "lod_hidden", lod->tier_counts[TEXT_LOD_HIDDEN]);
+    }
+    BenchJsonInt(ctx, "impostors_active", ecs_count_id(world, ImpostorActive));
+    BenchJsonEndObject(ctx);
+}
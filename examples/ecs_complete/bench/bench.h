@@ -0,0 +1,77 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <flecs.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#define BENCH_JSON_MAX_DEPTH 16
+
+// Shared state of one pevi_bench run
+typedef struct {
+    const char *scenario;
+    int files;          // Synthesized files
+    int lines;          // Lines per file
+    int frames;         // Frames to simulate
+    int edits;          // Random edits (buffer)
+    const char *record_path;  // Record the scripted input log (pipeline)
+    const char *input_path;   // Input log to replay (replay)
+    const char *source_path;  // Source file to lex (lexer) or edit (buffer), synthesized if NULL
+
+    // Minimal streaming JSON writer
+    FILE *out;
+    int depth;
+    bool needs_comma[BENCH_JSON_MAX_DEPTH];
+} BenchContext;
+
+// A scenario writes its results as fields of the top-level JSON object
+typedef struct {
+    const char *name;
+    const char *description;
+    int (*run)(BenchContext *ctx);
+} BenchScenario;
+
+// JSON output helpers (keys are ignored inside arrays, pass NULL)
+void BenchJsonBeginObject(BenchContext *ctx, const char *key);
+void BenchJsonEndObject(BenchContext *ctx);
+void BenchJsonBeginArray(BenchContext *ctx, const char *key);
+void BenchJsonEndArray(BenchContext *ctx);
+void BenchJsonInt(BenchContext *ctx, const char *key, int64_t value);
+void BenchJsonDouble(BenchContext *ctx, const char *key, double value);
+void BenchJsonString(BenchContext *ctx, const char *key, const char *value);
+void BenchJsonBool(BenchContext *ctx, const char *key, bool value);
+
+// Shared helpers for scenarios
+double BenchNowMs(void);
+long BenchMaxRssKb(void);
+ecs_world_t *BenchCreateEditorWorld(BenchContext *ctx);
+void BenchSynthesizeFiles(ecs_world_t *world, int files, int lines, ecs_entity_t *out_files);
+char *BenchSynthesizeSource(int lines, size_t *out_length);  // Same line templates, one text
+char *BenchReadFile(const char *path, size_t *out_length);
+void BenchWriteWorldCounts(BenchContext *ctx, ecs_world_t *world);
+
+// Process-wide count of malloc/calloc/realloc calls between Begin and End
+// (glibc only; BenchAllocCountingAvailable is false elsewhere)
+bool BenchAllocCountingAvailable(void);
+void BenchAllocCountingBegin(void);
+int64_t BenchAllocCountingEnd(int64_t *out_bytes);
+
+// Scenarios
+int BenchRunPipeline(BenchContext *ctx);
+int BenchRunReplay(BenchContext *ctx);
+int BenchRunLayout(BenchContext *ctx);
+int BenchRunCollision(BenchContext *ctx);
+int BenchRunPicking(BenchContext *ctx);
+int BenchRunLexer(BenchContext *ctx);
+int BenchRunIncludes(BenchContext *ctx);
+int BenchRunSymbols(BenchContext *ctx);
+int BenchRunSearch(BenchContext *ctx);
+int BenchRunFinder(BenchContext *ctx);
+int BenchRunBuffer(BenchContext *ctx);
+int BenchRunWorkspace(BenchContext *ctx);
+int BenchRunAutosave(BenchContext *ctx);
+int BenchRunArena(BenchContext *ctx);
+int BenchRunMemory(BenchContext *ctx);
+
+#endif // BENCH_H
@@ -0,0 +1,63 @@
+#include "bench.h"
+#include <stdatomic.h>
+#include <stddef.h>
+
+// Counts heap allocations made anywhere in the process (our modules, flecs,
+// libuv, raylib) while a scenario has counting switched on. glibc exports
+// its allocator under __libc_* names, so the bench replaces malloc, calloc
+// and realloc with thin wrappers around them; free needs no wrapper.
+// Allocations made through memalign-style calls are not counted.
+
+static atomic_bool counting = false;
+static atomic_llong allocation_count = 0;
+static atomic_llong allocation_bytes = 0;
+
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static inline void CountAllocation(size_t size) {
+    if (atomic_load_explicit(&counting, memory_order_relaxed)) {
+        atomic_fetch_add_explicit(&allocation_count, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&allocation_bytes, (long long)size, memory_order_relaxed);
+    }
+}
+
+void *malloc(size_t size) {
+    CountAllocation(size);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    CountAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    CountAllocation(size);
+    return __libc_realloc(ptr, size);
+}
+#endif
+
+bool BenchAllocCountingAvailable(void) {
+#ifdef __GLIBC__
+    return true;
+#else
+    return false;
+#endif
+}
+
+void BenchAllocCountingBegin(void) {
+    atomic_store(&allocation_count, 0);
+    atomic_store(&allocation_bytes, 0);
+    atomic_store(&counting, true);
+}
+
+int64_t BenchAllocCountingEnd(int64_t *out_bytes) {
+    atomic_store(&counting, false);
+    if (out_bytes) {
+        *out_bytes = atomic_load(&allocation_bytes);
+    }
+    return atomic_load(&allocation_count);
+}
@@ -0,0 +1,111 @@
+#include "bench.h"
+#include "../components/spatial.h"
+#include "../systems/frame_arena.h"
+#include "../systems/layout.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_ARENA_DT (1.0f / 60.0f)
+
+// Constant-distance orbit with a file dragged every frame, so the layout
+// rebuilds its octree each frame and both orbits cover the same states
+static void BenchArenaInput(InputFrame *input, int frame, int frame_count) {
+    const float rotation_speed = 0.5f;  // Matches the MainCamera controller
+    memset(input, 0, sizeof(*input));
+    input->screen_width = 1200;
+    input->screen_height = 800;
+    input->left_down = true;
+    input->mouse_delta.x = 360.0f / (frame_count * rotation_speed);
+    input->mouse_delta.y = sinf(2.0f * PI * frame / (float)frame_count) * 0.5f;
+}
+
+static void BenchArenaFrame(ecs_world_t *world, const ecs_entity_t *files, int file_count, int frame,
+                            int frame_count) {
+    InputFrame input;
+    BenchArenaInput(&input, frame, frame_count);
+    ecs_singleton_set_ptr(world, InputFrame, &input);
+    float direction = (frame / 30) % 2 == 0 ? 1.0f : -1.0f;
+    LayoutTranslateNode(world, files[frame % file_count], 0.05f * direction, 0.0f, 0.0f);
+    ecs_progress(world, BENCH_ARENA_DT);
+}
+
+// One orbit warms up every pool, GrowArray and arena to its high-water
+// mark; the second, identical orbit must not reach the heap. Every malloc
+// in the process is counted, flecs and libuv included.
+int BenchRunArena(BenchContext *ctx) {
+    ecs_entity_t *files = malloc(sizeof(ecs_entity_t) * (ctx->files > 0 ? ctx->files : 1));
+    if (!files || ctx->files < 1 || ctx->frames < 1) {
+        fprintf(stderr, "The arena scenario needs at least one file and one frame\n");
+        free(files);
+        return 1;
+    }
+
+    ecs_world_t *world = BenchCreateEditorWorld(ctx);
+    BenchSynthesizeFiles(world, ctx->files, ctx->lines, files);
+
+    double start = BenchNowMs();
+    for (int frame = 0; frame < ctx->frames; frame++) {
+        BenchArenaFrame(world, files, ctx->files, frame, ctx->frames);
+    }
+    double warmup_ms = BenchNowMs() - start;
+    const FrameArenaStats *stats = ecs_singleton_get(world, FrameArenaStats);
+    int32_t warmup_chunk_mallocs = stats->chunk_mallocs;
+
+    // Steady state: count per frame to find any frame that allocates
+    int64_t mallocs = 0;
+    int64_t malloc_bytes = 0;
+    int frames_with_mallocs = 0;
+    int64_t arena_allocations = 0;
+    int32_t chunk_mallocs = 0;
+    start = BenchNowMs();
+    for (int frame = 0; frame < ctx->frames; frame++) {
+        BenchAllocCountingBegin();
+        BenchArenaFrame(world, files, ctx->files, frame, ctx->frames);
+        int64_t frame_bytes = 0;
+        int64_t frame_mallocs = BenchAllocCountingEnd(&frame_bytes);
+        mallocs += frame_mallocs;
+        malloc_bytes += frame_bytes;
+        frames_with_mallocs += frame_mallocs > 0;
+
+        stats = ecs_singleton_get(world, FrameArenaStats);
+        arena_allocations += stats->allocations_frame;
+        chunk_mallocs += stats->chunk_mallocs_frame;
+    }
+    double steady_ms = BenchNowMs() - start;
+    stats = ecs_singleton_get(world, FrameArenaStats);
+
+    bool counted = BenchAllocCountingAvailable();
+    bool match = chunk_mallocs == 0 && (!counted || mallocs == 0);
+    if (!counted) {
+        fprintf(stderr, "Allocation counting needs glibc; only arena chunk mallocs were checked\n");
+    } else if (mallocs > 0) {
+        fprintf(stderr, "%lld mallocs (%lld bytes) in %d of %d steady-state frames\n",
+                (long long)mallocs, (long long)malloc_bytes, frames_with_mallocs, ctx->frames);
+    }
+
+    BenchJsonBeginObject(ctx, "arena");
+    BenchJsonInt(ctx, "files", ctx->files);
+    BenchJsonInt(ctx, "frames", ctx->frames);
+    BenchJsonDouble(ctx, "warmup_ms", warmup_ms);
+    BenchJsonDouble(ctx, "steady_ms", steady_ms);
+    BenchJsonBool(ctx, "counted", counted);
+    BenchJsonInt(ctx, "mallocs", mallocs);
+    BenchJsonInt(ctx, "malloc_bytes", malloc_bytes);
+    BenchJsonDouble(ctx, "mallocs_per_frame", (double)mallocs / ctx->frames);
+    BenchJsonInt(ctx, "frames_with_mallocs", frames_with_mallocs);
+    BenchJsonDouble(ctx, "arena_allocations_per_frame", (double)arena_allocations / ctx->frames);
+    BenchJsonInt(ctx, "arenas", stats->arenas);
+    BenchJsonInt(ctx, "capacity_bytes", stats->capacity);
+    BenchJsonInt(ctx, "high_water_bytes", stats->high_water);
+    BenchJsonInt(ctx, "warmup_chunk_mallocs", warmup_chunk_mallocs);
+    BenchJsonInt(ctx, "steady_chunk_mallocs", chunk_mallocs);
+    BenchJsonBool(ctx, "match", match);
+    BenchJsonEndObject(ctx);
+    BenchWriteWorldCounts(ctx, world);
+
+    ecs_fini(world);
+    free(files);
+    BenchJsonInt(ctx, "max_rss_kb", BenchMaxRssKb());
+    return match ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+#define _POSIX_C_SOURCE 200809L  // mkdtemp
+#include "bench.h"
+#include "../components/spatial.h"
+#include "../systems/autosave.h"
+#include "../systems/layout.h"
+#include "../systems/syntax.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BENCH_AUTOSAVE_EDITS_PER_FRAME 4  // Keystrokes landing in one frame
+#define BENCH_AUTOSAVE_DT (1.0f / 60.0f)
+
+// Lines typed into, one file after another, so every save has buffers
+static void BenchAutosaveEdit(ecs_world_t *world, const ecs_entity_t *files, int file_count, int lines,
+                              int edit) {
+    char text[64];
+    snprintf(text, sizeof(text), "    int autosave_edit_%d = %d;", edit, edit);
+    int line = (edit / file_count) % (lines > 0 ? lines : 1);
+    EditFileSyntaxLine(world, files[edit % file_count], line, text);
+}
+
+static bool BenchRecoveredTextMatches(const char *directory, ecs_world_t *world, ecs_entity_t file) {
+    const FileReference *ref = ecs_get(world, file, FileReference);
+    size_t expected_length = 0;
+    const char *expected = GetFileSyntaxText(world, ecs_get(world, file, FileSyntax), &expected_length);
+    if (!ref || !expected) {
+        return false;
+    }
+    char path[1024];
+    AutosaveRecoveryPath(directory, ref->filepath, path, sizeof(path));
+    size_t length = 0;
+    char *text = BenchReadFile(path, &length);
+    bool match = text && length == expected_length && memcmp(text, expected, length) == 0;
+    free(text);
+    return match;
+}
+
+// Runs the editor pipeline with keystrokes in every frame and an autosave
+// captured whenever the last one is written. Reports what a synchronous
+// save would stall a frame for, the main-thread capture time, and the
+// latency from capture to the fsynced rename.
+int BenchRunAutosave(BenchContext *ctx) {
+    char directory[] = "/tmp/pevi_bench_autosave_XXXXXX";
+    ecs_entity_t *files = malloc(sizeof(ecs_entity_t) * (ctx->files > 0 ? ctx->files : 1));
+    if (!files || ctx->files < 1 || !mkdtemp(directory)) {
+        fprintf(stderr, "Failed to set up the autosave directory\n");
+        free(files);
+        return 1;
+    }
+
+    ecs_world_t *world = BenchCreateEditorWorld(ctx);
+    BenchSynthesizeFiles(world, ctx->files, ctx->lines, files);
+    size_t length = 0;
+    char *source = BenchSynthesizeSource(ctx->lines, &length);
+    for (int f = 0; f < ctx->files && source; f++) {
+        AttachFileSyntax(world, files[f], source, length);
+    }
+    free(source);
+    SetAutosaveDirectory(world, directory);
+    AutosaveSettings *settings = ecs_singleton_get_mut(world, AutosaveSettings);
+    settings->interval_s = 0.0f;
+
+    // Baseline: every file edited, captured and written before returning
+    int edit = 0;
+    for (int f = 0; f < ctx->files; f++) {
+        BenchAutosaveEdit(world, files, ctx->files, ctx->lines, edit++);
+    }
+    double start = BenchNowMs();
+    FlushAutosave(world);
+    double sync_ms = BenchNowMs() - start;
+    const AutosaveStats *stats = ecs_singleton_get(world, AutosaveStats);
+    int64_t sync_bytes = stats->bytes;
+
+    // Frames: the capture is the only autosave work on the main thread
+    int captures = stats->captures;
+    int saves = stats->saves;
+    int frame_captures = 0;
+    int frame_saves = 0;
+    double capture_total_ms = 0.0;
+    double capture_max_ms = 0.0;
+    double latency_total_ms = 0.0;
+    double latency_max_ms = 0.0;
+    double frame_max_ms = 0.0;
+    for (int frame = 0; frame < ctx->frames; frame++) {
+        for (int k = 0; k < BENCH_AUTOSAVE_EDITS_PER_FRAME; k++) {
+            BenchAutosaveEdit(world, files, ctx->files, ctx->lines, edit++);
+        }
+        LayoutTranslateNode(world, files[frame % ctx->files], 0.01f, 0.0f, 0.0f);
+
+        double frame_start = BenchNowMs();
+        ecs_progress(world, BENCH_AUTOSAVE_DT);
+        double frame_ms = BenchNowMs() - frame_start;
+        frame_max_ms = frame_ms > frame_max_ms ? frame_ms : frame_max_ms;
+
+        stats = ecs_singleton_get(world, AutosaveStats);
+        if (stats->captures != captures) {
+            capture_total_ms += stats->capture_ms;
+            capture_max_ms = stats->capture_ms > capture_max_ms ? stats->capture_ms : capture_max_ms;
+            frame_captures += stats->captures - captures;
+            captures = stats->captures;
+        }
+        if (stats->saves != saves) {
+            latency_total_ms += stats->latency_ms;
+            latency_max_ms = stats->latency_ms > latency_max_ms ? stats->latency_ms : latency_max_ms;
+            frame_saves += stats->saves - saves;
+            saves = stats->saves;
+        }
+    }
+    FlushAutosave(world);
+    stats = ecs_singleton_get(world, AutosaveStats);
+
+    // The saved texts are the edited buffers, and the layout puts a moved
+    // file back
+    bool match = stats->failures == 0 && BenchRecoveredTextMatches(directory, world, files[0]) &&
+                 BenchRecoveredTextMatches(directory, world, files[ctx->files - 1]);
+    Position before = *ecs_get(world, files[0], Position);
+    LayoutTranslateNode(world, files[0], 100.0f, 0.0f, 0.0f);
+    int restored = RestoreAutosaveLayout(world, directory);
+    const Position *after = ecs_get(world, files[0], Position);
+    match = match && restored == ctx->files && fabsf(after->x - before.x) < 1e-3f &&
+            fabsf(after->z - before.z) < 1e-3f;
+
+    BenchJsonBeginObject(ctx, "autosave");
+    BenchJsonInt(ctx, "files", ctx->files);
+    BenchJsonInt(ctx, "frames", ctx->frames);
+    BenchJsonDouble(ctx, "sync_save_ms", sync_ms);
+    BenchJsonInt(ctx, "sync_save_bytes", sync_bytes);
+    BenchJsonInt(ctx, "captures", frame_captures);
+    BenchJsonInt(ctx, "saves", frame_saves);
+    BenchJsonInt(ctx, "deferred", stats->deferred);
+    BenchJsonDouble(ctx, "capture_mean_ms", frame_captures > 0 ? capture_total_ms / frame_captures : 0.0);
+    BenchJsonDouble(ctx, "capture_max_ms", capture_max_ms);
+    BenchJsonDouble(ctx, "latency_mean_ms", frame_saves > 0 ? latency_total_ms / frame_saves : 0.0);
+    BenchJsonDouble(ctx, "latency_max_ms", latency_max_ms);
+    BenchJsonDouble(ctx, "write_ms", stats->write_ms);
+    BenchJsonInt(ctx, "bytes_last", stats->bytes);
+    BenchJsonInt(ctx, "bytes_total", stats->bytes_total);
+    BenchJsonDouble(ctx, "frame_max_ms", frame_max_ms);
+    BenchJsonBool(ctx, "match", match);
+    BenchJsonEndObject(ctx);
+    BenchWriteWorldCounts(ctx, world);
+
+    for (int f = 0; f < ctx->files; f++) {
+        const FileReference *ref = ecs_get(world, files[f], FileReference);
+        char path[1024];
+        AutosaveRecoveryPath(directory, ref->filepath, path, sizeof(path));
+        unlink(path);
+    }
+    char layout_path[1024];
+    snprintf(layout_path, sizeof(layout_path), "%s/layout.pval", directory);
+    unlink(layout_path);
+    rmdir(directory);
+    ecs_fini(world);
+    free(files);
+    BenchJsonInt(ctx, "max_rss_kb", BenchMaxRssKb());
+    return match ? 0 : 1;
+}
@@ -0,0 +1,287 @@
+#define _POSIX_C_SOURCE 200809L  // mkstemp
+#include "bench.h"
+#include "../systems/text_buffer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BENCH_BUFFER_CHECK_BYTES (1 << 20)  // Text edited against a flat copy
+#define BENCH_BUFFER_CHECK_EDITS 20000
+#define BENCH_BUFFER_LOOKUPS 100000
+#define BENCH_BUFFER_FLAT_EDITS 100
+#define BENCH_BUFFER_PASTE_LINES 10000
+#define BENCH_BUFFER_PASTE_ROUNDS 100
+#define BENCH_BUFFER_HISTORY_EDITS 100000
+#define BENCH_BUFFER_HISTORY_STEP 8      // Edits per undo step
+#define BENCH_BUFFER_HISTORY_CAP (2u << 20)
+
+// Deterministic LCG so every run makes the same edits
+static uint32_t BenchRandom(uint32_t *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// Wide enough for offsets past 16M (BenchRandom keeps 24 bits)
+static size_t BenchRandomBelow(uint32_t *state, size_t bound) {
+    uint64_t value = ((uint64_t)BenchRandom(state) << 24) | BenchRandom(state);
+    return bound > 0 ? (size_t)(value % bound) : 0;
+}
+
+// One random single-character edit, mirrored in flat when it is not NULL
+static bool BenchRandomEdit(TextBuffer *buffer, char *flat, size_t *length, uint32_t *seed) {
+    if (BenchRandom(seed) % 2 == 0 || *length == 0) {
+        size_t offset = BenchRandomBelow(seed, *length + 1);
+        char c = BenchRandom(seed) % 16 == 0 ? '\n' : (char)('a' + BenchRandom(seed) % 26);
+        if (!TextBufferInsert(buffer, offset, &c, 1)) {
+            return false;
+        }
+        if (flat) {
+            memmove(flat + offset + 1, flat + offset, *length - offset);
+            flat[offset] = c;
+        }
+        (*length)++;
+    } else {
+        size_t offset = BenchRandomBelow(seed, *length);
+        if (!TextBufferDelete(buffer, offset, 1)) {
+            return false;
+        }
+        if (flat) {
+            memmove(flat + offset, flat + offset + 1, *length - offset - 1);
+        }
+        (*length)--;
+    }
+    return true;
+}
+
+// Edits the start of the text both in a piece table and in a flat copy,
+// then compares the contents and every line start
+static bool BenchCheckBuffer(const char *text, size_t length) {
+    size_t check_length = length < BENCH_BUFFER_CHECK_BYTES ? length : BENCH_BUFFER_CHECK_BYTES;
+    size_t capacity = check_length + BENCH_BUFFER_CHECK_EDITS + 1;
+    char *flat = malloc(capacity);
+    char *read = malloc(capacity);
+    TextBuffer buffer;
+    if (!flat || !read || !TextBufferInit(&buffer, text, check_length)) {
+        free(flat);
+        free(read);
+        return false;
+    }
+    memcpy(flat, text, check_length);
+
+    bool match = true;
+    uint32_t seed = 4242;
+    for (int e = 0; e < BENCH_BUFFER_CHECK_EDITS && match; e++) {
+        match = BenchRandomEdit(&buffer, flat, &check_length, &seed);
+    }
+    match = match && TextBufferLength(&buffer) == check_length &&
+            TextBufferRead(&buffer, 0, read, check_length) == check_length &&
+            memcmp(read, flat, check_length) == 0;
+
+    int line = 0;
+    for (size_t i = 0; i < check_length && match; i++) {
+        if (flat[i] == '\n') {
+            match = TextBufferLineStart(&buffer, ++line) == i + 1;
+        }
+    }
+    match = match && TextBufferNewlines(&buffer) == (size_t)line &&
+            TextBufferLineStart(&buffer, line + 1) == check_length;
+
+    TextBufferFree(&buffer);
+    free(flat);
+    free(read);
+    return match;
+}
+
+// Pastes the block into the middle of the text, then undoes and redoes it
+// `rounds` times; the text must read back the same after every step
+static bool BenchUndoPaste(TextBuffer *buffer, const char *paste, size_t paste_length, int rounds,
+                           double *undo_us, double *redo_us) {
+    size_t length = TextBufferLength(buffer);
+    size_t offset = TextBufferLineStart(buffer, (int)(TextBufferNewlines(buffer) / 2));
+    char before[64];
+    char *read = malloc(paste_length);
+    size_t context = TextBufferRead(buffer, offset, before, sizeof(before));
+    TextBufferCheckpoint(buffer);
+    bool match = read && TextBufferInsert(buffer, offset, paste, paste_length);
+    TextBufferCheckpoint(buffer);
+
+    double undo_ms = 0.0;
+    double redo_ms = 0.0;
+    char after[64];
+    TextChange change;
+    for (int r = 0; r < rounds && match; r++) {
+        double start = BenchNowMs();
+        match = TextBufferUndo(buffer, &change);
+        undo_ms += BenchNowMs() - start;
+        match = match && TextBufferLength(buffer) == length &&
+                TextBufferRead(buffer, offset, after, context) == context && memcmp(before, after, context) == 0;
+
+        start = BenchNowMs();
+        match = match && TextBufferRedo(buffer, &change);
+        redo_ms += BenchNowMs() - start;
+        match = match && TextBufferLength(buffer) == length + paste_length &&
+                TextBufferRead(buffer, offset, read, paste_length) == paste_length &&
+                memcmp(read, paste, paste_length) == 0;
+    }
+    match = match && TextBufferUndo(buffer, &change) && TextBufferLength(buffer) == length;
+    free(read);
+    *undo_us = rounds > 0 ? undo_ms * 1e3 / rounds : 0.0;
+    *redo_us = rounds > 0 ? redo_ms * 1e3 / rounds : 0.0;
+    return match;
+}
+
+// Writes the synthesized source to a temporary file so it is loaded the
+// way a real file is: mapped, not copied
+static bool BenchWriteTempSource(int lines, char *path, size_t path_size) {
+    size_t length;
+    char *text = BenchSynthesizeSource(lines, &length);
+    snprintf(path, path_size, "/tmp/pevi_bench_buffer_XXXXXX");
+    int fd = text ? mkstemp(path) : -1;
+    FILE *file = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    bool written = file && fwrite(text, 1, length, file) == length;
+    if (file) {
+        fclose(file);
+    } else if (fd >= 0) {
+        close(fd);
+    }
+    free(text);
+    return written;
+}
+
+// Maps --source FILE (or N x M synthesized lines) into a piece table and
+// makes K random single-character inserts and deletes, against a flat
+// array where every edit moves the tail of the text
+int BenchRunBuffer(BenchContext *ctx) {
+    char temp_path[64] = {0};
+    const char *path = ctx->source_path;
+    if (!path) {
+        if (!BenchWriteTempSource(ctx->files * ctx->lines, temp_path, sizeof(temp_path))) {
+            fprintf(stderr, "Failed to write synthesized source\n");
+            return 1;
+        }
+        path = temp_path;
+    }
+
+    TextBuffer buffer;
+    double start = BenchNowMs();
+    bool loaded = TextBufferInitMapped(&buffer, path);
+    double load_ms = BenchNowMs() - start;
+    if (temp_path[0]) {
+        unlink(temp_path);  // The mapping stays valid
+    }
+    if (!loaded) {
+        fprintf(stderr, "Failed to load source: %s\n", path);
+        return 1;
+    }
+    size_t length;
+    const char *text = TextBufferContiguous(&buffer, &length);
+    size_t original_length = length;
+
+    BenchJsonBeginObject(ctx, "buffer");
+    BenchJsonInt(ctx, "bytes", (int64_t)length);
+    BenchJsonInt(ctx, "lines", (int64_t)TextBufferNewlines(&buffer));
+    BenchJsonDouble(ctx, "load_ms", load_ms);
+
+    start = BenchNowMs();
+    bool match = BenchCheckBuffer(text, length);
+    BenchJsonDouble(ctx, "check_ms", BenchNowMs() - start);
+
+    // Flat baseline on a copy: a few edits, each a memmove of the tail
+    char *flat = malloc(length + BENCH_BUFFER_FLAT_EDITS + 1);
+    double flat_us = 0.0;
+    if (flat) {
+        memcpy(flat, text, length);
+        size_t flat_length = length;
+        uint32_t seed = 99;
+        start = BenchNowMs();
+        for (int e = 0; e < BENCH_BUFFER_FLAT_EDITS; e++) {
+            size_t offset = BenchRandomBelow(&seed, flat_length);
+            memmove(flat + offset + 1, flat + offset, flat_length - offset);
+            flat[offset] = 'x';
+            flat_length++;
+        }
+        flat_us = (BenchNowMs() - start) * 1e3 / BENCH_BUFFER_FLAT_EDITS;
+        free(flat);
+    }
+
+    uint32_t seed = 1234;
+    bool edited = true;
+    start = BenchNowMs();
+    for (int e = 0; e < ctx->edits && edited; e++) {
+        edited = BenchRandomEdit(&buffer, NULL, &length, &seed);
+    }
+    double edit_ms = BenchNowMs() - start;
+    match &= edited && TextBufferLength(&buffer) == length;
+
+    size_t newlines = TextBufferNewlines(&buffer);
+    size_t checksum = 0;
+    start = BenchNowMs();
+    for (int i = 0; i < BENCH_BUFFER_LOOKUPS; i++) {
+        checksum += TextBufferLineStart(&buffer, (int)BenchRandomBelow(&seed, newlines + 1));
+    }
+    double lookup_ms = BenchNowMs() - start;
+
+    BenchJsonInt(ctx, "edits", ctx->edits);
+    BenchJsonDouble(ctx, "edit_ms", edit_ms);
+    BenchJsonDouble(ctx, "edits_per_s", edit_ms > 0.0 ? ctx->edits / (edit_ms / 1e3) : 0.0);
+    BenchJsonDouble(ctx, "mean_edit_us", ctx->edits > 0 ? edit_ms * 1e3 / ctx->edits : 0.0);
+    BenchJsonDouble(ctx, "flat_mean_edit_us", flat_us);
+    BenchJsonDouble(ctx, "mean_line_lookup_us", lookup_ms * 1e3 / BENCH_BUFFER_LOOKUPS);
+    BenchJsonInt(ctx, "line_lookup_checksum", (int64_t)checksum);
+    BenchJsonInt(ctx, "pieces", TextBufferPieceCount(&buffer));
+    BenchJsonInt(ctx, "memory_bytes", (int64_t)TextBufferMemory(&buffer));
+    BenchJsonInt(ctx, "final_bytes", (int64_t)length);
+    BenchJsonInt(ctx, "original_bytes", (int64_t)original_length);
+
+    // Undo history: edits in small steps under the memory cap (the oldest
+    // steps are merged into the base), then a 10k-line paste undone and
+    // redone on the full text and on a 1 MB text. Both take the same time.
+    TextBufferEnableHistory(&buffer, BENCH_BUFFER_HISTORY_CAP);
+    start = BenchNowMs();
+    for (int e = 0; e < BENCH_BUFFER_HISTORY_EDITS && edited; e++) {
+        if (e % BENCH_BUFFER_HISTORY_STEP == 0) {
+            TextBufferCheckpoint(&buffer);
+        }
+        edited = BenchRandomEdit(&buffer, NULL, &length, &seed);
+    }
+    double history_ms = BenchNowMs() - start;
+    match &= edited && buffer.journal.memory <= BENCH_BUFFER_HISTORY_CAP;
+
+    size_t paste_length;
+    char *paste = BenchSynthesizeSource(BENCH_BUFFER_PASTE_LINES, &paste_length);
+    double undo_us = 0.0, redo_us = 0.0, small_undo_us = 0.0, small_redo_us = 0.0;
+    TextBuffer small;
+    size_t small_length = original_length < BENCH_BUFFER_CHECK_BYTES ? original_length : BENCH_BUFFER_CHECK_BYTES;
+    if (paste && TextBufferInit(&small, text, small_length)) {
+        TextBufferEnableHistory(&small, BENCH_BUFFER_HISTORY_CAP);
+        match &= BenchUndoPaste(&buffer, paste, paste_length, BENCH_BUFFER_PASTE_ROUNDS, &undo_us, &redo_us);
+        match &= BenchUndoPaste(&small, paste, paste_length, BENCH_BUFFER_PASTE_ROUNDS, &small_undo_us, &small_redo_us);
+        TextBufferFree(&small);
+    } else {
+        match = false;
+    }
+    free(paste);
+
+    BenchJsonBeginObject(ctx, "undo");
+    BenchJsonInt(ctx, "history_edits", BENCH_BUFFER_HISTORY_EDITS);
+    BenchJsonDouble(ctx, "mean_history_edit_us", history_ms * 1e3 / BENCH_BUFFER_HISTORY_EDITS);
+    BenchJsonInt(ctx, "memory_cap_bytes", BENCH_BUFFER_HISTORY_CAP);
+    BenchJsonInt(ctx, "history_memory_bytes", (int64_t)buffer.journal.memory);
+    BenchJsonInt(ctx, "undo_steps", TextBufferUndoSteps(&buffer));
+    BenchJsonInt(ctx, "steps_merged", buffer.journal.steps_merged);
+    BenchJsonInt(ctx, "paste_lines", BENCH_BUFFER_PASTE_LINES);
+    BenchJsonInt(ctx, "paste_bytes", (int64_t)paste_length);
+    BenchJsonDouble(ctx, "paste_undo_us", undo_us);
+    BenchJsonDouble(ctx, "paste_redo_us", redo_us);
+    BenchJsonInt(ctx, "small_bytes", (int64_t)small_length);
+    BenchJsonDouble(ctx, "small_paste_undo_us", small_undo_us);
+    BenchJsonDouble(ctx, "small_paste_redo_us", small_redo_us);
+    BenchJsonEndObject(ctx);
+
+    BenchJsonBool(ctx, "match", match);
+    BenchJsonEndObject(ctx);
+
+    TextBufferFree(&buffer);
+    BenchJsonInt(ctx, "max_rss_kb", BenchMaxRssKb());
+    return match ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+#include "bench.h"
+#include "../components/spatial.h"
+#include "../systems/collision.h"
+#include <math.h>
+
+#define BENCH_PANEL_HALF_WIDTH 4.0f
+#define BENCH_PANEL_HALF_HEIGHT 2.0f
+#define BENCH_PANEL_COVERAGE 0.5f   // Summed panel area relative to the scatter area
+
+// Deterministic LCG so every run scatters the same panels
+static uint32_t BenchRandom(uint32_t *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// Scatters N panels in one plane densely enough that most of them overlap,
+// then runs the pipeline until the broadphase reports no overlap
+int BenchRunCollision(BenchContext *ctx) {
+    if (!CollisionAvailable()) {
+        BenchJsonBool(ctx, "available", false);
+        return 1;
+    }
+
+    double setup_start = BenchNowMs();
+    ecs_world_t *world = BenchCreateEditorWorld(ctx);
+
+    float panel_area = 4.0f * BENCH_PANEL_HALF_WIDTH * BENCH_PANEL_HALF_HEIGHT;
+    float side = sqrtf(ctx->files * panel_area / BENCH_PANEL_COVERAGE);
+    uint32_t seed = 4242;
+    for (int i = 0; i < ctx->files; i++) {
+        ecs_entity_t panel = ecs_new(world);
+        float x = (BenchRandom(&seed) % 65536) / 65536.0f * side - side * 0.5f;
+        float y = (BenchRandom(&seed) % 65536) / 65536.0f * side - side * 0.5f;
+        ecs_set(world, panel, Position, {x, y, 0.0f});
+        AttachCollisionPanel(world, panel, (Vector3){BENCH_PANEL_HALF_WIDTH, BENCH_PANEL_HALF_HEIGHT, 0.5f});
+    }
+    double setup_ms = BenchNowMs() - setup_start;
+
+    const float dt = 1.0f / 60.0f;
+    int frames = 0;
+    int overlaps_first = -1;
+    int64_t overlaps_total = 0;
+    int64_t queries_total = 0;
+    int64_t pushes_total = 0;
+    double insert_ms = 0.0;
+    double resolve_ms_total = 0.0;
+    double resolve_ms_max = 0.0;
+    bool resolved = false;
+    double run_start = BenchNowMs();
+    while (frames < ctx->frames && !resolved) {
+        ecs_progress(world, dt);
+        frames++;
+
+        const CollisionStats *stats = ecs_singleton_get(world, CollisionStats);
+        if (stats->inserted_frame > 0) {
+            insert_ms += stats->insert_ms;
+        }
+        if (overlaps_first < 0) {
+            overlaps_first = stats->overlaps_frame;
+        }
+        overlaps_total += stats->overlaps_frame;
+        queries_total += stats->queries_frame;
+        pushes_total += stats->moved_frame;
+        resolve_ms_total += stats->frame_ms;
+        if (stats->frame_ms > resolve_ms_max) {
+            resolve_ms_max = stats->frame_ms;
+        }
+        resolved = stats->resolved;
+    }
+    double run_ms = BenchNowMs() - run_start;
+
+    const CollisionStats *stats = ecs_singleton_get(world, CollisionStats);
+    const CollisionSettings *settings = ecs_singleton_get(world, CollisionSettings);
+    BenchJsonDouble(ctx, "setup_ms", setup_ms);
+    BenchJsonBeginObject(ctx, "collision");
+    BenchJsonInt(ctx, "panels", stats->panels);
+    BenchJsonInt(ctx, "batches", stats->batches);
+    BenchJsonDouble(ctx, "batch_insert_ms", insert_ms);
+    BenchJsonInt(ctx, "max_passes", settings->max_passes);
+    BenchJsonBool(ctx, "resolved", resolved);
+    BenchJsonInt(ctx, "frames", frames);
+    BenchJsonInt(ctx, "overlaps_first_frame", overlaps_first);
+    BenchJsonInt(ctx, "overlaps_total", (int)overlaps_total);
+    BenchJsonInt(ctx, "queries_total", (int)queries_total);
+    BenchJsonInt(ctx, "panel_moves_total", (int)pushes_total);
+    BenchJsonDouble(ctx, "resolve_ms_total", resolve_ms_total);
+    BenchJsonDouble(ctx, "resolve_ms_max", resolve_ms_max);
+    BenchJsonDouble(ctx, "seconds_to_resolve", resolved ? run_ms / 1000.0 : -1.0);
+    BenchJsonEndObject(ctx);
+    BenchJsonDouble(ctx, "run_ms", run_ms);
+
+    BenchWriteWorldCounts(ctx, world);
+    ecs_fini(world);
+    BenchJsonInt(ctx, "max_rss_kb", BenchMaxRssKb());
+    return resolved ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+#include "bench.h"
+#include "../systems/fuzzy_finder.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_FINDER_FILE_EVERY 16    // One file path per this many candidates
+#define BENCH_FINDER_NAME_LENGTH 96
+
+// Deterministic LCG so every run ranks the same names
+static uint32_t BenchRandom(uint32_t *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+static const char *const modules[] = {
+    "core", "render", "physics", "audio", "net", "ui", "editor", "script", "assets", "platform"
+};
+static const char *const verbs[] = {
+    "get", "set", "update", "create", "destroy", "load", "save", "draw", "find", "resolve", "parse", "apply"
+};
+static const char *const nouns[] = {
+    "widget", "buffer", "texture", "camera", "layout", "symbol", "window", "shader", "entity", "socket",
+    "glyph", "panel", "stream", "cache"
+};
+
+#define PICK(list, seed) list[BenchRandom(seed) % (sizeof(list) / sizeof(list[0]))]
+
+// Paths like src/render/shader/load_texture_123.c, functions like
+// update_camera_42 or DrawPanelCache (every other function is camelCase)
+static void SynthesizeName(uint32_t *seed, int index, char *name) {
+    uint32_t n = BenchRandom(seed) % 1000;
+    if (index % BENCH_FINDER_FILE_EVERY == 0) {
+        snprintf(name, BENCH_FINDER_NAME_LENGTH, "src/%s/%s/%s_%s_%u.c", PICK(modules, seed), PICK(nouns, seed),
+                 PICK(verbs, seed), PICK(nouns, seed), n);
+    } else if (index % 2) {
+        snprintf(name, BENCH_FINDER_NAME_LENGTH, "%s_%s_%u", PICK(verbs, seed), PICK(nouns, seed), n);
+    } else {
+        snprintf(name, BENCH_FINDER_NAME_LENGTH, "%s%s%s", PICK(verbs, seed), PICK(nouns, seed), PICK(nouns, seed));
+        name[0] = (char)toupper((unsigned char)name[0]);
+    }
+}
+
+// Case-folded subsequence test: the baseline the finder's match count has
+// to agree with
+static bool NaiveMatch(const char *name, const char *query, bool case_sensitive) {
+    for (; *name && *query; name++) {
+        char a = case_sensitive ? *name : (char)tolower((unsigned char)*name);
+        char b = case_sensitive ? *query : (char)tolower((unsigned char)*query);
+        query += a == b;
+    }
+    return *query == '\0';
+}
+
+typedef struct {
+    const char *name;
+    const char *typed;        // Typed one character per keystroke
+} BenchFinderSession;
+
+static const BenchFinderSession sessions[] = {
+    {"symbol", "updcam"},
+    {"camel_case", "DrPaCa"},
+    {"path", "rend/shad/load"},
+    {"digits", "tex_12"},
+};
+
+// Ranks N x M synthesized file paths and function names (not attached to
+// entities) while "typing" each session one keystroke at a time, checking
+// every keystroke's match count against a naive scan
+int BenchRunFinder(BenchContext *ctx) {
+    int count = ctx->files * ctx->lines;
+    FinderCandidate *candidates = malloc(sizeof(FinderCandidate) * (count > 0 ? count : 1));
+    char *names = malloc((size_t)BENCH_FINDER_NAME_LENGTH * (count > 0 ? count : 1));
+    if (!candidates || !names) {
+        free(candidates);
+        free(names);
+        return 1;
+    }
+
+    double setup_start = BenchNowMs();
+    ecs_world_t *world = BenchCreateEditorWorld(ctx);
+    uint32_t seed = 777;
+    for (int i = 0; i < count; i++) {
+        char *name = names + (size_t)i * BENCH_FINDER_NAME_LENGTH;
+        SynthesizeName(&seed, i, name);
+        candidates[i] = (FinderCandidate){0, name, i % BENCH_FINDER_FILE_EVERY == 0 ? FINDER_FILE : FINDER_SYMBOL};
+    }
+    double setup_ms = BenchNowMs() - setup_start;
+
+    double start = BenchNowMs();
+    int kept = SetFinderCandidates(world, candidates, count);
+    double intern_ms = BenchNowMs() - start;
+    FinderStats interned = *ecs_singleton_get(world, FinderStats);
+
+    BenchJsonDouble(ctx, "setup_ms", setup_ms);
+    BenchJsonBeginObject(ctx, "finder");
+    BenchJsonInt(ctx, "candidates", kept);
+    BenchJsonInt(ctx, "files", interned.files);
+    BenchJsonInt(ctx, "names", interned.names);
+    BenchJsonDouble(ctx, "intern_ms", intern_ms);
+
+    bool all_match = true;
+    double max_keystroke_ms = 0.0;
+    FinderResult results[FINDER_MAX_RESULTS];
+    int session_count = (int)(sizeof(sessions) / sizeof(sessions[0]));
+    for (int s = 0; s < session_count; s++) {
+        const char *typed = sessions[s].typed;
+        size_t typed_length = strlen(typed);
+
+        BenchJsonBeginArray(ctx, sessions[s].name);
+        char query[FINDER_MAX_QUERY];
+        for (size_t length = 1; length <= typed_length; length++) {
+            memcpy(query, typed, length);
+            query[length] = '\0';
+            start = BenchNowMs();
+            int matches = FindFuzzy(world, query, results, FINDER_MAX_RESULTS);
+            double keystroke_ms = BenchNowMs() - start;
+            FinderStats stats = *ecs_singleton_get(world, FinderStats);
+            max_keystroke_ms = keystroke_ms > max_keystroke_ms ? keystroke_ms : max_keystroke_ms;
+
+            // The query so far is case-sensitive only once it has a capital
+            bool sensitive = false;
+            for (size_t i = 0; i < length; i++) {
+                sensitive |= isupper((unsigned char)query[i]) != 0;
+            }
+            int expected = 0;
+            for (int i = 0; i < count; i++) {
+                expected += NaiveMatch(candidates[i].name, query, sensitive);
+            }
+            bool ranked = true;
+            int shown = matches < FINDER_MAX_RESULTS ? matches : FINDER_MAX_RESULTS;
+            for (int r = 1; r < shown; r++) {
+                ranked &= results[r - 1].score >= results[r].score;
+            }
+            bool match = matches == expected && ranked;
+            all_match &= match;
+
+            BenchJsonBeginObject(ctx, NULL);
+            BenchJsonString(ctx, "query", query);
+            BenchJsonBool(ctx, "incremental", stats.incremental);
+            BenchJsonInt(ctx, "scanned", stats.scanned);
+            BenchJsonInt(ctx, "prefiltered", stats.prefiltered);
+            BenchJsonInt(ctx, "matches", matches);
+            BenchJsonInt(ctx, "expected", expected);
+            BenchJsonString(ctx, "best", shown > 0 ? GetFinderCandidateName(world, results[0].candidate) : "");
+            BenchJsonInt(ctx, "best_score", shown > 0 ? results[0].score : 0);
+            BenchJsonDouble(ctx, "query_ms", keystroke_ms);
+            BenchJsonBool(ctx, "match", match);
+            BenchJsonEndObject(ctx);
+        }
+        BenchJsonEndArray(ctx);
+    }
+
+    // Each whole query again without the previous matches: the full
+    // prefilter and scan
+    double max_cold_ms = 0.0;
+    for (int s = 0; s < session_count; s++) {
+        SetFinderCandidates(world, candidates, count);
+        start = BenchNowMs();
+        FindFuzzy(world, sessions[s].typed, results, FINDER_MAX_RESULTS);
+        double cold_ms = BenchNowMs() - start;
+        max_cold_ms = cold_ms > max_cold_ms ? cold_ms : max_cold_ms;
+    }
+
+    BenchJsonInt(ctx, "threads", ecs_singleton_get(world, FinderStats)->threads);
+    BenchJsonDouble(ctx, "max_keystroke_ms", max_keystroke_ms);
+    BenchJsonDouble(ctx, "max_cold_query_ms", max_cold_ms);
+    BenchJsonBool(ctx, "all_match", all_match);
+    BenchJsonEndObject(ctx);
+
+    BenchWriteWorldCounts(ctx, world);
+    free(candidates);
+    free(names);
+    ecs_fini(world);
+    BenchJsonInt(ctx, "max_rss_kb", BenchMaxRssKb());
+    return all_match ? 0 : 1;
+}
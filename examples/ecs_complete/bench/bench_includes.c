@@ -0,0 +1,146 @@
+#include "bench.h"
+#include "../components/spatial.h"
+#include "../systems/include_graph.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_INCLUDE_MODULE_SIZE 32   // Files per synthetic directory
+
+// Deterministic LCG so every run builds the same tree
+static uint32_t BenchRandom(uint32_t *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// File f lives in src/modNNNN/ and is a header if f is odd. Each file
+// includes headers of its own directory (quoted, relative), headers of
+// other directories through the "src" include path, two system headers and
+// one generated header that does not exist.
+static char *SynthesizeIncludeFile(int f, int files, int body_lines, uint32_t *seed, size_t *out_length) {
+    int module = f / BENCH_INCLUDE_MODULE_SIZE;
+    int module_start = module * BENCH_INCLUDE_MODULE_SIZE;
+    int module_size = files - module_start < BENCH_INCLUDE_MODULE_SIZE ? files - module_start : BENCH_INCLUDE_MODULE_SIZE;
+
+    size_t body_length = 0;
+    char *body = BenchSynthesizeSource(body_lines, &body_length);
+    size_t capacity = body_length + 1024;
+    char *text = malloc(capacity);
+    if (!text) {
+        free(body);
+        return NULL;
+    }
+
+    size_t length = 0;
+    length += (size_t)snprintf(text + length, capacity - length, "#include <stdio.h>\n#include <stdlib.h>\n");
+    for (int k = 0; k < 4; k++) {
+        int j = (module_start + (int)(BenchRandom(seed) % module_size)) | 1;
+        if (j < files) {
+            length += (size_t)snprintf(text + length, capacity - length, "#include \"file%05d.h\"\n", j);
+        }
+    }
+    for (int k = 0; k < 2; k++) {
+        int j = (int)(BenchRandom(seed) % files) | 1;
+        if (j < files) {
+            length += (size_t)snprintf(text + length, capacity - length, "#include \"mod%04d/file%05d.h\"\n",
+                                       j / BENCH_INCLUDE_MODULE_SIZE, j);
+        }
+    }
+    length += (size_t)snprintf(text + length, capacity - length, "#include \"generated/config.h\"\n");
+    if (body) {
+        memcpy(text + length, body, body_length);
+        length += body_length;
+        free(body);
+    }
+    *out_length = length;
+    return text;
+}
+
+static void WriteScan(BenchContext *ctx, const char *key, const IncludeStats *stats) {
+    BenchJsonBeginObject(ctx, key);
+    BenchJsonInt(ctx, "directives", stats->directives);
+    BenchJsonInt(ctx, "requests", stats->requests);
+    BenchJsonInt(ctx, "resolved", stats->resolved);
+    BenchJsonInt(ctx, "unresolved", stats->unresolved);
+    BenchJsonInt(ctx, "headers", stats->headers);
+    BenchJsonInt(ctx, "headers_created", stats->headers_created);
+    BenchJsonInt(ctx, "edges", stats->edges);
+    BenchJsonDouble(ctx, "scan_ms", stats->scan_ms);
+    BenchJsonDouble(ctx, "resolve_ms", stats->resolve_ms);
+    BenchJsonDouble(ctx, "apply_ms", stats->apply_ms);
+    BenchJsonDouble(ctx, "total_ms", stats->scan_ms + stats->resolve_ms + stats->apply_ms);
+    BenchJsonEndObject(ctx);
+}
+
+// Extracts the include graph of a synthesized N-file tree, then scans it
+// again: the rescan must reuse every header and produce the same edges
+int BenchRunIncludes(BenchContext *ctx) {
+    if (ctx->files < 1) {
+        fprintf(stderr, "includes needs at least one file\n");
+        return 1;
+    }
+
+    double setup_start = BenchNowMs();
+    ecs_world_t *world = BenchCreateEditorWorld(ctx);
+    IncludeSettings *settings = ecs_singleton_get_mut(world, IncludeSettings);
+    settings->path_count = 0;
+    AddIncludePath(world, "src");
+    AddIncludePath(world, "/usr/local/include");
+    AddIncludePath(world, "/usr/include");
+
+    IncludeSource *sources = calloc((size_t)ctx->files, sizeof(IncludeSource));
+    char (*paths)[64] = malloc(sizeof(*paths) * (size_t)ctx->files);
+    if (!sources || !paths) {
+        free(sources);
+        free(paths);
+        ecs_fini(world);
+        return 1;
+    }
+    int64_t bytes = 0;
+    uint32_t seed = 777;
+    for (int f = 0; f < ctx->files; f++) {
+        snprintf(paths[f], sizeof(paths[f]), "src/mod%04d/file%05d.%s", f / BENCH_INCLUDE_MODULE_SIZE, f,
+                 (f & 1) ? "h" : "c");
+        sources[f].file = ecs_new(world);
+        sources[f].path = paths[f];
+        sources[f].text = SynthesizeIncludeFile(f, ctx->files, ctx->lines, &seed, &sources[f].length);
+        bytes += (int64_t)sources[f].length;
+    }
+    double setup_ms = BenchNowMs() - setup_start;
+
+    double start = BenchNowMs();
+    int edges = ScanIncludes(world, sources, ctx->files);
+    double first_ms = BenchNowMs() - start;
+    IncludeStats first = *ecs_singleton_get(world, IncludeStats);
+
+    start = BenchNowMs();
+    int rescan_edges = ScanIncludes(world, sources, ctx->files);
+    double rescan_ms = BenchNowMs() - start;
+    const IncludeStats *rescan = ecs_singleton_get(world, IncludeStats);
+
+    int32_t pairs = ecs_count_id(world, ecs_pair(Includes, EcsWildcard));
+    bool stable = rescan_edges == edges && rescan->headers_created == 0;
+
+    BenchJsonDouble(ctx, "setup_ms", setup_ms);
+    BenchJsonBeginObject(ctx, "includes");
+    BenchJsonInt(ctx, "files", ctx->files);
+    BenchJsonInt(ctx, "bytes", bytes);
+    BenchJsonInt(ctx, "threads", first.threads);
+    BenchJsonBool(ctx, "check_filesystem", ecs_singleton_get(world, IncludeSettings)->check_filesystem);
+    BenchJsonDouble(ctx, "first_wall_ms", first_ms);
+    WriteScan(ctx, "first", &first);
+    BenchJsonDouble(ctx, "rescan_wall_ms", rescan_ms);
+    WriteScan(ctx, "rescan", rescan);
+    BenchJsonInt(ctx, "entities_with_includes", pairs);
+    BenchJsonBool(ctx, "rescan_stable", stable);
+    BenchJsonEndObject(ctx);
+
+    BenchWriteWorldCounts(ctx, world);
+    for (int f = 0; f < ctx->files; f++) {
+        free((char*)sources[f].text);
+    }
+    free(sources);
+    free(paths);
+    ecs_fini(world);
+    BenchJsonInt(ctx, "max_rss_kb", BenchMaxRssKb());
+    return stable ? 0 : 1;
+}
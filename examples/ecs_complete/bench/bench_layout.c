@@ -0,0 +1,144 @@
+#include "bench.h"
+#include "../components/spatial.h"
+#include "../systems/layout.h"
+#include "../systems/job_pool.h"
+#include <stdlib.h>
+
+#define BENCH_MODULE_SIZE 32   // Files per synthetic module
+
+// Deterministic LCG so every run builds the same graph
+static uint32_t BenchRandom(uint32_t *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// Modules of densely connected files plus sparse cross-module includes,
+// roughly the shape of a real include graph
+static int SynthesizeIncludes(ecs_world_t *world, const ecs_entity_t *files, int count) {
+    uint32_t seed = 12345;
+    int edges = 0;
+    for (int i = 0; i < count; i++) {
+        int module_start = (i / BENCH_MODULE_SIZE) * BENCH_MODULE_SIZE;
+        int module_size = count - module_start < BENCH_MODULE_SIZE ? count - module_start : BENCH_MODULE_SIZE;
+        for (int k = 0; k < 2; k++) {
+            int j = module_start + (int)(BenchRandom(&seed) % module_size);
+            if (j != i) {
+                ecs_add_pair(world, files[i], Includes, files[j]);
+                edges++;
+            }
+        }
+        if (BenchRandom(&seed) % 8 == 0) {
+            int j = (int)(BenchRandom(&seed) % count);
+            if (j != i) {
+                ecs_add_pair(world, files[i], Includes, files[j]);
+                edges++;
+            }
+        }
+    }
+    return edges;
+}
+
+// Runs the editor pipeline until the solver settles or the frame budget ends
+static bool RunUntilConverged(ecs_world_t *world, int max_frames, int *frames,
+                              double *layout_ms_total, double *layout_ms_max) {
+    // The editor pipeline runs around the solver, as it would interactively
+    const float dt = 1.0f / 60.0f;
+    bool converged = false;
+    while (*frames < max_frames && !converged) {
+        ecs_progress(world, dt);
+        (*frames)++;
+
+        const LayoutStats *stats = ecs_singleton_get(world, LayoutStats);
+        *layout_ms_total += stats->frame_ms;
+        if (stats->frame_ms > *layout_ms_max) {
+            *layout_ms_max = stats->frame_ms;
+        }
+        converged = stats->converged;
+    }
+    return converged;
+}
+
+// Adds one file that includes a few existing ones, as when the user opens a
+// file into a settled workspace, and measures the local re-settle
+static void BenchIncrementalEdit(BenchContext *ctx, ecs_world_t *world, const ecs_entity_t *files) {
+    ecs_entity_t added = 0;
+    BenchSynthesizeFiles(world, 1, ctx->lines, &added);
+    uint32_t seed = 777;
+    for (int k = 0; k < 3; k++) {
+        ecs_add_pair(world, added, Includes, files[BenchRandom(&seed) % ctx->files]);
+    }
+
+    int frames = 0;
+    double layout_ms_total = 0.0, layout_ms_max = 0.0;
+    double start = BenchNowMs();
+    bool converged = RunUntilConverged(world, ctx->frames, &frames, &layout_ms_total, &layout_ms_max);
+    double run_ms = BenchNowMs() - start;
+
+    const LayoutStats *stats = ecs_singleton_get(world, LayoutStats);
+    BenchJsonBeginObject(ctx, "incremental");
+    BenchJsonBool(ctx, "converged", converged);
+    BenchJsonBool(ctx, "local", stats->solve_incremental);
+    BenchJsonInt(ctx, "active_nodes", stats->solve_active);
+    BenchJsonInt(ctx, "moved_nodes", stats->solve_moved);
+    BenchJsonInt(ctx, "iterations", stats->solve_iterations);
+    BenchJsonInt(ctx, "frames", frames);
+    BenchJsonDouble(ctx, "solve_ms", stats->solve_ms);
+    BenchJsonDouble(ctx, "solver_ms_max", layout_ms_max);
+    BenchJsonDouble(ctx, "run_ms", run_ms);
+    BenchJsonEndObject(ctx);
+}
+
+int BenchRunLayout(BenchContext *ctx) {
+    ecs_entity_t *files = malloc(sizeof(ecs_entity_t) * (ctx->files > 0 ? ctx->files : 1));
+    if (!files) {
+        printf("Failed to allocate file list\n");
+        return 1;
+    }
+
+    double setup_start = BenchNowMs();
+    ecs_world_t *world = BenchCreateEditorWorld(ctx);
+    BenchSynthesizeFiles(world, ctx->files, ctx->lines, files);
+    int edges = SynthesizeIncludes(world, files, ctx->files);
+    double setup_ms = BenchNowMs() - setup_start;
+
+    double layout_ms_total = 0.0;
+    double layout_ms_max = 0.0;
+    int frames = 0;
+    double run_start = BenchNowMs();
+    bool converged = RunUntilConverged(world, ctx->frames, &frames, &layout_ms_total, &layout_ms_max);
+    double run_ms = BenchNowMs() - run_start;
+
+    const LayoutStats *stats = ecs_singleton_get(world, LayoutStats);
+    const LayoutSettings *settings = ecs_singleton_get(world, LayoutSettings);
+    BenchJsonDouble(ctx, "setup_ms", setup_ms);
+    BenchJsonBeginObject(ctx, "layout");
+    BenchJsonInt(ctx, "nodes", stats->nodes);
+    BenchJsonInt(ctx, "edges", stats->edges);
+    BenchJsonInt(ctx, "edges_requested", edges);
+    BenchJsonInt(ctx, "worker_threads", JobPoolDefaultThreads());
+    BenchJsonDouble(ctx, "time_budget_ms", settings->time_budget_ms);
+    BenchJsonDouble(ctx, "theta", settings->theta);
+    BenchJsonBool(ctx, "converged", converged);
+    BenchJsonInt(ctx, "frames", frames);
+    BenchJsonInt(ctx, "iterations", stats->iterations_total);
+    BenchJsonDouble(ctx, "seconds_to_converge", converged ? run_ms / 1000.0 : -1.0);
+    BenchJsonDouble(ctx, "solver_ms_per_frame", frames > 0 ? layout_ms_total / frames : 0.0);
+    BenchJsonDouble(ctx, "solver_ms_max", layout_ms_max);
+    BenchJsonDouble(ctx, "solver_ms_per_iteration",
+                    stats->iterations_total > 0 ? layout_ms_total / stats->iterations_total : 0.0);
+    BenchJsonDouble(ctx, "mean_displacement", stats->mean_displacement);
+    BenchJsonDouble(ctx, "energy", stats->energy);
+    BenchJsonEndObject(ctx);
+    BenchJsonDouble(ctx, "run_ms", run_ms);
+
+    if (converged && ctx->files > 0) {
+        BenchIncrementalEdit(ctx, world, files);
+    }
+
+    BenchWriteWorldCounts(ctx, world);
+    ecs_fini(world);
+    BenchJsonInt(ctx, "max_rss_kb", BenchMaxRssKb());
+
+    free(files);
+    return converged ? 0 : 1;
+}
@@ -0,0 +1,206 @@
+#include "bench.h"
+#include "../systems/lexer.h"
+#include "../systems/job_pool.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_LEX_RUNS 5
+#define BENCH_LEX_TARGET_MB_PER_S 500.0
+#define BENCH_LEX_EDITS 1000
+
+// Deterministic LCG so every run edits the same lines
+static uint32_t BenchRandom(uint32_t *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// The source text with at most one line replaced
+typedef struct {
+    const char *text;
+    const uint32_t *line_offset;
+    int edited_line;
+    const char *edited_text;
+    size_t edited_length;
+} BenchEditSource;
+
+static const char *BenchEditLine(void *ctx, int line, size_t *length) {
+    const BenchEditSource *source = ctx;
+    if (line == source->edited_line) {
+        *length = source->edited_length;
+        return source->edited_text;
+    }
+    *length = source->line_offset[line + 1] - source->line_offset[line];
+    return source->text + source->line_offset[line];
+}
+
+typedef struct {
+    int64_t lines;
+    int max_lines;
+    double total_us;
+} BenchEditTotals;
+
+static void WriteEditTotals(BenchContext *ctx, const char *key, const BenchEditTotals *totals, int edits) {
+    BenchJsonBeginObject(ctx, key);
+    BenchJsonDouble(ctx, "mean_lines_relexed", edits > 0 ? (double)totals->lines / edits : 0.0);
+    BenchJsonInt(ctx, "max_lines_relexed", totals->max_lines);
+    BenchJsonDouble(ctx, "mean_us", edits > 0 ? totals->total_us / edits : 0.0);
+    BenchJsonEndObject(ctx);
+}
+
+// Replaces one line with prefix + line + suffix, re-lexes incrementally
+// and restores it; only the edit itself is counted
+static void BenchEdit(TokenBuffer *tokens, BenchEditSource *source, int line,
+                      const char *prefix, const char *suffix, char *scratch, BenchEditTotals *totals) {
+    size_t length = source->line_offset[line + 1] - source->line_offset[line];
+    const char *original = source->text + source->line_offset[line];
+    size_t content = length;
+    while (content > 0 && (original[content - 1] == '\n' || original[content - 1] == '\r')) {
+        content--;
+    }
+    size_t prefix_length = strlen(prefix);
+    size_t suffix_length = strlen(suffix);
+    memcpy(scratch, prefix, prefix_length);
+    memcpy(scratch + prefix_length, original, content);
+    memcpy(scratch + prefix_length + content, suffix, suffix_length);
+    memcpy(scratch + prefix_length + content + suffix_length, original + content, length - content);
+
+    source->edited_line = line;
+    source->edited_text = scratch;
+    source->edited_length = length + prefix_length + suffix_length;
+    double start = BenchNowMs();
+    int relexed = LexEditLines(tokens, line, 1, 1, BenchEditLine, source);
+    totals->total_us += (BenchNowMs() - start) * 1e3;
+    totals->lines += relexed;
+    if (relexed > totals->max_lines) {
+        totals->max_lines = relexed;
+    }
+
+    source->edited_line = -1;
+    LexEditLines(tokens, line, 1, 1, BenchEditLine, source);
+}
+
+static double MegabytesPerSecond(size_t bytes, double ms) {
+    return ms > 0.0 ? (double)bytes / 1e6 / (ms / 1e3) : 0.0;
+}
+
+static bool SameTokens(const TokenBuffer *a, const TokenBuffer *b) {
+    return a->line_count == b->line_count && a->token_count == b->token_count &&
+           memcmp(a->line_first, b->line_first, sizeof(uint32_t) * (a->line_count + 1)) == 0 &&
+           memcmp(a->line_state, b->line_state, a->line_count) == 0 &&
+           memcmp(a->token_column, b->token_column, sizeof(uint16_t) * a->token_count) == 0 &&
+           memcmp(a->token_length, b->token_length, sizeof(uint16_t) * a->token_count) == 0 &&
+           memcmp(a->token_kind, b->token_kind, a->token_count) == 0;
+}
+
+// Lexes one large source (e.g. the Flecs amalgamation, distr/flecs.c) on
+// one core and across the job pool, best of several runs each, and checks
+// that the parallel spans are identical to the serial ones. Then measures
+// incremental re-lexing of single-line edits, which are reverted so the
+// spans must again match the parallel result.
+int BenchRunLexer(BenchContext *ctx) {
+    size_t length = 0;
+    char *text = ctx->source_path ? BenchReadFile(ctx->source_path, &length)
+                                  : BenchSynthesizeSource(ctx->files * ctx->lines, &length);
+    if (!text) {
+        fprintf(stderr, "lexer: failed to read %s\n", ctx->source_path ? ctx->source_path : "synthesized source");
+        return 1;
+    }
+
+    TokenBuffer serial, parallel;
+    TokenBufferInit(&serial);
+    TokenBufferInit(&parallel);
+
+    double serial_ms = 0.0;
+    for (int run = 0; run < BENCH_LEX_RUNS; run++) {
+        TokenBufferClear(&serial);
+        double start = BenchNowMs();
+        LexBuffer(text, length, LEX_STATE_CODE, &serial);
+        double ms = BenchNowMs() - start;
+        if (run == 0 || ms < serial_ms) {
+            serial_ms = ms;
+        }
+    }
+
+    int threads = JobPoolDefaultThreads();
+    JobPool *pool = JobPoolCreate(threads);
+    double parallel_ms = 0.0;
+    int relexed = 0;
+    for (int run = 0; run < BENCH_LEX_RUNS; run++) {
+        TokenBufferClear(&parallel);
+        double start = BenchNowMs();
+        relexed = LexBufferParallel(pool, text, length, &parallel);
+        double ms = BenchNowMs() - start;
+        if (run == 0 || ms < parallel_ms) {
+            parallel_ms = ms;
+        }
+    }
+    int workers = JobPoolWorkerCount(pool);
+    JobPoolDestroy(pool);
+
+    bool matches = SameTokens(&serial, &parallel);
+
+    // Line starts in the lexer's numbering (a final newline adds no line)
+    uint32_t *line_offset = malloc(sizeof(uint32_t) * (serial.line_count + 1));
+    char *scratch = malloc(length + 8);
+    BenchEditTotals append = {0}, comment = {0};
+    int edits = 0;
+    bool edits_restored = false;
+    if (line_offset && scratch && serial.line_count > 0) {
+        int line = 0;
+        line_offset[0] = 0;
+        for (size_t i = 0; i < length && line < serial.line_count; i++) {
+            if (text[i] == '\n') {
+                line_offset[++line] = (uint32_t)i + 1;
+            }
+        }
+        line_offset[serial.line_count] = (uint32_t)length;
+
+        // Typing at the end of a line normally re-lexes just that line;
+        // opening a block comment re-lexes up to the next "*/"
+        BenchEditSource source = {.text = text, .line_offset = line_offset, .edited_line = -1};
+        uint32_t seed = 4321;
+        for (edits = 0; edits < BENCH_LEX_EDITS; edits++) {
+            int target = (int)(BenchRandom(&seed) % (uint32_t)serial.line_count);
+            BenchEdit(&serial, &source, target, "", " x", scratch, &append);
+            BenchEdit(&serial, &source, target, "/*", "", scratch, &comment);
+        }
+        edits_restored = SameTokens(&serial, &parallel);
+    }
+    free(line_offset);
+    free(scratch);
+    int64_t kind_counts[TOKEN_KIND_COUNT] = {0};
+    for (int32_t t = 0; t < serial.token_count; t++) {
+        kind_counts[serial.token_kind[t]]++;
+    }
+    double serial_mb_per_s = MegabytesPerSecond(length, serial_ms);
+
+    BenchJsonBeginObject(ctx, "lexer");
+    BenchJsonInt(ctx, "bytes", (int64_t)length);
+    BenchJsonInt(ctx, "lines", serial.line_count);
+    BenchJsonInt(ctx, "tokens", serial.token_count);
+    BenchJsonInt(ctx, "runs", BENCH_LEX_RUNS);
+    BenchJsonDouble(ctx, "serial_ms", serial_ms);
+    BenchJsonDouble(ctx, "serial_mb_per_s", serial_mb_per_s);
+    BenchJsonBool(ctx, "serial_meets_target", serial_mb_per_s >= BENCH_LEX_TARGET_MB_PER_S);
+    BenchJsonInt(ctx, "threads", workers + 1);
+    BenchJsonDouble(ctx, "parallel_ms", parallel_ms);
+    BenchJsonDouble(ctx, "parallel_mb_per_s", MegabytesPerSecond(length, parallel_ms));
+    BenchJsonInt(ctx, "chunks_relexed", relexed);
+    BenchJsonBool(ctx, "parallel_matches_serial", matches);
+    BenchJsonInt(ctx, "edits", edits);
+    WriteEditTotals(ctx, "edit_append", &append, edits);
+    WriteEditTotals(ctx, "edit_open_comment", &comment, edits);
+    BenchJsonBool(ctx, "edits_restored", edits_restored);
+    BenchJsonBeginObject(ctx, "kinds");
+    for (int k = 0; k < TOKEN_KIND_COUNT; k++) {
+        BenchJsonInt(ctx, TokenKindName((TokenKind)k), kind_counts[k]);
+    }
+    BenchJsonEndObject(ctx);
+    BenchJsonEndObject(ctx);
+
+    TokenBufferFree(&serial);
+    TokenBufferFree(&parallel);
+    free(text);
+    BenchJsonInt(ctx, "max_rss_kb", BenchMaxRssKb());
+    return matches && (edits == 0 || edits_restored) ? 0 : 1;
+}
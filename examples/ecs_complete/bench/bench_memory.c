@@ -0,0 +1,95 @@
+#include "bench.h"
+#include "../systems/memory_tracker.h"
+#include "../systems/syntax.h"
+#include "../systems/world_stats.h"
+#include <stdlib.h>
+
+#define BENCH_MEMORY_SETTLE_FRAMES 60  // Frames for indexes and LOD to settle
+
+static void BenchWriteMemoryTags(BenchContext *ctx, const MemoryTagStats *before, const MemoryTagStats *now) {
+    BenchJsonBeginObject(ctx, "tags");
+    for (int t = 0; t < MEMORY_TAG_COUNT; t++) {
+        BenchJsonBeginObject(ctx, MemoryTagName(t));
+        BenchJsonInt(ctx, "live", now[t].live - before[t].live);
+        BenchJsonInt(ctx, "peak", now[t].peak);
+        BenchJsonInt(ctx, "allocations", now[t].allocations - before[t].allocations);
+        BenchJsonInt(ctx, "bytes_allocated", now[t].bytes_allocated - before[t].bytes_allocated);
+        BenchJsonEndObject(ctx);
+    }
+    BenchJsonEndObject(ctx);
+}
+
+// Opens N files x M lines with syntax, lets the editor settle and reports
+// what each subsystem holds. A one-byte ECS budget must be flagged, and
+// flecs must give back everything it allocated once the world is gone.
+int BenchRunMemory(BenchContext *ctx) {
+    MemoryTagStats before[MEMORY_TAG_COUNT];
+    GetMemoryTagStats(before);
+
+    double start = BenchNowMs();
+    ecs_world_t *world = BenchCreateEditorWorld(ctx);
+    ecs_entity_t *files = malloc(sizeof(ecs_entity_t) * (ctx->files > 0 ? ctx->files : 1));
+    if (!files) {
+        fprintf(stderr, "Failed to allocate file entities\n");
+        ecs_fini(world);
+        return 1;
+    }
+    BenchSynthesizeFiles(world, ctx->files, ctx->lines, files);
+    size_t length = 0;
+    char *source = BenchSynthesizeSource(ctx->lines, &length);
+    for (int f = 0; f < ctx->files && source; f++) {
+        AttachFileSyntax(world, files[f], source, length);
+    }
+    free(source);
+    for (int frame = 0; frame < BENCH_MEMORY_SETTLE_FRAMES; frame++) {
+        ecs_progress(world, 1.0f / 60.0f);
+    }
+    double load_ms = BenchNowMs() - start;
+
+    MemoryTagStats loaded[MEMORY_TAG_COUNT];
+    GetMemoryTagStats(loaded);
+    int64_t live = 0;
+    for (int t = 0; t < MEMORY_TAG_COUNT; t++) {
+        live += loaded[t].live - before[t].live;
+    }
+    const WorldStats *world_stats = ecs_singleton_get(world, WorldStats);
+    int phantoms = world_stats ? world_stats->text_count - ctx->files : 0;
+    int64_t ecs_live = loaded[MEMORY_TAG_ECS].live - before[MEMORY_TAG_ECS].live;
+
+    // Budget enforcement: the next frame flags the tag and the total
+    SetMemoryBudget(world, MEMORY_TAG_ECS, 1);
+    SetMemoryBudget(world, -1, 1);
+    ecs_progress(world, 1.0f / 60.0f);
+    const MemoryStats *stats = ecs_singleton_get(world, MemoryStats);
+    bool flagged = stats->tags[MEMORY_TAG_ECS].over_budget && stats->over_budget >= 2;
+
+    ecs_fini(world);
+    free(files);
+    MemoryTagStats after[MEMORY_TAG_COUNT];
+    GetMemoryTagStats(after);
+    int64_t ecs_leaked = after[MEMORY_TAG_ECS].live - before[MEMORY_TAG_ECS].live;
+    int64_t retained = 0;
+    for (int t = 0; t < MEMORY_TAG_COUNT; t++) {
+        retained += after[t].live - before[t].live;
+    }
+
+    // Frame arenas live for the process, so only flecs is held to zero
+    bool match = ecs_live > 0 && loaded[MEMORY_TAG_TEXT].live > before[MEMORY_TAG_TEXT].live &&
+                 loaded[MEMORY_TAG_SYNTAX].live > before[MEMORY_TAG_SYNTAX].live && flagged && ecs_leaked == 0;
+
+    BenchJsonBeginObject(ctx, "memory");
+    BenchJsonInt(ctx, "files", ctx->files);
+    BenchJsonInt(ctx, "phantoms", phantoms);
+    BenchJsonDouble(ctx, "load_ms", load_ms);
+    BenchJsonInt(ctx, "live_bytes", live);
+    BenchJsonDouble(ctx, "ecs_bytes_per_phantom", phantoms > 0 ? (double)ecs_live / phantoms : 0.0);
+    BenchJsonDouble(ctx, "bytes_per_phantom", phantoms > 0 ? (double)live / phantoms : 0.0);
+    BenchWriteMemoryTags(ctx, before, loaded);
+    BenchJsonBool(ctx, "budget_flagged", flagged);
+    BenchJsonInt(ctx, "ecs_leaked_bytes", ecs_leaked);
+    BenchJsonInt(ctx, "retained_bytes", retained);
+    BenchJsonBool(ctx, "match", match);
+    BenchJsonEndObject(ctx);
+    BenchJsonInt(ctx, "max_rss_kb", BenchMaxRssKb());
+    return match ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+#include "bench.h"
+#include "../components/spatial.h"
+#include "../systems/layout.h"
+#include "../systems/picking.h"
+#include <stdlib.h>
+
+#define BENCH_PICK_RAYS 2000
+#define BENCH_PICK_REGIONS 200
+#define BENCH_PICK_REGION_RADIUS 6.0f
+#define BENCH_PICK_BOX_HALF 4.0f
+
+// Deterministic LCG so every run casts the same rays
+static uint32_t BenchRandom(uint32_t *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+typedef struct {
+    double total_us;
+    double max_us;
+    int64_t candidates;
+    int hits;
+} BenchPickTotals;
+
+static void AddQuery(BenchPickTotals *totals, const PickingStats *stats) {
+    totals->total_us += stats->query_us;
+    if (stats->query_us > totals->max_us) {
+        totals->max_us = stats->query_us;
+    }
+    totals->candidates += stats->candidates;
+    totals->hits += stats->hits;
+}
+
+static void WriteTotals(BenchContext *ctx, const char *key, const BenchPickTotals *totals, int queries) {
+    BenchJsonBeginObject(ctx, key);
+    BenchJsonDouble(ctx, "mean_us", totals->total_us / queries);
+    BenchJsonDouble(ctx, "max_us", totals->max_us);
+    BenchJsonDouble(ctx, "mean_candidates", (double)totals->candidates / queries);
+    BenchJsonInt(ctx, "hits", totals->hits);
+    BenchJsonEndObject(ctx);
+}
+
+// Casts the same rays and region selects through both backends over
+// N files x M line phantoms and checks that they agree. A build with Jolt
+// fails if the broadphase backend did not come up, so a run cannot pass
+// without comparing anything.
+int BenchRunPicking(BenchContext *ctx) {
+    if (ctx->files < 1) {
+        fprintf(stderr, "picking needs at least one file\n");
+        return 1;
+    }
+
+    double setup_start = BenchNowMs();
+    ecs_world_t *world = BenchCreateEditorWorld(ctx);
+    // Files stay on their grid so only the explicit move below syncs bodies
+    ecs_singleton_get_mut(world, LayoutSettings)->enabled = false;
+    ecs_entity_t *files = malloc(sizeof(ecs_entity_t) * ctx->files);
+    BenchSynthesizeFiles(world, ctx->files, ctx->lines, files);
+    ecs_progress(world, 1.0f / 60.0f);  // Transforms and the first proxy batch
+    double setup_ms = BenchNowMs() - setup_start;
+
+    PickingSettings *settings = ecs_singleton_get_mut(world, PickingSettings);
+    const PickingStats *stats = ecs_singleton_get(world, PickingStats);
+    bool jolt = settings->backend == PICK_BACKEND_JOLT;
+    int32_t inserted_first = stats->inserted_frame;
+#ifdef PEVI_WITH_JOLT
+    if (!jolt) {
+        fprintf(stderr, "picking: built with Jolt but the broadphase backend is not active\n");
+        free(files);
+        ecs_fini(world);
+        return 1;
+    }
+#endif
+
+    // Rays aim at random line phantoms from a short distance in front of them
+    BenchPickTotals scan_rays = {0}, jolt_rays = {0};
+    int ray_mismatches = 0;
+    uint32_t seed = 1234;
+    for (int r = 0; r < BENCH_PICK_RAYS; r++) {
+        ecs_entity_t file = files[BenchRandom(&seed) % ctx->files];
+        const Position *origin = ecs_get(world, file, Position);
+        float line = (float)(BenchRandom(&seed) % (ctx->lines > 0 ? ctx->lines : 1)) + 1.0f;
+        Ray ray = {
+            .position = {origin->x + 0.1f, origin->y - line * 1.5f + 0.1f, origin->z - 20.0f},
+            .direction = {0.0f, 0.0f, 1.0f}
+        };
+
+        settings->backend = PICK_BACKEND_SCAN;
+        ecs_entity_t scan_hit = PickPhantom(world, ray, NULL);
+        AddQuery(&scan_rays, stats);
+        if (jolt) {
+            settings->backend = PICK_BACKEND_JOLT;
+            ecs_entity_t jolt_hit = PickPhantom(world, ray, NULL);
+            AddQuery(&jolt_rays, stats);
+            ray_mismatches += jolt_hit != scan_hit;
+        }
+    }
+
+    // Even selects are spheres, odd ones boxes (CollideSphere / CollideAABox)
+    BenchPickTotals scan_regions = {0}, jolt_regions = {0};
+    BenchPickTotals scan_boxes = {0}, jolt_boxes = {0};
+    int region_mismatches = 0;
+    for (int r = 0; r < BENCH_PICK_REGIONS; r++) {
+        ecs_entity_t file = files[BenchRandom(&seed) % ctx->files];
+        const Position *origin = ecs_get(world, file, Position);
+        Vector3 center = {origin->x, origin->y - ctx->lines * 0.75f, origin->z};
+        bool is_box = r % 2 == 1;
+        BoundingBox box = {
+            {center.x - BENCH_PICK_BOX_HALF, center.y - BENCH_PICK_BOX_HALF, center.z - BENCH_PICK_BOX_HALF},
+            {center.x + BENCH_PICK_BOX_HALF, center.y + BENCH_PICK_BOX_HALF, center.z + BENCH_PICK_BOX_HALF}
+        };
+
+        settings->backend = PICK_BACKEND_SCAN;
+        int scan_count = is_box ? SelectPhantomsInBox(world, box)
+                                : SelectPhantomsInSphere(world, center, BENCH_PICK_REGION_RADIUS);
+        AddQuery(is_box ? &scan_boxes : &scan_regions, stats);
+        if (jolt) {
+            settings->backend = PICK_BACKEND_JOLT;
+            int jolt_count = is_box ? SelectPhantomsInBox(world, box)
+                                    : SelectPhantomsInSphere(world, center, BENCH_PICK_REGION_RADIUS);
+            AddQuery(is_box ? &jolt_boxes : &jolt_regions, stats);
+            region_mismatches += jolt_count != scan_count;
+        }
+    }
+    settings->backend = jolt ? PICK_BACKEND_JOLT : PICK_BACKEND_SCAN;
+
+    // Moving one file must only move the bodies of its own lines
+    LayoutTranslateNode(world, files[0], 3.0f, 0.0f, 0.0f);
+    ecs_progress(world, 1.0f / 60.0f);
+    int32_t synced_after_move = stats->synced_frame;
+
+    BenchJsonDouble(ctx, "setup_ms", setup_ms);
+    BenchJsonBeginObject(ctx, "picking");
+    BenchJsonBool(ctx, "jolt", jolt);
+    BenchJsonInt(ctx, "proxies", stats->proxies);
+    BenchJsonInt(ctx, "inserted_first_frame", inserted_first);
+    BenchJsonInt(ctx, "synced_after_file_move", synced_after_move);
+    BenchJsonInt(ctx, "rays", BENCH_PICK_RAYS);
+    WriteTotals(ctx, "scan_ray", &scan_rays, BENCH_PICK_RAYS);
+    if (jolt) {
+        WriteTotals(ctx, "jolt_ray", &jolt_rays, BENCH_PICK_RAYS);
+    }
+    BenchJsonInt(ctx, "ray_mismatches", ray_mismatches);
+    BenchJsonInt(ctx, "regions", BENCH_PICK_REGIONS);
+    WriteTotals(ctx, "scan_sphere", &scan_regions, (BENCH_PICK_REGIONS + 1) / 2);
+    WriteTotals(ctx, "scan_box", &scan_boxes, BENCH_PICK_REGIONS / 2);
+    if (jolt) {
+        WriteTotals(ctx, "jolt_sphere", &jolt_regions, (BENCH_PICK_REGIONS + 1) / 2);
+        WriteTotals(ctx, "jolt_box", &jolt_boxes, BENCH_PICK_REGIONS / 2);
+    }
+    BenchJsonInt(ctx, "region_mismatches", region_mismatches);
+    BenchJsonEndObject(ctx);
+
+    BenchWriteWorldCounts(ctx, world);
+    free(files);
+    ecs_fini(world);
+    BenchJsonInt(ctx, "max_rss_kb", BenchMaxRssKb());
+    return ray_mismatches == 0 && region_mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,232 @@
+#include "bench.h"
+#include "../components/spatial.h"
+#include "../systems/profiler.h"
+#include "../systems/input_replay.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Per-system totals across the whole run
+typedef struct {
+    const char *name;
+    double total_ms;
+    double max_ms;      // Worst single frame
+    int64_t calls;
+} BenchZoneTotals;
+
+static int CompareDoubles(const void *a, const void *b) {
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+static double Percentile(const double *sorted, int count, double p) {
+    if (count == 0) {
+        return 0.0;
+    }
+    int index = (int)(p * (count - 1) + 0.5);
+    return sorted[index];
+}
+
+// Scripted camera: one full orbit over the run while zooming between the
+// near and far LOD ranges, so every tier transition is exercised
+static void ScriptCameraInput(InputFrame *input, int frame, int frame_count) {
+    const float rotation_speed = 0.5f;  // Matches the MainCamera controller
+    float phase = 2.0f * PI * frame / (float)frame_count;
+
+    memset(input, 0, sizeof(*input));
+    input->screen_width = 1200;
+    input->screen_height = 800;
+    input->left_down = true;
+    input->mouse_delta.x = 360.0f / (frame_count * rotation_speed);
+    input->mouse_delta.y = sinf(phase * 2.0f) * 0.5f;
+    input->wheel = -sinf(phase) * 1.5f;  // Zoom out first, then back in
+}
+
+static void AccumulateZones(BenchZoneTotals *totals, int *total_count) {
+    ProfileZoneStats zones[PROFILER_MAX_ZONES];
+    int zone_count = ProfilerGetFrameZones(zones, PROFILER_MAX_ZONES);
+
+    for (int z = 0; z < zone_count; z++) {
+        int t = 0;
+        while (t < *total_count && strcmp(totals[t].name, zones[z].name) != 0) {
+            t++;
+        }
+        if (t == *total_count) {
+            if (*total_count == PROFILER_MAX_ZONES) {
+                continue;
+            }
+            totals[t] = (BenchZoneTotals){zones[z].name, 0.0, 0.0, 0};
+            (*total_count)++;
+        }
+        totals[t].total_ms += zones[z].total_ms;
+        totals[t].calls += zones[z].calls;
+        if (zones[z].total_ms > totals[t].max_ms) {
+            totals[t].max_ms = zones[z].total_ms;
+        }
+    }
+}
+
+// Runs the frame loop with scripted input, or with input from a replay log,
+// optionally recording every frame, then writes timings and counts
+static int RunFrames(BenchContext *ctx, ecs_world_t *world, double setup_ms,
+                     InputReplay *replay, InputRecorder *recorder) {
+    int frame_total = ctx->frames;
+    if (replay && replay->header.frame_count > 0) {
+        frame_total = (int)replay->header.frame_count;
+    }
+    double *frame_ms = malloc(sizeof(double) * (frame_total > 0 ? frame_total : 1));
+    if (!frame_ms) {
+        printf("Failed to allocate frame timings\n");
+        ecs_fini(world);
+        return 1;
+    }
+
+    BenchZoneTotals totals[PROFILER_MAX_ZONES];
+    int total_count = 0;
+    float dt = replay ? replay->header.fixed_dt : INPUT_LOG_DEFAULT_DT;
+    uint64_t state_hash = 0;
+
+    ProfilerSetEnabled(true);
+    ProfilerFrameEnd();  // Drop events recorded during setup
+
+    int frames = 0;
+    double run_start = BenchNowMs();
+    for (; frames < frame_total; frames++) {
+        InputFrame input;
+        uint64_t expected_hash = 0;
+        if (replay) {
+            if (!InputReplayNext(replay, &input, &expected_hash)) {
+                break;
+            }
+        } else {
+            ScriptCameraInput(&input, frames, frame_total);
+        }
+        ecs_singleton_set_ptr(world, InputFrame, &input);
+
+        double frame_start = BenchNowMs();
+        ecs_progress(world, dt);
+        frame_ms[frames] = BenchNowMs() - frame_start;
+
+        // Hashing is outside the timed region
+        if (replay || recorder) {
+            state_hash = ComputeWorldStateHash(world);
+            if (replay) {
+                InputReplayVerify(replay, expected_hash, state_hash);
+            } else {
+                InputRecorderWrite(recorder, &input, state_hash);
+            }
+        }
+
+        ProfilerFrameEnd();
+        AccumulateZones(totals, &total_count);
+    }
+    double run_ms = BenchNowMs() - run_start;
+    ProfilerSetEnabled(false);
+
+    // Results
+    BenchJsonDouble(ctx, "setup_ms", setup_ms);
+    BenchJsonDouble(ctx, "run_ms", run_ms);
+    BenchJsonInt(ctx, "frames_run", frames);
+
+    double sum = 0.0;
+    for (int i = 0; i < frames; i++) {
+        sum += frame_ms[i];
+    }
+    qsort(frame_ms, frames, sizeof(double), CompareDoubles);
+
+    BenchJsonBeginObject(ctx, "frame_ms");
+    BenchJsonDouble(ctx, "mean", frames > 0 ? sum / frames : 0.0);
+    BenchJsonDouble(ctx, "p50", Percentile(frame_ms, frames, 0.50));
+    BenchJsonDouble(ctx, "p95", Percentile(frame_ms, frames, 0.95));
+    BenchJsonDouble(ctx, "p99", Percentile(frame_ms, frames, 0.99));
+    BenchJsonDouble(ctx, "max", frames > 0 ? frame_ms[frames - 1] : 0.0);
+    BenchJsonEndObject(ctx);
+
+    BenchJsonBeginArray(ctx, "systems");
+    for (int t = 0; t < total_count; t++) {
+        BenchJsonBeginObject(ctx, NULL);
+        BenchJsonString(ctx, "name", totals[t].name);
+        BenchJsonDouble(ctx, "mean_ms", frames > 0 ? totals[t].total_ms / frames : 0.0);
+        BenchJsonDouble(ctx, "max_ms", totals[t].max_ms);
+        BenchJsonDouble(ctx, "total_ms", totals[t].total_ms);
+        BenchJsonInt(ctx, "calls", totals[t].calls);
+        BenchJsonEndObject(ctx);
+    }
+    BenchJsonEndArray(ctx);
+
+    BenchWriteWorldCounts(ctx, world);
+
+    int result = 0;
+    if (replay || recorder) {
+        char hash_text[17];
+        snprintf(hash_text, sizeof(hash_text), "%016llx", (unsigned long long)state_hash);
+        BenchJsonBeginObject(ctx, "determinism");
+        BenchJsonString(ctx, "final_state_hash", hash_text);
+        if (replay) {
+            BenchJsonInt(ctx, "hash_mismatches", replay->mismatches);
+            BenchJsonInt(ctx, "first_mismatch_frame", replay->mismatches ? (int64_t)replay->first_mismatch : -1);
+            result = replay->mismatches > 0 ? 1 : 0;
+        }
+        BenchJsonEndObject(ctx);
+    }
+
+    double teardown_start = BenchNowMs();
+    ecs_fini(world);
+    double teardown_ms = BenchNowMs() - teardown_start;
+
+    BenchJsonDouble(ctx, "teardown_ms", teardown_ms);
+    BenchJsonInt(ctx, "max_rss_kb", BenchMaxRssKb());
+
+    free(frame_ms);
+    return result;
+}
+
+int BenchRunPipeline(BenchContext *ctx) {
+    double setup_start = BenchNowMs();
+    ecs_world_t *world = BenchCreateEditorWorld(ctx);
+    BenchSynthesizeFiles(world, ctx->files, ctx->lines, NULL);
+    double setup_ms = BenchNowMs() - setup_start;
+
+    // --record stores the scripted input so later runs can be replayed
+    InputRecorder recorder;
+    bool recording = false;
+    if (ctx->record_path) {
+        InputLogHeader header = {
+            .fixed_dt = INPUT_LOG_DEFAULT_DT,
+            .files = (uint32_t)ctx->files,
+            .lines = (uint32_t)ctx->lines
+        };
+        recording = InputRecorderOpen(&recorder, ctx->record_path, &header);
+    }
+
+    int result = RunFrames(ctx, world, setup_ms, NULL, recording ? &recorder : NULL);
+    if (recording) {
+        InputRecorderClose(&recorder);
+    }
+    return result;
+}
+
+int BenchRunReplay(BenchContext *ctx) {
+    InputReplay replay;
+    if (!ctx->input_path || !InputReplayOpen(&replay, ctx->input_path)) {
+        printf("Replay scenario needs a valid --input log\n");
+        return 1;
+    }
+    if (replay.header.files == 0) {
+        printf("Input log was recorded in the editor; replay it with spatial_editor --replay\n");
+        InputReplayClose(&replay);
+        return 1;
+    }
+
+    // Rebuild the world the log was recorded against
+    double setup_start = BenchNowMs();
+    ecs_world_t *world = BenchCreateEditorWorld(ctx);
+    BenchSynthesizeFiles(world, (int)replay.header.files, (int)replay.header.lines, NULL);
+    double setup_ms = BenchNowMs() - setup_start;
+
+    BenchJsonString(ctx, "input", ctx->input_path);
+    int result = RunFrames(ctx, world, setup_ms, &replay, NULL);
+    InputReplayClose(&replay);
+    return result;
+}
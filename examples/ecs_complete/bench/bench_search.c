@@ -0,0 +1,211 @@
+#include "bench.h"
+#include "../components/spatial.h"
+#include "../systems/syntax.h"
+#include "../systems/search_index.h"
+#include <ctype.h>
+#include <regex.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Deterministic LCG so every run searches the same text
+static uint32_t BenchRandom(uint32_t *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+typedef struct {
+    const char *name;
+    const char *pattern;
+    int flags;
+} BenchSearchQuery;
+
+static const BenchSearchQuery queries[] = {
+    {"rare_literal", "compute_4242(", 0},
+    {"common_literal", "return", 0},
+    {"ignore_case", "VALUE_77", SEARCH_IGNORE_CASE},
+    {"short_literal", "if", 0},
+    {"regex", "compute_12[0-9]+\\(item_9", SEARCH_REGEX},
+    {"regex_alternation", "alpha_999\\(|omega_4[0-9]?2$", SEARCH_REGEX},
+};
+
+static char *SynthesizeSearchFile(uint32_t *seed, int lines, size_t *out_length) {
+    size_t capacity = (size_t)lines * 64 + 64;
+    char *text = malloc(capacity);
+    if (!text) {
+        return NULL;
+    }
+    size_t length = 0;
+    for (int l = 0; l < lines; l++) {
+        uint32_t a = BenchRandom(seed) % 10000;
+        uint32_t b = BenchRandom(seed) % 10000;
+        switch (BenchRandom(seed) % 5) {
+            case 0:
+                length += (size_t)snprintf(text + length, capacity - length,
+                                           "    int value_%u = compute_%u(item_%u);\n", a, b, a % 100);
+                break;
+            case 1:
+                length += (size_t)snprintf(text + length, capacity - length, "    if (value_%u > %u) {\n", a, b);
+                break;
+            case 2:
+                length += (size_t)snprintf(text + length, capacity - length,
+                                           "        return alpha_%u(value_%u);\n", a, b);
+                break;
+            case 3:
+                length += (size_t)snprintf(text + length, capacity - length, "    }\n");
+                break;
+            default:
+                length += (size_t)snprintf(text + length, capacity - length, "// note %u: omega_%u\n", a, b % 1000);
+                break;
+        }
+    }
+    *out_length = length;
+    return text;
+}
+
+// Lines matching the query by a plain scan of every file, the baseline
+// the index has to agree with
+static int NaiveCount(ecs_world_t *world, const ecs_entity_t *files, int count, const BenchSearchQuery *query) {
+    regex_t regex;
+    bool is_regex = (query->flags & SEARCH_REGEX) != 0;
+    bool fold = (query->flags & SEARCH_IGNORE_CASE) != 0;
+    if (is_regex && regcomp(&regex, query->pattern, REG_EXTENDED | REG_NOSUB | (fold ? REG_ICASE : 0)) != 0) {
+        return -1;
+    }
+    char needle[SEARCH_MAX_QUERY];
+    size_t n = strlen(query->pattern);
+    for (size_t i = 0; i <= n; i++) {
+        needle[i] = fold ? (char)tolower((unsigned char)query->pattern[i]) : query->pattern[i];
+    }
+
+    int hits = 0;
+    char line[512];
+    for (int f = 0; f < count; f++) {
+        size_t length;
+        const char *text = GetFileSyntaxText(world, ecs_get(world, files[f], FileSyntax), &length);
+        const char *end = text ? text + length : NULL;
+        for (const char *p = text; p && p < end;) {
+            const char *newline = memchr(p, '\n', (size_t)(end - p));
+            size_t line_length = (size_t)((newline ? newline : end) - p);
+            if (line_length >= sizeof(line)) {
+                line_length = sizeof(line) - 1;
+            }
+            for (size_t i = 0; i < line_length; i++) {
+                line[i] = fold && !is_regex ? (char)tolower((unsigned char)p[i]) : p[i];
+            }
+            line[line_length] = '\0';
+            hits += is_regex ? regexec(&regex, line, 0, NULL, 0) == 0 : strstr(line, needle) != NULL;
+            p = newline ? newline + 1 : end;
+        }
+    }
+    if (is_regex) {
+        regfree(&regex);
+    }
+    return hits;
+}
+
+// Synthesizes N files with M lines each, lets the background builder
+// index them, checks every query against a naive scan (also once while
+// the build is still running), then edits one line and finds it through
+// the overlay
+int BenchRunSearch(BenchContext *ctx) {
+    int max_hits = ctx->files * ctx->lines + 1;
+    ecs_entity_t *files = malloc(sizeof(ecs_entity_t) * ctx->files);
+    SearchHit *hits = malloc(sizeof(SearchHit) * max_hits);
+    if (!files || !hits) {
+        free(files);
+        free(hits);
+        return 1;
+    }
+
+    double setup_start = BenchNowMs();
+    ecs_world_t *world = BenchCreateEditorWorld(ctx);
+    uint32_t seed = 9001;
+    int64_t bytes = 0;
+    for (int f = 0; f < ctx->files; f++) {
+        size_t length = 0;
+        char *text = SynthesizeSearchFile(&seed, ctx->lines, &length);
+        files[f] = ecs_new(world);
+        ecs_set(world, files[f], Position, {(float)(f % 64) * 20.0f, 0.0f, (float)(f / 64) * 20.0f});
+        if (text) {
+            AttachFileSyntax(world, files[f], text, length);
+            bytes += (int64_t)length;
+        }
+        free(text);
+    }
+    double setup_ms = BenchNowMs() - setup_start;
+
+    // The build runs on its own thread; a query meanwhile scans every file
+    double start = BenchNowMs();
+    UpdateSearchIndex(world);
+    double start_build_ms = BenchNowMs() - start;
+    int during_build = SearchPhantoms(world, queries[0].pattern, queries[0].flags, hits, max_hits);
+    SearchStats during = *ecs_singleton_get(world, SearchStats);
+    start = BenchNowMs();
+    WaitSearchIndex(world);
+    double wait_ms = BenchNowMs() - start;
+    SearchStats built = *ecs_singleton_get(world, SearchStats);
+
+    BenchJsonDouble(ctx, "setup_ms", setup_ms);
+    BenchJsonBeginObject(ctx, "search");
+    BenchJsonInt(ctx, "files", ctx->files);
+    BenchJsonInt(ctx, "bytes", bytes);
+    BenchJsonInt(ctx, "threads", built.threads);
+    BenchJsonDouble(ctx, "snapshot_ms", start_build_ms);
+    BenchJsonDouble(ctx, "build_ms", built.build_ms);
+    BenchJsonDouble(ctx, "wait_ms", wait_ms);
+    BenchJsonInt(ctx, "trigrams", built.trigrams);
+    BenchJsonInt(ctx, "postings", built.postings);
+    BenchJsonInt(ctx, "segment_bytes", built.segment_bytes);
+    BenchJsonDouble(ctx, "bytes_per_posting",
+                    built.postings > 0 ? (double)built.segment_bytes / (double)built.postings : 0.0);
+    BenchJsonBeginObject(ctx, "during_build");
+    BenchJsonInt(ctx, "candidates", during.candidates);
+    BenchJsonInt(ctx, "hits", during_build);
+    BenchJsonDouble(ctx, "query_us", during.query_us);
+    BenchJsonEndObject(ctx);
+
+    bool all_match = true;
+    int query_count = (int)(sizeof(queries) / sizeof(queries[0]));
+    for (int q = 0; q < query_count; q++) {
+        int found = SearchPhantoms(world, queries[q].pattern, queries[q].flags, hits, max_hits);
+        SearchStats stats = *ecs_singleton_get(world, SearchStats);
+        start = BenchNowMs();
+        int expected = NaiveCount(world, files, ctx->files, &queries[q]);
+        double naive_ms = BenchNowMs() - start;
+        bool match = found == expected && (q > 0 || found == during_build);
+        all_match &= match;
+
+        BenchJsonBeginObject(ctx, queries[q].name);
+        BenchJsonInt(ctx, "trigrams", stats.query_trigrams);
+        BenchJsonInt(ctx, "candidates", stats.candidates);
+        BenchJsonInt(ctx, "hits", found);
+        BenchJsonInt(ctx, "expected", expected);
+        BenchJsonDouble(ctx, "query_us", stats.query_us);
+        BenchJsonDouble(ctx, "naive_ms", naive_ms);
+        BenchJsonBool(ctx, "match", match);
+        BenchJsonEndObject(ctx);
+    }
+
+    // An edited line goes into the overlay and is found right away
+    EditFileSyntaxLine(world, files[ctx->files / 2], 1, "    int zebra_marker = 1;");
+    UpdateSearchIndex(world);
+    SearchStats edited = *ecs_singleton_get(world, SearchStats);
+    int found = SearchPhantoms(world, "zebra_marker", 0, hits, max_hits);
+    bool edit_found = found == 1 && hits[0].file == files[ctx->files / 2] && hits[0].line == 1;
+    BenchJsonBeginObject(ctx, "edit");
+    BenchJsonInt(ctx, "overlay_documents", edited.overlay_documents);
+    BenchJsonDouble(ctx, "overlay_ms", edited.overlay_ms);
+    BenchJsonInt(ctx, "candidates", ecs_singleton_get(world, SearchStats)->candidates);
+    BenchJsonDouble(ctx, "query_us", ecs_singleton_get(world, SearchStats)->query_us);
+    BenchJsonBool(ctx, "found", edit_found);
+    BenchJsonEndObject(ctx);
+    BenchJsonBool(ctx, "all_match", all_match);
+    BenchJsonEndObject(ctx);
+
+    BenchWriteWorldCounts(ctx, world);
+    free(files);
+    free(hits);
+    ecs_fini(world);
+    BenchJsonInt(ctx, "max_rss_kb", BenchMaxRssKb());
+    return all_match && edit_found ? 0 : 1;
+}
@@ -0,0 +1,219 @@
+#include "bench.h"
+#include "../components/spatial.h"
+#include "../systems/syntax.h"
+#include "../systems/symbol_index.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_SYMBOL_CALLS 3            // Calls to other functions per body
+#define BENCH_SYMBOL_FUNCTION_LINES 16  // Lines of one function template
+#define BENCH_SYMBOL_HEADER_LINES 2     // #include and #define before the prototypes
+#define BENCH_SYMBOL_CALL_LINE 3        // Line of the first call within a function
+
+// Deterministic LCG so every run builds the same call graph
+static uint32_t BenchRandom(uint32_t *state) {
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+// Function k of file f is fn_f_k; its callees are indices f * per_file + k
+typedef struct {
+    int files;
+    int per_file;
+    int32_t *callees;         // BENCH_SYMBOL_CALLS per function
+} BenchCallGraph;
+
+static int FunctionLine(const BenchCallGraph *graph, int k) {
+    return BENCH_SYMBOL_HEADER_LINES + graph->per_file + k * BENCH_SYMBOL_FUNCTION_LINES;
+}
+
+// Besides the real calls, each body has calls the index must ignore: in a
+// comment, in a string, through a member, and a macro on a directive line.
+// An #if/#else pair opens the same block twice.
+static char *SynthesizeSymbolFile(const BenchCallGraph *graph, int f, size_t *out_length) {
+    size_t capacity = 128 + (size_t)graph->per_file * 640;
+    char *text = malloc(capacity);
+    if (!text) {
+        return NULL;
+    }
+    size_t length = 0;
+    length += (size_t)snprintf(text + length, capacity - length,
+                               "#include <stdio.h>\n#define WRAP(x) fn_0_0(x)\n");
+    for (int k = 0; k < graph->per_file; k++) {
+        length += (size_t)snprintf(text + length, capacity - length, "int fn_%d_%d(int x);\n", f, k);
+    }
+    for (int k = 0; k < graph->per_file; k++) {
+        const int32_t *c = &graph->callees[(f * graph->per_file + k) * BENCH_SYMBOL_CALLS];
+        int per_file = graph->per_file;
+        length += (size_t)snprintf(text + length, capacity - length,
+            "/* fn_%d_%d: fn_1_0(1) in a comment is not a call */\n"
+            "int fn_%d_%d(int x)\n"
+            "{\n"
+            "    int y = fn_%d_%d(x) + fn_%d_%d(x);\n"
+            "#if defined(BENCH_ALTERNATE)\n"
+            "    if (x > 0) {\n"
+            "#else\n"
+            "    if (x >= 0) {\n"
+            "#endif\n"
+            "        y += fn_%d_%d(y);\n"
+            "    }\n"
+            "    printf(\"%%d fn_0_1(2)\\n\", y);\n"
+            "    state->callback(y);\n"
+            "    return y;\n"
+            "}\n"
+            "\n",
+            f, k, f, k, c[0] / per_file, c[0] % per_file, c[1] / per_file, c[1] % per_file,
+            c[2] / per_file, c[2] % per_file);
+    }
+    *out_length = length;
+    return text;
+}
+
+// Distinct callees other than the caller itself
+static int ExpectedEdges(const BenchCallGraph *graph) {
+    int edges = 0;
+    int functions = graph->files * graph->per_file;
+    for (int fn = 0; fn < functions; fn++) {
+        const int32_t *c = &graph->callees[fn * BENCH_SYMBOL_CALLS];
+        for (int i = 0; i < BENCH_SYMBOL_CALLS; i++) {
+            bool duplicate = c[i] == fn;
+            for (int j = 0; j < i && !duplicate; j++) {
+                duplicate = c[j] == c[i];
+            }
+            edges += !duplicate;
+        }
+    }
+    return edges;
+}
+
+static ecs_entity_t LookupFunction(ecs_world_t *world, int f, int k) {
+    char name[64];
+    snprintf(name, sizeof(name), "fn_%d_%d", f, k);
+    return FindFunction(world, name);
+}
+
+static void WriteScan(BenchContext *ctx, const char *key, const SymbolStats *stats, double wall_ms) {
+    BenchJsonBeginObject(ctx, key);
+    BenchJsonInt(ctx, "sources", stats->sources);
+    BenchJsonInt(ctx, "definitions", stats->definitions);
+    BenchJsonInt(ctx, "calls", stats->calls);
+    BenchJsonInt(ctx, "functions_created", stats->functions_created);
+    BenchJsonInt(ctx, "functions_removed", stats->functions_removed);
+    BenchJsonInt(ctx, "callers_updated", stats->callers_updated);
+    BenchJsonInt(ctx, "resolved", stats->resolved);
+    BenchJsonInt(ctx, "edges", stats->edges);
+    BenchJsonDouble(ctx, "scan_ms", stats->scan_ms);
+    BenchJsonDouble(ctx, "index_ms", stats->index_ms);
+    BenchJsonDouble(ctx, "apply_ms", stats->apply_ms);
+    BenchJsonDouble(ctx, "wall_ms", wall_ms);
+    BenchJsonEndObject(ctx);
+}
+
+// Lexes and indexes N synthesized files with M lines each, checks the
+// References pairs against the generated call graph, then edits one call
+// and renames one definition and rescans only the edited file
+int BenchRunSymbols(BenchContext *ctx) {
+    if (ctx->files < 4) {
+        fprintf(stderr, "symbols needs at least four files\n");
+        return 1;
+    }
+
+    BenchCallGraph graph = {.files = ctx->files};
+    graph.per_file = ctx->lines / BENCH_SYMBOL_FUNCTION_LINES;
+    if (graph.per_file < 1) {
+        graph.per_file = 1;
+    }
+    int functions = graph.files * graph.per_file;
+    graph.callees = malloc(sizeof(int32_t) * functions * BENCH_SYMBOL_CALLS);
+    ecs_entity_t *files = malloc(sizeof(ecs_entity_t) * ctx->files);
+    if (!graph.callees || !files) {
+        free(graph.callees);
+        free(files);
+        return 1;
+    }
+    uint32_t seed = 4242;
+    for (int i = 0; i < functions * BENCH_SYMBOL_CALLS; i++) {
+        graph.callees[i] = (int32_t)(BenchRandom(&seed) % (uint32_t)functions);
+    }
+
+    // Lexing queues every file for the symbol index
+    double setup_start = BenchNowMs();
+    ecs_world_t *world = BenchCreateEditorWorld(ctx);
+    int64_t bytes = 0;
+    for (int f = 0; f < ctx->files; f++) {
+        size_t length = 0;
+        char *text = SynthesizeSymbolFile(&graph, f, &length);
+        files[f] = ecs_new(world);
+        ecs_set(world, files[f], Position, {(float)(f % 64) * 20.0f, 0.0f, (float)(f / 64) * 20.0f});
+        if (text) {
+            AttachFileSyntax(world, files[f], text, length);
+            bytes += (int64_t)length;
+        }
+        free(text);
+    }
+    double setup_ms = BenchNowMs() - setup_start;
+    const SyntaxStats *syntax = ecs_singleton_get(world, SyntaxStats);
+
+    double start = BenchNowMs();
+    int edges = UpdateSymbolIndex(world);
+    double first_ms = BenchNowMs() - start;
+    SymbolStats first = *ecs_singleton_get(world, SymbolStats);
+    int expected = ExpectedEdges(&graph);
+    int32_t pairs = ecs_count_id(world, ecs_pair(References, EcsWildcard));
+
+    // Retarget the first call of fn_0_0 to a function it does not call yet
+    const int32_t *callees = &graph.callees[0];
+    int32_t target = 1;
+    while (target == callees[0] || target == callees[1] || target == callees[2]) {
+        target++;
+    }
+    char line[128];
+    snprintf(line, sizeof(line), "    int y = fn_%d_%d(x) + fn_%d_%d(x);", target / graph.per_file,
+             target % graph.per_file, callees[1] / graph.per_file, callees[1] % graph.per_file);
+    EditFileSyntaxLine(world, files[0], FunctionLine(&graph, 0) + BENCH_SYMBOL_CALL_LINE, line);
+    start = BenchNowMs();
+    UpdateSymbolIndex(world);
+    double call_edit_ms = BenchNowMs() - start;
+    SymbolStats call_edit = *ecs_singleton_get(world, SymbolStats);
+    ecs_entity_t caller = LookupFunction(world, 0, 0);
+    ecs_entity_t callee = LookupFunction(world, target / graph.per_file, target % graph.per_file);
+    bool call_applied = caller && callee && ecs_has_pair(world, caller, References, callee);
+
+    // Rename fn_1_0: its callers elsewhere lose their pair to it
+    snprintf(line, sizeof(line), "int fn_1_0_renamed(int x)");
+    EditFileSyntaxLine(world, files[1], FunctionLine(&graph, 0) + 1, line);
+    start = BenchNowMs();
+    UpdateSymbolIndex(world);
+    double rename_ms = BenchNowMs() - start;
+    SymbolStats rename = *ecs_singleton_get(world, SymbolStats);
+    bool rename_applied = !LookupFunction(world, 1, 0) && FindFunction(world, "fn_1_0_renamed") &&
+                          rename.functions_created == 1 && rename.functions_removed == 1;
+
+    bool edges_match = edges == expected;
+    BenchJsonDouble(ctx, "setup_ms", setup_ms);
+    BenchJsonBeginObject(ctx, "symbols");
+    BenchJsonInt(ctx, "files", ctx->files);
+    BenchJsonInt(ctx, "lines", syntax->lines);
+    BenchJsonInt(ctx, "bytes", bytes);
+    BenchJsonInt(ctx, "functions", functions);
+    BenchJsonInt(ctx, "threads", first.threads);
+    BenchJsonDouble(ctx, "lex_ms", syntax->lex_ms);
+    WriteScan(ctx, "first", &first, first_ms);
+    BenchJsonDouble(ctx, "lex_and_index_ms", syntax->lex_ms + first_ms);
+    BenchJsonInt(ctx, "symbols", first.symbols);
+    BenchJsonInt(ctx, "expected_edges", expected);
+    BenchJsonInt(ctx, "callers_with_references", pairs);
+    BenchJsonBool(ctx, "edges_match", edges_match);
+    WriteScan(ctx, "edit_call", &call_edit, call_edit_ms);
+    BenchJsonBool(ctx, "edit_call_applied", call_applied);
+    WriteScan(ctx, "rename_definition", &rename, rename_ms);
+    BenchJsonBool(ctx, "rename_applied", rename_applied);
+    BenchJsonEndObject(ctx);
+
+    BenchWriteWorldCounts(ctx, world);
+    free(graph.callees);
+    free(files);
+    ecs_fini(world);
+    BenchJsonInt(ctx, "max_rss_kb", BenchMaxRssKb());
+    return edges_match && call_applied && rename_applied ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+#define _POSIX_C_SOURCE 200809L  // mkdtemp
+#include "bench.h"
+#include "../components/spatial.h"
+#include "../systems/file_loader.h"
+#include "../systems/world_stats.h"
+#include "../systems/workspace.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define BENCH_WORKSPACE_STALE_EVERY 10  // Every 10th file changes on disk
+
+static int BenchTextCount(ecs_world_t *world) {
+    const WorldStats *stats = ecs_singleton_get(world, WorldStats);
+    return stats ? stats->text_count : 0;
+}
+
+static void BenchWorkspacePath(char *out, size_t size, const char *dir, int file) {
+    snprintf(out, size, "%s/file_%05d.c", dir, file);
+}
+
+static bool BenchWriteWorkspaceFiles(const char *dir, int files, int lines) {
+    size_t length;
+    char *text = BenchSynthesizeSource(lines, &length);
+    bool written = text != NULL;
+    for (int f = 0; f < files && written; f++) {
+        char path[512];
+        BenchWorkspacePath(path, sizeof(path), dir, f);
+        FILE *file = fopen(path, "wb");
+        written = file && fwrite(text, 1, length, file) == length;
+        if (file) {
+            fclose(file);
+        }
+    }
+    free(text);
+    return written;
+}
+
+// Loads N files x M lines from disk the usual way, saves the workspace,
+// changes every 10th file, then reopens the snapshot in a fresh world and
+// validates it. Reopen time is what a launch waits for; validation runs
+// in the background in the editor.
+int BenchRunWorkspace(BenchContext *ctx) {
+    char dir[] = "/tmp/pevi_bench_workspace_XXXXXX";
+    if (!mkdtemp(dir) || !BenchWriteWorkspaceFiles(dir, ctx->files, ctx->lines)) {
+        fprintf(stderr, "Failed to write workspace files\n");
+        return 1;
+    }
+    char snapshot_path[512];
+    snprintf(snapshot_path, sizeof(snapshot_path), "%s/workspace.pvws", dir);
+
+    // Cold load: read, split and lex every file, one phantom at a time
+    ecs_world_t *world = BenchCreateEditorWorld(ctx);
+    int baseline_text = BenchTextCount(world);
+    int columns = (int)ceilf(sqrtf((float)ctx->files));
+    columns = columns > 0 ? columns : 1;
+    double start = BenchNowMs();
+    for (int f = 0; f < ctx->files; f++) {
+        char path[512];
+        BenchWorkspacePath(path, sizeof(path), dir, f);
+        LoadFileAsPhantoms(world, path, (Vector3){(f % columns) * 15.0f, 0.0f, (f / columns) * 15.0f});
+    }
+    double cold_ms = BenchNowMs() - start;
+    int cold_phantoms = BenchTextCount(world) - baseline_text - ctx->files;
+
+    start = BenchNowMs();
+    bool saved = SaveWorkspaceSnapshot(world, snapshot_path);
+    double save_ms = BenchNowMs() - start;
+    ecs_fini(world);
+
+    int stale_files = 0;
+    for (int f = 0; f < ctx->files; f += BENCH_WORKSPACE_STALE_EVERY) {
+        char path[512];
+        BenchWorkspacePath(path, sizeof(path), dir, f);
+        FILE *file = fopen(path, "ab");
+        if (file) {
+            fputs("int changed_since_snapshot = 1;\n", file);
+            fclose(file);
+            stale_files++;
+        }
+    }
+
+    // Reopen: map the snapshot and bulk-insert its phantoms
+    world = BenchCreateEditorWorld(ctx);
+    baseline_text = BenchTextCount(world);
+    start = BenchNowMs();
+    int restored = saved ? LoadWorkspaceSnapshot(world, snapshot_path) : -1;
+    double reopen_ms = BenchNowMs() - start;
+    int restored_text = BenchTextCount(world) - baseline_text;
+
+    start = BenchNowMs();
+    WaitWorkspace(world);
+    double validate_ms = BenchNowMs() - start;
+    const WorkspaceStats *stats = ecs_singleton_get(world, WorkspaceStats);
+    int validated_phantoms = BenchTextCount(world) - baseline_text - ctx->files;
+
+    // Every phantom comes back, and a changed file reloads with its new line
+    bool match = saved && restored == cold_phantoms && restored_text == cold_phantoms + ctx->files &&
+                 stats->stale == stale_files && validated_phantoms == cold_phantoms + stale_files;
+
+    BenchJsonBeginObject(ctx, "workspace");
+    BenchJsonInt(ctx, "files", ctx->files);
+    BenchJsonInt(ctx, "phantoms", cold_phantoms);
+    BenchJsonDouble(ctx, "cold_load_ms", cold_ms);
+    BenchJsonDouble(ctx, "save_ms", save_ms);
+    BenchJsonInt(ctx, "snapshot_bytes", stats->bytes);
+    BenchJsonInt(ctx, "edges", stats->edges);
+    BenchJsonDouble(ctx, "reopen_ms", reopen_ms);
+    BenchJsonDouble(ctx, "map_ms", stats->map_ms);
+    BenchJsonDouble(ctx, "insert_ms", stats->insert_ms);
+    BenchJsonDouble(ctx, "reopen_speedup", reopen_ms > 0.0 ? cold_ms / reopen_ms : 0.0);
+    BenchJsonDouble(ctx, "validate_ms", validate_ms);
+    BenchJsonDouble(ctx, "hash_ms", stats->validate_ms);
+    BenchJsonInt(ctx, "stale_files", stats->stale);
+    BenchJsonBool(ctx, "match", match);
+    BenchJsonEndObject(ctx);
+    BenchWriteWorldCounts(ctx, world);
+    ecs_fini(world);
+
+    for (int f = 0; f < ctx->files; f++) {
+        char path[512];
+        BenchWorkspacePath(path, sizeof(path), dir, f);
+        unlink(path);
+    }
+    unlink(snapshot_path);
+    rmdir(dir);
+    BenchJsonInt(ctx, "max_rss_kb", BenchMaxRssKb());
+    return match ? 0 : 1;
+}
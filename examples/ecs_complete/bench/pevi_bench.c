@@ -0,0 +1,134 @@
+#define _POSIX_C_SOURCE 200809L  // dup, fdopen
+#include "bench.h"
+#include "../systems/memory_tracker.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Headless benchmark harness: runs editor modules without a window and
+// prints one JSON object per run for regression tracking.
+//
+//     pevi_bench [--scenario NAME] [--files N] [--lines M] [--frames K] [--out FILE]
+//                [--record LOG] [--input LOG] [--source FILE] [--edits K]
+
+static const BenchScenario scenarios[] = {
+    {"pipeline", "ECS pipeline over N files x M lines with a scripted camera", BenchRunPipeline},
+    {"replay", "Replay a recorded input log and verify per-frame state hashes", BenchRunReplay},
+    {"layout", "Force-directed layout of N files with synthetic Includes edges", BenchRunLayout},
+    {"collision", "Resolve N overlapping panels through the Jolt broadphase", BenchRunCollision},
+    {"picking", "Ray picks and region selects, broadphase vs linear scan", BenchRunPicking},
+    {"lexer", "Serial and parallel lexing of --source FILE (or N x M synthesized lines)", BenchRunLexer},
+    {"includes", "Include-graph extraction over a synthesized N-file tree", BenchRunIncludes},
+    {"symbols", "Symbol index and call graph over N files x M lines, then incremental edits", BenchRunSymbols},
+    {"search", "Trigram index over N files x M lines, queries vs a naive scan, then an edit", BenchRunSearch},
+    {"finder", "Fuzzy finder over N x M names, typed one keystroke at a time", BenchRunFinder},
+    {"buffer", "K random single-char edits to the piece table of --source FILE (or N x M lines)", BenchRunBuffer},
+    {"workspace", "Save N files x M lines as a snapshot, reopen it and validate against changed files", BenchRunWorkspace},
+    {"autosave", "Edit N files x M lines every frame for K frames with background autosave", BenchRunAutosave},
+    {"arena", "Orbit and drag over N files x M lines, counting mallocs in steady-state frames", BenchRunArena},
+    {"memory", "Live bytes per subsystem for N files x M lines, budget check and leaks after ecs_fini", BenchRunMemory},
+};
+
+static const int scenario_count = sizeof(scenarios) / sizeof(scenarios[0]);
+
+static void PrintUsage(const char *program) {
+    fprintf(stderr, "Usage: %s [--scenario NAME] [--files N] [--lines M] [--frames K] [--out FILE]\n"
+            "       [--record LOG] [--input LOG] [--source FILE] [--edits K]\n", program);
+    fprintf(stderr, "Scenarios:\n");
+    for (int i = 0; i < scenario_count; i++) {
+        fprintf(stderr, "  %-12s %s\n", scenarios[i].name, scenarios[i].description);
+    }
+}
+
+int main(int argc, char **argv) {
+    BenchContext ctx = {
+        .scenario = "pipeline",
+        .files = 64,
+        .lines = 200,
+        .frames = 600,
+        .edits = 1000000
+    };
+    const char *out_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--scenario") == 0 && has_value) {
+            ctx.scenario = argv[++i];
+        } else if (strcmp(argv[i], "--files") == 0 && has_value) {
+            ctx.files = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--lines") == 0 && has_value) {
+            ctx.lines = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--frames") == 0 && has_value) {
+            ctx.frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--out") == 0 && has_value) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && has_value) {
+            ctx.record_path = argv[++i];
+        } else if (strcmp(argv[i], "--input") == 0 && has_value) {
+            ctx.input_path = argv[++i];
+        } else if (strcmp(argv[i], "--source") == 0 && has_value) {
+            ctx.source_path = argv[++i];
+        } else if (strcmp(argv[i], "--edits") == 0 && has_value) {
+            ctx.edits = atoi(argv[++i]);
+        } else {
+            PrintUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    const BenchScenario *scenario = NULL;
+    for (int i = 0; i < scenario_count; i++) {
+        if (strcmp(scenarios[i].name, ctx.scenario) == 0) {
+            scenario = &scenarios[i];
+        }
+    }
+    if (!scenario || ctx.files < 0 || ctx.lines < 0 || ctx.frames < 0 || ctx.edits < 0) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    // Editor modules log to stdout; keep the JSON stream clean by moving
+    // those logs to stderr when the results go to stdout
+    if (out_path) {
+        ctx.out = fopen(out_path, "w");
+        if (!ctx.out) {
+            fprintf(stderr, "Failed to open output file: %s\n", out_path);
+            return 1;
+        }
+    } else {
+        fflush(stdout);
+        int json_fd = dup(STDOUT_FILENO);
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+        ctx.out = json_fd >= 0 ? fdopen(json_fd, "w") : NULL;
+        if (!ctx.out) {
+            fprintf(stderr, "Failed to open JSON output stream\n");
+            return 1;
+        }
+    }
+
+    // Every world of the run counts its flecs allocations per subsystem
+    InstallMemoryTracker();
+
+    fputc('{', ctx.out);
+    ctx.depth = 1;
+    BenchJsonString(&ctx, "scenario", scenario->name);
+    BenchJsonInt(&ctx, "timestamp", (int64_t)time(NULL));
+    BenchJsonBeginObject(&ctx, "config");
+    BenchJsonInt(&ctx, "files", ctx.files);
+    BenchJsonInt(&ctx, "lines", ctx.lines);
+    BenchJsonInt(&ctx, "frames", ctx.frames);
+    BenchJsonInt(&ctx, "edits", ctx.edits);
+    if (ctx.source_path) {
+        BenchJsonString(&ctx, "source", ctx.source_path);
+    }
+    BenchJsonEndObject(&ctx);
+
+    int result = scenario->run(&ctx);
+
+    BenchJsonInt(&ctx, "exit_code", result);
+    fputs("\n}\n", ctx.out);
+    fclose(ctx.out);
+    return result;
+}
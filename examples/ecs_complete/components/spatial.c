@@ -4,6 +4,7 @@
 ECS_DECLARE(Visible);
 ECS_DECLARE(Hidden);
 ECS_DECLARE(NeedsReload);
+ECS_DECLARE(ImpostorActive);
 
 ECS_DECLARE(References);
 ECS_DECLARE(Contains);
@@ -50,11 +51,14 @@ void RegisterSpatialComponents(ecs_world_t *world) {
     // Register camera and editor components
     ECS_COMPONENT_DEFINE(world, CameraController);
     ECS_COMPONENT_DEFINE(world, EditorState);
+    ECS_COMPONENT_DEFINE(world, ViewState);
+    ECS_COMPONENT_DEFINE(world, InputFrame);
     
     // Register tags
     ECS_TAG_DEFINE(world, Visible);
     ECS_TAG_DEFINE(world, Hidden);
     ECS_TAG_DEFINE(world, NeedsReload);
+    ECS_TAG_DEFINE(world, ImpostorActive);
     
     // Register custom relationships
     ECS_TAG_DEFINE(world, References);
@@ -28,6 +28,7 @@ typedef struct {
     Matrix world_matrix;
     Matrix local_matrix;
     bool needs_update;
+    bool changed;  // Recomputed this frame (consumers sync derived state)
 } EcsTransform;
 
 // 3D text phantom entity components
@@ -66,6 +67,35 @@ typedef struct {
     int mode;  // Orbital, free, first-person
 } CameraController;
 
+// Per-frame view parameters shared by LOD and culling systems (updated by ViewSystem)
+typedef struct {
+    Vector3 camera_position;
+    Vector3 camera_target;
+    float fovy;             // Vertical field of view in degrees
+    float viewport_width;   // Pixels
+    float viewport_height;  // Pixels
+} ViewState;
+
+// Input sampled once per frame before ecs_progress. Systems read this
+// singleton instead of polling raylib, so a scripted backend can drive them.
+typedef struct {
+    Vector2 mouse_position;
+    Vector2 mouse_delta;
+    float wheel;
+    bool left_down;
+    bool right_down;
+    bool left_pressed;
+    bool tab_pressed;
+    bool box_select_pressed;     // Command mode: select phantoms in a box
+    bool sphere_select_pressed;  // Command mode: select phantoms in a sphere
+    bool backspace_pressed;      // Edit mode: delete the last character
+    int typed_char;              // Edit mode: printable ASCII typed this frame, 0 if none
+    bool undo_pressed;           // Edit mode: Ctrl+Z
+    bool redo_pressed;           // Edit mode: Ctrl+Y or Ctrl+Shift+Z
+    int screen_width;
+    int screen_height;
+} InputFrame;
+
 // Editor state management
 typedef struct {
     int current_mode;  // Navigation, edit, command
@@ -78,6 +108,7 @@ typedef struct {
 extern ECS_DECLARE(Visible);
 extern ECS_DECLARE(Hidden);
 extern ECS_DECLARE(NeedsReload);
+extern ECS_DECLARE(ImpostorActive);  // File subtree is drawn as a single impostor
 
 // Custom relationships
 extern ECS_DECLARE(References);
@@ -104,6 +135,8 @@ ECS_COMPONENT_DECLARE(Selected);
 ECS_COMPONENT_DECLARE(BoundingSphere);
 ECS_COMPONENT_DECLARE(CameraController);
 ECS_COMPONENT_DECLARE(EditorState);
+ECS_COMPONENT_DECLARE(ViewState);
+ECS_COMPONENT_DECLARE(InputFrame);
 
 // Component registration function
 void RegisterSpatialComponents(ecs_world_t *world);
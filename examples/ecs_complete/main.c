@@ -1,21 +1,74 @@
 #include <flecs.h>
 #include <raylib.h>
 #include <stdio.h>
+#include <time.h>
 
 #include "components/spatial.h"
 #include "systems/core_systems.h"
 #include "systems/observers.h"
 #include "systems/prefabs.h"
 #include "systems/file_loader.h"
+#include "systems/impostor.h"
+#include "systems/text_lod.h"
+#include "systems/profiler.h"
+#include "systems/frame_arena.h"
+#include "systems/memory_tracker.h"
+#include "systems/world_stats.h"
+#include "systems/input_replay.h"
+#include "systems/layout.h"
+#include "systems/collision.h"
+#include "systems/picking.h"
+#include "systems/syntax.h"
+#include "systems/include_graph.h"
+#include "systems/symbol_index.h"
+#include "systems/search_index.h"
+#include "systems/fuzzy_finder.h"
+#include "systems/workspace.h"
+#include "systems/autosave.h"
+#include <string.h>
 
-int main(void) {
+int main(int argc, char **argv) {
+    // Optional deterministic input log: --record <file> or --replay <file>,
+    // extra include search paths: -I <dir>, a workspace snapshot restored
+    // on start and saved on exit: --workspace <file>, and a directory for
+    // background autosaves of the layout and edited files: --autosave <dir>,
+    // memory budgets: --memory-budget [<tag>=]<MB> (repeatable) and a JSON
+    // memory report written on exit: --memory-report <file>
+    const char *record_path = NULL;
+    const char *replay_path = NULL;
+    const char *workspace_path = NULL;
+    const char *autosave_path = NULL;
+    const char *memory_report_path = NULL;
+    const char *memory_budgets[MEMORY_TAG_COUNT + 1];
+    int memory_budget_count = 0;
+    const char *include_paths[INCLUDE_MAX_PATHS];
+    int include_path_count = 0;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--record") == 0) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--workspace") == 0) {
+            workspace_path = argv[++i];
+        } else if (strcmp(argv[i], "--autosave") == 0) {
+            autosave_path = argv[++i];
+        } else if (strcmp(argv[i], "--memory-report") == 0) {
+            memory_report_path = argv[++i];
+        } else if (strcmp(argv[i], "--memory-budget") == 0 && memory_budget_count < MEMORY_TAG_COUNT + 1) {
+            memory_budgets[memory_budget_count++] = argv[++i];
+        } else if (strcmp(argv[i], "-I") == 0 && include_path_count < INCLUDE_MAX_PATHS) {
+            include_paths[include_path_count++] = argv[++i];
+        }
+    }
+    
     // Initialize Raylib
     const int screenWidth = 1200;
     const int screenHeight = 800;
     InitWindow(screenWidth, screenHeight, "Pevi 3D Spatial Code Editor - Flecs ECS Complete Example");
     SetTargetFPS(60);
     
-    // Initialize Flecs ECS world
+    // Initialize Flecs ECS world, its allocations counted from the start
+    InstallMemoryTracker();
     ecs_world_t *world = ecs_init();
     
     printf("Initializing Pevi ECS Complete Example...\n");
@@ -31,20 +84,122 @@ int main(void) {
     RegisterCoreSystems(world);
     printf("Core systems registered.\n");
     
+    // Register the per-frame scratch arenas (reset at the end of each frame)
+    printf("Registering frame arena...\n");
+    RegisterFrameArena(world);
+    printf("Frame arena registered.\n");
+    
+    // Register per-subsystem memory accounting and budgets
+    printf("Registering memory tracker...\n");
+    RegisterMemoryTracker(world);
+    for (int i = 0; i < memory_budget_count; i++) {
+        ParseMemoryBudget(world, memory_budgets[i]);
+    }
+    printf("Memory tracker registered.\n");
+    
     // Register observers for reactive behavior
     printf("Registering observers...\n");
     RegisterObservers(world);
     printf("Observers registered.\n");
     
+    // Register cached world counters before any entity is created
+    printf("Registering world statistics...\n");
+    RegisterWorldStats(world);
+    printf("World statistics registered.\n");
+    
+    // Register far-field impostor LOD for file containers
+    printf("Registering impostor systems...\n");
+    RegisterImpostorSystems(world);
+    printf("Impostor systems registered.\n");
+    
+    // Register per-phantom text LOD (glyphs -> line bars -> file block)
+    printf("Registering text LOD systems...\n");
+    RegisterTextLODSystems(world);
+    printf("Text LOD systems registered.\n");
+    
+    // Register force-directed layout driven by relationship pairs
+    printf("Registering layout systems...\n");
+    RegisterLayoutSystems(world);
+    printf("Layout systems registered.\n");
+    
+    // Register overlap resolution for file blocks (Jolt broadphase)
+    printf("Registering collision systems...\n");
+    RegisterCollisionSystems(world);
+    printf("Collision systems registered.\n");
+    
+    // Register picking and region selection (shares the Jolt world)
+    printf("Registering picking systems...\n");
+    RegisterPickingSystems(world);
+    printf("Picking systems registered.\n");
+    
+    // Register syntax coloring (files are lexed in parallel on load)
+    printf("Registering syntax systems...\n");
+    RegisterSyntaxSystems(world);
+    printf("Syntax systems registered.\n");
+    
+    // Register the include-graph extractor (project dir first, then -I dirs)
+    printf("Registering include graph...\n");
+    RegisterIncludeGraph(world);
+    IncludeSettings *include_settings = ecs_singleton_get_mut(world, IncludeSettings);
+    include_settings->path_count = 0;
+    AddIncludePath(world, "./src");
+    for (int i = 0; i < include_path_count; i++) {
+        AddIncludePath(world, include_paths[i]);
+    }
+    AddIncludePath(world, "/usr/local/include");
+    AddIncludePath(world, "/usr/include");
+    printf("Include graph registered.\n");
+    
+    // Register the symbol index (files are rescanned when their spans change)
+    printf("Registering symbol index...\n");
+    RegisterSymbolIndex(world);
+    printf("Symbol index registered.\n");
+    
+    // Register full-text search (trigram index built in the background)
+    printf("Registering search index...\n");
+    RegisterSearchIndex(world);
+    printf("Search index registered.\n");
+    
+    // Register the fuzzy finder over file paths and function names
+    printf("Registering fuzzy finder...\n");
+    RegisterFuzzyFinder(world);
+    printf("Fuzzy finder registered.\n");
+    
+    // Register workspace snapshots (restored files are validated in the background)
+    printf("Registering workspace...\n");
+    RegisterWorkspace(world);
+    printf("Workspace registered.\n");
+    
+    // Register autosave (captured at frame end, written on a libuv worker)
+    printf("Registering autosave...\n");
+    RegisterAutosave(world);
+    if (autosave_path) {
+        SetAutosaveDirectory(world, autosave_path);
+    }
+    printf("Autosave registered.\n");
+    
     // Create prefabs for code editor elements
     printf("Creating prefabs...\n");
     CreatePrefabs(world);
     printf("Prefabs created.\n");
     
-    // Load example project files as phantoms
-    printf("Loading project files...\n");
-    LoadProjectAsPhantoms(world, "./src");
-    printf("Project files loaded.\n");
+    // Restore the last workspace, or load example project files as phantoms
+    if (workspace_path && LoadWorkspaceSnapshot(world, workspace_path) >= 0) {
+        // Recorded and replayed runs must see every file installed up front
+        if (record_path || replay_path) {
+            WaitWorkspace(world);
+        }
+    } else {
+        printf("Loading project files...\n");
+        LoadProjectAsPhantoms(world, "./src");
+        printf("Project files loaded.\n");
+    }
+    
+    // Put files back where the last autosave left them (not in recorded or
+    // replayed runs, which start from the loaded layout)
+    if (autosave_path && !record_path && !replay_path) {
+        RestoreAutosaveLayout(world, autosave_path);
+    }
     
     // Create additional code hierarchy examples
     printf("Creating code hierarchy...\n");
@@ -92,7 +247,14 @@ int main(void) {
         .terms = {
             { ecs_id(Position) },
             { ecs_id(TextContent) },
-            { ecs_id(Visible) }
+            { ecs_id(Visible) },
+            { ecs_id(TextLOD) },
+            // Skip lines of files that are currently drawn as an impostor
+            { ImpostorActive, .src.id = EcsUp, .trav = EcsChildOf, .oper = EcsNot },
+            // Lines of lexed files are drawn with colored token spans
+            { ecs_id(FileReference), .oper = EcsOptional },
+            { ecs_id(FileSyntax), .src.id = EcsUp, .trav = EcsChildOf, .oper = EcsOptional },
+            { ecs_id(Selected), .oper = EcsOptional }
         }
     });
 
@@ -103,6 +265,30 @@ int main(void) {
     int frame_count = 0;
     float avg_fps = 0.0f;
     
+    // Recording and replay both step the world with a fixed delta time
+    InputRecorder recorder = {0};
+    InputReplay replay = {0};
+    bool recording = false;
+    bool replaying = false;
+    if (replay_path) {
+        replaying = InputReplayOpen(&replay, replay_path);
+        if (replaying) {
+            printf("Replaying %u input frames from %s\n", replay.header.frame_count, replay_path);
+        }
+    } else if (record_path) {
+        InputLogHeader header = {.fixed_dt = INPUT_LOG_DEFAULT_DT};
+        recording = InputRecorderOpen(&recorder, record_path, &header);
+        if (recording) {
+            printf("Recording input to %s\n", record_path);
+        }
+    }
+    
+    // A time-budgeted layout would advance differently on every run
+    if (recording || replaying) {
+        LayoutSettings *layout_settings = ecs_singleton_get_mut(world, LayoutSettings);
+        layout_settings->fixed_iterations = 1;
+    }
+    
     // Main game loop
     while (!WindowShouldClose()) {
         double current_time = GetTime();
@@ -116,13 +302,61 @@ int main(void) {
             last_fps_time = current_time;
         }
         
+        // Profiler hotkeys: F8 toggles recording, F9 exports a Chrome trace
+        if (IsKeyPressed(KEY_F8)) {
+            ProfilerSetEnabled(!ProfilerIsEnabled());
+            printf("Profiler %s\n", ProfilerIsEnabled() ? "enabled" : "disabled");
+        }
+        if (IsKeyPressed(KEY_F9)) {
+            ProfilerExportChromeTrace(TextFormat("pevi_trace_%d.json", (int)time(NULL)));
+        }
+        
+        // F10 writes the per-subsystem memory report
+        if (IsKeyPressed(KEY_F10)) {
+            WriteMemoryReport(world, TextFormat("pevi_memory_%d.json", (int)time(NULL)));
+        }
+        
+        // Systems read input from the InputFrame singleton
+        uint64_t expected_hash = 0;
+        if (replaying) {
+            InputFrame input;
+            if (!InputReplayNext(&replay, &input, &expected_hash)) {
+                printf("Replay finished: %u frames, %u hash mismatches\n",
+                       replay.frame_index, replay.mismatches);
+                break;
+            }
+            ecs_singleton_set_ptr(world, InputFrame, &input);
+            delta_time = replay.header.fixed_dt;
+        } else {
+            CaptureRaylibInput(world);
+            if (recording) {
+                delta_time = INPUT_LOG_DEFAULT_DT;
+            }
+        }
+        
         // Update ECS world - this runs all systems in pipeline order
+        PROFILE_ZONE_BEGIN(Progress);
         ecs_progress(world, delta_time);
+        PROFILE_ZONE_END(Progress);
+        
+        // The hash walks the whole world, so it gets its own zone
+        if (recording || replaying) {
+            PROFILE_ZONE_BEGIN(StateHash);
+            uint64_t state_hash = ComputeWorldStateHash(world);
+            PROFILE_ZONE_END(StateHash);
+            if (recording) {
+                InputRecorderWrite(&recorder, ecs_singleton_get(world, InputFrame), state_hash);
+            } else {
+                InputReplayVerify(&replay, expected_hash, state_hash);
+            }
+        }
         
         // Rendering
         BeginDrawing();
         ClearBackground(BLACK);
         
+        PROFILE_ZONE_BEGIN(Render3D);
+        
         // Set up 3D camera from camera controller
         const CameraController *cam_ctrl = ecs_get(world, camera_entity, CameraController);
         if (cam_ctrl) {
@@ -140,13 +374,23 @@ int main(void) {
             DrawLine3D((Vector3){0, 0, 0}, (Vector3){0, 0, 5}, BLUE);   // Z axis
 
             // Render all 3D text entities
+            PROFILE_ZONE_BEGIN(RenderText);
             ecs_iter_t text_iter = ecs_query_iter(world, text_render_query);
             
             while (ecs_query_next(&text_iter)) {
                 Position *positions = ecs_field(&text_iter, Position, 0);
                 TextContent *texts = ecs_field(&text_iter, TextContent, 1);
+                TextLOD *lods = ecs_field(&text_iter, TextLOD, 3);
+                FileReference *refs = ecs_field(&text_iter, FileReference, 5);
+                const TokenBuffer *tokens = GetFileSyntax(world, ecs_field(&text_iter, FileSyntax, 6));
+                Selected *selections = ecs_field(&text_iter, Selected, 7);
                 
                 for (int i = 0; i < text_iter.count; i++) {
+                    // Hidden tier is represented by the parent file block
+                    if (lods[i].tier == TEXT_LOD_HIDDEN) {
+                        continue;
+                    }
+                    
                     Vector3 position = {positions[i].x, positions[i].y, positions[i].z};
                     
                     // Draw 3D text directly using Raylib
@@ -156,6 +400,12 @@ int main(void) {
                     if (screenPos.x >= 0 && screenPos.x <= GetScreenWidth() &&
                         screenPos.y >= 0 && screenPos.y <= GetScreenHeight()) {
                         
+                        // Far lines draw as a token-colored bar, no text measurement
+                        if (lods[i].tier == TEXT_LOD_SILHOUETTE) {
+                            DrawTextSilhouette(&lods[i], tokens, refs ? refs[i].line_number : -1, screenPos);
+                            continue;
+                        }
+                        
                         // Calculate text size for positioning
                         Font font = GetFontDefault();
                         Vector2 textSize = MeasureTextEx(font, texts[i].text, texts[i].font_size * 20, 1.0f);
@@ -163,11 +413,23 @@ int main(void) {
                         // Draw text with background for better visibility
                         Vector2 textPos = {screenPos.x - textSize.x/2, screenPos.y - textSize.y/2};
                         DrawRectangle(textPos.x - 2, textPos.y - 2, textSize.x + 4, textSize.y + 4, ColorAlpha(BLACK, 0.7f));
-                        DrawTextEx(font, texts[i].text, textPos, texts[i].font_size * 20, 1.0f, texts[i].color);
+                        // Selected lines keep their highlight color
+                        bool selected = selections && selections[i].is_selected;
+                        if (tokens && refs && !selected) {
+                            DrawSyntaxLine(tokens, refs[i].line_number, texts[i].text, font, textPos,
+                                           texts[i].font_size * 20, 1.0f);
+                        } else {
+                            DrawTextEx(font, texts[i].text, textPos, texts[i].font_size * 20, 1.0f, texts[i].color);
+                        }
                     }
                 }
             }
             
+            PROFILE_ZONE_END(RenderText);
+            
+            // Collapsed files are drawn as a single minimap billboard
+            DrawFileImpostors(world, camera);
+            
             // ECS text rendering happens in TextRenderSystem
             // But we can also draw additional 3D elements here
             
@@ -184,8 +446,10 @@ int main(void) {
             
             EndMode3D();
         }
+        PROFILE_ZONE_END(Render3D);
         
         // Draw 2D UI overlay
+        PROFILE_ZONE_BEGIN(RenderHUD);
         const EditorState *editor_state = ecs_get(world, editor, EditorState);
         if (editor_state) {
             const char* mode_names[] = {"Navigation", "Edit", "Command"};
@@ -194,6 +458,26 @@ int main(void) {
             DrawText(TextFormat("Mode: %s", mode_names[editor_state->current_mode]), 
                     10, 10, 24, mode_colors[editor_state->current_mode]);
             
+            // Command mode search prompt
+            const SearchPrompt *prompt = ecs_singleton_get(world, SearchPrompt);
+            if (prompt && prompt->active) {
+                DrawText(TextFormat("%c%s_  (%d hits)", prompt->regex ? '?' : '/', prompt->query, prompt->hits),
+                        260, 12, 20, ORANGE);
+            }
+            
+            // Command mode fuzzy finder and its ranked matches
+            const FinderPrompt *finder_prompt = ecs_singleton_get(world, FinderPrompt);
+            if (finder_prompt && finder_prompt->active) {
+                DrawText(TextFormat("p> %s_  (%d matches)", finder_prompt->query, finder_prompt->matches),
+                        260, 12, 20, ORANGE);
+                for (int r = 0; r < finder_prompt->result_count; r++) {
+                    const FinderResult *result = &finder_prompt->results[r];
+                    DrawText(TextFormat("%s %s", result->kind == FINDER_FILE ? "file" : "fn  ",
+                            GetFinderCandidateName(world, result->candidate)),
+                            260, 38 + r * 18, 16, r == 0 ? YELLOW : LIGHTGRAY);
+                }
+            }
+            
             if (editor_state->focused_entity != 0) {
                 DrawText(TextFormat("Selected: Entity %llu", editor_state->focused_entity),
                         10, 40, 20, YELLOW);
@@ -218,15 +502,165 @@ int main(void) {
                         10, GetScreenHeight() - 60, 16, LIGHTGRAY);
             }
             
-            // Performance information
-            DrawText(TextFormat("FPS: %.1f | Entities: %d", avg_fps, ecs_count_id(world, EcsAny)),
-                    10, GetScreenHeight() - 40, 16, LIME);
+            // Performance information (cached counters, O(1) per frame)
+            const WorldStats *world_stats = ecs_singleton_get(world, WorldStats);
+            if (world_stats) {
+                DrawText(TextFormat("FPS: %.1f | Entities: %d | Text: %d", avg_fps,
+                        world_stats->spatial_count, world_stats->text_count),
+                        10, GetScreenHeight() - 40, 16, LIME);
+                
+                DrawText(TextFormat("Visible: %d | Selected: %d",
+                        world_stats->visible_count, world_stats->selected_count),
+                        10, GetScreenHeight() - 20, 16, LIGHTGRAY);
+            }
+            
+            // Text LOD tier distribution
+            const TextLODStats *lod_stats = ecs_singleton_get(world, TextLODStats);
+            if (lod_stats) {
+                DrawText(TextFormat("LOD: glyphs %d | bars %d | hidden %d",
+                        lod_stats->tier_counts[TEXT_LOD_GLYPHS],
+                        lod_stats->tier_counts[TEXT_LOD_SILHOUETTE],
+                        lod_stats->tier_counts[TEXT_LOD_HIDDEN]),
+                        10, GetScreenHeight() - 80, 16, LIGHTGRAY);
+            }
+            
+            // Layout solver progress
+            const LayoutStats *layout_stats = ecs_singleton_get(world, LayoutStats);
+            if (layout_stats) {
+                DrawText(TextFormat("Layout: %d nodes | %d edges | %s | %d it %.2f ms | last %s solve: %d moved, %.1f ms",
+                        layout_stats->nodes, layout_stats->edges,
+                        layout_stats->converged ? "settled" : "settling",
+                        layout_stats->iterations_frame, layout_stats->frame_ms,
+                        layout_stats->solve_incremental ? "local" : "global",
+                        layout_stats->solve_moved, layout_stats->solve_ms),
+                        10, GetScreenHeight() - 100, 16, LIGHTGRAY);
+            }
+            
+            // Overlap resolution
+            const CollisionStats *collision_stats = ecs_singleton_get(world, CollisionStats);
+            if (collision_stats && CollisionAvailable()) {
+                DrawText(TextFormat("Collision: %d panels | %d overlaps | %d pushed | %.2f ms",
+                        collision_stats->panels, collision_stats->overlaps_frame,
+                        collision_stats->moved_frame, collision_stats->frame_ms),
+                        10, GetScreenHeight() - 120, 16, LIGHTGRAY);
+            }
+            
+            // Last pick or region query
+            const PickingStats *picking_stats = ecs_singleton_get(world, PickingStats);
+            if (picking_stats) {
+                DrawText(TextFormat("Picking: %d proxies | %d synced | last %s query: %d candidates, %d hits, %.1f us",
+                        picking_stats->proxies, picking_stats->synced_frame,
+                        picking_stats->last_query_jolt ? "broadphase" : "scan",
+                        picking_stats->candidates, picking_stats->hits, picking_stats->query_us),
+                        10, GetScreenHeight() - 140, 16, LIGHTGRAY);
+            }
+            
+            // Lexer totals for loaded files
+            const SyntaxStats *syntax_stats = ecs_singleton_get(world, SyntaxStats);
+            if (syntax_stats && syntax_stats->files > 0) {
+                DrawText(TextFormat("Syntax: %d files | %lld lines | %lld tokens | %.2f ms | last %.0f MB/s | last edit: %d lines re-lexed, %.1f us | %d undo/redo",
+                        syntax_stats->files, (long long)syntax_stats->lines, (long long)syntax_stats->tokens,
+                        syntax_stats->lex_ms, syntax_stats->last_mb_per_s,
+                        syntax_stats->last_edit_lines, syntax_stats->last_edit_us, syntax_stats->undos),
+                        10, GetScreenHeight() - 160, 16, LIGHTGRAY);
+            }
+            
+            // Last include scan
+            const IncludeStats *include_stats = ecs_singleton_get(world, IncludeStats);
+            if (include_stats && include_stats->sources > 0) {
+                DrawText(TextFormat("Includes: %d files | %d directives | %d headers | %d edges | %d unresolved | %.2f ms",
+                        include_stats->sources, include_stats->directives, include_stats->headers,
+                        include_stats->edges, include_stats->unresolved,
+                        include_stats->scan_ms + include_stats->resolve_ms + include_stats->apply_ms),
+                        10, GetScreenHeight() - 180, 16, LIGHTGRAY);
+            }
             
-            // ECS world statistics
-            int visible_count = ecs_count_id(world, Visible);
-            int selected_count = ecs_count_id(world, ecs_id(Selected));
-            DrawText(TextFormat("Visible: %d | Selected: %d", visible_count, selected_count),
-                    10, GetScreenHeight() - 20, 16, LIGHTGRAY);
+            // Last symbol scan (a whole project, or one edited file)
+            const SymbolStats *symbol_stats = ecs_singleton_get(world, SymbolStats);
+            if (symbol_stats && symbol_stats->symbols > 0) {
+                DrawText(TextFormat("Symbols: %d functions | %d names | last scan: %d files, %d callers, %d edges, %.2f ms",
+                        symbol_stats->functions, symbol_stats->symbols, symbol_stats->sources,
+                        symbol_stats->callers_updated, symbol_stats->edges,
+                        symbol_stats->scan_ms + symbol_stats->index_ms + symbol_stats->apply_ms),
+                        10, GetScreenHeight() - 200, 16, LIGHTGRAY);
+            }
+            
+            // Search index and the last query
+            const SearchStats *search_stats = ecs_singleton_get(world, SearchStats);
+            if (search_stats && search_stats->documents > 0) {
+                DrawText(TextFormat("Search: %d files (%d pending)%s | %d trigrams | %.1f MB | last query: %d candidates, %d hits, %.1f us",
+                        search_stats->documents, search_stats->pending_documents,
+                        search_stats->building ? " building" : "", search_stats->trigrams,
+                        (double)search_stats->segment_bytes / (1024.0 * 1024.0),
+                        search_stats->candidates, search_stats->hits, search_stats->query_us),
+                        10, GetScreenHeight() - 220, 16, LIGHTGRAY);
+            }
+            
+            // Fuzzy finder candidates and the last keystroke
+            const FinderStats *finder_stats = ecs_singleton_get(world, FinderStats);
+            if (finder_stats && finder_stats->candidates > 0) {
+                DrawText(TextFormat("Finder: %d candidates (%d files) | last query: %d scanned%s, %d prefiltered, %d matches, %.1f us",
+                        finder_stats->candidates, finder_stats->files, finder_stats->scanned,
+                        finder_stats->incremental ? " (narrowed)" : "", finder_stats->prefiltered,
+                        finder_stats->matches, finder_stats->query_us),
+                        10, GetScreenHeight() - 240, 16, LIGHTGRAY);
+            }
+            
+            // Restored workspace and its background validation
+            const WorkspaceStats *workspace_stats = ecs_singleton_get(world, WorkspaceStats);
+            if (workspace_stats && workspace_stats->files > 0) {
+                DrawText(TextFormat("Workspace: %d files, %d phantoms restored in %.1f ms | validated %d/%d, %d stale%s",
+                        workspace_stats->files, workspace_stats->phantoms,
+                        workspace_stats->map_ms + workspace_stats->insert_ms,
+                        workspace_stats->installed, workspace_stats->files, workspace_stats->stale,
+                        workspace_stats->validating ? " ..." : ""),
+                        10, GetScreenHeight() - 260, 16, LIGHTGRAY);
+            }
+            
+            // Background autosave and the main-thread cost of capturing it
+            const AutosaveStats *autosave_stats = ecs_singleton_get(world, AutosaveStats);
+            if (autosave_stats && autosave_stats->saves > 0) {
+                DrawText(TextFormat("Autosave: %d saves | last %d files, %d buffers, %lld KB in %.1f ms | capture %.3f ms (max %.3f)%s",
+                        autosave_stats->saves, autosave_stats->files, autosave_stats->buffers,
+                        (long long)(autosave_stats->bytes / 1024), autosave_stats->latency_ms,
+                        autosave_stats->capture_ms, autosave_stats->capture_max_ms,
+                        autosave_stats->pending ? " ..." : ""),
+                        10, GetScreenHeight() - 280, 16, LIGHTGRAY);
+            }
+            
+            // Transient per-frame memory; chunk mallocs stay at 0 once warmed up
+            const FrameArenaStats *arena_stats = ecs_singleton_get(world, FrameArenaStats);
+            if (arena_stats && arena_stats->frames > 0) {
+                DrawText(TextFormat("Frame arena: %lld KB used (high water %lld KB) of %lld KB in %d arenas | %lld allocs, %d chunk mallocs this frame",
+                        (long long)(arena_stats->used_frame / 1024), (long long)(arena_stats->high_water / 1024),
+                        (long long)(arena_stats->capacity / 1024), arena_stats->arenas,
+                        (long long)arena_stats->allocations_frame, arena_stats->chunk_mallocs_frame),
+                        10, GetScreenHeight() - 300, 16, LIGHTGRAY);
+            }
+            
+            // Live memory of the largest subsystems, red when a budget is exceeded
+            const MemoryStats *memory_stats = ecs_singleton_get(world, MemoryStats);
+            if (memory_stats) {
+                int largest[3];
+                for (int k = 0; k < 3; k++) {
+                    largest[k] = -1;
+                    for (int t = 0; t < MEMORY_TAG_COUNT; t++) {
+                        bool taken = (k > 0 && largest[0] == t) || (k > 1 && largest[1] == t);
+                        if (!taken && (largest[k] < 0 ||
+                                       memory_stats->tags[t].live > memory_stats->tags[largest[k]].live)) {
+                            largest[k] = t;
+                        }
+                    }
+                }
+                DrawText(TextFormat("Memory: %.1f MB live (peak %.1f) | %s %.1f, %s %.1f, %s %.1f MB | %s %.0f allocs/s%s",
+                        memory_stats->live / (1024.0 * 1024.0), memory_stats->peak / (1024.0 * 1024.0),
+                        MemoryTagName(largest[0]), memory_stats->tags[largest[0]].live / (1024.0 * 1024.0),
+                        MemoryTagName(largest[1]), memory_stats->tags[largest[1]].live / (1024.0 * 1024.0),
+                        MemoryTagName(largest[2]), memory_stats->tags[largest[2]].live / (1024.0 * 1024.0),
+                        MemoryTagName(MEMORY_TAG_ECS), memory_stats->tags[MEMORY_TAG_ECS].allocations_per_s,
+                        memory_stats->over_budget > 0 ? " | OVER BUDGET" : ""),
+                        10, GetScreenHeight() - 320, 16, memory_stats->over_budget > 0 ? RED : LIGHTGRAY);
+            }
         }
         
         // Controls help
@@ -236,7 +670,13 @@ int main(void) {
         DrawText("Mouse Wheel: Zoom", GetScreenWidth() - 300, 75, 14, LIGHTGRAY);
         DrawText("Left Click: Select Phantom", GetScreenWidth() - 300, 95, 14, LIGHTGRAY);
         DrawText("Tab: Switch Mode", GetScreenWidth() - 300, 115, 14, LIGHTGRAY);
-        DrawText("ESC: Exit", GetScreenWidth() - 300, 135, 14, LIGHTGRAY);
+        DrawText("B / O (Command): Box / Sphere Select", GetScreenWidth() - 300, 135, 14, LIGHTGRAY);
+        DrawText("Type / Backspace (Edit): Edit Focused Line", GetScreenWidth() - 300, 155, 14, LIGHTGRAY);
+        DrawText("Ctrl+Z / Ctrl+Y (Edit): Undo / Redo", GetScreenWidth() - 300, 175, 14, LIGHTGRAY);
+        DrawText("/ or ? (Command): Search Text / Regex", GetScreenWidth() - 300, 195, 14, LIGHTGRAY);
+        DrawText("P (Command): Fuzzy Find Files / Functions", GetScreenWidth() - 300, 215, 14, LIGHTGRAY);
+        DrawText("F8: Toggle Profiler", GetScreenWidth() - 300, 235, 14, LIGHTGRAY);
+        DrawText("ESC: Exit", GetScreenWidth() - 300, 255, 14, LIGHTGRAY);
         
         // Mode transition feedback
         if (editor_state && editor_state->mode_transition) {
@@ -249,7 +689,17 @@ int main(void) {
             }
         }
         
+        if (ProfilerIsEnabled()) {
+            DrawProfilerOverlay(10, 120, 520);
+        }
+        PROFILE_ZONE_END(RenderHUD);
+        
+        PROFILE_ZONE_BEGIN(EndDrawing);
         EndDrawing();
+        PROFILE_ZONE_END(EndDrawing);
+        
+        // Collect this frame's zones from all threads
+        ProfilerFrameEnd();
     }
     
     // Cleanup
@@ -260,6 +710,17 @@ int main(void) {
     printf("Visible entities: %d\n", ecs_count_id(world, Visible));
     printf("Text entities: %d\n", ecs_count_id(world, ecs_id(TextContent)));
     
+    InputRecorderClose(&recorder);
+    InputReplayClose(&replay);
+    
+    FlushAutosave(world);
+    if (workspace_path) {
+        SaveWorkspaceSnapshot(world, workspace_path);
+    }
+    if (memory_report_path) {
+        WriteMemoryReport(world, memory_report_path);
+    }
+    
     ecs_fini(world);
     CloseWindow();
     
@@ -0,0 +1,538 @@
+#define _POSIX_C_SOURCE 200809L  // uv.h needs pthread_rwlock_t
+#include "../systems/remote_protocol.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uv.h>
+
+// Command line viewer for pevi_server. It keeps a replica of the served
+// phantoms and reports bandwidth and update latency.
+//
+//     pevi_client [--connect ADDR] [--seconds S] [--nudges N]
+//
+// Update latency runs from the server capturing a frame to the client
+// having applied it. Both ends read uv_hrtime, so it only means something
+// when they run on one machine. With --nudges the client moves a random
+// file N times per second and times each move until the delta that
+// acknowledges it has been applied.
+
+#define CLIENT_READ_SIZE (256 * 1024)
+#define CLIENT_MAX_PENDING_NUDGES 256
+#define CLIENT_NUDGE_DISTANCE 0.5f
+#define CLIENT_KIND_COUNT 4
+
+typedef struct {
+    bool live;
+    uint8_t kind;
+    uint32_t parent;
+    float x, y, z;            // Relative to the parent
+    uint8_t text_length;
+    uint16_t token_count;
+    uint16_t edge_count;
+    uint8_t *content;         // Text, tokens and edges as received
+} ReplicaNode;
+
+typedef struct {
+    uint64_t *values;
+    int count;
+    int capacity;
+} Samples;
+
+typedef struct {
+    uint32_t token;
+    uint64_t sent_ns;
+} PendingNudge;
+
+typedef struct {
+    uv_write_t request;
+    uint8_t data[REMOTE_HEADER_SIZE + REMOTE_NUDGE_SIZE];
+} NudgeWrite;
+
+static struct {
+    uv_loop_t *loop;
+    union {
+        uv_tcp_t tcp;
+        uv_pipe_t pipe;
+    } handle;
+    uv_connect_t connect;
+    uv_timer_t finish;
+    uv_timer_t nudge;
+    bool connected;
+    double seconds;
+
+    uint8_t *received;
+    size_t received_length;
+    size_t received_capacity;
+
+    // Replica, indexed by node id
+    ReplicaNode *nodes;
+    uint32_t node_capacity;
+    int32_t live;
+    int32_t kinds[CLIENT_KIND_COUNT];
+    int64_t tokens;
+    int64_t edges;
+
+    uint64_t start_ns;
+    uint64_t connected_ns;
+    uint64_t snapshot_ns;     // First snapshot applied
+    uint64_t bytes;
+    uint64_t snapshot_bytes;
+    double snapshot_decode_ms;
+    int snapshots;
+    uint64_t delta_bytes;
+    uint64_t max_delta_bytes;
+    int deltas;
+    uint32_t first_frame;
+    uint32_t last_frame;
+    int64_t upserts;
+    int64_t moves;
+    int64_t removes;
+    Samples latency;
+    Samples nudge_latency;
+
+    PendingNudge pending[CLIENT_MAX_PENDING_NUDGES];
+    int pending_count;
+    uint32_t next_token;
+    int nudges_sent;
+    int errors;               // Records that do not apply to the replica
+    bool failed;              // Protocol error or lost connection
+} client;
+
+static void AddSample(Samples *samples, uint64_t value) {
+    if (samples->count == samples->capacity) {
+        int capacity = samples->capacity > 0 ? samples->capacity * 2 : 1024;
+        uint64_t *grown = realloc(samples->values, sizeof(uint64_t) * (size_t)capacity);
+        if (!grown) {
+            return;
+        }
+        samples->values = grown;
+        samples->capacity = capacity;
+    }
+    samples->values[samples->count++] = value;
+}
+
+static int CompareSamples(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static void PrintSamples(const char *label, Samples *samples) {
+    if (samples->count == 0) {
+        printf("%-16s no samples\n", label);
+        return;
+    }
+    qsort(samples->values, (size_t)samples->count, sizeof(uint64_t), CompareSamples);
+    printf("%-16s p50 %.2f ms, p99 %.2f ms, max %.2f ms (%d samples)\n", label,
+           samples->values[samples->count / 2] / 1e6,
+           samples->values[(int)(samples->count * 0.99)] / 1e6,
+           samples->values[samples->count - 1] / 1e6, samples->count);
+}
+
+// Replica
+
+static void ForgetNode(ReplicaNode *node) {
+    if (!node->live) {
+        return;
+    }
+    client.live--;
+    client.kinds[node->kind < CLIENT_KIND_COUNT ? node->kind : REMOTE_NODE_OTHER]--;
+    client.tokens -= node->token_count;
+    client.edges -= node->edge_count;
+    free(node->content);
+    memset(node, 0, sizeof(*node));
+}
+
+static bool ApplyNode(const RemoteNode *record) {
+    if (record->id >= client.node_capacity) {
+        uint32_t capacity = client.node_capacity > 0 ? client.node_capacity : 1024;
+        while (capacity <= record->id) {
+            capacity *= 2;
+        }
+        ReplicaNode *grown = realloc(client.nodes, sizeof(ReplicaNode) * capacity);
+        if (!grown) {
+            return false;
+        }
+        memset(grown + client.node_capacity, 0, sizeof(ReplicaNode) * (capacity - client.node_capacity));
+        client.nodes = grown;
+        client.node_capacity = capacity;
+    }
+    ReplicaNode *node = &client.nodes[record->id];
+    ForgetNode(node);
+    size_t content_size = RemoteNodeSize(record) - REMOTE_NODE_SIZE;
+    node->content = malloc(content_size > 0 ? content_size : 1);
+    if (!node->content) {
+        return false;
+    }
+    memcpy(node->content, record->text, content_size);
+    node->live = true;
+    node->kind = record->kind;
+    node->parent = record->parent;
+    node->x = record->x;
+    node->y = record->y;
+    node->z = record->z;
+    node->text_length = record->text_length;
+    node->token_count = record->token_count;
+    node->edge_count = record->edge_count;
+    client.live++;
+    client.kinds[node->kind < CLIENT_KIND_COUNT ? node->kind : REMOTE_NODE_OTHER]++;
+    client.tokens += node->token_count;
+    client.edges += node->edge_count;
+    return true;
+}
+
+static ReplicaNode *FindNode(uint32_t id) {
+    return id < client.node_capacity && client.nodes[id].live ? &client.nodes[id] : NULL;
+}
+
+static bool ApplySnapshot(const uint8_t *body, size_t length) {
+    for (uint32_t i = 0; i < client.node_capacity; i++) {
+        ForgetNode(&client.nodes[i]);
+    }
+    if (length < 4) {
+        return false;
+    }
+    uint32_t count = RemoteGetU32(body);
+    size_t offset = 4;
+    for (uint32_t n = 0; n < count; n++) {
+        RemoteNode record;
+        size_t size = RemoteGetNode(body + offset, length - offset, &record);
+        if (size == 0 || !ApplyNode(&record)) {
+            return false;
+        }
+        offset += size;
+    }
+    return offset == length;
+}
+
+static void AcknowledgeNudge(uint32_t token, uint64_t now) {
+    for (int i = 0; i < client.pending_count; i++) {
+        if (client.pending[i].token == token) {
+            AddSample(&client.nudge_latency, now - client.pending[i].sent_ns);
+            client.pending[i] = client.pending[--client.pending_count];
+            return;
+        }
+    }
+}
+
+static bool ApplyDelta(const uint8_t *body, size_t length) {
+    if (length < 16) {
+        return false;
+    }
+    uint32_t removed = RemoteGetU32(body);
+    uint32_t upserted = RemoteGetU32(body + 4);
+    uint32_t moved = RemoteGetU32(body + 8);
+    uint32_t acks = RemoteGetU32(body + 12);
+    size_t offset = 16;
+
+    if ((length - offset) / 4 < removed) {
+        return false;
+    }
+    for (uint32_t i = 0; i < removed; i++, offset += 4) {
+        ReplicaNode *node = FindNode(RemoteGetU32(body + offset));
+        if (node) {
+            ForgetNode(node);
+        } else {
+            client.errors++;
+        }
+    }
+    for (uint32_t i = 0; i < upserted; i++) {
+        RemoteNode record;
+        size_t size = RemoteGetNode(body + offset, length - offset, &record);
+        if (size == 0 || !ApplyNode(&record)) {
+            return false;
+        }
+        offset += size;
+    }
+    if ((length - offset) / REMOTE_MOVE_SIZE < moved) {
+        return false;
+    }
+    for (uint32_t i = 0; i < moved; i++, offset += REMOTE_MOVE_SIZE) {
+        ReplicaNode *node = FindNode(RemoteGetU32(body + offset));
+        if (!node) {
+            client.errors++;
+            continue;
+        }
+        node->x = RemoteGetF32(body + offset + 4);
+        node->y = RemoteGetF32(body + offset + 8);
+        node->z = RemoteGetF32(body + offset + 12);
+    }
+    if ((length - offset) / 4 != acks || (length - offset) % 4 != 0) {
+        return false;
+    }
+    uint64_t now = uv_hrtime();
+    for (uint32_t i = 0; i < acks; i++, offset += 4) {
+        AcknowledgeNudge(RemoteGetU32(body + offset), now);
+    }
+    client.removes += removed;
+    client.upserts += upserted;
+    client.moves += moved;
+    return true;
+}
+
+// Sockets
+
+static void Finish(void) {
+    uv_timer_stop(&client.finish);
+    uv_timer_stop(&client.nudge);
+    if (!uv_is_closing((uv_handle_t*)&client.handle)) {
+        uv_close((uv_handle_t*)&client.handle, NULL);
+    }
+}
+
+static void Fail(const char *message) {
+    fprintf(stderr, "pevi_client: %s\n", message);
+    client.failed = true;
+    Finish();
+}
+
+static void OnMessage(const RemoteHeader *header, const uint8_t *body, size_t length) {
+    uint64_t start = uv_hrtime();
+    if (header->type == REMOTE_MSG_SNAPSHOT) {
+        if (!ApplySnapshot(body, length)) {
+            Fail("malformed snapshot");
+            return;
+        }
+        uint64_t now = uv_hrtime();
+        if (client.snapshots++ == 0) {
+            client.snapshot_ns = now;
+            client.snapshot_bytes = header->length;
+            client.snapshot_decode_ms = (double)(now - start) / 1e6;
+            client.first_frame = header->frame;
+        }
+    } else if (header->type == REMOTE_MSG_DELTA) {
+        if (client.snapshots == 0 || !ApplyDelta(body, length)) {
+            Fail("malformed delta");
+            return;
+        }
+        client.deltas++;
+        client.delta_bytes += header->length;
+        if (header->length > client.max_delta_bytes) {
+            client.max_delta_bytes = header->length;
+        }
+        AddSample(&client.latency, uv_hrtime() - header->time_ns);
+    }
+    client.last_frame = header->frame;
+}
+
+static void AllocReceiveBuffer(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf) {
+    (void)handle;
+    (void)suggested_size;
+    if (client.received_capacity - client.received_length < CLIENT_READ_SIZE) {
+        size_t capacity = client.received_capacity > 0 ? client.received_capacity * 2 : CLIENT_READ_SIZE * 4;
+        uint8_t *grown = realloc(client.received, capacity);
+        if (!grown) {
+            *buf = uv_buf_init(NULL, 0);
+            return;
+        }
+        client.received = grown;
+        client.received_capacity = capacity;
+    }
+    *buf = uv_buf_init((char*)client.received + client.received_length,
+                       (unsigned int)(client.received_capacity - client.received_length));
+}
+
+static void OnRead(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
+    (void)buf;
+    if (nread < 0) {
+        if (!client.failed && !uv_is_closing((uv_handle_t*)stream)) {
+            Fail(nread == UV_EOF ? "server closed the connection" : uv_strerror((int)nread));
+        }
+        return;
+    }
+    client.received_length += (size_t)nread;
+    client.bytes += (uint64_t)nread;
+
+    size_t offset = 0;
+    while (client.received_length - offset >= REMOTE_HEADER_SIZE && !client.failed) {
+        RemoteHeader header;
+        RemoteGetHeader(client.received + offset, &header);
+        if (header.version != REMOTE_PROTOCOL_VERSION) {
+            Fail("server speaks another protocol version");
+            return;
+        }
+        if (header.length < REMOTE_HEADER_SIZE || header.length > REMOTE_MAX_MESSAGE) {
+            Fail("invalid message length");
+            return;
+        }
+        if (client.received_length - offset < header.length) {
+            break;
+        }
+        OnMessage(&header, client.received + offset + REMOTE_HEADER_SIZE, header.length - REMOTE_HEADER_SIZE);
+        offset += header.length;
+    }
+    if (offset > 0) {
+        memmove(client.received, client.received + offset, client.received_length - offset);
+        client.received_length -= offset;
+    }
+}
+
+static void OnNudgeWritten(uv_write_t *request, int status) {
+    (void)status;
+    free(request);
+}
+
+// Move a random file back and forth; its delta acknowledges the token
+static void OnNudgeTimer(uv_timer_t *timer) {
+    (void)timer;
+    if (client.snapshots == 0 || client.pending_count == CLIENT_MAX_PENDING_NUDGES || client.node_capacity == 0) {
+        return;
+    }
+    uint32_t start = (uint32_t)rand() % client.node_capacity;
+    uint32_t id = 0;
+    for (uint32_t i = 0; i < client.node_capacity && id == 0; i++) {
+        uint32_t candidate = (start + i) % client.node_capacity;
+        if (client.nodes[candidate].live && client.nodes[candidate].kind == REMOTE_NODE_FILE) {
+            id = candidate;
+        }
+    }
+    if (id == 0) {
+        return;
+    }
+    NudgeWrite *write = malloc(sizeof(NudgeWrite));
+    if (!write) {
+        return;
+    }
+    uint32_t token = client.next_token++;
+    RemoteHeader header = {
+        .length = sizeof(write->data),
+        .type = REMOTE_MSG_NUDGE,
+        .version = REMOTE_PROTOCOL_VERSION
+    };
+    RemotePutHeader(write->data, &header);
+    uint8_t *body = write->data + REMOTE_HEADER_SIZE;
+    RemotePutU32(body, id);
+    RemotePutF32(body + 4, token & 1 ? CLIENT_NUDGE_DISTANCE : -CLIENT_NUDGE_DISTANCE);
+    RemotePutF32(body + 8, 0.0f);
+    RemotePutF32(body + 12, 0.0f);
+    RemotePutU32(body + 16, token);
+    uv_buf_t buf = uv_buf_init((char*)write->data, sizeof(write->data));
+    if (uv_write(&write->request, (uv_stream_t*)&client.handle, &buf, 1, OnNudgeWritten) < 0) {
+        free(write);
+        return;
+    }
+    client.pending[client.pending_count++] = (PendingNudge){token, uv_hrtime()};
+    client.nudges_sent++;
+}
+
+static void OnFinishTimer(uv_timer_t *timer) {
+    (void)timer;
+    Finish();
+}
+
+static void OnConnect(uv_connect_t *request, int status) {
+    (void)request;
+    if (status < 0) {
+        fprintf(stderr, "pevi_client: cannot connect: %s\n", uv_strerror(status));
+        client.failed = true;
+        Finish();
+        return;
+    }
+    client.connected = true;
+    client.connected_ns = uv_hrtime();
+    uv_read_start((uv_stream_t*)&client.handle, AllocReceiveBuffer, OnRead);
+    uv_timer_start(&client.finish, OnFinishTimer, (uint64_t)(client.seconds * 1000.0), 0);
+}
+
+static void PrintReport(const char *address) {
+    double elapsed_s = (double)(uv_hrtime() - client.connected_ns) / 1e9;
+    double stream_s = client.snapshot_ns ? (double)(uv_hrtime() - client.snapshot_ns) / 1e9 : 0.0;
+    printf("Server:          %s, %.1f s connected\n", address, elapsed_s);
+    printf("Replica:         %d nodes (%d files, %d lines, %d functions, %d other), %lld tokens, %lld edges\n",
+           client.live, client.kinds[REMOTE_NODE_FILE], client.kinds[REMOTE_NODE_LINE],
+           client.kinds[REMOTE_NODE_FUNCTION], client.kinds[REMOTE_NODE_OTHER],
+           (long long)client.tokens, (long long)client.edges);
+    printf("Snapshot:        %.2f MB, applied %.1f ms after connecting (decode %.1f ms), %d received\n",
+           client.snapshot_bytes / (1024.0 * 1024.0),
+           client.snapshot_ns ? (double)(client.snapshot_ns - client.connected_ns) / 1e6 : 0.0,
+           client.snapshot_decode_ms, client.snapshots);
+    printf("Deltas:          %d for %u frames, %.0f bytes average, %llu max\n", client.deltas,
+           client.last_frame - client.first_frame, client.deltas ? (double)client.delta_bytes / client.deltas : 0.0,
+           (unsigned long long)client.max_delta_bytes);
+    printf("Records:         %lld upserts, %lld moves, %lld removes\n",
+           (long long)client.upserts, (long long)client.moves, (long long)client.removes);
+    printf("Bandwidth:       %.2f MB/s overall, %.1f KB/s of deltas\n",
+           elapsed_s > 0.0 ? client.bytes / (1024.0 * 1024.0) / elapsed_s : 0.0,
+           stream_s > 0.0 ? client.delta_bytes / 1024.0 / stream_s : 0.0);
+    PrintSamples("Update latency:", &client.latency);
+    if (client.nudges_sent > 0) {
+        printf("Nudges:          %d sent, %d acknowledged\n", client.nudges_sent,
+               client.nudge_latency.count);
+        PrintSamples("Nudge latency:", &client.nudge_latency);
+    }
+    printf("Errors:          %d\n", client.errors);
+}
+
+int main(int argc, char **argv) {
+    const char *address = "127.0.0.1:7341";
+    double nudges_per_s = 0.0;
+    client.seconds = 10.0;
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--connect") == 0 && has_value) {
+            address = argv[++i];
+        } else if (strcmp(argv[i], "--seconds") == 0 && has_value) {
+            client.seconds = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--nudges") == 0 && has_value) {
+            nudges_per_s = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--connect ADDR] [--seconds S] [--nudges N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    client.loop = uv_default_loop();
+    client.start_ns = uv_hrtime();
+    client.next_token = (uint32_t)client.start_ns;
+    srand((unsigned int)client.start_ns);
+    uv_timer_init(client.loop, &client.finish);
+    uv_timer_init(client.loop, &client.nudge);
+
+    char host[256];
+    int port = 0;
+    int result;
+    if (RemoteSplitAddress(address, host, sizeof(host), &port)) {
+        struct sockaddr_storage addr;
+        result = uv_ip4_addr(host, port, (struct sockaddr_in*)&addr);
+        if (result) {
+            result = uv_ip6_addr(host, port, (struct sockaddr_in6*)&addr);
+        }
+        uv_tcp_init(client.loop, &client.handle.tcp);
+        uv_tcp_nodelay(&client.handle.tcp, 1);
+        if (!result) {
+            result = uv_tcp_connect(&client.connect, &client.handle.tcp, (const struct sockaddr*)&addr, OnConnect);
+        }
+    } else {
+        uv_pipe_init(client.loop, &client.handle.pipe, 0);
+        uv_pipe_connect(&client.connect, &client.handle.pipe, address, OnConnect);
+        result = 0;
+    }
+    if (result) {
+        fprintf(stderr, "pevi_client: invalid address %s: %s\n", address, uv_strerror(result));
+        return 1;
+    }
+    if (nudges_per_s > 0.0) {
+        uint64_t interval = (uint64_t)(1000.0 / nudges_per_s);
+        uv_timer_start(&client.nudge, OnNudgeTimer, interval, interval > 0 ? interval : 1);
+    }
+
+    uv_run(client.loop, UV_RUN_DEFAULT);
+    uv_close((uv_handle_t*)&client.finish, NULL);
+    uv_close((uv_handle_t*)&client.nudge, NULL);
+    uv_run(client.loop, UV_RUN_DEFAULT);
+
+    if (client.connected) {
+        PrintReport(address);
+    }
+    uv_loop_close(client.loop);
+    for (uint32_t i = 0; i < client.node_capacity; i++) {
+        ForgetNode(&client.nodes[i]);
+    }
+    free(client.nodes);
+    free(client.received);
+    free(client.latency.values);
+    free(client.nudge_latency.values);
+    return client.failed || client.snapshots == 0 || client.errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,226 @@
+#include "../components/spatial.h"
+#include "../systems/core_systems.h"
+#include "../systems/frame_arena.h"
+#include "../systems/memory_tracker.h"
+#include "../systems/observers.h"
+#include "../systems/prefabs.h"
+#include "../systems/file_loader.h"
+#include "../systems/impostor.h"
+#include "../systems/text_lod.h"
+#include "../systems/profiler.h"
+#include "../systems/world_stats.h"
+#include "../systems/layout.h"
+#include "../systems/collision.h"
+#include "../systems/picking.h"
+#include "../systems/syntax.h"
+#include "../systems/include_graph.h"
+#include "../systems/symbol_index.h"
+#include "../systems/search_index.h"
+#include "../systems/fuzzy_finder.h"
+#include "../systems/workspace.h"
+#include "../systems/autosave.h"
+#include "../systems/remote_server.h"
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Headless editor core: loads, lexes, indexes and lays out files without a
+// window, and serves the phantoms to remote viewers (see remote_server.h).
+//
+//     pevi_server [--listen ADDR] [--fps N] [--frames K] [--workspace FILE]
+//                 [-I DIR] [--memory-report FILE] [FILE...]
+//
+// ADDR is host:port, a port on 127.0.0.1 or the path of a Unix domain
+// socket (default 127.0.0.1:7341). Without files or a workspace the
+// example project in ./src is loaded. The server runs until interrupted,
+// or for K frames.
+
+#define SERVER_FILE_SPACING 15.0f  // Grid of file containers before the layout moves them
+#define SERVER_STATUS_INTERVAL_S 5.0
+
+static volatile sig_atomic_t quit_requested = 0;
+
+static void OnSignal(int signal_number) {
+    (void)signal_number;
+    quit_requested = 1;
+}
+
+static void PrintUsage(const char *program) {
+    fprintf(stderr, "Usage: %s [--listen ADDR] [--fps N] [--frames K] [--workspace FILE]\n"
+            "       [-I DIR] [--memory-report FILE] [FILE...]\n", program);
+}
+
+// The editor's modules minus the window: impostors keep their CPU image
+// and nothing is drawn
+static ecs_world_t *CreateHeadlessWorld(const char **include_paths, int include_path_count) {
+    ecs_world_t *world = ecs_init();
+    RegisterSpatialComponents(world);
+    RegisterCoreSystems(world);
+    RegisterFrameArena(world);
+    RegisterMemoryTracker(world);
+    RegisterObservers(world);
+    RegisterWorldStats(world);
+    RegisterImpostorSystems(world);
+    RegisterTextLODSystems(world);
+    RegisterLayoutSystems(world);
+    RegisterCollisionSystems(world);
+    RegisterPickingSystems(world);
+    RegisterSyntaxSystems(world);
+    RegisterIncludeGraph(world);
+    IncludeSettings *include_settings = ecs_singleton_get_mut(world, IncludeSettings);
+    include_settings->path_count = 0;
+    for (int i = 0; i < include_path_count; i++) {
+        AddIncludePath(world, include_paths[i]);
+    }
+    AddIncludePath(world, "/usr/local/include");
+    AddIncludePath(world, "/usr/include");
+    RegisterSymbolIndex(world);
+    RegisterSearchIndex(world);
+    RegisterFuzzyFinder(world);
+    RegisterWorkspace(world);
+    RegisterAutosave(world);
+    RegisterRemoteServer(world);
+    CreatePrefabs(world);
+
+    // Systems that follow the view read the camera and editor singletons
+    ecs_entity_t camera_entity = ecs_new(world);
+    ecs_set_name(world, camera_entity, "MainCamera");
+    ecs_set(world, camera_entity, CameraController, {
+        .target = {0.0f, 0.0f, 0.0f},
+        .distance = 20.0f,
+        .pitch = 30.0f,
+        .yaw = 45.0f,
+        .move_speed = 10.0f,
+        .rotation_speed = 0.5f,
+        .mode = 0
+    });
+    ecs_entity_t editor = ecs_new(world);
+    ecs_set_name(world, editor, "Editor");
+    ecs_set(world, editor, EditorState, {
+        .current_mode = 0,
+        .previous_mode = 0,
+        .mode_transition = false,
+        .focused_entity = 0
+    });
+    return world;
+}
+
+// Files on a grid in the XZ plane, as the bench lays them out
+static void LoadFiles(ecs_world_t *world, char **paths, int count) {
+    int columns = (int)ceilf(sqrtf((float)count));
+    if (columns < 1) {
+        columns = 1;
+    }
+    for (int f = 0; f < count; f++) {
+        Vector3 origin = {(f % columns) * SERVER_FILE_SPACING, 0.0f, (f / columns) * SERVER_FILE_SPACING};
+        LoadFileAsPhantoms(world, paths[f], origin);
+    }
+}
+
+static void PrintStatus(ecs_world_t *world, uint32_t frame) {
+    const RemoteServerStats *remote = ecs_singleton_get(world, RemoteServerStats);
+    const LayoutStats *layout = ecs_singleton_get(world, LayoutStats);
+    printf("Frame %u: %d clients, %d phantoms, %.1f MB sent, capture %.2f ms (max %.2f), layout %s\n",
+           frame, remote->clients, remote->nodes, remote->bytes_sent / (1024.0 * 1024.0),
+           remote->capture_ms, remote->capture_max_ms,
+           layout && layout->converged ? "converged" : "solving");
+}
+
+int main(int argc, char **argv) {
+    const char *listen_address = "127.0.0.1:7341";
+    const char *workspace_path = NULL;
+    const char *memory_report_path = NULL;
+    const char *include_paths[INCLUDE_MAX_PATHS];
+    int include_path_count = 0;
+    int fps = 60;
+    int frames = 0;
+    char **files = malloc(sizeof(char*) * (size_t)(argc > 0 ? argc : 1));
+    int file_count = 0;
+    if (!files) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--listen") == 0 && has_value) {
+            listen_address = argv[++i];
+        } else if (strcmp(argv[i], "--fps") == 0 && has_value) {
+            fps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--frames") == 0 && has_value) {
+            frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--workspace") == 0 && has_value) {
+            workspace_path = argv[++i];
+        } else if (strcmp(argv[i], "--memory-report") == 0 && has_value) {
+            memory_report_path = argv[++i];
+        } else if (strcmp(argv[i], "-I") == 0 && has_value) {
+            if (include_path_count < INCLUDE_MAX_PATHS) {
+                include_paths[include_path_count++] = argv[i + 1];
+            }
+            i++;
+        } else if (argv[i][0] == '-') {
+            PrintUsage(argv[0]);
+            return 2;
+        } else {
+            files[file_count++] = argv[i];
+        }
+    }
+    if (fps <= 0 || frames < 0) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    InstallMemoryTracker();
+    ecs_world_t *world = CreateHeadlessWorld(include_paths, include_path_count);
+
+    // Everything is loaded and lexed before the first client can connect
+    uint64_t load_start = ProfilerNow();
+    if (workspace_path && LoadWorkspaceSnapshot(world, workspace_path) >= 0) {
+        WaitWorkspace(world);
+    } else if (file_count > 0) {
+        LoadFiles(world, files, file_count);
+    } else {
+        LoadProjectAsPhantoms(world, "./src");
+    }
+    ecs_progress(world, 1.0f / fps);
+    const WorldStats *world_stats = ecs_singleton_get(world, WorldStats);
+    const SyntaxStats *syntax = ecs_singleton_get(world, SyntaxStats);
+    const SymbolStats *symbols = ecs_singleton_get(world, SymbolStats);
+    printf("Loaded %d files, %d phantoms, %lld lines, %lld tokens, %d functions in %.1f ms\n",
+           syntax->files, world_stats->text_count, (long long)syntax->lines, (long long)syntax->tokens,
+           symbols->functions, (double)(ProfilerNow() - load_start) / 1e6);
+
+    if (!StartRemoteServer(world, listen_address)) {
+        ecs_fini(world);
+        free(files);
+        return 1;
+    }
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+
+    // Fixed time step; the time left in a frame serves the sockets
+    const double frame_ms = 1000.0 / fps;
+    uint64_t last_status = ProfilerNow();
+    uint32_t frame = 0;
+    while (!quit_requested && (frames == 0 || (int)frame < frames)) {
+        uint64_t start = ProfilerNow();
+        ecs_progress(world, 1.0f / fps);
+        frame++;
+
+        if ((double)(ProfilerNow() - last_status) >= SERVER_STATUS_INTERVAL_S * 1e9) {
+            PrintStatus(world, frame);
+            last_status = ProfilerNow();
+        }
+        RemoteServerWait(world, frame_ms - (double)(ProfilerNow() - start) / 1e6);
+    }
+    PrintStatus(world, frame);
+
+    if (memory_report_path) {
+        WriteMemoryReport(world, memory_report_path);
+    }
+    ecs_fini(world);
+    free(files);
+    return 0;
+}
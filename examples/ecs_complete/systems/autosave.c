@@ -0,0 +1,571 @@
+#define _POSIX_C_SOURCE 200809L  // fsync, mkdir
+#include "autosave.h"
+#include "impostor.h"
+#include "layout.h"
+#include "memory_tracker.h"
+#include "syntax.h"
+#include "text_buffer.h"
+#include "profiler.h"
+#include "../components/spatial.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <uv.h>
+
+ECS_COMPONENT_DECLARE(AutosaveSettings);
+ECS_COMPONENT_DECLARE(AutosaveStats);
+
+#define AUTOSAVE_MAGIC "PVAL"
+#define AUTOSAVE_BYTE_ORDER 0x01020304u
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t file_count;
+    uint64_t string_bytes;
+} LayoutHeader;
+
+typedef struct {
+    Position position;
+    float mass;
+    uint32_t path;            // Offset in the strings
+} LayoutRecord;
+
+typedef struct {
+    uint32_t path;            // Offset in the job's strings
+    TextSnapshot text;
+} AutosaveBuffer;
+
+// One save, captured on the main thread and written by a libuv worker.
+// Its arrays are kept from one save to the next.
+typedef struct {
+    uv_work_t request;
+    ecs_world_t *world;
+    char directory[AUTOSAVE_PATH_MAX];
+    LayoutRecord *files;
+    int file_count;           // 0 when the layout did not change
+    int file_capacity;
+    AutosaveBuffer *buffers;
+    int buffer_count;
+    int buffer_capacity;
+    char *strings;
+    int string_count;
+    int string_capacity;
+    uint64_t captured_ns;
+    uint64_t finished_ns;     // Set by the worker
+    uint64_t write_ns;
+    int64_t bytes;
+    bool failed;
+} AutosaveJob;
+
+// Edit count of a syntax slot's buffer at its last capture
+typedef struct {
+    ecs_entity_t file;
+    uint32_t edits;
+} AutosaveSlot;
+
+typedef struct {
+    uv_loop_t loop;
+    bool loop_ready;
+    AutosaveJob job;
+    bool pending;
+    uint64_t layout_hash;     // Of the last layout captured, 0 = none
+    AutosaveSlot *slots;
+    int slot_capacity;
+    uint64_t last_capture_ns;
+    ecs_query_t *layout_query;
+    ecs_query_t *buffer_query;
+} Autosave;
+
+// The saver belongs to the world that registered the module: the system
+// gets it as ctx, completions through their loop's data and API calls
+// through this singleton
+typedef struct {
+    Autosave *autosave;
+} AutosaveModule;
+
+static ECS_COMPONENT_DECLARE(AutosaveModule);
+
+static Autosave *GetAutosave(const ecs_world_t *world) {
+    const AutosaveModule *module = ecs_singleton_get(world, AutosaveModule);
+    return module ? module->autosave : NULL;
+}
+
+static uint64_t HashBytes(uint64_t hash, const void *data, size_t length) {
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static uint32_t AddString(AutosaveJob *job, const char *text) {
+    int length = (int)strlen(text) + 1;
+    if (!GrowArray(MEMORY_TAG_IO, (void**)&job->strings, &job->string_capacity, job->string_count + length, 1)) {
+        return UINT32_MAX;
+    }
+    uint32_t offset = (uint32_t)job->string_count;
+    memcpy(job->strings + offset, text, (size_t)length);
+    job->string_count += length;
+    return offset;
+}
+
+// <directory>/<file name>.<hash of the full path>.txt
+void AutosaveRecoveryPath(const char *directory, const char *path, char *out, size_t size) {
+    const char *name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    unsigned long long hash = (unsigned long long)HashBytes(0xcbf29ce484222325ull, path, strlen(path));
+    snprintf(out, size, "%s/%s.%016llx.txt", directory, name, hash);
+}
+
+// Writing (worker thread)
+
+static bool WriteAll(int fd, const void *data, size_t length) {
+    const char *bytes = data;
+    while (length > 0) {
+        ssize_t written = write(fd, bytes, length);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+// Write spans to path.tmp, fsync it and rename it over path
+static bool WriteDurable(const char *path, const TextSnapshotSpan *spans, int span_count) {
+    char temp_path[AUTOSAVE_PATH_MAX * 2 + 8];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        printf("Autosave: cannot write %s\n", temp_path);
+        return false;
+    }
+    bool written = true;
+    for (int i = 0; i < span_count && written; i++) {
+        written = WriteAll(fd, spans[i].bytes, spans[i].length);
+    }
+    written = fsync(fd) == 0 && written;
+    written = close(fd) == 0 && written;
+    if (!written || rename(temp_path, path) != 0) {
+        printf("Autosave: failed writing %s\n", path);
+        unlink(temp_path);
+        return false;
+    }
+    return true;
+}
+
+static bool WriteLayout(AutosaveJob *job) {
+    LayoutHeader header = {
+        .magic = {'P', 'V', 'A', 'L'},
+        .version = AUTOSAVE_VERSION,
+        .byte_order = AUTOSAVE_BYTE_ORDER,
+        .file_count = (uint32_t)job->file_count,
+        .string_bytes = (uint64_t)job->string_count
+    };
+    TextSnapshotSpan spans[3] = {
+        {(const char*)&header, sizeof(header)},
+        {(const char*)job->files, (uint32_t)(sizeof(LayoutRecord) * (size_t)job->file_count)},
+        {job->strings, (uint32_t)job->string_count}
+    };
+    char path[AUTOSAVE_PATH_MAX + 16];
+    snprintf(path, sizeof(path), "%s/layout.pval", job->directory);
+    job->bytes += (int64_t)(spans[0].length + spans[1].length + spans[2].length);
+    return WriteDurable(path, spans, 3);
+}
+
+static void AutosaveWork(uv_work_t *request) {
+    AutosaveJob *job = request->data;
+    uint64_t start = ProfilerNow();
+    bool ok = job->file_count == 0 || WriteLayout(job);
+    for (int i = 0; i < job->buffer_count; i++) {
+        AutosaveBuffer *buffer = &job->buffers[i];
+        char path[AUTOSAVE_PATH_MAX * 2];
+        AutosaveRecoveryPath(job->directory, job->strings + buffer->path, path, sizeof(path));
+        ok = WriteDurable(path, buffer->text.spans, buffer->text.span_count) && ok;
+        job->bytes += (int64_t)buffer->text.length;
+    }
+
+    // The renames are durable once the directory is
+    int fd = open(job->directory, O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+    job->failed = !ok;
+    job->finished_ns = ProfilerNow();
+    job->write_ns = job->finished_ns - start;
+}
+
+// Completion (main thread, from uv_run)
+
+// The next capture takes the whole layout and every edited buffer
+static void ForgetSaved(Autosave *autosave) {
+    autosave->layout_hash = 0;
+    memset(autosave->slots, 0, sizeof(AutosaveSlot) * (size_t)autosave->slot_capacity);
+}
+
+static void ReleaseJobBuffers(AutosaveJob *job) {
+    for (int i = 0; i < job->buffer_count; i++) {
+        TextSnapshotFree(&job->buffers[i].text);
+    }
+    job->buffer_count = 0;
+}
+
+static void AutosaveDone(uv_work_t *request, int status) {
+    Autosave *autosave = request->loop->data;
+    AutosaveJob *job = request->data;
+    bool failed = status != 0 || job->failed;
+    ReleaseJobBuffers(job);
+    autosave->pending = false;
+
+    // A failed save is captured again in full
+    if (failed) {
+        ForgetSaved(autosave);
+    }
+
+    AutosaveStats *stats = ecs_singleton_get_mut(job->world, AutosaveStats);
+    if (!stats) {
+        return;
+    }
+    stats->pending = false;
+    if (failed) {
+        stats->failures++;
+        return;
+    }
+    stats->saves++;
+    stats->bytes = job->bytes;
+    stats->bytes_total += job->bytes;
+    stats->write_ms = (double)job->write_ns / 1e6;
+    stats->latency_ms = (double)(job->finished_ns - job->captured_ns) / 1e6;
+    if (stats->latency_ms > stats->latency_max_ms) {
+        stats->latency_max_ms = stats->latency_ms;
+    }
+}
+
+// Capture (main thread)
+
+static bool CaptureLayout(ecs_world_t *world, Autosave *autosave, AutosaveJob *job) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    bool ok = true;
+    ecs_iter_t it = ecs_query_iter(world, autosave->layout_query);
+    while (ecs_query_next(&it)) {
+        const FileReference *refs = ecs_field(&it, FileReference, 1);
+        const Position *positions = ecs_field(&it, Position, 2);
+        const LayoutNode *nodes = ecs_field(&it, LayoutNode, 3);
+        if (!ok || !GrowArray(MEMORY_TAG_IO, (void**)&job->files, &job->file_capacity, job->file_count + it.count,
+                              sizeof(LayoutRecord))) {
+            ok = false;
+            continue;
+        }
+        for (int i = 0; i < it.count; i++) {
+            LayoutRecord *record = &job->files[job->file_count++];
+            record->position = positions[i];
+            record->mass = nodes[i].mass;
+            record->path = AddString(job, refs[i].filepath);
+            ok = ok && record->path != UINT32_MAX;
+            hash = HashBytes(hash, &it.entities[i], sizeof(ecs_entity_t));
+            hash = HashBytes(hash, &record->position, sizeof(Position) + sizeof(float));
+        }
+    }
+    // An unchanged layout is not written again
+    if (!ok || hash == autosave->layout_hash) {
+        job->file_count = 0;
+        job->string_count = 0;
+        return ok;
+    }
+    autosave->layout_hash = hash;
+    return true;
+}
+
+static bool CaptureBuffers(ecs_world_t *world, Autosave *autosave, AutosaveJob *job) {
+    bool ok = true;
+    ecs_iter_t it = ecs_query_iter(world, autosave->buffer_query);
+    while (ecs_query_next(&it)) {
+        const FileSyntax *syntax = ecs_field(&it, FileSyntax, 0);
+        const FileReference *refs = ecs_field(&it, FileReference, 1);
+        for (int i = 0; i < it.count && ok; i++) {
+            const TextBuffer *buffer = GetFileSyntaxBuffer(world, &syntax[i]);
+            int slot = syntax[i].slot;
+            if (!buffer || !GrowArray(MEMORY_TAG_IO, (void**)&autosave->slots, &autosave->slot_capacity, slot + 1,
+                                      sizeof(AutosaveSlot))) {
+                continue;
+            }
+            // Slots are reused: a slot last saved for another file is new
+            AutosaveSlot *saved = &autosave->slots[slot];
+            if (saved->file != it.entities[i]) {
+                *saved = (AutosaveSlot){it.entities[i], 0};
+            }
+            // A buffer loaded again from disk starts over at 0 edits
+            if (buffer->edits == saved->edits || buffer->edits == 0) {
+                saved->edits = buffer->edits;
+                continue;
+            }
+            ok = GrowArray(MEMORY_TAG_IO, (void**)&job->buffers, &job->buffer_capacity, job->buffer_count + 1,
+                           sizeof(AutosaveBuffer));
+            uint32_t path = ok ? AddString(job, refs[i].filepath) : UINT32_MAX;
+            if (path == UINT32_MAX || !TextBufferSnapshot(buffer, &job->buffers[job->buffer_count].text)) {
+                ok = false;
+                break;
+            }
+            job->buffers[job->buffer_count++].path = path;
+            saved->edits = buffer->edits;
+        }
+    }
+    return ok;
+}
+
+// Capture the changes since the last save and queue them for the worker.
+// Returns false if nothing changed.
+static bool CaptureAutosave(ecs_world_t *world, Autosave *autosave, const AutosaveSettings *settings,
+                            AutosaveStats *stats) {
+    PROFILE_ZONE_BEGIN(AutosaveCapture);
+    uint64_t start = ProfilerNow();
+    AutosaveJob *job = &autosave->job;
+    job->file_count = 0;
+    job->buffer_count = 0;
+    job->string_count = 0;
+    job->bytes = 0;
+    job->failed = false;
+
+    bool ok = CaptureLayout(world, autosave, job) && CaptureBuffers(world, autosave, job);
+    bool queued = false;
+    if (!ok) {
+        ReleaseJobBuffers(job);
+        ForgetSaved(autosave);
+        stats->failures++;
+    } else if (job->file_count > 0 || job->buffer_count > 0) {
+        job->world = world;
+        job->request.data = job;
+        job->captured_ns = ProfilerNow();
+        strncpy(job->directory, settings->directory, sizeof(job->directory) - 1);
+        job->directory[sizeof(job->directory) - 1] = '\0';
+        queued = uv_queue_work(&autosave->loop, &job->request, AutosaveWork, AutosaveDone) == 0;
+        if (!queued) {
+            ReleaseJobBuffers(job);
+            ForgetSaved(autosave);
+            stats->failures++;
+        }
+    }
+    autosave->pending = queued;
+    autosave->last_capture_ns = start;
+    stats->captures += queued ? 1 : 0;
+
+    stats->pending = queued;
+    stats->files = job->file_count;
+    stats->buffers = job->buffer_count;
+    stats->capture_ms = (double)(ProfilerNow() - start) / 1e6;
+    if (stats->capture_ms > stats->capture_max_ms) {
+        stats->capture_max_ms = stats->capture_ms;
+    }
+    PROFILE_ZONE_END(AutosaveCapture);
+    return queued;
+}
+
+bool SetAutosaveDirectory(ecs_world_t *world, const char *directory) {
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) {
+        printf("Autosave: cannot create %s\n", directory);
+        return false;
+    }
+    AutosaveSettings *settings = ecs_singleton_get_mut(world, AutosaveSettings);
+    strncpy(settings->directory, directory, sizeof(settings->directory) - 1);
+    settings->directory[sizeof(settings->directory) - 1] = '\0';
+    settings->enabled = true;
+    return true;
+}
+
+void FlushAutosave(ecs_world_t *world) {
+    Autosave *autosave = GetAutosave(world);
+    const AutosaveSettings *settings = ecs_singleton_get(world, AutosaveSettings);
+    AutosaveStats *stats = ecs_singleton_get_mut(world, AutosaveStats);
+    if (!autosave || !autosave->loop_ready || !settings || !stats) {
+        return;
+    }
+    // The save in flight may predate the last changes: finish it first
+    uv_run(&autosave->loop, UV_RUN_DEFAULT);
+    if (settings->enabled && CaptureAutosave(world, autosave, settings, stats)) {
+        uv_run(&autosave->loop, UV_RUN_DEFAULT);
+    }
+}
+
+// Restoring
+
+static const char *sort_strings;  // Strings of the records being sorted
+
+static int CompareRecords(const void *a, const void *b) {
+    return strcmp(sort_strings + ((const LayoutRecord*)a)->path, sort_strings + ((const LayoutRecord*)b)->path);
+}
+
+int RestoreAutosaveLayout(ecs_world_t *world, const char *directory) {
+    Autosave *autosave = GetAutosave(world);
+    if (!autosave) {
+        return -1;
+    }
+    char path[AUTOSAVE_PATH_MAX + 16];
+    snprintf(path, sizeof(path), "%s/layout.pval", directory);
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        return -1;
+    }
+    LayoutHeader header;
+    LayoutRecord *records = NULL;
+    char *strings = NULL;
+    bool ok = fread(&header, sizeof(header), 1, file) == 1 &&
+              memcmp(header.magic, AUTOSAVE_MAGIC, 4) == 0 && header.version == AUTOSAVE_VERSION &&
+              header.byte_order == AUTOSAVE_BYTE_ORDER && header.string_bytes > 0 &&
+              header.string_bytes < UINT32_MAX && header.file_count < UINT32_MAX / sizeof(LayoutRecord);
+    if (ok) {
+        records = TrackedMalloc(MEMORY_TAG_IO, sizeof(LayoutRecord) * (header.file_count > 0 ? header.file_count : 1));
+        strings = TrackedMalloc(MEMORY_TAG_IO, (size_t)header.string_bytes);
+        ok = records && strings &&
+             fread(records, sizeof(LayoutRecord), header.file_count, file) == header.file_count &&
+             fread(strings, 1, (size_t)header.string_bytes, file) == header.string_bytes &&
+             strings[header.string_bytes - 1] == '\0';
+    }
+    for (uint32_t i = 0; ok && i < header.file_count; i++) {
+        ok = records[i].path < header.string_bytes;
+    }
+    fclose(file);
+    if (!ok) {
+        printf("Autosave: %s is not a valid layout\n", path);
+        TrackedFree(MEMORY_TAG_IO, records);
+        TrackedFree(MEMORY_TAG_IO, strings);
+        return -1;
+    }
+
+    sort_strings = strings;
+    qsort(records, header.file_count, sizeof(LayoutRecord), CompareRecords);
+
+    int moved = 0;
+    ecs_iter_t it = ecs_query_iter(world, autosave->layout_query);
+    while (ecs_query_next(&it)) {
+        const FileReference *refs = ecs_field(&it, FileReference, 1);
+        const Position *positions = ecs_field(&it, Position, 2);
+        for (int i = 0; i < it.count; i++) {
+            // Binary search by path
+            int low = 0;
+            int high = (int)header.file_count;
+            while (low < high) {
+                int mid = low + (high - low) / 2;
+                int order = strcmp(strings + records[mid].path, refs[i].filepath);
+                if (order == 0) {
+                    low = high = mid;
+                } else if (order < 0) {
+                    low = mid + 1;
+                } else {
+                    high = mid;
+                }
+            }
+            if (low < (int)header.file_count && strcmp(strings + records[low].path, refs[i].filepath) == 0) {
+                const Position *to = &records[low].position;
+                LayoutTranslateNode(world, it.entities[i], to->x - positions[i].x, to->y - positions[i].y,
+                                    to->z - positions[i].z);
+                moved++;
+            }
+        }
+    }
+    printf("Autosave: restored the layout of %d of %u files from %s\n", moved, header.file_count, path);
+    TrackedFree(MEMORY_TAG_IO, records);
+    TrackedFree(MEMORY_TAG_IO, strings);
+    return moved;
+}
+
+// Saves are captured at the end of the frame, once the layout and edits
+// of the frame are done
+void AutosaveSystem(ecs_iter_t *it) {
+    Autosave *autosave = it->ctx;
+    if (!autosave->loop_ready) {
+        return;
+    }
+    // Completions run here, on the main thread
+    if (autosave->pending) {
+        uv_run(&autosave->loop, UV_RUN_NOWAIT);
+    }
+    const AutosaveSettings *settings = ecs_singleton_get(it->world, AutosaveSettings);
+    if (!settings || !settings->enabled) {
+        return;
+    }
+    if ((double)(ProfilerNow() - autosave->last_capture_ns) < (double)settings->interval_s * 1e9) {
+        return;
+    }
+    AutosaveStats *stats = ecs_singleton_get_mut(it->world, AutosaveStats);
+    if (autosave->pending) {
+        stats->deferred++;
+        return;
+    }
+    CaptureAutosave(it->world, autosave, settings, stats);
+}
+
+static void AutosaveFini(ecs_world_t *world, void *ctx) {
+    (void)world;
+    Autosave *autosave = ctx;
+    if (autosave->loop_ready) {
+        uv_run(&autosave->loop, UV_RUN_DEFAULT);
+        uv_loop_close(&autosave->loop);
+    }
+    ReleaseJobBuffers(&autosave->job);
+    TrackedFree(MEMORY_TAG_IO, autosave->job.files);
+    TrackedFree(MEMORY_TAG_IO, autosave->job.buffers);
+    TrackedFree(MEMORY_TAG_IO, autosave->job.strings);
+    TrackedFree(MEMORY_TAG_IO, autosave->slots);
+    TrackedFree(MEMORY_TAG_IO, autosave);
+}
+
+void RegisterAutosave(ecs_world_t *world) {
+    ECS_COMPONENT_DEFINE(world, AutosaveSettings);
+    ECS_COMPONENT_DEFINE(world, AutosaveStats);
+    ECS_COMPONENT_DEFINE(world, AutosaveModule);
+
+    ecs_singleton_set(world, AutosaveSettings, {
+        .enabled = false,
+        .interval_s = 2.0f
+    });
+    ecs_singleton_set(world, AutosaveStats, {0});
+
+    Autosave *autosave = TrackedCalloc(MEMORY_TAG_IO, 1, sizeof(Autosave));
+    if (!autosave) {
+        printf("Autosave: out of memory\n");
+        return;
+    }
+    autosave->loop_ready = uv_loop_init(&autosave->loop) == 0;
+    if (!autosave->loop_ready) {
+        printf("Autosave: cannot start the libuv loop, autosave is off\n");
+    }
+    autosave->loop.data = autosave;
+    autosave->layout_query = ecs_query(world, {
+        .terms = {
+            { ecs_id(FileImpostor), .inout = EcsInOutNone },
+            { ecs_id(FileReference), .inout = EcsIn },
+            { ecs_id(Position), .inout = EcsIn },
+            { ecs_id(LayoutNode), .inout = EcsIn }
+        },
+        .cache_kind = EcsQueryCacheAuto
+    });
+    autosave->buffer_query = ecs_query(world, {
+        .terms = {
+            { ecs_id(FileSyntax), .inout = EcsIn },
+            { ecs_id(FileReference), .inout = EcsIn }
+        },
+        .cache_kind = EcsQueryCacheAuto
+    });
+    ecs_singleton_set(world, AutosaveModule, {autosave});
+    ecs_atfini(world, AutosaveFini, autosave);
+
+    ecs_system(world, {
+        .entity = ecs_entity(world, {
+            .name = "AutosaveSystem",
+            .add = ecs_ids(ecs_dependson(EcsOnStore))
+        }),
+        .callback = AutosaveSystem,
+        .ctx = autosave
+    });
+}
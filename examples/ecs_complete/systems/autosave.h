@@ -0,0 +1,75 @@
+#ifndef AUTOSAVE_H
+#define AUTOSAVE_H
+
+#include <flecs.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Background autosave of the layout and of edited buffers.
+//
+// At the end of a frame the system captures what changed: the position
+// and mass of every file container (a few bytes each, compared against the
+// last save) and a snapshot of each buffer edited since its last save. A
+// buffer snapshot copies the piece list and holds the buffer's bytes (see
+// TextBufferSnapshot), so no text is copied on the main thread. A libuv
+// worker writes each file to a temporary name, fsyncs it and renames it
+// over the last save; the directory is fsynced after the renames. One save
+// is in flight at a time: changes made meanwhile go into the next one.
+//
+// Files in the autosave directory:
+//     layout.pval        header, file records (position, mass, path offset),
+//                        NUL-terminated paths
+//     <name>.<hash>.txt  text of an edited file (hash of its full path)
+// Layouts are restored with RestoreAutosaveLayout; a recovered text is the
+// edited file as it was, to be copied back by hand.
+
+#define AUTOSAVE_VERSION 1
+#define AUTOSAVE_PATH_MAX 512
+
+typedef struct {
+    bool enabled;             // Set by SetAutosaveDirectory
+    float interval_s;         // Least time between two captures (0 = every frame)
+    char directory[AUTOSAVE_PATH_MAX];
+} AutosaveSettings;
+
+typedef struct {
+    int32_t captures;         // Saves queued
+    int32_t saves;            // Completed
+    int32_t failures;
+    int32_t deferred;         // Captures put off while a save was being written
+    int32_t files;            // Layout records in the last save, 0 if unchanged
+    int32_t buffers;          // Edited buffers in the last save
+    int64_t bytes;            // Written by the last save
+    int64_t bytes_total;
+    double capture_ms;        // Main thread: last capture
+    double capture_max_ms;
+    double write_ms;          // Worker: last serialize, write, fsync and rename
+    double latency_ms;        // Capture to the last rename of a save
+    double latency_max_ms;
+    bool pending;             // A save is being written
+} AutosaveStats;
+
+extern ECS_COMPONENT_DECLARE(AutosaveSettings);
+extern ECS_COMPONENT_DECLARE(AutosaveStats);
+
+// Save into directory (created if missing) from now on. Returns false if it
+// cannot be created.
+bool SetAutosaveDirectory(ecs_world_t *world, const char *directory);
+
+// Capture now whatever the interval, and block until every save is written
+void FlushAutosave(ecs_world_t *world);
+
+// Where the edited text of path is saved in directory
+void AutosaveRecoveryPath(const char *directory, const char *path, char *out, size_t size);
+
+// Move file containers to their positions in the autosaved layout of
+// directory. Returns the number of containers moved, -1 if there is no
+// valid layout file.
+int RestoreAutosaveLayout(ecs_world_t *world, const char *directory);
+
+// Systems
+void AutosaveSystem(ecs_iter_t *it);
+
+void RegisterAutosave(ecs_world_t *world);
+
+#endif // AUTOSAVE_H
@@ -0,0 +1,656 @@
+#include "collision.h"
+#include "impostor.h"
+#include "layout.h"
+#include "memory_tracker.h"
+#include "profiler.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef PEVI_WITH_JOLT
+#include <joltc.h>
+#endif
+
+ECS_COMPONENT_DECLARE(CollisionPanel);
+ECS_COMPONENT_DECLARE(CollisionSettings);
+ECS_COMPONENT_DECLARE(CollisionStats);
+
+#define COLLISION_MOVE_EPSILON 1e-3f     // Smaller moves do not re-check a panel
+#define COLLISION_SLACK 0.25f            // Extra separation, relative to the padding
+#define COLLISION_EXTENT_EPSILON 0.05f   // Relative size change that rebuilds a body
+#define COLLISION_NO_BODY 0xffffffffu    // Same bit pattern as Jolt's invalid BodyID
+#define COLLISION_BODY_INDEX_MASK 0x007fffffu  // BodyID bits holding the body index
+
+// Panel boxes live outside the ECS as flat arrays. Slots are dense; removal
+// swaps the last slot into the hole.
+typedef struct {
+    int count;
+    int capacity;
+    ecs_entity_t *entities;
+    float *cx, *cy, *cz;          // Box centers
+    float *hx, *hy, *hz;          // Half extents
+    float *tx, *ty;               // Total push of the current frame
+    uint32_t *bodies;             // Jolt body IDs, COLLISION_NO_BODY until inserted
+    uint8_t *queued;              // Slot is in the current check queue
+    uint8_t *touched;             // Slot is in the next pass's queue
+    uint8_t *pushed;              // Slot is in the moved list
+
+    int32_t *queue;               // Slots to check against their neighbors
+    int queue_count;
+    int32_t *next_queue;
+    int next_count;
+    int32_t *moved;               // Slots pushed this frame, written back once
+    int moved_count;
+
+    int32_t *pending;             // Slots waiting for batch insertion
+    int pending_count;
+    int pending_capacity;
+
+    int32_t *candidates;          // Broadphase hits of one query
+    int candidate_count;
+    int candidate_capacity;
+
+    int32_t *body_slots;          // Body index -> slot, sized to max_bodies
+    int max_bodies;
+
+#ifdef PEVI_WITH_JOLT
+    JPH_PhysicsSystem *system;
+    JPH_BodyInterface *body_interface;
+    const JPH_BroadPhaseQuery *query;
+    JPH_BroadPhaseLayerFilter *layer_filters[COLLISION_LAYER_COUNT];
+#endif
+} CollisionWorld;
+
+// The panel world belongs to the world that registered the module: the
+// system and observer get it as ctx, API calls find it through this singleton
+typedef struct {
+    CollisionWorld *collision;
+} CollisionModule;
+
+static ECS_COMPONENT_DECLARE(CollisionModule);
+
+static CollisionWorld *GetCollision(const ecs_world_t *world) {
+    const CollisionModule *module = ecs_singleton_get(world, CollisionModule);
+    return module ? module->collision : NULL;
+}
+
+static bool ReserveSlots(CollisionWorld *c, int count) {
+    if (count <= c->capacity) {
+        return true;
+    }
+    int capacity = c->capacity;
+    float **float_arrays[] = {&c->cx, &c->cy, &c->cz, &c->hx, &c->hy, &c->hz, &c->tx, &c->ty};
+    for (size_t a = 0; a < sizeof(float_arrays) / sizeof(float_arrays[0]); a++) {
+        int tmp = capacity;
+        if (!GrowArray(MEMORY_TAG_PHYSICS, (void**)float_arrays[a], &tmp, count, sizeof(float))) {
+            return false;
+        }
+    }
+    int32_t **int_arrays[] = {&c->queue, &c->next_queue, &c->moved};
+    for (size_t a = 0; a < sizeof(int_arrays) / sizeof(int_arrays[0]); a++) {
+        int tmp = capacity;
+        if (!GrowArray(MEMORY_TAG_PHYSICS, (void**)int_arrays[a], &tmp, count, sizeof(int32_t))) {
+            return false;
+        }
+    }
+    uint8_t **flag_arrays[] = {&c->queued, &c->touched, &c->pushed};
+    for (size_t a = 0; a < sizeof(flag_arrays) / sizeof(flag_arrays[0]); a++) {
+        int tmp = capacity;
+        if (!GrowArray(MEMORY_TAG_PHYSICS, (void**)flag_arrays[a], &tmp, count, sizeof(uint8_t))) {
+            return false;
+        }
+    }
+    int tmp = capacity;
+    if (!GrowArray(MEMORY_TAG_PHYSICS, (void**)&c->bodies, &tmp, count, sizeof(uint32_t))) {
+        return false;
+    }
+    tmp = capacity;
+    if (!GrowArray(MEMORY_TAG_PHYSICS, (void**)&c->entities, &tmp, count, sizeof(ecs_entity_t))) {
+        return false;
+    }
+    c->capacity = tmp;
+    return true;
+}
+
+// Adds a slot to the check queue of the current pass
+static void QueueSlot(CollisionWorld *c, int32_t slot) {
+    if (!c->queued[slot]) {
+        c->queued[slot] = 1;
+        c->queue[c->queue_count++] = slot;
+    }
+}
+
+static void PushPending(CollisionWorld *c, int32_t slot) {
+    if (GrowArray(MEMORY_TAG_PHYSICS, (void**)&c->pending, &c->pending_capacity, c->pending_count + 1,
+                  sizeof(int32_t))) {
+        c->pending[c->pending_count++] = slot;
+    }
+}
+
+#ifdef PEVI_WITH_JOLT
+
+// Broadphase layer filters restrict a query to the tree of one object layer.
+// joltc keeps one set of filter procs per process; each filter only carries
+// its layer as user data.
+static bool ShouldCollideLayer(void *user_data, JPH_BroadPhaseLayer layer) {
+    return layer == (JPH_BroadPhaseLayer)(uintptr_t)user_data;
+}
+
+static const JPH_BroadPhaseLayerFilter_Procs layer_filter_procs = {
+    .ShouldCollide = ShouldCollideLayer
+};
+
+static bool CreateCollisionWorld(CollisionWorld *c, int max_bodies) {
+    if (!JPH_Init()) {
+        printf("Failed to initialize Jolt\n");
+        return false;
+    }
+
+    // The pair table starts with every pair disabled: bodies never generate
+    // contacts through the simulation, overlaps come from broadphase queries.
+    // Each object layer gets its own broadphase tree.
+    JPH_ObjectLayerPairFilter *pair_filter = JPH_ObjectLayerPairFilterTable_Create(COLLISION_LAYER_COUNT);
+    JPH_BroadPhaseLayerInterface *layer_interface = JPH_BroadPhaseLayerInterfaceTable_Create(
+        COLLISION_LAYER_COUNT, COLLISION_LAYER_COUNT);
+    JPH_BroadPhaseLayerFilter_SetProcs(&layer_filter_procs);
+    for (uint32_t layer = 0; layer < COLLISION_LAYER_COUNT; layer++) {
+        JPH_BroadPhaseLayerInterfaceTable_MapObjectToBroadPhaseLayer(layer_interface, layer, (JPH_BroadPhaseLayer)layer);
+        c->layer_filters[layer] = JPH_BroadPhaseLayerFilter_Create((void*)(uintptr_t)layer);
+    }
+    JPH_ObjectVsBroadPhaseLayerFilter *layer_filter = JPH_ObjectVsBroadPhaseLayerFilterTable_Create(
+        layer_interface, COLLISION_LAYER_COUNT, pair_filter, COLLISION_LAYER_COUNT);
+
+    JPH_PhysicsSystemSettings settings = {0};
+    settings.maxBodies = (uint32_t)max_bodies;
+    settings.numBodyMutexes = 0;
+    settings.maxBodyPairs = 65536;
+    settings.maxContactConstraints = 65536;
+    settings.broadPhaseLayerInterface = layer_interface;
+    settings.objectLayerPairFilter = pair_filter;
+    settings.objectVsBroadPhaseLayerFilter = layer_filter;
+    c->system = JPH_PhysicsSystem_Create(&settings);
+    if (!c->system) {
+        printf("Failed to create Jolt physics system\n");
+        JPH_Shutdown();
+        return false;
+    }
+    c->body_interface = JPH_PhysicsSystem_GetBodyInterface(c->system);
+    c->query = JPH_PhysicsSystem_GetBroadPhaseQuery(c->system);
+
+    c->body_slots = TrackedMalloc(MEMORY_TAG_PHYSICS, sizeof(int32_t) * max_bodies);
+    if (!c->body_slots) {
+        printf("Collision: out of memory for %d bodies\n", max_bodies);
+        return false;
+    }
+    c->max_bodies = max_bodies;
+    return true;
+}
+
+static void DestroyBody(CollisionWorld *c, int32_t slot) {
+    if (c->bodies[slot] != COLLISION_NO_BODY) {
+        JPH_BodyInterface_RemoveAndDestroyBody(c->body_interface, c->bodies[slot]);
+        c->bodies[slot] = COLLISION_NO_BODY;
+    }
+}
+
+static void MoveBody(CollisionWorld *c, int32_t slot) {
+    if (c->bodies[slot] != COLLISION_NO_BODY) {
+        JPH_RVec3 position = {c->cx[slot], c->cy[slot], c->cz[slot]};
+        JPH_BodyInterface_SetPosition(c->body_interface, c->bodies[slot], &position, JPH_Activation_DontActivate);
+    }
+}
+
+// Creates all pending bodies first and then adds them in one sweep, so the
+// broadphase is rebuilt once per batch rather than degraded by one-at-a-time
+// insertion interleaved with queries
+static void InsertPending(CollisionWorld *c, const CollisionSettings *settings, CollisionStats *stats) {
+    if (c->pending_count == 0) {
+        return;
+    }
+    uint64_t start = ProfilerNow();
+
+    int created = 0;
+    for (int k = 0; k < c->pending_count; k++) {
+        int32_t slot = c->pending[k];
+        // Convex radius 0: panels can be thinner than Jolt's default radius
+        JPH_Vec3 half_extent = {c->hx[slot], c->hy[slot], c->hz[slot]};
+        JPH_BoxShape *shape = JPH_BoxShape_Create(&half_extent, 0.0f);
+        JPH_RVec3 position = {c->cx[slot], c->cy[slot], c->cz[slot]};
+        JPH_BodyCreationSettings *body_settings = JPH_BodyCreationSettings_Create3(
+            (const JPH_Shape*)shape, &position, NULL, JPH_MotionType_Static, COLLISION_LAYER_PANELS);
+        JPH_Body *body = JPH_BodyInterface_CreateBody(c->body_interface, body_settings);
+        JPH_BodyCreationSettings_Destroy(body_settings);
+        JPH_Shape_Destroy((JPH_Shape*)shape);  // The body holds its own reference
+        if (!body) {
+            printf("Collision: body limit reached (%d panels)\n", c->count);
+            break;
+        }
+
+        JPH_BodyID id = JPH_Body_GetID(body);
+        c->bodies[slot] = id;
+        c->body_slots[id & COLLISION_BODY_INDEX_MASK] = slot;
+        c->pending[created++] = slot;
+    }
+
+    for (int k = 0; k < created; k++) {
+        JPH_BodyInterface_AddBody(c->body_interface, c->bodies[c->pending[k]], JPH_Activation_DontActivate);
+        QueueSlot(c, c->pending[k]);
+    }
+    if (created >= settings->optimize_batch) {
+        JPH_PhysicsSystem_OptimizeBroadPhase(c->system);
+    }
+
+    stats->inserted_frame = created;
+    stats->batches++;
+    stats->insert_ms = (ProfilerNow() - start) / 1e6;
+    c->pending_count = 0;
+}
+
+static float CollectCandidate(void *context, const JPH_BodyID body) {
+    CollisionWorld *c = context;
+    if (GrowArray(MEMORY_TAG_PHYSICS, (void**)&c->candidates, &c->candidate_capacity, c->candidate_count + 1,
+                  sizeof(int32_t))) {
+        c->candidates[c->candidate_count++] = c->body_slots[body & COLLISION_BODY_INDEX_MASK];
+    }
+    return FLT_MAX;  // Keep collecting
+}
+
+static void QueryOverlaps(CollisionWorld *c, int32_t slot, float padding) {
+    JPH_AABox box = {
+        .min = {c->cx[slot] - c->hx[slot] - padding, c->cy[slot] - c->hy[slot] - padding, c->cz[slot] - c->hz[slot]},
+        .max = {c->cx[slot] + c->hx[slot] + padding, c->cy[slot] + c->hy[slot] + padding, c->cz[slot] + c->hz[slot]}
+    };
+    c->candidate_count = 0;
+    JPH_BroadPhaseQuery_CollideAABox(c->query, &box, CollectCandidate, c,
+                                     c->layer_filters[COLLISION_LAYER_PANELS], NULL);
+}
+
+#else
+
+static bool CreateCollisionWorld(CollisionWorld *c, int max_bodies) {
+    (void)c;
+    (void)max_bodies;
+    printf("Collision resolution disabled (built without Jolt)\n");
+    return false;
+}
+
+static void DestroyBody(CollisionWorld *c, int32_t slot) {
+    c->bodies[slot] = COLLISION_NO_BODY;
+}
+
+static void MoveBody(CollisionWorld *c, int32_t slot) {
+    (void)c;
+    (void)slot;
+}
+
+static void InsertPending(CollisionWorld *c, const CollisionSettings *settings, CollisionStats *stats) {
+    (void)settings;
+    (void)stats;
+    c->pending_count = 0;
+}
+
+static void QueryOverlaps(CollisionWorld *c, int32_t slot, float padding) {
+    (void)slot;
+    (void)padding;
+    c->candidate_count = 0;
+}
+
+#endif
+
+bool CollisionAvailable(void) {
+#ifdef PEVI_WITH_JOLT
+    return true;
+#else
+    return false;
+#endif
+}
+
+#ifdef PEVI_WITH_JOLT
+JPH_PhysicsSystem *CollisionPhysicsSystem(const ecs_world_t *world) {
+    const CollisionWorld *c = GetCollision(world);
+    return c ? c->system : NULL;
+}
+
+JPH_BroadPhaseLayerFilter *CollisionLayerFilter(const ecs_world_t *world, JPH_ObjectLayer layer) {
+    const CollisionWorld *c = GetCollision(world);
+    return c && layer < COLLISION_LAYER_COUNT ? c->layer_filters[layer] : NULL;
+}
+#endif
+
+// Brings a panel's slot in line with the ECS: allocates new slots, follows
+// moves and rebuilds bodies whose size changed
+static void SyncPanel(CollisionWorld *c, ecs_entity_t entity, CollisionPanel *panel,
+                      const Position *position, const FileImpostor *impostor) {
+    // File blocks take their box from the impostor bounds whenever those are
+    // fresh; in between, the box follows Position with the last known offset
+    if (impostor && !impostor->bounds_dirty) {
+        panel->half_extents.x = impostor->extent.x * 0.5f;
+        panel->half_extents.y = impostor->extent.y * 0.5f;
+        panel->offset = (Vector3){impostor->center.x - position->x,
+                                  impostor->center.y - position->y,
+                                  impostor->center.z - position->z};
+    }
+    Vector3 half = panel->half_extents;
+    Vector3 center = {position->x + panel->offset.x,
+                      position->y + panel->offset.y,
+                      position->z + panel->offset.z};
+
+    if (panel->slot < 0) {
+        if (!ReserveSlots(c, c->count + 1)) {
+            return;
+        }
+        int32_t slot = c->count++;
+        c->entities[slot] = entity;
+        c->cx[slot] = center.x;
+        c->cy[slot] = center.y;
+        c->cz[slot] = center.z;
+        c->hx[slot] = half.x;
+        c->hy[slot] = half.y;
+        c->hz[slot] = half.z;
+        c->tx[slot] = 0.0f;
+        c->ty[slot] = 0.0f;
+        c->bodies[slot] = COLLISION_NO_BODY;
+        c->queued[slot] = 0;
+        c->touched[slot] = 0;
+        c->pushed[slot] = 0;
+        panel->slot = slot;
+        PushPending(c, slot);
+        return;
+    }
+
+    int32_t slot = panel->slot;
+    bool resized = fabsf(half.x - c->hx[slot]) > c->hx[slot] * COLLISION_EXTENT_EPSILON ||
+                   fabsf(half.y - c->hy[slot]) > c->hy[slot] * COLLISION_EXTENT_EPSILON;
+    bool moved = fabsf(center.x - c->cx[slot]) > COLLISION_MOVE_EPSILON ||
+                 fabsf(center.y - c->cy[slot]) > COLLISION_MOVE_EPSILON ||
+                 fabsf(center.z - c->cz[slot]) > COLLISION_MOVE_EPSILON;
+    if (!resized && !moved) {
+        return;
+    }
+
+    c->cx[slot] = center.x;
+    c->cy[slot] = center.y;
+    c->cz[slot] = center.z;
+    if (resized) {
+        // Jolt shapes are immutable: the body is re-inserted with the next batch
+        c->hx[slot] = half.x;
+        c->hy[slot] = half.y;
+        DestroyBody(c, slot);
+        PushPending(c, slot);
+    } else {
+        MoveBody(c, slot);
+        QueueSlot(c, slot);
+    }
+}
+
+// Moves a slot by a push and queues it for the next pass
+static void PushSlot(CollisionWorld *c, int32_t slot, float dx, float dy) {
+    if (!c->pushed[slot]) {
+        c->pushed[slot] = 1;
+        c->moved[c->moved_count++] = slot;
+    }
+    c->cx[slot] += dx;
+    c->cy[slot] += dy;
+    c->tx[slot] += dx;
+    c->ty[slot] += dy;
+    MoveBody(c, slot);
+
+    if (!c->touched[slot]) {
+        c->touched[slot] = 1;
+        c->next_queue[c->next_count++] = slot;
+    }
+}
+
+// Pushes overlapping panels apart along the shallower in-plane axis.
+// Pushes apply immediately (Gauss-Seidel), so later checks in the same pass
+// see them; this settles crowded regions far faster than accumulating.
+// Panels pushed in a pass are checked again in the next one, and unfinished
+// work carries over to the next frame.
+static void ResolveOverlaps(CollisionWorld *c, const CollisionSettings *settings, CollisionStats *stats) {
+    float padding = settings->padding;
+    float slack = padding * COLLISION_SLACK;
+
+    for (int pass = 0; pass < settings->max_passes && c->queue_count > 0; pass++) {
+        c->next_count = 0;
+        for (int q = 0; q < c->queue_count; q++) {
+            int32_t i = c->queue[q];
+            QueryOverlaps(c, i, padding);
+            stats->queries_frame++;
+
+            for (int k = 0; k < c->candidate_count; k++) {
+                int32_t j = c->candidates[k];
+                if (j == i) {
+                    continue;
+                }
+
+                float dx = c->cx[j] - c->cx[i];
+                float dy = c->cy[j] - c->cy[i];
+                float depth_x = c->hx[i] + c->hx[j] + padding - fabsf(dx);
+                float depth_y = c->hy[i] + c->hy[j] + padding - fabsf(dy);
+                float depth_z = c->hz[i] + c->hz[j] - fabsf(c->cz[j] - c->cz[i]);
+                if (depth_x <= slack || depth_y <= slack || depth_z <= 0.0f) {
+                    continue;
+                }
+                stats->overlaps_frame++;
+
+                // Each panel takes half the depth plus some slack, so resting
+                // neighbors are not re-detected; coincident panels separate
+                // by slot order, which is deterministic
+                if (depth_x * (c->hy[i] + c->hy[j]) < depth_y * (c->hx[i] + c->hx[j])) {
+                    float push = (dx > 0.0f || (dx == 0.0f && i < j) ? -0.5f : 0.5f) * (depth_x + slack);
+                    PushSlot(c, i, push, 0.0f);
+                    PushSlot(c, j, -push, 0.0f);
+                } else {
+                    float push = (dy > 0.0f || (dy == 0.0f && i < j) ? -0.5f : 0.5f) * (depth_y + slack);
+                    PushSlot(c, i, 0.0f, push);
+                    PushSlot(c, j, 0.0f, -push);
+                }
+            }
+        }
+
+        for (int q = 0; q < c->queue_count; q++) {
+            c->queued[c->queue[q]] = 0;
+        }
+        int32_t *swap = c->queue;
+        c->queue = c->next_queue;
+        c->next_queue = swap;
+        c->queue_count = c->next_count;
+        for (int q = 0; q < c->queue_count; q++) {
+            c->queued[c->queue[q]] = 1;
+            c->touched[c->queue[q]] = 0;
+        }
+        stats->passes_frame++;
+    }
+}
+
+// Moves pushed panels (and their children) in the ECS once per frame
+static int WriteBack(ecs_world_t *world, CollisionWorld *c) {
+    int moved = 0;
+    for (int k = 0; k < c->moved_count; k++) {
+        int32_t slot = c->moved[k];
+        if (c->tx[slot] != 0.0f || c->ty[slot] != 0.0f) {
+            LayoutTranslateNode(world, c->entities[slot], c->tx[slot], c->ty[slot], 0.0f);
+            moved++;
+        }
+        c->tx[slot] = 0.0f;
+        c->ty[slot] = 0.0f;
+        c->pushed[slot] = 0;
+    }
+    c->moved_count = 0;
+    return moved;
+}
+
+// Syncs panels from the ECS, inserts new ones as one batch and resolves
+// overlaps. Runs as a custom run callback so the batch and the resolution
+// happen once after all tables were visited.
+void CollisionSystem(ecs_iter_t *it) {
+    CollisionWorld *c = it->ctx;
+    const CollisionSettings *settings = ecs_singleton_get(it->world, CollisionSettings);
+    CollisionStats *stats = ecs_singleton_get_mut(it->world, CollisionStats);
+    if (!settings || !settings->enabled || !stats || !c->body_slots) {
+        ecs_iter_fini(it);
+        return;
+    }
+
+    PROFILE_ZONE_BEGIN(CollisionSystem);
+    uint64_t start = ProfilerNow();
+    stats->inserted_frame = 0;
+    stats->queries_frame = 0;
+    stats->overlaps_frame = 0;
+    stats->passes_frame = 0;
+
+    while (ecs_iter_next(it)) {
+        CollisionPanel *panels = ecs_field(it, CollisionPanel, 0);
+        const Position *positions = ecs_field(it, Position, 1);
+        const FileImpostor *impostors = ecs_field(it, FileImpostor, 2);  // Optional
+
+        for (int i = 0; i < it->count; i++) {
+            SyncPanel(c, it->entities[i], &panels[i], &positions[i], impostors ? &impostors[i] : NULL);
+        }
+    }
+
+    InsertPending(c, settings, stats);
+    ResolveOverlaps(c, settings, stats);
+    stats->moved_frame = WriteBack(it->world, c);
+
+    stats->panels = c->count;
+    stats->resolved = c->queue_count == 0;
+    stats->frame_ms = (ProfilerNow() - start) / 1e6;
+    PROFILE_ZONE_END(CollisionSystem);
+}
+
+// Frees the panel's body and moves the last slot into the hole
+void OnCollisionPanelRemoved(ecs_iter_t *it) {
+    CollisionWorld *c = it->ctx;
+    CollisionPanel *panels = ecs_field(it, CollisionPanel, 0);
+    if (!c->body_slots) {
+        return;
+    }
+
+    for (int i = 0; i < it->count; i++) {
+        int32_t slot = panels[i].slot;
+        if (slot < 0 || slot >= c->count || c->entities[slot] != it->entities[i]) {
+            continue;
+        }
+        DestroyBody(c, slot);
+
+        int32_t last = --c->count;
+        if (slot != last) {
+            c->entities[slot] = c->entities[last];
+            c->cx[slot] = c->cx[last];
+            c->cy[slot] = c->cy[last];
+            c->cz[slot] = c->cz[last];
+            c->hx[slot] = c->hx[last];
+            c->hy[slot] = c->hy[last];
+            c->hz[slot] = c->hz[last];
+            c->bodies[slot] = c->bodies[last];
+            if (c->bodies[slot] != COLLISION_NO_BODY) {
+                c->body_slots[c->bodies[slot] & COLLISION_BODY_INDEX_MASK] = slot;
+            }
+            CollisionPanel *moved = ecs_get_mut(it->world, c->entities[slot], CollisionPanel);
+            if (moved) {
+                moved->slot = slot;
+            }
+        }
+
+    }
+
+    // Work left over from the last frame may name a moved slot; the panels
+    // are checked again the next time they move
+    c->queue_count = 0;
+    memset(c->queued, 0, c->capacity);
+}
+
+static void CollisionFini(ecs_world_t *world, void *ctx) {
+    (void)world;
+    CollisionWorld *c = ctx;
+#ifdef PEVI_WITH_JOLT
+    if (c->system) {
+        JPH_PhysicsSystem_Destroy(c->system);  // Destroys remaining bodies
+        for (int layer = 0; layer < COLLISION_LAYER_COUNT; layer++) {
+            JPH_BroadPhaseLayerFilter_Destroy(c->layer_filters[layer]);
+        }
+        JPH_Shutdown();
+    }
+#endif
+    TrackedFree(MEMORY_TAG_PHYSICS, c->entities);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->cx);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->cy);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->cz);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->hx);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->hy);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->hz);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->tx);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->ty);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->bodies);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->queued);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->touched);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->pushed);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->queue);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->next_queue);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->moved);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->pending);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->candidates);
+    TrackedFree(MEMORY_TAG_PHYSICS, c->body_slots);
+    TrackedFree(MEMORY_TAG_PHYSICS, c);
+}
+
+void AttachCollisionPanel(ecs_world_t *world, ecs_entity_t entity, Vector3 half_extents) {
+    ecs_set(world, entity, CollisionPanel, {
+        .half_extents = half_extents,
+        .offset = {0.0f, 0.0f, 0.0f},
+        .slot = -1
+    });
+}
+
+void RegisterCollisionSystems(ecs_world_t *world) {
+    ECS_COMPONENT_DEFINE(world, CollisionPanel);
+    ECS_COMPONENT_DEFINE(world, CollisionSettings);
+    ECS_COMPONENT_DEFINE(world, CollisionStats);
+    ECS_COMPONENT_DEFINE(world, CollisionModule);
+
+    ecs_singleton_set(world, CollisionSettings, {
+        .enabled = true,
+        .padding = 0.5f,
+        .max_passes = 4,
+        .optimize_batch = 64,
+        .max_bodies = 131072
+    });
+    ecs_singleton_set(world, CollisionStats, {0});
+
+    const CollisionSettings *settings = ecs_singleton_get(world, CollisionSettings);
+    CollisionWorld *c = TrackedCalloc(MEMORY_TAG_PHYSICS, 1, sizeof(CollisionWorld));
+    if (!c) {
+        printf("Collision: out of memory\n");
+        return;
+    }
+    ecs_singleton_set(world, CollisionModule, {c});
+    ecs_atfini(world, CollisionFini, c);  // Also frees a partially created world
+    if (!CreateCollisionWorld(c, settings->max_bodies)) {
+        return;
+    }
+
+    // Registered after the layout so resolution sees this frame's positions
+    // and still runs before TransformSystem
+    ecs_system(world, {
+        .entity = ecs_entity(world, {
+            .name = "CollisionSystem",
+            .add = ecs_ids(ecs_dependson(EcsPreUpdate))
+        }),
+        .query.terms = {
+            { ecs_id(CollisionPanel) },
+            { ecs_id(Position), .inout = EcsIn },
+            { ecs_id(FileImpostor), .inout = EcsIn, .oper = EcsOptional }
+        },
+        .run = CollisionSystem,
+        .ctx = c
+    });
+
+    ecs_observer_desc_t removed_desc = {0};
+    removed_desc.query.terms[0].id = ecs_id(CollisionPanel);
+    removed_desc.events[0] = EcsOnRemove;
+    removed_desc.callback = OnCollisionPanelRemoved;
+    removed_desc.ctx = c;
+    ecs_observer_init(world, &removed_desc);
+}
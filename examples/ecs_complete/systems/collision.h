@@ -0,0 +1,83 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include <flecs.h>
+#include <stdbool.h>
+#include "../components/spatial.h"
+#ifdef PEVI_WITH_JOLT
+#include <joltc.h>
+#endif
+
+// Overlap resolution for phantom panels (file blocks and other flat boxes).
+// Panels are registered as static bodies in a dedicated Jolt object layer;
+// overlapping pairs are found with Jolt's broadphase (AABB tree) instead of
+// O(n^2) checks and pushed apart along the axis of least penetration.
+// New panels are inserted into the broadphase in batches once per frame.
+//
+// Jolt is optional: without PEVI_WITH_JOLT the components are registered
+// but panels are never resolved.
+//
+// The physics system is shared with the picking module, which keeps line
+// phantoms in a second object layer. Every object layer maps to its own
+// broadphase layer, so queries of one layer never visit the other's tree.
+
+#define COLLISION_LAYER_PANELS 0     // File blocks and other flat boxes
+#define COLLISION_LAYER_PHANTOMS 1   // Pickable phantoms (picking.c)
+#define COLLISION_LAYER_COUNT 2
+
+// Opt-in marker. File containers take their box from FileImpostor bounds,
+// other entities use half_extents as given.
+typedef struct {
+    Vector3 half_extents;
+    Vector3 offset;          // Box center relative to Position
+    int32_t slot;            // Index in the collision world, -1 until inserted
+} CollisionPanel;
+
+typedef struct {
+    bool enabled;
+    float padding;           // Gap kept between resolved panels (world units)
+    int max_passes;          // Relaxation passes per frame
+    int optimize_batch;      // Batches at least this large rebuild the broadphase tree
+    int max_bodies;          // Jolt body capacity, read at registration
+} CollisionSettings;
+
+typedef struct {
+    int32_t panels;
+    int32_t inserted_frame;  // Bodies added by the last batch
+    int32_t batches;
+    int32_t queries_frame;   // Broadphase box queries in the last frame
+    int32_t overlaps_frame;  // Overlapping pairs found in the last frame
+    int32_t moved_frame;     // Panels pushed in the last frame
+    int32_t passes_frame;
+    double insert_ms;        // Time of the last batch insertion
+    double frame_ms;
+    bool resolved;           // Last frame ended without overlaps
+} CollisionStats;
+
+extern ECS_COMPONENT_DECLARE(CollisionPanel);
+extern ECS_COMPONENT_DECLARE(CollisionSettings);
+extern ECS_COMPONENT_DECLARE(CollisionStats);
+
+// True when the build links Jolt
+bool CollisionAvailable(void);
+
+#ifdef PEVI_WITH_JOLT
+// Shared Jolt world, NULL when RegisterCollisionSystems could not create it.
+// Its fini action destroys every body left in it, so fini actions of other
+// users (registered later) must not touch their bodies.
+JPH_PhysicsSystem *CollisionPhysicsSystem(const ecs_world_t *world);
+
+// Broadphase layer filter that only accepts the tree of one object layer
+JPH_BroadPhaseLayerFilter *CollisionLayerFilter(const ecs_world_t *world, JPH_ObjectLayer layer);
+#endif
+
+// Opt an entity into overlap resolution (entity needs a Position)
+void AttachCollisionPanel(ecs_world_t *world, ecs_entity_t entity, Vector3 half_extents);
+
+// Systems and observers
+void CollisionSystem(ecs_iter_t *it);
+void OnCollisionPanelRemoved(ecs_iter_t *it);
+
+void RegisterCollisionSystems(ecs_world_t *world);
+
+#endif // COLLISION_H
@@ -1,4 +1,6 @@
 #include "core_systems.h"
+#include "picking.h"
+#include "profiler.h"
 #include <raylib.h>
 #include <raymath.h>
 #include <math.h>
@@ -27,8 +29,47 @@ void DrawText3D(Font font, const char *text, Vector3 position, float fontSize, f
     }
 }
 
+// Live input backend: samples raylib once per frame into the InputFrame
+// singleton. Headless tools write the singleton directly instead.
+void CaptureRaylibInput(ecs_world_t *world) {
+    InputFrame frame = {
+        .mouse_position = GetMousePosition(),
+        .mouse_delta = GetMouseDelta(),
+        .wheel = GetMouseWheelMove(),
+        .left_down = IsMouseButtonDown(MOUSE_BUTTON_LEFT),
+        .right_down = IsMouseButtonDown(MOUSE_BUTTON_RIGHT),
+        .left_pressed = IsMouseButtonPressed(MOUSE_BUTTON_LEFT),
+        .tab_pressed = IsKeyPressed(KEY_TAB),
+        .box_select_pressed = IsKeyPressed(KEY_B),
+        .sphere_select_pressed = IsKeyPressed(KEY_O),
+        .backspace_pressed = IsKeyPressed(KEY_BACKSPACE),
+        .screen_width = GetScreenWidth(),
+        .screen_height = GetScreenHeight()
+    };
+    
+    // One printable character per frame; the rest of the queue is dropped
+    for (int c = GetCharPressed(); c != 0; c = GetCharPressed()) {
+        if (frame.typed_char == 0 && c >= 32 && c < 127) {
+            frame.typed_char = c;
+        }
+    }
+
+    bool control = IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL);
+    bool shift = IsKeyDown(KEY_LEFT_SHIFT) || IsKeyDown(KEY_RIGHT_SHIFT);
+    frame.undo_pressed = control && !shift && IsKeyPressed(KEY_Z);
+    frame.redo_pressed = control && (IsKeyPressed(KEY_Y) || (shift && IsKeyPressed(KEY_Z)));
+    ecs_singleton_set_ptr(world, InputFrame, &frame);
+}
+
 // Input system for 3D navigation and selection - uses singleton queries
 void InputSystem(ecs_iter_t *it) {
+    PROFILE_ZONE_BEGIN(InputSystem);
+    const InputFrame *input = ecs_singleton_get(it->world, InputFrame);
+    if (!input) {
+        PROFILE_ZONE_END(InputSystem);
+        return;
+    }
+    
     // Add debug output to confirm system is running
     static int call_count = 0;
     call_count++;
@@ -63,10 +104,10 @@ void InputSystem(ecs_iter_t *it) {
         }
     
     // Handle mouse input for camera control
-    Vector2 mouse_delta = GetMouseDelta();
-    bool left_mouse = IsMouseButtonDown(MOUSE_BUTTON_LEFT);
-    bool right_mouse = IsMouseButtonDown(MOUSE_BUTTON_RIGHT);
-    float wheel = GetMouseWheelMove();
+    Vector2 mouse_delta = input->mouse_delta;
+    bool left_mouse = input->left_down;
+    bool right_mouse = input->right_down;
+    float wheel = input->wheel;
     
     if (editor_state->current_mode == 0) { // Navigation mode
         bool input_handled = false;
@@ -109,23 +150,51 @@ void InputSystem(ecs_iter_t *it) {
     }
     
         // Mode switching
-        if (IsKeyPressed(KEY_TAB)) {
+        if (input->tab_pressed) {
             editor_state->previous_mode = editor_state->current_mode;
             editor_state->current_mode = (editor_state->current_mode + 1) % 3;
             editor_state->mode_transition = true;
             printf("Switched to mode: %d\n", editor_state->current_mode);
         }
     } // End of for loop processing EditorState entities
+    PROFILE_ZONE_END(InputSystem);
+}
+
+// Publishes camera and viewport parameters to the ViewState singleton
+void ViewSystem(ecs_iter_t *it) {
+    PROFILE_ZONE_BEGIN(ViewSystem);
+    CameraController *cameras = ecs_field(it, CameraController, 0);
+    
+    // Singleton is created in RegisterCoreSystems, so writing through the
+    // pointer is safe while the frame is deferred
+    ViewState *view = ecs_singleton_get_mut(it->world, ViewState);
+    const InputFrame *input = ecs_singleton_get(it->world, InputFrame);
+    if (!view || !input) {
+        PROFILE_ZONE_END(ViewSystem);
+        return;
+    }
+    
+    for (int i = 0; i < it->count; i++) {
+        Camera3D camera = CreateCamera(&cameras[i]);
+        view->camera_position = camera.position;
+        view->camera_target = camera.target;
+        view->fovy = camera.fovy;
+        view->viewport_width = (float)input->screen_width;
+        view->viewport_height = (float)input->screen_height;
+    }
+    PROFILE_ZONE_END(ViewSystem);
 }
 
 // Transform computation system with hierarchical support
 void TransformSystem(ecs_iter_t *it) {
+    PROFILE_ZONE_BEGIN(TransformSystem);
     Position *positions = ecs_field(it, Position, 0);
     Rotation *rotations = ecs_field(it, Rotation, 1);
     Scale *scales = ecs_field(it, Scale, 2);
     EcsTransform *transforms = ecs_field(it, EcsTransform, 3);
     
     for (int i = 0; i < it->count; i++) {
+        transforms[i].changed = transforms[i].needs_update;
         if (transforms[i].needs_update) {
             // Convert quaternion to rotation matrix
             Matrix rot_matrix = QuaternionToMatrix((Quaternion){
@@ -145,12 +214,15 @@ void TransformSystem(ecs_iter_t *it) {
             transforms[i].needs_update = false;
         }
     }
+    PROFILE_ZONE_END(TransformSystem);
 }
 
 // Frustum culling system for performance optimization
 void CullingSystem(ecs_iter_t *it) {
+    PROFILE_ZONE_BEGIN(CullingSystem);
     EcsTransform *transforms = ecs_field(it, EcsTransform, 0);
     BoundingSphere *bounds = ecs_field(it, BoundingSphere, 1);
+    bool was_visible = ecs_field_is_set(it, 2);  // Visible is a tag, same for the whole table
     
     for (int i = 0; i < it->count; i++) {
         Vector3 world_pos = Vector3Transform(bounds[i].center_offset, transforms[i].world_matrix);
@@ -160,12 +232,14 @@ void CullingSystem(ecs_iter_t *it) {
         float distance = Vector3Length(world_pos);
         bool visible = distance < 200.0f; // Culling distance
         
-        if (visible) {
+        // Only enqueue transitions; WorldStats observers count the changes
+        if (visible && !was_visible) {
             ecs_add(it->world, it->entities[i], Visible);
-        } else {
+        } else if (!visible && was_visible) {
             ecs_remove(it->world, it->entities[i], Visible);
         }
     }
+    PROFILE_ZONE_END(CullingSystem);
 }
 
 // 3D text rendering system with billboard support
@@ -193,6 +267,7 @@ void TextRenderSystem(ecs_iter_t *it) {
 
 // Hot reload system for file changes
 void HotReloadSystem(ecs_iter_t *it) {
+    PROFILE_ZONE_BEGIN(HotReloadSystem);
     FileReference *file_refs = ecs_field(it, FileReference, 0);
     
     for (int i = 0; i < it->count; i++) {
@@ -203,61 +278,56 @@ void HotReloadSystem(ecs_iter_t *it) {
             file_refs[i].last_modified = current_time;
         }
     }
+    PROFILE_ZONE_END(HotReloadSystem);
 }
 
 // 3D picking system for phantom selection - uses singleton queries
 void PickingSystem(ecs_iter_t *it) {
+    PROFILE_ZONE_BEGIN(PickingSystem);
     // Get singleton entities for editor and camera
     ecs_entity_t editor_entity = ecs_lookup(it->world, "Editor");
     ecs_entity_t camera_entity = ecs_lookup(it->world, "MainCamera");
     
     if (editor_entity == 0 || camera_entity == 0) {
+        PROFILE_ZONE_END(PickingSystem);
         return; // Silently return if entities not found
     }
     
     EditorState *editor_state = ecs_get_mut(it->world, editor_entity, EditorState);
     const CameraController *camera_ctrl = ecs_get(it->world, camera_entity, CameraController);
+    const InputFrame *input = ecs_singleton_get(it->world, InputFrame);
     
-    if (!editor_state || !camera_ctrl) {
+    if (!editor_state || !camera_ctrl || !input) {
+        PROFILE_ZONE_END(PickingSystem);
         return; // Silently return if components not found
     }
     
-    if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT) && 
+    if (input->left_pressed && 
         editor_state->current_mode == 0) { // Navigation mode
         
         // Generate picking ray from mouse position
-        Vector2 mouse_pos = GetMousePosition();
+        Vector2 mouse_pos = input->mouse_position;
         CameraController camera_copy = *camera_ctrl; // Make a copy since CreateCamera expects non-const
         Camera3D camera = CreateCamera(&camera_copy);
-        Ray picking_ray = GetMouseRay(mouse_pos, camera);
-        
-        // Find closest intersection with phantom entities
-        float closest_distance __attribute__((unused)) = FLT_MAX;
-        ecs_entity_t closest_entity = 0;
-        
-        // Simplified selection - just select a dummy entity for now
-        // In a full implementation, this would iterate through entities with proper component queries
-        printf("Mouse clicked at (%.2f, %.2f) - ray: (%.2f, %.2f, %.2f)\n", 
-               mouse_pos.x, mouse_pos.y, picking_ray.direction.x, picking_ray.direction.y, picking_ray.direction.z);
+        Ray picking_ray = GetScreenToWorldRayEx(mouse_pos, camera, input->screen_width, input->screen_height);
         
-        // For demo purposes, create a simple entity to select
-        closest_entity = ecs_new(it->world);
-        printf("Created entity %llu for selection\n", closest_entity);
+        // Closest phantom along the ray (Jolt broadphase or linear scan)
+        ecs_entity_t closest_entity = PickPhantom(it->world, picking_ray, NULL);
         
-        // Update selection
         if (closest_entity != 0) {
-            // Clear previous selection (simplified)
-            if (editor_state->focused_entity != 0) {
-                printf("Clearing previous selection: %llu\n", editor_state->focused_entity);
+            if (editor_state->focused_entity != 0 && editor_state->focused_entity != closest_entity &&
+                ecs_is_alive(it->world, editor_state->focused_entity)) {
+                ecs_set(it->world, editor_state->focused_entity, Selected, {.is_selected = false});
+                ecs_remove(it->world, editor_state->focused_entity, Selected);
             }
-            
-            // Set new selection (simplified - just store entity ID)
-            printf("Selecting new entity: %llu\n", closest_entity);
-            
+            ecs_set(it->world, closest_entity, Selected, {
+                .is_selected = true,
+                .selection_time = (float)ecs_get_world_info(it->world)->world_time_total
+            });
             editor_state->focused_entity = closest_entity;
-            printf("Selected phantom entity %llu\n", closest_entity);
         }
     }
+    PROFILE_ZONE_END(PickingSystem);
 }
 
 // Helper function to get camera position from controller
@@ -291,9 +361,11 @@ Camera3D CreateCamera(CameraController *camera_ctrl) {
 void RegisterCoreSystems(ecs_world_t *world) {
     // Register systems using ECS_SYSTEM macro for consistency
     ECS_SYSTEM(world, InputSystem, EcsOnUpdate, EditorState);
+    ECS_SYSTEM(world, ViewSystem, EcsOnUpdate, CameraController);
     ECS_SYSTEM(world, PickingSystem, EcsOnUpdate, EditorState);
     ECS_SYSTEM(world, TransformSystem, EcsOnUpdate, Position, Rotation, Scale, EcsTransform);
-    ECS_SYSTEM(world, CullingSystem, EcsOnUpdate, EcsTransform, BoundingSphere);
+    // Phantoms inside a file collapsed to an impostor skip per-line culling
+    ECS_SYSTEM(world, CullingSystem, EcsOnUpdate, EcsTransform, BoundingSphere, ?Visible, !ImpostorActive(up));
     // TextRenderSystem removed - 3D text rendering now handled in main loop
     ECS_SYSTEM(world, HotReloadSystem, EcsOnUpdate, FileReference);
     
@@ -301,4 +373,18 @@ void RegisterCoreSystems(ecs_world_t *world) {
     ecs_add_pair(world, ecs_id(TransformSystem), EcsDependsOn, ecs_id(InputSystem));
     ecs_add_pair(world, ecs_id(CullingSystem), EcsDependsOn, ecs_id(TransformSystem));
     ecs_add_pair(world, ecs_id(PickingSystem), EcsDependsOn, ecs_id(InputSystem));
+    ecs_add_pair(world, ecs_id(ViewSystem), EcsDependsOn, ecs_id(InputSystem));
+    
+    // View parameters are read by LOD systems through a singleton
+    ecs_singleton_set(world, ViewState, {
+        .fovy = 45.0f,
+        .viewport_width = 1200.0f,
+        .viewport_height = 800.0f
+    });
+    
+    // Written every frame by CaptureRaylibInput or a scripted backend
+    ecs_singleton_set(world, InputFrame, {
+        .screen_width = 1200,
+        .screen_height = 800
+    });
 }
@@ -6,12 +6,16 @@
 
 // System declarations
 void InputSystem(ecs_iter_t *it);
+void ViewSystem(ecs_iter_t *it);
 void TransformSystem(ecs_iter_t *it);
 void CullingSystem(ecs_iter_t *it);
 void TextRenderSystem(ecs_iter_t *it);
 void HotReloadSystem(ecs_iter_t *it);
 void PickingSystem(ecs_iter_t *it);
 
+// Input backends
+void CaptureRaylibInput(ecs_world_t *world);
+
 // Helper functions
 Vector3 GetCameraPosition(CameraController camera_ctrl);
 Camera3D CreateCamera(CameraController *camera_ctrl);
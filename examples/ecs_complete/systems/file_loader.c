@@ -1,4 +1,8 @@
 #include "file_loader.h"
+#include "impostor.h"
+#include "layout.h"
+#include "collision.h"
+#include "syntax.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -45,32 +49,8 @@ ecs_entity_t CreatePhantomFromLine(ecs_world_t *world, const char* line_text, in
     return phantom;
 }
 
-// Load text file and create phantom entities for each line
-void LoadFileAsPhantoms(ecs_world_t *world, const char* filepath, Vector3 start_position) {
-    FILE *file = fopen(filepath, "r");
-    if (!file) {
-        printf("Failed to open file: %s\n", filepath);
-        
-        // Create a placeholder entity even if file doesn't exist
-        ecs_entity_t placeholder = ecs_new(world);
-        ecs_set_name(world, placeholder, filepath);
-        ecs_set(world, placeholder, Position, {start_position.x, start_position.y, start_position.z});
-        ecs_set(world, placeholder, Rotation, {0.0f, 0.0f, 0.0f, 1.0f});
-        ecs_set(world, placeholder, Scale, {1.0f, 1.0f, 1.0f});
-        ecs_set(world, placeholder, EcsTransform, {.needs_update = true});
-        
-        TextContent error_text = {.font_size = 1.5f, .color = RED, .billboard_mode = false};
-        snprintf(error_text.text, sizeof(error_text.text), "FILE NOT FOUND: %s", filepath);
-        ecs_set_ptr(world, placeholder, TextContent, &error_text);
-        
-        return;
-    }
-    
-    char line_buffer[1024];
-    int line_number = 0;
-    float line_spacing = 1.5f;
-    
-    // Create file container entity
+// Create the container entity that parents all line phantoms of a file
+ecs_entity_t CreateFileContainer(ecs_world_t *world, const char* filepath, Vector3 start_position) {
     ecs_entity_t file_entity = ecs_entity(world, {0});
     ecs_set_name(world, file_entity, filepath);
     ecs_set(world, file_entity, Position, {start_position.x, start_position.y, start_position.z});
@@ -95,17 +75,77 @@ void LoadFileAsPhantoms(ecs_world_t *world, const char* filepath, Vector3 start_
     file_title.text[sizeof(file_title.text) - 1] = '\0';
     ecs_set_ptr(world, file_entity, TextContent, &file_title);
     
+    // Far-field impostor replaces the whole block when zoomed out
+    AttachFileImpostor(world, file_entity);
+    
+    // Placement follows the relationship graph
+    AttachLayoutNode(world, file_entity, 0.0f);
+    
+    // Overlapping file blocks are pushed apart (size comes from the impostor)
+    AttachCollisionPanel(world, file_entity, (Vector3){1.0f, 1.0f, 0.5f});
+    
+    return file_entity;
+}
+
+// Load text file and create phantom entities for each line
+void LoadFileAsPhantoms(ecs_world_t *world, const char* filepath, Vector3 start_position) {
+    // The file is mapped as the original buffer of its piece table; the
+    // phantoms are created from the mapping, which the syntax store then
+    // keeps as the file's text
+    TextBuffer buffer;
+    if (!TextBufferInitMapped(&buffer, filepath)) {
+        printf("Failed to open file: %s\n", filepath);
+        
+        // Create a placeholder entity even if file doesn't exist
+        ecs_entity_t placeholder = ecs_new(world);
+        ecs_set_name(world, placeholder, filepath);
+        ecs_set(world, placeholder, Position, {start_position.x, start_position.y, start_position.z});
+        ecs_set(world, placeholder, Rotation, {0.0f, 0.0f, 0.0f, 1.0f});
+        ecs_set(world, placeholder, Scale, {1.0f, 1.0f, 1.0f});
+        ecs_set(world, placeholder, EcsTransform, {.needs_update = true});
+        
+        TextContent error_text = {.font_size = 1.5f, .color = RED, .billboard_mode = false};
+        snprintf(error_text.text, sizeof(error_text.text), "FILE NOT FOUND: %s", filepath);
+        ecs_set_ptr(world, placeholder, TextContent, &error_text);
+        
+        return;
+    }
+    
+    size_t length;
+    const char *contents = TextBufferContiguous(&buffer, &length);
+    
+    int line_number = 0;
+    float line_spacing = 1.5f;
+    
+    // Create file container entity
+    ecs_entity_t file_entity = CreateFileContainer(world, filepath, start_position);
+    
     // Create phantom for each line
-    while (fgets(line_buffer, sizeof(line_buffer), file)) {
-        // Remove newline character
-        line_buffer[strcspn(line_buffer, "\n")] = 0;
+    char line_buffer[sizeof(((TextContent*)0)->text)];
+    const char *cursor = contents;
+    const char *end = contents + length;
+    while (cursor < end) {
+        const char *line_start = cursor;
+        const char *newline = memchr(cursor, '\n', (size_t)(end - cursor));
+        size_t line_length = (size_t)((newline ? newline : end) - line_start);
+        if (line_length > 0 && line_start[line_length - 1] == '\r') {
+            line_length--;
+        }
+        cursor = newline ? newline + 1 : end;
         
         // Skip empty lines
-        if (strlen(line_buffer) == 0) {
+        if (line_length == 0) {
             line_number++;
             continue;
         }
         
+        // Long lines are truncated to what a phantom can display
+        if (line_length >= sizeof(line_buffer)) {
+            line_length = sizeof(line_buffer) - 1;
+        }
+        memcpy(line_buffer, line_start, line_length);
+        line_buffer[line_length] = '\0';
+        
         // Calculate line position
         Vector3 line_position = {
             start_position.x,
@@ -117,7 +157,8 @@ void LoadFileAsPhantoms(ecs_world_t *world, const char* filepath, Vector3 start_
         line_number++;
     }
     
-    fclose(file);
+    // The whole file is lexed at once, in parallel
+    AttachFileSyntaxBuffer(world, file_entity, &buffer);
     printf("Loaded %d lines from %s as phantoms\n", line_number, filepath);
 }
 
@@ -159,6 +200,9 @@ void LoadProjectAsPhantoms(ecs_world_t *world, const char* project_path) {
             TextContent file_text = {.font_size = 2.0f, .color = BLUE, .billboard_mode = false};
             strncpy(file_text.text, source_files[i], sizeof(file_text.text) - 1);
             ecs_set_ptr(world, file_entity, TextContent, &file_text);
+            AttachFileImpostor(world, file_entity);
+            AttachLayoutNode(world, file_entity, 0.0f);
+            AttachCollisionPanel(world, file_entity, (Vector3){1.0f, 1.0f, 0.5f});
             
             // Add some example code lines
             const char* example_lines[] = {
@@ -170,6 +214,15 @@ void LoadProjectAsPhantoms(ecs_world_t *world, const char* project_path) {
                 "}"
             };
             
+            // Lex the example as one text so lines share comment/directive state
+            char example_text[256];
+            size_t example_length = 0;
+            for (int j = 0; j < 6; j++) {
+                example_length += (size_t)snprintf(example_text + example_length,
+                                                   sizeof(example_text) - example_length, "%s\n", example_lines[j]);
+            }
+            AttachFileSyntax(world, file_entity, example_text, example_length);
+            
             for (int j = 0; j < 6; j++) {
                 if (strlen(example_lines[j]) > 0) {
                     Vector3 line_pos = {
@@ -9,6 +9,7 @@ void LoadFileAsPhantoms(ecs_world_t *world, const char* filepath, Vector3 start_
 void LoadProjectAsPhantoms(ecs_world_t *world, const char* project_path);
 
 // Helper functions
+ecs_entity_t CreateFileContainer(ecs_world_t *world, const char* filepath, Vector3 start_position);
 ecs_entity_t CreatePhantomFromLine(ecs_world_t *world, const char* line_text, int line_number, 
                                    const char* filepath, Vector3 position, ecs_entity_t parent);
 
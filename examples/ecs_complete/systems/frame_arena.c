@@ -0,0 +1,255 @@
+#include "frame_arena.h"
+#include "memory_tracker.h"
+#include "profiler.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+ECS_COMPONENT_DECLARE(FrameArenaStats);
+
+// Chunks of an arena form a list; the ones after the current chunk are
+// empty. The header is padded so data starts aligned.
+typedef struct FrameChunk {
+    struct FrameChunk *next;
+    size_t capacity;
+    size_t used;
+} FrameChunk;
+
+#define FRAME_CHUNK_HEADER \
+    ((sizeof(FrameChunk) + FRAME_ARENA_ALIGNMENT - 1) & ~(size_t)(FRAME_ARENA_ALIGNMENT - 1))
+
+// Owned by one thread; only FrameArenaReset touches it from elsewhere, at
+// the end of a frame
+typedef struct FrameArena {
+    FrameChunk *first;
+    FrameChunk *current;
+    size_t in_use;                // Bytes handed out and not rewound
+    size_t peak;                  // Largest in_use since the last reset
+    int64_t allocations;
+    int32_t chunk_mallocs;
+    struct FrameArena *next;
+} FrameArena;
+
+static _Atomic(FrameArena*) arena_list = NULL;
+static atomic_int arena_count = 0;
+static _Thread_local FrameArena *local_arena = NULL;
+
+// Totals over all arenas, filled in by FrameArenaReset
+static FrameArenaStats totals;
+
+static inline size_t AlignSize(size_t size) {
+    return (size + FRAME_ARENA_ALIGNMENT - 1) & ~(size_t)(FRAME_ARENA_ALIGNMENT - 1);
+}
+
+static inline unsigned char *ChunkData(FrameChunk *chunk) {
+    return (unsigned char*)chunk + FRAME_CHUNK_HEADER;
+}
+
+static FrameChunk *NewChunk(FrameArena *arena, size_t capacity) {
+    FrameChunk *chunk = TrackedMalloc(MEMORY_TAG_ARENA, FRAME_CHUNK_HEADER + capacity);
+    if (!chunk) {
+        printf("FrameArena: out of memory for a %zu byte chunk\n", capacity);
+        return NULL;
+    }
+    chunk->next = NULL;
+    chunk->capacity = capacity;
+    chunk->used = 0;
+    arena->chunk_mallocs++;
+    return chunk;
+}
+
+static FrameArena *GetLocalArena(void) {
+    if (local_arena) {
+        return local_arena;
+    }
+
+    FrameArena *arena = TrackedCalloc(MEMORY_TAG_ARENA, 1, sizeof(FrameArena));
+    if (!arena) {
+        return NULL;
+    }
+    arena->first = NewChunk(arena, FRAME_ARENA_CHUNK_SIZE);
+    if (!arena->first) {
+        TrackedFree(MEMORY_TAG_ARENA, arena);
+        return NULL;
+    }
+    arena->current = arena->first;
+
+    // Lock-free push onto the global list; arenas live for the process
+    FrameArena *head = atomic_load(&arena_list);
+    do {
+        arena->next = head;
+    } while (!atomic_compare_exchange_weak(&arena_list, &head, arena));
+    atomic_fetch_add(&arena_count, 1);
+
+    local_arena = arena;
+    return arena;
+}
+
+void *FrameAlloc(size_t size) {
+    FrameArena *arena = GetLocalArena();
+    if (!arena) {
+        return NULL;
+    }
+    size = AlignSize(size > 0 ? size : 1);
+
+    // Later chunks are empty; the first that fits becomes current
+    FrameChunk *chunk = arena->current;
+    while (chunk->used + size > chunk->capacity && chunk->next) {
+        chunk = chunk->next;
+    }
+    if (chunk->used + size > chunk->capacity) {
+        size_t capacity = arena->current->capacity;
+        while (capacity < size) {
+            capacity *= 2;
+        }
+        FrameChunk *grown = NewChunk(arena, capacity);
+        if (!grown) {
+            return NULL;
+        }
+        chunk->next = grown;
+        chunk = grown;
+    }
+
+    void *ptr = ChunkData(chunk) + chunk->used;
+    chunk->used += size;
+    arena->current = chunk;
+    arena->in_use += size;
+    if (arena->in_use > arena->peak) {
+        arena->peak = arena->in_use;
+    }
+    arena->allocations++;
+    return ptr;
+}
+
+void *FrameRealloc(void *ptr, size_t old_size, size_t new_size) {
+    if (!ptr) {
+        return FrameAlloc(new_size);
+    }
+    if (new_size <= old_size) {
+        return ptr;
+    }
+
+    // The last allocation grows in place when the chunk has room
+    FrameArena *arena = local_arena;
+    FrameChunk *chunk = arena ? arena->current : NULL;
+    size_t old_aligned = AlignSize(old_size > 0 ? old_size : 1);
+    size_t new_aligned = AlignSize(new_size);
+    if (chunk && (unsigned char*)ptr + old_aligned == ChunkData(chunk) + chunk->used &&
+        chunk->used - old_aligned + new_aligned <= chunk->capacity) {
+        chunk->used += new_aligned - old_aligned;
+        arena->in_use += new_aligned - old_aligned;
+        if (arena->in_use > arena->peak) {
+            arena->peak = arena->in_use;
+        }
+        return ptr;
+    }
+
+    void *moved = FrameAlloc(new_size);
+    if (moved) {
+        memcpy(moved, ptr, old_size);
+    }
+    return moved;
+}
+
+FrameArenaMark FrameArenaGetMark(void) {
+    FrameArena *arena = GetLocalArena();
+    if (!arena) {
+        return (FrameArenaMark){0};
+    }
+    return (FrameArenaMark){arena->current, arena->current->used, arena->in_use};
+}
+
+void FrameArenaRewind(FrameArenaMark mark) {
+    FrameArena *arena = local_arena;
+    if (!arena || !mark.chunk) {
+        return;
+    }
+    FrameChunk *chunk = mark.chunk;
+    for (FrameChunk *later = chunk->next; later; later = later->next) {
+        later->used = 0;
+    }
+    chunk->used = mark.used;
+    arena->current = chunk;
+    arena->in_use = mark.in_use;
+}
+
+void FrameArenaReset(void) {
+    int64_t capacity = 0;
+    int64_t used = 0;
+    int64_t allocations = 0;
+    int32_t chunk_mallocs = 0;
+
+    for (FrameArena *arena = atomic_load(&arena_list); arena; arena = arena->next) {
+        // A frame that spilled into more chunks gets one chunk of the
+        // combined size, so the next frame like it fits without a malloc
+        size_t total = 0;
+        for (FrameChunk *chunk = arena->first; chunk; chunk = chunk->next) {
+            total += chunk->capacity;
+        }
+        if (arena->first->next) {
+            FrameChunk *merged = NewChunk(arena, total);
+            if (merged) {
+                FrameChunk *chunk = arena->first;
+                while (chunk) {
+                    FrameChunk *next = chunk->next;
+                    TrackedFree(MEMORY_TAG_ARENA, chunk);
+                    chunk = next;
+                }
+                arena->first = merged;
+            }
+        }
+        for (FrameChunk *chunk = arena->first; chunk; chunk = chunk->next) {
+            chunk->used = 0;
+        }
+        arena->current = arena->first;
+
+        capacity += (int64_t)total;
+        used += (int64_t)arena->peak;
+        allocations += arena->allocations;
+        chunk_mallocs += arena->chunk_mallocs;
+        arena->in_use = 0;
+        arena->peak = 0;
+        arena->allocations = 0;
+    }
+
+    totals.arenas = atomic_load(&arena_count);
+    totals.capacity = capacity;
+    totals.used_frame = used;
+    if (used > totals.high_water) {
+        totals.high_water = used;
+    }
+    totals.allocations_frame = allocations;
+    totals.chunk_mallocs_frame = chunk_mallocs - totals.chunk_mallocs;
+    totals.chunk_mallocs = chunk_mallocs;
+    totals.frames++;
+}
+
+void FrameArenaSystem(ecs_iter_t *it) {
+    PROFILE_ZONE_BEGIN(FrameArenaReset);
+    FrameArenaReset();
+    PROFILE_ZONE_END(FrameArenaReset);
+
+    FrameArenaStats *stats = ecs_singleton_get_mut(it->world, FrameArenaStats);
+    if (stats) {
+        *stats = totals;
+    }
+}
+
+void RegisterFrameArena(ecs_world_t *world) {
+    ECS_COMPONENT_DEFINE(world, FrameArenaStats);
+    ecs_singleton_set(world, FrameArenaStats, {0});
+
+    // Arenas outlive worlds; only the reported history starts over
+    int32_t chunk_mallocs = totals.chunk_mallocs;
+    memset(&totals, 0, sizeof(totals));
+    totals.chunk_mallocs = chunk_mallocs;
+
+    ecs_system(world, {
+        .entity = ecs_entity(world, {
+            .name = "FrameArenaSystem",
+            .add = ecs_ids(ecs_dependson(EcsPostFrame))
+        }),
+        .callback = FrameArenaSystem
+    });
+}
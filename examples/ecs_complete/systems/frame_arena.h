@@ -0,0 +1,72 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <flecs.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Per-frame bump allocator for transient data.
+//
+// Each thread that allocates gets its own arena, so job pool workers never
+// contend. An allocation is a pointer bump in the thread's current chunk;
+// nothing is freed on its own. Every arena is reset when the frame ends
+// (FrameArenaSystem, in EcsPostFrame), which also merges an arena that
+// needed extra chunks into one chunk of the combined size. After the first
+// frames have reached the high-water mark, a frame calls malloc for none of
+// its scratch.
+//
+// Memory from the arena is valid until the end of the frame it was taken
+// in (data allocated after ecs_progress, e.g. while drawing, lives until
+// the end of the next one). Only code that finishes within a frame may use
+// it: main thread systems, and jobs that systems wait for. Background
+// threads that outlive a frame must not.
+//
+// Users: the impostor line list and the layout's octree and partial sums.
+// Culling builds no list (it toggles the Visible tag), so it has none.
+
+#define FRAME_ARENA_CHUNK_SIZE (1 << 20)  // First chunk of each arena
+#define FRAME_ARENA_ALIGNMENT 16
+
+// Where an arena stood, to give back scratch used within a frame
+typedef struct {
+    void *chunk;
+    size_t used;
+    size_t in_use;
+} FrameArenaMark;
+
+typedef struct {
+    int32_t arenas;              // Threads that have allocated
+    int64_t capacity;            // Bytes reserved in all arenas
+    int64_t used_frame;          // Peak bytes in use during the last frame, all arenas
+    int64_t high_water;          // Largest used_frame so far
+    int64_t allocations_frame;   // FrameAlloc calls in the last frame
+    int32_t chunk_mallocs;       // Chunks allocated so far
+    int32_t chunk_mallocs_frame; // ... in the last frame (0 in steady state)
+    int64_t frames;
+} FrameArenaStats;
+
+extern ECS_COMPONENT_DECLARE(FrameArenaStats);
+
+// size bytes from the calling thread's arena, aligned to
+// FRAME_ARENA_ALIGNMENT. NULL if out of memory.
+void *FrameAlloc(size_t size);
+
+// Resize an allocation. The last allocation of the thread grows in place
+// when its chunk has room; otherwise the contents move to a new block.
+void *FrameRealloc(void *ptr, size_t old_size, size_t new_size);
+
+// Give back everything the calling thread allocated since the mark
+FrameArenaMark FrameArenaGetMark(void);
+void FrameArenaRewind(FrameArenaMark mark);
+
+// Reset every arena. Called at the end of each frame; no other thread may
+// be using its arena.
+void FrameArenaReset(void);
+
+// Systems
+void FrameArenaSystem(ecs_iter_t *it);
+
+void RegisterFrameArena(ecs_world_t *world);
+
+#endif // FRAME_ARENA_H
@@ -0,0 +1,974 @@
+#include "fuzzy_finder.h"
+#include "worker_pool.h"
+#include "memory_tracker.h"
+#include "profiler.h"
+#include "search_index.h"
+#include "string_table.h"
+#include "symbol_index.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FINDER_USE_SSE2 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define FINDER_USE_NEON 1
+#endif
+
+ECS_COMPONENT_DECLARE(FinderSettings);
+ECS_COMPONENT_DECLARE(FinderPrompt);
+ECS_COMPONENT_DECLARE(FinderStats);
+
+#define FINDER_CHUNK 16384            // Candidates per scoring job
+
+// fzf's scoring constants (algo.go): every matched character scores, a gap
+// costs more to open than to extend, and a match right after a boundary
+// earns a bonus that consecutive matches inherit
+#define SCORE_MATCH 16
+#define SCORE_GAP_START -3
+#define SCORE_GAP_EXTENSION -1
+#define BONUS_BOUNDARY (SCORE_MATCH / 2)
+#define BONUS_NON_WORD (SCORE_MATCH / 2)
+#define BONUS_CAMEL_123 (BONUS_BOUNDARY + SCORE_GAP_EXTENSION)
+#define BONUS_CONSECUTIVE (-(SCORE_GAP_START + SCORE_GAP_EXTENSION))
+#define BONUS_FIRST_CHAR_MULTIPLIER 2
+#define BONUS_BOUNDARY_WHITE (BONUS_BOUNDARY + 2)
+#define BONUS_BOUNDARY_DELIMITER (BONUS_BOUNDARY + 1)
+
+// Character classes, ordered so that everything above CHAR_DELIMITER is a
+// word character
+enum {
+    CHAR_WHITE,
+    CHAR_NON_WORD,
+    CHAR_DELIMITER,               // '/', ',', ':', ';', '|'
+    CHAR_LOWER,
+    CHAR_UPPER,
+    CHAR_LETTER,                  // Bytes >= 0x80 (UTF-8)
+    CHAR_NUMBER,
+    CHAR_CLASS_COUNT
+};
+
+// A query, folded to lower case unless it is case-sensitive
+typedef struct {
+    unsigned char chars[FINDER_MAX_QUERY];
+    int length;
+    bool case_sensitive;
+    uint32_t mask;
+} FinderPattern;
+
+// Ranking key of a match: score, then the shorter name, then the earlier
+// candidate
+typedef struct {
+    int32_t score;
+    int32_t length;
+    int32_t candidate;
+} FinderRank;
+
+typedef struct {
+    StringTable names;
+    uint32_t *name_mask;          // Characters of each interned name
+    int name_mask_capacity;
+    char *folded;                 // Lower-case copy of the name arena, same offsets
+    int folded_capacity;
+
+    // Per candidate
+    int32_t *name;
+    ecs_entity_t *entity;
+    uint8_t *kind;
+    int32_t *grouped;             // Candidates by live name, in candidate order within a name
+    int count;
+    int capacity;
+    uint32_t generation;          // Bumped when the candidates are replaced
+
+    // Names stay interned across collections; the live ones have candidates.
+    // A query scores each live name once, then ranks its whole group.
+    int32_t *live_name;
+    uint32_t *live_mask;          // Contiguous for the SIMD prefilter
+    int32_t *group_start;         // live_count + 1 offsets into grouped
+    int live_count;
+    int live_capacity;
+    int32_t *name_live;           // Live index of each interned name, -1 if none
+    int name_live_capacity;
+
+    // One-character queries are ranked at collection time: best ranks and
+    // match count per query byte (a capital matches case-sensitively)
+    FinderRank char_best[256][FINDER_MAX_RESULTS];
+    int32_t char_best_count[256];
+    int32_t char_matches[256];
+
+    // Live names matched by the previous query, rescanned when the next
+    // one extends it
+    char last_query[FINDER_MAX_QUERY];
+    bool last_case_sensitive;
+    uint32_t last_generation;
+    bool has_last;
+    int32_t *matches;
+    int match_count;
+    int match_capacity;
+
+    // Query scratch: chunk outputs at their input offsets, per-chunk results
+    int32_t *scratch;
+    int scratch_capacity;
+    FinderRank *chunk_best;
+    int chunk_best_capacity;
+    int32_t *chunk_matches;
+    int32_t *chunk_candidates;
+    int32_t *chunk_passed;
+    int32_t *chunk_best_count;
+    int chunk_capacity;
+
+    FinderCandidate *collect;     // CollectFinderCandidates input
+    int collect_capacity;
+    bool dirty;                   // Files or functions changed since the last collection
+    ecs_query_t *file_query;
+    JobPool *pool;
+} FuzzyFinder;
+
+// The finder belongs to the world that registered the module: the system
+// and observers get it as ctx, API calls find it through this singleton
+typedef struct {
+    FuzzyFinder *finder;
+} FinderModule;
+
+static ECS_COMPONENT_DECLARE(FinderModule);
+
+static FuzzyFinder *GetFinder(const ecs_world_t *world) {
+    const FinderModule *module = ecs_singleton_get(world, FinderModule);
+    return module ? module->finder : NULL;
+}
+
+static uint8_t char_class[256];
+static int8_t bonus_matrix[CHAR_CLASS_COUNT][CHAR_CLASS_COUNT];  // [previous][current]
+
+static bool GrowCandidates(FuzzyFinder *finder, int needed) {
+    int old_capacity = finder->capacity;
+    if (needed <= old_capacity) {
+        return true;
+    }
+    int capacity = old_capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&finder->name, &capacity, needed, sizeof(int32_t))) {
+        return false;
+    }
+    capacity = old_capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&finder->entity, &capacity, needed, sizeof(ecs_entity_t))) {
+        return false;
+    }
+    capacity = old_capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&finder->kind, &capacity, needed, sizeof(uint8_t))) {
+        return false;
+    }
+    capacity = old_capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&finder->grouped, &capacity, needed, sizeof(int32_t))) {
+        return false;
+    }
+    finder->capacity = capacity;
+    return true;
+}
+
+static bool GrowLive(FuzzyFinder *finder, int needed) {
+    int old_capacity = finder->live_capacity;
+    if (needed <= old_capacity) {
+        return true;
+    }
+    int capacity = old_capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&finder->live_name, &capacity, needed, sizeof(int32_t))) {
+        return false;
+    }
+    capacity = old_capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&finder->live_mask, &capacity, needed, sizeof(uint32_t))) {
+        return false;
+    }
+    capacity = old_capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&finder->group_start, &capacity, needed, sizeof(int32_t))) {
+        return false;
+    }
+    finder->live_capacity = capacity;
+    return true;
+}
+
+static bool GrowChunks(FuzzyFinder *finder, int needed) {
+    int old_capacity = finder->chunk_capacity;
+    if (needed <= old_capacity) {
+        return true;
+    }
+    int capacity = old_capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&finder->chunk_matches, &capacity, needed, sizeof(int32_t))) {
+        return false;
+    }
+    capacity = old_capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&finder->chunk_candidates, &capacity, needed, sizeof(int32_t))) {
+        return false;
+    }
+    capacity = old_capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&finder->chunk_passed, &capacity, needed, sizeof(int32_t))) {
+        return false;
+    }
+    capacity = old_capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&finder->chunk_best_count, &capacity, needed, sizeof(int32_t))) {
+        return false;
+    }
+    finder->chunk_capacity = capacity;
+    return true;
+}
+
+static void InitCharClasses(void) {
+    for (int c = 0; c < 256; c++) {
+        uint8_t cls = CHAR_NON_WORD;
+        if (c >= 'a' && c <= 'z') {
+            cls = CHAR_LOWER;
+        } else if (c >= 'A' && c <= 'Z') {
+            cls = CHAR_UPPER;
+        } else if (c >= '0' && c <= '9') {
+            cls = CHAR_NUMBER;
+        } else if (c >= 0x80) {
+            cls = CHAR_LETTER;
+        } else if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f') {
+            cls = CHAR_WHITE;
+        } else if (c == '/' || c == ',' || c == ':' || c == ';' || c == '|') {
+            cls = CHAR_DELIMITER;
+        }
+        char_class[c] = cls;
+    }
+
+    for (int previous = 0; previous < CHAR_CLASS_COUNT; previous++) {
+        for (int current = 0; current < CHAR_CLASS_COUNT; current++) {
+            int bonus = 0;
+            if (current > CHAR_DELIMITER && previous == CHAR_WHITE) {
+                bonus = BONUS_BOUNDARY_WHITE;
+            } else if (current > CHAR_DELIMITER && previous == CHAR_DELIMITER) {
+                bonus = BONUS_BOUNDARY_DELIMITER;
+            } else if (current > CHAR_DELIMITER && previous == CHAR_NON_WORD) {
+                bonus = BONUS_BOUNDARY;
+            } else if ((previous == CHAR_LOWER && current == CHAR_UPPER) ||
+                       (previous != CHAR_NUMBER && current == CHAR_NUMBER)) {
+                bonus = BONUS_CAMEL_123;
+            } else if (current == CHAR_NON_WORD || current == CHAR_DELIMITER) {
+                bonus = BONUS_NON_WORD;
+            } else if (current == CHAR_WHITE) {
+                bonus = BONUS_BOUNDARY_WHITE;
+            }
+            bonus_matrix[previous][current] = (int8_t)bonus;
+        }
+    }
+}
+
+static inline unsigned char Fold(unsigned char c) {
+    return c >= 'A' && c <= 'Z' ? (unsigned char)(c + ('a' - 'A')) : c;
+}
+
+// One bit per letter, four shared by the digits, one for '_' and one for
+// everything else. Case-folded, so the mask test never rejects a match.
+static inline uint32_t CharBit(unsigned char c) {
+    c = Fold(c);
+    if (c >= 'a' && c <= 'z') {
+        return 1u << (c - 'a');
+    }
+    if (c >= '0' && c <= '9') {
+        return 1u << (26 + (c - '0') % 4);
+    }
+    return c == '_' ? 1u << 30 : 1u << 31;
+}
+
+static uint32_t CharMask(const char *text, size_t length) {
+    uint32_t mask = 0;
+    for (size_t i = 0; i < length; i++) {
+        mask |= CharBit((unsigned char)text[i]);
+    }
+    return mask;
+}
+
+// Scoring
+
+// fzf's V1 match: the first in-order occurrence of the query fixes the
+// end, a backward pass from there finds the shortest window, and the
+// window is scored. match is text itself for a case-sensitive query, its
+// folded copy otherwise. -1 if the query is not a subsequence of text.
+static int32_t ScoreCandidate(const unsigned char *text, const unsigned char *match, int length,
+                              const FinderPattern *pattern) {
+    const unsigned char *chars = pattern->chars;
+    int start = -1;
+    int end = 0;
+    for (int p = 0; p < pattern->length; p++) {
+        const unsigned char *found = memchr(match + end, chars[p], (size_t)(length - end));
+        if (!found) {
+            return -1;
+        }
+        end = (int)(found - match) + 1;
+        start = start < 0 ? end - 1 : start;
+    }
+
+    int p = pattern->length - 1;
+    for (int i = end - 1; i >= start; i--) {
+        if (match[i] == chars[p] && --p < 0) {
+            start = i;
+            break;
+        }
+    }
+
+    int32_t score = 0;
+    int consecutive = 0;
+    int first_bonus = 0;
+    bool in_gap = false;
+    int previous = start > 0 ? char_class[text[start - 1]] : CHAR_WHITE;
+    p = 0;
+    for (int i = start; i < end; i++) {
+        int current = char_class[text[i]];
+        if (p < pattern->length && match[i] == chars[p]) {
+            int bonus = bonus_matrix[previous][current];
+            score += SCORE_MATCH;
+            if (consecutive == 0) {
+                first_bonus = bonus;
+            } else {
+                // A run keeps the bonus of its first character
+                if (bonus >= BONUS_BOUNDARY && bonus > first_bonus) {
+                    first_bonus = bonus;
+                }
+                bonus = bonus > first_bonus ? bonus : first_bonus;
+                bonus = bonus > BONUS_CONSECUTIVE ? bonus : BONUS_CONSECUTIVE;
+            }
+            score += p == 0 ? bonus * BONUS_FIRST_CHAR_MULTIPLIER : bonus;
+            in_gap = false;
+            consecutive++;
+            p++;
+        } else {
+            score += in_gap ? SCORE_GAP_EXTENSION : SCORE_GAP_START;
+            in_gap = true;
+            consecutive = 0;
+            first_bonus = 0;
+        }
+        previous = current;
+    }
+    return score;
+}
+
+static inline bool RanksBefore(const FinderRank *a, const FinderRank *b) {
+    if (a->score != b->score) {
+        return a->score > b->score;
+    }
+    if (a->length != b->length) {
+        return a->length < b->length;
+    }
+    return a->candidate < b->candidate;
+}
+
+// Keeps best[0, *count) sorted, at most k entries. False if rank missed.
+static bool InsertRank(FinderRank *best, int *count, int k, const FinderRank *rank) {
+    if (*count == k && (k == 0 || !RanksBefore(rank, &best[k - 1]))) {
+        return false;
+    }
+    int i = *count < k ? (*count)++ : k - 1;
+    while (i > 0 && RanksBefore(rank, &best[i - 1])) {
+        best[i] = best[i - 1];
+        i--;
+    }
+    best[i] = *rank;
+    return true;
+}
+
+// Ranks the candidates of a matched live name. They share its score and
+// length, so the first one that misses the top k ends the group. Returns
+// the group size.
+static int RankGroup(const FuzzyFinder *finder, int32_t live, int32_t score, int32_t length,
+                     FinderRank *best, int *best_count, int k) {
+    int begin = finder->group_start[live];
+    int end = finder->group_start[live + 1];
+    for (int g = begin; g < end; g++) {
+        FinderRank rank = {score, length, finder->grouped[g]};
+        if (!InsertRank(best, best_count, k, &rank)) {
+            break;
+        }
+    }
+    return end - begin;
+}
+
+typedef struct {
+    FuzzyFinder *finder;
+    const FinderPattern *pattern;
+    const int32_t *input;         // Previous matches, NULL = every live name
+    int32_t *output;              // Each chunk writes its matched names at its input offset
+    FinderRank *best;             // k per chunk
+    int k;
+} FinderQuery;
+
+static inline void ScoreInto(FinderQuery *q, int32_t live, int32_t *out, int *matched, int *candidates,
+                             FinderRank *best, int *best_count) {
+    const FuzzyFinder *finder = q->finder;
+    int32_t name = finder->live_name[live];
+    int length = (int)finder->names.key_length[name];
+    if (length < q->pattern->length) {
+        return;
+    }
+    uint32_t offset = finder->names.key_offset[name];
+    const unsigned char *text = (const unsigned char*)finder->names.arena + offset;
+    const unsigned char *match = q->pattern->case_sensitive ? text : (const unsigned char*)finder->folded + offset;
+    int32_t score = ScoreCandidate(text, match, length, q->pattern);
+    if (score < 0) {
+        return;
+    }
+    out[(*matched)++] = live;
+    *candidates += RankGroup(finder, live, score, length, best, best_count, q->k);
+}
+
+static void QueryJob(void *ctx, int chunk, int begin, int end) {
+    FinderQuery *q = ctx;
+    FuzzyFinder *finder = q->finder;
+    int32_t *out = q->output + begin;
+    FinderRank *best = q->best + (size_t)chunk * q->k;
+    int matched = 0;
+    int candidates = 0;
+    int passed = 0;
+    int best_count = 0;
+    uint32_t need = q->pattern->mask;
+
+    if (q->input) {
+        for (int i = begin; i < end; i++) {
+            int32_t live = q->input[i];
+            if ((finder->live_mask[live] & need) == need) {
+                passed++;
+                ScoreInto(q, live, out, &matched, &candidates, best, &best_count);
+            }
+        }
+    } else {
+        int i = begin;
+#ifdef FINDER_USE_SSE2
+        // Four masks per compare; most lanes of a selective query are rejected here
+        const __m128i required = _mm_set1_epi32((int)need);
+        for (; i + 4 <= end; i += 4) {
+            __m128i masks = _mm_loadu_si128((const __m128i*)(finder->live_mask + i));
+            __m128i covered = _mm_cmpeq_epi32(_mm_and_si128(masks, required), required);
+            int lanes = _mm_movemask_ps(_mm_castsi128_ps(covered));
+            for (int lane = 0; lanes; lane++, lanes >>= 1) {
+                if (lanes & 1) {
+                    passed++;
+                    ScoreInto(q, i + lane, out, &matched, &candidates, best, &best_count);
+                }
+            }
+        }
+#elif defined(FINDER_USE_NEON)
+        const uint32x4_t required = vdupq_n_u32(need);
+        for (; i + 4 <= end; i += 4) {
+            uint32x4_t covered = vceqq_u32(vandq_u32(vld1q_u32(finder->live_mask + i), required), required);
+            if (vmaxvq_u32(covered) == 0) {
+                continue;
+            }
+            uint32_t lanes[4];
+            vst1q_u32(lanes, covered);
+            for (int lane = 0; lane < 4; lane++) {
+                if (lanes[lane]) {
+                    passed++;
+                    ScoreInto(q, i + lane, out, &matched, &candidates, best, &best_count);
+                }
+            }
+        }
+#endif
+        for (; i < end; i++) {
+            if ((finder->live_mask[i] & need) == need) {
+                passed++;
+                ScoreInto(q, i, out, &matched, &candidates, best, &best_count);
+            }
+        }
+    }
+
+    finder->chunk_matches[chunk] = matched;
+    finder->chunk_candidates[chunk] = candidates;
+    finder->chunk_passed[chunk] = passed;
+    finder->chunk_best_count[chunk] = best_count;
+}
+
+// Candidates
+
+// Counting sort of the candidates by live name, the live names numbered in
+// order of their first candidate
+static bool GroupByName(FuzzyFinder *finder) {
+    int names = finder->names.count;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&finder->name_live, &finder->name_live_capacity, names,
+                   sizeof(int32_t)) ||
+        !GrowLive(finder, names + 1)) {
+        return false;
+    }
+    for (int n = 0; n < names; n++) {
+        finder->name_live[n] = -1;
+    }
+
+    int32_t *start = finder->group_start;
+    finder->live_count = 0;
+    for (int c = 0; c < finder->count; c++) {
+        int32_t name = finder->name[c];
+        if (finder->name_live[name] < 0) {
+            int live = finder->live_count++;
+            finder->name_live[name] = live;
+            finder->live_name[live] = name;
+            finder->live_mask[live] = finder->name_mask[name];
+            start[live + 1] = 0;
+        }
+        start[finder->name_live[name] + 1]++;
+    }
+    start[0] = 0;
+    for (int live = 0; live < finder->live_count; live++) {
+        start[live + 1] += start[live];
+    }
+
+    // Filling moves each start to the next group's, so shift them back
+    for (int c = 0; c < finder->count; c++) {
+        finder->grouped[start[finder->name_live[finder->name[c]]]++] = c;
+    }
+    for (int live = finder->live_count; live > 0; live--) {
+        start[live] = start[live - 1];
+    }
+    start[0] = 0;
+    return true;
+}
+
+// A single character's V1 window is its first occurrence: one match with
+// the doubled first-character bonus. Folded bytes rank the case-insensitive
+// queries, capitals the case-sensitive ones.
+static void RankSingleCharacters(FuzzyFinder *finder) {
+    memset(finder->char_best_count, 0, sizeof(finder->char_best_count));
+    memset(finder->char_matches, 0, sizeof(finder->char_matches));
+    for (int live = 0; live < finder->live_count; live++) {
+        int32_t name = finder->live_name[live];
+        int length = (int)finder->names.key_length[name];
+        uint32_t offset = finder->names.key_offset[name];
+        const unsigned char *text = (const unsigned char*)finder->names.arena + offset;
+        const unsigned char *folded = (const unsigned char*)finder->folded + offset;
+        uint64_t seen[4] = {0};
+        int previous = CHAR_WHITE;
+        for (int i = 0; i < length; i++) {
+            int current = char_class[text[i]];
+            int32_t score = SCORE_MATCH + bonus_matrix[previous][current] * BONUS_FIRST_CHAR_MULTIPLIER;
+            unsigned char keys[2] = {folded[i], text[i]};
+            for (int k = 0; k < (text[i] != folded[i] ? 2 : 1); k++) {
+                unsigned char key = keys[k];
+                if (seen[key >> 6] & (1ull << (key & 63))) {
+                    continue;
+                }
+                seen[key >> 6] |= 1ull << (key & 63);
+                const FinderRank *last = &finder->char_best[key][FINDER_MAX_RESULTS - 1];
+                if (finder->char_best_count[key] == FINDER_MAX_RESULTS &&
+                    (score < last->score || (score == last->score && length > last->length))) {
+                    finder->char_matches[key] += finder->group_start[live + 1] - finder->group_start[live];
+                    continue;
+                }
+                finder->char_matches[key] += RankGroup(finder, live, score, length, finder->char_best[key],
+                                                       &finder->char_best_count[key], FINDER_MAX_RESULTS);
+            }
+            previous = current;
+        }
+    }
+}
+
+int SetFinderCandidates(ecs_world_t *world, const FinderCandidate *candidates, int count) {
+    FuzzyFinder *finder = GetFinder(world);
+    if (!finder) {
+        return -1;
+    }
+    PROFILE_ZONE_BEGIN(SetFinderCandidates);
+    uint64_t start = ProfilerNow();
+    finder->count = 0;
+    finder->generation++;
+    finder->has_last = false;
+    if (!GrowCandidates(finder, count)) {
+        PROFILE_ZONE_END(SetFinderCandidates);
+        return -1;
+    }
+
+    int files = 0;
+    for (int i = 0; i < count; i++) {
+        const char *text = candidates[i].name;
+        size_t length = text ? strlen(text) : 0;
+        if (length == 0) {
+            continue;
+        }
+        bool inserted;
+        int name = StringTableInsert(&finder->names, text, length, &inserted);
+        if (name < 0 || !GrowArray(MEMORY_TAG_INDEX, (void**)&finder->name_mask, &finder->name_mask_capacity, name + 1,
+                                   sizeof(uint32_t))) {
+            break;
+        }
+        if (inserted) {
+            if (!GrowArray(MEMORY_TAG_INDEX, (void**)&finder->folded, &finder->folded_capacity,
+                           finder->names.arena_length, 1)) {
+                break;
+            }
+            char *folded = finder->folded + finder->names.key_offset[name];
+            for (size_t k = 0; k < length; k++) {
+                folded[k] = (char)Fold((unsigned char)text[k]);
+            }
+            finder->name_mask[name] = CharMask(text, length);
+        }
+        int c = finder->count++;
+        finder->name[c] = name;
+        finder->entity[c] = candidates[i].entity;
+        finder->kind[c] = (uint8_t)candidates[i].kind;
+        files += candidates[i].kind == FINDER_FILE;
+    }
+    bool grouped = GroupByName(finder);
+    if (!grouped) {
+        finder->count = 0;
+        finder->live_count = 0;
+        files = 0;
+    }
+    RankSingleCharacters(finder);
+
+    FinderStats *stats = ecs_singleton_get_mut(world, FinderStats);
+    stats->candidates = finder->count;
+    stats->files = files;
+    stats->symbols = finder->count - files;
+    stats->names = finder->names.count;
+    stats->collect_ms = (double)(ProfilerNow() - start) / 1e6;
+    PROFILE_ZONE_END(SetFinderCandidates);
+    return grouped ? finder->count : -1;
+}
+
+int CollectFinderCandidates(ecs_world_t *world) {
+    FuzzyFinder *finder = GetFinder(world);
+    if (!finder) {
+        return 0;
+    }
+    PROFILE_ZONE_BEGIN(CollectFinderCandidates);
+    uint64_t start = ProfilerNow();
+    int count = 0;
+
+    // File containers and header entities: a FileReference and no parent
+    ecs_iter_t it = ecs_query_iter(world, finder->file_query);
+    while (ecs_query_next(&it)) {
+        const FileReference *refs = ecs_field(&it, FileReference, 0);
+        if (!GrowArray(MEMORY_TAG_INDEX, (void**)&finder->collect, &finder->collect_capacity, count + it.count,
+                       sizeof(FinderCandidate))) {
+            ecs_iter_fini(&it);
+            break;
+        }
+        for (int i = 0; i < it.count; i++) {
+            finder->collect[count++] = (FinderCandidate){it.entities[i], refs[i].filepath, FINDER_FILE};
+        }
+    }
+
+    if (ecs_id(FunctionSymbol)) {
+        it = ecs_each_id(world, ecs_id(FunctionSymbol));
+        while (ecs_each_next(&it)) {
+            const FunctionSymbol *functions = ecs_field(&it, FunctionSymbol, 0);
+            if (!GrowArray(MEMORY_TAG_INDEX, (void**)&finder->collect, &finder->collect_capacity, count + it.count,
+                           sizeof(FinderCandidate))) {
+                ecs_iter_fini(&it);
+                break;
+            }
+            for (int i = 0; i < it.count; i++) {
+                const char *name = GetSymbolName(world, functions[i].symbol);
+                if (name) {
+                    finder->collect[count++] = (FinderCandidate){it.entities[i], name, FINDER_SYMBOL};
+                }
+            }
+        }
+    }
+
+    int kept = SetFinderCandidates(world, finder->collect, count);
+    finder->dirty = false;
+    ecs_singleton_get_mut(world, FinderStats)->collect_ms = (double)(ProfilerNow() - start) / 1e6;
+    PROFILE_ZONE_END(CollectFinderCandidates);
+    return kept;
+}
+
+const char *GetFinderCandidateName(const ecs_world_t *world, int32_t candidate) {
+    const FuzzyFinder *finder = GetFinder(world);
+    if (!finder || candidate < 0 || candidate >= finder->count) {
+        return NULL;
+    }
+    return StringTableKey(&finder->names, finder->name[candidate]);
+}
+
+// Queries
+
+static void RememberQuery(FuzzyFinder *finder, const char *query, const FinderPattern *pattern, int matched) {
+    snprintf(finder->last_query, sizeof(finder->last_query), "%s", query);
+    finder->last_case_sensitive = pattern->case_sensitive;
+    finder->last_generation = finder->generation;
+    finder->match_count = matched;
+    finder->has_last = true;
+}
+
+int FindFuzzy(ecs_world_t *world, const char *query, FinderResult *results, int max_results) {
+    FuzzyFinder *finder = GetFinder(world);
+    if (!finder) {
+        return 0;
+    }
+    PROFILE_ZONE_BEGIN(FindFuzzy);
+    uint64_t start = ProfilerNow();
+    FinderStats *stats = ecs_singleton_get_mut(world, FinderStats);
+
+    FinderPattern pattern = {0};
+    for (const char *c = query; *c && pattern.length < FINDER_MAX_QUERY - 1; c++) {
+        pattern.case_sensitive |= *c >= 'A' && *c <= 'Z';
+        pattern.chars[pattern.length++] = (unsigned char)*c;
+    }
+    for (int i = 0; i < pattern.length; i++) {
+        pattern.chars[i] = pattern.case_sensitive ? pattern.chars[i] : Fold(pattern.chars[i]);
+        pattern.mask |= CharBit(pattern.chars[i]);
+    }
+    int k = max_results < FINDER_MAX_RESULTS ? max_results : FINDER_MAX_RESULTS;
+    k = k > 0 ? k : 0;
+    stats->threads = JobPoolWorkerCount(finder->pool) + 1;
+
+    // No scan for one character; the next keystroke scans the names cold
+    if (pattern.length == 1) {
+        unsigned char key = pattern.chars[0];
+        int shown = finder->char_best_count[key] < k ? finder->char_best_count[key] : k;
+        for (int r = 0; r < shown; r++) {
+            int32_t candidate = finder->char_best[key][r].candidate;
+            results[r] = (FinderResult){candidate, finder->char_best[key][r].score, finder->entity[candidate],
+                                        finder->kind[candidate]};
+        }
+        finder->has_last = false;
+        stats->scanned = 0;
+        stats->prefiltered = 0;
+        stats->matches = finder->char_matches[key];
+        stats->incremental = false;
+        stats->query_us = (double)(ProfilerNow() - start) / 1e3;
+        PROFILE_ZONE_END(FindFuzzy);
+        return finder->char_matches[key];
+    }
+
+    // Matches of a query are a superset of the matches of its extensions
+    // (a case-insensitive query is extended by a case-sensitive one, never
+    // the other way round)
+    size_t last_length = strlen(finder->last_query);
+    bool incremental = finder->has_last && finder->last_generation == finder->generation &&
+                       last_length <= (size_t)pattern.length && memcmp(finder->last_query, query, last_length) == 0 &&
+                       (pattern.case_sensitive || !finder->last_case_sensitive);
+    const int32_t *input = incremental ? finder->matches : NULL;
+    int count = pattern.length == 0 ? 0 : incremental ? finder->match_count : finder->live_count;
+    int chunk_count = JobPoolChunkCount(count, FINDER_CHUNK);
+
+    stats->scanned = count;
+    stats->prefiltered = 0;
+    stats->matches = 0;
+    stats->incremental = incremental;
+    if (count == 0 || !GrowArray(MEMORY_TAG_INDEX, (void**)&finder->scratch, &finder->scratch_capacity, count,
+                                 sizeof(int32_t)) ||
+        !GrowChunks(finder, chunk_count) ||
+        !GrowArray(MEMORY_TAG_INDEX, (void**)&finder->chunk_best, &finder->chunk_best_capacity,
+                   chunk_count * (k > 0 ? k : 1), sizeof(FinderRank))) {
+        // Nothing to scan stays nothing for every extension
+        RememberQuery(finder, query, &pattern, 0);
+        finder->has_last = pattern.length > 0 && count == 0;
+        stats->query_us = (double)(ProfilerNow() - start) / 1e3;
+        PROFILE_ZONE_END(FindFuzzy);
+        return 0;
+    }
+
+    FinderQuery q = {
+        .finder = finder,
+        .pattern = &pattern,
+        .input = input,
+        .output = finder->scratch,
+        .best = finder->chunk_best,
+        .k = k
+    };
+    JobPoolParallelFor(finder->pool, count, FINDER_CHUNK, QueryJob, &q);
+
+    // Compact the chunk outputs in chunk order and merge their best lists
+    FinderRank best[FINDER_MAX_RESULTS];
+    int best_count = 0;
+    int matched = 0;
+    int candidates = 0;
+    int passed = 0;
+    for (int c = 0; c < chunk_count; c++) {
+        int n = finder->chunk_matches[c];
+        if (n > 0 && matched != c * FINDER_CHUNK) {
+            memmove(finder->scratch + matched, finder->scratch + (size_t)c * FINDER_CHUNK, sizeof(int32_t) * n);
+        }
+        matched += n;
+        candidates += finder->chunk_candidates[c];
+        passed += finder->chunk_passed[c];
+        for (int r = 0; r < finder->chunk_best_count[c]; r++) {
+            InsertRank(best, &best_count, k, &finder->chunk_best[(size_t)c * k + r]);
+        }
+    }
+
+    // The matches become the input of the next keystroke
+    int32_t *swap = finder->matches;
+    int swap_capacity = finder->match_capacity;
+    finder->matches = finder->scratch;
+    finder->match_capacity = finder->scratch_capacity;
+    finder->scratch = swap;
+    finder->scratch_capacity = swap_capacity;
+    RememberQuery(finder, query, &pattern, matched);
+
+    for (int r = 0; r < best_count; r++) {
+        int32_t candidate = best[r].candidate;
+        results[r] = (FinderResult){candidate, best[r].score, finder->entity[candidate], finder->kind[candidate]};
+    }
+    stats->prefiltered = passed;
+    stats->matches = candidates;
+    stats->query_us = (double)(ProfilerNow() - start) / 1e3;
+    PROFILE_ZONE_END(FindFuzzy);
+    return candidates;
+}
+
+// Prompt
+
+static void SelectFinderResult(ecs_world_t *world, ecs_entity_t entity) {
+    ecs_defer_begin(world);
+    ecs_iter_t it = ecs_each_id(world, ecs_id(Selected));
+    while (ecs_each_next(&it)) {
+        for (int i = 0; i < it.count; i++) {
+            ecs_set(world, it.entities[i], Selected, {.is_selected = false});
+            ecs_remove(world, it.entities[i], Selected);
+        }
+    }
+    float now = (float)ecs_get_world_info(world)->world_time_total;
+    ecs_set(world, entity, Selected, {.is_selected = true, .selection_id = 0, .selection_time = now});
+    ecs_defer_end(world);
+
+    const Position *position = ecs_get(world, entity, Position);
+    if (position) {
+        FlyCameraTo(world, (Vector3){position->x, position->y, position->z});
+    }
+}
+
+void FinderPromptSystem(ecs_iter_t *it) {
+    FuzzyFinder *finder = it->ctx;
+    EditorState *editor_states = ecs_field(it, EditorState, 0);
+    const InputFrame *input = ecs_singleton_get(it->world, InputFrame);
+    const FinderSettings *settings = ecs_singleton_get(it->world, FinderSettings);
+    const SearchPrompt *search_prompt = ecs_singleton_get(it->world, SearchPrompt);
+    FinderPrompt *prompt = ecs_singleton_get_mut(it->world, FinderPrompt);
+    if (!input || !settings || !prompt) {
+        return;
+    }
+
+    for (int i = 0; i < it->count; i++) {
+        if (editor_states[i].current_mode != 2) {
+            prompt->active = false;
+            continue;
+        }
+        if (!prompt->active) {
+            if ((input->typed_char == 'p' || input->typed_char == 'P') && !(search_prompt && search_prompt->active)) {
+                prompt->active = true;
+                prompt->query[0] = '\0';
+                prompt->matches = 0;
+                prompt->result_count = 0;
+                if (settings->enabled && finder->dirty) {
+                    CollectFinderCandidates(it->world);
+                }
+            }
+            continue;
+        }
+
+        size_t length = strlen(prompt->query);
+        if (input->backspace_pressed) {
+            if (length == 0) {
+                prompt->active = false;
+                continue;
+            }
+            prompt->query[--length] = '\0';
+        } else if (input->typed_char >= 32 && input->typed_char < 127 && length + 1 < sizeof(prompt->query)) {
+            prompt->query[length++] = (char)input->typed_char;
+            prompt->query[length] = '\0';
+        } else {
+            continue;
+        }
+
+        int max_results = settings->max_results < FINDER_MAX_RESULTS ? settings->max_results : FINDER_MAX_RESULTS;
+        prompt->matches = FindFuzzy(it->world, prompt->query, prompt->results, max_results);
+        prompt->result_count = prompt->matches < max_results ? prompt->matches : max_results;
+        ecs_entity_t best = prompt->result_count > 0 ? prompt->results[0].entity : 0;
+        if (best && ecs_is_alive(it->world, best)) {
+            SelectFinderResult(it->world, best);
+            editor_states[i].focused_entity = best;
+        }
+    }
+}
+
+// Files or functions appeared or went away: collect again on the next open
+void OnFinderSourceChanged(ecs_iter_t *it) {
+    FuzzyFinder *finder = it->ctx;
+    finder->dirty = true;
+}
+
+static void FuzzyFinderFini(ecs_world_t *world, void *ctx) {
+    FuzzyFinder *finder = ctx;
+    WorkerPoolRelease(world);
+    StringTableFree(&finder->names);
+    TrackedFree(MEMORY_TAG_INDEX, finder->name_mask);
+    TrackedFree(MEMORY_TAG_INDEX, finder->folded);
+    TrackedFree(MEMORY_TAG_INDEX, finder->name);
+    TrackedFree(MEMORY_TAG_INDEX, finder->entity);
+    TrackedFree(MEMORY_TAG_INDEX, finder->kind);
+    TrackedFree(MEMORY_TAG_INDEX, finder->grouped);
+    TrackedFree(MEMORY_TAG_INDEX, finder->live_name);
+    TrackedFree(MEMORY_TAG_INDEX, finder->live_mask);
+    TrackedFree(MEMORY_TAG_INDEX, finder->group_start);
+    TrackedFree(MEMORY_TAG_INDEX, finder->name_live);
+    TrackedFree(MEMORY_TAG_INDEX, finder->matches);
+    TrackedFree(MEMORY_TAG_INDEX, finder->scratch);
+    TrackedFree(MEMORY_TAG_INDEX, finder->chunk_best);
+    TrackedFree(MEMORY_TAG_INDEX, finder->chunk_matches);
+    TrackedFree(MEMORY_TAG_INDEX, finder->chunk_candidates);
+    TrackedFree(MEMORY_TAG_INDEX, finder->chunk_passed);
+    TrackedFree(MEMORY_TAG_INDEX, finder->chunk_best_count);
+    TrackedFree(MEMORY_TAG_INDEX, finder->collect);
+    TrackedFree(MEMORY_TAG_INDEX, finder);
+}
+
+void RegisterFuzzyFinder(ecs_world_t *world) {
+    ECS_COMPONENT_DEFINE(world, FinderSettings);
+    ECS_COMPONENT_DEFINE(world, FinderPrompt);
+    ECS_COMPONENT_DEFINE(world, FinderStats);
+    ECS_COMPONENT_DEFINE(world, FinderModule);
+
+    InitCharClasses();
+    ecs_singleton_set(world, FinderSettings, {
+        .enabled = true,
+        .max_results = 10
+    });
+    ecs_singleton_set(world, FinderPrompt, {0});
+    ecs_singleton_set(world, FinderStats, {0});
+
+    FuzzyFinder *finder = TrackedCalloc(MEMORY_TAG_INDEX, 1, sizeof(FuzzyFinder));
+    if (!finder) {
+        printf("FuzzyFinder: out of memory\n");
+        return;
+    }
+    finder->pool = WorkerPoolAcquire(world);
+    finder->dirty = true;
+    finder->file_query = ecs_query(world, {
+        .terms = {
+            { ecs_id(FileReference), .inout = EcsIn },
+            { ecs_pair(EcsChildOf, EcsWildcard), .oper = EcsNot }
+        }
+    });
+    ecs_singleton_set(world, FinderModule, {finder});
+    ecs_atfini(world, FuzzyFinderFini, finder);
+
+    // After the search prompt, which ignores 'p' while it is closed
+    ecs_system(world, {
+        .entity = ecs_entity(world, {
+            .name = "FinderPromptSystem",
+            .add = ecs_ids(ecs_dependson(EcsOnUpdate))
+        }),
+        .query.terms = {
+            { ecs_id(EditorState) }
+        },
+        .callback = FinderPromptSystem,
+        .ctx = finder
+    });
+
+    ecs_observer_desc_t file_desc = {0};
+    file_desc.query.terms[0].id = ecs_id(FileReference);
+    file_desc.events[0] = EcsOnSet;
+    file_desc.events[1] = EcsOnRemove;
+    file_desc.callback = OnFinderSourceChanged;
+    file_desc.ctx = finder;
+    ecs_observer_init(world, &file_desc);
+
+    if (ecs_id(FunctionSymbol)) {
+        ecs_observer_desc_t symbol_desc = {0};
+        symbol_desc.query.terms[0].id = ecs_id(FunctionSymbol);
+        symbol_desc.events[0] = EcsOnSet;
+        symbol_desc.events[1] = EcsOnRemove;
+        symbol_desc.callback = OnFinderSourceChanged;
+        symbol_desc.ctx = finder;
+        ecs_observer_init(world, &symbol_desc);
+    }
+}
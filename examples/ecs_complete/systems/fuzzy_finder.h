@@ -0,0 +1,107 @@
+#ifndef FUZZY_FINDER_H
+#define FUZZY_FINDER_H
+
+#include <flecs.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "../components/spatial.h"
+
+// Fuzzy finder over file paths and function names: the query's characters
+// must appear in order, and matches are ranked the way fzf ranks them
+// (consecutive runs and characters after a word boundary, '/', '_' or a
+// camelCase hump score higher, gaps cost).
+//
+// Candidate names are interned once into a string table together with a
+// 32-bit mask of the characters they contain, and the candidates are
+// grouped by name. A query first rejects every name whose mask lacks one
+// of the query's characters, four masks per SSE2 or NEON compare (scalar
+// on other targets), then scores each surviving name once for its whole
+// group. Both passes run in chunks on the finder job pool; each chunk
+// keeps its own best results, merged in chunk order so the ranking does
+// not depend on the thread count. A query that extends the previous one
+// only rescans the previous matches. One-character queries, the ones that
+// match most names, are ranked ahead of time when the candidates are set.
+//
+// Files are the entities with a FileReference and no parent, functions
+// the FunctionSymbol phantoms (see symbol_index.h). Candidates are
+// collected again when the prompt opens after either changed.
+
+#define FINDER_MAX_QUERY 64
+#define FINDER_MAX_RESULTS 16
+
+enum {
+    FINDER_FILE = 0,
+    FINDER_SYMBOL = 1
+};
+
+// One candidate handed to SetFinderCandidates
+typedef struct {
+    ecs_entity_t entity;
+    const char *name;         // Copied (interned)
+    int kind;                 // FINDER_*
+} FinderCandidate;
+
+// One ranked match
+typedef struct {
+    int32_t candidate;
+    int32_t score;
+    ecs_entity_t entity;
+    int kind;
+} FinderResult;
+
+typedef struct {
+    bool enabled;             // Collect files and functions from the world
+    int max_results;          // Ranked results kept, up to FINDER_MAX_RESULTS
+} FinderSettings;
+
+// Command mode prompt: 'p' opens it, every keystroke reranks and flies the
+// camera to the best match
+typedef struct {
+    bool active;
+    char query[FINDER_MAX_QUERY];
+    int matches;              // Candidates matching the query
+    int result_count;
+    FinderResult results[FINDER_MAX_RESULTS];  // Best first
+} FinderPrompt;
+
+typedef struct {
+    int32_t candidates;
+    int32_t files;
+    int32_t symbols;
+    int32_t names;            // Distinct interned names
+    int32_t threads;          // Scoring threads including the caller
+    double collect_ms;        // Last candidate collection
+
+    int32_t scanned;          // Names the last query looked at, 0 for one character
+    int32_t prefiltered;      // Passed the character mask
+    int32_t matches;          // Candidates matched in order
+    bool incremental;         // Rescanned the previous matches only
+    double query_us;
+} FinderStats;
+
+extern ECS_COMPONENT_DECLARE(FinderSettings);
+extern ECS_COMPONENT_DECLARE(FinderPrompt);
+extern ECS_COMPONENT_DECLARE(FinderStats);
+
+// Replace the candidate set. Returns the candidates kept, -1 when out of
+// memory.
+int SetFinderCandidates(ecs_world_t *world, const FinderCandidate *candidates, int count);
+
+// Collect the files and functions of the world as candidates
+int CollectFinderCandidates(ecs_world_t *world);
+
+// Rank the candidates matching query (case-insensitive unless it has an
+// uppercase letter). Fills up to max_results best first and returns the
+// number of matches.
+int FindFuzzy(ecs_world_t *world, const char *query, FinderResult *results, int max_results);
+
+// Interned name of a candidate, NULL if out of range
+const char *GetFinderCandidateName(const ecs_world_t *world, int32_t candidate);
+
+// Systems and observers
+void FinderPromptSystem(ecs_iter_t *it);
+void OnFinderSourceChanged(ecs_iter_t *it);
+
+void RegisterFuzzyFinder(ecs_world_t *world);
+
+#endif // FUZZY_FINDER_H
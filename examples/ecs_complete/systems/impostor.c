@@ -0,0 +1,426 @@
+#include "impostor.h"
+#include "frame_arena.h"
+#include "memory_tracker.h"
+#include "profiler.h"
+#include <raylib.h>
+#include <raymath.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+ECS_COMPONENT_DECLARE(FileImpostor);
+ECS_COMPONENT_DECLARE(ImpostorSettings);
+
+// Layout metrics used to estimate the footprint of a file block
+#define IMPOSTOR_COLUMN_WIDTH 0.5f  // World units per text column
+#define IMPOSTOR_TAB_WIDTH 4
+
+// Component hooks: FileImpostor owns a pixel buffer and a GPU texture
+static void FileImpostor_move(void *dst_ptr, void *src_ptr, int32_t count, const ecs_type_info_t *ti) {
+    FileImpostor *dst = (FileImpostor*)dst_ptr;
+    FileImpostor *src = (FileImpostor*)src_ptr;
+    for (int i = 0; i < count; i++) {
+        dst[i] = src[i];
+        src[i].pixels = NULL;
+        src[i].has_texture = false;
+    }
+}
+
+static void FileImpostor_dtor(void *ptr, int32_t count, const ecs_type_info_t *ti) {
+    FileImpostor *impostors = (FileImpostor*)ptr;
+    for (int i = 0; i < count; i++) {
+        TrackedFree(MEMORY_TAG_IMPOSTOR, impostors[i].pixels);
+        impostors[i].pixels = NULL;
+        if (impostors[i].has_texture) {
+            MemoryTrackExternal(MEMORY_TAG_GPU, -(int64_t)impostors[i].width * impostors[i].height * 4);
+            if (IsWindowReady()) {
+                UnloadTexture(impostors[i].texture);
+            }
+        }
+        impostors[i].has_texture = false;
+    }
+}
+
+static uint32_t HashText(uint32_t hash, const char *text) {
+    // FNV-1a
+    for (const unsigned char *c = (const unsigned char*)text; *c; c++) {
+        hash ^= *c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// CPU minimap rasterizer. Every non-whitespace character becomes a cell in
+// the line's color; cells landing on the same pixel keep the brightest value.
+void RasterizeFileMinimap(const ImpostorLine *lines, int line_count, int total_lines,
+                          int max_columns, uint8_t *rgba, int width, int height) {
+    if (!rgba || width <= 0 || height <= 0) {
+        return;
+    }
+
+    // Dark translucent backing so the block reads as a solid panel
+    for (int p = 0; p < width * height; p++) {
+        rgba[p * 4 + 0] = 20;
+        rgba[p * 4 + 1] = 20;
+        rgba[p * 4 + 2] = 30;
+        rgba[p * 4 + 3] = 200;
+    }
+
+    if (total_lines <= 0 || max_columns <= 0) {
+        return;
+    }
+
+    for (int l = 0; l < line_count; l++) {
+        const ImpostorLine *line = &lines[l];
+        if (line->line_number < 0 || line->line_number >= total_lines) {
+            continue;
+        }
+
+        int y0 = (int)((int64_t)line->line_number * height / total_lines);
+        int y1 = (int)((int64_t)(line->line_number + 1) * height / total_lines);
+        if (y1 <= y0) {
+            y1 = y0 + 1;
+        }
+        if (y1 > height) {
+            y1 = height;
+        }
+
+        int column = 0;
+        for (const char *c = line->text; *c && column < max_columns; c++) {
+            if (*c == '\t') {
+                column += IMPOSTOR_TAB_WIDTH - (column % IMPOSTOR_TAB_WIDTH);
+                continue;
+            }
+            if (*c == ' ') {
+                column++;
+                continue;
+            }
+
+            int x0 = (int)((int64_t)column * width / max_columns);
+            int x1 = (int)((int64_t)(column + 1) * width / max_columns);
+            if (x1 <= x0) {
+                x1 = x0 + 1;
+            }
+            if (x1 > width) {
+                x1 = width;
+            }
+
+            for (int y = y0; y < y1; y++) {
+                uint8_t *row = rgba + (size_t)y * width * 4;
+                for (int x = x0; x < x1; x++) {
+                    uint8_t *px = row + x * 4;
+                    if (line->color.r > px[0]) px[0] = line->color.r;
+                    if (line->color.g > px[1]) px[1] = line->color.g;
+                    if (line->color.b > px[2]) px[2] = line->color.b;
+                    px[3] = 255;
+                }
+            }
+            column++;
+        }
+    }
+}
+
+// Recompute world-space bounds of a file block from its line phantoms
+static void RefreshImpostorBounds(ecs_world_t *world, ecs_entity_t file_entity, FileImpostor *impostor) {
+    Vector3 min = {FLT_MAX, FLT_MAX, FLT_MAX};
+    Vector3 max = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    int max_length = 0;
+
+    const Position *file_pos = ecs_get(world, file_entity, Position);
+    if (file_pos) {
+        min = max = (Vector3){file_pos->x, file_pos->y, file_pos->z};
+    }
+
+    ecs_iter_t it = ecs_children(world, file_entity);
+    while (ecs_children_next(&it)) {
+        for (int i = 0; i < it.count; i++) {
+            const Position *pos = ecs_get(world, it.entities[i], Position);
+            if (!pos) {
+                continue;
+            }
+            Vector3 p = {pos->x, pos->y, pos->z};
+            min = Vector3Min(min, p);
+            max = Vector3Max(max, p);
+
+            const TextContent *text = ecs_get(world, it.entities[i], TextContent);
+            if (text) {
+                int length = (int)strlen(text->text);
+                if (length > max_length) {
+                    max_length = length;
+                }
+            }
+        }
+    }
+
+    if (min.x > max.x) {
+        // No spatial data at all
+        impostor->center = (Vector3){0};
+        impostor->extent = (Vector2){1.0f, 1.0f};
+        impostor->radius = 1.0f;
+        impostor->bounds_dirty = false;
+        return;
+    }
+
+    // Text extends to the right of the phantom anchor
+    float text_width = max_length * IMPOSTOR_COLUMN_WIDTH;
+    max.x += text_width * 0.5f;
+    min.x -= text_width * 0.5f;
+
+    impostor->center = Vector3Scale(Vector3Add(min, max), 0.5f);
+    impostor->extent = (Vector2){fmaxf(max.x - min.x, 1.0f), fmaxf(max.y - min.y, 1.0f)};
+    impostor->radius = 0.5f * Vector3Distance(min, max);
+    impostor->bounds_dirty = false;
+}
+
+static bool BuildImpostor(ecs_world_t *world, ecs_entity_t file_entity, FileImpostor *impostor,
+                          const ImpostorSettings *settings) {
+    // Line list is scratch from the frame arena, given back on return
+    FrameArenaMark mark = FrameArenaGetMark();
+    int capacity = 256;
+    int count = 0;
+    int total_lines = 1;
+    ImpostorLine *lines = FrameAlloc(capacity * sizeof(ImpostorLine));
+    if (!lines) {
+        return false;
+    }
+
+    uint32_t hash = 2166136261u;
+    ecs_iter_t it = ecs_children(world, file_entity);
+    while (ecs_children_next(&it)) {
+        for (int i = 0; i < it.count; i++) {
+            const TextContent *text = ecs_get(world, it.entities[i], TextContent);
+            const FileReference *ref = ecs_get(world, it.entities[i], FileReference);
+            if (!text || !ref) {
+                continue;
+            }
+
+            if (count == capacity) {
+                ImpostorLine *grown = FrameRealloc(lines, capacity * sizeof(ImpostorLine),
+                                                   capacity * 2 * sizeof(ImpostorLine));
+                if (!grown) {
+                    FrameArenaRewind(mark);
+                    return false;
+                }
+                lines = grown;
+                capacity *= 2;
+            }
+
+            lines[count++] = (ImpostorLine){text->text, ref->line_number, text->color};
+            if (ref->line_number + 1 > total_lines) {
+                total_lines = ref->line_number + 1;
+            }
+            hash = HashText(hash ^ (uint32_t)ref->line_number, text->text);
+        }
+    }
+
+    // Text is unchanged since the last build (e.g. reload of identical content)
+    if (impostor->pixels && hash == impostor->content_hash) {
+        FrameArenaRewind(mark);
+        impostor->image_dirty = false;
+        return true;
+    }
+
+    int width = settings->texture_width;
+    int height = settings->texture_height;
+    if (!impostor->pixels || impostor->width != width || impostor->height != height) {
+        TrackedFree(MEMORY_TAG_IMPOSTOR, impostor->pixels);
+        impostor->pixels = TrackedMalloc(MEMORY_TAG_IMPOSTOR, (size_t)width * height * 4);
+        if (!impostor->pixels) {
+            FrameArenaRewind(mark);
+            return false;
+        }
+        if (impostor->has_texture) {
+            MemoryTrackExternal(MEMORY_TAG_GPU, -(int64_t)impostor->width * impostor->height * 4);
+            if (IsWindowReady()) {
+                UnloadTexture(impostor->texture);
+            }
+        }
+        impostor->has_texture = false;
+        impostor->width = width;
+        impostor->height = height;
+    }
+
+    RasterizeFileMinimap(lines, count, total_lines, settings->max_columns,
+                         impostor->pixels, width, height);
+    FrameArenaRewind(mark);
+
+    // GPU upload only when a GL context exists; headless runs keep the CPU image
+    if (IsWindowReady()) {
+        if (impostor->has_texture) {
+            UpdateTexture(impostor->texture, impostor->pixels);
+        } else {
+            Image image = {
+                .data = impostor->pixels,
+                .width = width,
+                .height = height,
+                .mipmaps = 1,
+                .format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8
+            };
+            impostor->texture = LoadTextureFromImage(image);
+            SetTextureFilter(impostor->texture, TEXTURE_FILTER_BILINEAR);
+            impostor->has_texture = true;
+            MemoryTrackExternal(MEMORY_TAG_GPU, (int64_t)width * height * 4);
+        }
+    }
+
+    impostor->content_hash = hash;
+    impostor->image_dirty = false;
+    return true;
+}
+
+bool GenerateFileImpostor(ecs_world_t *world, ecs_entity_t file_entity) {
+    FileImpostor *impostor = ecs_get_mut(world, file_entity, FileImpostor);
+    const ImpostorSettings *settings = ecs_singleton_get(world, ImpostorSettings);
+    if (!impostor || !settings) {
+        return false;
+    }
+
+    if (impostor->bounds_dirty) {
+        RefreshImpostorBounds(world, file_entity, impostor);
+    }
+    return BuildImpostor(world, file_entity, impostor, settings);
+}
+
+void AttachFileImpostor(ecs_world_t *world, ecs_entity_t file_entity) {
+    ecs_set(world, file_entity, FileImpostor, {
+        .bounds_dirty = true,
+        .image_dirty = true
+    });
+}
+
+// Collapse or expand file blocks based on their projected size
+void ImpostorLODSystem(ecs_iter_t *it) {
+    FileImpostor *impostors = ecs_field(it, FileImpostor, 0);
+
+    const ViewState *view = ecs_singleton_get(it->world, ViewState);
+    const ImpostorSettings *settings = ecs_singleton_get(it->world, ImpostorSettings);
+    if (!view || !settings || view->viewport_height <= 0.0f) {
+        return;
+    }
+
+    PROFILE_ZONE_BEGIN(ImpostorLODSystem);
+
+    // Pixels per world unit at distance 1
+    float focal_px = view->viewport_height * 0.5f / tanf(view->fovy * 0.5f * DEG2RAD);
+    int regenerated = 0;
+
+    for (int i = 0; i < it->count; i++) {
+        ecs_entity_t file_entity = it->entities[i];
+        FileImpostor *impostor = &impostors[i];
+
+        if (impostor->bounds_dirty) {
+            RefreshImpostorBounds(it->world, file_entity, impostor);
+        }
+
+        float distance = Vector3Distance(view->camera_position, impostor->center);
+        float projected_px = distance > 0.001f ?
+            (2.0f * impostor->radius) * focal_px / distance : FLT_MAX;
+
+        // Hidden-tier line count from the previous frame's TextLODSystem
+        impostor->block_lines = impostor->hidden_lines;
+        impostor->hidden_lines = 0;
+
+        bool active = ecs_has(it->world, file_entity, ImpostorActive);
+        if (!active && projected_px < settings->collapse_px) {
+            ecs_add(it->world, file_entity, ImpostorActive);
+            active = true;
+        } else if (active && projected_px > settings->expand_px) {
+            ecs_remove(it->world, file_entity, ImpostorActive);
+            active = false;
+        }
+
+        // Minimaps are only (re)built for files that are actually shown as a block
+        bool show_block = active || impostor->block_lines > 0;
+        if (show_block && impostor->image_dirty && regenerated < settings->max_regen_per_frame) {
+            BuildImpostor(it->world, file_entity, impostor, settings);
+            regenerated++;
+        }
+    }
+    PROFILE_ZONE_END(ImpostorLODSystem);
+}
+
+// Marks the parent file's impostor stale when a line phantom changes
+void OnImpostorSourceChanged(ecs_iter_t *it) {
+    for (int i = 0; i < it->count; i++) {
+        ecs_entity_t parent = ecs_get_target(it->world, it->entities[i], EcsChildOf, 0);
+        if (parent == 0) {
+            continue;
+        }
+
+        FileImpostor *impostor = ecs_get_mut(it->world, parent, FileImpostor);
+        if (!impostor) {
+            continue;
+        }
+
+        if (it->event_id == ecs_id(Position)) {
+            impostor->bounds_dirty = true;
+        } else {
+            impostor->image_dirty = true;
+        }
+    }
+}
+
+void DrawFileImpostors(ecs_world_t *world, Camera3D camera) {
+    ecs_iter_t it = ecs_each_id(world, ecs_id(FileImpostor));
+    while (ecs_each_next(&it)) {
+        FileImpostor *impostors = ecs_field(&it, FileImpostor, 0);
+        for (int i = 0; i < it.count; i++) {
+            const FileImpostor *impostor = &impostors[i];
+            if (impostor->block_lines == 0 && !ecs_has(world, it.entities[i], ImpostorActive)) {
+                continue;
+            }
+
+            if (impostor->has_texture) {
+                Rectangle source = {0, 0, (float)impostor->width, (float)impostor->height};
+                DrawBillboardRec(camera, impostor->texture, source, impostor->center,
+                                 impostor->extent, WHITE);
+            } else {
+                // Minimap not built yet (regeneration is budgeted per frame)
+                DrawCubeWires(impostor->center, impostor->extent.x, impostor->extent.y, 0.1f, DARKBLUE);
+            }
+        }
+    }
+}
+
+void RegisterImpostorSystems(ecs_world_t *world) {
+    ECS_COMPONENT_DEFINE(world, FileImpostor);
+    ECS_COMPONENT_DEFINE(world, ImpostorSettings);
+
+    ecs_set_hooks(world, FileImpostor, {
+        .move = FileImpostor_move,
+        .dtor = FileImpostor_dtor
+    });
+
+    ecs_singleton_set(world, ImpostorSettings, {
+        .collapse_px = 48.0f,
+        .expand_px = 64.0f,
+        .texture_width = 128,
+        .texture_height = 256,
+        .max_columns = 120,
+        .max_regen_per_frame = 2
+    });
+
+    // Registered after RegisterCoreSystems so it runs after ViewSystem
+    ECS_SYSTEM(world, ImpostorLODSystem, EcsOnUpdate, FileImpostor);
+
+    // Lazy regeneration triggers
+    ecs_observer_desc_t text_observer_desc = {0};
+    text_observer_desc.query.terms[0].id = ecs_id(TextContent);
+    text_observer_desc.events[0] = EcsOnSet;
+    text_observer_desc.callback = OnImpostorSourceChanged;
+    ecs_observer_init(world, &text_observer_desc);
+
+    ecs_observer_desc_t reload_observer_desc = {0};
+    reload_observer_desc.query.terms[0].id = NeedsReload;
+    reload_observer_desc.events[0] = EcsOnAdd;
+    reload_observer_desc.callback = OnImpostorSourceChanged;
+    ecs_observer_init(world, &reload_observer_desc);
+
+    ecs_observer_desc_t position_observer_desc = {0};
+    position_observer_desc.query.terms[0].id = ecs_id(Position);
+    position_observer_desc.events[0] = EcsOnSet;
+    position_observer_desc.callback = OnImpostorSourceChanged;
+    ecs_observer_init(world, &position_observer_desc);
+}
@@ -0,0 +1,74 @@
+#ifndef IMPOSTOR_H
+#define IMPOSTOR_H
+
+#include <flecs.h>
+#include "../components/spatial.h"
+
+// Far-field impostor for a file container. When the projected size of the
+// file falls below ImpostorSettings.collapse_px the whole subtree is replaced
+// by a single minimap texture (ImpostorActive tag on the file entity).
+typedef struct {
+    // World-space bounds of the file block (container + line phantoms)
+    Vector3 center;
+    Vector2 extent;         // Width/height of the block in world units
+    float radius;
+
+    // Cached minimap, RGBA8 (CPU side is always kept for headless use)
+    uint8_t *pixels;
+    int width, height;
+    uint32_t content_hash;  // Hash of the text the minimap was built from
+
+    Texture2D texture;
+    bool has_texture;
+
+    // Line phantoms in the hidden text LOD tier. TextLODSystem accumulates
+    // hidden_lines; ImpostorLODSystem latches it into block_lines each frame.
+    int hidden_lines;
+    int block_lines;
+
+    bool bounds_dirty;      // Children moved/added, recompute bounds
+    bool image_dirty;       // Text changed, regenerate minimap lazily
+} FileImpostor;
+
+typedef struct {
+    float collapse_px;       // Collapse when projected height drops below this
+    float expand_px;         // Expand again when projected height exceeds this
+    int texture_width;
+    int texture_height;
+    int max_columns;         // Source columns mapped to the texture width
+    int max_regen_per_frame; // Bound on minimap rebuilds per frame
+} ImpostorSettings;
+
+// Source line for the CPU minimap rasterizer
+typedef struct {
+    const char *text;
+    int line_number;
+    Color color;
+} ImpostorLine;
+
+extern ECS_COMPONENT_DECLARE(FileImpostor);
+extern ECS_COMPONENT_DECLARE(ImpostorSettings);
+
+// CPU rasterizer: draws lines as minimap strokes into an RGBA8 buffer.
+// Does not touch raylib's GL state, so it can run headless.
+void RasterizeFileMinimap(const ImpostorLine *lines, int line_count, int total_lines,
+                          int max_columns, uint8_t *rgba, int width, int height);
+
+// Build or rebuild the impostor for a file container. Uploads to the GPU
+// only when a window (GL context) exists.
+bool GenerateFileImpostor(ecs_world_t *world, ecs_entity_t file_entity);
+
+// Attach impostor bookkeeping to a file container entity
+void AttachFileImpostor(ecs_world_t *world, ecs_entity_t file_entity);
+
+// Draw collapsed files and file blocks behind hidden lines
+// (call between BeginMode3D/EndMode3D)
+void DrawFileImpostors(ecs_world_t *world, Camera3D camera);
+
+// Systems
+void ImpostorLODSystem(ecs_iter_t *it);
+void OnImpostorSourceChanged(ecs_iter_t *it);
+
+void RegisterImpostorSystems(ecs_world_t *world);
+
+#endif // IMPOSTOR_H
@@ -0,0 +1,560 @@
+#define _POSIX_C_SOURCE 200809L  // access
+#include "include_graph.h"
+#include "worker_pool.h"
+#include "layout.h"
+#include "lexer.h"
+#include "memory_tracker.h"
+#include "syntax.h"
+#include "profiler.h"
+#include "string_table.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+ECS_COMPONENT_DECLARE(IncludeHeader);
+ECS_COMPONENT_DECLARE(IncludeSettings);
+ECS_COMPONENT_DECLARE(IncludeStats);
+
+#define INCLUDE_SOURCE_CHUNK 16     // Sources per scan job
+#define INCLUDE_REQUEST_CHUNK 64    // Requests per resolve job
+#define INCLUDE_RESOLVED_RELATIVE 0 // Request resolution: next to the includer
+#define INCLUDE_UNRESOLVED -1       // Otherwise 1 + index of the include path
+
+// One #include line: the name is a span of the source text
+typedef struct {
+    int32_t source;
+    uint32_t name_offset;
+    uint16_t name_length;
+    uint8_t angled;
+    int32_t request;
+} IncludeDirective;
+
+typedef struct {
+    IncludeDirective *items;
+    int count;
+    int capacity;
+} DirectiveList;
+
+// Headers persist across scans so rescans reuse their entities
+typedef struct {
+    StringTable headers;      // Resolved path (or spelling) -> header
+    ecs_entity_t *entities;
+    int entity_capacity;
+    JobPool *pool;
+} IncludeGraph;
+
+// The graph belongs to the world that registered the module; API calls
+// find it through this singleton
+typedef struct {
+    IncludeGraph *graph;
+} IncludeModule;
+
+static ECS_COMPONENT_DECLARE(IncludeModule);
+
+static IncludeGraph *GetGraph(const ecs_world_t *world) {
+    const IncludeModule *module = ecs_singleton_get(world, IncludeModule);
+    return module ? module->graph : NULL;
+}
+
+// Paths
+
+// Joins dir and name and removes "." and "dir/.." segments. Returns the
+// length written to out, 0 if it does not fit.
+static size_t NormalizePath(const char *dir, size_t dir_length, const char *name, size_t name_length,
+                            char *out, size_t out_size) {
+    char joined[2 * INCLUDE_MAX_PATH];
+    if (dir_length + name_length + 2 > sizeof(joined)) {
+        return 0;
+    }
+    size_t length = 0;
+    if (name_length == 0 || name[0] != '/') {
+        memcpy(joined, dir, dir_length);
+        length = dir_length;
+        if (length > 0 && joined[length - 1] != '/') {
+            joined[length++] = '/';
+        }
+    }
+    memcpy(joined + length, name, name_length);
+    length += name_length;
+
+    size_t written = 0;
+    bool absolute = length > 0 && joined[0] == '/';
+    if (absolute) {
+        out[written++] = '/';
+    }
+    size_t root = written;
+    size_t i = 0;
+    while (i < length) {
+        while (i < length && joined[i] == '/') {
+            i++;
+        }
+        size_t start = i;
+        while (i < length && joined[i] != '/') {
+            i++;
+        }
+        size_t segment = i - start;
+        if (segment == 0 || (segment == 1 && joined[start] == '.')) {
+            continue;
+        }
+        if (segment == 2 && joined[start] == '.' && joined[start + 1] == '.') {
+            // Drop the previous segment unless there is none (or it is "..")
+            size_t last = written;
+            while (last > root && out[last - 1] != '/') {
+                last--;
+            }
+            bool parent = written - last == 2 && out[last] == '.' && out[last + 1] == '.';
+            if (written > root && !parent) {
+                written = last > root ? last - 1 : root;
+                continue;
+            }
+            if (absolute) {
+                continue;  // "/.." is "/"
+            }
+        }
+        if (written + (written > root ? 1 : 0) + segment + 1 > out_size) {
+            return 0;
+        }
+        if (written > root) {
+            out[written++] = '/';
+        }
+        memcpy(out + written, joined + start, segment);
+        written += segment;
+    }
+    out[written] = '\0';
+    return written;
+}
+
+static size_t DirectoryLength(const char *path) {
+    const char *slash = strrchr(path, '/');
+    return slash ? (size_t)(slash - path) + 1 : 0;
+}
+
+// Directive extraction
+
+static inline const char *SkipBlanks(const char *p, const char *end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    return p;
+}
+
+static void PushDirective(DirectiveList *list, const IncludeDirective *directive) {
+    if (GrowArray(MEMORY_TAG_INDEX, (void**)&list->items, &list->capacity, list->count + 1, sizeof(IncludeDirective))) {
+        list->items[list->count++] = *directive;
+    }
+}
+
+// '#' as the first non-blank of a line, then include/include_next/import
+static void ExtractDirectives(const IncludeSource *source, int source_index, DirectiveList *out) {
+    const char *text = source->text;
+    const char *p = text;
+    const char *end = text + source->length;
+    int line = 0;
+
+    while (p < end) {
+        const char *newline = memchr(p, '\n', (size_t)(end - p));
+        const char *line_end = newline ? newline : end;
+        bool commented = source->line_state && line < source->line_count &&
+                         (source->line_state[line] & LEX_STATE_MODE_MASK) != LEX_STATE_CODE;
+        const char *c = SkipBlanks(p, line_end);
+
+        if (!commented && c < line_end && *c == '#') {
+            c = SkipBlanks(c + 1, line_end);
+            size_t word = 0;
+            while (c + word < line_end && ((c[word] >= 'a' && c[word] <= 'z') || c[word] == '_')) {
+                word++;
+            }
+            bool include = (word == 7 && memcmp(c, "include", 7) == 0) ||
+                           (word == 12 && memcmp(c, "include_next", 12) == 0) ||
+                           (word == 6 && memcmp(c, "import", 6) == 0);
+            if (include) {
+                c = SkipBlanks(c + word, line_end);
+                char close = c < line_end && *c == '<' ? '>' : (c < line_end && *c == '"' ? '"' : 0);
+                const char *name = c + 1;
+                const char *name_end = close ? memchr(name, close, (size_t)(line_end - name)) : NULL;
+                size_t name_length = name_end ? (size_t)(name_end - name) : 0;
+                if (name_length > 0 && name_length < INCLUDE_MAX_PATH) {
+                    IncludeDirective directive = {
+                        .source = source_index,
+                        .name_offset = (uint32_t)(name - text),
+                        .name_length = (uint16_t)name_length,
+                        .angled = close == '>',
+                        .request = -1
+                    };
+                    PushDirective(out, &directive);
+                }
+            }
+        }
+        line++;
+        p = newline ? newline + 1 : end;
+    }
+}
+
+// Scan state shared with the jobs
+
+typedef struct {
+    const IncludeSource *sources;
+    DirectiveList *chunk_directives;  // One list per chunk, merged in chunk order
+
+    // Distinct requests: key "<name" or "dir\"name"
+    StringTable requests;
+    int32_t *request_directive;       // First directive of each request
+    int request_capacity;
+    int8_t *request_result;           // INCLUDE_UNRESOLVED, RELATIVE or 1 + path
+
+    StringTable known;                // Normalized source paths -> source index
+    const IncludeSettings *settings;
+    IncludeDirective *directives;
+    int directive_count;
+} IncludeScan;
+
+static void ScanJob(void *ctx, int chunk, int begin, int end) {
+    IncludeScan *scan = ctx;
+    for (int i = begin; i < end; i++) {
+        ExtractDirectives(&scan->sources[i], i, &scan->chunk_directives[chunk]);
+    }
+}
+
+// Candidate path of a request; 0 if it does not fit
+static size_t RequestCandidate(const IncludeScan *scan, const IncludeDirective *directive, int candidate,
+                               char *out, size_t out_size) {
+    const IncludeSource *source = &scan->sources[directive->source];
+    const char *name = source->text + directive->name_offset;
+    if (candidate == INCLUDE_RESOLVED_RELATIVE) {
+        return NormalizePath(source->path, DirectoryLength(source->path), name, directive->name_length,
+                             out, out_size);
+    }
+    const char *dir = scan->settings->paths[candidate - 1];
+    return NormalizePath(dir, strlen(dir), name, directive->name_length, out, out_size);
+}
+
+static bool CandidateExists(const IncludeScan *scan, const char *path, size_t length) {
+    if (StringTableFind(&scan->known, path, length) >= 0) {
+        return true;
+    }
+    return scan->settings->check_filesystem && access(path, F_OK) == 0;
+}
+
+// Requests only read the source texts, the known-path table and the
+// settings, and each writes its own result
+static void ResolveJob(void *ctx, int chunk, int begin, int end) {
+    (void)chunk;
+    IncludeScan *scan = ctx;
+    char path[INCLUDE_MAX_PATH];
+    for (int r = begin; r < end; r++) {
+        const IncludeDirective *directive = &scan->directives[scan->request_directive[r]];
+        int8_t result = INCLUDE_UNRESOLVED;
+        int first = directive->angled ? 1 : INCLUDE_RESOLVED_RELATIVE;
+        for (int candidate = first; candidate <= scan->settings->path_count; candidate++) {
+            size_t length = RequestCandidate(scan, directive, candidate, path, sizeof(path));
+            if (length > 0 && CandidateExists(scan, path, length)) {
+                result = (int8_t)candidate;
+                break;
+            }
+        }
+        scan->request_result[r] = result;
+    }
+}
+
+static const char *BaseName(const char *path) {
+    const char *slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+// Header entities sit on a ring above the files until the layout moves them
+static ecs_entity_t CreateHeaderEntity(ecs_world_t *world, const char *key, bool resolved, int index) {
+    float angle = index * 2.39996f;  // Golden angle
+    float radius = 20.0f + 2.0f * sqrtf((float)index);
+
+    ecs_entity_t header = ecs_new(world);
+    ecs_set(world, header, Position, {cosf(angle) * radius, 10.0f, sinf(angle) * radius});
+    ecs_set(world, header, Rotation, {0.0f, 0.0f, 0.0f, 1.0f});
+    ecs_set(world, header, Scale, {1.0f, 1.0f, 1.0f});
+    ecs_set(world, header, EcsTransform, {.needs_update = true});
+    ecs_set(world, header, IncludeHeader, {resolved});
+
+    TextContent label = {.font_size = 1.0f, .color = resolved ? PURPLE : GRAY, .billboard_mode = false};
+    strncpy(label.text, BaseName(key), sizeof(label.text) - 1);
+    ecs_set_ptr(world, header, TextContent, &label);
+
+    FileReference file_ref = {.line_number = 0, .last_modified = time(NULL)};
+    strncpy(file_ref.filepath, key, sizeof(file_ref.filepath) - 1);
+    ecs_set_ptr(world, header, FileReference, &file_ref);
+
+    AttachLayoutNode(world, header, 0.0f);
+    return header;
+}
+
+// Entity for a request: a scanned source, a known header or a new one
+static ecs_entity_t RequestTarget(ecs_world_t *world, IncludeGraph *graph, IncludeScan *scan, int request, IncludeStats *stats) {
+    const IncludeDirective *directive = &scan->directives[scan->request_directive[request]];
+    int8_t result = scan->request_result[request];
+    char key[INCLUDE_MAX_PATH];
+    size_t length;
+    if (result != INCLUDE_UNRESOLVED) {
+        length = RequestCandidate(scan, directive, result, key, sizeof(key));
+        int known = StringTableFind(&scan->known, key, length);
+        if (known >= 0) {
+            return scan->sources[known].file;
+        }
+    } else {
+        // Unresolved headers are identified by their spelling
+        length = directive->name_length;
+        memcpy(key, scan->sources[directive->source].text + directive->name_offset, length);
+        key[length] = '\0';
+    }
+
+    bool inserted;
+    int header = StringTableInsert(&graph->headers, key, length, &inserted);
+    if (header < 0 || !GrowArray(MEMORY_TAG_INDEX, (void**)&graph->entities, &graph->entity_capacity, header + 1,
+                                 sizeof(ecs_entity_t))) {
+        return 0;
+    }
+    if (inserted || !ecs_is_alive(world, graph->entities[header])) {
+        graph->entities[header] = CreateHeaderEntity(world, key, result != INCLUDE_UNRESOLVED, header);
+        stats->headers_created++;
+    }
+    return graph->entities[header];
+}
+
+static void FreeScan(IncludeScan *scan, int chunk_count) {
+    for (int c = 0; c < chunk_count; c++) {
+        TrackedFree(MEMORY_TAG_INDEX, scan->chunk_directives[c].items);
+    }
+    TrackedFree(MEMORY_TAG_INDEX, scan->chunk_directives);
+    TrackedFree(MEMORY_TAG_INDEX, scan->directives);
+    TrackedFree(MEMORY_TAG_INDEX, scan->request_directive);
+    TrackedFree(MEMORY_TAG_INDEX, scan->request_result);
+    StringTableFree(&scan->requests);
+    StringTableFree(&scan->known);
+}
+
+int ScanIncludes(ecs_world_t *world, const IncludeSource *sources, int count) {
+    const IncludeSettings *settings = ecs_singleton_get(world, IncludeSettings);
+    IncludeGraph *graph = GetGraph(world);
+    if (!settings || !graph || count <= 0) {
+        return 0;
+    }
+
+    PROFILE_ZONE_BEGIN(ScanIncludes);
+    IncludeStats stats = {.sources = count, .threads = JobPoolWorkerCount(graph->pool) + 1};
+    IncludeScan scan = {.sources = sources, .settings = settings};
+    int chunk_count = JobPoolChunkCount(count, INCLUDE_SOURCE_CHUNK);
+    scan.chunk_directives = TrackedCalloc(MEMORY_TAG_INDEX, (size_t)chunk_count, sizeof(DirectiveList));
+    if (!scan.chunk_directives) {
+        PROFILE_ZONE_END(ScanIncludes);
+        return 0;
+    }
+
+    // 1. Directives of every source, in parallel
+    uint64_t start = ProfilerNow();
+    JobPoolParallelFor(graph->pool, count, INCLUDE_SOURCE_CHUNK, ScanJob, &scan);
+    int total = 0;
+    for (int c = 0; c < chunk_count; c++) {
+        total += scan.chunk_directives[c].count;
+    }
+    int directive_capacity = 0;
+    GrowArray(MEMORY_TAG_INDEX, (void**)&scan.directives, &directive_capacity, total > 0 ? total : 1,
+              sizeof(IncludeDirective));
+    for (int c = 0; c < chunk_count && scan.directives; c++) {
+        memcpy(scan.directives + scan.directive_count, scan.chunk_directives[c].items,
+               sizeof(IncludeDirective) * scan.chunk_directives[c].count);
+        scan.directive_count += scan.chunk_directives[c].count;
+    }
+    stats.directives = scan.directive_count;
+    stats.scan_ms = (double)(ProfilerNow() - start) / 1e6;
+
+    // 2. Distinct requests, resolved in parallel against the sources and disk
+    start = ProfilerNow();
+    char path[INCLUDE_MAX_PATH];
+    bool inserted;
+    for (int i = 0; i < count; i++) {
+        size_t length = NormalizePath("", 0, sources[i].path, strlen(sources[i].path), path, sizeof(path));
+        if (length > 0) {
+            StringTableInsert(&scan.known, path, length, &inserted);
+        }
+    }
+    char key[2 * INCLUDE_MAX_PATH];
+    for (int d = 0; d < scan.directive_count; d++) {
+        IncludeDirective *directive = &scan.directives[d];
+        const IncludeSource *source = &sources[directive->source];
+        size_t dir_length = directive->angled ? 0 : DirectoryLength(source->path);
+        size_t length = 0;
+        if (directive->angled) {
+            key[length++] = '<';
+        } else {
+            memcpy(key, source->path, dir_length);
+            length = dir_length;
+            key[length++] = '"';
+        }
+        memcpy(key + length, source->text + directive->name_offset, directive->name_length);
+        length += directive->name_length;
+
+        directive->request = StringTableInsert(&scan.requests, key, length, &inserted);
+        if (inserted && GrowArray(MEMORY_TAG_INDEX, (void**)&scan.request_directive, &scan.request_capacity,
+                                  scan.requests.count, sizeof(int32_t))) {
+            scan.request_directive[directive->request] = d;
+        }
+    }
+    stats.requests = scan.requests.count;
+    scan.request_result = TrackedMalloc(MEMORY_TAG_INDEX, scan.requests.count > 0 ? (size_t)scan.requests.count : 1);
+    if (scan.request_result && scan.requests.count > 0) {
+        JobPoolParallelFor(graph->pool, scan.requests.count, INCLUDE_REQUEST_CHUNK, ResolveJob, &scan);
+    }
+    stats.resolve_ms = (double)(ProfilerNow() - start) / 1e6;
+
+    // 3. Targets, then every pair in one deferred batch
+    start = ProfilerNow();
+    ecs_entity_t *targets = TrackedCalloc(MEMORY_TAG_INDEX, scan.requests.count > 0 ? (size_t)scan.requests.count : 1,
+                                          sizeof(ecs_entity_t));
+    if (targets && scan.request_result) {
+        for (int r = 0; r < scan.requests.count; r++) {
+            targets[r] = RequestTarget(world, graph, &scan, r, &stats);
+        }
+    }
+
+    ecs_defer_begin(world);
+    int d = 0;
+    for (int i = 0; i < count; i++) {
+        ecs_remove_pair(world, sources[i].file, Includes, EcsWildcard);
+        int first_edge = d;
+        for (; d < scan.directive_count && scan.directives[d].source == i; d++) {
+            int request = scan.directives[d].request;
+            ecs_entity_t target = targets && request >= 0 ? targets[request] : 0;
+            if (request < 0 || !scan.request_result || scan.request_result[request] == INCLUDE_UNRESOLVED) {
+                stats.unresolved++;
+            } else {
+                stats.resolved++;
+            }
+            if (!target || target == sources[i].file) {
+                continue;
+            }
+            // A file that includes the same target twice gets one pair
+            bool duplicate = false;
+            for (int e = first_edge; e < d && !duplicate; e++) {
+                int other = scan.directives[e].request;
+                duplicate = other >= 0 && targets[other] == target;
+            }
+            if (!duplicate) {
+                ecs_add_pair(world, sources[i].file, Includes, target);
+                stats.edges++;
+            }
+        }
+    }
+    ecs_defer_end(world);
+    stats.headers = graph->headers.count;
+    stats.apply_ms = (double)(ProfilerNow() - start) / 1e6;
+
+    TrackedFree(MEMORY_TAG_INDEX, targets);
+    FreeScan(&scan, chunk_count);
+    ecs_singleton_set_ptr(world, IncludeStats, &stats);
+    PROFILE_ZONE_END(ScanIncludes);
+    return stats.edges;
+}
+
+int ScanProjectIncludes(ecs_world_t *world) {
+    ecs_query_t *query = ecs_query(world, {
+        .terms = {
+            { ecs_id(FileSyntax), .inout = EcsIn },
+            { ecs_id(FileReference), .inout = EcsIn, .oper = EcsOptional }
+        }
+    });
+
+    IncludeSource *sources = NULL;
+    int source_count = 0;
+    int source_capacity = 0;
+    ecs_iter_t it = ecs_query_iter(world, query);
+    while (ecs_query_next(&it)) {
+        const FileSyntax *syntax = ecs_field(&it, FileSyntax, 0);
+        const FileReference *refs = ecs_field(&it, FileReference, 1);
+        for (int i = 0; i < it.count; i++) {
+            size_t length;
+            const char *text = GetFileSyntaxText(world, &syntax[i], &length);
+            const TokenBuffer *tokens = GetFileSyntax(world, &syntax[i]);
+            // In-memory example files have no FileReference, only a name
+            const char *path = refs ? refs[i].filepath : ecs_get_name(world, it.entities[i]);
+            if (!text || !path ||
+                !GrowArray(MEMORY_TAG_INDEX, (void**)&sources, &source_capacity, source_count + 1,
+                           sizeof(IncludeSource))) {
+                continue;
+            }
+            sources[source_count++] = (IncludeSource){
+                .file = it.entities[i],
+                .path = path,
+                .text = text,
+                .length = length,
+                .line_state = tokens ? tokens->line_state : NULL,
+                .line_count = tokens ? tokens->line_count : 0
+            };
+        }
+    }
+
+    int edges = ScanIncludes(world, sources, source_count);
+    TrackedFree(MEMORY_TAG_INDEX, sources);
+    ecs_query_fini(query);
+    return edges;
+}
+
+ecs_entity_t FindIncludeHeader(ecs_world_t *world, const char *name) {
+    IncludeGraph *graph = GetGraph(world);
+    if (!graph) {
+        return 0;
+    }
+    size_t name_length = strlen(name);
+    for (int h = 0; h < graph->headers.count; h++) {
+        const char *key = StringTableKey(&graph->headers, h);
+        size_t length = graph->headers.key_length[h];
+        bool match = length == name_length ? memcmp(key, name, length) == 0
+                   : length > name_length && key[length - name_length - 1] == '/' &&
+                     memcmp(key + length - name_length, name, name_length) == 0;
+        if (match && ecs_is_alive(world, graph->entities[h])) {
+            return graph->entities[h];
+        }
+    }
+    return 0;
+}
+
+bool AddIncludePath(ecs_world_t *world, const char *path) {
+    IncludeSettings *settings = ecs_singleton_get_mut(world, IncludeSettings);
+    if (!settings || settings->path_count >= INCLUDE_MAX_PATHS || strlen(path) >= INCLUDE_MAX_PATH) {
+        printf("IncludeGraph: cannot add include path %s\n", path);
+        return false;
+    }
+    strcpy(settings->paths[settings->path_count++], path);
+    return true;
+}
+
+static void IncludeGraphFini(ecs_world_t *world, void *ctx) {
+    IncludeGraph *graph = ctx;
+    WorkerPoolRelease(world);
+    StringTableFree(&graph->headers);
+    TrackedFree(MEMORY_TAG_INDEX, graph->entities);
+    TrackedFree(MEMORY_TAG_INDEX, graph);
+}
+
+void RegisterIncludeGraph(ecs_world_t *world) {
+    ECS_COMPONENT_DEFINE(world, IncludeHeader);
+    ECS_COMPONENT_DEFINE(world, IncludeSettings);
+    ECS_COMPONENT_DEFINE(world, IncludeStats);
+    ECS_COMPONENT_DEFINE(world, IncludeModule);
+
+    IncludeSettings settings = {
+        .check_filesystem = true,
+        .path_count = 2,
+        .paths = {"/usr/local/include", "/usr/include"}
+    };
+    ecs_singleton_set_ptr(world, IncludeSettings, &settings);
+    ecs_singleton_set(world, IncludeStats, {0});
+
+    IncludeGraph *graph = TrackedCalloc(MEMORY_TAG_INDEX, 1, sizeof(IncludeGraph));
+    if (!graph) {
+        printf("IncludeGraph: out of memory\n");
+        return;
+    }
+    graph->pool = WorkerPoolAcquire(world);
+    ecs_singleton_set(world, IncludeModule, {graph});
+    ecs_atfini(world, IncludeGraphFini, graph);
+}
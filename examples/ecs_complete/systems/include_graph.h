@@ -0,0 +1,77 @@
+#ifndef INCLUDE_GRAPH_H
+#define INCLUDE_GRAPH_H
+
+#include <flecs.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../components/spatial.h"
+
+// Include-graph extraction: (Includes, header) pairs from #include lines.
+//
+// Sources are scanned in parallel on the include job pool. Each distinct
+// (directory, name) request is resolved once: quoted names first relative
+// to the including file, then against the include paths in order; angle
+// names only against the include paths. A candidate exists if it is one of
+// the scanned sources or, when enabled, a file on disk. Headers are
+// deduplicated by resolved path (or by spelling if unresolved) across
+// scans, and all pairs are added in one deferred batch.
+
+#define INCLUDE_MAX_PATHS 8
+#define INCLUDE_MAX_PATH 256
+
+// Header entity created for an included file that is not a scanned source
+typedef struct {
+    bool resolved;            // False if no include path contained it
+} IncludeHeader;
+
+typedef struct {
+    bool check_filesystem;    // Resolve against files on disk, not only scanned sources
+    int path_count;
+    char paths[INCLUDE_MAX_PATHS][INCLUDE_MAX_PATH];  // Searched in order
+} IncludeSettings;
+
+// Results of the last scan
+typedef struct {
+    int32_t sources;
+    int32_t threads;          // Scanner threads including the caller
+    int32_t directives;       // #include lines found
+    int32_t requests;         // Distinct (directory, name) pairs resolved
+    int32_t resolved;         // Directives that resolved to a file
+    int32_t unresolved;
+    int32_t headers;          // Distinct include targets
+    int32_t headers_created;  // New header entities
+    int32_t edges;            // (Includes, target) pairs added
+    double scan_ms;           // Parallel directive extraction
+    double resolve_ms;        // Parallel path resolution
+    double apply_ms;          // Header entities and deferred pair batch
+} IncludeStats;
+
+// One file to scan
+typedef struct {
+    ecs_entity_t file;        // Entity that gets the (Includes, header) pairs
+    const char *path;         // Path of the file, for quoted includes
+    const char *text;
+    size_t length;
+    const uint8_t *line_state;  // Optional lexer checkpoints, skips commented lines
+    int line_count;
+} IncludeSource;
+
+extern ECS_COMPONENT_DECLARE(IncludeHeader);
+extern ECS_COMPONENT_DECLARE(IncludeSettings);
+extern ECS_COMPONENT_DECLARE(IncludeStats);
+
+// Append a directory to the include search path; false if the list is full
+bool AddIncludePath(ecs_world_t *world, const char *path);
+
+// Scan sources and replace their Includes pairs. Returns the pairs added.
+int ScanIncludes(ecs_world_t *world, const IncludeSource *sources, int count);
+
+// Scan every loaded file container with lexed text (see syntax.h)
+int ScanProjectIncludes(ecs_world_t *world);
+
+// Target entity of an include spelled name (e.g. "stdio.h"), 0 if none
+ecs_entity_t FindIncludeHeader(ecs_world_t *world, const char *name);
+
+void RegisterIncludeGraph(ecs_world_t *world);
+
+#endif // INCLUDE_GRAPH_H
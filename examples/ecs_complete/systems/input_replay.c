@@ -0,0 +1,289 @@
+#include "input_replay.h"
+#include "text_lod.h"
+#include <string.h>
+
+static const char input_log_magic[4] = {'P', 'V', 'I', 'R'};
+
+// Explicit little-endian encoding keeps logs portable across hosts
+static void PutU16(uint8_t *out, uint16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void PutU32(uint8_t *out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out[i] = (uint8_t)(value >> (i * 8));
+    }
+}
+
+static void PutU64(uint8_t *out, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        out[i] = (uint8_t)(value >> (i * 8));
+    }
+}
+
+static void PutF32(uint8_t *out, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    PutU32(out, bits);
+}
+
+static uint16_t GetU16(const uint8_t *in) {
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static uint32_t GetU32(const uint8_t *in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= (uint32_t)in[i] << (i * 8);
+    }
+    return value;
+}
+
+static uint64_t GetU64(const uint8_t *in) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value |= (uint64_t)in[i] << (i * 8);
+    }
+    return value;
+}
+
+static float GetF32(const uint8_t *in) {
+    uint32_t bits = GetU32(in);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void EncodeHeader(uint8_t *out, const InputLogHeader *header) {
+    memcpy(out, input_log_magic, 4);
+    PutU32(out + 4, INPUT_LOG_VERSION);
+    PutF32(out + 8, header->fixed_dt);
+    PutU32(out + 12, header->files);
+    PutU32(out + 16, header->lines);
+    PutU32(out + 20, header->frame_count);
+}
+
+#define INPUT_LOG_HEADER_SIZE 24
+#define INPUT_LOG_FRAME_COUNT_OFFSET 20
+
+bool InputRecorderOpen(InputRecorder *recorder, const char *path, const InputLogHeader *header) {
+    memset(recorder, 0, sizeof(*recorder));
+    recorder->file = fopen(path, "wb");
+    if (!recorder->file) {
+        printf("Failed to open input log for writing: %s\n", path);
+        return false;
+    }
+
+    recorder->header = *header;
+    recorder->header.frame_count = 0;  // Patched on close
+
+    uint8_t bytes[INPUT_LOG_HEADER_SIZE];
+    EncodeHeader(bytes, &recorder->header);
+    if (fwrite(bytes, 1, sizeof(bytes), recorder->file) != sizeof(bytes)) {
+        printf("Failed to write input log header: %s\n", path);
+        fclose(recorder->file);
+        recorder->file = NULL;
+        return false;
+    }
+    return true;
+}
+
+bool InputRecorderWrite(InputRecorder *recorder, const InputFrame *frame, uint64_t state_hash) {
+    if (!recorder->file) {
+        return false;
+    }
+
+    uint8_t bytes[INPUT_LOG_FRAME_SIZE];
+    bytes[0] = (uint8_t)((frame->left_down ? INPUT_LOG_LEFT_DOWN : 0) |
+                         (frame->right_down ? INPUT_LOG_RIGHT_DOWN : 0) |
+                         (frame->left_pressed ? INPUT_LOG_LEFT_PRESSED : 0) |
+                         (frame->tab_pressed ? INPUT_LOG_TAB_PRESSED : 0) |
+                         (frame->box_select_pressed ? INPUT_LOG_BOX_SELECT : 0) |
+                         (frame->sphere_select_pressed ? INPUT_LOG_SPHERE_SELECT : 0) |
+                         (frame->backspace_pressed ? INPUT_LOG_BACKSPACE : 0) |
+                         (frame->undo_pressed ? INPUT_LOG_UNDO : 0));
+    PutF32(bytes + 1, frame->mouse_position.x);
+    PutF32(bytes + 5, frame->mouse_position.y);
+    PutF32(bytes + 9, frame->mouse_delta.x);
+    PutF32(bytes + 13, frame->mouse_delta.y);
+    PutF32(bytes + 17, frame->wheel);
+    PutU16(bytes + 21, (uint16_t)frame->screen_width);
+    PutU16(bytes + 23, (uint16_t)frame->screen_height);
+    bytes[25] = (frame->typed_char >= 32 && frame->typed_char < 127) ? (uint8_t)frame->typed_char : 0;
+    bytes[26] = (uint8_t)(frame->redo_pressed ? INPUT_LOG_REDO : 0);
+    PutU64(bytes + 27, state_hash);
+
+    if (fwrite(bytes, 1, sizeof(bytes), recorder->file) != sizeof(bytes)) {
+        return false;
+    }
+    recorder->frames_written++;
+    return true;
+}
+
+void InputRecorderClose(InputRecorder *recorder) {
+    if (!recorder->file) {
+        return;
+    }
+
+    // Patch the frame count so readers can preallocate
+    uint8_t count[4];
+    PutU32(count, recorder->frames_written);
+    if (fseek(recorder->file, INPUT_LOG_FRAME_COUNT_OFFSET, SEEK_SET) == 0) {
+        fwrite(count, 1, sizeof(count), recorder->file);
+    }
+    fclose(recorder->file);
+    recorder->file = NULL;
+    printf("Recorded %u input frames\n", recorder->frames_written);
+}
+
+bool InputReplayOpen(InputReplay *replay, const char *path) {
+    memset(replay, 0, sizeof(*replay));
+    replay->file = fopen(path, "rb");
+    if (!replay->file) {
+        printf("Failed to open input log: %s\n", path);
+        return false;
+    }
+
+    uint8_t bytes[INPUT_LOG_HEADER_SIZE];
+    if (fread(bytes, 1, sizeof(bytes), replay->file) != sizeof(bytes) ||
+        memcmp(bytes, input_log_magic, 4) != 0 || GetU32(bytes + 4) != INPUT_LOG_VERSION) {
+        printf("Not a version %d input log: %s\n", INPUT_LOG_VERSION, path);
+        fclose(replay->file);
+        replay->file = NULL;
+        return false;
+    }
+
+    replay->header.fixed_dt = GetF32(bytes + 8);
+    replay->header.files = GetU32(bytes + 12);
+    replay->header.lines = GetU32(bytes + 16);
+    replay->header.frame_count = GetU32(bytes + 20);
+    return true;
+}
+
+bool InputReplayNext(InputReplay *replay, InputFrame *frame, uint64_t *expected_hash) {
+    if (!replay->file) {
+        return false;
+    }
+
+    uint8_t bytes[INPUT_LOG_FRAME_SIZE];
+    if (fread(bytes, 1, sizeof(bytes), replay->file) != sizeof(bytes)) {
+        return false;  // End of log (a truncated last frame is ignored)
+    }
+
+    memset(frame, 0, sizeof(*frame));
+    frame->left_down = (bytes[0] & INPUT_LOG_LEFT_DOWN) != 0;
+    frame->right_down = (bytes[0] & INPUT_LOG_RIGHT_DOWN) != 0;
+    frame->left_pressed = (bytes[0] & INPUT_LOG_LEFT_PRESSED) != 0;
+    frame->tab_pressed = (bytes[0] & INPUT_LOG_TAB_PRESSED) != 0;
+    frame->box_select_pressed = (bytes[0] & INPUT_LOG_BOX_SELECT) != 0;
+    frame->sphere_select_pressed = (bytes[0] & INPUT_LOG_SPHERE_SELECT) != 0;
+    frame->backspace_pressed = (bytes[0] & INPUT_LOG_BACKSPACE) != 0;
+    frame->undo_pressed = (bytes[0] & INPUT_LOG_UNDO) != 0;
+    frame->mouse_position = (Vector2){GetF32(bytes + 1), GetF32(bytes + 5)};
+    frame->mouse_delta = (Vector2){GetF32(bytes + 9), GetF32(bytes + 13)};
+    frame->wheel = GetF32(bytes + 17);
+    frame->screen_width = GetU16(bytes + 21);
+    frame->screen_height = GetU16(bytes + 23);
+    frame->typed_char = bytes[25] >= 32 ? bytes[25] : 0;
+    frame->redo_pressed = (bytes[26] & INPUT_LOG_REDO) != 0;
+    if (expected_hash) {
+        *expected_hash = GetU64(bytes + 27);
+    }
+
+    replay->frame_index++;
+    return true;
+}
+
+bool InputReplayVerify(InputReplay *replay, uint64_t expected_hash, uint64_t actual_hash) {
+    if (expected_hash == actual_hash) {
+        return true;
+    }
+    if (replay->mismatches == 0) {
+        replay->first_mismatch = replay->frame_index - 1;
+        printf("Replay diverged at frame %u: expected %016llx, got %016llx\n",
+               replay->first_mismatch, (unsigned long long)expected_hash,
+               (unsigned long long)actual_hash);
+    }
+    replay->mismatches++;
+    return false;
+}
+
+void InputReplayClose(InputReplay *replay) {
+    if (replay->file) {
+        fclose(replay->file);
+        replay->file = NULL;
+    }
+}
+
+// splitmix64 finalizer: cheap, well-distributed 64-bit mixing
+static uint64_t Mix64(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ull;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebull;
+    value ^= value >> 31;
+    return value;
+}
+
+static uint64_t HashBytes(uint64_t seed, const void *data, size_t size) {
+    const uint8_t *bytes = data;
+    uint64_t hash = seed ^ 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return Mix64(hash);
+}
+
+// Sums per-entity hashes so table iteration order does not matter
+static uint64_t HashComponent(ecs_world_t *world, ecs_id_t id, size_t size, uint64_t salt) {
+    uint64_t sum = 0;
+    ecs_iter_t it = ecs_each_id(world, id);
+    while (ecs_each_next(&it)) {
+        const uint8_t *data = size ? ecs_field_w_size(&it, size, 0) : NULL;
+        for (int i = 0; i < it.count; i++) {
+            uint64_t hash = Mix64(it.entities[i] ^ salt);
+            if (data) {
+                hash = HashBytes(hash, data + i * size, size);
+            }
+            sum += hash;
+        }
+    }
+    return Mix64(sum ^ salt);
+}
+
+uint64_t ComputeWorldStateHash(ecs_world_t *world) {
+    uint64_t hash = 0;
+    hash ^= HashComponent(world, ecs_id(CameraController), sizeof(CameraController), 1);
+    hash ^= HashComponent(world, ecs_id(Position), sizeof(Position), 2);
+    hash ^= HashComponent(world, Visible, 0, 3);
+    hash ^= HashComponent(world, ecs_id(Selected), 0, 4);
+    hash ^= HashComponent(world, ImpostorActive, 0, 5);
+
+    // EditorState has padding; hash its fields explicitly
+    ecs_iter_t it = ecs_each_id(world, ecs_id(EditorState));
+    while (ecs_each_next(&it)) {
+        EditorState *states = ecs_field(&it, EditorState, 0);
+        for (int i = 0; i < it.count; i++) {
+            uint64_t fields[3] = {
+                (uint64_t)states[i].current_mode,
+                (uint64_t)states[i].focused_entity,
+                (uint64_t)states[i].mode_transition
+            };
+            hash ^= HashBytes(Mix64(it.entities[i] ^ 6), fields, sizeof(fields));
+        }
+    }
+
+    // Only the tier is state; projected_px is derived from the camera
+    it = ecs_each_id(world, ecs_id(TextLOD));
+    uint64_t tiers = 0;
+    while (ecs_each_next(&it)) {
+        TextLOD *lods = ecs_field(&it, TextLOD, 0);
+        for (int i = 0; i < it.count; i++) {
+            tiers += Mix64((it.entities[i] << 2) ^ lods[i].tier ^ 7);
+        }
+    }
+    hash ^= Mix64(tiers);
+
+    return hash;
+}
@@ -0,0 +1,78 @@
+#ifndef INPUT_REPLAY_H
+#define INPUT_REPLAY_H
+
+#include <flecs.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "../components/spatial.h"
+
+// Deterministic input record/replay.
+//
+// A log stores one InputFrame per simulated frame together with the world
+// state hash taken after ecs_progress. Both recording and replay advance
+// the world with the fixed delta time stored in the header, so a replay of
+// the same setup must reproduce every hash bit for bit.
+//
+// File layout (little endian):
+//     header: "PVIR" u32 version, f32 fixed_dt, u32 files, u32 lines, u32 frame_count
+//     frame:  u8 buttons, f32 mouse x/y, f32 delta x/y, f32 wheel,
+//             u16 screen width/height, u8 typed char, u8 keys, u64 state hash
+//
+// The typed char byte holds printable ASCII only (0 = none); keys without a
+// character are bits of the buttons and keys bytes.
+
+#define INPUT_LOG_VERSION 3
+#define INPUT_LOG_FRAME_SIZE 35
+#define INPUT_LOG_DEFAULT_DT (1.0f / 60.0f)
+
+// Button/key bits of a recorded frame
+#define INPUT_LOG_LEFT_DOWN    (1u << 0)
+#define INPUT_LOG_RIGHT_DOWN   (1u << 1)
+#define INPUT_LOG_LEFT_PRESSED (1u << 2)
+#define INPUT_LOG_TAB_PRESSED  (1u << 3)
+#define INPUT_LOG_BOX_SELECT    (1u << 4)
+#define INPUT_LOG_SPHERE_SELECT (1u << 5)
+#define INPUT_LOG_BACKSPACE     (1u << 6)
+#define INPUT_LOG_UNDO          (1u << 7)
+
+// Bits of the keys byte
+#define INPUT_LOG_REDO (1u << 0)
+
+typedef struct {
+    float fixed_dt;
+    uint32_t files;        // Synthesized world size (0 = editor project)
+    uint32_t lines;
+    uint32_t frame_count;  // 0 if the recorder was not closed cleanly
+} InputLogHeader;
+
+typedef struct {
+    FILE *file;
+    InputLogHeader header;
+    uint32_t frames_written;
+} InputRecorder;
+
+typedef struct {
+    FILE *file;
+    InputLogHeader header;
+    uint32_t frame_index;       // Frames consumed so far
+    uint32_t first_mismatch;    // Frame of the first hash mismatch (valid if mismatches > 0)
+    uint32_t mismatches;
+} InputReplay;
+
+// Recording
+bool InputRecorderOpen(InputRecorder *recorder, const char *path, const InputLogHeader *header);
+bool InputRecorderWrite(InputRecorder *recorder, const InputFrame *frame, uint64_t state_hash);
+void InputRecorderClose(InputRecorder *recorder);
+
+// Replay
+bool InputReplayOpen(InputReplay *replay, const char *path);
+bool InputReplayNext(InputReplay *replay, InputFrame *frame, uint64_t *expected_hash);
+bool InputReplayVerify(InputReplay *replay, uint64_t expected_hash, uint64_t actual_hash);
+void InputReplayClose(InputReplay *replay);
+
+// Order-independent hash of the simulation state (camera, editor mode,
+// selection, positions, visibility and LOD tiers)
+uint64_t ComputeWorldStateHash(ecs_world_t *world);
+
+#endif // INPUT_REPLAY_H
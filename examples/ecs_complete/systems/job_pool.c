@@ -0,0 +1,173 @@
+#define _POSIX_C_SOURCE 200809L  // sysconf
+#include "job_pool.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define JOB_POOL_MAX_THREADS 15
+
+struct JobPool {
+    pthread_t threads[JOB_POOL_MAX_THREADS];
+    int thread_count;
+
+    pthread_mutex_t submit;       // Held by the thread whose job is running
+    pthread_mutex_t mutex;
+    pthread_cond_t work_cond;     // Signalled when a new job is published
+    pthread_cond_t done_cond;     // Signalled when the last worker finishes
+    uint64_t generation;          // Incremented per job
+    int busy;                     // Workers still inside the current job
+    bool shutdown;
+
+    // Current job (written under the mutex before generation++)
+    JobFn fn;
+    void *ctx;
+    int count;
+    int chunk_size;
+    int chunk_count;
+    atomic_int next_chunk;
+};
+
+int JobPoolDefaultThreads(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers = cpus > 1 ? (int)cpus - 1 : 0;
+    return workers > JOB_POOL_MAX_THREADS ? JOB_POOL_MAX_THREADS : workers;
+}
+
+int JobPoolChunkCount(int count, int chunk_size) {
+    if (count <= 0) {
+        return 0;
+    }
+    if (chunk_size <= 0) {
+        chunk_size = count;
+    }
+    return (count + chunk_size - 1) / chunk_size;
+}
+
+static void RunChunks(JobPool *pool) {
+    for (;;) {
+        int chunk = atomic_fetch_add_explicit(&pool->next_chunk, 1, memory_order_relaxed);
+        if (chunk >= pool->chunk_count) {
+            return;
+        }
+        int begin = chunk * pool->chunk_size;
+        int end = begin + pool->chunk_size < pool->count ? begin + pool->chunk_size : pool->count;
+        pool->fn(pool->ctx, chunk, begin, end);
+    }
+}
+
+static void *WorkerMain(void *arg) {
+    JobPool *pool = arg;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+    for (;;) {
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->work_cond, &pool->mutex);
+        }
+        if (pool->shutdown) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->mutex);
+
+        RunChunks(pool);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->busy == 0) {
+            pthread_cond_signal(&pool->done_cond);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+}
+
+JobPool *JobPoolCreate(int worker_threads) {
+    JobPool *pool = calloc(1, sizeof(JobPool));
+    if (!pool) {
+        return NULL;
+    }
+    pthread_mutex_init(&pool->submit, NULL);
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->work_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+
+    if (worker_threads > JOB_POOL_MAX_THREADS) {
+        worker_threads = JOB_POOL_MAX_THREADS;
+    }
+    for (int i = 0; i < worker_threads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, WorkerMain, pool) != 0) {
+            printf("JobPool: failed to start worker %d, continuing with %d\n", i, i);
+            break;
+        }
+        pool->thread_count++;
+    }
+    return pool;
+}
+
+void JobPoolDestroy(JobPool *pool) {
+    if (!pool) {
+        return;
+    }
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->work_cond);
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_mutex_destroy(&pool->submit);
+    free(pool);
+}
+
+int JobPoolWorkerCount(const JobPool *pool) {
+    return pool ? pool->thread_count : 0;
+}
+
+void JobPoolParallelFor(JobPool *pool, int count, int chunk_size, JobFn fn, void *ctx) {
+    int chunk_count = JobPoolChunkCount(count, chunk_size);
+    if (chunk_count == 0) {
+        return;
+    }
+    if (chunk_size <= 0) {
+        chunk_size = count;
+    }
+
+    // Single chunk, no workers or the workers are busy with a job of another
+    // thread (or of the caller, from inside a chunk): run inline
+    if (!pool || pool->thread_count == 0 || chunk_count == 1 || pthread_mutex_trylock(&pool->submit) != 0) {
+        for (int chunk = 0; chunk < chunk_count; chunk++) {
+            int begin = chunk * chunk_size;
+            int end = begin + chunk_size < count ? begin + chunk_size : count;
+            fn(ctx, chunk, begin, end);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->fn = fn;
+    pool->ctx = ctx;
+    pool->count = count;
+    pool->chunk_size = chunk_size;
+    pool->chunk_count = chunk_count;
+    atomic_store(&pool->next_chunk, 0);
+    pool->busy = pool->thread_count;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    RunChunks(pool);
+
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->busy > 0) {
+        pthread_cond_wait(&pool->done_cond, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    pthread_mutex_unlock(&pool->submit);
+}
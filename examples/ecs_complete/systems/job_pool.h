@@ -0,0 +1,32 @@
+#ifndef JOB_POOL_H
+#define JOB_POOL_H
+
+#include <stdbool.h>
+
+// Minimal fork/join pool for data-parallel loops. The calling thread
+// participates, so a pool with zero workers simply runs inline.
+//
+// Work is split into fixed-size chunks; chunk indices do not depend on
+// which thread runs them, so per-chunk partial results can be reduced in
+// a deterministic order.
+
+typedef void (*JobFn)(void *ctx, int chunk, int begin, int end);
+
+typedef struct JobPool JobPool;
+
+// Suggested worker count: online CPUs minus the calling thread, capped
+int JobPoolDefaultThreads(void);
+
+JobPool *JobPoolCreate(int worker_threads);
+void JobPoolDestroy(JobPool *pool);
+int JobPoolWorkerCount(const JobPool *pool);
+
+// Number of chunks ParallelFor will use for this range
+int JobPoolChunkCount(int count, int chunk_size);
+
+// Runs fn over [0, count) in chunks and returns when every chunk is done.
+// Any thread may call it; while the workers run the job of one caller,
+// other callers run their chunks inline.
+void JobPoolParallelFor(JobPool *pool, int count, int chunk_size, JobFn fn, void *ctx);
+
+#endif // JOB_POOL_H
@@ -0,0 +1,1072 @@
+#include "layout.h"
+#include "frame_arena.h"
+#include "impostor.h"
+#include "worker_pool.h"
+#include "memory_tracker.h"
+#include "profiler.h"
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+ECS_COMPONENT_DECLARE(LayoutNode);
+ECS_COMPONENT_DECLARE(LayoutSettings);
+ECS_COMPONENT_DECLARE(LayoutStats);
+
+#define LAYOUT_CHUNK_SIZE 256        // Nodes per parallel chunk
+#define LAYOUT_LEAF_SIZE 8           // Bodies per octree leaf before it splits
+#define LAYOUT_MAX_DEPTH 24          // Octree depth limit (coincident nodes)
+#define LAYOUT_STACK_SIZE (LAYOUT_MAX_DEPTH * 8 + 8)
+#define LAYOUT_COOLING 0.9f          // Adaptive step factor (Yifan Hu)
+#define LAYOUT_WRITE_EPSILON 1e-3f   // Smaller moves are not written back
+#define LAYOUT_INCREMENTAL_STEP 0.25f // Initial step of a local solve, relative to K
+
+// Octree cell; leaves keep a short list of bodies (linked via next_body)
+typedef struct {
+    float cx, cy, cz, half;   // Cube center and half extent
+    float mx, my, mz, mass;   // Center of mass (weighted sums until finalized)
+    int32_t child[8];
+    int32_t first;            // First body of a leaf's list, -1 if none
+    int32_t count;            // Bodies in the subtree
+    bool leaf;
+} LayoutCell;
+
+typedef struct {
+    ecs_entity_t entity;
+    int32_t index;
+} LayoutLookup;
+
+// Solver state lives outside the ECS as flat arrays so the hot loops stay
+// cache friendly and can be split across worker threads
+typedef struct {
+    int node_count;
+    int node_capacity;
+    ecs_entity_t *entities;
+    float *x, *y, *z;             // Solver positions
+    float *fx, *fy, *fz;          // Forces of the current iteration
+    float *wx, *wy, *wz;          // Positions last written to the ECS
+    float *mass;
+    int32_t *next_body;           // Leaf body lists of the octree
+    LayoutLookup *lookup;         // Sorted by entity for lifting edges
+
+    int edge_count;
+    int edge_capacity;
+    int32_t *edge_from;
+    int32_t *edge_to;
+    uint8_t *edge_hop;            // Edge is followed by k-hop neighborhoods
+
+    // Undirected adjacency over hop edges (CSR), rebuilt with the graph
+    int32_t *adjacency_start;     // node_count + 1 offsets
+    int32_t *adjacency;
+    int adjacency_capacity;
+
+    // Nodes relaxed by the current solve; all others stay pinned
+    int32_t *active;
+    int active_count;
+    int32_t *hops;                // BFS distance from the change, -1 = unreached
+    uint8_t *moved;               // Written back during the current solve
+
+    // Snapshot of the previous graph, to spot new nodes and their neighbors
+    LayoutLookup *previous;
+    int previous_count;
+    int previous_capacity;
+
+    // Entities touched by topology changes since the last snapshot
+    ecs_entity_t *seeds;
+    int seed_count;
+    int seed_capacity;
+
+    // Scratch of one iteration, from the frame arena
+    LayoutCell *cells;
+    int cell_count;
+    int cell_capacity;
+
+    double *chunk_energy;         // Per-chunk partial sums, reduced in order
+    double *chunk_displacement;
+
+    float step;
+    float mean_displacement;
+    double energy;
+    int progress;
+    bool topology_dirty;
+    bool converged;
+    bool settled_once;            // A full layout exists to keep stable
+    bool incremental;             // Current solve is a local relaxation
+    int solve_iterations;
+    double solve_ms;
+
+    // Parameters of the running iteration (read by workers)
+    const LayoutSettings *settings;
+
+    JobPool *pool;
+} LayoutSolver;
+
+// The solver belongs to the world that registered the module: the system
+// and observers get it as ctx, API calls find it through this singleton
+typedef struct {
+    LayoutSolver *solver;
+} LayoutModule;
+
+static ECS_COMPONENT_DECLARE(LayoutModule);
+
+static LayoutSolver *GetSolver(const ecs_world_t *world) {
+    const LayoutModule *module = ecs_singleton_get(world, LayoutModule);
+    return module ? module->solver : NULL;
+}
+
+static bool ReserveNodes(LayoutSolver *s, int count) {
+    if (count <= s->node_capacity) {
+        return true;
+    }
+    int capacity = s->node_capacity;
+    float **arrays[] = {&s->x, &s->y, &s->z, &s->fx, &s->fy, &s->fz, &s->wx, &s->wy, &s->wz, &s->mass};
+    for (size_t a = 0; a < sizeof(arrays) / sizeof(arrays[0]); a++) {
+        int tmp = capacity;
+        if (!GrowArray(MEMORY_TAG_LAYOUT, (void**)arrays[a], &tmp, count, sizeof(float))) {
+            return false;
+        }
+    }
+    int tmp = capacity;
+    if (!GrowArray(MEMORY_TAG_LAYOUT, (void**)&s->next_body, &tmp, count, sizeof(int32_t))) {
+        return false;
+    }
+    tmp = capacity;
+    if (!GrowArray(MEMORY_TAG_LAYOUT, (void**)&s->entities, &tmp, count, sizeof(ecs_entity_t))) {
+        return false;
+    }
+    int32_t **int_arrays[] = {&s->active, &s->hops};
+    for (size_t a = 0; a < sizeof(int_arrays) / sizeof(int_arrays[0]); a++) {
+        tmp = capacity;
+        if (!GrowArray(MEMORY_TAG_LAYOUT, (void**)int_arrays[a], &tmp, count, sizeof(int32_t))) {
+            return false;
+        }
+    }
+    tmp = capacity;
+    if (!GrowArray(MEMORY_TAG_LAYOUT, (void**)&s->adjacency_start, &tmp, count + 1, sizeof(int32_t))) {
+        return false;
+    }
+    tmp = capacity;
+    if (!GrowArray(MEMORY_TAG_LAYOUT, (void**)&s->moved, &tmp, count, sizeof(uint8_t))) {
+        return false;
+    }
+    tmp = capacity;
+    if (!GrowArray(MEMORY_TAG_LAYOUT, (void**)&s->lookup, &tmp, count, sizeof(LayoutLookup))) {
+        return false;
+    }
+    s->node_capacity = tmp;
+    return true;
+}
+
+static bool AddEdge(LayoutSolver *s, int32_t from, int32_t to, bool hop) {
+    int capacity = s->edge_capacity;
+    if (!GrowArray(MEMORY_TAG_LAYOUT, (void**)&s->edge_from, &capacity, s->edge_count + 1, sizeof(int32_t))) {
+        return false;
+    }
+    capacity = s->edge_capacity;
+    if (!GrowArray(MEMORY_TAG_LAYOUT, (void**)&s->edge_to, &capacity, s->edge_count + 1, sizeof(int32_t))) {
+        return false;
+    }
+    capacity = s->edge_capacity;
+    if (!GrowArray(MEMORY_TAG_LAYOUT, (void**)&s->edge_hop, &capacity, s->edge_count + 1, sizeof(uint8_t))) {
+        return false;
+    }
+    s->edge_capacity = capacity;
+    s->edge_from[s->edge_count] = from;
+    s->edge_to[s->edge_count] = to;
+    s->edge_hop[s->edge_count] = hop;
+    s->edge_count++;
+    return true;
+}
+
+static bool PushSeed(LayoutSolver *s, ecs_entity_t entity) {
+    if (!GrowArray(MEMORY_TAG_LAYOUT, (void**)&s->seeds, &s->seed_capacity, s->seed_count + 1, sizeof(ecs_entity_t))) {
+        return false;
+    }
+    s->seeds[s->seed_count++] = entity;
+    return true;
+}
+
+static int CompareLookup(const void *a, const void *b) {
+    ecs_entity_t ea = ((const LayoutLookup*)a)->entity;
+    ecs_entity_t eb = ((const LayoutLookup*)b)->entity;
+    return (ea > eb) - (ea < eb);
+}
+
+static int32_t FindInLookup(const LayoutLookup *lookup, int count, ecs_entity_t entity) {
+    LayoutLookup key = {entity, -1};
+    const LayoutLookup *found = bsearch(&key, lookup, count, sizeof(LayoutLookup), CompareLookup);
+    return found ? found->index : -1;
+}
+
+static int32_t FindNode(const LayoutSolver *s, ecs_entity_t entity) {
+    return FindInLookup(s->lookup, s->node_count, entity);
+}
+
+// Nearest layout node at or above the entity in the ChildOf hierarchy
+static int32_t ResolveNode(ecs_world_t *world, const LayoutSolver *s, ecs_entity_t entity) {
+    for (int depth = 0; entity != 0 && depth < 8; depth++) {
+        int32_t index = FindNode(s, entity);
+        if (index >= 0) {
+            return index;
+        }
+        entity = ecs_get_target(world, entity, EcsChildOf, 0);
+    }
+    return -1;
+}
+
+// Undirected CSR adjacency over the hop edges
+static void BuildAdjacency(LayoutSolver *s) {
+    memset(s->adjacency_start, 0, sizeof(int32_t) * (s->node_count + 1));
+    int hop_edges = 0;
+    for (int e = 0; e < s->edge_count; e++) {
+        if (s->edge_hop[e]) {
+            s->adjacency_start[s->edge_from[e] + 1]++;
+            s->adjacency_start[s->edge_to[e] + 1]++;
+            hop_edges++;
+        }
+    }
+    for (int i = 0; i < s->node_count; i++) {
+        s->adjacency_start[i + 1] += s->adjacency_start[i];
+    }
+    if (!GrowArray(MEMORY_TAG_LAYOUT, (void**)&s->adjacency, &s->adjacency_capacity, hop_edges * 2 + 1,
+                   sizeof(int32_t))) {
+        memset(s->adjacency_start, 0, sizeof(int32_t) * (s->node_count + 1));
+        return;
+    }
+
+    // Fill using hops[] as per-node write cursors
+    for (int i = 0; i < s->node_count; i++) {
+        s->hops[i] = s->adjacency_start[i];
+    }
+    for (int e = 0; e < s->edge_count; e++) {
+        if (s->edge_hop[e]) {
+            s->adjacency[s->hops[s->edge_from[e]]++] = s->edge_to[e];
+            s->adjacency[s->hops[s->edge_to[e]]++] = s->edge_from[e];
+        }
+    }
+}
+
+// Snapshots layout nodes and relationship edges from the world
+static void RebuildGraph(ecs_world_t *world, LayoutSolver *s) {
+    s->node_count = 0;
+    s->edge_count = 0;
+
+    ecs_iter_t it = ecs_each_id(world, ecs_id(LayoutNode));
+    while (ecs_each_next(&it)) {
+        LayoutNode *nodes = ecs_field(&it, LayoutNode, 0);
+        if (!ReserveNodes(s, s->node_count + it.count)) {
+            ecs_iter_fini(&it);
+            break;
+        }
+        for (int i = 0; i < it.count; i++) {
+            ecs_entity_t entity = it.entities[i];
+            const Position *position = ecs_get(world, entity, Position);
+            if (!position) {
+                continue;
+            }
+
+            float mass = nodes[i].mass;
+            if (mass <= 0.0f) {
+                int children = 0;
+                ecs_iter_t child_it = ecs_children(world, entity);
+                while (ecs_children_next(&child_it)) {
+                    children += child_it.count;
+                }
+                mass = 1.0f + children * 0.02f;
+            }
+
+            int n = s->node_count++;
+            s->entities[n] = entity;
+            s->x[n] = s->wx[n] = position->x;
+            s->y[n] = s->wy[n] = position->y;
+            s->z[n] = s->wz[n] = position->z;
+            s->mass[n] = mass;
+            s->lookup[n] = (LayoutLookup){entity, n};
+        }
+    }
+    qsort(s->lookup, s->node_count, sizeof(LayoutLookup), CompareLookup);
+
+    // All four relations are springs; References/Includes also define the
+    // neighborhood an incremental solve may disturb
+    ecs_entity_t relations[] = {References, Includes, Imports, Contains};
+    bool relation_hops[] = {true, true, false, false};
+    for (size_t r = 0; r < sizeof(relations) / sizeof(relations[0]); r++) {
+        ecs_iter_t pair_it = ecs_each_id(world, ecs_pair(relations[r], EcsWildcard));
+        while (ecs_each_next(&pair_it)) {
+            for (int i = 0; i < pair_it.count; i++) {
+                int32_t from = ResolveNode(world, s, pair_it.entities[i]);
+                if (from < 0) {
+                    continue;
+                }
+                ecs_entity_t target;
+                for (int32_t t = 0; (target = ecs_get_target(world, pair_it.entities[i], relations[r], t)) != 0; t++) {
+                    int32_t to = ResolveNode(world, s, target);
+                    if (to >= 0 && to != from) {
+                        AddEdge(s, from, to, relation_hops[r]);
+                    }
+                }
+            }
+        }
+    }
+
+    BuildAdjacency(s);
+    s->topology_dirty = false;
+}
+
+static int32_t NewCell(LayoutSolver *s, float cx, float cy, float cz, float half) {
+    if (s->cell_count == s->cell_capacity) {
+        int capacity = s->cell_capacity > 0 ? s->cell_capacity * 2 : 256;
+        LayoutCell *grown = FrameRealloc(s->cells, (size_t)s->cell_capacity * sizeof(LayoutCell),
+                                         (size_t)capacity * sizeof(LayoutCell));
+        if (!grown) {
+            printf("Layout: out of memory growing to %d elements\n", capacity);
+            return -1;
+        }
+        s->cells = grown;
+        s->cell_capacity = capacity;
+    }
+    LayoutCell *cell = &s->cells[s->cell_count];
+    memset(cell, 0, sizeof(*cell));
+    cell->cx = cx;
+    cell->cy = cy;
+    cell->cz = cz;
+    cell->half = half;
+    for (int c = 0; c < 8; c++) {
+        cell->child[c] = -1;
+    }
+    cell->first = -1;
+    cell->leaf = true;
+    return s->cell_count++;
+}
+
+static void AccumulateBody(LayoutCell *cell, const LayoutSolver *s, int32_t body) {
+    float m = s->mass[body];
+    cell->mass += m;
+    cell->mx += s->x[body] * m;
+    cell->my += s->y[body] * m;
+    cell->mz += s->z[body] * m;
+    cell->count++;
+}
+
+// Child cell for a body, created on demand; -1 when out of memory
+static int32_t ChildCell(LayoutSolver *s, int32_t cell_index, int32_t body) {
+    LayoutCell *cell = &s->cells[cell_index];
+    int octant = (s->x[body] > cell->cx) | ((s->y[body] > cell->cy) << 1) | ((s->z[body] > cell->cz) << 2);
+    if (cell->child[octant] >= 0) {
+        return cell->child[octant];
+    }
+
+    float quarter = cell->half * 0.5f;
+    float cx = cell->cx + ((octant & 1) ? quarter : -quarter);
+    float cy = cell->cy + ((octant & 2) ? quarter : -quarter);
+    float cz = cell->cz + ((octant & 4) ? quarter : -quarter);
+    int32_t child = NewCell(s, cx, cy, cz, quarter);  // May move s->cells
+    if (child >= 0) {
+        s->cells[cell_index].child[octant] = child;
+    }
+    return child;
+}
+
+static void PushBody(LayoutSolver *s, int32_t cell_index, int32_t body) {
+    LayoutCell *cell = &s->cells[cell_index];
+    s->next_body[body] = cell->first;
+    cell->first = body;
+}
+
+static void InsertBody(LayoutSolver *s, int32_t body) {
+    int32_t cell_index = 0;
+    for (int depth = 0; cell_index >= 0; depth++) {
+        LayoutCell *cell = &s->cells[cell_index];
+        AccumulateBody(cell, s, body);
+
+        if (cell->leaf) {
+            if (cell->count <= LAYOUT_LEAF_SIZE || depth >= LAYOUT_MAX_DEPTH) {
+                PushBody(s, cell_index, body);
+                return;
+            }
+
+            // Full leaf: turn it into an inner cell and push its bodies down
+            int32_t list = cell->first;
+            cell->first = -1;
+            cell->leaf = false;
+            while (list >= 0) {
+                int32_t next = s->next_body[list];
+                int32_t child = ChildCell(s, cell_index, list);
+                if (child < 0) {
+                    return;
+                }
+                AccumulateBody(&s->cells[child], s, list);
+                PushBody(s, child, list);
+                list = next;
+            }
+        }
+        cell_index = ChildCell(s, cell_index, body);
+    }
+}
+
+static void BuildTree(LayoutSolver *s) {
+    s->cell_count = 0;
+    if (s->node_count == 0) {
+        return;
+    }
+
+    float min_x = FLT_MAX, min_y = FLT_MAX, min_z = FLT_MAX;
+    float max_x = -FLT_MAX, max_y = -FLT_MAX, max_z = -FLT_MAX;
+    for (int i = 0; i < s->node_count; i++) {
+        min_x = fminf(min_x, s->x[i]);
+        max_x = fmaxf(max_x, s->x[i]);
+        min_y = fminf(min_y, s->y[i]);
+        max_y = fmaxf(max_y, s->y[i]);
+        min_z = fminf(min_z, s->z[i]);
+        max_z = fmaxf(max_z, s->z[i]);
+    }
+    float half = fmaxf(max_x - min_x, fmaxf(max_y - min_y, max_z - min_z)) * 0.5f + 1.0f;
+    if (NewCell(s, (min_x + max_x) * 0.5f, (min_y + max_y) * 0.5f, (min_z + max_z) * 0.5f, half) < 0) {
+        return;
+    }
+
+    for (int i = 0; i < s->node_count; i++) {
+        InsertBody(s, i);
+    }
+
+    for (int c = 0; c < s->cell_count; c++) {
+        LayoutCell *cell = &s->cells[c];
+        if (cell->mass > 0.0f) {
+            cell->mx /= cell->mass;
+            cell->my /= cell->mass;
+            cell->mz /= cell->mass;
+        }
+    }
+}
+
+// Yifan Hu model: |f| = C K^2 m_i m_j / d, so the vector is delta * w / d^2
+static inline void RepulsionTerm(float dx, float dy, float dz, float weight, int i,
+                                 float *fx, float *fy, float *fz) {
+    float d2 = dx * dx + dy * dy + dz * dz;
+    if (d2 < 1e-6f) {
+        // Coincident: separate along a direction derived from the index
+        dx = (i & 1) ? 0.01f : -0.01f;
+        dy = (i & 2) ? 0.01f : -0.01f;
+        dz = (i & 4) ? 0.01f : -0.01f;
+        d2 = 3e-4f;
+    }
+    float f = weight / d2;
+    *fx += dx * f;
+    *fy += dy * f;
+    *fz += dz * f;
+}
+
+// Repulsion (Barnes-Hut) and gravity for a range of nodes
+static void RepulsionJob(void *ctx, int chunk, int begin, int end) {
+    (void)chunk;
+    LayoutSolver *s = ctx;
+    const LayoutSettings *settings = s->settings;
+    const float strength = settings->repulsion * settings->natural_length * settings->natural_length;
+    const float theta2 = settings->theta * settings->theta;
+    int32_t stack[LAYOUT_STACK_SIZE];
+
+    for (int k = begin; k < end; k++) {
+        int i = s->active[k];
+        float px = s->x[i], py = s->y[i], pz = s->z[i];
+        float fx = -px * settings->gravity * s->mass[i];
+        float fy = -py * settings->gravity * s->mass[i];
+        float fz = -pz * settings->gravity * s->mass[i];
+
+        int top = 0;
+        if (s->cell_count > 0) {
+            stack[top++] = 0;
+        }
+        while (top > 0) {
+            const LayoutCell *cell = &s->cells[stack[--top]];
+            if (cell->count == 0) {
+                continue;
+            }
+
+            float dx = px - cell->mx;
+            float dy = py - cell->my;
+            float dz = pz - cell->mz;
+            float d2 = dx * dx + dy * dy + dz * dz;
+            float size = cell->half * 2.0f;
+            bool contains_self = fabsf(px - cell->cx) <= cell->half &&
+                                 fabsf(py - cell->cy) <= cell->half &&
+                                 fabsf(pz - cell->cz) <= cell->half;
+            bool near = contains_self || size * size >= theta2 * d2;
+
+            if (near && !cell->leaf) {
+                // Too close to approximate: open the cell
+                for (int c = 0; c < 8; c++) {
+                    if (cell->child[c] >= 0 && top < LAYOUT_STACK_SIZE) {
+                        stack[top++] = cell->child[c];
+                    }
+                }
+            } else if (near) {
+                // Near leaf: exact pairwise terms
+                for (int32_t j = cell->first; j >= 0; j = s->next_body[j]) {
+                    if (j != i) {
+                        RepulsionTerm(px - s->x[j], py - s->y[j], pz - s->z[j],
+                                      strength * s->mass[i] * s->mass[j], i, &fx, &fy, &fz);
+                    }
+                }
+            } else {
+                // Far cell: its center of mass stands in for all its bodies
+                RepulsionTerm(dx, dy, dz, strength * s->mass[i] * cell->mass, i, &fx, &fy, &fz);
+            }
+        }
+
+        s->fx[i] = fx;
+        s->fy[i] = fy;
+        s->fz[i] = fz;
+    }
+}
+
+// Moves each node along its force by at most the current step
+static void IntegrateJob(void *ctx, int chunk, int begin, int end) {
+    LayoutSolver *s = ctx;
+    double energy = 0.0;
+    double displacement = 0.0;
+
+    for (int k = begin; k < end; k++) {
+        int i = s->active[k];
+        float f2 = s->fx[i] * s->fx[i] + s->fy[i] * s->fy[i] + s->fz[i] * s->fz[i];
+        energy += f2;
+        if (f2 <= 0.0f) {
+            continue;
+        }
+        float length = sqrtf(f2);
+        float move = fminf(s->step, length);
+        float scale = move / length;
+        s->x[i] += s->fx[i] * scale;
+        s->y[i] += s->fy[i] * scale;
+        s->z[i] += s->fz[i] * scale;
+        displacement += move;
+    }
+
+    s->chunk_energy[chunk] = energy;
+    s->chunk_displacement[chunk] = displacement;
+}
+
+static void ApplySprings(LayoutSolver *s, const LayoutSettings *settings) {
+    // Yifan Hu model: |f| = d^2 / K, so the vector is delta * d / K.
+    // Pinned endpoints (hops < 0) anchor the spring but are not pushed.
+    float inv_k = 1.0f / settings->natural_length;
+    for (int e = 0; e < s->edge_count; e++) {
+        int32_t a = s->edge_from[e];
+        int32_t b = s->edge_to[e];
+        bool a_active = s->hops[a] >= 0;
+        bool b_active = s->hops[b] >= 0;
+        if (!a_active && !b_active) {
+            continue;
+        }
+        float dx = s->x[b] - s->x[a];
+        float dy = s->y[b] - s->y[a];
+        float dz = s->z[b] - s->z[a];
+        float f = sqrtf(dx * dx + dy * dy + dz * dz) * inv_k;
+        if (a_active) {
+            s->fx[a] += dx * f;
+            s->fy[a] += dy * f;
+            s->fz[a] += dz * f;
+        }
+        if (b_active) {
+            s->fx[b] -= dx * f;
+            s->fy[b] -= dy * f;
+            s->fz[b] -= dz * f;
+        }
+    }
+}
+
+// Marks every node active for a global solve
+static void ActivateAll(LayoutSolver *s) {
+    for (int i = 0; i < s->node_count; i++) {
+        s->active[i] = i;
+        s->hops[i] = 0;
+    }
+    s->active_count = s->node_count;
+    s->incremental = false;
+}
+
+// Breadth-first search from the changed nodes over References/Includes;
+// returns false when the neighborhood is too large to be worth pinning
+static bool ActivateNeighborhood(ecs_world_t *world, LayoutSolver *s, const LayoutSettings *settings) {
+    for (int i = 0; i < s->node_count; i++) {
+        s->hops[i] = -1;
+    }
+    s->active_count = 0;
+
+    for (int k = 0; k < s->seed_count; k++) {
+        if (!ecs_is_alive(world, s->seeds[k])) {
+            continue;  // Deleted node: its neighbors were seeded on removal
+        }
+        int32_t node = ResolveNode(world, s, s->seeds[k]);
+        if (node >= 0 && s->hops[node] < 0) {
+            s->hops[node] = 0;
+            s->active[s->active_count++] = node;
+        }
+    }
+
+    // active[] doubles as the BFS queue
+    for (int head = 0; head < s->active_count; head++) {
+        int32_t node = s->active[head];
+        if (s->hops[node] >= settings->incremental_hops) {
+            continue;
+        }
+        for (int32_t a = s->adjacency_start[node]; a < s->adjacency_start[node + 1]; a++) {
+            int32_t neighbor = s->adjacency[a];
+            if (s->hops[neighbor] < 0) {
+                s->hops[neighbor] = s->hops[node] + 1;
+                s->active[s->active_count++] = neighbor;
+            }
+        }
+    }
+
+    if (s->active_count == 0 || s->active_count > s->node_count * settings->incremental_max_fraction) {
+        return false;
+    }
+
+    // Keep chunks and reductions in a stable order
+    for (int k = 1; k < s->active_count; k++) {
+        int32_t value = s->active[k];
+        int j = k - 1;
+        for (; j >= 0 && s->active[j] > value; j--) {
+            s->active[j + 1] = s->active[j];
+        }
+        s->active[j + 1] = value;
+    }
+    s->incremental = true;
+    return true;
+}
+
+// New nodes start at the centroid of their already placed neighbors so they
+// appear next to what they relate to instead of at their spawn position
+static void PlaceNewNodes(LayoutSolver *s) {
+    for (int k = 0; k < s->active_count; k++) {
+        int32_t node = s->active[k];
+        if (FindInLookup(s->previous, s->previous_count, s->entities[node]) >= 0) {
+            continue;
+        }
+
+        float sx = 0.0f, sy = 0.0f, sz = 0.0f;
+        int placed = 0;
+        for (int32_t a = s->adjacency_start[node]; a < s->adjacency_start[node + 1]; a++) {
+            int32_t neighbor = s->adjacency[a];
+            if (FindInLookup(s->previous, s->previous_count, s->entities[neighbor]) >= 0) {
+                sx += s->x[neighbor];
+                sy += s->y[neighbor];
+                sz += s->z[neighbor];
+                placed++;
+            }
+        }
+        if (placed > 0) {
+            // Deterministic offset so siblings do not start coincident
+            float offset = 0.25f * (float)(node % 7 + 1);
+            s->x[node] = sx / placed + offset;
+            s->y[node] = sy / placed;
+            s->z[node] = sz / placed - offset;
+        }
+    }
+}
+
+// One solver iteration; returns false once converged
+static bool LayoutIterate(LayoutSolver *s, const LayoutSettings *settings) {
+    if (s->active_count == 0) {
+        s->converged = true;
+        return false;
+    }
+
+    // Octree and partial sums live for this iteration only
+    FrameArenaMark mark = FrameArenaGetMark();
+    int chunk_count = JobPoolChunkCount(s->active_count, LAYOUT_CHUNK_SIZE);
+    s->chunk_energy = FrameAlloc((size_t)chunk_count * sizeof(double));
+    s->chunk_displacement = FrameAlloc((size_t)chunk_count * sizeof(double));
+    s->cells = NULL;
+    s->cell_capacity = 0;
+    if (!s->chunk_energy || !s->chunk_displacement) {
+        FrameArenaRewind(mark);
+        return false;
+    }
+    s->settings = settings;
+
+    PROFILE_ZONE_BEGIN(LayoutBuildTree);
+    BuildTree(s);
+    PROFILE_ZONE_END(LayoutBuildTree);
+
+    PROFILE_ZONE_BEGIN(LayoutForces);
+    JobPoolParallelFor(s->pool, s->active_count, LAYOUT_CHUNK_SIZE, RepulsionJob, s);
+    ApplySprings(s, settings);
+    PROFILE_ZONE_END(LayoutForces);
+
+    PROFILE_ZONE_BEGIN(LayoutIntegrate);
+    JobPoolParallelFor(s->pool, s->active_count, LAYOUT_CHUNK_SIZE, IntegrateJob, s);
+    PROFILE_ZONE_END(LayoutIntegrate);
+
+    // Reduce in chunk order so results do not depend on thread scheduling
+    double energy = 0.0;
+    double displacement = 0.0;
+    for (int c = 0; c < chunk_count; c++) {
+        energy += s->chunk_energy[c];
+        displacement += s->chunk_displacement[c];
+    }
+    FrameArenaRewind(mark);
+    s->cells = NULL;
+    s->cell_capacity = 0;
+    s->chunk_energy = NULL;
+    s->chunk_displacement = NULL;
+
+    // Adaptive cooling: grow the step after sustained progress, else shrink.
+    // A local solve only cools, which bounds how far any node can travel.
+    if (s->incremental) {
+        s->step *= LAYOUT_COOLING;
+    } else if (energy < s->energy) {
+        if (++s->progress >= 5) {
+            s->progress = 0;
+            s->step = fminf(s->step / LAYOUT_COOLING, settings->natural_length * 4.0f);
+        }
+    } else {
+        s->progress = 0;
+        s->step *= LAYOUT_COOLING;
+    }
+    s->energy = energy;
+
+    float mean_displacement = (float)(displacement / s->active_count);
+    float limit = settings->tolerance * settings->natural_length;
+    s->converged = mean_displacement < limit || s->step < limit * 0.01f;
+
+    s->mean_displacement = mean_displacement;
+    return !s->converged;
+}
+
+// Flags a moved node's transform and shifts its children rigidly
+static void ShiftSubtree(ecs_world_t *world, ecs_entity_t entity, float dx, float dy, float dz) {
+    EcsTransform *transform = ecs_get_mut(world, entity, EcsTransform);
+    if (transform) {
+        transform->needs_update = true;
+    }
+
+    ecs_iter_t child_it = ecs_children(world, entity);
+    while (ecs_children_next(&child_it)) {
+        for (int c = 0; c < child_it.count; c++) {
+            Position *child_position = ecs_get_mut(world, child_it.entities[c], Position);
+            if (child_position) {
+                child_position->x += dx;
+                child_position->y += dy;
+                child_position->z += dz;
+            }
+            EcsTransform *child_transform = ecs_get_mut(world, child_it.entities[c], EcsTransform);
+            if (child_transform) {
+                child_transform->needs_update = true;
+            }
+        }
+    }
+
+    FileImpostor *impostor = ecs_get_mut(world, entity, FileImpostor);
+    if (impostor) {
+        impostor->bounds_dirty = true;
+    }
+}
+
+// Copies moved solver positions back to the ECS; children follow rigidly
+static int WriteBack(ecs_world_t *world, LayoutSolver *s) {
+    int moved = 0;
+    for (int k = 0; k < s->active_count; k++) {
+        int i = s->active[k];
+        float dx = s->x[i] - s->wx[i];
+        float dy = s->y[i] - s->wy[i];
+        float dz = s->z[i] - s->wz[i];
+        if (fabsf(dx) < LAYOUT_WRITE_EPSILON && fabsf(dy) < LAYOUT_WRITE_EPSILON &&
+            fabsf(dz) < LAYOUT_WRITE_EPSILON) {
+            continue;
+        }
+
+        ecs_entity_t entity = s->entities[i];
+        Position *position = ecs_get_mut(world, entity, Position);
+        if (!position) {
+            s->topology_dirty = true;  // Node lost its Position; resnapshot
+            continue;
+        }
+        position->x = s->x[i];
+        position->y = s->y[i];
+        position->z = s->z[i];
+        ShiftSubtree(world, entity, dx, dy, dz);
+
+        s->wx[i] = s->x[i];
+        s->wy[i] = s->y[i];
+        s->wz[i] = s->z[i];
+        s->moved[i] = 1;
+        moved++;
+    }
+    return moved;
+}
+
+static void ResetSolverDynamics(LayoutSolver *s, const LayoutSettings *settings) {
+    // A local solve starts cool so pinned surroundings are not torn apart
+    s->step = settings->natural_length * (s->incremental ? LAYOUT_INCREMENTAL_STEP : 1.0f);
+    s->energy = DBL_MAX;
+    s->progress = 0;
+    s->converged = false;
+    s->solve_iterations = 0;
+    s->solve_ms = 0.0;
+    memset(s->moved, 0, s->node_count);
+}
+
+// Snapshots the graph and chooses a global or a k-hop local solve
+static void BeginSolve(ecs_world_t *world, LayoutSolver *s, const LayoutSettings *settings) {
+    // Keep the previous membership to recognize new nodes
+    if (GrowArray(MEMORY_TAG_LAYOUT, (void**)&s->previous, &s->previous_capacity, s->node_count + 1,
+                  sizeof(LayoutLookup))) {
+        memcpy(s->previous, s->lookup, sizeof(LayoutLookup) * s->node_count);
+        s->previous_count = s->node_count;
+    } else {
+        s->previous_count = 0;
+    }
+
+    RebuildGraph(world, s);
+
+    bool local = settings->incremental_hops > 0 && s->settled_once && s->seed_count > 0 &&
+                 ActivateNeighborhood(world, s, settings);
+    if (local) {
+        PlaceNewNodes(s);
+    } else {
+        ActivateAll(s);
+    }
+    s->seed_count = 0;
+    ResetSolverDynamics(s, settings);
+}
+
+// Runs iterations until the budget, the iteration cap or convergence
+static int LayoutStep(ecs_world_t *world, LayoutSolver *s, const LayoutSettings *settings,
+                      double budget_ms, int max_iterations) {
+    LayoutStats *stats = ecs_singleton_get_mut(world, LayoutStats);
+    uint64_t start = ProfilerNow();
+
+    if (s->topology_dirty) {
+        BeginSolve(world, s, settings);
+    }
+
+    int iterations = 0;
+    while (!s->converged && (max_iterations <= 0 || iterations < max_iterations)) {
+        LayoutIterate(s, settings);
+        iterations++;
+        if (budget_ms > 0.0 && (ProfilerNow() - start) / 1e6 >= budget_ms) {
+            break;
+        }
+    }
+
+    int moved = iterations > 0 ? WriteBack(world, s) : 0;
+    double frame_ms = (ProfilerNow() - start) / 1e6;
+    s->solve_iterations += iterations;
+    s->solve_ms += frame_ms;
+    bool finished = s->converged && iterations > 0;
+    if (s->converged) {
+        s->settled_once = true;
+    }
+
+    if (stats) {
+        stats->nodes = s->node_count;
+        stats->edges = s->edge_count;
+        stats->cells = s->cell_count;
+        stats->iterations_frame = iterations;
+        stats->iterations_total += iterations;
+        stats->moved_frame = moved;
+        stats->step = s->step;
+        stats->energy = s->energy;
+        stats->converged = s->converged;
+        stats->frame_ms = frame_ms;
+        stats->mean_displacement = s->mean_displacement;
+        stats->active_nodes = s->active_count;
+        stats->incremental = s->incremental;
+
+        // Totals of a finished solve stay visible until the next one ends
+        if (finished) {
+            int solve_moved = 0;
+            for (int k = 0; k < s->active_count; k++) {
+                solve_moved += s->moved[s->active[k]];
+            }
+            stats->solve_moved = solve_moved;
+            stats->solve_active = s->active_count;
+            stats->solve_iterations = s->solve_iterations;
+            stats->solve_ms = s->solve_ms;
+            stats->solve_incremental = s->incremental;
+            stats->solves++;
+        }
+    }
+    return iterations;
+}
+
+void AttachLayoutNode(ecs_world_t *world, ecs_entity_t entity, float mass) {
+    ecs_set(world, entity, LayoutNode, {mass});
+}
+
+int LayoutRunIterations(ecs_world_t *world, int max_iterations) {
+    const LayoutSettings *settings = ecs_singleton_get(world, LayoutSettings);
+    LayoutSolver *s = GetSolver(world);
+    if (!settings || !s) {
+        return 0;
+    }
+    return LayoutStep(world, s, settings, 0.0, max_iterations);
+}
+
+void LayoutSystem(ecs_iter_t *it) {
+    LayoutSolver *s = it->ctx;
+    const LayoutSettings *settings = ecs_singleton_get(it->world, LayoutSettings);
+    if (!settings || !settings->enabled) {
+        return;
+    }
+    if (!s->topology_dirty && s->converged) {
+        return;  // Settled: nothing to do until the graph changes
+    }
+
+    PROFILE_ZONE_BEGIN(LayoutSystem);
+    if (settings->fixed_iterations > 0) {
+        LayoutStep(it->world, s, settings, 0.0, settings->fixed_iterations);
+    } else {
+        LayoutStep(it->world, s, settings, settings->time_budget_ms, 0);
+    }
+    PROFILE_ZONE_END(LayoutSystem);
+}
+
+// Any node or relationship change invalidates the graph snapshot. The
+// touched entities seed the neighborhood of the next incremental solve.
+void OnLayoutTopologyChanged(ecs_iter_t *it) {
+    LayoutSolver *s = it->ctx;
+    s->topology_dirty = true;
+
+    bool pair = ecs_id_is_pair(it->event_id);
+    for (int i = 0; i < it->count; i++) {
+        ecs_entity_t entity = it->entities[i];
+        PushSeed(s, entity);
+
+        if (pair) {
+            ecs_entity_t target = ecs_pair_second(it->world, it->event_id);
+            if (target) {
+                PushSeed(s, target);
+            }
+        } else if (it->event == EcsOnRemove) {
+            // A removed node leaves a hole: its old neighbors relax into it
+            int32_t node = FindNode(s, entity);
+            if (node >= 0 && s->adjacency_start) {
+                for (int32_t a = s->adjacency_start[node]; a < s->adjacency_start[node + 1]; a++) {
+                    PushSeed(s, s->entities[s->adjacency[a]]);
+                }
+            }
+        }
+    }
+}
+
+void LayoutTranslateNode(ecs_world_t *world, ecs_entity_t entity, float dx, float dy, float dz) {
+    Position *position = ecs_get_mut(world, entity, Position);
+    if (!position) {
+        return;
+    }
+    position->x += dx;
+    position->y += dy;
+    position->z += dz;
+    ShiftSubtree(world, entity, dx, dy, dz);
+
+    // Keep the solver's copy in step so the next iteration does not undo it
+    LayoutSolver *s = GetSolver(world);
+    int32_t node = !s || s->topology_dirty ? -1 : FindNode(s, entity);
+    if (node >= 0) {
+        s->x[node] += dx;
+        s->y[node] += dy;
+        s->z[node] += dz;
+        s->wx[node] += dx;
+        s->wy[node] += dy;
+        s->wz[node] += dz;
+    }
+}
+
+void LayoutRequestFullSolve(ecs_world_t *world) {
+    LayoutSolver *s = GetSolver(world);
+    if (!s) {
+        return;
+    }
+    s->topology_dirty = true;
+    s->settled_once = false;  // Forces a global solve
+    s->seed_count = 0;
+}
+
+static void LayoutFini(ecs_world_t *world, void *ctx) {
+    LayoutSolver *s = ctx;
+    WorkerPoolRelease(world);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->entities);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->x);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->y);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->z);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->fx);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->fy);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->fz);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->wx);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->wy);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->wz);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->mass);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->next_body);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->lookup);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->edge_from);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->edge_to);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->edge_hop);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->adjacency_start);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->adjacency);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->active);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->hops);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->moved);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->previous);
+    TrackedFree(MEMORY_TAG_LAYOUT, s->seeds);
+    TrackedFree(MEMORY_TAG_LAYOUT, s);
+}
+
+static void ObserveTopology(ecs_world_t *world, LayoutSolver *s, ecs_id_t id) {
+    ecs_observer_desc_t desc = {0};
+    desc.query.terms[0].id = id;
+    desc.events[0] = EcsOnAdd;
+    desc.events[1] = EcsOnRemove;
+    desc.callback = OnLayoutTopologyChanged;
+    desc.ctx = s;
+    ecs_observer_init(world, &desc);
+}
+
+void RegisterLayoutSystems(ecs_world_t *world) {
+    ECS_COMPONENT_DEFINE(world, LayoutNode);
+    ECS_COMPONENT_DEFINE(world, LayoutSettings);
+    ECS_COMPONENT_DEFINE(world, LayoutStats);
+    ECS_COMPONENT_DEFINE(world, LayoutModule);
+
+    ecs_singleton_set(world, LayoutSettings, {
+        .enabled = true,
+        .natural_length = 12.0f,
+        .repulsion = 0.2f,
+        .theta = 1.2f,
+        .gravity = 0.002f,
+        .tolerance = 0.005f,
+        .time_budget_ms = 4.0f,
+        .fixed_iterations = 0,
+        .incremental_hops = 2,
+        .incremental_max_fraction = 0.25f
+    });
+    ecs_singleton_set(world, LayoutStats, {0});
+
+    LayoutSolver *s = TrackedCalloc(MEMORY_TAG_LAYOUT, 1, sizeof(LayoutSolver));
+    if (!s) {
+        printf("Layout: out of memory\n");
+        return;
+    }
+    s->pool = WorkerPoolAcquire(world);
+    s->topology_dirty = true;
+    ecs_singleton_set(world, LayoutModule, {s});
+    ecs_atfini(world, LayoutFini, s);
+
+    // Runs before TransformSystem so moved nodes get fresh matrices
+    ecs_system(world, {
+        .entity = ecs_entity(world, {
+            .name = "LayoutSystem",
+            .add = ecs_ids(ecs_dependson(EcsPreUpdate))
+        }),
+        .callback = LayoutSystem,
+        .ctx = s
+    });
+
+    ObserveTopology(world, s, ecs_id(LayoutNode));
+    ObserveTopology(world, s, ecs_pair(References, EcsWildcard));
+    ObserveTopology(world, s, ecs_pair(Includes, EcsWildcard));
+    ObserveTopology(world, s, ecs_pair(Imports, EcsWildcard));
+    ObserveTopology(world, s, ecs_pair(Contains, EcsWildcard));
+}
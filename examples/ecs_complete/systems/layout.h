@@ -0,0 +1,87 @@
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <flecs.h>
+#include <stdbool.h>
+#include "../components/spatial.h"
+
+// Force-directed placement of code elements (files, symbols) driven by the
+// References/Includes/Imports/Contains relationships. Repulsion uses a
+// Barnes-Hut octree (O(n log n)), springs follow relationship pairs, and
+// the solver advances a few iterations per frame under a time budget.
+//
+// After the first global solve, topology changes are solved incrementally:
+// only nodes within k References/Includes hops of the change move, the rest
+// stay pinned so the user's mental map is preserved.
+//
+// Relationship pairs on ChildOf descendants (e.g. line phantoms) are lifted
+// to the nearest ancestor that is a layout node, and children move rigidly
+// with their layout node.
+
+// Marks an entity as a layout node
+typedef struct {
+    float mass;  // Repulsion weight; 0 derives it from the child count
+} LayoutNode;
+
+typedef struct {
+    bool enabled;
+    float natural_length;    // K: preferred spring length (world units)
+    float repulsion;         // C: relative repulsion strength
+    float theta;             // Barnes-Hut opening criterion (0 = exact)
+    float gravity;           // Pull towards the origin keeps components together
+    float tolerance;         // Converged when mean displacement < tolerance * K
+    float time_budget_ms;    // Solver time per frame (at least one iteration runs)
+    int fixed_iterations;    // > 0: exactly this many iterations per frame (replays)
+    int incremental_hops;    // k: a change relaxes nodes within k hops (0 = always global)
+    float incremental_max_fraction;  // Larger neighborhoods fall back to a global solve
+} LayoutSettings;
+
+typedef struct {
+    int32_t nodes;
+    int32_t edges;
+    int32_t cells;               // Octree cells of the last iteration
+    int32_t iterations_frame;    // Iterations run in the last frame
+    int64_t iterations_total;
+    int32_t moved_frame;         // Nodes written back in the last frame
+    float step;                  // Current adaptive step length
+    float mean_displacement;
+    double energy;
+    double frame_ms;             // Solver time of the last frame
+    bool converged;
+    bool incremental;            // Running solve relaxes only a neighborhood
+    int32_t active_nodes;        // Nodes relaxed by the running solve
+
+    // Last finished solve (from topology change to convergence)
+    int32_t solves;
+    int32_t solve_active;
+    int32_t solve_moved;         // Nodes whose position changed
+    int32_t solve_iterations;
+    double solve_ms;
+    bool solve_incremental;
+} LayoutStats;
+
+extern ECS_COMPONENT_DECLARE(LayoutNode);
+extern ECS_COMPONENT_DECLARE(LayoutSettings);
+extern ECS_COMPONENT_DECLARE(LayoutStats);
+
+// Opt an entity into the layout (entity needs a Position)
+void AttachLayoutNode(ecs_world_t *world, ecs_entity_t entity, float mass);
+
+// Moves an entity and its children by a delta outside the solver (e.g.
+// collision resolution); layout nodes keep the new position as their start
+void LayoutTranslateNode(ecs_world_t *world, ecs_entity_t entity, float dx, float dy, float dz);
+
+// Discards pinning and re-solves the whole graph on the next step
+void LayoutRequestFullSolve(ecs_world_t *world);
+
+// Runs solver iterations synchronously until converged or max_iterations
+// is reached; returns the number of iterations run
+int LayoutRunIterations(ecs_world_t *world, int max_iterations);
+
+// Systems and observers
+void LayoutSystem(ecs_iter_t *it);
+void OnLayoutTopologyChanged(ecs_iter_t *it);
+
+void RegisterLayoutSystems(ecs_world_t *world);
+
+#endif // LAYOUT_H
@@ -0,0 +1,890 @@
+#include "lexer.h"
+#include "memory_tracker.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define LEX_USE_SSE2 1
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define LEX_USE_NEON 1
+#endif
+
+#define LEX_KEYWORD_HASH_SIZE 256
+#define LEX_KEYWORD_MAX_LENGTH 13
+#define LEX_PARALLEL_MIN_CHUNK (256 * 1024)   // Bytes; smaller texts are lexed inline
+#define LEX_PARALLEL_CHUNKS_PER_THREAD 4
+
+// Character classes driving the main switch
+enum {
+    LEX_OTHER = 0,      // Control characters, skipped
+    LEX_SPACE,
+    LEX_NEWLINE,
+    LEX_IDENT,          // Identifier start; bytes >= 0x80 count as letters (UTF-8)
+    LEX_DIGIT,
+    LEX_QUOTE,
+    LEX_SLASH,
+    LEX_HASH,
+    LEX_BACKSLASH,
+    LEX_DOT,
+    LEX_PUNCT
+};
+
+#define O LEX_OTHER
+#define S LEX_SPACE
+#define N LEX_NEWLINE
+#define I LEX_IDENT
+#define D LEX_DIGIT
+#define Q LEX_QUOTE
+#define L LEX_SLASH
+#define H LEX_HASH
+#define B LEX_BACKSLASH
+#define T LEX_DOT
+#define P LEX_PUNCT
+static const uint8_t lex_class[256] = {
+    O, O, O, O, O, O, O, O, O, S, N, S, S, S, O, O,  // 0x00
+    O, O, O, O, O, O, O, O, O, O, O, O, O, O, O, O,  // 0x10
+    S, P, Q, H, I, P, P, Q, P, P, P, P, P, P, T, L,  // 0x20
+    D, D, D, D, D, D, D, D, D, D, P, P, P, P, P, P,  // 0x30
+    P, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I,  // 0x40
+    I, I, I, I, I, I, I, I, I, I, I, P, B, P, P, I,  // 0x50
+    P, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I,  // 0x60
+    I, I, I, I, I, I, I, I, I, I, I, P, P, P, P, O,  // 0x70
+    I, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I,  // 0x80
+    I, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I,  // 0x90
+    I, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I,  // 0xa0
+    I, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I,  // 0xb0
+    I, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I,  // 0xc0
+    I, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I,  // 0xd0
+    I, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I,  // 0xe0
+    I, I, I, I, I, I, I, I, I, I, I, I, I, I, I, I  // 0xf0
+};
+#undef O
+#undef S
+#undef N
+#undef I
+#undef D
+#undef Q
+#undef L
+#undef H
+#undef B
+#undef T
+#undef P
+
+// Keywords sorted by length, found through an open-addressing hash of the
+// first, middle and last character (at most one extra probe)
+static const struct { const char *word; uint8_t length; uint8_t kind; } lex_keywords[] = {
+    {NULL, 0, 0},  // Index 0 marks an empty hash slot
+    {"do", 2, TOKEN_KEYWORD}, {"if", 2, TOKEN_KEYWORD}, {"for", 3, TOKEN_KEYWORD},
+    {"int", 3, TOKEN_TYPE}, {"new", 3, TOKEN_KEYWORD}, {"try", 3, TOKEN_KEYWORD},
+    {"auto", 4, TOKEN_TYPE}, {"bool", 4, TOKEN_TYPE}, {"case", 4, TOKEN_KEYWORD},
+    {"char", 4, TOKEN_TYPE}, {"else", 4, TOKEN_KEYWORD}, {"enum", 4, TOKEN_TYPE},
+    {"goto", 4, TOKEN_KEYWORD}, {"long", 4, TOKEN_TYPE}, {"this", 4, TOKEN_KEYWORD},
+    {"true", 4, TOKEN_KEYWORD}, {"void", 4, TOKEN_TYPE}, {"_Bool", 5, TOKEN_TYPE},
+    {"break", 5, TOKEN_KEYWORD}, {"catch", 5, TOKEN_KEYWORD}, {"class", 5, TOKEN_TYPE},
+    {"const", 5, TOKEN_TYPE}, {"false", 5, TOKEN_KEYWORD}, {"final", 5, TOKEN_TYPE},
+    {"float", 5, TOKEN_TYPE}, {"short", 5, TOKEN_TYPE}, {"throw", 5, TOKEN_KEYWORD},
+    {"union", 5, TOKEN_TYPE}, {"using", 5, TOKEN_TYPE}, {"while", 5, TOKEN_KEYWORD},
+    {"delete", 6, TOKEN_KEYWORD}, {"double", 6, TOKEN_TYPE}, {"extern", 6, TOKEN_TYPE},
+    {"friend", 6, TOKEN_TYPE}, {"inline", 6, TOKEN_TYPE}, {"public", 6, TOKEN_TYPE},
+    {"return", 6, TOKEN_KEYWORD}, {"signed", 6, TOKEN_TYPE}, {"sizeof", 6, TOKEN_KEYWORD},
+    {"static", 6, TOKEN_TYPE}, {"struct", 6, TOKEN_TYPE}, {"switch", 6, TOKEN_KEYWORD},
+    {"_Atomic", 7, TOKEN_TYPE}, {"alignof", 7, TOKEN_KEYWORD}, {"default", 7, TOKEN_KEYWORD},
+    {"mutable", 7, TOKEN_TYPE}, {"nullptr", 7, TOKEN_KEYWORD}, {"private", 7, TOKEN_TYPE},
+    {"typedef", 7, TOKEN_TYPE}, {"virtual", 7, TOKEN_TYPE}, {"co_await", 8, TOKEN_KEYWORD},
+    {"co_yield", 8, TOKEN_KEYWORD}, {"continue", 8, TOKEN_KEYWORD}, {"decltype", 8, TOKEN_TYPE},
+    {"explicit", 8, TOKEN_TYPE}, {"noexcept", 8, TOKEN_TYPE}, {"operator", 8, TOKEN_KEYWORD},
+    {"override", 8, TOKEN_TYPE}, {"register", 8, TOKEN_TYPE}, {"restrict", 8, TOKEN_TYPE},
+    {"template", 8, TOKEN_TYPE}, {"typename", 8, TOKEN_TYPE}, {"unsigned", 8, TOKEN_TYPE},
+    {"volatile", 8, TOKEN_TYPE}, {"co_return", 9, TOKEN_KEYWORD}, {"consteval", 9, TOKEN_TYPE},
+    {"constexpr", 9, TOKEN_TYPE}, {"constinit", 9, TOKEN_TYPE}, {"namespace", 9, TOKEN_TYPE},
+    {"protected", 9, TOKEN_TYPE}, {"thread_local", 12, TOKEN_TYPE},
+    {"_Thread_local", 13, TOKEN_TYPE}, {"static_assert", 13, TOKEN_TYPE}
+};
+
+static const uint8_t lex_keyword_hash[LEX_KEYWORD_HASH_SIZE] = {
+    62,  0,  0, 16,  0,  0,  0,  0,  4,  0,  0, 29,  0, 30,  0, 42,
+     0,  0,  0,  0, 64,  0,  0,  0,  0,  0,  0,  0,  0,  0, 57, 71,
+     0, 47,  0,  0,  0, 56,  0,  0,  0,  0,  0,  0,  0, 37,  0,  0,
+     0,  0,  0,  0,  5, 28,  0,  0,  0,  0,  0,  0,  0, 50,  0,  0,
+     0,  0,  0,  0,  0, 59,  0,  0,  0, 73,  0, 15,  0,  0,  0,  0,
+    60, 26,  0,  0,  0,  0,  0,  0, 41,  0,  0,  0,  0,  0,  0,  0,
+     0, 43,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0, 27,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  6,  0, 44,  0,  0,  0,  0, 52,  0,
+     0,  0, 32,  0, 53, 31,  0,  0,  0,  0,  9,  0,  0, 34,  0,  0,
+     0,  0, 72,  0,  0, 18, 54,  0, 11, 23, 19,  0,  0,  0, 20,  0,
+     0,  0,  0,  0,  0,  0,  0,  0,  0,  8,  0,  2, 35,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0, 65,  0,  7, 66,  0,  0,  0,  0,  0,
+     0, 46, 33,  0,  0, 24, 10,  1,  0,  0, 12,  0,  0, 21,  0,  0,
+    14,  0,  0,  0, 36,  0, 70,  0,  0,  0,  0,  0, 45, 69, 67,  0,
+    22, 58,  0, 13,  0,  0,  0,  0,  3,  0, 68, 48, 51, 55,  0,  0,
+     0, 38, 40,  0, 39,  0, 25,  0,  0,  0, 63,  0, 49,  0, 61, 17
+};
+
+static const char *token_kind_names[TOKEN_KIND_COUNT] = {
+    "identifier", "keyword", "type", "number", "string", "comment", "directive", "punct"
+};
+
+const char *TokenKindName(TokenKind kind) {
+    return kind < TOKEN_KIND_COUNT ? token_kind_names[kind] : "unknown";
+}
+
+static uint8_t ClassifyWord(const char *word, size_t length) {
+    if (length < 2 || length > LEX_KEYWORD_MAX_LENGTH) {
+        return TOKEN_IDENTIFIER;
+    }
+    unsigned hash = ((unsigned char)word[0] * 7u + (unsigned char)word[length - 1] * 6u +
+                     (unsigned char)word[length / 2] + (unsigned)length) & (LEX_KEYWORD_HASH_SIZE - 1);
+    for (;;) {
+        uint8_t index = lex_keyword_hash[hash];
+        if (index == 0) {
+            return TOKEN_IDENTIFIER;
+        }
+        if (lex_keywords[index].length == length && memcmp(lex_keywords[index].word, word, length) == 0) {
+            return lex_keywords[index].kind;
+        }
+        hash = (hash + 1) & (LEX_KEYWORD_HASH_SIZE - 1);
+    }
+}
+
+// Token buffer storage
+
+void TokenBufferInit(TokenBuffer *buffer) {
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+void TokenBufferFree(TokenBuffer *buffer) {
+    TrackedFree(MEMORY_TAG_SYNTAX, buffer->line_first);
+    TrackedFree(MEMORY_TAG_SYNTAX, buffer->line_state);
+    TrackedFree(MEMORY_TAG_SYNTAX, buffer->token_column);
+    TrackedFree(MEMORY_TAG_SYNTAX, buffer->token_length);
+    TrackedFree(MEMORY_TAG_SYNTAX, buffer->token_kind);
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+void TokenBufferClear(TokenBuffer *buffer) {
+    buffer->line_count = 0;
+    buffer->token_count = 0;
+    if (buffer->line_first) {
+        buffer->line_first[0] = 0;
+        buffer->line_state[0] = LEX_STATE_CODE;
+    }
+}
+
+// The three token arrays share token_capacity
+static bool ReserveTokens(TokenBuffer *buffer, int32_t needed) {
+    if (needed <= buffer->token_capacity) {
+        return true;
+    }
+    int tmp = buffer->token_capacity;
+    if (!GrowArray(MEMORY_TAG_SYNTAX, (void**)&buffer->token_column, &tmp, needed, sizeof(uint16_t))) {
+        return false;
+    }
+    tmp = buffer->token_capacity;
+    if (!GrowArray(MEMORY_TAG_SYNTAX, (void**)&buffer->token_length, &tmp, needed, sizeof(uint16_t))) {
+        return false;
+    }
+    tmp = buffer->token_capacity;
+    if (!GrowArray(MEMORY_TAG_SYNTAX, (void**)&buffer->token_kind, &tmp, needed, sizeof(uint8_t))) {
+        return false;
+    }
+    buffer->token_capacity = tmp;
+    return true;
+}
+
+// Line arrays keep one extra entry for the line_first sentinel
+static bool ReserveLines(TokenBuffer *buffer, int32_t needed) {
+    if (needed + 1 <= buffer->line_capacity) {
+        return true;
+    }
+    int tmp = buffer->line_capacity;
+    if (!GrowArray(MEMORY_TAG_SYNTAX, (void**)&buffer->line_first, &tmp, needed + 1, sizeof(uint32_t))) {
+        return false;
+    }
+    tmp = buffer->line_capacity;
+    if (!GrowArray(MEMORY_TAG_SYNTAX, (void**)&buffer->line_state, &tmp, needed + 1, sizeof(uint8_t))) {
+        return false;
+    }
+    buffer->line_capacity = tmp;
+    return true;
+}
+
+static inline bool BeginLine(TokenBuffer *buffer, uint8_t state) {
+    if (buffer->line_count + 1 >= buffer->line_capacity && !ReserveLines(buffer, buffer->line_count + 1)) {
+        return false;
+    }
+    buffer->line_first[buffer->line_count] = (uint32_t)buffer->token_count;
+    buffer->line_state[buffer->line_count] = state;
+    buffer->line_count++;
+    buffer->line_first[buffer->line_count] = (uint32_t)buffer->token_count;
+    return true;
+}
+
+static inline void PushToken(TokenBuffer *buffer, size_t column, size_t length, uint8_t kind) {
+    if (buffer->token_count == buffer->token_capacity && !ReserveTokens(buffer, buffer->token_count + 1)) {
+        return;
+    }
+    int32_t t = buffer->token_count++;
+    buffer->token_column[t] = (uint16_t)column;
+    buffer->token_length[t] = (uint16_t)length;
+    buffer->token_kind[t] = kind;
+}
+
+// Appends a span of the current line; spans longer than 16 bits are split
+static inline void EmitToken(TokenBuffer *buffer, const char *line, const char *begin, const char *end, uint8_t kind) {
+    size_t column = (size_t)(begin - line);
+    size_t length = (size_t)(end - begin);
+    while (length > LEX_MAX_COLUMN && column <= LEX_MAX_COLUMN) {
+        PushToken(buffer, column, LEX_MAX_COLUMN, kind);
+        column += LEX_MAX_COLUMN;
+        length -= LEX_MAX_COLUMN;
+    }
+    if (column <= LEX_MAX_COLUMN && length > 0) {
+        PushToken(buffer, column, length, kind);
+    }
+}
+
+// Run scanners. Each returns the first byte that ends the run (or end);
+// the SIMD paths handle whole 16-byte blocks and leave the tail to the
+// scalar loop.
+
+#ifdef LEX_USE_SSE2
+static inline int FirstSetBit(unsigned mask) {
+    return __builtin_ctz(mask);
+}
+#endif
+
+#ifdef LEX_USE_NEON
+// Index of the first set byte of a compare result, 16 if none. NEON has no
+// movemask: blocks without a hit are skipped with vmaxvq_u8, and a hit is
+// located by narrowing the result to four bits per byte.
+static inline int FirstMatch(uint8x16_t matches) {
+    if (vmaxvq_u8(matches) == 0) {
+        return 16;
+    }
+    uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(matches), 4);
+    return __builtin_ctzll(vget_lane_u64(vreinterpret_u64_u8(nibbles), 0)) >> 2;
+}
+#endif
+
+// Identifier continuation: letters, digits, '_', '$' and bytes >= 0x80
+static inline const char *SkipIdentifier(const char *p, const char *end) {
+#ifdef LEX_USE_SSE2
+    const __m128i case_bit = _mm_set1_epi8(0x20);
+    const __m128i below_a = _mm_set1_epi8('a' - 1);
+    const __m128i above_z = _mm_set1_epi8('z' + 1);
+    const __m128i below_0 = _mm_set1_epi8('0' - 1);
+    const __m128i above_9 = _mm_set1_epi8('9' + 1);
+    const __m128i underscore = _mm_set1_epi8('_');
+    const __m128i dollar = _mm_set1_epi8('$');
+    const __m128i zero = _mm_setzero_si128();
+    while (end - p >= 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)p);
+        __m128i folded = _mm_or_si128(bytes, case_bit);
+        __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(folded, below_a), _mm_cmpgt_epi8(above_z, folded));
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(bytes, below_0), _mm_cmpgt_epi8(above_9, bytes));
+        __m128i other = _mm_or_si128(_mm_cmpeq_epi8(bytes, underscore), _mm_cmpeq_epi8(bytes, dollar));
+        __m128i high = _mm_cmplt_epi8(bytes, zero);  // Signed: bytes >= 0x80
+        __m128i ident = _mm_or_si128(_mm_or_si128(alpha, digit), _mm_or_si128(other, high));
+        unsigned stop = ~(unsigned)_mm_movemask_epi8(ident) & 0xffffu;
+        if (stop) {
+            return p + FirstSetBit(stop);
+        }
+        p += 16;
+    }
+#elif defined(LEX_USE_NEON)
+    const uint8x16_t case_bit = vdupq_n_u8(0x20);
+    const uint8x16_t a = vdupq_n_u8('a');
+    const uint8x16_t zero = vdupq_n_u8('0');
+    const uint8x16_t letters = vdupq_n_u8('z' - 'a');
+    const uint8x16_t digits = vdupq_n_u8('9' - '0');
+    const uint8x16_t underscore = vdupq_n_u8('_');
+    const uint8x16_t dollar = vdupq_n_u8('$');
+    const uint8x16_t high_bit = vdupq_n_u8(0x80);
+    while (end - p >= 16) {
+        uint8x16_t bytes = vld1q_u8((const uint8_t*)p);
+        // Unsigned range checks: x - low <= high - low
+        uint8x16_t alpha = vcleq_u8(vsubq_u8(vorrq_u8(bytes, case_bit), a), letters);
+        uint8x16_t digit = vcleq_u8(vsubq_u8(bytes, zero), digits);
+        uint8x16_t other = vorrq_u8(vceqq_u8(bytes, underscore), vceqq_u8(bytes, dollar));
+        uint8x16_t high = vcgeq_u8(bytes, high_bit);
+        uint8x16_t ident = vorrq_u8(vorrq_u8(alpha, digit), vorrq_u8(other, high));
+        int stop = FirstMatch(vmvnq_u8(ident));
+        if (stop < 16) {
+            return p + stop;
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && (lex_class[(unsigned char)*p] == LEX_IDENT || lex_class[(unsigned char)*p] == LEX_DIGIT)) {
+        p++;
+    }
+    return p;
+}
+
+// Horizontal whitespace (spaces and tabs in blocks, the rarer \r\v\f singly)
+static inline const char *SkipSpace(const char *p, const char *end) {
+#ifdef LEX_USE_SSE2
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    while (end - p >= 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)p);
+        __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(bytes, space), _mm_cmpeq_epi8(bytes, tab));
+        unsigned stop = ~(unsigned)_mm_movemask_epi8(blank) & 0xffffu;
+        if (stop) {
+            p += FirstSetBit(stop);
+            break;
+        }
+        p += 16;
+    }
+#elif defined(LEX_USE_NEON)
+    const uint8x16_t space = vdupq_n_u8(' ');
+    const uint8x16_t tab = vdupq_n_u8('\t');
+    while (end - p >= 16) {
+        uint8x16_t bytes = vld1q_u8((const uint8_t*)p);
+        uint8x16_t blank = vorrq_u8(vceqq_u8(bytes, space), vceqq_u8(bytes, tab));
+        int stop = FirstMatch(vmvnq_u8(blank));
+        if (stop < 16) {
+            p += stop;
+            break;
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && lex_class[(unsigned char)*p] == LEX_SPACE) {
+        p++;
+    }
+    return p;
+}
+
+// First of two bytes (or end)
+static inline const char *FindEither(const char *p, const char *end, char a, char b) {
+#ifdef LEX_USE_SSE2
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    while (end - p >= 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)p);
+        unsigned hits = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(bytes, va), _mm_cmpeq_epi8(bytes, vb)));
+        if (hits) {
+            return p + FirstSetBit(hits);
+        }
+        p += 16;
+    }
+#elif defined(LEX_USE_NEON)
+    const uint8x16_t va = vdupq_n_u8((uint8_t)a);
+    const uint8x16_t vb = vdupq_n_u8((uint8_t)b);
+    while (end - p >= 16) {
+        uint8x16_t bytes = vld1q_u8((const uint8_t*)p);
+        int hit = FirstMatch(vorrq_u8(vceqq_u8(bytes, va), vceqq_u8(bytes, vb)));
+        if (hit < 16) {
+            return p + hit;
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != a && *p != b) {
+        p++;
+    }
+    return p;
+}
+
+// First of three bytes (or end)
+static inline const char *FindAny3(const char *p, const char *end, char a, char b, char c) {
+#ifdef LEX_USE_SSE2
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    const __m128i vc = _mm_set1_epi8(c);
+    while (end - p >= 16) {
+        __m128i bytes = _mm_loadu_si128((const __m128i*)p);
+        __m128i any = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, va), _mm_cmpeq_epi8(bytes, vb)),
+                                   _mm_cmpeq_epi8(bytes, vc));
+        unsigned hits = (unsigned)_mm_movemask_epi8(any);
+        if (hits) {
+            return p + FirstSetBit(hits);
+        }
+        p += 16;
+    }
+#elif defined(LEX_USE_NEON)
+    const uint8x16_t va = vdupq_n_u8((uint8_t)a);
+    const uint8x16_t vb = vdupq_n_u8((uint8_t)b);
+    const uint8x16_t vc = vdupq_n_u8((uint8_t)c);
+    while (end - p >= 16) {
+        uint8x16_t bytes = vld1q_u8((const uint8_t*)p);
+        uint8x16_t any = vorrq_u8(vorrq_u8(vceqq_u8(bytes, va), vceqq_u8(bytes, vb)), vceqq_u8(bytes, vc));
+        int hit = FirstMatch(any);
+        if (hit < 16) {
+            return p + hit;
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != a && *p != b && *p != c) {
+        p++;
+    }
+    return p;
+}
+
+// A backslash at p continues the line if only "\n" or "\r\n" follows
+static inline bool IsContinuation(const char *p, const char *end) {
+    return (p + 1 < end && p[1] == '\n') || (p + 2 < end && p[1] == '\r' && p[2] == '\n');
+}
+
+// Last byte of the line content before the terminator (skipping '\r')
+static inline bool EndsWithBackslash(const char *line, const char *newline) {
+    const char *last = newline - 1;
+    if (last >= line && *last == '\r') {
+        last--;
+    }
+    return last >= line && *last == '\\';
+}
+
+// Scans a block comment body; returns past "*/" with *closed set, or the
+// line end
+static inline const char *ScanBlockComment(const char *p, const char *end, bool *closed) {
+    for (;;) {
+        p = FindEither(p, end, '*', '\n');
+        if (p >= end || *p == '\n') {
+            *closed = false;
+            return p;
+        }
+        if (p + 1 < end && p[1] == '/') {
+            *closed = true;
+            return p + 2;
+        }
+        p++;
+    }
+}
+
+// Scans a literal body up to the closing quote. Returns past the quote, or
+// the line end with *continued set if a backslash joins the next line.
+static inline const char *ScanLiteral(const char *p, const char *end, char quote, bool *continued) {
+    *continued = false;
+    for (;;) {
+        p = FindAny3(p, end, quote, '\\', '\n');
+        if (p >= end || *p == '\n') {
+            return p;  // Unterminated literal ends with the line
+        }
+        if (*p == quote) {
+            return p + 1;
+        }
+        if (IsContinuation(p, end)) {
+            *continued = true;
+            return p[1] == '\r' ? p + 2 : p + 1;
+        }
+        p += 2;  // Escape sequence
+    }
+}
+
+// Numbers: digits, letters, '.', digit separators and exponent signs
+static inline const char *ScanNumber(const char *p, const char *end) {
+    while (p < end) {
+        unsigned char c = (unsigned char)*p;
+        uint8_t cls = lex_class[c];
+        if (cls == LEX_IDENT || cls == LEX_DIGIT || c == '.' || c == '\'') {
+            p++;
+        } else if ((c == '+' || c == '-') && (p[-1] == 'e' || p[-1] == 'E' || p[-1] == 'p' || p[-1] == 'P')) {
+            p++;
+        } else {
+            break;
+        }
+    }
+    return p;
+}
+
+static inline bool IsPunctRun(const char *p, const char *end) {
+    uint8_t cls = lex_class[(unsigned char)*p];
+    if (cls == LEX_PUNCT) {
+        return true;
+    }
+    if (cls == LEX_SLASH) {
+        return !(p + 1 < end && (p[1] == '/' || p[1] == '*'));
+    }
+    if (cls == LEX_DOT) {
+        return !(p + 1 < end && lex_class[(unsigned char)p[1]] == LEX_DIGIT);
+    }
+    return false;
+}
+
+// Lexes one line starting in state. Returns the state for the next line;
+// *next points past the line terminator.
+static uint8_t LexLine(const char *line, const char *end, uint8_t state, TokenBuffer *buffer, const char **next) {
+    const char *p = line;
+    uint8_t directive = state & LEX_STATE_DIRECTIVE;
+    uint8_t open = LEX_STATE_CODE;   // Construct left open at the line end
+    bool seen_code = directive != 0; // '#' only starts a directive before any code
+    bool header_name = false;        // '<...>' is a string on an #include line
+    bool continued = false;
+
+    // Resume what the previous line left open
+    switch (state & LEX_STATE_MODE_MASK) {
+    case LEX_STATE_BLOCK_COMMENT: {
+        bool closed;
+        const char *stop = ScanBlockComment(p, end, &closed);
+        EmitToken(buffer, line, p, stop, TOKEN_COMMENT);
+        p = stop;
+        if (!closed) {
+            open = LEX_STATE_BLOCK_COMMENT;
+        }
+        break;
+    }
+    case LEX_STATE_LINE_COMMENT: {
+        const char *newline = memchr(p, '\n', (size_t)(end - p));
+        const char *stop = newline ? newline : end;
+        EmitToken(buffer, line, p, stop, TOKEN_COMMENT);
+        if (newline && EndsWithBackslash(line, newline)) {
+            open = LEX_STATE_LINE_COMMENT;
+        }
+        p = stop;
+        break;
+    }
+    case LEX_STATE_STRING: {
+        const char *stop = ScanLiteral(p, end, '"', &continued);
+        EmitToken(buffer, line, p, stop, TOKEN_STRING);
+        if (continued) {
+            open = LEX_STATE_STRING;
+        }
+        p = stop;
+        break;
+    }
+    default:
+        break;
+    }
+
+    while (p < end && *p != '\n') {
+        const char *start = p;
+        switch (lex_class[(unsigned char)*p]) {
+        case LEX_SPACE:
+            p = SkipSpace(p + 1, end);
+            break;
+
+        case LEX_IDENT: {
+            p = SkipIdentifier(p + 1, end);
+            EmitToken(buffer, line, start, p, ClassifyWord(start, (size_t)(p - start)));
+            seen_code = true;
+            break;
+        }
+
+        case LEX_DIGIT:
+            p = ScanNumber(p + 1, end);
+            EmitToken(buffer, line, start, p, TOKEN_NUMBER);
+            seen_code = true;
+            break;
+
+        case LEX_QUOTE: {
+            p = ScanLiteral(p + 1, end, *p, &continued);
+            EmitToken(buffer, line, start, p, TOKEN_STRING);
+            if (continued) {
+                open = LEX_STATE_STRING;
+            }
+            seen_code = true;
+            break;
+        }
+
+        case LEX_SLASH:
+            if (p + 1 < end && p[1] == '/') {
+                const char *newline = memchr(p, '\n', (size_t)(end - p));
+                const char *stop = newline ? newline : end;
+                EmitToken(buffer, line, start, stop, TOKEN_COMMENT);
+                if (newline && EndsWithBackslash(line, newline)) {
+                    open = LEX_STATE_LINE_COMMENT;
+                }
+                p = stop;
+            } else if (p + 1 < end && p[1] == '*') {
+                bool closed;
+                p = ScanBlockComment(p + 2, end, &closed);
+                EmitToken(buffer, line, start, p, TOKEN_COMMENT);
+                if (!closed) {
+                    open = LEX_STATE_BLOCK_COMMENT;
+                }
+            } else {
+                goto punct;
+            }
+            break;
+
+        case LEX_HASH:
+            if (!seen_code) {
+                // '#', optional blanks and the directive name form one span
+                const char *name = SkipSpace(p + 1, end);
+                p = SkipIdentifier(name, end);
+                EmitToken(buffer, line, start, p, TOKEN_DIRECTIVE);
+                size_t name_length = (size_t)(p - name);
+                header_name = (name_length == 7 && memcmp(name, "include", 7) == 0) ||
+                              (name_length == 12 && memcmp(name, "include_next", 12) == 0) ||
+                              (name_length == 6 && memcmp(name, "import", 6) == 0);
+                directive = LEX_STATE_DIRECTIVE;
+                seen_code = true;
+                break;
+            }
+            goto punct;
+
+        case LEX_BACKSLASH:
+            if (IsContinuation(p, end)) {
+                continued = true;
+                p = p[1] == '\r' ? p + 2 : p + 1;
+                break;
+            }
+            goto punct;
+
+        case LEX_DOT:
+            if (p + 1 < end && lex_class[(unsigned char)p[1]] == LEX_DIGIT) {
+                p = ScanNumber(p + 1, end);
+                EmitToken(buffer, line, start, p, TOKEN_NUMBER);
+                seen_code = true;
+                break;
+            }
+            goto punct;
+
+        case LEX_PUNCT:
+        punct:
+            if (header_name && *p == '<') {
+                const char *close = FindEither(p + 1, end, '>', '\n');
+                p = (close < end && *close == '>') ? close + 1 : close;
+                EmitToken(buffer, line, start, p, TOKEN_STRING);
+                header_name = false;
+                seen_code = true;
+                break;
+            }
+            p++;
+            while (p < end && IsPunctRun(p, end)) {
+                p++;
+            }
+            EmitToken(buffer, line, start, p, TOKEN_PUNCT);
+            seen_code = true;
+            break;
+
+        default:
+            p++;  // Control characters
+            break;
+        }
+    }
+
+    *next = p < end ? p + 1 : end;
+    // A directive continues past the line end only through a backslash or
+    // an open block comment (comments are removed before preprocessing)
+    if (open == LEX_STATE_CODE && !continued) {
+        directive = 0;
+    }
+    return open | directive;
+}
+
+uint8_t LexBuffer(const char *text, size_t length, uint8_t state, TokenBuffer *buffer) {
+    const char *p = text;
+    const char *end = text + length;
+
+    // Typical C averages one span per 4-6 bytes and 30-40 bytes per line
+    ReserveTokens(buffer, buffer->token_count + (int32_t)(length / 5) + 16);
+    ReserveLines(buffer, buffer->line_count + (int32_t)(length / 32) + 16);
+
+    while (p < end) {
+        if (!BeginLine(buffer, state)) {
+            break;
+        }
+        state = LexLine(p, end, state, buffer, &p);
+        buffer->line_first[buffer->line_count] = (uint32_t)buffer->token_count;
+    }
+    if (buffer->line_state) {
+        buffer->line_state[buffer->line_count] = state;
+    }
+    return state;
+}
+
+// Incremental re-lexing
+
+int LexEditLines(TokenBuffer *buffer, int first_line, int removed, int inserted,
+                 LexLineSource source, void *ctx) {
+    int old_count = buffer->line_count;
+    if (first_line < 0 || first_line > old_count || removed < 0 || inserted < 0) {
+        return 0;
+    }
+    if (removed > old_count - first_line) {
+        removed = old_count - first_line;
+    }
+    if (!ReserveLines(buffer, old_count)) {
+        return 0;
+    }
+    if (old_count == 0) {
+        buffer->line_first[0] = 0;
+        buffer->line_state[0] = LEX_STATE_CODE;
+    }
+
+    // Lex the replacement lines from the checkpoint of the first edited
+    // line, then keep going through the following lines until the state
+    // entering one matches the checkpoint stored for it
+    TokenBuffer relexed;
+    TokenBufferInit(&relexed);
+    uint8_t state = buffer->line_state[first_line];
+    int new_line = first_line;
+    int old_line = first_line + removed;
+    while (new_line < first_line + inserted ||
+           (old_line < old_count && state != buffer->line_state[old_line])) {
+        size_t length = 0;
+        const char *text = source(ctx, new_line, &length);
+        const char *next;
+        if (!BeginLine(&relexed, state)) {
+            break;
+        }
+        state = LexLine(text, text + length, state, &relexed, &next);
+        relexed.line_first[relexed.line_count] = (uint32_t)relexed.token_count;
+        if (new_line++ >= first_line + inserted) {
+            old_line++;
+        }
+    }
+
+    // Splice: lines [first_line, old_line) become the re-lexed lines, and
+    // the untouched tail moves with its token indices rebased
+    int new_count = old_count - (old_line - first_line) + relexed.line_count;
+    int tail_lines = old_count - old_line;
+    uint32_t token_begin = buffer->line_first[first_line];
+    uint32_t token_end = buffer->line_first[old_line];
+    uint32_t tail_tokens = (uint32_t)buffer->token_count - token_end;
+    int32_t token_delta = relexed.token_count - (int32_t)(token_end - token_begin);
+    if (!ReserveLines(buffer, new_count) || !ReserveTokens(buffer, buffer->token_count + token_delta)) {
+        TokenBufferFree(&relexed);
+        return 0;
+    }
+
+    // The tail only moves when the token or line count changed
+    uint32_t token_tail = token_begin + (uint32_t)relexed.token_count;
+    if (token_tail != token_end) {
+        memmove(buffer->token_column + token_tail, buffer->token_column + token_end, sizeof(uint16_t) * tail_tokens);
+        memmove(buffer->token_length + token_tail, buffer->token_length + token_end, sizeof(uint16_t) * tail_tokens);
+        memmove(buffer->token_kind + token_tail, buffer->token_kind + token_end, sizeof(uint8_t) * tail_tokens);
+    }
+    // Lines without tokens leave the relexed arrays unallocated (NULL)
+    if (relexed.token_count > 0) {
+        memcpy(buffer->token_column + token_begin, relexed.token_column, sizeof(uint16_t) * relexed.token_count);
+        memcpy(buffer->token_length + token_begin, relexed.token_length, sizeof(uint16_t) * relexed.token_count);
+        memcpy(buffer->token_kind + token_begin, relexed.token_kind, sizeof(uint8_t) * relexed.token_count);
+    }
+
+    // Tail lines plus the sentinel entry
+    if (new_line != old_line) {
+        memmove(buffer->line_first + new_line, buffer->line_first + old_line, sizeof(uint32_t) * (tail_lines + 1));
+        memmove(buffer->line_state + new_line, buffer->line_state + old_line, sizeof(uint8_t) * (tail_lines + 1));
+    }
+    if (token_delta != 0) {
+        for (int l = new_line; l <= new_count; l++) {
+            buffer->line_first[l] = (uint32_t)((int32_t)buffer->line_first[l] + token_delta);
+        }
+    }
+    for (int l = 0; l < relexed.line_count; l++) {
+        buffer->line_first[first_line + l] = relexed.line_first[l] + token_begin;
+        buffer->line_state[first_line + l] = relexed.line_state[l];
+    }
+    if (tail_lines == 0) {
+        buffer->line_state[new_count] = state;
+    }
+
+    buffer->line_count = new_count;
+    buffer->token_count += token_delta;
+    int lines_lexed = relexed.line_count;
+    TokenBufferFree(&relexed);
+    return lines_lexed;
+}
+
+// Parallel lexing
+
+typedef struct {
+    const char *text;
+    const size_t *chunk_begin;    // chunk_count + 1 offsets, each at a line start
+    TokenBuffer *parts;
+    uint8_t *end_states;
+} LexJob;
+
+static void LexChunkJob(void *ctx, int chunk, int begin, int end) {
+    (void)chunk;
+    LexJob *job = ctx;
+    for (int c = begin; c < end; c++) {
+        size_t offset = job->chunk_begin[c];
+        job->end_states[c] = LexBuffer(job->text + offset, job->chunk_begin[c + 1] - offset,
+                                       LEX_STATE_CODE, &job->parts[c]);
+    }
+}
+
+// Appends all lines of part to buffer, rebasing the token indices
+static void AppendPart(TokenBuffer *buffer, const TokenBuffer *part) {
+    if (!ReserveTokens(buffer, buffer->token_count + part->token_count) ||
+        !ReserveLines(buffer, buffer->line_count + part->line_count)) {
+        return;
+    }
+    uint32_t base = (uint32_t)buffer->token_count;
+    memcpy(buffer->token_column + base, part->token_column, sizeof(uint16_t) * part->token_count);
+    memcpy(buffer->token_length + base, part->token_length, sizeof(uint16_t) * part->token_count);
+    memcpy(buffer->token_kind + base, part->token_kind, sizeof(uint8_t) * part->token_count);
+    for (int32_t l = 0; l < part->line_count; l++) {
+        buffer->line_first[buffer->line_count + l] = part->line_first[l] + base;
+        buffer->line_state[buffer->line_count + l] = part->line_state[l];
+    }
+    buffer->line_count += part->line_count;
+    buffer->token_count += part->token_count;
+    buffer->line_first[buffer->line_count] = (uint32_t)buffer->token_count;
+    buffer->line_state[buffer->line_count] = part->line_state ? part->line_state[part->line_count] : LEX_STATE_CODE;
+}
+
+int LexBufferParallel(JobPool *pool, const char *text, size_t length, TokenBuffer *buffer) {
+    int threads = pool ? JobPoolWorkerCount(pool) + 1 : 1;
+    size_t chunk_size = length / ((size_t)threads * LEX_PARALLEL_CHUNKS_PER_THREAD);
+    if (chunk_size < LEX_PARALLEL_MIN_CHUNK) {
+        chunk_size = LEX_PARALLEL_MIN_CHUNK;
+    }
+    if (threads == 1 || length < 2 * chunk_size) {
+        LexBuffer(text, length, LEX_STATE_CODE, buffer);
+        return 0;
+    }
+
+    // Chunks end after a newline so every chunk starts a line
+    int max_chunks = (int)(length / chunk_size) + 1;
+    size_t *chunk_begin = TrackedMalloc(MEMORY_TAG_SYNTAX, sizeof(size_t) * (max_chunks + 1));
+    TokenBuffer *parts = TrackedCalloc(MEMORY_TAG_SYNTAX, max_chunks, sizeof(TokenBuffer));
+    uint8_t *end_states = TrackedMalloc(MEMORY_TAG_SYNTAX, max_chunks);
+    if (!chunk_begin || !parts || !end_states) {
+        TrackedFree(MEMORY_TAG_SYNTAX, chunk_begin);
+        TrackedFree(MEMORY_TAG_SYNTAX, parts);
+        TrackedFree(MEMORY_TAG_SYNTAX, end_states);
+        LexBuffer(text, length, LEX_STATE_CODE, buffer);
+        return 0;
+    }
+
+    int chunk_count = 0;
+    size_t offset = 0;
+    while (offset < length && chunk_count < max_chunks) {
+        chunk_begin[chunk_count++] = offset;
+        size_t target = offset + chunk_size;
+        if (target >= length || chunk_count == max_chunks) {
+            offset = length;
+            break;
+        }
+        const char *newline = memchr(text + target, '\n', length - target);
+        offset = newline ? (size_t)(newline - text) + 1 : length;
+    }
+    chunk_begin[chunk_count] = length;
+
+    LexJob job = {
+        .text = text,
+        .chunk_begin = chunk_begin,
+        .parts = parts,
+        .end_states = end_states
+    };
+    JobPoolParallelFor(pool, chunk_count, 1, LexChunkJob, &job);
+
+    // Stitch in order; a chunk that really starts inside an open construct
+    // (e.g. a block comment crossing the split) is lexed again
+    int relexed = 0;
+    uint8_t state = LEX_STATE_CODE;
+    for (int c = 0; c < chunk_count; c++) {
+        if (state != LEX_STATE_CODE) {
+            TokenBufferClear(&parts[c]);
+            end_states[c] = LexBuffer(text + chunk_begin[c], chunk_begin[c + 1] - chunk_begin[c], state, &parts[c]);
+            relexed++;
+        }
+        AppendPart(buffer, &parts[c]);
+        state = end_states[c];
+        TokenBufferFree(&parts[c]);
+    }
+
+    TrackedFree(MEMORY_TAG_SYNTAX, chunk_begin);
+    TrackedFree(MEMORY_TAG_SYNTAX, parts);
+    TrackedFree(MEMORY_TAG_SYNTAX, end_states);
+    return relexed;
+}
@@ -0,0 +1,88 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "job_pool.h"
+
+// Hand-written, table-driven C/C++ lexer for syntax coloring.
+//
+// It does not build a token stream for a parser: it only emits colored
+// spans, one list per line, into a structure-of-arrays TokenBuffer. Tokens
+// never cross a line; a block comment spanning lines yields one span per
+// line. Whitespace is not stored (it is the gap between spans), and runs
+// of punctuation are merged into one span.
+//
+// Identifier, whitespace, comment and string runs are classified 16 bytes
+// at a time with SSE2 on x86-64 and NEON on arm64; other targets (32-bit
+// ARM among them) use the scalar path.
+
+typedef enum {
+    TOKEN_IDENTIFIER = 0,
+    TOKEN_KEYWORD,        // Control flow keywords
+    TOKEN_TYPE,           // Type, storage and declaration keywords
+    TOKEN_NUMBER,
+    TOKEN_STRING,         // String, character and header-name literals
+    TOKEN_COMMENT,
+    TOKEN_DIRECTIVE,      // '#' plus the directive name
+    TOKEN_PUNCT,
+    TOKEN_KIND_COUNT
+} TokenKind;
+
+// Lexer state at a line start: what the previous line left open
+#define LEX_STATE_CODE          0u
+#define LEX_STATE_BLOCK_COMMENT 1u
+#define LEX_STATE_LINE_COMMENT  2u   // '//' comment continued with a backslash
+#define LEX_STATE_STRING        3u   // String continued with a backslash
+#define LEX_STATE_MODE_MASK     3u
+#define LEX_STATE_DIRECTIVE     4u   // Inside a preprocessor line
+
+#define LEX_MAX_COLUMN 0xffff        // Spans past this column are dropped
+
+// Token spans of one buffer. Line l owns tokens [line_first[l], line_first[l + 1]).
+typedef struct {
+    int32_t line_count;
+    int32_t line_capacity;
+    uint32_t *line_first;         // line_count + 1 entries
+    uint8_t *line_state;          // Checkpoint: state at the start of each line,
+                                  // plus the state at the end of the buffer
+
+    int32_t token_count;
+    int32_t token_capacity;
+    uint16_t *token_column;       // Byte offset from the line start
+    uint16_t *token_length;
+    uint8_t *token_kind;          // TokenKind
+} TokenBuffer;
+
+void TokenBufferInit(TokenBuffer *buffer);
+void TokenBufferFree(TokenBuffer *buffer);
+void TokenBufferClear(TokenBuffer *buffer);
+
+// Tokenizes text as consecutive lines appended to buffer, starting in
+// state (LEX_STATE_*); returns the state left open at the end of text
+uint8_t LexBuffer(const char *text, size_t length, uint8_t state, TokenBuffer *buffer);
+
+// Same result as LexBuffer from LEX_STATE_CODE, with the text split at
+// line boundaries across the pool. Chunks are lexed speculatively from the
+// code state; a chunk whose real start state differs is lexed again.
+// Returns the number of chunks that had to be lexed again.
+int LexBufferParallel(JobPool *pool, const char *text, size_t length, TokenBuffer *buffer);
+
+// Returns line `line` of the edited text, including its line terminator
+// (a trailing backslash only continues a line if the newline follows it)
+typedef const char *(*LexLineSource)(void *ctx, int line, size_t *length);
+
+// Updates the spans after lines [first_line, first_line + removed) were
+// replaced by `inserted` lines, read through source in the new numbering.
+// Lexing starts from the checkpoint of first_line and continues past the
+// inserted lines only while the state entering a line differs from its
+// stored checkpoint (e.g. after opening a block comment). Returns the
+// number of lines lexed.
+int LexEditLines(TokenBuffer *buffer, int first_line, int removed, int inserted,
+                 LexLineSource source, void *ctx);
+
+// Name of a token kind for logs and benchmark output
+const char *TokenKindName(TokenKind kind);
+
+#endif // LEXER_H
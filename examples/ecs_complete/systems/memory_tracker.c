@@ -0,0 +1,333 @@
+#include "memory_tracker.h"
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __APPLE__
+#include <malloc/malloc.h>
+#define MemoryUsableSize(ptr) malloc_size(ptr)
+#else
+#include <malloc.h>
+#define MemoryUsableSize(ptr) malloc_usable_size(ptr)
+#endif
+
+ECS_COMPONENT_DECLARE(MemoryStats);
+
+#define MEMORY_RATE_WINDOW_S 1.0
+
+// Updated from any thread
+typedef struct {
+    atomic_llong live;
+    atomic_llong peak;
+    atomic_llong allocations;
+    atomic_llong frees;
+    atomic_llong bytes_allocated;
+} MemoryCounters;
+
+static MemoryCounters counters[MEMORY_TAG_COUNT];
+
+static const char *tag_names[MEMORY_TAG_COUNT] = {
+    "ecs", "text", "files", "syntax", "index", "layout",
+    "physics", "impostor", "gpu", "arena", "io"
+};
+
+// Rate window of the system, main thread only
+static struct {
+    double elapsed;
+    int64_t allocations[MEMORY_TAG_COUNT];
+    int64_t bytes[MEMORY_TAG_COUNT];
+    bool total_over;
+} window;
+
+static void Charge(MemoryTag tag, int64_t bytes) {
+    MemoryCounters *c = &counters[tag];
+    int64_t live = atomic_fetch_add_explicit(&c->live, bytes, memory_order_relaxed) + bytes;
+    int64_t peak = atomic_load_explicit(&c->peak, memory_order_relaxed);
+    while (live > peak && !atomic_compare_exchange_weak(&c->peak, &peak, live)) {
+        // peak now holds what another thread stored; retry while still higher
+    }
+}
+
+static void CountAllocation(MemoryTag tag, void *ptr) {
+    int64_t size = (int64_t)MemoryUsableSize(ptr);
+    atomic_fetch_add_explicit(&counters[tag].allocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters[tag].bytes_allocated, size, memory_order_relaxed);
+    Charge(tag, size);
+}
+
+void *TrackedMalloc(MemoryTag tag, size_t size) {
+    void *ptr = malloc(size);
+    if (ptr) {
+        CountAllocation(tag, ptr);
+    }
+    return ptr;
+}
+
+void *TrackedCalloc(MemoryTag tag, size_t count, size_t size) {
+    void *ptr = calloc(count, size);
+    if (ptr) {
+        CountAllocation(tag, ptr);
+    }
+    return ptr;
+}
+
+// Counted as a free of the old block and an allocation of the new one
+void *TrackedRealloc(MemoryTag tag, void *ptr, size_t size) {
+    int64_t old_size = ptr ? (int64_t)MemoryUsableSize(ptr) : 0;
+    void *grown = realloc(ptr, size);
+    if (!grown) {
+        return NULL;
+    }
+    if (ptr) {
+        atomic_fetch_add_explicit(&counters[tag].frees, 1, memory_order_relaxed);
+        Charge(tag, -old_size);
+    }
+    CountAllocation(tag, grown);
+    return grown;
+}
+
+void TrackedFree(MemoryTag tag, void *ptr) {
+    if (!ptr) {
+        return;
+    }
+    atomic_fetch_add_explicit(&counters[tag].frees, 1, memory_order_relaxed);
+    Charge(tag, -(int64_t)MemoryUsableSize(ptr));
+    free(ptr);
+}
+
+bool GrowArray(MemoryTag tag, void **array, int *capacity, int needed, size_t element_size) {
+    if (needed <= *capacity) {
+        return true;
+    }
+    int new_capacity = *capacity > 0 ? *capacity : 256;
+    while (new_capacity < needed) {
+        // Stop doubling before int overflows; the last step lands on needed
+        new_capacity = new_capacity <= INT_MAX / 2 ? new_capacity * 2 : needed;
+    }
+    if ((size_t)new_capacity > SIZE_MAX / element_size) {
+        printf("Memory: %s array of %d elements is too large\n", MemoryTagName(tag), new_capacity);
+        return false;
+    }
+    void *grown = TrackedRealloc(tag, *array, (size_t)new_capacity * element_size);
+    if (!grown) {
+        printf("Memory: out of %s memory growing to %d elements\n", MemoryTagName(tag), new_capacity);
+        return false;
+    }
+    *array = grown;
+    *capacity = new_capacity;
+    return true;
+}
+
+void MemoryTrackExternal(MemoryTag tag, int64_t bytes) {
+    if (bytes > 0) {
+        atomic_fetch_add_explicit(&counters[tag].allocations, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&counters[tag].bytes_allocated, bytes, memory_order_relaxed);
+    } else if (bytes < 0) {
+        atomic_fetch_add_explicit(&counters[tag].frees, 1, memory_order_relaxed);
+    }
+    Charge(tag, bytes);
+}
+
+static void *EcsTrackedMalloc(ecs_size_t size) {
+    return TrackedMalloc(MEMORY_TAG_ECS, (size_t)size);
+}
+
+static void *EcsTrackedCalloc(ecs_size_t size) {
+    return TrackedCalloc(MEMORY_TAG_ECS, 1, (size_t)size);
+}
+
+static void *EcsTrackedRealloc(void *ptr, ecs_size_t size) {
+    return TrackedRealloc(MEMORY_TAG_ECS, ptr, (size_t)size);
+}
+
+static void EcsTrackedFree(void *ptr) {
+    TrackedFree(MEMORY_TAG_ECS, ptr);
+}
+
+void InstallMemoryTracker(void) {
+    ecs_os_set_api_defaults();
+    ecs_os_api_t api = ecs_os_get_api();
+    api.malloc_ = EcsTrackedMalloc;
+    api.calloc_ = EcsTrackedCalloc;
+    api.realloc_ = EcsTrackedRealloc;
+    api.free_ = EcsTrackedFree;
+    ecs_os_set_api(&api);
+}
+
+const char *MemoryTagName(MemoryTag tag) {
+    return tag >= 0 && tag < MEMORY_TAG_COUNT ? tag_names[tag] : "unknown";
+}
+
+int MemoryTagFromName(const char *name) {
+    for (int t = 0; t < MEMORY_TAG_COUNT; t++) {
+        if (strcmp(name, tag_names[t]) == 0) {
+            return t;
+        }
+    }
+    return -1;
+}
+
+void GetMemoryTagStats(MemoryTagStats out[MEMORY_TAG_COUNT]) {
+    for (int t = 0; t < MEMORY_TAG_COUNT; t++) {
+        MemoryCounters *c = &counters[t];
+        out[t] = (MemoryTagStats){
+            .live = atomic_load_explicit(&c->live, memory_order_relaxed),
+            .peak = atomic_load_explicit(&c->peak, memory_order_relaxed),
+            .allocations = atomic_load_explicit(&c->allocations, memory_order_relaxed),
+            .frees = atomic_load_explicit(&c->frees, memory_order_relaxed),
+            .bytes_allocated = atomic_load_explicit(&c->bytes_allocated, memory_order_relaxed)
+        };
+    }
+}
+
+void SetMemoryBudget(ecs_world_t *world, int tag, int64_t bytes) {
+    MemoryStats *stats = ecs_singleton_get_mut(world, MemoryStats);
+    if (tag < 0) {
+        stats->budget = bytes;
+    } else if (tag < MEMORY_TAG_COUNT) {
+        stats->tags[tag].budget = bytes;
+    }
+}
+
+bool ParseMemoryBudget(ecs_world_t *world, const char *spec) {
+    const char *equals = strchr(spec, '=');
+    int tag = -1;
+    if (equals) {
+        char name[32];
+        size_t length = (size_t)(equals - spec);
+        if (length >= sizeof(name)) {
+            length = sizeof(name) - 1;
+        }
+        memcpy(name, spec, length);
+        name[length] = '\0';
+        tag = MemoryTagFromName(name);
+        if (tag < 0) {
+            printf("Memory: unknown budget tag '%s'\n", name);
+            return false;
+        }
+        spec = equals + 1;
+    }
+    char *end = NULL;
+    double megabytes = strtod(spec, &end);
+    if (end == spec || megabytes < 0.0) {
+        printf("Memory: invalid budget '%s', expected TAG=MB or MB\n", spec);
+        return false;
+    }
+    SetMemoryBudget(world, tag, (int64_t)(megabytes * 1024.0 * 1024.0));
+    return true;
+}
+
+void WriteMemoryReportJson(ecs_world_t *world, FILE *file) {
+    const MemoryStats *stats = ecs_singleton_get(world, MemoryStats);
+    MemoryTagStats now[MEMORY_TAG_COUNT];
+    GetMemoryTagStats(now);
+
+    int64_t live = 0;
+    for (int t = 0; t < MEMORY_TAG_COUNT; t++) {
+        live += now[t].live;
+    }
+    fprintf(file, "{\"live\":%lld,\"peak\":%lld,\"budget\":%lld,\"tags\":{",
+            (long long)live, (long long)(stats ? stats->peak : live), (long long)(stats ? stats->budget : 0));
+    for (int t = 0; t < MEMORY_TAG_COUNT; t++) {
+        const MemoryTagStats *rates = stats ? &stats->tags[t] : &now[t];
+        int64_t budget = stats ? stats->tags[t].budget : 0;
+        fprintf(file, "%s\"%s\":{\"live\":%lld,\"peak\":%lld,\"allocations\":%lld,\"frees\":%lld,"
+                "\"bytes_allocated\":%lld,\"allocations_per_s\":%.1f,\"bytes_per_s\":%.1f,"
+                "\"budget\":%lld,\"over_budget\":%s}",
+                t > 0 ? "," : "", tag_names[t], (long long)now[t].live, (long long)now[t].peak,
+                (long long)now[t].allocations, (long long)now[t].frees, (long long)now[t].bytes_allocated,
+                rates->allocations_per_s, rates->bytes_per_s, (long long)budget,
+                budget > 0 && now[t].live > budget ? "true" : "false");
+    }
+    fprintf(file, "}}");
+}
+
+bool WriteMemoryReport(ecs_world_t *world, const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        printf("Memory: cannot write report to %s\n", path);
+        return false;
+    }
+    WriteMemoryReportJson(world, file);
+    fputc('\n', file);
+    bool written = fclose(file) == 0;
+    if (written) {
+        printf("Memory report written to %s\n", path);
+    }
+    return written;
+}
+
+void MemoryStatsSystem(ecs_iter_t *it) {
+    MemoryStats *stats = ecs_singleton_get_mut(it->world, MemoryStats);
+    if (!stats) {
+        return;
+    }
+    MemoryTagStats now[MEMORY_TAG_COUNT];
+    GetMemoryTagStats(now);
+
+    window.elapsed += it->delta_time;
+    bool rates_due = window.elapsed >= MEMORY_RATE_WINDOW_S;
+
+    stats->live = 0;
+    int32_t over_budget = 0;
+    for (int t = 0; t < MEMORY_TAG_COUNT; t++) {
+        MemoryTagStats *tag = &stats->tags[t];
+        tag->live = now[t].live;
+        tag->peak = now[t].peak;
+        tag->allocations = now[t].allocations;
+        tag->frees = now[t].frees;
+        tag->bytes_allocated = now[t].bytes_allocated;
+        if (rates_due) {
+            tag->allocations_per_s = (now[t].allocations - window.allocations[t]) / window.elapsed;
+            tag->bytes_per_s = (now[t].bytes_allocated - window.bytes[t]) / window.elapsed;
+            window.allocations[t] = now[t].allocations;
+            window.bytes[t] = now[t].bytes_allocated;
+        }
+
+        // Warn once each time a tag goes over its budget
+        bool over = tag->budget > 0 && tag->live > tag->budget;
+        if (over && !tag->over_budget) {
+            printf("Memory: %s over budget, %.1f of %.1f MB\n", tag_names[t],
+                   tag->live / (1024.0 * 1024.0), tag->budget / (1024.0 * 1024.0));
+        }
+        tag->over_budget = over;
+        over_budget += over;
+        stats->live += tag->live;
+    }
+    if (rates_due) {
+        window.elapsed = 0.0;
+    }
+
+    bool total_over = stats->budget > 0 && stats->live > stats->budget;
+    if (total_over && !window.total_over) {
+        printf("Memory: total over budget, %.1f of %.1f MB\n",
+               stats->live / (1024.0 * 1024.0), stats->budget / (1024.0 * 1024.0));
+    }
+    window.total_over = total_over;
+    stats->over_budget = over_budget + total_over;
+    if (stats->live > stats->peak) {
+        stats->peak = stats->live;
+    }
+}
+
+void RegisterMemoryTracker(ecs_world_t *world) {
+    ECS_COMPONENT_DEFINE(world, MemoryStats);
+    ecs_singleton_set(world, MemoryStats, {0});
+
+    // Counters are process-wide; rates of this world start from here
+    MemoryTagStats now[MEMORY_TAG_COUNT];
+    GetMemoryTagStats(now);
+    memset(&window, 0, sizeof(window));
+    for (int t = 0; t < MEMORY_TAG_COUNT; t++) {
+        window.allocations[t] = now[t].allocations;
+        window.bytes[t] = now[t].bytes_allocated;
+    }
+
+    ecs_system(world, {
+        .entity = ecs_entity(world, {
+            .name = "MemoryStatsSystem",
+            .add = ecs_ids(ecs_dependson(EcsPostFrame))
+        }),
+        .callback = MemoryStatsSystem
+    });
+}
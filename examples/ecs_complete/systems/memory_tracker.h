@@ -0,0 +1,100 @@
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+#include <flecs.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Live bytes and allocation rate per subsystem.
+//
+// Modules allocate through TrackedMalloc/TrackedRealloc/TrackedFree with
+// their tag instead of malloc/realloc/free; flecs goes through the same
+// counters once InstallMemoryTracker has replaced its ecs_os_api
+// allocator. A block is charged its usable size as reported by the C
+// library, so nothing is stored next to it and a tracked block may still be
+// freed with plain free (its bytes then stay charged). Memory that is not
+// on the heap, mapped files and GPU textures, is reported with
+// MemoryTrackExternal.
+//
+// Budgets are optional per tag and for the total. MemoryStatsSystem
+// computes the rates once per second and warns when a budget is first
+// exceeded.
+
+typedef enum {
+    MEMORY_TAG_ECS,         // Flecs tables, queries, command queues
+    MEMORY_TAG_TEXT,        // Piece tables and add buffers
+    MEMORY_TAG_FILES,       // Mapped file bytes (external)
+    MEMORY_TAG_SYNTAX,      // Lexer output and per-file token spans
+    MEMORY_TAG_INDEX,       // Include graph, symbol, search and finder indexes
+    MEMORY_TAG_LAYOUT,      // Layout solver arrays
+    MEMORY_TAG_PHYSICS,     // Collision and picking bookkeeping
+    MEMORY_TAG_IMPOSTOR,    // Minimap images on the CPU
+    MEMORY_TAG_GPU,         // Uploaded textures (external, estimated)
+    MEMORY_TAG_ARENA,       // Frame arena chunks
+    MEMORY_TAG_IO,          // Workspace snapshots, autosave jobs and remote clients
+    MEMORY_TAG_COUNT
+} MemoryTag;
+
+typedef struct {
+    int64_t live;             // Bytes currently allocated
+    int64_t peak;
+    int64_t allocations;      // Since start
+    int64_t frees;
+    int64_t bytes_allocated;  // Since start
+    double allocations_per_s; // Over the last second
+    double bytes_per_s;
+    int64_t budget;           // 0 = none
+    bool over_budget;
+} MemoryTagStats;
+
+typedef struct {
+    MemoryTagStats tags[MEMORY_TAG_COUNT];
+    int64_t live;             // All tags
+    int64_t peak;             // Largest live seen by the system
+    int64_t budget;           // Total budget, 0 = none
+    int32_t over_budget;      // Tags over their budget, plus one if the total is
+} MemoryStats;
+
+extern ECS_COMPONENT_DECLARE(MemoryStats);
+
+// Route flecs allocations through the tracker. Call before the first
+// ecs_init, so no block flecs frees was allocated untracked.
+void InstallMemoryTracker(void);
+
+void *TrackedMalloc(MemoryTag tag, size_t size);
+void *TrackedCalloc(MemoryTag tag, size_t count, size_t size);
+void *TrackedRealloc(MemoryTag tag, void *ptr, size_t size);
+void TrackedFree(MemoryTag tag, void *ptr);
+
+// Grow a tracked array to hold at least needed elements, doubling from 256.
+// On failure the array and capacity are left unchanged.
+bool GrowArray(MemoryTag tag, void **array, int *capacity, int needed, size_t element_size);
+
+// Memory owned elsewhere: bytes > 0 when acquired, < 0 when released
+void MemoryTrackExternal(MemoryTag tag, int64_t bytes);
+
+const char *MemoryTagName(MemoryTag tag);
+// -1 if name is not a tag
+int MemoryTagFromName(const char *name);
+
+// Counters of every tag right now (rates are filled in by the system)
+void GetMemoryTagStats(MemoryTagStats out[MEMORY_TAG_COUNT]);
+
+// Budget in bytes for a tag, or for the total with tag = -1; 0 clears it
+void SetMemoryBudget(ecs_world_t *world, int tag, int64_t bytes);
+
+// Parse "TAG=MB" or "MB" (total) from the command line
+bool ParseMemoryBudget(ecs_world_t *world, const char *spec);
+
+// Per-tag report as a JSON object
+void WriteMemoryReportJson(ecs_world_t *world, FILE *file);
+bool WriteMemoryReport(ecs_world_t *world, const char *path);
+
+// Systems
+void MemoryStatsSystem(ecs_iter_t *it);
+
+void RegisterMemoryTracker(ecs_world_t *world);
+
+#endif // MEMORY_TRACKER_H
@@ -37,12 +37,19 @@ void OnSelectionChanged(ecs_iter_t *it) {
 void OnFileModified(ecs_iter_t *it) {
     FileReference *file_refs = ecs_field(it, FileReference, 0);
     
+    // Phantoms of one file arrive together (a bulk insert sets a whole
+    // file), so a run of the same path is checked with one stat
+    struct stat file_stat;
+    const char *stat_path = NULL;
+    bool stat_ok = false;
+    
     for (int i = 0; i < it->count; i++) {
-        ecs_entity_t file_entity = it->entities[i];
-        
         // Check if file needs reloading
-        struct stat file_stat;
-        if (stat(file_refs[i].filepath, &file_stat) == 0) {
+        if (!stat_path || strcmp(stat_path, file_refs[i].filepath) != 0) {
+            stat_path = file_refs[i].filepath;
+            stat_ok = stat(stat_path, &file_stat) == 0;
+        }
+        if (stat_ok) {
             if (file_stat.st_mtime > file_refs[i].last_modified) {
                 printf("File %s modified, reloading phantoms\n", file_refs[i].filepath);
                 
@@ -0,0 +1,693 @@
+#include "picking.h"
+#include "collision.h"
+#include "profiler.h"
+#include "search_index.h"
+#include "fuzzy_finder.h"
+#include "memory_tracker.h"
+#include <float.h>
+#include <math.h>
+#include <raymath.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef PEVI_WITH_JOLT
+#include <joltc.h>
+#endif
+
+ECS_COMPONENT_DECLARE(PickProxy);
+ECS_COMPONENT_DECLARE(PickingSettings);
+ECS_COMPONENT_DECLARE(PickingStats);
+
+#define PICK_NO_BODY 0xffffffffu           // Same bit pattern as Jolt's invalid BodyID
+#define PICK_BODY_INDEX_MASK 0x007fffffu   // BodyID bits holding the body index
+
+// Proxy spheres live outside the ECS as flat arrays. Slots are dense;
+// removal swaps the last slot into the hole.
+typedef struct {
+    int count;
+    int capacity;
+    ecs_entity_t *entities;
+    float *cx, *cy, *cz;          // Sphere centers
+    float *radius;
+    uint32_t *bodies;             // Jolt body IDs, PICK_NO_BODY until inserted
+
+    int32_t *pending;             // Slots waiting for batch insertion
+    int pending_count;
+    int pending_capacity;
+
+    int32_t *body_slots;          // Body index -> slot, sized to the body capacity
+    int max_bodies;
+
+    // Query in flight (broadphase callbacks only receive this struct)
+    Ray ray;
+    float ray_length;
+    float best_distance;
+    ecs_entity_t best_entity;
+    bool region_is_box;
+    BoundingBox box;
+    Vector3 sphere_center;
+    float sphere_radius;
+    ecs_entity_t *results;
+    int result_count;
+    int result_capacity;
+    int candidate_count;
+
+    ecs_query_t *scan_query;      // EcsTransform + BoundingSphere, used by the scan backend
+
+#ifdef PEVI_WITH_JOLT
+    JPH_PhysicsSystem *system;
+    JPH_BodyInterface *body_interface;
+    const JPH_BroadPhaseQuery *query;
+    JPH_BroadPhaseLayerFilter *layer_filter;
+#endif
+} PickWorld;
+
+// The pick world belongs to the world that registered the module: systems
+// and the observer get it as ctx, API calls find it through this singleton
+typedef struct {
+    PickWorld *picking;
+} PickingModule;
+
+static ECS_COMPONENT_DECLARE(PickingModule);
+
+static PickWorld *GetPicking(const ecs_world_t *world) {
+    const PickingModule *module = ecs_singleton_get(world, PickingModule);
+    return module ? module->picking : NULL;
+}
+
+static bool ReserveSlots(PickWorld *p, int count) {
+    if (count <= p->capacity) {
+        return true;
+    }
+    int capacity = p->capacity;
+    float **float_arrays[] = {&p->cx, &p->cy, &p->cz, &p->radius};
+    for (size_t a = 0; a < sizeof(float_arrays) / sizeof(float_arrays[0]); a++) {
+        int tmp = capacity;
+        if (!GrowArray(MEMORY_TAG_PHYSICS, (void**)float_arrays[a], &tmp, count, sizeof(float))) {
+            return false;
+        }
+    }
+    int tmp = capacity;
+    if (!GrowArray(MEMORY_TAG_PHYSICS, (void**)&p->bodies, &tmp, count, sizeof(uint32_t))) {
+        return false;
+    }
+    tmp = capacity;
+    if (!GrowArray(MEMORY_TAG_PHYSICS, (void**)&p->entities, &tmp, count, sizeof(ecs_entity_t))) {
+        return false;
+    }
+    p->capacity = tmp;
+    return true;
+}
+
+static void PushPending(PickWorld *p, int32_t slot) {
+    if (GrowArray(MEMORY_TAG_PHYSICS, (void**)&p->pending, &p->pending_capacity, p->pending_count + 1,
+                  sizeof(int32_t))) {
+        p->pending[p->pending_count++] = slot;
+    }
+}
+
+// Renames a pending slot after a swap removal; to = -1 drops it
+static void RetargetPending(PickWorld *p, int32_t from, int32_t to) {
+    int kept = 0;
+    for (int k = 0; k < p->pending_count; k++) {
+        int32_t slot = p->pending[k] == from ? to : p->pending[k];
+        if (slot >= 0) {
+            p->pending[kept++] = slot;
+        }
+    }
+    p->pending_count = kept;
+}
+
+static void PushResult(PickWorld *p, ecs_entity_t entity) {
+    if (GrowArray(MEMORY_TAG_PHYSICS, (void**)&p->results, &p->result_capacity, p->result_count + 1,
+                  sizeof(ecs_entity_t))) {
+        p->results[p->result_count++] = entity;
+    }
+}
+
+// Exact region test shared by both backends
+static bool RegionContains(const PickWorld *p, Vector3 center, float radius) {
+    if (p->region_is_box) {
+        return CheckCollisionBoxSphere(p->box, center, radius);
+    }
+    return CheckCollisionSpheres(p->sphere_center, p->sphere_radius, center, radius);
+}
+
+static Vector3 SphereCenter(const EcsTransform *transform, const BoundingSphere *bounds) {
+    return Vector3Transform(bounds->center_offset, transform->world_matrix);
+}
+
+#ifdef PEVI_WITH_JOLT
+
+static bool AttachPickingWorld(const ecs_world_t *world, PickWorld *p, int max_bodies) {
+    p->system = CollisionPhysicsSystem(world);
+    if (!p->system) {
+        return false;
+    }
+    p->body_interface = JPH_PhysicsSystem_GetBodyInterface(p->system);
+    p->query = JPH_PhysicsSystem_GetBroadPhaseQuery(p->system);
+    p->layer_filter = CollisionLayerFilter(world, COLLISION_LAYER_PHANTOMS);
+
+    p->body_slots = TrackedMalloc(MEMORY_TAG_PHYSICS, sizeof(int32_t) * max_bodies);
+    if (!p->body_slots) {
+        printf("Picking: out of memory for %d bodies\n", max_bodies);
+        return false;
+    }
+    p->max_bodies = max_bodies;
+    return true;
+}
+
+static void DestroyBody(PickWorld *p, int32_t slot) {
+    if (p->bodies[slot] != PICK_NO_BODY) {
+        JPH_BodyInterface_RemoveAndDestroyBody(p->body_interface, p->bodies[slot]);
+        p->bodies[slot] = PICK_NO_BODY;
+    }
+}
+
+static void MoveBody(PickWorld *p, int32_t slot) {
+    if (p->bodies[slot] != PICK_NO_BODY) {
+        JPH_RVec3 position = {p->cx[slot], p->cy[slot], p->cz[slot]};
+        JPH_BodyInterface_SetPosition(p->body_interface, p->bodies[slot], &position, JPH_Activation_DontActivate);
+    }
+}
+
+// Creates all pending bodies first and adds them in one sweep (see
+// collision.c); a file's worth of line phantoms arrives as one batch
+static void InsertPending(PickWorld *p, const PickingSettings *settings, PickingStats *stats) {
+    if (p->pending_count == 0) {
+        return;
+    }
+
+    int created = 0;
+    for (int k = 0; k < p->pending_count; k++) {
+        int32_t slot = p->pending[k];
+        JPH_SphereShape *shape = JPH_SphereShape_Create(p->radius[slot]);
+        JPH_RVec3 position = {p->cx[slot], p->cy[slot], p->cz[slot]};
+        JPH_BodyCreationSettings *body_settings = JPH_BodyCreationSettings_Create3(
+            (const JPH_Shape*)shape, &position, NULL, JPH_MotionType_Static, COLLISION_LAYER_PHANTOMS);
+        JPH_Body *body = JPH_BodyInterface_CreateBody(p->body_interface, body_settings);
+        JPH_BodyCreationSettings_Destroy(body_settings);
+        JPH_Shape_Destroy((JPH_Shape*)shape);  // The body holds its own reference
+        if (!body) {
+            printf("Picking: body limit reached (%d proxies)\n", p->count);
+            break;
+        }
+
+        JPH_BodyID id = JPH_Body_GetID(body);
+        p->bodies[slot] = id;
+        p->body_slots[id & PICK_BODY_INDEX_MASK] = slot;
+        p->pending[created++] = slot;
+    }
+
+    for (int k = 0; k < created; k++) {
+        JPH_BodyInterface_AddBody(p->body_interface, p->bodies[p->pending[k]], JPH_Activation_DontActivate);
+    }
+    if (created >= settings->optimize_batch) {
+        JPH_PhysicsSystem_OptimizeBroadPhase(p->system);
+    }
+
+    stats->inserted_frame = created;
+    stats->batches++;
+    p->pending_count = 0;
+}
+
+// Maps a broadphase hit back to a live slot; the full ID check rejects
+// bodies that were destroyed after the last sync
+static int32_t SlotOfBody(const PickWorld *p, JPH_BodyID body) {
+    int32_t slot = p->body_slots[body & PICK_BODY_INDEX_MASK];
+    if (slot < 0 || slot >= p->count || p->bodies[slot] != body) {
+        return -1;
+    }
+    return slot;
+}
+
+// The broadphase only knows body bounds: each candidate gets the exact
+// sphere test, and the early-out fraction shrinks to the closest hit
+static float CollectRayHit(void *context, const JPH_BroadPhaseCastResult *result) {
+    PickWorld *p = context;
+    p->candidate_count++;
+    int32_t slot = SlotOfBody(p, result->bodyID);
+    if (slot >= 0) {
+        Vector3 center = {p->cx[slot], p->cy[slot], p->cz[slot]};
+        RayCollision hit = GetRayCollisionSphere(p->ray, center, p->radius[slot]);
+        if (hit.hit && hit.distance < p->best_distance) {
+            p->best_distance = hit.distance;
+            p->best_entity = p->entities[slot];
+        }
+    }
+    return fminf(p->best_distance / p->ray_length, 1.0f);
+}
+
+static float CollectRegionHit(void *context, const JPH_BodyID body) {
+    PickWorld *p = context;
+    p->candidate_count++;
+    int32_t slot = SlotOfBody(p, body);
+    if (slot >= 0) {
+        Vector3 center = {p->cx[slot], p->cy[slot], p->cz[slot]};
+        if (RegionContains(p, center, p->radius[slot])) {
+            PushResult(p, p->entities[slot]);
+        }
+    }
+    return FLT_MAX;  // Keep collecting
+}
+
+static void QueryRay(PickWorld *p) {
+    JPH_Vec3 origin = {p->ray.position.x, p->ray.position.y, p->ray.position.z};
+    JPH_Vec3 direction = {p->ray.direction.x * p->ray_length,
+                          p->ray.direction.y * p->ray_length,
+                          p->ray.direction.z * p->ray_length};
+    JPH_BroadPhaseQuery_CastRay(p->query, &origin, &direction, CollectRayHit, p, p->layer_filter, NULL);
+}
+
+static void QueryRegion(PickWorld *p) {
+    if (p->region_is_box) {
+        JPH_AABox box = {
+            .min = {p->box.min.x, p->box.min.y, p->box.min.z},
+            .max = {p->box.max.x, p->box.max.y, p->box.max.z}
+        };
+        JPH_BroadPhaseQuery_CollideAABox(p->query, &box, CollectRegionHit, p, p->layer_filter, NULL);
+    } else {
+        JPH_Vec3 center = {p->sphere_center.x, p->sphere_center.y, p->sphere_center.z};
+        JPH_BroadPhaseQuery_CollideSphere(p->query, &center, p->sphere_radius, CollectRegionHit, p,
+                                          p->layer_filter, NULL);
+    }
+}
+
+#else
+
+static bool AttachPickingWorld(const ecs_world_t *world, PickWorld *p, int max_bodies) {
+    (void)world;
+    (void)p;
+    (void)max_bodies;
+    return false;
+}
+
+static void DestroyBody(PickWorld *p, int32_t slot) {
+    p->bodies[slot] = PICK_NO_BODY;
+}
+
+static void MoveBody(PickWorld *p, int32_t slot) {
+    (void)p;
+    (void)slot;
+}
+
+static void InsertPending(PickWorld *p, const PickingSettings *settings, PickingStats *stats) {
+    (void)settings;
+    (void)stats;
+    p->pending_count = 0;
+}
+
+static void QueryRay(PickWorld *p) {
+    (void)p;
+}
+
+static void QueryRegion(PickWorld *p) {
+    (void)p;
+}
+
+#endif
+
+// Linear fallback over every bounding sphere
+static void ScanRay(ecs_world_t *world, PickWorld *p) {
+    ecs_iter_t it = ecs_query_iter(world, p->scan_query);
+    while (ecs_query_next(&it)) {
+        const EcsTransform *transforms = ecs_field(&it, EcsTransform, 0);
+        const BoundingSphere *bounds = ecs_field(&it, BoundingSphere, 1);
+        for (int i = 0; i < it.count; i++) {
+            p->candidate_count++;
+            RayCollision hit = GetRayCollisionSphere(p->ray, SphereCenter(&transforms[i], &bounds[i]),
+                                                     bounds[i].radius);
+            if (hit.hit && hit.distance < p->best_distance) {
+                p->best_distance = hit.distance;
+                p->best_entity = it.entities[i];
+            }
+        }
+    }
+}
+
+static void ScanRegion(ecs_world_t *world, PickWorld *p) {
+    ecs_iter_t it = ecs_query_iter(world, p->scan_query);
+    while (ecs_query_next(&it)) {
+        const EcsTransform *transforms = ecs_field(&it, EcsTransform, 0);
+        const BoundingSphere *bounds = ecs_field(&it, BoundingSphere, 1);
+        for (int i = 0; i < it.count; i++) {
+            p->candidate_count++;
+            if (RegionContains(p, SphereCenter(&transforms[i], &bounds[i]), bounds[i].radius)) {
+                PushResult(p, it.entities[i]);
+            }
+        }
+    }
+}
+
+// Jolt answers when it is linked, selected and the proxies are registered
+static bool UseJolt(const PickWorld *p, const PickingSettings *settings) {
+    return settings->backend == PICK_BACKEND_JOLT && p->body_slots != NULL;
+}
+
+ecs_entity_t PickPhantom(ecs_world_t *world, Ray ray, float *distance) {
+    PickWorld *p = GetPicking(world);
+    const PickingSettings *settings = ecs_singleton_get(world, PickingSettings);
+    PickingStats *stats = ecs_singleton_get_mut(world, PickingStats);
+    if (!p || !settings || !stats || !p->scan_query) {
+        return 0;
+    }
+
+    PROFILE_ZONE_BEGIN(PickPhantom);
+    uint64_t start = ProfilerNow();
+    p->ray = ray;
+    p->ray.direction = Vector3Normalize(ray.direction);
+    p->ray_length = settings->max_distance;
+    p->best_distance = settings->max_distance;
+    p->best_entity = 0;
+    p->candidate_count = 0;
+
+    bool jolt = UseJolt(p, settings);
+    if (jolt) {
+        QueryRay(p);
+    } else {
+        ScanRay(world, p);
+    }
+
+    stats->candidates = p->candidate_count;
+    stats->hits = p->best_entity != 0;
+    stats->query_us = (ProfilerNow() - start) / 1e3;
+    stats->last_query_jolt = jolt;
+    if (distance) {
+        *distance = p->best_distance;
+    }
+    PROFILE_ZONE_END(PickPhantom);
+    return p->best_entity;
+}
+
+// Runs the region query of the active backend and replaces the selection
+static int SelectRegion(ecs_world_t *world, PickWorld *p) {
+    const PickingSettings *settings = ecs_singleton_get(world, PickingSettings);
+    PickingStats *stats = ecs_singleton_get_mut(world, PickingStats);
+    if (!settings || !stats || !p->scan_query) {
+        return 0;
+    }
+
+    PROFILE_ZONE_BEGIN(SelectRegion);
+    uint64_t start = ProfilerNow();
+    p->result_count = 0;
+    p->candidate_count = 0;
+
+    bool jolt = UseJolt(p, settings);
+    if (jolt) {
+        QueryRegion(p);
+    } else {
+        ScanRegion(world, p);
+    }
+    stats->candidates = p->candidate_count;
+    stats->hits = p->result_count;
+    stats->query_us = (ProfilerNow() - start) / 1e3;
+    stats->last_query_jolt = jolt;
+
+    // Deselect first so the selection observer restores the old phantoms
+    ecs_defer_begin(world);
+    ecs_iter_t it = ecs_each_id(world, ecs_id(Selected));
+    while (ecs_each_next(&it)) {
+        for (int i = 0; i < it.count; i++) {
+            ecs_set(world, it.entities[i], Selected, {.is_selected = false});
+            ecs_remove(world, it.entities[i], Selected);
+        }
+    }
+
+    float now = (float)ecs_get_world_info(world)->world_time_total;
+    for (int k = 0; k < p->result_count; k++) {
+        ecs_set(world, p->results[k], Selected, {
+            .is_selected = true,
+            .selection_id = (uint32_t)k,
+            .selection_time = now
+        });
+    }
+    ecs_defer_end(world);
+    PROFILE_ZONE_END(SelectRegion);
+    return p->result_count;
+}
+
+int SelectPhantomsInBox(ecs_world_t *world, BoundingBox box) {
+    PickWorld *p = GetPicking(world);
+    if (!p) {
+        return 0;
+    }
+    p->region_is_box = true;
+    p->box = box;
+    return SelectRegion(world, p);
+}
+
+int SelectPhantomsInSphere(ecs_world_t *world, Vector3 center, float radius) {
+    PickWorld *p = GetPicking(world);
+    if (!p) {
+        return 0;
+    }
+    p->region_is_box = false;
+    p->sphere_center = center;
+    p->sphere_radius = radius;
+    return SelectRegion(world, p);
+}
+
+// Brings a proxy in line with the ECS: allocates new slots and follows
+// transforms that TransformSystem recomputed this frame
+static bool SyncProxy(PickWorld *p, ecs_entity_t entity, PickProxy *proxy,
+                      const EcsTransform *transform, const BoundingSphere *bounds) {
+    if (proxy->slot >= 0 && !transform->changed) {
+        return false;
+    }
+
+    Vector3 center = SphereCenter(transform, bounds);
+    if (proxy->slot < 0) {
+        if (!ReserveSlots(p, p->count + 1)) {
+            return false;
+        }
+        int32_t slot = p->count++;
+        p->entities[slot] = entity;
+        p->cx[slot] = center.x;
+        p->cy[slot] = center.y;
+        p->cz[slot] = center.z;
+        p->radius[slot] = bounds->radius;
+        p->bodies[slot] = PICK_NO_BODY;
+        proxy->slot = slot;
+        PushPending(p, slot);
+        return false;
+    }
+
+    int32_t slot = proxy->slot;
+    p->cx[slot] = center.x;
+    p->cy[slot] = center.y;
+    p->cz[slot] = center.z;
+    MoveBody(p, slot);
+    return true;
+}
+
+// Runs after TransformSystem; untouched proxies cost one flag test
+void PickProxySystem(ecs_iter_t *it) {
+    PickWorld *p = it->ctx;
+    const PickingSettings *settings = ecs_singleton_get(it->world, PickingSettings);
+    PickingStats *stats = ecs_singleton_get_mut(it->world, PickingStats);
+    if (!settings || !stats || !p->body_slots) {
+        ecs_iter_fini(it);
+        return;
+    }
+
+    PROFILE_ZONE_BEGIN(PickProxySystem);
+    stats->inserted_frame = 0;
+    stats->synced_frame = 0;
+
+    while (ecs_iter_next(it)) {
+        PickProxy *proxies = ecs_field(it, PickProxy, 0);
+        const EcsTransform *transforms = ecs_field(it, EcsTransform, 1);
+        const BoundingSphere *bounds = ecs_field(it, BoundingSphere, 2);
+
+        for (int i = 0; i < it->count; i++) {
+            stats->synced_frame += SyncProxy(p, it->entities[i], &proxies[i], &transforms[i], &bounds[i]);
+        }
+    }
+
+    InsertPending(p, settings, stats);
+    stats->proxies = p->count;
+    PROFILE_ZONE_END(PickProxySystem);
+}
+
+// Command mode: B selects the box, O the sphere around the camera target
+void RegionSelectSystem(ecs_iter_t *it) {
+    const PickWorld *p = it->ctx;
+    EditorState *editor_states = ecs_field(it, EditorState, 0);
+    const InputFrame *input = ecs_singleton_get(it->world, InputFrame);
+    const ViewState *view = ecs_singleton_get(it->world, ViewState);
+    const PickingSettings *settings = ecs_singleton_get(it->world, PickingSettings);
+    if (!input || !view || !settings || !(input->box_select_pressed || input->sphere_select_pressed)) {
+        return;
+    }
+
+    // B and O are plain letters while the search or finder prompt is open
+    const SearchPrompt *prompt = ecs_singleton_get(it->world, SearchPrompt);
+    const FinderPrompt *finder_prompt = ecs_singleton_get(it->world, FinderPrompt);
+    if ((prompt && prompt->active) || (finder_prompt && finder_prompt->active)) {
+        return;
+    }
+
+    for (int i = 0; i < it->count; i++) {
+        if (editor_states[i].current_mode != 2) {
+            continue;
+        }
+
+        Vector3 center = view->camera_target;
+        float r = settings->select_radius;
+        int selected;
+        if (input->box_select_pressed) {
+            BoundingBox box = {
+                .min = {center.x - r, center.y - r, center.z - r},
+                .max = {center.x + r, center.y + r, center.z + r}
+            };
+            selected = SelectPhantomsInBox(it->world, box);
+        } else {
+            selected = SelectPhantomsInSphere(it->world, center, r);
+        }
+        editor_states[i].focused_entity = selected > 0 ? p->results[0] : 0;
+        printf("Region select: %d phantoms\n", selected);
+    }
+}
+
+// Frees the proxy's body and moves the last slot into the hole
+void OnPickProxyRemoved(ecs_iter_t *it) {
+    PickWorld *p = it->ctx;
+    PickProxy *proxies = ecs_field(it, PickProxy, 0);
+    if (!p->body_slots) {
+        return;
+    }
+
+    for (int i = 0; i < it->count; i++) {
+        int32_t slot = proxies[i].slot;
+        if (slot < 0 || slot >= p->count || p->entities[slot] != it->entities[i]) {
+            continue;
+        }
+        DestroyBody(p, slot);
+        RetargetPending(p, slot, -1);
+
+        int32_t last = --p->count;
+        if (slot != last) {
+            p->entities[slot] = p->entities[last];
+            p->cx[slot] = p->cx[last];
+            p->cy[slot] = p->cy[last];
+            p->cz[slot] = p->cz[last];
+            p->radius[slot] = p->radius[last];
+            p->bodies[slot] = p->bodies[last];
+            if (p->bodies[slot] != PICK_NO_BODY) {
+                p->body_slots[p->bodies[slot] & PICK_BODY_INDEX_MASK] = slot;
+            } else {
+                RetargetPending(p, last, slot);
+            }
+            PickProxy *moved = ecs_get_mut(it->world, p->entities[slot], PickProxy);
+            if (moved) {
+                moved->slot = slot;
+            }
+        }
+    }
+}
+
+static void PickProxyCtor(void *ptr, int32_t count, const ecs_type_info_t *ti) {
+    (void)ti;
+    PickProxy *proxies = ptr;
+    for (int i = 0; i < count; i++) {
+        proxies[i].slot = -1;
+    }
+}
+
+// Bodies were destroyed with the shared physics system (collision.c)
+static void PickingFini(ecs_world_t *world, void *ctx) {
+    (void)world;
+    PickWorld *p = ctx;
+    TrackedFree(MEMORY_TAG_PHYSICS, p->entities);
+    TrackedFree(MEMORY_TAG_PHYSICS, p->cx);
+    TrackedFree(MEMORY_TAG_PHYSICS, p->cy);
+    TrackedFree(MEMORY_TAG_PHYSICS, p->cz);
+    TrackedFree(MEMORY_TAG_PHYSICS, p->radius);
+    TrackedFree(MEMORY_TAG_PHYSICS, p->bodies);
+    TrackedFree(MEMORY_TAG_PHYSICS, p->pending);
+    TrackedFree(MEMORY_TAG_PHYSICS, p->body_slots);
+    TrackedFree(MEMORY_TAG_PHYSICS, p->results);
+    TrackedFree(MEMORY_TAG_PHYSICS, p);
+}
+
+void RegisterPickingSystems(ecs_world_t *world) {
+    ECS_COMPONENT_DEFINE(world, PickProxy);
+    ECS_COMPONENT_DEFINE(world, PickingSettings);
+    ECS_COMPONENT_DEFINE(world, PickingStats);
+    ECS_COMPONENT_DEFINE(world, PickingModule);
+
+    ecs_set_hooks(world, PickProxy, {
+        .ctor = PickProxyCtor
+    });
+
+    // Every pickable entity gets a proxy automatically
+    ecs_add_pair(world, ecs_id(BoundingSphere), EcsWith, ecs_id(PickProxy));
+
+    ecs_singleton_set(world, PickingSettings, {
+        .backend = CollisionAvailable() ? PICK_BACKEND_JOLT : PICK_BACKEND_SCAN,
+        .max_distance = 1000.0f,
+        .select_radius = 10.0f,
+        .optimize_batch = 256
+    });
+    ecs_singleton_set(world, PickingStats, {0});
+
+    PickWorld *p = TrackedCalloc(MEMORY_TAG_PHYSICS, 1, sizeof(PickWorld));
+    if (!p) {
+        printf("Picking: out of memory\n");
+        return;
+    }
+    p->scan_query = ecs_query(world, {
+        .terms = {
+            { ecs_id(EcsTransform), .inout = EcsIn },
+            { ecs_id(BoundingSphere), .inout = EcsIn }
+        }
+    });
+    ecs_singleton_set(world, PickingModule, {p});
+    ecs_atfini(world, PickingFini, p);
+
+    ecs_entity_t region_select = ecs_system(world, {
+        .entity = ecs_entity(world, {
+            .name = "RegionSelectSystem",
+            .add = ecs_ids(ecs_dependson(EcsOnUpdate))
+        }),
+        .query.terms = {
+            { ecs_id(EditorState) }
+        },
+        .callback = RegionSelectSystem,
+        .ctx = p
+    });
+
+    const CollisionSettings *collision_settings = ecs_singleton_get(world, CollisionSettings);
+    if (!collision_settings || !AttachPickingWorld(world, p, collision_settings->max_bodies)) {
+        printf("Picking uses the linear scan (no Jolt world)\n");
+        return;
+    }
+
+    // Proxies follow this frame's transforms, so the sync runs after
+    // TransformSystem and region selection sees the synced bodies
+    ecs_entity_t proxy_system = ecs_system(world, {
+        .entity = ecs_entity(world, {
+            .name = "PickProxySystem",
+            .add = ecs_ids(ecs_dependson(EcsOnUpdate))
+        }),
+        .query.terms = {
+            { ecs_id(PickProxy) },
+            { ecs_id(EcsTransform), .inout = EcsIn },
+            { ecs_id(BoundingSphere), .inout = EcsIn }
+        },
+        .run = PickProxySystem,
+        .ctx = p
+    });
+    ecs_entity_t transform_system = ecs_lookup(world, "TransformSystem");
+    if (transform_system) {
+        ecs_add_pair(world, proxy_system, EcsDependsOn, transform_system);
+    }
+    ecs_add_pair(world, region_select, EcsDependsOn, proxy_system);
+
+    ecs_observer_desc_t removed_desc = {0};
+    removed_desc.query.terms[0].id = ecs_id(PickProxy);
+    removed_desc.events[0] = EcsOnRemove;
+    removed_desc.callback = OnPickProxyRemoved;
+    removed_desc.ctx = p;
+    ecs_observer_init(world, &removed_desc);
+}
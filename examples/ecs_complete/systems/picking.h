@@ -0,0 +1,67 @@
+#ifndef PICKING_H
+#define PICKING_H
+
+#include <flecs.h>
+#include <stdbool.h>
+#include "../components/spatial.h"
+
+// Ray picking and region selection of phantoms.
+//
+// Every entity with a BoundingSphere gets a PickProxy. With Jolt, proxies
+// are static sphere bodies in the phantom object layer of the shared
+// physics system (see collision.h), and picks are broadphase ray casts and
+// sphere/box collections followed by an exact sphere test on the few
+// candidates. Bodies are only moved for entities whose EcsTransform was
+// recomputed this frame, and new proxies are inserted as one batch.
+//
+// The scan backend tests every BoundingSphere and is used without Jolt or
+// when selected explicitly (e.g. to compare results).
+
+typedef enum {
+    PICK_BACKEND_SCAN = 0,    // Linear test over all bounding spheres
+    PICK_BACKEND_JOLT = 1     // Broadphase queries over phantom bodies
+} PickBackend;
+
+// Added automatically alongside BoundingSphere
+typedef struct {
+    int32_t slot;             // Index in the picking world, -1 until inserted
+} PickProxy;
+
+typedef struct {
+    int backend;              // PickBackend, falls back to the scan without Jolt
+    float max_distance;       // Ray length of a pick (world units)
+    float select_radius;      // Half size of the region select around the camera target
+    int optimize_batch;       // Batches at least this large rebuild the broadphase tree
+} PickingSettings;
+
+typedef struct {
+    int32_t proxies;
+    int32_t inserted_frame;   // Bodies added by the last batch
+    int32_t synced_frame;     // Bodies moved in the last frame
+    int32_t batches;
+    int32_t candidates;       // Broadphase hits of the last query
+    int32_t hits;             // Entities returned by the last query
+    double query_us;          // Time of the last query
+    bool last_query_jolt;     // Backend that answered the last query
+} PickingStats;
+
+extern ECS_COMPONENT_DECLARE(PickProxy);
+extern ECS_COMPONENT_DECLARE(PickingSettings);
+extern ECS_COMPONENT_DECLARE(PickingStats);
+
+// Closest phantom hit by a ray, 0 if none. distance may be NULL.
+ecs_entity_t PickPhantom(ecs_world_t *world, Ray ray, float *distance);
+
+// Replace the selection with every phantom inside a region; return the
+// number of selected phantoms
+int SelectPhantomsInBox(ecs_world_t *world, BoundingBox box);
+int SelectPhantomsInSphere(ecs_world_t *world, Vector3 center, float radius);
+
+// Systems and observers
+void PickProxySystem(ecs_iter_t *it);
+void RegionSelectSystem(ecs_iter_t *it);
+void OnPickProxyRemoved(ecs_iter_t *it);
+
+void RegisterPickingSystems(ecs_world_t *world);
+
+#endif // PICKING_H
@@ -1,4 +1,6 @@
 #include "prefabs.h"
+#include "include_graph.h"
+#include "symbol_index.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -153,39 +155,12 @@ void CreateCodeHierarchy(ecs_world_t *world) {
 
 // Custom relationships for code dependencies
 void SetupCodeDependencies(ecs_world_t *world) {
-    // Create entities for different code elements
-    ecs_entity_t header_file = ecs_entity(world, { .name = "stdio.h" });
-    ecs_entity_t source_file = ecs_entity(world, { .name = "main.c" });
-    ecs_entity_t printf_func = ecs_entity(world, { .name = "printf" });
-    ecs_entity_t main_func = ecs_entity(world, { .name = "main" });
-    
-    // Establish dependency relationships
-    ecs_add_pair(world, source_file, Includes, header_file);
-    ecs_add_pair(world, main_func, References, printf_func);
-    ecs_add_pair(world, printf_func, Contains, header_file);
-    
-    // Position entities based on dependencies
-    ecs_set(world, header_file, Position, {-5.0f, 5.0f, 0.0f});
-    ecs_set(world, header_file, Rotation, {0.0f, 0.0f, 0.0f, 1.0f});
-    ecs_set(world, header_file, Scale, {1.0f, 1.0f, 1.0f});
-    ecs_set(world, header_file, EcsTransform, {.needs_update = true});
-    ecs_set(world, header_file, TextContent, {"stdio.h", 1.0f, PURPLE, false});
-    
-    ecs_set(world, source_file, Position, {0.0f, 0.0f, 0.0f});
-    ecs_set(world, source_file, Rotation, {0.0f, 0.0f, 0.0f, 1.0f});
-    ecs_set(world, source_file, Scale, {1.0f, 1.0f, 1.0f});
-    ecs_set(world, source_file, EcsTransform, {.needs_update = true});
-    ecs_set(world, source_file, TextContent, {"main.c", 1.5f, BLUE, false});
-    
-    ecs_set(world, main_func, Position, {2.0f, -2.0f, 0.0f});
-    ecs_set(world, main_func, Rotation, {0.0f, 0.0f, 0.0f, 1.0f});
-    ecs_set(world, main_func, Scale, {1.0f, 1.0f, 1.0f});
-    ecs_set(world, main_func, EcsTransform, {.needs_update = true});
-    ecs_set(world, main_func, TextContent, {"main()", 1.2f, GREEN, false});
-    
-    ecs_set(world, printf_func, Position, {-2.0f, -2.0f, 0.0f});
-    ecs_set(world, printf_func, Rotation, {0.0f, 0.0f, 0.0f, 1.0f});
-    ecs_set(world, printf_func, Scale, {1.0f, 1.0f, 1.0f});
-    ecs_set(world, printf_func, EcsTransform, {.needs_update = true});
-    ecs_set(world, printf_func, TextContent, {"printf()", 1.2f, YELLOW, false});
+    // Includes come from the #include lines of the loaded files
+    int include_edges = ScanProjectIncludes(world);
+    printf("Include graph: %d edges\n", include_edges);
+    
+    // References between function phantoms come from the symbol index,
+    // which has queued every file lexed so far
+    int reference_edges = UpdateSymbolIndex(world);
+    printf("Call graph: %d edges\n", reference_edges);
 }
@@ -0,0 +1,272 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime
+#include "profiler.h"
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Single-producer (owning thread) / single-consumer (main thread) ring
+typedef struct ProfileThreadRing {
+    ProfileEvent events[PROFILER_RING_SIZE];
+    atomic_uint_fast64_t head;      // Next write slot, advanced by the owner
+    atomic_uint_fast64_t tail;      // Next read slot, advanced by the collector
+    atomic_uint_fast64_t dropped;   // Events lost because the ring was full
+    uint32_t thread_id;
+    uint32_t depth;                 // Current zone nesting, owner thread only
+    struct ProfileThreadRing *next;
+} ProfileThreadRing;
+
+atomic_bool g_profiler_enabled = false;
+
+static _Atomic(ProfileThreadRing*) ring_list = NULL;
+static atomic_uint next_thread_id = 0;
+static _Thread_local ProfileThreadRing *local_ring = NULL;
+
+// Collector state (main thread only)
+static ProfileEvent history[PROFILER_HISTORY_SIZE];
+static uint64_t history_count = 0;
+static ProfileEvent frame_main_events[PROFILER_RING_SIZE];
+static int frame_main_count = 0;
+static ProfileZoneStats frame_zones[PROFILER_MAX_ZONES];
+static int frame_zone_count = 0;
+static uint64_t frame_begin_ns = 0;
+static uint64_t frame_end_ns = 0;
+static uint32_t main_thread_id = 0;
+
+uint64_t ProfilerNow(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static ProfileThreadRing *GetLocalRing(void) {
+    if (local_ring) {
+        return local_ring;
+    }
+
+    ProfileThreadRing *ring = calloc(1, sizeof(ProfileThreadRing));
+    if (!ring) {
+        return NULL;
+    }
+    ring->thread_id = atomic_fetch_add(&next_thread_id, 1);
+
+    // Lock-free push onto the global ring list; rings live for the process
+    ProfileThreadRing *head = atomic_load(&ring_list);
+    do {
+        ring->next = head;
+    } while (!atomic_compare_exchange_weak(&ring_list, &head, ring));
+
+    local_ring = ring;
+    return ring;
+}
+
+uint64_t ProfilerBegin(void) {
+    ProfileThreadRing *ring = GetLocalRing();
+    if (!ring) {
+        return 0;
+    }
+    ring->depth++;
+
+    uint64_t now = ProfilerNow();
+    return now ? now : 1;  // Zero means "zone not recorded"
+}
+
+void ProfilerEnd(const char *name, uint64_t start_ns) {
+    ProfileThreadRing *ring = GetLocalRing();
+    if (!ring) {
+        return;
+    }
+    if (ring->depth > 0) {
+        ring->depth--;
+    }
+
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    if (head - tail >= PROFILER_RING_SIZE) {
+        atomic_fetch_add_explicit(&ring->dropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    ProfileEvent *event = &ring->events[head & (PROFILER_RING_SIZE - 1)];
+    event->name = name;
+    event->start_ns = start_ns;
+    event->end_ns = ProfilerNow();
+    event->thread_id = ring->thread_id;
+    event->depth = ring->depth;
+
+    // Publish the event to the collector
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void ProfilerSetEnabled(bool enabled) {
+    atomic_store(&g_profiler_enabled, enabled);
+}
+
+bool ProfilerIsEnabled(void) {
+    return atomic_load_explicit(&g_profiler_enabled, memory_order_relaxed);
+}
+
+static void AccumulateZone(const ProfileEvent *event) {
+    double ms = (event->end_ns - event->start_ns) / 1e6;
+
+    for (int z = 0; z < frame_zone_count; z++) {
+        // Same literal may live at different addresses in different units
+        if (frame_zones[z].name == event->name || strcmp(frame_zones[z].name, event->name) == 0) {
+            frame_zones[z].total_ms += ms;
+            frame_zones[z].calls++;
+            return;
+        }
+    }
+
+    if (frame_zone_count < PROFILER_MAX_ZONES) {
+        frame_zones[frame_zone_count++] = (ProfileZoneStats){event->name, ms, 1};
+    }
+}
+
+void ProfilerFrameEnd(void) {
+    ProfileThreadRing *own = GetLocalRing();
+    if (own) {
+        main_thread_id = own->thread_id;
+    }
+
+    uint64_t now = ProfilerNow();
+    frame_main_count = 0;
+    frame_zone_count = 0;
+
+    for (ProfileThreadRing *ring = atomic_load(&ring_list); ring; ring = ring->next) {
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+        for (uint64_t i = tail; i < head; i++) {
+            const ProfileEvent *event = &ring->events[i & (PROFILER_RING_SIZE - 1)];
+
+            history[history_count % PROFILER_HISTORY_SIZE] = *event;
+            history_count++;
+
+            AccumulateZone(event);
+            if (event->thread_id == main_thread_id && frame_main_count < PROFILER_RING_SIZE) {
+                frame_main_events[frame_main_count++] = *event;
+            }
+        }
+
+        // Hand the slots back to the producer
+        atomic_store_explicit(&ring->tail, head, memory_order_release);
+    }
+
+    frame_begin_ns = frame_end_ns ? frame_end_ns : now;
+    frame_end_ns = now;
+}
+
+int ProfilerGetFrameZones(ProfileZoneStats *out, int max_zones) {
+    int count = frame_zone_count < max_zones ? frame_zone_count : max_zones;
+    memcpy(out, frame_zones, count * sizeof(ProfileZoneStats));
+    return count;
+}
+
+double ProfilerGetFrameMs(void) {
+    return (frame_end_ns - frame_begin_ns) / 1e6;
+}
+
+uint64_t ProfilerGetDroppedEvents(void) {
+    uint64_t dropped = 0;
+    for (ProfileThreadRing *ring = atomic_load(&ring_list); ring; ring = ring->next) {
+        dropped += atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+    }
+    return dropped;
+}
+
+bool ProfilerExportChromeTrace(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (!file) {
+        printf("Failed to open trace file: %s\n", path);
+        return false;
+    }
+
+    uint64_t first = history_count > PROFILER_HISTORY_SIZE ? history_count - PROFILER_HISTORY_SIZE : 0;
+    uint64_t origin_ns = UINT64_MAX;
+    for (uint64_t i = first; i < history_count; i++) {
+        const ProfileEvent *event = &history[i % PROFILER_HISTORY_SIZE];
+        if (event->start_ns < origin_ns) {
+            origin_ns = event->start_ns;
+        }
+    }
+
+    // Complete ("X") events, timestamps in microseconds
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (uint64_t i = first; i < history_count; i++) {
+        const ProfileEvent *event = &history[i % PROFILER_HISTORY_SIZE];
+        fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"pevi\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,"
+                "\"ts\":%.3f,\"dur\":%.3f}",
+                i == first ? "" : ",\n",
+                event->name, event->thread_id,
+                (event->start_ns - origin_ns) / 1e3,
+                (event->end_ns - event->start_ns) / 1e3);
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    printf("Exported %llu trace events to %s\n", (unsigned long long)(history_count - first), path);
+    return true;
+}
+
+static Color ZoneColor(const char *name) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *c = (const unsigned char*)name; *c; c++) {
+        hash = (hash ^ *c) * 16777619u;
+    }
+    return (Color){(unsigned char)(80 + (hash & 0x7F)), (unsigned char)(80 + ((hash >> 8) & 0x7F)),
+                   (unsigned char)(80 + ((hash >> 16) & 0x7F)), 230};
+}
+
+void DrawProfilerOverlay(int x, int y, int width) {
+    const int row_height = 14;
+    double frame_ms = ProfilerGetFrameMs();
+
+    int max_depth = 0;
+    for (int i = 0; i < frame_main_count; i++) {
+        if ((int)frame_main_events[i].depth > max_depth) {
+            max_depth = frame_main_events[i].depth;
+        }
+    }
+    int flame_height = (max_depth + 1) * row_height;
+    int bars_height = frame_zone_count * row_height;
+
+    DrawRectangle(x - 4, y - 4, width + 8, 24 + flame_height + 8 + bars_height + 4, ColorAlpha(BLACK, 0.75f));
+    DrawText(TextFormat("Profiler: frame %.2f ms | dropped %llu | F9 export trace",
+             frame_ms, (unsigned long long)ProfilerGetDroppedEvents()), x, y, 14, LIME);
+    y += 20;
+
+    // Flame graph of the main thread across the last frame
+    double span_ns = (double)(frame_end_ns - frame_begin_ns);
+    if (span_ns > 0.0) {
+        for (int i = 0; i < frame_main_count; i++) {
+            const ProfileEvent *event = &frame_main_events[i];
+            if (event->end_ns < frame_begin_ns) {
+                continue;
+            }
+            double start = event->start_ns > frame_begin_ns ? (double)(event->start_ns - frame_begin_ns) : 0.0;
+            double end = (double)(event->end_ns - frame_begin_ns);
+            int x0 = x + (int)(start / span_ns * width);
+            int w = (int)((end - start) / span_ns * width);
+            if (w < 1) {
+                w = 1;
+            }
+            int row_y = y + event->depth * row_height;
+            DrawRectangle(x0, row_y, w, row_height - 1, ZoneColor(event->name));
+            if (w > MeasureText(event->name, 10) + 4) {
+                DrawText(event->name, x0 + 2, row_y + 2, 10, BLACK);
+            }
+        }
+    }
+    y += flame_height + 8;
+
+    // Per-zone totals (all threads) as bars relative to the frame time
+    for (int z = 0; z < frame_zone_count; z++) {
+        const ProfileZoneStats *zone = &frame_zones[z];
+        int bar = frame_ms > 0.0 ? (int)(zone->total_ms / frame_ms * (width - 200)) : 0;
+        DrawRectangle(x + 200, y + z * row_height, bar > 0 ? bar : 1, row_height - 2, ZoneColor(zone->name));
+        DrawText(TextFormat("%-18s %6.3f ms x%d", zone->name, zone->total_ms, zone->calls),
+                 x, y + z * row_height, 10, LIGHTGRAY);
+    }
+}
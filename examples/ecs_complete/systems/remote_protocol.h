@@ -0,0 +1,221 @@
+#ifndef REMOTE_PROTOCOL_H
+#define REMOTE_PROTOCOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Wire format between pevi_server and its clients (see remote_server.h).
+// Plain C without flecs or raylib, so a client needs only this header.
+//
+// Every message is a header followed by a body; integers and floats are
+// little-endian and packed, records follow each other without padding.
+//
+//     header    u32 length (whole message), u16 type, u16 version,
+//               u32 frame, u32 reserved, u64 time_ns (server uv_hrtime when
+//               the frame was captured)
+//
+//     SNAPSHOT  u32 node count, node records
+//     DELTA     u32 removed, u32 upserted, u32 moved, u32 acks,
+//               removed ids (u32), node records, moves, nudge tokens (u32)
+//     NUDGE     u32 id, f32 dx, dy, dz, u32 token          (client to server)
+//
+//     node      u32 id, u32 parent (0 = none), i32 line, f32 x, y, z,
+//               u32 color (RGBA), u8 kind, u8 text length, u16 tokens,
+//               u16 edges, text bytes, tokens (u16 column, u16 length,
+//               u8 kind), edges (u32 target, u8 kind)
+//     move      u32 id, f32 x, y, z
+//
+// A node's position is relative to its parent's, so moving a file moves
+// its lines without a record for each. A client gets one SNAPSHOT when it
+// connects (and again if it fell too far behind), then one DELTA per
+// server frame that changed something. A DELTA acknowledges the nudges
+// applied in its frame by their tokens.
+
+#define REMOTE_PROTOCOL_VERSION 1
+#define REMOTE_DEFAULT_PORT 7341
+#define REMOTE_HEADER_SIZE 24
+#define REMOTE_NODE_SIZE 34        // Node record without text, tokens and edges
+#define REMOTE_TOKEN_SIZE 5
+#define REMOTE_EDGE_SIZE 5
+#define REMOTE_MOVE_SIZE 16
+#define REMOTE_NUDGE_SIZE 20
+#define REMOTE_MAX_MESSAGE (1u << 30)
+#define REMOTE_MAX_CLIENT_MESSAGE 4096
+
+typedef enum {
+    REMOTE_MSG_SNAPSHOT = 1,
+    REMOTE_MSG_DELTA = 2,
+    REMOTE_MSG_NUDGE = 3
+} RemoteMessageType;
+
+typedef enum {
+    REMOTE_NODE_FILE = 0,     // File container
+    REMOTE_NODE_LINE,         // Line phantom, with the token spans of its text
+    REMOTE_NODE_FUNCTION,     // Function phantom of the symbol index
+    REMOTE_NODE_OTHER
+} RemoteNodeKind;
+
+typedef enum {
+    REMOTE_EDGE_REFERENCES = 0,
+    REMOTE_EDGE_INCLUDES,
+    REMOTE_EDGE_IMPORTS
+} RemoteEdgeKind;
+
+typedef struct {
+    uint32_t length;
+    uint16_t type;
+    uint16_t version;
+    uint32_t frame;
+    uint64_t time_ns;
+} RemoteHeader;
+
+typedef struct {
+    uint32_t id;
+    uint32_t parent;
+    int32_t line;
+    float x, y, z;
+    uint32_t color;
+    uint8_t kind;
+    uint8_t text_length;
+    uint16_t token_count;
+    uint16_t edge_count;
+    const uint8_t *text;      // Decoded: points into the message
+    const uint8_t *tokens;
+    const uint8_t *edges;
+} RemoteNode;
+
+// Little-endian stores and loads on unaligned bytes
+
+static inline void RemotePutU16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void RemotePutU32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline void RemotePutU64(uint8_t *p, uint64_t v) {
+    RemotePutU32(p, (uint32_t)v);
+    RemotePutU32(p + 4, (uint32_t)(v >> 32));
+}
+
+static inline void RemotePutF32(uint8_t *p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    RemotePutU32(p, bits);
+}
+
+static inline uint16_t RemoteGetU16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t RemoteGetU32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint64_t RemoteGetU64(const uint8_t *p) {
+    return (uint64_t)RemoteGetU32(p) | ((uint64_t)RemoteGetU32(p + 4) << 32);
+}
+
+static inline float RemoteGetF32(const uint8_t *p) {
+    uint32_t bits = RemoteGetU32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+static inline void RemotePutHeader(uint8_t *p, const RemoteHeader *header) {
+    RemotePutU32(p, header->length);
+    RemotePutU16(p + 4, header->type);
+    RemotePutU16(p + 6, header->version);
+    RemotePutU32(p + 8, header->frame);
+    RemotePutU32(p + 12, 0);
+    RemotePutU64(p + 16, header->time_ns);
+}
+
+static inline void RemoteGetHeader(const uint8_t *p, RemoteHeader *header) {
+    header->length = RemoteGetU32(p);
+    header->type = RemoteGetU16(p + 4);
+    header->version = RemoteGetU16(p + 6);
+    header->frame = RemoteGetU32(p + 8);
+    header->time_ns = RemoteGetU64(p + 16);
+}
+
+static inline size_t RemoteNodeSize(const RemoteNode *node) {
+    return REMOTE_NODE_SIZE + node->text_length + (size_t)node->token_count * REMOTE_TOKEN_SIZE +
+           (size_t)node->edge_count * REMOTE_EDGE_SIZE;
+}
+
+// Fixed part of a node record; text, tokens and edges follow it
+static inline void RemotePutNode(uint8_t *p, const RemoteNode *node) {
+    RemotePutU32(p, node->id);
+    RemotePutU32(p + 4, node->parent);
+    RemotePutU32(p + 8, (uint32_t)node->line);
+    RemotePutF32(p + 12, node->x);
+    RemotePutF32(p + 16, node->y);
+    RemotePutF32(p + 20, node->z);
+    RemotePutU32(p + 24, node->color);
+    p[28] = node->kind;
+    p[29] = node->text_length;
+    RemotePutU16(p + 30, node->token_count);
+    RemotePutU16(p + 32, node->edge_count);
+}
+
+// Decode the node record at p (at most available bytes). Returns its size,
+// 0 if it is truncated.
+static inline size_t RemoteGetNode(const uint8_t *p, size_t available, RemoteNode *node) {
+    if (available < REMOTE_NODE_SIZE) {
+        return 0;
+    }
+    node->id = RemoteGetU32(p);
+    node->parent = RemoteGetU32(p + 4);
+    node->line = (int32_t)RemoteGetU32(p + 8);
+    node->x = RemoteGetF32(p + 12);
+    node->y = RemoteGetF32(p + 16);
+    node->z = RemoteGetF32(p + 20);
+    node->color = RemoteGetU32(p + 24);
+    node->kind = p[28];
+    node->text_length = p[29];
+    node->token_count = RemoteGetU16(p + 30);
+    node->edge_count = RemoteGetU16(p + 32);
+    size_t size = RemoteNodeSize(node);
+    if (size > available) {
+        return 0;
+    }
+    node->text = p + REMOTE_NODE_SIZE;
+    node->tokens = node->text + node->text_length;
+    node->edges = node->tokens + (size_t)node->token_count * REMOTE_TOKEN_SIZE;
+    return size;
+}
+
+// Split "host:port" or "port" (host 127.0.0.1). Returns false for anything
+// else, which is taken as the path of a Unix domain socket.
+static inline bool RemoteSplitAddress(const char *address, char *host, size_t host_size, int *port) {
+    const char *colon = strrchr(address, ':');
+    const char *digits = colon ? colon + 1 : address;
+    if (*digits == '\0' || strchr(address, '/')) {
+        return false;
+    }
+    for (const char *c = digits; *c; c++) {
+        if (*c < '0' || *c > '9') {
+            return false;
+        }
+    }
+    *port = atoi(digits);
+    if (colon) {
+        snprintf(host, host_size, "%.*s", (int)(colon - address), address);
+    } else {
+        snprintf(host, host_size, "127.0.0.1");
+    }
+    return *port <= 65535;
+}
+
+#endif // REMOTE_PROTOCOL_H
@@ -0,0 +1,893 @@
+#define _POSIX_C_SOURCE 200809L  // uv.h needs pthread_rwlock_t
+#include "remote_server.h"
+#include "layout.h"
+#include "memory_tracker.h"
+#include "profiler.h"
+#include "symbol_index.h"
+#include "syntax.h"
+#include "../components/spatial.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <uv.h>
+
+ECS_COMPONENT_DECLARE(RemoteServerSettings);
+ECS_COMPONENT_DECLARE(RemoteServerStats);
+
+#define REMOTE_BACKLOG 128
+#define REMOTE_READ_SIZE 4096
+#define REMOTE_PATH_MAX 512
+
+// Mirror of one phantom, indexed by its entity index
+typedef struct {
+    ecs_entity_t entity;      // 0 = not in the mirror
+    uint32_t parent;          // Index of the parent phantom, 0 if none
+    uint32_t seen;            // Last frame the query returned it
+    uint32_t edited;          // Files: last frame the buffer was edited or lexed again
+    int32_t live_index;       // In remote.live
+    int32_t syntax_slot;      // Files: FileSyntax slot and buffer edits at the last frame
+    uint32_t edits;
+    uint8_t kind;             // RemoteNodeKind
+    bool added;               // Not sent yet
+    Position position;        // World position this frame
+    Position sent;            // Relative to the parent, as last sent
+    uint64_t hash;            // Content (text, tokens, edges, color) as last sent
+} MirrorNode;
+
+// Bytes of one message section
+typedef struct {
+    uint8_t *data;
+    int length;
+    int capacity;
+} RemoteBuffer;
+
+// One encoded message, shared by the sockets it is queued on
+typedef struct {
+    int32_t refs;
+    uint32_t length;
+    uint8_t data[];
+} RemotePacket;
+
+typedef struct RemoteWrite {
+    uv_write_t request;
+    RemotePacket *packet;
+    struct RemoteWrite *next_free;
+} RemoteWrite;
+
+typedef struct {
+    union {
+        uv_tcp_t tcp;
+        uv_pipe_t pipe;
+    } handle;                 // First member: a handle pointer is its client
+    uint8_t *received;
+    int received_length;
+    int received_capacity;
+    bool needs_snapshot;
+    bool resync;              // Fell behind: wait for the socket to drain
+    bool closing;
+} RemoteClient;
+
+typedef struct {
+    uint32_t id;
+    float dx, dy, dz;
+    uint32_t token;
+} RemoteNudge;
+
+typedef struct {
+    uv_loop_t loop;
+    bool loop_ready;
+    union {
+        uv_tcp_t tcp;
+        uv_pipe_t pipe;
+    } listener;
+    bool listening;
+    bool pipe;
+    char pipe_path[REMOTE_PATH_MAX];
+    uv_timer_t wait_timer;
+    bool waiting;
+
+    RemoteClient **clients;
+    int client_count;
+    int client_capacity;
+    RemoteWrite *free_writes;
+    RemoteNudge *nudges;
+    int nudge_count;
+    int nudge_capacity;
+
+    MirrorNode *nodes;
+    int node_capacity;
+    uint32_t *live;           // Indexes of the mirrored phantoms
+    int live_count;
+    int live_capacity;
+    uint32_t frame;
+
+    // Sections of the frame's delta
+    RemoteBuffer removed;
+    RemoteBuffer upserts;
+    RemoteBuffer moves;
+    RemoteBuffer acks;
+    int removed_count;
+    int upsert_count;
+    int move_count;
+    int ack_count;
+    RemoteBuffer snapshot;
+
+    ecs_query_t *node_query;
+} RemoteServer;
+
+// The server belongs to the world that registered the module: systems
+// get it as ctx, socket callbacks through their loop's data and API calls
+// through this singleton
+typedef struct {
+    RemoteServer *remote;
+} RemoteModule;
+
+static ECS_COMPONENT_DECLARE(RemoteModule);
+
+static RemoteServer *GetRemote(const ecs_world_t *world) {
+    const RemoteModule *module = ecs_singleton_get(world, RemoteModule);
+    return module ? module->remote : NULL;
+}
+
+// Room for size more bytes; returns where they go, NULL if out of memory
+static uint8_t *Reserve(RemoteBuffer *buffer, int size) {
+    if (!GrowArray(MEMORY_TAG_IO, (void**)&buffer->data, &buffer->capacity, buffer->length + size, 1)) {
+        return NULL;
+    }
+    uint8_t *at = buffer->data + buffer->length;
+    buffer->length += size;
+    return at;
+}
+
+static uint64_t HashBytes(uint64_t hash, const void *data, size_t length) {
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// Packets
+
+static RemotePacket *NewPacket(uint32_t length) {
+    RemotePacket *packet = TrackedMalloc(MEMORY_TAG_IO, sizeof(RemotePacket) + length);
+    if (!packet) {
+        printf("Remote: out of memory for a %u byte message\n", length);
+        return NULL;
+    }
+    packet->refs = 1;         // Held by the sender until it is queued everywhere
+    packet->length = length;
+    return packet;
+}
+
+static void ReleasePacket(RemotePacket *packet) {
+    if (packet && --packet->refs == 0) {
+        TrackedFree(MEMORY_TAG_IO, packet);
+    }
+}
+
+// Header plus the given sections, copied one after the other
+static RemotePacket *BuildPacket(const RemoteServer *remote, RemoteMessageType type, uint64_t captured_ns,
+                                 const RemoteBuffer *sections, int section_count) {
+    uint64_t length = REMOTE_HEADER_SIZE;
+    for (int i = 0; i < section_count; i++) {
+        length += (uint64_t)sections[i].length;
+    }
+    if (length > REMOTE_MAX_MESSAGE) {
+        printf("Remote: a %llu byte message is over the protocol limit\n", (unsigned long long)length);
+        return NULL;
+    }
+    RemotePacket *packet = NewPacket((uint32_t)length);
+    if (!packet) {
+        return NULL;
+    }
+    RemoteHeader header = {
+        .length = (uint32_t)length,
+        .type = (uint16_t)type,
+        .version = REMOTE_PROTOCOL_VERSION,
+        .frame = remote->frame,
+        .time_ns = captured_ns
+    };
+    RemotePutHeader(packet->data, &header);
+    uint8_t *at = packet->data + REMOTE_HEADER_SIZE;
+    for (int i = 0; i < section_count; i++) {
+        if (sections[i].length > 0) {
+            memcpy(at, sections[i].data, (size_t)sections[i].length);
+            at += sections[i].length;
+        }
+    }
+    return packet;
+}
+
+// Sockets (all callbacks run on the main thread, from uv_run)
+
+static void OnClientClosed(uv_handle_t *handle) {
+    RemoteClient *client = (RemoteClient*)handle;
+    TrackedFree(MEMORY_TAG_IO, client->received);
+    TrackedFree(MEMORY_TAG_IO, client);
+}
+
+static void CloseClient(RemoteServer *remote, RemoteClient *client) {
+    if (client->closing) {
+        return;
+    }
+    client->closing = true;
+    for (int i = 0; i < remote->client_count; i++) {
+        if (remote->clients[i] == client) {
+            remote->clients[i] = remote->clients[--remote->client_count];
+            break;
+        }
+    }
+    uv_close((uv_handle_t*)&client->handle, OnClientClosed);
+}
+
+static void OnPacketWritten(uv_write_t *request, int status) {
+    RemoteServer *remote = request->handle->loop->data;
+    RemoteWrite *write = (RemoteWrite*)request;
+    ReleasePacket(write->packet);
+    write->packet = NULL;
+    write->next_free = remote->free_writes;
+    remote->free_writes = write;
+    if (status < 0 && status != UV_ECANCELED) {
+        CloseClient(remote, (RemoteClient*)request->handle);
+    }
+}
+
+static bool QueuePacket(RemoteServer *remote, RemoteClient *client, RemotePacket *packet,
+                        RemoteServerStats *stats) {
+    RemoteWrite *write = remote->free_writes;
+    if (write) {
+        remote->free_writes = write->next_free;
+    } else {
+        write = TrackedMalloc(MEMORY_TAG_IO, sizeof(RemoteWrite));
+        if (!write) {
+            CloseClient(remote, client);
+            return false;
+        }
+    }
+    write->packet = packet;
+    packet->refs++;
+    uv_buf_t buf = uv_buf_init((char*)packet->data, packet->length);
+    if (uv_write(&write->request, (uv_stream_t*)&client->handle, &buf, 1, OnPacketWritten) < 0) {
+        packet->refs--;
+        write->next_free = remote->free_writes;
+        remote->free_writes = write;
+        CloseClient(remote, client);
+        return false;
+    }
+    stats->bytes_sent += packet->length;
+    return true;
+}
+
+static void AllocClientBuffer(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf) {
+    (void)suggested_size;
+    RemoteClient *client = (RemoteClient*)handle;
+    if (!GrowArray(MEMORY_TAG_IO, (void**)&client->received, &client->received_capacity,
+                   client->received_length + REMOTE_READ_SIZE, 1)) {
+        *buf = uv_buf_init(NULL, 0);
+        return;
+    }
+    *buf = uv_buf_init((char*)client->received + client->received_length,
+                       (unsigned int)(client->received_capacity - client->received_length));
+}
+
+// Nudges are queued here and applied at the start of the next frame
+static void OnClientRead(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
+    (void)buf;
+    RemoteServer *remote = stream->loop->data;
+    RemoteClient *client = (RemoteClient*)stream;
+    if (nread < 0) {
+        CloseClient(remote, client);
+        return;
+    }
+    client->received_length += (int)nread;
+
+    int offset = 0;
+    while (client->received_length - offset >= REMOTE_HEADER_SIZE) {
+        RemoteHeader header;
+        RemoteGetHeader(client->received + offset, &header);
+        if (header.length < REMOTE_HEADER_SIZE || header.length > REMOTE_MAX_CLIENT_MESSAGE ||
+            header.version != REMOTE_PROTOCOL_VERSION) {
+            printf("Remote: closing a client that sent an invalid message\n");
+            CloseClient(remote, client);
+            return;
+        }
+        if (client->received_length - offset < (int)header.length) {
+            break;
+        }
+        const uint8_t *body = client->received + offset + REMOTE_HEADER_SIZE;
+        if (header.type == REMOTE_MSG_NUDGE && header.length >= REMOTE_HEADER_SIZE + REMOTE_NUDGE_SIZE &&
+            GrowArray(MEMORY_TAG_IO, (void**)&remote->nudges, &remote->nudge_capacity, remote->nudge_count + 1,
+                      sizeof(RemoteNudge))) {
+            remote->nudges[remote->nudge_count++] = (RemoteNudge){
+                .id = RemoteGetU32(body),
+                .dx = RemoteGetF32(body + 4),
+                .dy = RemoteGetF32(body + 8),
+                .dz = RemoteGetF32(body + 12),
+                .token = RemoteGetU32(body + 16)
+            };
+        }
+        // Other types are ignored, for clients of later versions
+        offset += (int)header.length;
+    }
+    if (offset > 0) {
+        memmove(client->received, client->received + offset, (size_t)(client->received_length - offset));
+        client->received_length -= offset;
+    }
+}
+
+static void OnRemoteConnection(uv_stream_t *server, int status) {
+    RemoteServer *remote = server->loop->data;
+    if (status < 0) {
+        printf("Remote: connection error %s\n", uv_strerror(status));
+        return;
+    }
+    RemoteClient *client = TrackedCalloc(MEMORY_TAG_IO, 1, sizeof(RemoteClient));
+    if (!client) {
+        return;
+    }
+    if (remote->pipe) {
+        uv_pipe_init(&remote->loop, &client->handle.pipe, 0);
+    } else {
+        uv_tcp_init(&remote->loop, &client->handle.tcp);
+    }
+    if (uv_accept(server, (uv_stream_t*)&client->handle) != 0 ||
+        !GrowArray(MEMORY_TAG_IO, (void**)&remote->clients, &remote->client_capacity, remote->client_count + 1,
+                   sizeof(RemoteClient*))) {
+        client->closing = true;
+        uv_close((uv_handle_t*)&client->handle, OnClientClosed);
+        return;
+    }
+    if (!remote->pipe) {
+        uv_tcp_nodelay(&client->handle.tcp, 1);
+    }
+    client->needs_snapshot = true;
+    remote->clients[remote->client_count++] = client;
+    uv_read_start((uv_stream_t*)&client->handle, AllocClientBuffer, OnClientRead);
+}
+
+static void OnWaitTimer(uv_timer_t *timer) {
+    RemoteServer *remote = timer->loop->data;
+    remote->waiting = false;
+}
+
+bool StartRemoteServer(ecs_world_t *world, const char *address) {
+    RemoteServer *remote = GetRemote(world);
+    if (!remote || !remote->loop_ready || remote->listening) {
+        return false;
+    }
+    char host[256];
+    int port = 0;
+    int result;
+    remote->pipe = !RemoteSplitAddress(address, host, sizeof(host), &port);
+    if (!remote->pipe) {
+        struct sockaddr_storage addr;
+        result = uv_ip4_addr(host, port, (struct sockaddr_in*)&addr);
+        if (result) {
+            result = uv_ip6_addr(host, port, (struct sockaddr_in6*)&addr);
+        }
+        uv_tcp_init(&remote->loop, &remote->listener.tcp);
+        if (!result) {
+            result = uv_tcp_bind(&remote->listener.tcp, (const struct sockaddr*)&addr, 0);
+        }
+    } else {
+        // A socket left behind by an earlier run, never any other file
+        struct stat st;
+        if (stat(address, &st) == 0 && S_ISSOCK(st.st_mode)) {
+            unlink(address);
+        }
+        uv_pipe_init(&remote->loop, &remote->listener.pipe, 0);
+        result = uv_pipe_bind(&remote->listener.pipe, address);
+        snprintf(remote->pipe_path, sizeof(remote->pipe_path), "%s", address);
+    }
+    if (!result) {
+        result = uv_listen((uv_stream_t*)&remote->listener, REMOTE_BACKLOG, OnRemoteConnection);
+    }
+    if (result) {
+        printf("Remote: cannot listen on %s: %s\n", address, uv_strerror(result));
+        uv_close((uv_handle_t*)&remote->listener, NULL);
+        uv_run(&remote->loop, UV_RUN_NOWAIT);
+        remote->pipe_path[0] = '\0';
+        return false;
+    }
+
+    RemoteServerStats *stats = ecs_singleton_get_mut(world, RemoteServerStats);
+    if (!remote->pipe) {
+        struct sockaddr_storage bound;
+        int length = sizeof(bound);
+        if (uv_tcp_getsockname(&remote->listener.tcp, (struct sockaddr*)&bound, &length) == 0) {
+            port = ntohs(bound.ss_family == AF_INET6 ? ((struct sockaddr_in6*)&bound)->sin6_port :
+                                                       ((struct sockaddr_in*)&bound)->sin_port);
+        }
+    }
+    stats->listening = true;
+    stats->port = port;
+    remote->listening = true;
+    if (remote->pipe) {
+        printf("Remote: serving phantoms on %s\n", address);
+    } else {
+        printf("Remote: serving phantoms on %s:%d\n", host, port);
+    }
+    return true;
+}
+
+void RemoteServerWait(ecs_world_t *world, double ms) {
+    RemoteServer *remote = GetRemote(world);
+    if (ms <= 0.0) {
+        return;
+    }
+    if (!remote || !remote->listening) {
+        uv_sleep((unsigned int)ms);
+        return;
+    }
+    remote->waiting = true;
+    uv_timer_start(&remote->wait_timer, OnWaitTimer, (uint64_t)ms, 0);
+    while (remote->waiting && uv_run(&remote->loop, UV_RUN_ONCE)) {
+    }
+    uv_timer_stop(&remote->wait_timer);
+}
+
+// Mirror
+
+static uint32_t PackColor(Color color) {
+    return (uint32_t)color.r | ((uint32_t)color.g << 8) | ((uint32_t)color.b << 16) | ((uint32_t)color.a << 24);
+}
+
+// Append the record of a mirrored phantom at position (relative to its
+// parent) to buffer. hash, if given, receives the hash of everything in
+// the record but the position. Returns false if out of memory.
+static bool EncodeNode(ecs_world_t *world, const RemoteServer *remote, RemoteBuffer *buffer, uint32_t index,
+                       const MirrorNode *node, Position position, uint64_t *hash) {
+    const TextContent *content = ecs_get(world, node->entity, TextContent);
+    RemoteNode record = {
+        .id = index,
+        .parent = node->parent,
+        .line = -1,
+        .x = position.x,
+        .y = position.y,
+        .z = position.z,
+        .color = content ? PackColor(content->color) : 0,
+        .kind = node->kind
+    };
+    if (content) {
+        record.text_length = (uint8_t)strnlen(content->text, UINT8_MAX);
+    }
+
+    // Lines carry the spans of their text, clipped to what the phantom shows
+    const TokenBuffer *tokens = NULL;
+    uint32_t first_token = 0;
+    if (node->kind == REMOTE_NODE_LINE) {
+        const FileReference *ref = ecs_get(world, node->entity, FileReference);
+        const FileSyntax *syntax = node->parent ? ecs_get(world, remote->nodes[node->parent].entity, FileSyntax) : NULL;
+        record.line = ref ? ref->line_number : -1;
+        tokens = syntax ? GetFileSyntax(world, syntax) : NULL;
+        if (tokens && record.line >= 0 && record.line < tokens->line_count) {
+            first_token = tokens->line_first[record.line];
+            uint32_t end = tokens->line_first[record.line + 1];
+            while (first_token + record.token_count < end && record.token_count < UINT16_MAX &&
+                   tokens->token_column[first_token + record.token_count] < record.text_length) {
+                record.token_count++;
+            }
+        }
+    } else if (node->kind == REMOTE_NODE_FUNCTION) {
+        const FunctionSymbol *function = ecs_get(world, node->entity, FunctionSymbol);
+        record.line = function ? function->line : -1;
+    }
+
+    int start = buffer->length;
+    int fixed = REMOTE_NODE_SIZE + record.text_length + record.token_count * REMOTE_TOKEN_SIZE;
+    uint8_t *at = Reserve(buffer, fixed);
+    if (!at) {
+        return false;
+    }
+    uint8_t *text = at + REMOTE_NODE_SIZE;
+    if (record.text_length > 0) {
+        memcpy(text, content->text, record.text_length);
+    }
+    uint8_t *token = text + record.text_length;
+    for (uint32_t t = first_token; t < first_token + record.token_count; t++) {
+        RemotePutU16(token, tokens->token_column[t]);
+        RemotePutU16(token + 2, tokens->token_length[t]);
+        token[4] = tokens->token_kind[t];
+        token += REMOTE_TOKEN_SIZE;
+    }
+
+    // Edges to any entity; a target that is not a phantom is skipped by clients
+    const ecs_entity_t relations[] = {References, Includes, Imports};
+    const uint8_t edge_kinds[] = {REMOTE_EDGE_REFERENCES, REMOTE_EDGE_INCLUDES, REMOTE_EDGE_IMPORTS};
+    for (int r = 0; r < 3; r++) {
+        ecs_entity_t target;
+        for (int32_t t = 0; record.edge_count < UINT16_MAX &&
+             (target = ecs_get_target(world, node->entity, relations[r], t)) != 0; t++) {
+            uint8_t *edge = Reserve(buffer, REMOTE_EDGE_SIZE);
+            if (!edge) {
+                buffer->length = start;
+                return false;
+            }
+            RemotePutU32(edge, (uint32_t)target);
+            edge[4] = edge_kinds[r];
+            record.edge_count++;
+        }
+    }
+
+    at = buffer->data + start;
+    RemotePutNode(at, &record);
+    if (hash) {
+        // Everything but the position (bytes 12 to 24)
+        uint64_t h = HashBytes(0xcbf29ce484222325ull, at, 12);
+        *hash = HashBytes(h, at + 24, (size_t)(buffer->length - start - 24));
+    }
+    return true;
+}
+
+// Pass over the world: positions, new phantoms and edited files
+static void CaptureMirror(ecs_world_t *world, RemoteServer *remote) {
+    uint32_t frame = remote->frame;
+    ecs_iter_t it = ecs_query_iter(world, remote->node_query);
+    while (ecs_query_next(&it)) {
+        const Position *positions = ecs_field(&it, Position, 0);
+        const FileSyntax *syntax = ecs_field(&it, FileSyntax, 4);
+        bool is_function = ecs_field_is_set(&it, 3);
+        bool has_reference = ecs_field_is_set(&it, 2);
+        for (int i = 0; i < it.count; i++) {
+            ecs_entity_t entity = it.entities[i];
+            uint32_t index = (uint32_t)entity;
+            int old_capacity = remote->node_capacity;
+            if (!GrowArray(MEMORY_TAG_IO, (void**)&remote->nodes, &remote->node_capacity, (int)index + 1,
+                           sizeof(MirrorNode))) {
+                continue;
+            }
+            if (remote->node_capacity > old_capacity) {
+                memset(remote->nodes + old_capacity, 0,
+                       sizeof(MirrorNode) * (size_t)(remote->node_capacity - old_capacity));
+            }
+            MirrorNode *node = &remote->nodes[index];
+
+            // New, or the index was recycled by another entity: sent in full
+            if (node->entity != entity) {
+                if (node->entity == 0) {
+                    if (!GrowArray(MEMORY_TAG_IO, (void**)&remote->live, &remote->live_capacity, remote->live_count + 1,
+                                   sizeof(uint32_t))) {
+                        continue;
+                    }
+                    node->live_index = remote->live_count;
+                    remote->live[remote->live_count++] = index;
+                }
+                ecs_entity_t parent = ecs_get_parent(world, entity);
+                bool parent_phantom = parent && ecs_has(world, parent, Position) && ecs_has(world, parent, TextContent);
+                node->entity = entity;
+                node->parent = parent_phantom ? (uint32_t)parent : 0;
+                node->kind = is_function ? REMOTE_NODE_FUNCTION :
+                             has_reference ? (node->parent ? REMOTE_NODE_LINE : REMOTE_NODE_FILE) : REMOTE_NODE_OTHER;
+                node->syntax_slot = -1;
+                node->edits = 0;
+                node->edited = 0;
+                node->added = true;
+            }
+            node->position = positions[i];
+            node->seen = frame;
+
+            // Lines of a file are compared again when its buffer changes
+            int32_t slot = syntax ? syntax[i].slot : -1;
+            const TextBuffer *buffer = syntax ? GetFileSyntaxBuffer(world, &syntax[i]) : NULL;
+            uint32_t edits = buffer ? buffer->edits : 0;
+            if (slot != node->syntax_slot || edits != node->edits) {
+                node->syntax_slot = slot;
+                node->edits = edits;
+                node->edited = frame;
+            }
+        }
+    }
+}
+
+static Position RelativePosition(const RemoteServer *remote, const MirrorNode *node) {
+    Position position = node->position;
+    if (node->parent) {
+        const MirrorNode *parent = &remote->nodes[node->parent];
+        if (parent->seen == remote->frame) {
+            position.x -= parent->position.x;
+            position.y -= parent->position.y;
+            position.z -= parent->position.z;
+        }
+    }
+    return position;
+}
+
+// Pass over the mirror: removals, changed content and moves
+static void EncodeChanges(ecs_world_t *world, RemoteServer *remote, float epsilon) {
+    uint32_t frame = remote->frame;
+    int l = 0;
+    while (l < remote->live_count) {
+        uint32_t index = remote->live[l];
+        MirrorNode *node = &remote->nodes[index];
+        if (node->seen != frame) {
+            uint8_t *removed = Reserve(&remote->removed, 4);
+            if (removed) {
+                RemotePutU32(removed, index);
+                remote->removed_count++;
+            }
+            uint32_t last = remote->live[--remote->live_count];
+            remote->live[l] = last;
+            remote->nodes[last].live_index = l;
+            node->entity = 0;
+            continue;
+        }
+        l++;
+
+        // Files, functions and labels are few and compared every frame;
+        // lines only when new or when their file changed
+        Position position = RelativePosition(remote, node);
+        bool compare = node->added || node->kind != REMOTE_NODE_LINE ||
+                       (node->parent && remote->nodes[node->parent].edited == frame);
+        if (compare) {
+            int mark = remote->upserts.length;
+            uint64_t hash = 0;
+            if (!EncodeNode(world, remote, &remote->upserts, index, node, position, &hash)) {
+                continue;
+            }
+            if (node->added || hash != node->hash) {
+                node->added = false;
+                node->hash = hash;
+                node->sent = position;
+                remote->upsert_count++;
+                continue;
+            }
+            remote->upserts.length = mark;
+        }
+
+        if (fabsf(position.x - node->sent.x) > epsilon || fabsf(position.y - node->sent.y) > epsilon ||
+            fabsf(position.z - node->sent.z) > epsilon) {
+            uint8_t *move = Reserve(&remote->moves, REMOTE_MOVE_SIZE);
+            if (!move) {
+                continue;
+            }
+            RemotePutU32(move, index);
+            RemotePutF32(move + 4, position.x);
+            RemotePutF32(move + 8, position.y);
+            RemotePutF32(move + 12, position.z);
+            node->sent = position;
+            remote->move_count++;
+        }
+    }
+}
+
+static RemotePacket *EncodeDelta(RemoteServer *remote, uint64_t captured_ns) {
+    uint8_t counts[16];
+    RemotePutU32(counts, (uint32_t)remote->removed_count);
+    RemotePutU32(counts + 4, (uint32_t)remote->upsert_count);
+    RemotePutU32(counts + 8, (uint32_t)remote->move_count);
+    RemotePutU32(counts + 12, (uint32_t)remote->ack_count);
+    RemoteBuffer sections[5] = {
+        {counts, sizeof(counts), sizeof(counts)},
+        remote->removed,
+        remote->upserts,
+        remote->moves,
+        remote->acks
+    };
+    return BuildPacket(remote, REMOTE_MSG_DELTA, captured_ns, sections, 5);
+}
+
+// Every mirrored phantom as last sent, so later deltas apply on top
+static RemotePacket *EncodeSnapshot(ecs_world_t *world, RemoteServer *remote, uint64_t captured_ns,
+                                    RemoteServerStats *stats) {
+    remote->snapshot.length = 0;
+    uint8_t *count = Reserve(&remote->snapshot, 4);
+    if (!count) {
+        return NULL;
+    }
+    RemotePutU32(count, (uint32_t)remote->live_count);
+    for (int l = 0; l < remote->live_count; l++) {
+        uint32_t index = remote->live[l];
+        const MirrorNode *node = &remote->nodes[index];
+        if (!EncodeNode(world, remote, &remote->snapshot, index, node, node->sent, NULL)) {
+            return NULL;
+        }
+    }
+    RemotePacket *packet = BuildPacket(remote, REMOTE_MSG_SNAPSHOT, captured_ns, &remote->snapshot, 1);
+    if (packet) {
+        stats->snapshots++;
+        stats->snapshot_bytes = packet->length;
+    }
+    return packet;
+}
+
+// The delta goes to every client in step; new clients and clients that
+// drained after falling behind get a snapshot instead
+static void SendFrame(ecs_world_t *world, RemoteServer *remote, const RemoteServerSettings *settings,
+                      RemoteServerStats *stats, uint64_t captured_ns) {
+    bool changed = remote->removed_count + remote->upsert_count + remote->move_count + remote->ack_count > 0;
+    RemotePacket *delta = NULL;
+    RemotePacket *snapshot = NULL;
+    for (int c = remote->client_count - 1; c >= 0; c--) {
+        RemoteClient *client = remote->clients[c];
+        size_t queued = uv_stream_get_write_queue_size((uv_stream_t*)&client->handle);
+        if (!client->needs_snapshot && (int64_t)queued > settings->max_queue_bytes) {
+            client->needs_snapshot = true;
+            client->resync = true;
+            stats->resyncs++;
+        }
+        if (client->needs_snapshot) {
+            if (client->resync && queued > 0) {
+                continue;
+            }
+            if (!snapshot) {
+                snapshot = EncodeSnapshot(world, remote, captured_ns, stats);
+            }
+            if (snapshot && QueuePacket(remote, client, snapshot, stats)) {
+                client->needs_snapshot = false;
+                client->resync = false;
+            }
+        } else if (changed) {
+            if (!delta) {
+                delta = EncodeDelta(remote, captured_ns);
+                stats->delta_bytes = delta ? delta->length : 0;
+            }
+            if (delta) {
+                QueuePacket(remote, client, delta, stats);
+            }
+        }
+    }
+    ReleasePacket(delta);
+    ReleasePacket(snapshot);
+}
+
+// Nudges read since the last frame move their node (and its children);
+// the frame's delta acknowledges them
+void RemoteReceiveSystem(ecs_iter_t *it) {
+    RemoteServer *remote = it->ctx;
+    if (!remote->listening) {
+        return;
+    }
+    uv_run(&remote->loop, UV_RUN_NOWAIT);
+
+    RemoteServerStats *stats = ecs_singleton_get_mut(it->world, RemoteServerStats);
+    for (int n = 0; n < remote->nudge_count; n++) {
+        const RemoteNudge *nudge = &remote->nudges[n];
+        if ((int)nudge->id < remote->node_capacity && remote->nodes[nudge->id].entity &&
+            ecs_is_alive(it->world, remote->nodes[nudge->id].entity)) {
+            LayoutTranslateNode(it->world, remote->nodes[nudge->id].entity, nudge->dx, nudge->dy, nudge->dz);
+            stats->nudges++;
+        }
+        uint8_t *ack = Reserve(&remote->acks, 4);
+        if (ack) {
+            RemotePutU32(ack, nudge->token);
+            remote->ack_count++;
+        }
+    }
+    remote->nudge_count = 0;
+}
+
+// Captured once the frame's layout and edits are done
+void RemoteServerSystem(ecs_iter_t *it) {
+    RemoteServer *remote = it->ctx;
+    if (!remote->listening) {
+        return;
+    }
+    RemoteServerStats *stats = ecs_singleton_get_mut(it->world, RemoteServerStats);
+    const RemoteServerSettings *settings = ecs_singleton_get(it->world, RemoteServerSettings);
+    stats->clients = remote->client_count;
+
+    // Without clients the mirror is left as it is; the first capture with
+    // clients diffs against it, and every new client gets a snapshot anyway
+    if (remote->client_count > 0) {
+        PROFILE_ZONE_BEGIN(RemoteCapture);
+        uint64_t start = uv_hrtime();
+        remote->frame++;
+        remote->removed.length = remote->upserts.length = remote->moves.length = 0;
+        remote->removed_count = remote->upsert_count = remote->move_count = 0;
+
+        CaptureMirror(it->world, remote);
+        EncodeChanges(it->world, remote, settings->position_epsilon);
+        SendFrame(it->world, remote, settings, stats, start);
+        remote->acks.length = 0;
+        remote->ack_count = 0;
+
+        stats->frame = remote->frame;
+        stats->nodes = remote->live_count;
+        stats->removed_frame = remote->removed_count;
+        stats->upserted_frame = remote->upsert_count;
+        stats->moved_frame = remote->move_count;
+        stats->capture_ms = (double)(uv_hrtime() - start) / 1e6;
+        if (stats->capture_ms > stats->capture_max_ms) {
+            stats->capture_max_ms = stats->capture_ms;
+        }
+        PROFILE_ZONE_END(RemoteCapture);
+    }
+
+    // Start the writes now rather than at the next frame
+    uv_run(&remote->loop, UV_RUN_NOWAIT);
+}
+
+static void CloseHandle(uv_handle_t *handle, void *arg) {
+    RemoteServer *remote = arg;
+    if (!uv_is_closing(handle)) {
+        uv_close(handle, handle == (uv_handle_t*)&remote->listener || handle == (uv_handle_t*)&remote->wait_timer ?
+                 NULL : OnClientClosed);
+    }
+}
+
+static void RemoteServerFini(ecs_world_t *world, void *ctx) {
+    (void)world;
+    RemoteServer *remote = ctx;
+    if (remote->loop_ready) {
+        remote->client_count = 0;
+        uv_walk(&remote->loop, CloseHandle, remote);
+        uv_run(&remote->loop, UV_RUN_DEFAULT);
+        uv_loop_close(&remote->loop);
+    }
+    if (remote->pipe_path[0]) {
+        unlink(remote->pipe_path);
+    }
+    while (remote->free_writes) {
+        RemoteWrite *next = remote->free_writes->next_free;
+        TrackedFree(MEMORY_TAG_IO, remote->free_writes);
+        remote->free_writes = next;
+    }
+    TrackedFree(MEMORY_TAG_IO, remote->clients);
+    TrackedFree(MEMORY_TAG_IO, remote->nudges);
+    TrackedFree(MEMORY_TAG_IO, remote->nodes);
+    TrackedFree(MEMORY_TAG_IO, remote->live);
+    TrackedFree(MEMORY_TAG_IO, remote->removed.data);
+    TrackedFree(MEMORY_TAG_IO, remote->upserts.data);
+    TrackedFree(MEMORY_TAG_IO, remote->moves.data);
+    TrackedFree(MEMORY_TAG_IO, remote->acks.data);
+    TrackedFree(MEMORY_TAG_IO, remote->snapshot.data);
+    TrackedFree(MEMORY_TAG_IO, remote);
+}
+
+void RegisterRemoteServer(ecs_world_t *world) {
+    ECS_COMPONENT_DEFINE(world, RemoteServerSettings);
+    ECS_COMPONENT_DEFINE(world, RemoteServerStats);
+    ECS_COMPONENT_DEFINE(world, RemoteModule);
+
+    ecs_singleton_set(world, RemoteServerSettings, {
+        .position_epsilon = 1e-4f,
+        .max_queue_bytes = 64ll * 1024 * 1024
+    });
+    ecs_singleton_set(world, RemoteServerStats, {0});
+
+    RemoteServer *remote = TrackedCalloc(MEMORY_TAG_IO, 1, sizeof(RemoteServer));
+    if (!remote) {
+        printf("Remote: out of memory\n");
+        return;
+    }
+    remote->loop_ready = uv_loop_init(&remote->loop) == 0;
+    remote->loop.data = remote;
+    if (remote->loop_ready) {
+        uv_timer_init(&remote->loop, &remote->wait_timer);
+    } else {
+        printf("Remote: cannot start the libuv loop, the server is off\n");
+    }
+    remote->node_query = ecs_query(world, {
+        .terms = {
+            { ecs_id(Position), .inout = EcsIn },
+            { ecs_id(TextContent), .inout = EcsInOutNone },
+            { ecs_id(FileReference), .inout = EcsInOutNone, .oper = EcsOptional },
+            { ecs_id(FunctionSymbol), .inout = EcsInOutNone, .oper = EcsOptional },
+            { ecs_id(FileSyntax), .inout = EcsIn, .oper = EcsOptional }
+        },
+        .cache_kind = EcsQueryCacheAuto
+    });
+    ecs_singleton_set(world, RemoteModule, {remote});
+    ecs_atfini(world, RemoteServerFini, remote);
+
+    ecs_system(world, {
+        .entity = ecs_entity(world, {
+            .name = "RemoteReceiveSystem",
+            .add = ecs_ids(ecs_dependson(EcsOnLoad))
+        }),
+        .callback = RemoteReceiveSystem,
+        .ctx = remote
+    });
+    ecs_system(world, {
+        .entity = ecs_entity(world, {
+            .name = "RemoteServerSystem",
+            .add = ecs_ids(ecs_dependson(EcsOnStore))
+        }),
+        .callback = RemoteServerSystem,
+        .ctx = remote
+    });
+}
@@ -0,0 +1,72 @@
+#ifndef REMOTE_SERVER_H
+#define REMOTE_SERVER_H
+
+#include <flecs.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "remote_protocol.h"
+
+// Phantom state served to remote viewers over a TCP or Unix domain socket.
+//
+// Every phantom (an entity with Position and TextContent) is mirrored by
+// the server under its entity index. At the end of a frame the system
+// compares the world with the mirror and encodes one DELTA message: the
+// phantoms that appeared or changed (text, token spans, color, edges), the
+// ones that moved relative to their parent and the ones that are gone.
+// Line text is only compared again when its file's buffer was edited or
+// lexed again, so an idle frame costs one pass over the positions. The
+// same encoded message is queued on every client's socket.
+//
+// A client that connects gets a SNAPSHOT of the mirror at the end of the
+// frame, then the deltas of later frames. A client whose socket has more
+// than max_queue_bytes unsent gets no deltas until it has drained, then a
+// new snapshot. NUDGE messages from clients move a node (and its children)
+// at the start of the next frame; the delta of that frame acknowledges them.
+//
+// Sockets run on a libuv loop owned by this module, served from the
+// systems (and by RemoteServerWait between frames in a headless loop).
+
+typedef struct {
+    float position_epsilon;   // Smaller moves relative to the parent are not sent
+    int64_t max_queue_bytes;  // Unsent bytes before a client is resynchronized
+} RemoteServerSettings;
+
+typedef struct {
+    bool listening;
+    int32_t port;             // Bound TCP port (0 for a Unix socket)
+    int32_t clients;
+    int32_t nodes;            // Phantoms in the mirror
+    uint32_t frame;           // Frames captured
+
+    int32_t removed_frame;    // Last frame's delta
+    int32_t upserted_frame;
+    int32_t moved_frame;
+    int64_t delta_bytes;
+    int32_t snapshots;        // Snapshots encoded (one per frame with new clients)
+    int64_t snapshot_bytes;   // Size of the last one
+    int32_t resyncs;          // Clients that fell behind and got a new snapshot
+    int32_t nudges;           // Applied since start
+    int64_t bytes_sent;       // Written to sockets since start
+    double capture_ms;        // Diff and encode of the last frame
+    double capture_max_ms;
+} RemoteServerStats;
+
+extern ECS_COMPONENT_DECLARE(RemoteServerSettings);
+extern ECS_COMPONENT_DECLARE(RemoteServerStats);
+
+// Listen on address: "host:port", "port" (on 127.0.0.1) or the path of a
+// Unix domain socket. Port 0 binds any free port (see RemoteServerStats).
+// Returns false if the server cannot listen.
+bool StartRemoteServer(ecs_world_t *world, const char *address);
+
+// Serve sockets (accept, read nudges, write) for up to ms milliseconds.
+// A headless loop calls this between frames instead of sleeping.
+void RemoteServerWait(ecs_world_t *world, double ms);
+
+// Systems
+void RemoteReceiveSystem(ecs_iter_t *it);
+void RemoteServerSystem(ecs_iter_t *it);
+
+void RegisterRemoteServer(ecs_world_t *world);
+
+#endif // REMOTE_SERVER_H
@@ -0,0 +1,1591 @@
+#include "search_index.h"
+#include "fuzzy_finder.h"
+#include "worker_pool.h"
+#include "memory_tracker.h"
+#include "syntax.h"
+#include "profiler.h"
+#include <pthread.h>
+#include <regex.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+ECS_COMPONENT_DECLARE(FileSearch);
+ECS_COMPONENT_DECLARE(SearchSettings);
+ECS_COMPONENT_DECLARE(SearchPrompt);
+ECS_COMPONENT_DECLARE(SearchStats);
+
+#define SEARCH_SOURCE_CHUNK 4         // Documents per extraction job (file sizes vary a lot)
+#define SEARCH_PARTITIONS 64          // Trigram ranges whose postings are written in parallel
+#define SEARCH_PARTITION_SHIFT 18     // 24-bit trigram >> 18 = partition
+#define SEARCH_OVERLAY_BATCH 32       // Larger batches are left to a background rebuild
+#define SEARCH_MAX_ALTERNATIVES 16    // Top-level regex alternatives planned separately
+#define SEARCH_MAX_PLAN_TRIGRAMS 32   // Required trigrams kept per alternative
+
+enum {
+    SEARCH_DOC_FREE,
+    SEARCH_DOC_PENDING,               // Not indexed yet: always a candidate
+    SEARCH_DOC_SEGMENT,
+    SEARCH_DOC_OVERLAY
+};
+
+typedef struct {
+    ecs_entity_t file;
+    uint32_t *trigrams;               // Overlay documents: sorted distinct trigrams
+    int trigram_count;
+    uint32_t version;                 // Bumped when the text changes or the id is reused
+    uint8_t state;
+} SearchDoc;
+
+// Immutable once built. Postings of key k are the bytes
+// [offsets[k], offsets[k + 1]): ascending document ids as varint deltas,
+// the first one from -1.
+typedef struct {
+    uint32_t *keys;                   // Sorted trigrams
+    int64_t *offsets;                 // count + 1 entries
+    uint32_t *doc_counts;
+    uint8_t *postings;
+    int count;
+    int64_t entries;
+} SearchSegment;
+
+// Copy of one document handed to the builder thread
+typedef struct {
+    int32_t doc;                      // -1 if its trigrams could not be extracted
+    uint32_t version;
+    char *text;
+    size_t length;
+    uint32_t *trigrams;
+    int trigram_count;
+} SearchSource;
+
+// Postings of one trigram range, written by one partition job
+typedef struct {
+    uint32_t *slots;                  // Entry + 1, 0 = empty
+    int slot_capacity;                // Power of two
+    uint32_t *keys;
+    int32_t *last_doc;
+    int64_t *bytes;                   // Size, then write position
+    uint32_t *doc_counts;
+    int count;
+    int capacity;
+    uint64_t *order;                  // key << 32 | entry, sorted
+    uint8_t *postings;
+    int64_t posting_bytes;
+    bool ok;
+} SearchPartition;
+
+typedef struct SearchIndex SearchIndex;
+
+typedef struct {
+    SearchIndex *search;              // Index that started the build
+    SearchSource *sources;            // Ascending document ids
+    int count;
+    SearchPartition partitions[SEARCH_PARTITIONS];
+    SearchSegment segment;
+    double build_ms;
+    bool ok;
+} SearchBuild;
+
+// Trigrams a match must contain: any alternative, all of its trigrams.
+// The longest literal run of each alternative anchors the regex: only
+// lines containing one are handed to regexec.
+typedef struct {
+    uint32_t trigrams[SEARCH_MAX_ALTERNATIVES][SEARCH_MAX_PLAN_TRIGRAMS];
+    int counts[SEARCH_MAX_ALTERNATIVES];
+    char anchors[SEARCH_MAX_ALTERNATIVES][SEARCH_MAX_QUERY];
+    int anchor_lengths[SEARCH_MAX_ALTERNATIVES];
+    int alternatives;
+    bool all;                         // Some alternative requires nothing
+} SearchPlan;
+
+struct SearchIndex {
+    SearchDoc *docs;
+    int doc_count;
+    int doc_capacity;
+    int32_t *free_docs;
+    int free_count;
+    int free_capacity;
+
+    SearchSegment segment;
+    SearchBuild *build;               // Running background build, NULL if none
+    pthread_t builder;
+    bool builder_started;
+    atomic_int build_done;
+
+    ecs_entity_t *pending;            // Files whose FileSyntax was set
+    int pending_count;
+    int pending_capacity;
+    bool recount;
+
+    uint8_t *candidates;              // Scratch: one flag per document
+    int candidate_capacity;
+    int32_t *matches;                 // Scratch: intersected postings, then matched lines
+    int match_capacity;
+    char *line;                       // Scratch: NUL-terminated line for regexec
+    int line_capacity;
+    SearchHit *hits;                  // Prompt results
+    int hit_capacity;
+    JobPool *pool;                    // Used by the builder thread only
+};
+
+// The index belongs to the world that registered the module: systems and
+// observers get it as ctx, API calls find it through this singleton
+typedef struct {
+    SearchIndex *search;
+} SearchModule;
+
+static ECS_COMPONENT_DECLARE(SearchModule);
+
+static SearchIndex *GetSearch(const ecs_world_t *world) {
+    const SearchModule *module = ecs_singleton_get(world, SearchModule);
+    return module ? module->search : NULL;
+}
+
+// Trigrams
+
+static inline uint32_t FoldByte(unsigned char c) {
+    return c >= 'A' && c <= 'Z' ? (uint32_t)c + 32u : (uint32_t)c;
+}
+
+// LSD radix sort of 24-bit keys, one byte per pass. Returns the buffer
+// holding the result (scratch, after an odd number of passes).
+static uint32_t *SortTrigrams(uint32_t *keys, uint32_t *scratch, int count) {
+    for (int shift = 0; shift < 24; shift += 8) {
+        int offsets[257] = {0};
+        for (int i = 0; i < count; i++) {
+            offsets[((keys[i] >> shift) & 0xFF) + 1]++;
+        }
+        for (int b = 0; b < 256; b++) {
+            offsets[b + 1] += offsets[b];
+        }
+        for (int i = 0; i < count; i++) {
+            scratch[offsets[(keys[i] >> shift) & 0xFF]++] = keys[i];
+        }
+        uint32_t *swap = keys;
+        keys = scratch;
+        scratch = swap;
+    }
+    return keys;
+}
+
+// Sorted distinct case-folded trigrams of text, none spanning a line
+// break. *out is malloc'ed; returns the count, -1 when out of memory.
+static int ExtractTrigrams(const char *text, size_t length, uint32_t **out) {
+    *out = NULL;
+    if (length < 3) {
+        return 0;
+    }
+    uint32_t *keys = TrackedMalloc(MEMORY_TAG_INDEX, sizeof(uint32_t) * (length - 2));
+    uint32_t *scratch = TrackedMalloc(MEMORY_TAG_INDEX, sizeof(uint32_t) * (length - 2));
+    if (!keys || !scratch) {
+        printf("SearchIndex: out of memory indexing %zu bytes\n", length);
+        TrackedFree(MEMORY_TAG_INDEX, keys);
+        TrackedFree(MEMORY_TAG_INDEX, scratch);
+        return -1;
+    }
+
+    int count = 0;
+    int run = 0;
+    uint32_t window = 0;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if (c == '\n') {
+            run = 0;
+            continue;
+        }
+        window = ((window << 8) | FoldByte(c)) & 0xFFFFFFu;
+        if (++run >= 3) {
+            keys[count++] = window;
+        }
+    }
+
+    uint32_t *sorted = SortTrigrams(keys, scratch, count);
+    TrackedFree(MEMORY_TAG_INDEX, sorted == keys ? scratch : keys);
+    int unique = 0;
+    for (int i = 0; i < count; i++) {
+        if (unique == 0 || sorted[unique - 1] != sorted[i]) {
+            sorted[unique++] = sorted[i];
+        }
+    }
+    if (unique == 0) {
+        TrackedFree(MEMORY_TAG_INDEX, sorted);
+        return 0;
+    }
+    uint32_t *shrunk = TrackedRealloc(MEMORY_TAG_INDEX, sorted, sizeof(uint32_t) * unique);
+    *out = shrunk ? shrunk : sorted;
+    return unique;
+}
+
+// First index whose trigram is >= key
+static int LowerBound(const uint32_t *trigrams, int count, uint32_t key) {
+    int lo = 0;
+    int hi = count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (trigrams[mid] < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static bool ContainsTrigram(const uint32_t *trigrams, int count, uint32_t key) {
+    int i = LowerBound(trigrams, count, key);
+    return i < count && trigrams[i] == key;
+}
+
+// Postings
+
+static int VarintSize(uint32_t value) {
+    int size = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+static uint8_t *PutVarint(uint8_t *p, uint32_t value) {
+    while (value >= 0x80) {
+        *p++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+static const uint8_t *GetVarint(const uint8_t *p, uint32_t *value) {
+    uint32_t result = 0;
+    int shift = 0;
+    while (*p & 0x80) {
+        result |= (uint32_t)(*p++ & 0x7F) << shift;
+        shift += 7;
+    }
+    *value = result | ((uint32_t)*p++ << shift);
+    return p;
+}
+
+static void FreeSegment(SearchSegment *segment) {
+    TrackedFree(MEMORY_TAG_INDEX, segment->keys);
+    TrackedFree(MEMORY_TAG_INDEX, segment->offsets);
+    TrackedFree(MEMORY_TAG_INDEX, segment->doc_counts);
+    TrackedFree(MEMORY_TAG_INDEX, segment->postings);
+    memset(segment, 0, sizeof(*segment));
+}
+
+static int FindSegmentKey(const SearchSegment *segment, uint32_t key) {
+    int k = LowerBound(segment->keys, segment->count, key);
+    return k < segment->count && segment->keys[k] == key ? k : -1;
+}
+
+// Segment build (background thread and its extraction jobs)
+
+static void ExtractJob(void *ctx, int chunk, int begin, int end) {
+    (void)chunk;
+    SearchBuild *build = ctx;
+    for (int i = begin; i < end; i++) {
+        SearchSource *source = &build->sources[i];
+        source->trigram_count = ExtractTrigrams(source->text, source->length, &source->trigrams);
+        if (source->trigram_count < 0) {
+            source->doc = -1;
+            source->trigram_count = 0;
+        }
+        TrackedFree(MEMORY_TAG_INDEX, source->text);
+        source->text = NULL;
+    }
+}
+
+static inline uint32_t PartitionSlot(uint32_t key, uint32_t mask) {
+    return (key * 2654435761u) & mask;
+}
+
+static bool RehashPartition(SearchPartition *part, int slot_capacity) {
+    uint32_t *slots = TrackedCalloc(MEMORY_TAG_INDEX, (size_t)slot_capacity, sizeof(uint32_t));
+    if (!slots) {
+        printf("SearchIndex: out of memory growing to %d elements\n", slot_capacity);
+        return false;
+    }
+    uint32_t mask = (uint32_t)slot_capacity - 1;
+    for (int e = 0; e < part->count; e++) {
+        uint32_t s = PartitionSlot(part->keys[e], mask);
+        while (slots[s]) {
+            s = (s + 1) & mask;
+        }
+        slots[s] = (uint32_t)e + 1;
+    }
+    TrackedFree(MEMORY_TAG_INDEX, part->slots);
+    part->slots = slots;
+    part->slot_capacity = slot_capacity;
+    return true;
+}
+
+static int FindPartitionEntry(const SearchPartition *part, uint32_t key) {
+    uint32_t mask = (uint32_t)part->slot_capacity - 1;
+    for (uint32_t s = PartitionSlot(key, mask);; s = (s + 1) & mask) {
+        uint32_t entry = part->slots[s];
+        if (entry == 0) {
+            return -1;
+        }
+        if (part->keys[entry - 1] == key) {
+            return (int)entry - 1;
+        }
+    }
+}
+
+static int InsertPartitionEntry(SearchPartition *part, uint32_t key) {
+    if (part->slot_capacity > 0) {
+        int e = FindPartitionEntry(part, key);
+        if (e >= 0) {
+            return e;
+        }
+    }
+    if ((part->count + 1) * 2 > part->slot_capacity &&
+        !RehashPartition(part, part->slot_capacity > 0 ? part->slot_capacity * 2 : 1024)) {
+        return -1;
+    }
+    int capacity = part->capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&part->keys, &capacity, part->count + 1, sizeof(uint32_t))) {
+        return -1;
+    }
+    capacity = part->capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&part->last_doc, &capacity, part->count + 1, sizeof(int32_t))) {
+        return -1;
+    }
+    capacity = part->capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&part->bytes, &capacity, part->count + 1, sizeof(int64_t))) {
+        return -1;
+    }
+    capacity = part->capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&part->doc_counts, &capacity, part->count + 1, sizeof(uint32_t))) {
+        return -1;
+    }
+    part->capacity = capacity;
+
+    int e = part->count++;
+    part->keys[e] = key;
+    part->last_doc[e] = -1;
+    part->bytes[e] = 0;
+    part->doc_counts[e] = 0;
+    uint32_t mask = (uint32_t)part->slot_capacity - 1;
+    uint32_t s = PartitionSlot(key, mask);
+    while (part->slots[s]) {
+        s = (s + 1) & mask;
+    }
+    part->slots[s] = (uint32_t)e + 1;
+    return e;
+}
+
+static int CompareOrder(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// Every source contributes the slice of its sorted trigrams that falls in
+// the partition, so partitions never touch the same entries
+static void BuildPartition(SearchBuild *build, int p) {
+    SearchPartition *part = &build->partitions[p];
+    uint32_t lo = (uint32_t)p << SEARCH_PARTITION_SHIFT;
+    uint32_t hi = (uint32_t)(p + 1) << SEARCH_PARTITION_SHIFT;
+
+    // 1. Entries and the size of their postings
+    for (int i = 0; i < build->count; i++) {
+        const SearchSource *source = &build->sources[i];
+        if (source->doc < 0) {
+            continue;
+        }
+        int first = LowerBound(source->trigrams, source->trigram_count, lo);
+        int last = LowerBound(source->trigrams, source->trigram_count, hi);
+        for (int t = first; t < last; t++) {
+            int e = InsertPartitionEntry(part, source->trigrams[t]);
+            if (e < 0) {
+                return;
+            }
+            part->bytes[e] += VarintSize((uint32_t)(source->doc - part->last_doc[e]));
+            part->last_doc[e] = source->doc;
+            part->doc_counts[e]++;
+        }
+    }
+
+    // 2. Entries in key order, each one's postings after the previous
+    part->order = TrackedMalloc(MEMORY_TAG_INDEX, sizeof(uint64_t) * (part->count + 1));
+    if (!part->order) {
+        return;
+    }
+    for (int e = 0; e < part->count; e++) {
+        part->order[e] = (uint64_t)part->keys[e] << 32 | (uint32_t)e;
+    }
+    qsort(part->order, (size_t)part->count, sizeof(uint64_t), CompareOrder);
+    int64_t total = 0;
+    for (int r = 0; r < part->count; r++) {
+        int e = (int)(uint32_t)part->order[r];
+        int64_t size = part->bytes[e];
+        part->bytes[e] = total;
+        part->last_doc[e] = -1;
+        total += size;
+    }
+    part->postings = TrackedMalloc(MEMORY_TAG_INDEX, total > 0 ? (size_t)total : 1);
+    if (!part->postings) {
+        return;
+    }
+    part->posting_bytes = total;
+
+    // 3. Deltas, in document order
+    for (int i = 0; i < build->count; i++) {
+        const SearchSource *source = &build->sources[i];
+        if (source->doc < 0) {
+            continue;
+        }
+        int first = LowerBound(source->trigrams, source->trigram_count, lo);
+        int last = LowerBound(source->trigrams, source->trigram_count, hi);
+        for (int t = first; t < last; t++) {
+            int e = FindPartitionEntry(part, source->trigrams[t]);
+            uint8_t *end = PutVarint(part->postings + part->bytes[e],
+                                     (uint32_t)(source->doc - part->last_doc[e]));
+            part->bytes[e] = end - part->postings;
+            part->last_doc[e] = source->doc;
+        }
+    }
+    part->ok = true;
+}
+
+static void PartitionJob(void *ctx, int chunk, int begin, int end) {
+    (void)chunk;
+    for (int p = begin; p < end; p++) {
+        BuildPartition(ctx, p);
+    }
+}
+
+static void FreePartition(SearchPartition *part) {
+    TrackedFree(MEMORY_TAG_INDEX, part->slots);
+    TrackedFree(MEMORY_TAG_INDEX, part->keys);
+    TrackedFree(MEMORY_TAG_INDEX, part->last_doc);
+    TrackedFree(MEMORY_TAG_INDEX, part->bytes);
+    TrackedFree(MEMORY_TAG_INDEX, part->doc_counts);
+    TrackedFree(MEMORY_TAG_INDEX, part->order);
+    TrackedFree(MEMORY_TAG_INDEX, part->postings);
+    memset(part, 0, sizeof(*part));
+}
+
+// Partitions cover ascending key ranges, so concatenating them keeps the
+// segment sorted
+static bool MergePartitions(SearchBuild *build) {
+    int count = 0;
+    int64_t bytes = 0;
+    for (int p = 0; p < SEARCH_PARTITIONS; p++) {
+        if (!build->partitions[p].ok) {
+            return false;
+        }
+        count += build->partitions[p].count;
+        bytes += build->partitions[p].posting_bytes;
+    }
+
+    SearchSegment *segment = &build->segment;
+    segment->keys = TrackedMalloc(MEMORY_TAG_INDEX, sizeof(uint32_t) * (count + 1));
+    segment->offsets = TrackedMalloc(MEMORY_TAG_INDEX, sizeof(int64_t) * (count + 1));
+    segment->doc_counts = TrackedMalloc(MEMORY_TAG_INDEX, sizeof(uint32_t) * (count + 1));
+    segment->postings = TrackedMalloc(MEMORY_TAG_INDEX, bytes > 0 ? (size_t)bytes : 1);
+    if (!segment->keys || !segment->offsets || !segment->doc_counts || !segment->postings) {
+        printf("SearchIndex: out of memory merging %d trigrams\n", count);
+        FreeSegment(segment);
+        return false;
+    }
+
+    int k = 0;
+    int64_t base = 0;
+    for (int p = 0; p < SEARCH_PARTITIONS; p++) {
+        const SearchPartition *part = &build->partitions[p];
+        int64_t start = 0;
+        for (int r = 0; r < part->count; r++) {
+            int e = (int)(uint32_t)part->order[r];
+            segment->keys[k] = part->keys[e];
+            segment->doc_counts[k] = part->doc_counts[e];
+            segment->offsets[k] = base + start;
+            segment->entries += part->doc_counts[e];
+            start = part->bytes[e];
+            k++;
+        }
+        if (part->posting_bytes > 0) {
+            memcpy(segment->postings + base, part->postings, (size_t)part->posting_bytes);
+        }
+        base += part->posting_bytes;
+    }
+    segment->offsets[count] = bytes;
+    segment->count = count;
+    return true;
+}
+
+static void BuildSegment(SearchBuild *build) {
+    SearchIndex *search = build->search;
+    PROFILE_ZONE_BEGIN(BuildSearchSegment);
+    uint64_t start = ProfilerNow();
+    JobPoolParallelFor(search->pool, build->count, SEARCH_SOURCE_CHUNK, ExtractJob, build);
+    JobPoolParallelFor(search->pool, SEARCH_PARTITIONS, 1, PartitionJob, build);
+    build->ok = MergePartitions(build);
+    for (int p = 0; p < SEARCH_PARTITIONS; p++) {
+        FreePartition(&build->partitions[p]);
+    }
+    for (int i = 0; i < build->count; i++) {
+        TrackedFree(MEMORY_TAG_INDEX, build->sources[i].trigrams);
+        build->sources[i].trigrams = NULL;
+    }
+    build->build_ms = (double)(ProfilerNow() - start) / 1e6;
+    PROFILE_ZONE_END(BuildSearchSegment);
+}
+
+static void *SearchBuilderMain(void *arg) {
+    SearchBuild *build = arg;
+    BuildSegment(build);
+    atomic_store(&build->search->build_done, 1);
+    return NULL;
+}
+
+// Documents
+
+static int32_t AllocateDoc(SearchIndex *search, ecs_entity_t file) {
+    int32_t doc;
+    if (search->free_count > 0) {
+        doc = search->free_docs[--search->free_count];
+    } else {
+        if (!GrowArray(MEMORY_TAG_INDEX, (void**)&search->docs, &search->doc_capacity, search->doc_count + 1,
+                       sizeof(SearchDoc))) {
+            return -1;
+        }
+        doc = search->doc_count++;
+        memset(&search->docs[doc], 0, sizeof(SearchDoc));
+    }
+    search->docs[doc].file = file;
+    search->docs[doc].state = SEARCH_DOC_PENDING;
+    search->docs[doc].version++;
+    return doc;
+}
+
+static void ClearOverlay(SearchDoc *doc) {
+    TrackedFree(MEMORY_TAG_INDEX, doc->trigrams);
+    doc->trigrams = NULL;
+    doc->trigram_count = 0;
+}
+
+static const char *DocText(ecs_world_t *world, const SearchDoc *doc, size_t *length) {
+    *length = 0;
+    if (!ecs_is_alive(world, doc->file)) {
+        return NULL;
+    }
+    return GetFileSyntaxText(world, ecs_get(world, doc->file, FileSyntax), length);
+}
+
+// Copies the text of every document and hands them to the builder thread
+static void StartSearchBuild(ecs_world_t *world, SearchIndex *search) {
+    SearchBuild *build = TrackedCalloc(MEMORY_TAG_INDEX, 1, sizeof(SearchBuild));
+    if (build) {
+        build->sources = TrackedCalloc(MEMORY_TAG_INDEX, (size_t)search->doc_count + 1, sizeof(SearchSource));
+    }
+    if (build) {
+        build->search = search;
+    }
+    if (!build || !build->sources) {
+        printf("SearchIndex: out of memory snapshotting %d files\n", search->doc_count);
+        TrackedFree(MEMORY_TAG_INDEX, build);
+        return;
+    }
+
+    PROFILE_ZONE_BEGIN(SnapshotSearchSources);
+    for (int d = 0; d < search->doc_count; d++) {
+        SearchDoc *doc = &search->docs[d];
+        size_t length;
+        if (doc->state == SEARCH_DOC_FREE) {
+            continue;
+        }
+        // A file without text has nothing to find
+        const char *text = DocText(world, doc, &length);
+        if (!text) {
+            ClearOverlay(doc);
+            doc->state = SEARCH_DOC_OVERLAY;
+            continue;
+        }
+        char *copy = TrackedMalloc(MEMORY_TAG_INDEX, length + 1);
+        if (!copy) {
+            continue;
+        }
+        memcpy(copy, text, length);
+        build->sources[build->count++] = (SearchSource){
+            .doc = d,
+            .version = doc->version,
+            .text = copy,
+            .length = length
+        };
+    }
+    PROFILE_ZONE_END(SnapshotSearchSources);
+
+    search->build = build;
+    atomic_store(&search->build_done, 0);
+    search->builder_started = pthread_create(&search->builder, NULL, SearchBuilderMain, build) == 0;
+    if (!search->builder_started) {
+        printf("SearchIndex: no builder thread, building %d files inline\n", build->count);
+        BuildSegment(build);
+        atomic_store(&search->build_done, 1);
+    }
+    SearchStats *stats = ecs_singleton_get_mut(world, SearchStats);
+    stats->building = true;
+}
+
+// Documents whose text is still the one the builder copied move to the
+// segment; the others keep their overlay or stay pending
+static void InstallSearchBuild(ecs_world_t *world, SearchIndex *search) {
+    SearchBuild *build = search->build;
+    if (search->builder_started) {
+        pthread_join(search->builder, NULL);
+    }
+    search->build = NULL;
+    search->builder_started = false;
+
+    SearchStats *stats = ecs_singleton_get_mut(world, SearchStats);
+    stats->building = false;
+    stats->build_ms = build->build_ms;
+    if (build->ok) {
+        FreeSegment(&search->segment);
+        search->segment = build->segment;
+        for (int d = 0; d < search->doc_count; d++) {
+            if (search->docs[d].state == SEARCH_DOC_SEGMENT) {
+                search->docs[d].state = SEARCH_DOC_PENDING;
+            }
+        }
+        for (int i = 0; i < build->count; i++) {
+            const SearchSource *source = &build->sources[i];
+            SearchDoc *doc = source->doc >= 0 ? &search->docs[source->doc] : NULL;
+            if (doc && doc->state != SEARCH_DOC_FREE && doc->version == source->version) {
+                ClearOverlay(doc);
+                doc->state = SEARCH_DOC_SEGMENT;
+            }
+        }
+        stats->builds++;
+    } else {
+        FreeSegment(&build->segment);
+        printf("SearchIndex: segment build failed, keeping the previous one\n");
+    }
+
+    for (int i = 0; i < build->count; i++) {
+        TrackedFree(MEMORY_TAG_INDEX, build->sources[i].text);
+        TrackedFree(MEMORY_TAG_INDEX, build->sources[i].trigrams);
+    }
+    TrackedFree(MEMORY_TAG_INDEX, build->sources);
+    TrackedFree(MEMORY_TAG_INDEX, build);
+    search->recount = true;
+}
+
+static void IndexOverlay(ecs_world_t *world, SearchDoc *doc) {
+    size_t length;
+    const char *text = DocText(world, doc, &length);
+    if (!text) {
+        return;
+    }
+    uint32_t *trigrams;
+    int count = ExtractTrigrams(text, length, &trigrams);
+    if (count < 0) {
+        return;
+    }
+    ClearOverlay(doc);
+    doc->trigrams = trigrams;
+    doc->trigram_count = count;
+    doc->state = SEARCH_DOC_OVERLAY;
+}
+
+static int CompareEntities(const void *a, const void *b) {
+    ecs_entity_t x = *(const ecs_entity_t*)a;
+    ecs_entity_t y = *(const ecs_entity_t*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+void UpdateSearchIndex(ecs_world_t *world) {
+    const SearchSettings *settings = ecs_singleton_get(world, SearchSettings);
+    SearchIndex *search = GetSearch(world);
+    if (!settings || !search) {
+        return;
+    }
+    if (search->build && atomic_load(&search->build_done)) {
+        InstallSearchBuild(world, search);
+    }
+    if (search->pending_count == 0 && !search->recount) {
+        return;
+    }
+
+    PROFILE_ZONE_BEGIN(UpdateSearchIndex);
+    // A file set several times since the last update is indexed once
+    qsort(search->pending, (size_t)search->pending_count, sizeof(ecs_entity_t), CompareEntities);
+    for (int i = 0; i < search->pending_count; i++) {
+        ecs_entity_t file = search->pending[i];
+        if ((i > 0 && file == search->pending[i - 1]) || !ecs_is_alive(world, file)) {
+            continue;
+        }
+        const FileSearch *existing = ecs_get(world, file, FileSearch);
+        int32_t d = existing ? existing->doc : -1;
+        if (d < 0) {
+            d = AllocateDoc(search, file);
+            if (d < 0) {
+                continue;
+            }
+            ecs_set(world, file, FileSearch, {d});
+        } else {
+            search->docs[d].version++;
+            search->docs[d].state = SEARCH_DOC_PENDING;
+        }
+        ClearOverlay(&search->docs[d]);
+    }
+    search->pending_count = 0;
+
+    int documents = 0;
+    int pending = 0;
+    int overlay = 0;
+    for (int d = 0; d < search->doc_count; d++) {
+        uint8_t state = search->docs[d].state;
+        documents += state != SEARCH_DOC_FREE;
+        pending += state == SEARCH_DOC_PENDING;
+        overlay += state == SEARCH_DOC_OVERLAY;
+    }
+
+    // A batch (the first load, a whole-project reload) or an overlay grown
+    // past a quarter of the index is left to the builder; a few edits are
+    // indexed right away, even while a build runs
+    bool rebuild = pending > SEARCH_OVERLAY_BATCH ||
+                   (overlay > SEARCH_OVERLAY_BATCH && overlay * 4 > documents);
+    if (rebuild && !search->build) {
+        StartSearchBuild(world, search);
+    } else if (pending > 0 && pending <= SEARCH_OVERLAY_BATCH) {
+        uint64_t start = ProfilerNow();
+        for (int d = 0; d < search->doc_count; d++) {
+            if (search->docs[d].state == SEARCH_DOC_PENDING) {
+                IndexOverlay(world, &search->docs[d]);
+            }
+        }
+        ecs_singleton_get_mut(world, SearchStats)->overlay_ms = (double)(ProfilerNow() - start) / 1e6;
+    }
+
+    SearchStats *stats = ecs_singleton_get_mut(world, SearchStats);
+    stats->documents = documents;
+    stats->segment_documents = 0;
+    stats->overlay_documents = 0;
+    stats->pending_documents = 0;
+    for (int d = 0; d < search->doc_count; d++) {
+        uint8_t state = search->docs[d].state;
+        stats->segment_documents += state == SEARCH_DOC_SEGMENT;
+        stats->overlay_documents += state == SEARCH_DOC_OVERLAY;
+        stats->pending_documents += state == SEARCH_DOC_PENDING;
+    }
+    stats->trigrams = search->segment.count;
+    stats->postings = search->segment.entries;
+    stats->segment_bytes = search->segment.count > 0 ? search->segment.offsets[search->segment.count] : 0;
+    stats->threads = JobPoolWorkerCount(search->pool) + 1;
+    search->recount = false;
+    PROFILE_ZONE_END(UpdateSearchIndex);
+}
+
+// Installing a build may start another one for files changed meanwhile
+void WaitSearchIndex(ecs_world_t *world) {
+    SearchIndex *search = GetSearch(world);
+    if (!search) {
+        return;
+    }
+    UpdateSearchIndex(world);
+    while (search->build) {
+        if (search->builder_started) {
+            pthread_join(search->builder, NULL);
+            search->builder_started = false;
+        }
+        atomic_store(&search->build_done, 1);
+        UpdateSearchIndex(world);
+    }
+}
+
+// Query planning
+
+static void PlanRun(SearchPlan *plan, int alternative, const char *run, int length) {
+    if (length > plan->anchor_lengths[alternative] && length < SEARCH_MAX_QUERY) {
+        memcpy(plan->anchors[alternative], run, (size_t)length);
+        plan->anchors[alternative][length] = '\0';
+        plan->anchor_lengths[alternative] = length;
+    }
+    int *count = &plan->counts[alternative];
+    for (int i = 0; i + 3 <= length && *count < SEARCH_MAX_PLAN_TRIGRAMS; i++) {
+        uint32_t key = FoldByte((unsigned char)run[i]) << 16 | FoldByte((unsigned char)run[i + 1]) << 8 |
+                       FoldByte((unsigned char)run[i + 2]);
+        bool duplicate = false;
+        for (int t = 0; t < *count && !duplicate; t++) {
+            duplicate = plan->trigrams[alternative][t] == key;
+        }
+        if (!duplicate) {
+            plan->trigrams[alternative][(*count)++] = key;
+        }
+    }
+}
+
+// Skips a bracket expression starting at '[', returns the index after ']'
+static int SkipBracket(const char *pattern, int i) {
+    i++;
+    if (pattern[i] == '^') {
+        i++;
+    }
+    if (pattern[i] == ']') {
+        i++;
+    }
+    while (pattern[i] && pattern[i] != ']') {
+        // [:alpha:] and friends contain a ']' of their own
+        if (pattern[i] == '[' && (pattern[i + 1] == ':' || pattern[i + 1] == '.' || pattern[i + 1] == '=')) {
+            char kind = pattern[i + 1];
+            i += 2;
+            while (pattern[i] && !(pattern[i] == kind && pattern[i + 1] == ']')) {
+                i++;
+            }
+            i += pattern[i] ? 2 : 0;
+            continue;
+        }
+        i++;
+    }
+    return pattern[i] ? i + 1 : i;
+}
+
+// Skips a group starting at '(', returns the index after its ')'
+static int SkipGroup(const char *pattern, int i) {
+    int depth = 0;
+    while (pattern[i]) {
+        if (pattern[i] == '\\' && pattern[i + 1]) {
+            i += 2;
+            continue;
+        }
+        if (pattern[i] == '[') {
+            i = SkipBracket(pattern, i);
+            continue;
+        }
+        if (pattern[i] == '(') {
+            depth++;
+        } else if (pattern[i] == ')' && --depth == 0) {
+            return i + 1;
+        }
+        i++;
+    }
+    return i;
+}
+
+// Literal runs every match of one alternative must contain. Anything that
+// is not a plain character (classes, groups, '.', anchors, escapes like
+// \w) ends the current run; an atom made optional by '*', '?' or '{' is
+// dropped, one repeated by '+' ends the run after itself.
+static void PlanRegexAlternative(SearchPlan *plan, const char *pattern, int begin, int end) {
+    int alternative = plan->alternatives++;
+    char run[SEARCH_MAX_QUERY];
+    int run_length = 0;
+    int i = begin;
+    while (i < end) {
+        bool literal = false;
+        char c = pattern[i];
+        int next;
+        if (c == '\\' && i + 1 < end) {
+            char escaped = pattern[i + 1];
+            bool is_class = (escaped >= 'a' && escaped <= 'z') || (escaped >= 'A' && escaped <= 'Z') ||
+                            (escaped >= '0' && escaped <= '9');
+            literal = !is_class;
+            c = escaped;
+            next = i + 2;
+        } else if (c == '[') {
+            next = SkipBracket(pattern, i);
+        } else if (c == '(') {
+            next = SkipGroup(pattern, i);
+        } else {
+            literal = strchr(".^$)*+?{", c) == NULL;
+            next = i + 1;
+        }
+        if (next > end) {
+            next = end;
+        }
+
+        // Quantifiers may stack (a+?, a+*): the atom stays required only
+        // if every one of them is '+'
+        bool repeated = false;
+        bool optional = false;
+        i = next;
+        while (i < end && (pattern[i] == '*' || pattern[i] == '+' || pattern[i] == '?' || pattern[i] == '{')) {
+            repeated = true;
+            optional |= pattern[i] != '+';
+            if (pattern[i] == '{') {
+                while (i < end && pattern[i] != '}') {
+                    i++;
+                }
+            }
+            i += i < end;
+        }
+        if (literal && !optional && run_length < (int)sizeof(run)) {
+            run[run_length++] = c;
+        }
+        if (!literal || repeated) {
+            PlanRun(plan, alternative, run, run_length);
+            run_length = 0;
+        }
+    }
+    PlanRun(plan, alternative, run, run_length);
+}
+
+static void PlanRegex(SearchPlan *plan, const char *pattern) {
+    int length = (int)strlen(pattern);
+    int begin = 0;
+    int depth = 0;
+    for (int i = 0; i <= length; i++) {
+        char c = pattern[i];
+        if (c == '\\' && i + 1 < length) {
+            i++;
+        } else if (c == '[') {
+            i = SkipBracket(pattern, i) - 1;
+        } else if (c == '(') {
+            depth++;
+        } else if (c == ')' && depth > 0) {
+            depth--;
+        } else if ((c == '|' && depth == 0) || c == '\0') {
+            if (plan->alternatives == SEARCH_MAX_ALTERNATIVES) {
+                plan->all = true;
+                return;
+            }
+            PlanRegexAlternative(plan, pattern, begin, i);
+            begin = i + 1;
+        }
+    }
+}
+
+// Candidates
+
+// Documents in the postings of every trigram, ascending
+static int IntersectPostings(SearchIndex *search, const uint32_t *trigrams, int count) {
+    const SearchSegment *segment = &search->segment;
+    int entries[SEARCH_MAX_PLAN_TRIGRAMS];
+    for (int t = 0; t < count; t++) {
+        entries[t] = FindSegmentKey(segment, trigrams[t]);
+        if (entries[t] < 0) {
+            return 0;
+        }
+    }
+    // Shortest postings first keeps the running intersection small
+    for (int t = 1; t < count; t++) {
+        int e = entries[t];
+        int j = t;
+        while (j > 0 && segment->doc_counts[entries[j - 1]] > segment->doc_counts[e]) {
+            entries[j] = entries[j - 1];
+            j--;
+        }
+        entries[j] = e;
+    }
+
+    int n = (int)segment->doc_counts[entries[0]];
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&search->matches, &search->match_capacity, n + 1, sizeof(int32_t))) {
+        return 0;
+    }
+    const uint8_t *p = segment->postings + segment->offsets[entries[0]];
+    int32_t doc = -1;
+    for (int i = 0; i < n; i++) {
+        uint32_t delta;
+        p = GetVarint(p, &delta);
+        doc += (int32_t)delta;
+        search->matches[i] = doc;
+    }
+
+    for (int t = 1; t < count && n > 0; t++) {
+        p = segment->postings + segment->offsets[entries[t]];
+        const uint8_t *end = segment->postings + segment->offsets[entries[t] + 1];
+        doc = -1;
+        bool have = false;
+        int kept = 0;
+        int i = 0;
+        while (i < n) {
+            if (!have) {
+                if (p >= end) {
+                    break;
+                }
+                uint32_t delta;
+                p = GetVarint(p, &delta);
+                doc += (int32_t)delta;
+                have = true;
+            }
+            if (doc < search->matches[i]) {
+                have = false;
+            } else if (doc > search->matches[i]) {
+                i++;
+            } else {
+                search->matches[kept++] = search->matches[i++];
+                have = false;
+            }
+        }
+        n = kept;
+    }
+    return n;
+}
+
+// Flags the documents that may match: segment postings, overlay lists,
+// and every document not indexed yet
+static int MarkCandidates(SearchIndex *search, const SearchPlan *plan) {
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&search->candidates, &search->candidate_capacity, search->doc_count + 1,
+                   1)) {
+        return 0;
+    }
+    memset(search->candidates, 0, (size_t)search->doc_count);
+
+    for (int a = 0; a < plan->alternatives && !plan->all; a++) {
+        const uint32_t *trigrams = plan->trigrams[a];
+        int count = plan->counts[a];
+        if (count == 0) {
+            break;
+        }
+        int matches = IntersectPostings(search, trigrams, count);
+        for (int m = 0; m < matches; m++) {
+            int32_t d = search->matches[m];
+            if (d < search->doc_count && search->docs[d].state == SEARCH_DOC_SEGMENT) {
+                search->candidates[d] = 1;
+            }
+        }
+        for (int d = 0; d < search->doc_count; d++) {
+            const SearchDoc *doc = &search->docs[d];
+            if (doc->state != SEARCH_DOC_OVERLAY || search->candidates[d]) {
+                continue;
+            }
+            bool all = true;
+            for (int t = 0; t < count && all; t++) {
+                all = ContainsTrigram(doc->trigrams, doc->trigram_count, trigrams[t]);
+            }
+            search->candidates[d] = all;
+        }
+    }
+
+    bool everything = plan->all || plan->alternatives == 0;
+    for (int a = 0; a < plan->alternatives; a++) {
+        everything |= plan->counts[a] == 0;
+    }
+    int candidates = 0;
+    for (int d = 0; d < search->doc_count; d++) {
+        uint8_t state = search->docs[d].state;
+        if (state == SEARCH_DOC_PENDING || (everything && state != SEARCH_DOC_FREE)) {
+            search->candidates[d] = 1;
+        }
+        candidates += search->candidates[d];
+    }
+    return candidates;
+}
+
+// Verification
+
+static int CountNewlines(const char *begin, const char *end) {
+    int count = 0;
+    while (begin < end && (begin = memchr(begin, '\n', (size_t)(end - begin))) != NULL) {
+        count++;
+        begin++;
+    }
+    return count;
+}
+
+static const char *FindLiteral(const char *p, const char *end, const char *needle, size_t n, bool fold) {
+    if ((size_t)(end - p) < n) {
+        return NULL;
+    }
+    const char *last = end - n;
+    if (!fold) {
+        while (p <= last && (p = memchr(p, needle[0], (size_t)(last - p) + 1)) != NULL) {
+            if (memcmp(p, needle, n) == 0) {
+                return p;
+            }
+            p++;
+        }
+        return NULL;
+    }
+    // Both cases of the first byte are found with memchr
+    char lower = (char)FoldByte((unsigned char)needle[0]);
+    char upper = lower >= 'a' && lower <= 'z' ? (char)(lower - 32) : lower;
+    while (p <= last) {
+        size_t span = (size_t)(last - p) + 1;
+        const char *a = memchr(p, lower, span);
+        const char *b = upper != lower ? memchr(p, upper, a ? (size_t)(a - p) : span) : NULL;
+        p = b ? b : a;
+        if (!p) {
+            return NULL;
+        }
+        size_t k = 1;
+        while (k < n && FoldByte((unsigned char)p[k]) == FoldByte((unsigned char)needle[k])) {
+            k++;
+        }
+        if (k == n) {
+            return p;
+        }
+        p++;
+    }
+    return NULL;
+}
+
+// One hit per matching line, at most max_hits - count of them
+static int VerifyLiteral(const char *text, size_t length, const char *needle, bool fold,
+                         ecs_entity_t file, SearchHit *hits, int count, int max_hits) {
+    size_t n = strlen(needle);
+    const char *end = text + length;
+    const char *p = text;
+    const char *counted = text;
+    int line = 0;
+    while (count < max_hits) {
+        const char *match = FindLiteral(p, end, needle, n, fold);
+        if (!match) {
+            break;
+        }
+        line += CountNewlines(counted, match);
+        hits[count++] = (SearchHit){file, file, line};
+        const char *newline = memchr(match, '\n', (size_t)(end - match));
+        if (!newline) {
+            break;
+        }
+        p = counted = newline + 1;
+        line++;
+    }
+    return count;
+}
+
+static bool MatchLine(SearchIndex *search, const regex_t *regex, const char *begin, const char *end) {
+    int length = (int)(end - begin);
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&search->line, &search->line_capacity, length + 1, 1)) {
+        return false;
+    }
+    memcpy(search->line, begin, (size_t)length);
+    search->line[length] = '\0';
+    return regexec(regex, search->line, 0, NULL, 0) == 0;
+}
+
+static int CompareLines(const void *a, const void *b) {
+    int32_t x = *(const int32_t*)a;
+    int32_t y = *(const int32_t*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// Lines holding an anchor of some alternative are matched, the rest are
+// skipped; without anchors every line is
+static int VerifyRegex(SearchIndex *search, const regex_t *regex, const SearchPlan *plan, bool fold,
+                       const char *text, size_t length, ecs_entity_t file, SearchHit *hits, int count,
+                       int max_hits) {
+    const char *end = text + length;
+    bool anchored = !plan->all && plan->alternatives > 0;
+    for (int a = 0; a < plan->alternatives; a++) {
+        anchored &= plan->anchor_lengths[a] > 0;
+    }
+    if (!anchored) {
+        const char *p = text;
+        for (int line = 0; p < end && count < max_hits; line++) {
+            const char *newline = memchr(p, '\n', (size_t)(end - p));
+            if (MatchLine(search, regex, p, newline ? newline : end)) {
+                hits[count++] = (SearchHit){file, file, line};
+            }
+            p = newline ? newline + 1 : end;
+        }
+        return count;
+    }
+
+    int matched = 0;
+    for (int a = 0; a < plan->alternatives; a++) {
+        const char *p = text;
+        const char *counted = text;
+        int line = 0;
+        const char *match;
+        while ((match = FindLiteral(p, end, plan->anchors[a], (size_t)plan->anchor_lengths[a], fold)) != NULL) {
+            line += CountNewlines(counted, match);
+            const char *begin = match;
+            while (begin > text && begin[-1] != '\n') {
+                begin--;
+            }
+            const char *newline = memchr(match, '\n', (size_t)(end - match));
+            if (MatchLine(search, regex, begin, newline ? newline : end) &&
+                GrowArray(MEMORY_TAG_INDEX, (void**)&search->matches, &search->match_capacity, matched + 1,
+                          sizeof(int32_t))) {
+                search->matches[matched++] = line;
+            }
+            if (!newline) {
+                break;
+            }
+            p = counted = newline + 1;
+            line++;
+        }
+    }
+
+    // Alternatives may find the same line
+    qsort(search->matches, (size_t)matched, sizeof(int32_t), CompareLines);
+    for (int m = 0; m < matched && count < max_hits; m++) {
+        if (m == 0 || search->matches[m] != search->matches[m - 1]) {
+            hits[count++] = (SearchHit){file, file, search->matches[m]};
+        }
+    }
+    return count;
+}
+
+static int CompareHitLine(const void *key, const void *hit) {
+    int32_t line = *(const int32_t*)key;
+    int32_t other = ((const SearchHit*)hit)->line;
+    return line < other ? -1 : (line > other ? 1 : 0);
+}
+
+// Hits of one file (ascending lines) get the line phantom of their line
+static void ResolveHitEntities(ecs_world_t *world, ecs_entity_t file, SearchHit *hits, int count) {
+    ecs_iter_t it = ecs_children(world, file);
+    while (ecs_children_next(&it)) {
+        for (int i = 0; i < it.count; i++) {
+            const FileReference *ref = ecs_get(world, it.entities[i], FileReference);
+            if (!ref) {
+                continue;
+            }
+            int32_t line = ref->line_number;
+            SearchHit *hit = bsearch(&line, hits, (size_t)count, sizeof(SearchHit), CompareHitLine);
+            if (hit) {
+                hit->entity = it.entities[i];
+            }
+        }
+    }
+}
+
+int SearchPhantoms(ecs_world_t *world, const char *pattern, int flags, SearchHit *hits, int max_hits) {
+    SearchIndex *search = GetSearch(world);
+    if (!search || !pattern || !pattern[0] || max_hits <= 0 || strchr(pattern, '\n')) {
+        return 0;
+    }
+
+    PROFILE_ZONE_BEGIN(SearchPhantoms);
+    uint64_t start = ProfilerNow();
+    bool fold = (flags & SEARCH_IGNORE_CASE) != 0;
+    bool is_regex = (flags & SEARCH_REGEX) != 0;
+    regex_t regex;
+    SearchPlan plan = {0};
+    if (is_regex) {
+        if (regcomp(&regex, pattern, REG_EXTENDED | REG_NOSUB | (fold ? REG_ICASE : 0)) != 0) {
+            PROFILE_ZONE_END(SearchPhantoms);
+            return -1;
+        }
+        PlanRegex(&plan, pattern);
+    } else {
+        plan.alternatives = 1;
+        PlanRun(&plan, 0, pattern, (int)strlen(pattern));
+    }
+
+    int candidates = MarkCandidates(search, &plan);
+    int count = 0;
+    for (int d = 0; d < search->doc_count && count < max_hits; d++) {
+        if (!search->candidates[d]) {
+            continue;
+        }
+        size_t length;
+        const char *text = DocText(world, &search->docs[d], &length);
+        if (!text) {
+            continue;
+        }
+        ecs_entity_t file = search->docs[d].file;
+        int first = count;
+        count = is_regex ? VerifyRegex(search, &regex, &plan, fold, text, length, file, hits, count, max_hits)
+                         : VerifyLiteral(text, length, pattern, fold, file, hits, count, max_hits);
+        if (count > first) {
+            ResolveHitEntities(world, file, hits + first, count - first);
+        }
+    }
+    if (is_regex) {
+        regfree(&regex);
+    }
+
+    SearchStats *stats = ecs_singleton_get_mut(world, SearchStats);
+    stats->query_trigrams = 0;
+    for (int a = 0; a < plan.alternatives; a++) {
+        stats->query_trigrams += plan.counts[a];
+    }
+    stats->candidates = candidates;
+    stats->hits = count;
+    stats->query_us = (double)(ProfilerNow() - start) / 1e3;
+    PROFILE_ZONE_END(SearchPhantoms);
+    return count;
+}
+
+int SelectSearchHits(ecs_world_t *world, const char *pattern, int flags) {
+    const SearchSettings *settings = ecs_singleton_get(world, SearchSettings);
+    SearchIndex *search = GetSearch(world);
+    if (!settings || !search || !GrowArray(MEMORY_TAG_INDEX, (void**)&search->hits, &search->hit_capacity,
+                                           settings->max_hits, sizeof(SearchHit))) {
+        return 0;
+    }
+    int count = SearchPhantoms(world, pattern, flags, search->hits, settings->max_hits);
+    if (count < 0) {
+        return -1;
+    }
+
+    // Deselect first so the selection observer restores the old phantoms
+    ecs_defer_begin(world);
+    ecs_iter_t it = ecs_each_id(world, ecs_id(Selected));
+    while (ecs_each_next(&it)) {
+        for (int i = 0; i < it.count; i++) {
+            ecs_set(world, it.entities[i], Selected, {.is_selected = false});
+            ecs_remove(world, it.entities[i], Selected);
+        }
+    }
+
+    float now = (float)ecs_get_world_info(world)->world_time_total;
+    for (int k = 0; k < count; k++) {
+        ecs_set(world, search->hits[k].entity, Selected, {
+            .is_selected = true,
+            .selection_id = (uint32_t)k,
+            .selection_time = now
+        });
+    }
+    ecs_defer_end(world);
+
+    ecs_singleton_get_mut(world, SearchPrompt)->hits = count;
+    const Position *position = count > 0 ? ecs_get(world, search->hits[0].entity, Position) : NULL;
+    if (position) {
+        FlyCameraTo(world, (Vector3){position->x, position->y, position->z});
+    }
+    return count;
+}
+
+void FlyCameraTo(ecs_world_t *world, Vector3 target) {
+    SearchPrompt *prompt = ecs_singleton_get_mut(world, SearchPrompt);
+    prompt->fly_target = target;
+    prompt->flying = true;
+}
+
+// Indexing happens at the start of the next frame, so edits of one frame
+// to the same file are indexed once
+void SearchIndexSystem(ecs_iter_t *it) {
+    const SearchSettings *settings = ecs_singleton_get(it->world, SearchSettings);
+    if (!settings || !settings->enabled) {
+        return;
+    }
+    UpdateSearchIndex(it->world);
+}
+
+// Command mode: '/' opens a literal prompt, '?' a regex one. Every
+// keystroke runs the query again; backspace on an empty prompt closes it.
+// Lowercase queries ignore case.
+void SearchPromptSystem(ecs_iter_t *it) {
+    SearchIndex *search = it->ctx;
+    EditorState *editor_states = ecs_field(it, EditorState, 0);
+    const InputFrame *input = ecs_singleton_get(it->world, InputFrame);
+    const FinderPrompt *finder = ecs_singleton_get(it->world, FinderPrompt);
+    SearchPrompt *prompt = ecs_singleton_get_mut(it->world, SearchPrompt);
+    if (!input || !prompt) {
+        return;
+    }
+
+    for (int i = 0; i < it->count; i++) {
+        if (editor_states[i].current_mode != 2) {
+            prompt->active = false;
+            continue;
+        }
+        if (!prompt->active) {
+            if ((input->typed_char == '/' || input->typed_char == '?') && !(finder && finder->active)) {
+                prompt->active = true;
+                prompt->regex = input->typed_char == '?';
+                prompt->query[0] = '\0';
+                prompt->hits = 0;
+            }
+            continue;
+        }
+
+        size_t length = strlen(prompt->query);
+        if (input->backspace_pressed) {
+            if (length == 0) {
+                prompt->active = false;
+                continue;
+            }
+            prompt->query[--length] = '\0';
+        } else if (input->typed_char >= 32 && input->typed_char < 127 && length + 1 < sizeof(prompt->query)) {
+            prompt->query[length++] = (char)input->typed_char;
+            prompt->query[length] = '\0';
+        } else {
+            continue;
+        }
+        if (length == 0) {
+            continue;
+        }
+
+        int flags = prompt->regex ? SEARCH_REGEX : 0;
+        bool upper = false;
+        for (size_t c = 0; c < length && !upper; c++) {
+            upper = prompt->query[c] >= 'A' && prompt->query[c] <= 'Z';
+        }
+        flags |= upper ? 0 : SEARCH_IGNORE_CASE;
+        char query[SEARCH_MAX_QUERY];
+        memcpy(query, prompt->query, length + 1);
+        int hits = SelectSearchHits(it->world, query, flags);
+        if (hits > 0) {
+            editor_states[i].focused_entity = search->hits[0].entity;
+        }
+    }
+}
+
+// Eases the camera target towards the first hit
+void SearchFlySystem(ecs_iter_t *it) {
+    CameraController *cameras = ecs_field(it, CameraController, 0);
+    const SearchSettings *settings = ecs_singleton_get(it->world, SearchSettings);
+    SearchPrompt *prompt = ecs_singleton_get_mut(it->world, SearchPrompt);
+    if (!settings || !prompt || !prompt->flying) {
+        return;
+    }
+
+    float t = it->delta_time * settings->fly_speed;
+    t = t > 1.0f ? 1.0f : t;
+    for (int i = 0; i < it->count; i++) {
+        Vector3 *target = &cameras[i].target;
+        Vector3 goal = prompt->fly_target;
+        target->x += (goal.x - target->x) * t;
+        target->y += (goal.y - target->y) * t;
+        target->z += (goal.z - target->z) * t;
+        float dx = goal.x - target->x;
+        float dy = goal.y - target->y;
+        float dz = goal.z - target->z;
+        if (dx * dx + dy * dy + dz * dz < 1e-4f) {
+            *target = goal;
+            prompt->flying = false;
+        }
+    }
+}
+
+void OnSearchSourceSet(ecs_iter_t *it) {
+    const SearchSettings *settings = ecs_singleton_get(it->world, SearchSettings);
+    if (!settings || !settings->enabled) {
+        return;
+    }
+    SearchIndex *search = it->ctx;
+    for (int i = 0; i < it->count; i++) {
+        if (GrowArray(MEMORY_TAG_INDEX, (void**)&search->pending, &search->pending_capacity, search->pending_count + 1,
+                      sizeof(ecs_entity_t))) {
+            search->pending[search->pending_count++] = it->entities[i];
+        }
+    }
+}
+
+// The document id is reused; a running build's postings for it are
+// ignored because the version no longer matches
+void OnFileSearchRemoved(ecs_iter_t *it) {
+    SearchIndex *search = it->ctx;
+    FileSearch *file_search = ecs_field(it, FileSearch, 0);
+    for (int i = 0; i < it->count; i++) {
+        int32_t d = file_search[i].doc;
+        if (d < 0 || d >= search->doc_count || search->docs[d].state == SEARCH_DOC_FREE) {
+            continue;
+        }
+        ClearOverlay(&search->docs[d]);
+        search->docs[d].state = SEARCH_DOC_FREE;
+        search->docs[d].file = 0;
+        search->docs[d].version++;
+        if (GrowArray(MEMORY_TAG_INDEX, (void**)&search->free_docs, &search->free_capacity, search->free_count + 1,
+                      sizeof(int32_t))) {
+            search->free_docs[search->free_count++] = d;
+        }
+        file_search[i].doc = -1;
+        search->recount = true;
+    }
+}
+
+static void FileSearchCtor(void *ptr, int32_t count, const ecs_type_info_t *ti) {
+    (void)ti;
+    FileSearch *file_search = ptr;
+    for (int i = 0; i < count; i++) {
+        file_search[i].doc = -1;
+    }
+}
+
+// The builder borrows the job pool, so it is joined first
+static void SearchIndexFini(ecs_world_t *world, void *ctx) {
+    SearchIndex *search = ctx;
+    if (search->build) {
+        if (search->builder_started) {
+            pthread_join(search->builder, NULL);
+        }
+        for (int i = 0; i < search->build->count; i++) {
+            TrackedFree(MEMORY_TAG_INDEX, search->build->sources[i].text);
+            TrackedFree(MEMORY_TAG_INDEX, search->build->sources[i].trigrams);
+        }
+        FreeSegment(&search->build->segment);
+        TrackedFree(MEMORY_TAG_INDEX, search->build->sources);
+        TrackedFree(MEMORY_TAG_INDEX, search->build);
+    }
+    WorkerPoolRelease(world);  // After the last job
+    for (int d = 0; d < search->doc_count; d++) {
+        ClearOverlay(&search->docs[d]);
+    }
+    FreeSegment(&search->segment);
+    TrackedFree(MEMORY_TAG_INDEX, search->docs);
+    TrackedFree(MEMORY_TAG_INDEX, search->free_docs);
+    TrackedFree(MEMORY_TAG_INDEX, search->pending);
+    TrackedFree(MEMORY_TAG_INDEX, search->candidates);
+    TrackedFree(MEMORY_TAG_INDEX, search->matches);
+    TrackedFree(MEMORY_TAG_INDEX, search->line);
+    TrackedFree(MEMORY_TAG_INDEX, search->hits);
+    TrackedFree(MEMORY_TAG_INDEX, search);
+}
+
+void RegisterSearchIndex(ecs_world_t *world) {
+    ECS_COMPONENT_DEFINE(world, FileSearch);
+    ECS_COMPONENT_DEFINE(world, SearchSettings);
+    ECS_COMPONENT_DEFINE(world, SearchPrompt);
+    ECS_COMPONENT_DEFINE(world, SearchStats);
+    ECS_COMPONENT_DEFINE(world, SearchModule);
+
+    ecs_set_hooks(world, FileSearch, {
+        .ctor = FileSearchCtor
+    });
+
+    ecs_singleton_set(world, SearchSettings, {
+        .enabled = true,
+        .max_hits = 256,
+        .fly_speed = 6.0f
+    });
+    ecs_singleton_set(world, SearchPrompt, {0});
+    ecs_singleton_set(world, SearchStats, {0});
+
+    SearchIndex *search = TrackedCalloc(MEMORY_TAG_INDEX, 1, sizeof(SearchIndex));
+    if (!search) {
+        printf("SearchIndex: out of memory\n");
+        return;
+    }
+    search->pool = WorkerPoolAcquire(world);
+    ecs_singleton_set(world, SearchModule, {search});
+    ecs_atfini(world, SearchIndexFini, search);
+
+    ecs_system(world, {
+        .entity = ecs_entity(world, {
+            .name = "SearchIndexSystem",
+            .add = ecs_ids(ecs_dependson(EcsPostLoad))
+        }),
+        .callback = SearchIndexSystem
+    });
+
+    ecs_system(world, {
+        .entity = ecs_entity(world, {
+            .name = "SearchPromptSystem",
+            .add = ecs_ids(ecs_dependson(EcsOnUpdate))
+        }),
+        .query.terms = {
+            { ecs_id(EditorState) }
+        },
+        .callback = SearchPromptSystem,
+        .ctx = search
+    });
+
+    ecs_system(world, {
+        .entity = ecs_entity(world, {
+            .name = "SearchFlySystem",
+            .add = ecs_ids(ecs_dependson(EcsOnUpdate))
+        }),
+        .query.terms = {
+            { ecs_id(CameraController) }
+        },
+        .callback = SearchFlySystem
+    });
+
+    ecs_observer_desc_t set_desc = {0};
+    set_desc.query.terms[0].id = ecs_id(FileSyntax);
+    set_desc.events[0] = EcsOnSet;
+    set_desc.callback = OnSearchSourceSet;
+    set_desc.ctx = search;
+    ecs_observer_init(world, &set_desc);
+
+    ecs_observer_desc_t removed_desc = {0};
+    removed_desc.query.terms[0].id = ecs_id(FileSearch);
+    removed_desc.events[0] = EcsOnRemove;
+    removed_desc.callback = OnFileSearchRemoved;
+    removed_desc.ctx = search;
+    ecs_observer_init(world, &removed_desc);
+}
@@ -0,0 +1,119 @@
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include <flecs.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "../components/spatial.h"
+
+// Full-text search over the text of loaded files, answered as line
+// phantoms to highlight and fly the camera to.
+//
+// Every file with a FileSyntax text is a document of a trigram inverted
+// index: each run of three bytes (ASCII case folded, never across a line
+// break) maps to the documents containing it, as a list of ascending
+// document ids stored as varint deltas.
+//
+// The bulk of the index (the segment) is built on a background thread from
+// a copy of the texts, so loading continues while it runs; the trigrams of
+// each file are extracted in parallel on the search job pool. A file whose
+// FileSyntax is set again (edit, hot reload) gets a small sorted trigram
+// list of its own, the overlay, and its postings in the segment are
+// ignored until the next rebuild folds it back in. Files not indexed yet
+// are always candidates, so answers are complete while a build runs.
+//
+// A query picks candidate files by intersecting the postings of the
+// trigrams every match must contain (for a regex, those of its literal
+// runs; a top-level alternation is a union), then verifies them line by
+// line on the text.
+
+#define SEARCH_MAX_QUERY 128
+
+enum {
+    SEARCH_REGEX = 1 << 0,        // POSIX extended regex instead of a literal
+    SEARCH_IGNORE_CASE = 1 << 1
+};
+
+// Added to file containers that are documents of the index
+typedef struct {
+    int32_t doc;              // Document id, -1 if none
+} FileSearch;
+
+typedef struct {
+    bool enabled;             // Index files whose FileSyntax was set
+    int max_hits;             // Lines highlighted by the search prompt
+    float fly_speed;          // Camera target approach rate (1/s)
+} SearchSettings;
+
+// Command mode prompt: '/' starts a literal search, '?' a regex
+typedef struct {
+    bool active;
+    bool regex;
+    char query[SEARCH_MAX_QUERY];
+    int hits;                 // Lines matched by the last query
+    bool flying;
+    Vector3 fly_target;       // Camera target moves here
+} SearchPrompt;
+
+typedef struct {
+    int32_t documents;        // Files in the index
+    int32_t segment_documents;  // Served from the segment
+    int32_t overlay_documents;  // Reindexed since the segment was built
+    int32_t pending_documents;  // Not indexed yet (always candidates)
+    int32_t trigrams;         // Distinct trigrams in the segment
+    int64_t postings;         // Document entries in the segment
+    int64_t segment_bytes;    // Compressed postings
+    int32_t builds;
+    int32_t threads;          // Extraction threads including the builder
+    bool building;
+    double build_ms;          // Last segment build, on the background thread
+    double overlay_ms;        // Last synchronous overlay update
+
+    int32_t query_trigrams;   // Trigrams the last query required
+    int32_t candidates;       // Files verified by the last query
+    int32_t hits;             // Lines it matched
+    double query_us;
+} SearchStats;
+
+// One matching line
+typedef struct {
+    ecs_entity_t entity;      // Line phantom, the file container if the line has none
+    ecs_entity_t file;
+    int32_t line;
+} SearchHit;
+
+extern ECS_COMPONENT_DECLARE(FileSearch);
+extern ECS_COMPONENT_DECLARE(SearchSettings);
+extern ECS_COMPONENT_DECLARE(SearchPrompt);
+extern ECS_COMPONENT_DECLARE(SearchStats);
+
+// Index the files whose FileSyntax was set since the last update: a few
+// go into the overlay right away, a batch starts a background rebuild.
+// Installs a finished rebuild. Run by SearchIndexSystem.
+void UpdateSearchIndex(ecs_world_t *world);
+
+// Wait for a running background build and install it
+void WaitSearchIndex(ecs_world_t *world);
+
+// Lines matching pattern (SEARCH_* flags), in file and line order. Fills
+// up to max_hits and returns the number filled, -1 for an invalid regex.
+int SearchPhantoms(ecs_world_t *world, const char *pattern, int flags, SearchHit *hits, int max_hits);
+
+// Run a query from the prompt: select the matching phantoms and fly the
+// camera to the first. Returns the lines selected.
+int SelectSearchHits(ecs_world_t *world, const char *pattern, int flags);
+
+// Ease the camera target to target (SearchFlySystem); also used by the
+// fuzzy finder
+void FlyCameraTo(ecs_world_t *world, Vector3 target);
+
+// Systems and observers
+void SearchIndexSystem(ecs_iter_t *it);
+void SearchPromptSystem(ecs_iter_t *it);
+void SearchFlySystem(ecs_iter_t *it);
+void OnSearchSourceSet(ecs_iter_t *it);
+void OnFileSearchRemoved(ecs_iter_t *it);
+
+void RegisterSearchIndex(ecs_world_t *world);
+
+#endif // SEARCH_INDEX_H
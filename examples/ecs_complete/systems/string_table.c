@@ -0,0 +1,118 @@
+#include "string_table.h"
+#include "memory_tracker.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+uint32_t StringHash(const char *key, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)key[i]) * 16777619u;
+    }
+    return hash;
+}
+
+void StringTableFree(StringTable *t) {
+    TrackedFree(MEMORY_TAG_INDEX, t->slots);
+    TrackedFree(MEMORY_TAG_INDEX, t->hashes);
+    TrackedFree(MEMORY_TAG_INDEX, t->key_offset);
+    TrackedFree(MEMORY_TAG_INDEX, t->key_length);
+    TrackedFree(MEMORY_TAG_INDEX, t->arena);
+    memset(t, 0, sizeof(*t));
+}
+
+const char *StringTableKey(const StringTable *t, int index) {
+    return t->arena + t->key_offset[index];
+}
+
+int StringTableFindHashed(const StringTable *t, const char *key, size_t length, uint32_t hash) {
+    if (t->slot_capacity == 0) {
+        return -1;
+    }
+    uint32_t mask = (uint32_t)t->slot_capacity - 1;
+    for (uint32_t s = hash & mask;; s = (s + 1) & mask) {
+        uint32_t entry = t->slots[s];
+        if (entry == 0) {
+            return -1;
+        }
+        int index = (int)entry - 1;
+        if (t->hashes[index] == hash && t->key_length[index] == length &&
+            memcmp(StringTableKey(t, index), key, length) == 0) {
+            return index;
+        }
+    }
+}
+
+int StringTableFind(const StringTable *t, const char *key, size_t length) {
+    return StringTableFindHashed(t, key, length, StringHash(key, length));
+}
+
+static bool TableRehash(StringTable *t, int slot_capacity) {
+    uint32_t *slots = TrackedCalloc(MEMORY_TAG_INDEX, (size_t)slot_capacity, sizeof(uint32_t));
+    if (!slots) {
+        printf("StringTable: out of memory growing to %d elements\n", slot_capacity);
+        return false;
+    }
+    uint32_t mask = (uint32_t)slot_capacity - 1;
+    for (int i = 0; i < t->count; i++) {
+        uint32_t s = t->hashes[i] & mask;
+        while (slots[s]) {
+            s = (s + 1) & mask;
+        }
+        slots[s] = (uint32_t)i + 1;
+    }
+    TrackedFree(MEMORY_TAG_INDEX, t->slots);
+    t->slots = slots;
+    t->slot_capacity = slot_capacity;
+    return true;
+}
+
+int StringTableInsertHashed(StringTable *t, const char *key, size_t length, uint32_t hash, bool *inserted) {
+    *inserted = false;
+    int index = StringTableFindHashed(t, key, length, hash);
+    if (index >= 0) {
+        return index;
+    }
+    // Keep the load factor at or below one half
+    if ((t->count + 1) * 2 > t->slot_capacity &&
+        !TableRehash(t, t->slot_capacity > 0 ? t->slot_capacity * 2 : 1024)) {
+        return -1;
+    }
+    int capacity = t->capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&t->hashes, &capacity, t->count + 1, sizeof(uint32_t))) {
+        return -1;
+    }
+    capacity = t->capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&t->key_offset, &capacity, t->count + 1, sizeof(uint32_t))) {
+        return -1;
+    }
+    capacity = t->capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&t->key_length, &capacity, t->count + 1, sizeof(uint32_t))) {
+        return -1;
+    }
+    t->capacity = capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&t->arena, &t->arena_capacity, t->arena_length + (int)length + 1, 1)) {
+        return -1;
+    }
+
+    index = t->count++;
+    t->hashes[index] = hash;
+    t->key_offset[index] = (uint32_t)t->arena_length;
+    t->key_length[index] = (uint32_t)length;
+    memcpy(t->arena + t->arena_length, key, length);
+    t->arena[t->arena_length + length] = '\0';
+    t->arena_length += (int)length + 1;
+
+    uint32_t mask = (uint32_t)t->slot_capacity - 1;
+    uint32_t s = hash & mask;
+    while (t->slots[s]) {
+        s = (s + 1) & mask;
+    }
+    t->slots[s] = (uint32_t)index + 1;
+    *inserted = true;
+    return index;
+}
+
+int StringTableInsert(StringTable *t, const char *key, size_t length, bool *inserted) {
+    return StringTableInsertHashed(t, key, length, StringHash(key, length), inserted);
+}
@@ -0,0 +1,43 @@
+#ifndef STRING_TABLE_H
+#define STRING_TABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Open-addressing string table (FNV-1a, linear probing) mapping keys to
+// dense indices in insertion order. Keys are copied into one arena and
+// stay NUL-terminated; entries are never removed.
+//
+// The *Hashed variants take a precomputed StringHash so the hashing can be
+// done by parallel jobs and only the inserts stay serial.
+
+typedef struct {
+    uint32_t *slots;          // Entry index + 1, 0 = empty
+    int slot_capacity;        // Power of two
+    uint32_t *hashes;
+    uint32_t *key_offset;
+    uint32_t *key_length;
+    int count;
+    int capacity;
+    char *arena;
+    int arena_length;
+    int arena_capacity;
+} StringTable;
+
+uint32_t StringHash(const char *key, size_t length);
+
+void StringTableFree(StringTable *table);
+
+// Key of an entry (NUL-terminated, valid until the next insert)
+const char *StringTableKey(const StringTable *table, int index);
+
+// Index of key, -1 if absent
+int StringTableFind(const StringTable *table, const char *key, size_t length);
+int StringTableFindHashed(const StringTable *table, const char *key, size_t length, uint32_t hash);
+
+// Index of key, inserted if absent (*inserted tells which); -1 on failure
+int StringTableInsert(StringTable *table, const char *key, size_t length, bool *inserted);
+int StringTableInsertHashed(StringTable *table, const char *key, size_t length, uint32_t hash, bool *inserted);
+
+#endif // STRING_TABLE_H
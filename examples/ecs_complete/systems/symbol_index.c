@@ -0,0 +1,843 @@
+#include "symbol_index.h"
+#include "worker_pool.h"
+#include "memory_tracker.h"
+#include "syntax.h"
+#include "profiler.h"
+#include "string_table.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+ECS_COMPONENT_DECLARE(FunctionSymbol);
+ECS_COMPONENT_DECLARE(FileSymbols);
+ECS_COMPONENT_DECLARE(SymbolSettings);
+ECS_COMPONENT_DECLARE(SymbolStats);
+
+#define SYMBOL_SOURCE_CHUNK 4       // Sources per scan job (file sizes vary a lot)
+#define SYMBOL_FUNCTION_OFFSET -6.0f  // Function phantoms sit left of their line
+#define SYMBOL_LINE_SPACING 1.5f    // Matches the line phantoms of file_loader
+#define SYMBOL_MAX_CONDITIONALS 32  // Nesting of #if tracked by the scanner
+
+// A name found by the scanner: a span of the source text
+typedef struct {
+    uint32_t offset;
+    uint16_t length;
+    uint32_t hash;
+} SymbolName;
+
+typedef struct {
+    SymbolName name;
+    int32_t line;
+    int32_t first_call;       // Calls of the body start here
+} ExtractedFunction;
+
+// Scanner output of one source. The calls of function f are
+// [functions[f].first_call, functions[f + 1].first_call).
+typedef struct {
+    ExtractedFunction *functions;
+    int function_count;
+    int function_capacity;
+    SymbolName *calls;
+    int call_count;
+    int call_capacity;
+} SymbolExtract;
+
+// What the index keeps of one file between scans
+typedef struct {
+    ecs_entity_t file;
+    int32_t *function_symbol;
+    ecs_entity_t *function_entity;
+    int32_t *function_line;
+    int32_t *function_first_call;   // function_count + 1 entries
+    int function_count;
+    int32_t *call_symbol;
+    int call_count;
+    uint32_t scan;                  // Scan that last replaced this file
+    bool used;
+} SymbolFile;
+
+// Per-name arrays are indexed by the name's entry in the table
+typedef struct {
+    StringTable names;
+    int32_t *definition_count;
+    ecs_entity_t *primary;          // First definition in file slot order
+    uint8_t *dirty;                 // Definitions changed since the last resolve
+    int32_t *reuse;                 // Scratch: old function + 1 while a file is replaced
+    uint32_t *seen;                 // Scratch: stamp of the caller that last resolved it
+    int name_capacity;
+    int32_t *dirty_names;
+    int dirty_count;
+    int dirty_capacity;
+    uint32_t seen_stamp;
+
+    SymbolFile *files;
+    int file_count;
+    int file_capacity;
+    int32_t *free_slots;
+    int free_count;
+    int free_capacity;
+    int32_t function_total;
+    uint32_t scan;
+
+    ecs_entity_t *pending;          // Files whose FileSyntax was set
+    int pending_count;
+    int pending_capacity;
+    bool resolve_pending;           // Definitions went away with a removed file
+    JobPool *pool;
+} SymbolIndex;
+
+// The index belongs to the world that registered the module: the system
+// and observers get it as ctx, API calls find it through this singleton
+typedef struct {
+    SymbolIndex *symbols;
+} SymbolModule;
+
+static ECS_COMPONENT_DECLARE(SymbolModule);
+
+static SymbolIndex *GetSymbols(const ecs_world_t *world) {
+    const SymbolModule *module = ecs_singleton_get(world, SymbolModule);
+    return module ? module->symbols : NULL;
+}
+
+// Per-name arrays follow the table; new entries start zeroed
+static bool GrowNames(SymbolIndex *symbols, int needed) {
+    int old_capacity = symbols->name_capacity;
+    if (needed <= old_capacity) {
+        return true;
+    }
+    int capacity = old_capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&symbols->definition_count, &capacity, needed, sizeof(int32_t))) {
+        return false;
+    }
+    capacity = old_capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&symbols->primary, &capacity, needed, sizeof(ecs_entity_t))) {
+        return false;
+    }
+    capacity = old_capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&symbols->dirty, &capacity, needed, sizeof(uint8_t))) {
+        return false;
+    }
+    capacity = old_capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&symbols->reuse, &capacity, needed, sizeof(int32_t))) {
+        return false;
+    }
+    capacity = old_capacity;
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&symbols->seen, &capacity, needed, sizeof(uint32_t))) {
+        return false;
+    }
+    int added = capacity - old_capacity;
+    memset(symbols->definition_count + old_capacity, 0, sizeof(int32_t) * added);
+    memset(symbols->primary + old_capacity, 0, sizeof(ecs_entity_t) * added);
+    memset(symbols->dirty + old_capacity, 0, sizeof(uint8_t) * added);
+    memset(symbols->reuse + old_capacity, 0, sizeof(int32_t) * added);
+    memset(symbols->seen + old_capacity, 0, sizeof(uint32_t) * added);
+    symbols->name_capacity = capacity;
+    return true;
+}
+
+static int32_t InternName(SymbolIndex *symbols, const char *text, const SymbolName *name) {
+    bool inserted;
+    int symbol = StringTableInsertHashed(&symbols->names, text + name->offset, name->length, name->hash, &inserted);
+    if (symbol < 0 || !GrowNames(symbols, symbol + 1)) {
+        return -1;
+    }
+    return symbol;
+}
+
+static void MarkDirty(SymbolIndex *symbols, int32_t symbol) {
+    if (symbols->dirty[symbol]) {
+        return;
+    }
+    if (GrowArray(MEMORY_TAG_INDEX, (void**)&symbols->dirty_names, &symbols->dirty_capacity, symbols->dirty_count + 1,
+                  sizeof(int32_t))) {
+        symbols->dirty[symbol] = 1;
+        symbols->dirty_names[symbols->dirty_count++] = symbol;
+    }
+}
+
+// File store
+
+static int32_t AllocateSlot(SymbolIndex *symbols) {
+    if (symbols->free_count > 0) {
+        return symbols->free_slots[--symbols->free_count];
+    }
+    if (!GrowArray(MEMORY_TAG_INDEX, (void**)&symbols->files, &symbols->file_capacity, symbols->file_count + 1,
+                   sizeof(SymbolFile))) {
+        return -1;
+    }
+    memset(&symbols->files[symbols->file_count], 0, sizeof(SymbolFile));
+    return symbols->file_count++;
+}
+
+static void FreeSymbolFile(SymbolFile *file) {
+    TrackedFree(MEMORY_TAG_INDEX, file->function_symbol);
+    TrackedFree(MEMORY_TAG_INDEX, file->function_entity);
+    TrackedFree(MEMORY_TAG_INDEX, file->function_line);
+    TrackedFree(MEMORY_TAG_INDEX, file->function_first_call);
+    TrackedFree(MEMORY_TAG_INDEX, file->call_symbol);
+    memset(file, 0, sizeof(*file));
+}
+
+// Extraction
+
+// Brace state around one #if: only the first branch's braces count, so
+// branches that each open the same block do not unbalance the file
+typedef struct {
+    int depth;
+    int body_depth;
+    int first_depth;          // State at the end of the first branch
+    int first_body_depth;
+    bool has_else;
+} SymbolConditional;
+
+typedef struct {
+    int depth;                // Brace depth
+    int paren;                // Parenthesis depth outside function bodies
+    int body_depth;           // Brace depth outside the current body, -1 outside bodies
+    bool candidate;           // Identifier followed by '(' that may start a definition
+    bool candidate_closed;    // Its parameter list is complete
+    SymbolName candidate_name;
+    int candidate_line;
+    SymbolName last;          // Last identifier
+    bool last_identifier;     // The previous token was that identifier
+    bool last_member;         // It followed '.' or '->'
+    bool member_next;
+    SymbolConditional conditionals[SYMBOL_MAX_CONDITIONALS];
+    int conditional_count;    // May exceed the tracked levels
+} SymbolScanner;
+
+static void PushFunction(SymbolExtract *out, const SymbolName *name, int line) {
+    if (GrowArray(MEMORY_TAG_INDEX, (void**)&out->functions, &out->function_capacity, out->function_count + 1,
+                  sizeof(ExtractedFunction))) {
+        out->functions[out->function_count++] = (ExtractedFunction){*name, line, out->call_count};
+    }
+}
+
+static void PushCall(SymbolExtract *out, const SymbolName *name) {
+    if (GrowArray(MEMORY_TAG_INDEX, (void**)&out->calls, &out->call_capacity, out->call_count + 1,
+                  sizeof(SymbolName))) {
+        out->calls[out->call_count++] = *name;
+    }
+}
+
+// Specifiers that take parentheses but never name a function
+static bool IsAttributeName(const char *text, const SymbolName *name) {
+    static const char *const attributes[] = {
+        "__attribute__", "__attribute", "__declspec", "__asm__", "__asm", "asm", "alignas", "_Alignas"
+    };
+    for (size_t i = 0; i < sizeof(attributes) / sizeof(attributes[0]); i++) {
+        if (strlen(attributes[i]) == name->length && memcmp(attributes[i], text + name->offset, name->length) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void ScanPunct(SymbolScanner *s, SymbolExtract *out, const char *text, char c, char previous, int line) {
+    bool in_body = s->body_depth >= 0;
+    bool call = c == '(' && s->last_identifier;
+    s->last_identifier = false;
+
+    switch (c) {
+        case '(':
+            if (in_body) {
+                if (call && !s->last_member) {
+                    s->last.hash = StringHash(text + s->last.offset, s->last.length);
+                    PushCall(out, &s->last);
+                }
+                break;
+            }
+            // The last name before the parameter list is the candidate
+            if (call && s->paren == 0 && !IsAttributeName(text, &s->last)) {
+                s->candidate = true;
+                s->candidate_closed = false;
+                s->candidate_name = s->last;
+                s->candidate_line = line;
+            }
+            s->paren++;
+            break;
+        case ')':
+            if (!in_body && s->paren > 0 && --s->paren == 0 && s->candidate) {
+                s->candidate_closed = true;
+            }
+            break;
+        case '{':
+            if (!in_body && s->candidate && s->candidate_closed && s->paren == 0) {
+                s->candidate_name.hash = StringHash(text + s->candidate_name.offset, s->candidate_name.length);
+                PushFunction(out, &s->candidate_name, s->candidate_line);
+                s->body_depth = s->depth;
+            }
+            s->candidate = false;
+            s->depth++;
+            break;
+        case '}':
+            if (s->depth > 0) {
+                s->depth--;
+            }
+            if (in_body && s->depth <= s->body_depth) {
+                s->body_depth = -1;
+            }
+            s->candidate = false;
+            break;
+        case ';':
+        case '=':
+        case ',':
+            // A declaration or initializer, not a definition
+            if (!in_body && s->paren == 0) {
+                s->candidate = false;
+            }
+            break;
+        default:
+            break;
+    }
+    s->member_next = c == '.' || (c == '>' && previous == '-');
+}
+
+static void ScanConditional(SymbolScanner *s, const char *line, size_t length) {
+    size_t i = 0;
+    while (i < length && (line[i] == ' ' || line[i] == '\t' || line[i] == '#')) {
+        i++;
+    }
+    const char *word = line + i;
+    size_t word_length = 0;
+    while (i + word_length < length && word[word_length] >= 'a' && word[word_length] <= 'z') {
+        word_length++;
+    }
+
+    int level = s->conditional_count - 1;
+    SymbolConditional *top = level >= 0 && level < SYMBOL_MAX_CONDITIONALS ? &s->conditionals[level] : NULL;
+    if (word_length >= 2 && memcmp(word, "if", 2) == 0) {
+        if (s->conditional_count < SYMBOL_MAX_CONDITIONALS) {
+            s->conditionals[s->conditional_count] = (SymbolConditional){s->depth, s->body_depth, 0, 0, false};
+        }
+        s->conditional_count++;
+    } else if ((word_length == 4 && memcmp(word, "else", 4) == 0) ||
+               (word_length == 4 && memcmp(word, "elif", 4) == 0) ||
+               (word_length >= 5 && memcmp(word, "elif", 4) == 0)) {
+        if (top) {
+            if (!top->has_else) {
+                top->first_depth = s->depth;
+                top->first_body_depth = s->body_depth;
+                top->has_else = true;
+            }
+            s->depth = top->depth;
+            s->body_depth = top->body_depth;
+        }
+    } else if (word_length == 5 && memcmp(word, "endif", 5) == 0 && s->conditional_count > 0) {
+        if (top && top->has_else) {
+            s->depth = top->first_depth;
+            s->body_depth = top->first_body_depth;
+        }
+        s->conditional_count--;
+    }
+}
+
+// Walks the spans of every line outside preprocessor lines
+static void ExtractSymbols(const SymbolSource *source, SymbolExtract *out) {
+    const TokenBuffer *tokens = source->tokens;
+    const char *text = source->text;
+    const char *line_start = text;
+    const char *end = text + source->length;
+    SymbolScanner s = {.body_depth = -1};
+
+    for (int line = 0; line < tokens->line_count && line_start < end; line++) {
+        const char *newline = memchr(line_start, '\n', (size_t)(end - line_start));
+        size_t line_length = (size_t)((newline ? newline : end) - line_start);
+        uint32_t first = tokens->line_first[line];
+        uint32_t last = tokens->line_first[line + 1];
+        bool continued = (tokens->line_state[line] & LEX_STATE_DIRECTIVE) != 0;
+        bool directive = continued || (first < last && tokens->token_kind[first] == TOKEN_DIRECTIVE);
+        if (directive && !continued) {
+            ScanConditional(&s, line_start + tokens->token_column[first], line_length - tokens->token_column[first]);
+        }
+
+        for (uint32_t t = first; t < last && !directive; t++) {
+            size_t column = tokens->token_column[t];
+            size_t length = tokens->token_length[t];
+            if (column + length > line_length) {
+                break;
+            }
+            const char *span = line_start + column;
+            switch (tokens->token_kind[t]) {
+                case TOKEN_IDENTIFIER:
+                    s.last = (SymbolName){(uint32_t)(span - text), (uint16_t)length, 0};
+                    s.last_identifier = true;
+                    s.last_member = s.member_next;
+                    s.member_next = false;
+                    break;
+                case TOKEN_PUNCT:
+                    for (size_t i = 0; i < length; i++) {
+                        ScanPunct(&s, out, text, span[i], i > 0 ? span[i - 1] : 0, line);
+                    }
+                    break;
+                case TOKEN_COMMENT:
+                    break;
+                default:
+                    s.last_identifier = false;
+                    s.member_next = false;
+                    break;
+            }
+        }
+        line_start = newline ? newline + 1 : end;
+    }
+}
+
+typedef struct {
+    const SymbolSource *sources;
+    SymbolExtract *extracts;
+} SymbolScan;
+
+static void ScanJob(void *ctx, int chunk, int begin, int end) {
+    (void)chunk;
+    SymbolScan *scan = ctx;
+    for (int i = begin; i < end; i++) {
+        if (scan->sources[i].tokens && scan->sources[i].text) {
+            ExtractSymbols(&scan->sources[i], &scan->extracts[i]);
+        }
+    }
+}
+
+// Indexing
+
+static ecs_entity_t CreateFunctionEntity(ecs_world_t *world, SymbolIndex *symbols, ecs_entity_t file,
+                                         int32_t symbol, int line) {
+    const Position *origin = ecs_get(world, file, Position);
+    Position position = origin ? *origin : (Position){0.0f, 0.0f, 0.0f};
+
+    ecs_entity_t function = ecs_new_w_pair(world, EcsChildOf, file);
+    ecs_set(world, function, Position, {position.x + SYMBOL_FUNCTION_OFFSET,
+                                        position.y - line * SYMBOL_LINE_SPACING, position.z});
+    ecs_set(world, function, Rotation, {0.0f, 0.0f, 0.0f, 1.0f});
+    ecs_set(world, function, Scale, {1.0f, 1.0f, 1.0f});
+    ecs_set(world, function, EcsTransform, {.needs_update = true});
+    ecs_set(world, function, FunctionSymbol, {symbol, line});
+    ecs_set(world, function, BoundingSphere, {1.0f, {0.0f, 0.0f, 0.0f}});
+
+    TextContent label = {.font_size = 1.2f, .color = GREEN, .billboard_mode = false};
+    snprintf(label.text, sizeof(label.text), "%s()", StringTableKey(&symbols->names, symbol));
+    ecs_set_ptr(world, function, TextContent, &label);
+    return function;
+}
+
+// Replaces what the index knew about one file. Function phantoms are
+// reused by name; a name's definitions only count as changed when a
+// phantom is created or deleted for it.
+static void IndexSource(ecs_world_t *world, SymbolIndex *symbols, const SymbolSource *source,
+                        const SymbolExtract *extract, SymbolStats *stats) {
+    const FileSymbols *existing = ecs_get(world, source->file, FileSymbols);
+    int32_t slot = existing && existing->slot >= 0 ? existing->slot : AllocateSlot(symbols);
+    if (slot < 0) {
+        return;
+    }
+    if (!existing || existing->slot < 0) {
+        ecs_set(world, source->file, FileSymbols, {slot});
+    }
+
+    int function_count = extract->function_count;
+    int call_count = extract->call_count;
+    int32_t *function_symbol = TrackedMalloc(MEMORY_TAG_INDEX, sizeof(int32_t) * (function_count + 1));
+    ecs_entity_t *function_entity = TrackedMalloc(MEMORY_TAG_INDEX, sizeof(ecs_entity_t) * (function_count + 1));
+    int32_t *function_line = TrackedMalloc(MEMORY_TAG_INDEX, sizeof(int32_t) * (function_count + 1));
+    int32_t *function_first_call = TrackedMalloc(MEMORY_TAG_INDEX, sizeof(int32_t) * (function_count + 1));
+    int32_t *call_symbol = TrackedMalloc(MEMORY_TAG_INDEX, sizeof(int32_t) * (call_count + 1));
+    if (!function_symbol || !function_entity || !function_line || !function_first_call || !call_symbol) {
+        printf("SymbolIndex: out of memory indexing %d functions\n", function_count);
+        TrackedFree(MEMORY_TAG_INDEX, function_symbol);
+        TrackedFree(MEMORY_TAG_INDEX, function_entity);
+        TrackedFree(MEMORY_TAG_INDEX, function_line);
+        TrackedFree(MEMORY_TAG_INDEX, function_first_call);
+        TrackedFree(MEMORY_TAG_INDEX, call_symbol);
+        return;
+    }
+    for (int c = 0; c < call_count; c++) {
+        call_symbol[c] = InternName(symbols, source->text, &extract->calls[c]);
+    }
+
+    // Old phantoms by name; a name defined twice in a file reuses one
+    SymbolFile *file = &symbols->files[slot];
+    for (int f = 0; f < file->function_count; f++) {
+        int32_t symbol = file->function_symbol[f];
+        if (symbols->reuse[symbol] == 0) {
+            symbols->reuse[symbol] = f + 1;
+        }
+    }
+
+    for (int f = 0; f < function_count; f++) {
+        const ExtractedFunction *found = &extract->functions[f];
+        int32_t symbol = InternName(symbols, source->text, &found->name);
+        function_symbol[f] = symbol;
+        function_line[f] = found->line;
+        function_first_call[f] = found->first_call;
+        function_entity[f] = 0;
+        if (symbol < 0) {
+            continue;
+        }
+
+        int old = symbols->reuse[symbol] - 1;
+        if (old >= 0 && file->function_entity[old] && ecs_is_alive(world, file->function_entity[old])) {
+            function_entity[f] = file->function_entity[old];
+            file->function_entity[old] = 0;
+            symbols->reuse[symbol] = 0;
+            if (file->function_line[old] != found->line) {
+                ecs_set(world, function_entity[f], FunctionSymbol, {symbol, found->line});
+            }
+        } else {
+            function_entity[f] = CreateFunctionEntity(world, symbols, source->file, symbol, found->line);
+            symbols->definition_count[symbol]++;
+            MarkDirty(symbols, symbol);
+            stats->functions_created++;
+        }
+    }
+    function_first_call[function_count] = call_count;
+
+    // Phantoms whose definition is gone
+    for (int f = 0; f < file->function_count; f++) {
+        int32_t symbol = file->function_symbol[f];
+        symbols->reuse[symbol] = 0;
+        if (file->function_entity[f]) {
+            if (ecs_is_alive(world, file->function_entity[f])) {
+                ecs_delete(world, file->function_entity[f]);
+            }
+            symbols->definition_count[symbol]--;
+            MarkDirty(symbols, symbol);
+            stats->functions_removed++;
+        }
+    }
+
+    symbols->function_total += function_count - file->function_count;
+    FreeSymbolFile(file);
+    file->file = source->file;
+    file->function_symbol = function_symbol;
+    file->function_entity = function_entity;
+    file->function_line = function_line;
+    file->function_first_call = function_first_call;
+    file->function_count = function_count;
+    file->call_symbol = call_symbol;
+    file->call_count = call_count;
+    file->scan = symbols->scan;
+    file->used = true;
+}
+
+// Resolution
+
+static void UpdatePrimaryDefinitions(ecs_world_t *world, SymbolIndex *symbols) {
+    for (int d = 0; d < symbols->dirty_count; d++) {
+        symbols->primary[symbols->dirty_names[d]] = 0;
+    }
+    for (int slot = 0; slot < symbols->file_count; slot++) {
+        const SymbolFile *file = &symbols->files[slot];
+        for (int f = 0; f < file->function_count; f++) {
+            int32_t symbol = file->function_symbol[f];
+            if (symbol >= 0 && symbols->dirty[symbol] && !symbols->primary[symbol] &&
+                ecs_is_alive(world, file->function_entity[f])) {
+                symbols->primary[symbol] = file->function_entity[f];
+            }
+        }
+    }
+}
+
+// A definition in the calling file wins over the first one elsewhere
+static ecs_entity_t ResolveCall(const SymbolIndex *symbols, const SymbolFile *file, int32_t symbol) {
+    if (symbol < 0 || symbols->definition_count[symbol] <= 0) {
+        return 0;
+    }
+    if (symbols->definition_count[symbol] > 1) {
+        for (int f = 0; f < file->function_count; f++) {
+            if (file->function_symbol[f] == symbol) {
+                return file->function_entity[f];
+            }
+        }
+    }
+    return symbols->primary[symbol];
+}
+
+static bool CallsDirtyName(const SymbolIndex *symbols, const SymbolFile *file, int f) {
+    for (int c = file->function_first_call[f]; c < file->function_first_call[f + 1]; c++) {
+        if (file->call_symbol[c] >= 0 && symbols->dirty[file->call_symbol[c]]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Callers in rescanned files, and callers elsewhere that call a name whose
+// definitions changed, get their References pairs replaced
+static void ResolveCallers(ecs_world_t *world, SymbolIndex *symbols, SymbolStats *stats) {
+    bool any_dirty = symbols->dirty_count > 0;
+    for (int slot = 0; slot < symbols->file_count; slot++) {
+        const SymbolFile *file = &symbols->files[slot];
+        bool rescanned = file->used && file->scan == symbols->scan;
+        if (!rescanned && !any_dirty) {
+            continue;
+        }
+        for (int f = 0; f < file->function_count; f++) {
+            ecs_entity_t caller = file->function_entity[f];
+            if (!caller || (!rescanned && !CallsDirtyName(symbols, file, f)) || !ecs_is_alive(world, caller)) {
+                continue;
+            }
+            ecs_remove_pair(world, caller, References, EcsWildcard);
+            stats->callers_updated++;
+
+            // A callee called twice gets one pair
+            uint32_t stamp = ++symbols->seen_stamp;
+            for (int c = file->function_first_call[f]; c < file->function_first_call[f + 1]; c++) {
+                int32_t symbol = file->call_symbol[c];
+                ecs_entity_t target = ResolveCall(symbols, file, symbol);
+                if (!target) {
+                    continue;
+                }
+                stats->resolved++;
+                if (symbols->seen[symbol] == stamp || target == caller || !ecs_is_alive(world, target)) {
+                    continue;
+                }
+                symbols->seen[symbol] = stamp;
+                ecs_add_pair(world, caller, References, target);
+                stats->edges++;
+            }
+        }
+    }
+
+    for (int d = 0; d < symbols->dirty_count; d++) {
+        symbols->dirty[symbols->dirty_names[d]] = 0;
+    }
+    symbols->dirty_count = 0;
+    symbols->resolve_pending = false;
+}
+
+int ScanSymbols(ecs_world_t *world, const SymbolSource *sources, int count) {
+    const SymbolSettings *settings = ecs_singleton_get(world, SymbolSettings);
+    SymbolIndex *symbols = GetSymbols(world);
+    if (!settings || !symbols || (count <= 0 && !symbols->resolve_pending)) {
+        return 0;
+    }
+
+    PROFILE_ZONE_BEGIN(ScanSymbols);
+    SymbolStats stats = {.sources = count, .threads = JobPoolWorkerCount(symbols->pool) + 1};
+    SymbolScan scan = {.sources = sources};
+    scan.extracts = TrackedCalloc(MEMORY_TAG_INDEX, count > 0 ? (size_t)count : 1, sizeof(SymbolExtract));
+    if (!scan.extracts) {
+        PROFILE_ZONE_END(ScanSymbols);
+        return 0;
+    }
+
+    // 1. Definitions and calls of every source, in parallel
+    uint64_t start = ProfilerNow();
+    if (count > 0) {
+        JobPoolParallelFor(symbols->pool, count, SYMBOL_SOURCE_CHUNK, ScanJob, &scan);
+    }
+    stats.scan_ms = (double)(ProfilerNow() - start) / 1e6;
+
+    // 2. Names, function phantoms and definition counts, then every pair in
+    // one deferred batch
+    ecs_defer_begin(world);
+    start = ProfilerNow();
+    symbols->scan++;
+    for (int i = 0; i < count; i++) {
+        stats.definitions += scan.extracts[i].function_count;
+        stats.calls += scan.extracts[i].call_count;
+        IndexSource(world, symbols, &sources[i], &scan.extracts[i], &stats);
+    }
+    UpdatePrimaryDefinitions(world, symbols);
+    stats.index_ms = (double)(ProfilerNow() - start) / 1e6;
+
+    start = ProfilerNow();
+    ResolveCallers(world, symbols, &stats);
+    ecs_defer_end(world);
+    stats.apply_ms = (double)(ProfilerNow() - start) / 1e6;
+    stats.symbols = symbols->names.count;
+    stats.functions = symbols->function_total;
+
+    for (int i = 0; i < count; i++) {
+        TrackedFree(MEMORY_TAG_INDEX, scan.extracts[i].functions);
+        TrackedFree(MEMORY_TAG_INDEX, scan.extracts[i].calls);
+    }
+    TrackedFree(MEMORY_TAG_INDEX, scan.extracts);
+    ecs_singleton_set_ptr(world, SymbolStats, &stats);
+    PROFILE_ZONE_END(ScanSymbols);
+    return stats.edges;
+}
+
+static int CompareEntities(const void *a, const void *b) {
+    ecs_entity_t x = *(const ecs_entity_t*)a;
+    ecs_entity_t y = *(const ecs_entity_t*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+int UpdateSymbolIndex(ecs_world_t *world) {
+    SymbolIndex *symbols = GetSymbols(world);
+    if (!symbols || (symbols->pending_count == 0 && !symbols->resolve_pending)) {
+        return 0;
+    }
+
+    // A file set several times since the last update is scanned once
+    qsort(symbols->pending, (size_t)symbols->pending_count, sizeof(ecs_entity_t), CompareEntities);
+    SymbolSource *sources = TrackedMalloc(MEMORY_TAG_INDEX, sizeof(SymbolSource) * (symbols->pending_count + 1));
+    int count = 0;
+    for (int i = 0; i < symbols->pending_count && sources; i++) {
+        ecs_entity_t file = symbols->pending[i];
+        if ((i > 0 && file == symbols->pending[i - 1]) || !ecs_is_alive(world, file)) {
+            continue;
+        }
+        const FileSyntax *syntax = ecs_get(world, file, FileSyntax);
+        size_t length;
+        const char *text = GetFileSyntaxText(world, syntax, &length);
+        const TokenBuffer *tokens = GetFileSyntax(world, syntax);
+        if (text && tokens) {
+            sources[count++] = (SymbolSource){file, text, length, tokens};
+        }
+    }
+    symbols->pending_count = 0;
+
+    int edges = ScanSymbols(world, sources, count);
+    TrackedFree(MEMORY_TAG_INDEX, sources);
+    return edges;
+}
+
+ecs_entity_t FindFunction(ecs_world_t *world, const char *name) {
+    SymbolIndex *symbols = GetSymbols(world);
+    if (!symbols) {
+        return 0;
+    }
+    int symbol = StringTableFind(&symbols->names, name, strlen(name));
+    if (symbol < 0 || symbols->definition_count[symbol] <= 0 || !ecs_is_alive(world, symbols->primary[symbol])) {
+        return 0;
+    }
+    return symbols->primary[symbol];
+}
+
+const char *GetSymbolName(const ecs_world_t *world, int32_t symbol) {
+    const SymbolIndex *symbols = GetSymbols(world);
+    if (!symbols || symbol < 0 || symbol >= symbols->names.count) {
+        return NULL;
+    }
+    return StringTableKey(&symbols->names, symbol);
+}
+
+// Rescans happen at the start of the next frame, so edits of one frame to
+// the same file are scanned once
+void SymbolIndexSystem(ecs_iter_t *it) {
+    const SymbolSettings *settings = ecs_singleton_get(it->world, SymbolSettings);
+    if (!settings || !settings->enabled) {
+        return;
+    }
+    UpdateSymbolIndex(it->world);
+}
+
+void OnFileSyntaxSet(ecs_iter_t *it) {
+    const SymbolSettings *settings = ecs_singleton_get(it->world, SymbolSettings);
+    if (!settings || !settings->enabled) {
+        return;
+    }
+    SymbolIndex *symbols = it->ctx;
+    for (int i = 0; i < it->count; i++) {
+        if (GrowArray(MEMORY_TAG_INDEX, (void**)&symbols->pending, &symbols->pending_capacity,
+                      symbols->pending_count + 1, sizeof(ecs_entity_t))) {
+            symbols->pending[symbols->pending_count++] = it->entities[i];
+        }
+    }
+}
+
+// Function phantoms are deleted with their file; callers elsewhere may now
+// resolve to another definition of the same name
+void OnFileSymbolsRemoved(ecs_iter_t *it) {
+    SymbolIndex *symbols = it->ctx;
+    FileSymbols *file_symbols = ecs_field(it, FileSymbols, 0);
+    for (int i = 0; i < it->count; i++) {
+        int32_t slot = file_symbols[i].slot;
+        if (slot < 0 || slot >= symbols->file_count || !symbols->files[slot].used) {
+            continue;
+        }
+        SymbolFile *file = &symbols->files[slot];
+        for (int f = 0; f < file->function_count; f++) {
+            int32_t symbol = file->function_symbol[f];
+            if (symbol >= 0) {
+                symbols->definition_count[symbol]--;
+                MarkDirty(symbols, symbol);
+            }
+        }
+        symbols->function_total -= file->function_count;
+        symbols->resolve_pending = true;
+        FreeSymbolFile(file);
+        if (GrowArray(MEMORY_TAG_INDEX, (void**)&symbols->free_slots, &symbols->free_capacity, symbols->free_count + 1,
+                      sizeof(int32_t))) {
+            symbols->free_slots[symbols->free_count++] = slot;
+        }
+        file_symbols[i].slot = -1;
+    }
+}
+
+static void FileSymbolsCtor(void *ptr, int32_t count, const ecs_type_info_t *ti) {
+    (void)ti;
+    FileSymbols *file_symbols = ptr;
+    for (int i = 0; i < count; i++) {
+        file_symbols[i].slot = -1;
+    }
+}
+
+static void SymbolIndexFini(ecs_world_t *world, void *ctx) {
+    SymbolIndex *symbols = ctx;
+    WorkerPoolRelease(world);
+    for (int i = 0; i < symbols->file_count; i++) {
+        FreeSymbolFile(&symbols->files[i]);
+    }
+    TrackedFree(MEMORY_TAG_INDEX, symbols->files);
+    TrackedFree(MEMORY_TAG_INDEX, symbols->free_slots);
+    TrackedFree(MEMORY_TAG_INDEX, symbols->pending);
+    StringTableFree(&symbols->names);
+    TrackedFree(MEMORY_TAG_INDEX, symbols->definition_count);
+    TrackedFree(MEMORY_TAG_INDEX, symbols->primary);
+    TrackedFree(MEMORY_TAG_INDEX, symbols->dirty);
+    TrackedFree(MEMORY_TAG_INDEX, symbols->reuse);
+    TrackedFree(MEMORY_TAG_INDEX, symbols->seen);
+    TrackedFree(MEMORY_TAG_INDEX, symbols->dirty_names);
+    TrackedFree(MEMORY_TAG_INDEX, symbols);
+}
+
+void RegisterSymbolIndex(ecs_world_t *world) {
+    ECS_COMPONENT_DEFINE(world, FunctionSymbol);
+    ECS_COMPONENT_DEFINE(world, FileSymbols);
+    ECS_COMPONENT_DEFINE(world, SymbolSettings);
+    ECS_COMPONENT_DEFINE(world, SymbolStats);
+    ECS_COMPONENT_DEFINE(world, SymbolModule);
+
+    ecs_set_hooks(world, FileSymbols, {
+        .ctor = FileSymbolsCtor
+    });
+
+    ecs_singleton_set(world, SymbolSettings, {
+        .enabled = true,
+    });
+    ecs_singleton_set(world, SymbolStats, {0});
+
+    SymbolIndex *symbols = TrackedCalloc(MEMORY_TAG_INDEX, 1, sizeof(SymbolIndex));
+    if (!symbols) {
+        printf("SymbolIndex: out of memory\n");
+        return;
+    }
+    symbols->pool = WorkerPoolAcquire(world);
+    ecs_singleton_set(world, SymbolModule, {symbols});
+    ecs_atfini(world, SymbolIndexFini, symbols);
+
+    // Before the layout step so new pairs are solved in the same frame
+    ecs_system(world, {
+        .entity = ecs_entity(world, {
+            .name = "SymbolIndexSystem",
+            .add = ecs_ids(ecs_dependson(EcsPostLoad))
+        }),
+        .callback = SymbolIndexSystem
+    });
+
+    ecs_observer_desc_t set_desc = {0};
+    set_desc.query.terms[0].id = ecs_id(FileSyntax);
+    set_desc.events[0] = EcsOnSet;
+    set_desc.callback = OnFileSyntaxSet;
+    set_desc.ctx = symbols;
+    ecs_observer_init(world, &set_desc);
+
+    ecs_observer_desc_t removed_desc = {0};
+    removed_desc.query.terms[0].id = ecs_id(FileSymbols);
+    removed_desc.events[0] = EcsOnRemove;
+    removed_desc.callback = OnFileSymbolsRemoved;
+    removed_desc.ctx = symbols;
+    ecs_observer_init(world, &removed_desc);
+}
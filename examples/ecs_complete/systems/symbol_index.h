@@ -0,0 +1,95 @@
+#ifndef SYMBOL_INDEX_H
+#define SYMBOL_INDEX_H
+
+#include <flecs.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "lexer.h"
+#include "../components/spatial.h"
+
+// Symbol index and call graph: (References, callee) pairs between function
+// phantoms.
+//
+// Function definitions and the call sites inside their bodies are found on
+// the lexer's token spans (see lexer.h), in parallel over files on the
+// symbol job pool. A definition is an identifier followed by a balanced
+// parameter list and '{' outside any function body; a call is an
+// identifier followed by '(' inside one. Preprocessor lines, comments,
+// strings and member calls (a.f(), p->f()) are skipped.
+//
+// Names go into one global hash table. A call resolves to a definition in
+// the calling file first, then to the first definition anywhere else.
+// Each file keeps its own functions and calls, so a file whose FileSyntax
+// is set again (load or edit) is rescanned alone: its function phantoms
+// are reused by name, and only the callers whose targets may have changed
+// get their References pairs replaced, in one deferred batch.
+
+// Function phantom created for a definition, child of its file container
+typedef struct {
+    int32_t symbol;           // Name in the global symbol table
+    int32_t line;             // Line of the definition
+} FunctionSymbol;
+
+// Added to file containers that have been scanned
+typedef struct {
+    int32_t slot;             // Functions and calls in the symbol store, -1 if none
+} FileSymbols;
+
+typedef struct {
+    bool enabled;             // Rescan files whose FileSyntax was set
+} SymbolSettings;
+
+// Results of the last scan
+typedef struct {
+    int32_t sources;          // Files scanned
+    int32_t threads;          // Scanner threads including the caller
+    int32_t symbols;          // Distinct names in the table (defined or called)
+    int32_t functions;        // Definitions in the whole index
+    int32_t definitions;      // Definitions found in the scanned files
+    int32_t calls;            // Call sites found in the scanned files
+    int32_t functions_created;
+    int32_t functions_removed;
+    int32_t callers_updated;  // Functions whose References pairs were replaced
+    int32_t resolved;         // Call sites of updated callers with a definition
+    int32_t edges;            // (References, callee) pairs added
+    double scan_ms;           // Parallel extraction from the token spans
+    double index_ms;          // Name interning and definition bookkeeping
+    double apply_ms;          // Function phantoms and deferred pair batch
+} SymbolStats;
+
+// One file to scan
+typedef struct {
+    ecs_entity_t file;        // File container, parent of its function phantoms
+    const char *text;
+    size_t length;
+    const TokenBuffer *tokens;  // Spans of text (see syntax.h)
+} SymbolSource;
+
+extern ECS_COMPONENT_DECLARE(FunctionSymbol);
+extern ECS_COMPONENT_DECLARE(FileSymbols);
+extern ECS_COMPONENT_DECLARE(SymbolSettings);
+extern ECS_COMPONENT_DECLARE(SymbolStats);
+
+// Scan sources, replacing what the index knew about them, and update the
+// References pairs of every affected caller. Returns the pairs added.
+int ScanSymbols(ecs_world_t *world, const SymbolSource *sources, int count);
+
+// Rescan the files whose FileSyntax was set since the last update (run by
+// SymbolIndexSystem). Returns the pairs added.
+int UpdateSymbolIndex(ecs_world_t *world);
+
+// Function phantom of a definition named name (the first one), 0 if none
+ecs_entity_t FindFunction(ecs_world_t *world, const char *name);
+
+// Name of a FunctionSymbol's symbol, NULL if out of range (valid until
+// the next scan interns new names)
+const char *GetSymbolName(const ecs_world_t *world, int32_t symbol);
+
+// Systems and observers
+void SymbolIndexSystem(ecs_iter_t *it);
+void OnFileSyntaxSet(ecs_iter_t *it);
+void OnFileSymbolsRemoved(ecs_iter_t *it);
+
+void RegisterSymbolIndex(ecs_world_t *world);
+
+#endif // SYMBOL_INDEX_H
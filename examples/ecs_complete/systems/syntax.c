@@ -0,0 +1,615 @@
+#include "syntax.h"
+#include "worker_pool.h"
+#include "memory_tracker.h"
+#include "profiler.h"
+#include "text_buffer.h"
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+ECS_COMPONENT_DECLARE(FileSyntax);
+ECS_COMPONENT_DECLARE(SyntaxSettings);
+ECS_COMPONENT_DECLARE(SyntaxStats);
+
+// Token class colors, shared with the text_lod silhouettes
+#define SYNTAX_DEFAULT   (Color){170, 170, 170, 255}
+#define SYNTAX_COMMENT   (Color){ 90, 130,  90, 255}
+#define SYNTAX_DIRECTIVE (Color){200, 122, 255, 255}
+#define SYNTAX_KEYWORD   (Color){255, 161,   0, 255}
+#define SYNTAX_TYPE      (Color){102, 191, 255, 255}
+#define SYNTAX_NUMBER    (Color){220, 200, 120, 255}
+#define SYNTAX_STRING    (Color){206, 145, 120, 255}
+#define SYNTAX_PUNCT     (Color){110, 110, 110, 255}
+
+// Lexed text of one file. The piece table is the file's text; edits change
+// it in place and are re-lexed from the line checkpoints. Consumers that
+// scan the whole text get it flattened into text, rebuilt on first use
+// after an edit.
+typedef struct {
+    TokenBuffer tokens;
+    TextBuffer buffer;
+    char *text;
+    int text_capacity;
+    bool text_stale;
+    char *line;               // One line, read for the lexer
+    int line_capacity;
+    int last_edit_line;       // Where TextEditSystem typed last, -1 if none
+    bool last_edit_deleted;   // The last keystroke was a backspace
+} SyntaxFile;
+
+// Lexed files; slots of removed files are reused
+typedef struct {
+    SyntaxFile *files;
+    int file_count;
+    int file_capacity;
+    int32_t *free_slots;
+    int free_count;
+    int free_capacity;
+    char *edit;               // Line being edited by TextEditSystem
+    int edit_capacity;
+    JobPool *pool;
+} SyntaxStore;
+
+// The store belongs to the world that registered the module: systems and
+// observers get it as ctx, API calls find it through this singleton
+typedef struct {
+    SyntaxStore *store;
+} SyntaxModule;
+
+static ECS_COMPONENT_DECLARE(SyntaxModule);
+
+static SyntaxStore *GetStore(const ecs_world_t *world) {
+    const SyntaxModule *module = ecs_singleton_get(world, SyntaxModule);
+    return module ? module->store : NULL;
+}
+
+static int32_t AllocateSlot(SyntaxStore *s) {
+    if (s->free_count > 0) {
+        return s->free_slots[--s->free_count];
+    }
+    if (!GrowArray(MEMORY_TAG_SYNTAX, (void**)&s->files, &s->file_capacity, s->file_count + 1, sizeof(SyntaxFile))) {
+        return -1;
+    }
+    memset(&s->files[s->file_count], 0, sizeof(SyntaxFile));
+    return s->file_count++;
+}
+
+static void FreeSyntaxFile(SyntaxFile *file) {
+    TokenBufferFree(&file->tokens);
+    TextBufferFree(&file->buffer);
+    TrackedFree(MEMORY_TAG_SYNTAX, file->text);
+    TrackedFree(MEMORY_TAG_SYNTAX, file->line);
+    memset(file, 0, sizeof(*file));
+}
+
+static void ReleaseSlot(SyntaxStore *s, int32_t slot) {
+    if (slot < 0 || slot >= s->file_count) {
+        return;
+    }
+    FreeSyntaxFile(&s->files[slot]);
+    if (GrowArray(MEMORY_TAG_SYNTAX, (void**)&s->free_slots, &s->free_capacity, s->free_count + 1, sizeof(int32_t))) {
+        s->free_slots[s->free_count++] = slot;
+    }
+}
+
+static SyntaxFile *GetSlotFile(const ecs_world_t *world, const FileSyntax *syntax) {
+    SyntaxStore *store = GetStore(world);
+    if (!store || !syntax || syntax->slot < 0 || syntax->slot >= store->file_count) {
+        return NULL;
+    }
+    return &store->files[syntax->slot];
+}
+
+static SyntaxFile *GetSyntaxFile(ecs_world_t *world, ecs_entity_t file) {
+    return GetSlotFile(world, ecs_get(world, file, FileSyntax));
+}
+
+// The whole text in one span: the mapping itself while the file is a single
+// piece, otherwise a copy flattened after each edit
+static const char *GetSyntaxFileText(SyntaxFile *file, size_t *length) {
+    const char *contiguous = TextBufferContiguous(&file->buffer, length);
+    if (contiguous) {
+        return contiguous;
+    }
+    size_t total = TextBufferLength(&file->buffer);
+    if (file->text_stale) {
+        if (total + 1 > (size_t)INT32_MAX ||
+            !GrowArray(MEMORY_TAG_SYNTAX, (void**)&file->text, &file->text_capacity, (int)total + 1, 1)) {
+            *length = 0;
+            return NULL;
+        }
+        TextBufferRead(&file->buffer, 0, file->text, total);
+        file->text[total] = '\0';
+        file->text_stale = false;
+    }
+    *length = total;
+    return file->text;
+}
+
+bool AttachFileSyntax(ecs_world_t *world, ecs_entity_t file, const char *text, size_t length) {
+    TextBuffer buffer;
+    if (!TextBufferInit(&buffer, text, length)) {
+        printf("Syntax: out of memory copying %zu bytes\n", length);
+        return false;
+    }
+    return AttachFileSyntaxBuffer(world, file, &buffer);
+}
+
+bool AttachFileSyntaxBuffer(ecs_world_t *world, ecs_entity_t file, TextBuffer *buffer) {
+    const SyntaxSettings *settings = ecs_singleton_get(world, SyntaxSettings);
+    SyntaxStore *store = GetStore(world);
+    if (!settings || !settings->enabled || !store) {
+        TextBufferFree(buffer);
+        return false;
+    }
+
+    PROFILE_ZONE_BEGIN(LexFile);
+    const FileSyntax *existing = ecs_get(world, file, FileSyntax);
+    int32_t slot = existing && existing->slot >= 0 ? existing->slot : AllocateSlot(store);
+    if (slot < 0) {
+        TextBufferFree(buffer);
+        PROFILE_ZONE_END(LexFile);
+        return false;
+    }
+
+    SyntaxFile *syntax = &store->files[slot];
+    TextBufferFree(&syntax->buffer);
+    syntax->buffer = *buffer;
+    memset(buffer, 0, sizeof(*buffer));
+    syntax->text_stale = true;
+    syntax->last_edit_line = -1;
+    if (settings->undo_memory_kb > 0) {
+        TextBufferEnableHistory(&syntax->buffer, (size_t)settings->undo_memory_kb * 1024);
+    }
+
+    size_t length;
+    const char *text = GetSyntaxFileText(syntax, &length);
+    if (!text) {
+        PROFILE_ZONE_END(LexFile);
+        return false;
+    }
+
+    TokenBuffer *tokens = &syntax->tokens;
+    TokenBufferClear(tokens);
+    uint64_t start = ProfilerNow();
+    int relexed = LexBufferParallel(store->pool, text, length, tokens);
+    double lex_ms = (double)(ProfilerNow() - start) / 1e6;
+    ecs_set(world, file, FileSyntax, {slot});
+
+    SyntaxStats *stats = ecs_singleton_get_mut(world, SyntaxStats);
+    stats->files++;
+    stats->bytes += (int64_t)length;
+    stats->lines += tokens->line_count;
+    stats->tokens += tokens->token_count;
+    stats->chunks_relexed += relexed;
+    stats->lex_ms += lex_ms;
+    stats->last_mb_per_s = lex_ms > 0.0 ? (double)length / 1e6 / (lex_ms / 1e3) : 0.0;
+    PROFILE_ZONE_END(LexFile);
+    return true;
+}
+
+// Lines follow the lexer's convention: a final newline does not start
+// another line, so line l is [LineStart(l), LineStart(l + 1)) with its
+// terminator
+static size_t ReadSyntaxLine(SyntaxFile *file, int line, char **out) {
+    size_t begin = TextBufferLineStart(&file->buffer, line);
+    size_t end = TextBufferLineStart(&file->buffer, line + 1);
+    if (end - begin + 1 > (size_t)INT32_MAX ||
+        !GrowArray(MEMORY_TAG_SYNTAX, (void**)&file->line, &file->line_capacity, (int)(end - begin) + 1, 1)) {
+        *out = NULL;
+        return 0;
+    }
+    size_t length = TextBufferRead(&file->buffer, begin, file->line, end - begin);
+    file->line[length] = '\0';
+    *out = file->line;
+    return length;
+}
+
+static const char *SyntaxFileLine(void *ctx, int line, size_t *length) {
+    char *text;
+    *length = ReadSyntaxLine(ctx, line, &text);
+    return text ? text : "";
+}
+
+int EditFileSyntaxLine(ecs_world_t *world, ecs_entity_t file, int line, const char *text) {
+    SyntaxFile *syntax = GetSyntaxFile(world, file);
+    if (!syntax || line < 0 || line >= syntax->tokens.line_count) {
+        return -1;
+    }
+
+    PROFILE_ZONE_BEGIN(RelexEdit);
+    uint64_t start = ProfilerNow();
+
+    // Replace the line content, keeping its terminator. Only the bytes
+    // between the common prefix and suffix go through the piece table, so
+    // typing a character is one insert.
+    char *old;
+    size_t old_length = ReadSyntaxLine(syntax, line, &old);
+    if (!old) {
+        PROFILE_ZONE_END(RelexEdit);
+        return -1;
+    }
+    if (old_length > 0 && old[old_length - 1] == '\n') {
+        old_length--;
+        if (old_length > 0 && old[old_length - 1] == '\r') {
+            old_length--;
+        }
+    }
+    size_t new_length = strlen(text);
+    size_t prefix = 0;
+    while (prefix < old_length && prefix < new_length && old[prefix] == text[prefix]) {
+        prefix++;
+    }
+    size_t suffix = 0;
+    while (suffix < old_length - prefix && suffix < new_length - prefix &&
+           old[old_length - 1 - suffix] == text[new_length - 1 - suffix]) {
+        suffix++;
+    }
+    size_t begin = TextBufferLineStart(&syntax->buffer, line) + prefix;
+    if (!TextBufferDelete(&syntax->buffer, begin, old_length - prefix - suffix) ||
+        !TextBufferInsert(&syntax->buffer, begin, text + prefix, new_length - prefix - suffix)) {
+        PROFILE_ZONE_END(RelexEdit);
+        return -1;
+    }
+    syntax->text_stale = true;
+
+    int relexed = LexEditLines(&syntax->tokens, line, 1, 1, SyntaxFileLine, syntax);
+    double edit_us = (double)(ProfilerNow() - start) / 1e3;
+    ecs_modified(world, file, FileSyntax);  // Observers of the spans (e.g. symbols) see the edit
+
+    SyntaxStats *stats = ecs_singleton_get_mut(world, SyntaxStats);
+    stats->edits++;
+    stats->edit_lines_relexed += relexed;
+    stats->last_edit_lines = relexed;
+    stats->last_edit_us = edit_us;
+    PROFILE_ZONE_END(RelexEdit);
+    return relexed;
+}
+
+// Set a line phantom's TextContent, cut to what it can display but never
+// inside a UTF-8 character
+static void ShowPhantomLine(ecs_world_t *world, ecs_entity_t phantom, const TextContent *current,
+                            const char *line, size_t length) {
+    TextContent text = *current;
+    size_t shown = length < sizeof(text.text) ? length : sizeof(text.text) - 1;
+    while (shown > 0 && shown < length && ((unsigned char)line[shown] & 0xC0) == 0x80) {
+        shown--;
+    }
+    memcpy(text.text, line, shown);
+    text.text[shown] = '\0';
+    ecs_set_ptr(world, phantom, TextContent, &text);
+}
+
+// Line phantoms of [first, end) show the file's text again
+static void RefreshPhantomLines(ecs_world_t *world, ecs_entity_t file, SyntaxFile *syntax, int first, int end) {
+    ecs_iter_t it = ecs_children(world, file);
+    while (ecs_children_next(&it)) {
+        for (int i = 0; i < it.count; i++) {
+            const FileReference *ref = ecs_get(world, it.entities[i], FileReference);
+            const TextContent *current = ecs_get(world, it.entities[i], TextContent);
+            if (!ref || !current || ref->line_number < first || ref->line_number >= end) {
+                continue;
+            }
+            char *line;
+            size_t length = ReadSyntaxLine(syntax, ref->line_number, &line);
+            if (!line) {
+                continue;
+            }
+            while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+                length--;
+            }
+            ShowPhantomLine(world, it.entities[i], current, line, length);
+        }
+    }
+}
+
+// Lexer lines in the buffer: a final partial line counts
+static int SyntaxLineCount(const TextBuffer *buffer) {
+    size_t length = TextBufferLength(buffer);
+    char last = '\n';
+    if (length > 0) {
+        TextBufferRead(buffer, length - 1, &last, 1);
+    }
+    return (int)TextBufferNewlines(buffer) + (last != '\n');
+}
+
+int UndoFileSyntax(ecs_world_t *world, ecs_entity_t file, bool redo) {
+    SyntaxFile *syntax = GetSyntaxFile(world, file);
+    if (!syntax) {
+        return -1;
+    }
+
+    PROFILE_ZONE_BEGIN(RelexUndo);
+    uint64_t start = ProfilerNow();
+    int old_count = syntax->tokens.line_count;
+    TextChange change;
+    bool applied = redo ? TextBufferRedo(&syntax->buffer, &change) : TextBufferUndo(&syntax->buffer, &change);
+    if (!applied) {
+        PROFILE_ZONE_END(RelexUndo);
+        return -1;
+    }
+    syntax->text_stale = true;
+    syntax->last_edit_line = -1;
+
+    // Lines holding the changed span now; the step removed as many lines
+    // as it inserted, less the change in line count
+    int new_count = SyntaxLineCount(&syntax->buffer);
+    int first = TextBufferLineOf(&syntax->buffer, change.offset);
+    int inserted = TextBufferLineOf(&syntax->buffer, change.offset + change.inserted) - first + 1;
+    if (inserted > new_count - first) {
+        inserted = new_count - first;
+    }
+    int removed = inserted - (new_count - old_count);
+    int relexed = LexEditLines(&syntax->tokens, first, removed, inserted, SyntaxFileLine, syntax);
+    double edit_us = (double)(ProfilerNow() - start) / 1e3;
+    ecs_modified(world, file, FileSyntax);
+    RefreshPhantomLines(world, file, syntax, first, first + inserted);
+
+    SyntaxStats *stats = ecs_singleton_get_mut(world, SyntaxStats);
+    stats->undos++;
+    stats->edit_lines_relexed += relexed;
+    stats->last_edit_lines = relexed;
+    stats->last_edit_us = edit_us;
+    PROFILE_ZONE_END(RelexUndo);
+    return relexed;
+}
+
+const TokenBuffer *GetFileSyntax(const ecs_world_t *world, const FileSyntax *syntax) {
+    SyntaxFile *file = GetSlotFile(world, syntax);
+    return file ? &file->tokens : NULL;
+}
+
+const char *GetFileSyntaxText(const ecs_world_t *world, const FileSyntax *syntax, size_t *length) {
+    SyntaxFile *file = GetSlotFile(world, syntax);
+    if (!file) {
+        *length = 0;
+        return NULL;
+    }
+    return GetSyntaxFileText(file, length);
+}
+
+const TextBuffer *GetFileSyntaxBuffer(const ecs_world_t *world, const FileSyntax *syntax) {
+    SyntaxFile *file = GetSlotFile(world, syntax);
+    return file ? &file->buffer : NULL;
+}
+
+size_t GetFileSyntaxLine(const ecs_world_t *world, const FileSyntax *syntax, int line, char *out, size_t capacity) {
+    SyntaxFile *file = GetSlotFile(world, syntax);
+    if (!file || capacity == 0) {
+        return 0;
+    }
+    if (line < 0 || line >= file->tokens.line_count) {
+        out[0] = '\0';
+        return 0;
+    }
+    size_t begin = TextBufferLineStart(&file->buffer, line);
+    size_t end = TextBufferLineStart(&file->buffer, line + 1);
+    size_t length = TextBufferRead(&file->buffer, begin, out, end - begin < capacity ? end - begin : capacity - 1);
+    while (length > 0 && (out[length - 1] == '\n' || out[length - 1] == '\r')) {
+        length--;
+    }
+    out[length] = '\0';
+    return length;
+}
+
+Color TokenKindColor(TokenKind kind) {
+    switch (kind) {
+        case TOKEN_KEYWORD:   return SYNTAX_KEYWORD;
+        case TOKEN_TYPE:      return SYNTAX_TYPE;
+        case TOKEN_NUMBER:    return SYNTAX_NUMBER;
+        case TOKEN_STRING:    return SYNTAX_STRING;
+        case TOKEN_COMMENT:   return SYNTAX_COMMENT;
+        case TOKEN_DIRECTIVE: return SYNTAX_DIRECTIVE;
+        case TOKEN_PUNCT:     return SYNTAX_PUNCT;
+        default:              return SYNTAX_DEFAULT;
+    }
+}
+
+// Spans are drawn one by one; the gaps between them are only measured.
+// Raylib adds spacing between glyphs, so joining two measured pieces adds
+// one spacing as well.
+void DrawSyntaxLine(const TokenBuffer *tokens, int line, const char *text, Font font,
+                    Vector2 position, float font_size, float spacing) {
+    char piece[sizeof(((TextContent*)0)->text)];
+    size_t text_length = strlen(text);
+    float x = position.x;
+    size_t cursor = 0;
+
+    if (line < 0 || line >= tokens->line_count) {
+        DrawTextEx(font, text, position, font_size, spacing, SYNTAX_DEFAULT);
+        return;
+    }
+
+    for (uint32_t t = tokens->line_first[line]; t < tokens->line_first[line + 1]; t++) {
+        size_t column = tokens->token_column[t];
+        if (column >= text_length) {
+            break;
+        }
+        size_t length = tokens->token_length[t];
+        if (column + length > text_length) {
+            length = text_length - column;
+        }
+
+        if (column > cursor) {
+            memcpy(piece, text + cursor, column - cursor);
+            piece[column - cursor] = '\0';
+            x += MeasureTextEx(font, piece, font_size, spacing).x + spacing;
+        }
+        memcpy(piece, text + column, length);
+        piece[length] = '\0';
+        DrawTextEx(font, piece, (Vector2){x, position.y}, font_size, spacing,
+                   TokenKindColor((TokenKind)tokens->token_kind[t]));
+        x += MeasureTextEx(font, piece, font_size, spacing).x + spacing;
+        cursor = column + length;
+    }
+}
+
+// Edit mode: typed characters and backspace change the end of the focused
+// line in the file's text, the spans follow the edit, and the phantom's
+// TextContent shows the start of the new line. An undo step is a run of
+// typing or of backspaces on one line, ended by a space; Ctrl+Z / Ctrl+Y
+// undo and redo whole steps in the focused phantom's file.
+void TextEditSystem(ecs_iter_t *it) {
+    SyntaxStore *store = it->ctx;
+    const InputFrame *input = ecs_singleton_get(it->world, InputFrame);
+    if (!input || (input->typed_char == 0 && !input->backspace_pressed &&
+                   !input->undo_pressed && !input->redo_pressed)) {
+        return;
+    }
+    EditorState *editor_states = ecs_field(it, EditorState, 0);
+
+    for (int i = 0; i < it->count; i++) {
+        ecs_entity_t focused = editor_states[i].focused_entity;
+        if (editor_states[i].current_mode != 1 || !focused || !ecs_is_alive(it->world, focused)) {
+            continue;
+        }
+        const TextContent *current = ecs_get(it->world, focused, TextContent);
+        const FileReference *ref = ecs_get(it->world, focused, FileReference);
+        ecs_entity_t file = ecs_get_target(it->world, focused, EcsChildOf, 0);
+        SyntaxFile *syntax = file ? GetSyntaxFile(it->world, file) : NULL;
+        if (syntax && (input->undo_pressed || input->redo_pressed)) {
+            UndoFileSyntax(it->world, file, input->redo_pressed);
+            continue;
+        }
+        if (!current || !ref || !syntax || ref->line_number < 0 || ref->line_number >= syntax->tokens.line_count) {
+            continue;
+        }
+
+        char *line;
+        size_t length = ReadSyntaxLine(syntax, ref->line_number, &line);
+        if (!line || !GrowArray(MEMORY_TAG_SYNTAX, (void**)&store->edit, &store->edit_capacity, (int)length + 2, 1)) {
+            continue;
+        }
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+            length--;
+        }
+        memcpy(store->edit, line, length);
+        size_t old_length = length;
+        if (input->backspace_pressed && length > 0) {
+            // A whole UTF-8 character: step back over its continuation bytes
+            length--;
+            while (length > 0 && ((unsigned char)store->edit[length] & 0xC0) == 0x80) {
+                length--;
+            }
+        }
+        if (input->typed_char >= 32 && input->typed_char < 127) {
+            store->edit[length++] = (char)input->typed_char;
+        }
+        store->edit[length] = '\0';
+        if (length == old_length && (length == 0 || store->edit[length - 1] == line[length - 1])) {
+            continue;
+        }
+
+        bool deleted = length < old_length;
+        if (ref->line_number != syntax->last_edit_line || deleted != syntax->last_edit_deleted ||
+            input->typed_char == ' ') {
+            TextBufferCheckpoint(&syntax->buffer);
+        }
+        syntax->last_edit_line = ref->line_number;
+        syntax->last_edit_deleted = deleted;
+        EditFileSyntaxLine(it->world, file, ref->line_number, store->edit);
+        ShowPhantomLine(it->world, focused, current, store->edit, length);
+    }
+}
+
+void OnFileSyntaxRemoved(ecs_iter_t *it) {
+    SyntaxStore *store = it->ctx;
+    FileSyntax *syntax = ecs_field(it, FileSyntax, 0);
+    for (int i = 0; i < it->count; i++) {
+        ReleaseSlot(store, syntax[i].slot);
+        syntax[i].slot = -1;
+    }
+}
+
+// A hot-reloaded file container is read and lexed again, so everything
+// that follows FileSyntax (symbols, search) sees the new text. The tag is
+// removed from the container so the next modification reloads it too.
+void OnFileSyntaxReload(ecs_iter_t *it) {
+    for (int i = 0; i < it->count; i++) {
+        ecs_entity_t file = it->entities[i];
+        const FileReference *ref = ecs_get(it->world, file, FileReference);
+        if (!ref || !ecs_has(it->world, file, FileSyntax)) {
+            continue;
+        }
+
+        TextBuffer buffer;
+        if (!TextBufferInitMapped(&buffer, ref->filepath)) {
+            printf("Failed to reload file: %s\n", ref->filepath);
+            continue;
+        }
+        AttachFileSyntaxBuffer(it->world, file, &buffer);
+        ecs_remove(it->world, file, NeedsReload);
+    }
+}
+
+static void FileSyntaxCtor(void *ptr, int32_t count, const ecs_type_info_t *ti) {
+    (void)ti;
+    FileSyntax *syntax = ptr;
+    for (int i = 0; i < count; i++) {
+        syntax[i].slot = -1;
+    }
+}
+
+static void SyntaxFini(ecs_world_t *world, void *ctx) {
+    SyntaxStore *store = ctx;
+    WorkerPoolRelease(world);
+    for (int i = 0; i < store->file_count; i++) {
+        FreeSyntaxFile(&store->files[i]);
+    }
+    TrackedFree(MEMORY_TAG_SYNTAX, store->files);
+    TrackedFree(MEMORY_TAG_SYNTAX, store->free_slots);
+    TrackedFree(MEMORY_TAG_SYNTAX, store->edit);
+    TrackedFree(MEMORY_TAG_SYNTAX, store);
+}
+
+void RegisterSyntaxSystems(ecs_world_t *world) {
+    ECS_COMPONENT_DEFINE(world, FileSyntax);
+    ECS_COMPONENT_DEFINE(world, SyntaxSettings);
+    ECS_COMPONENT_DEFINE(world, SyntaxStats);
+    ECS_COMPONENT_DEFINE(world, SyntaxModule);
+
+    ecs_set_hooks(world, FileSyntax, {
+        .ctor = FileSyntaxCtor
+    });
+
+    ecs_singleton_set(world, SyntaxSettings, {
+        .enabled = true,
+        .undo_memory_kb = 4096
+    });
+    ecs_singleton_set(world, SyntaxStats, {0});
+
+    SyntaxStore *store = TrackedCalloc(MEMORY_TAG_SYNTAX, 1, sizeof(SyntaxStore));
+    if (!store) {
+        printf("Syntax: out of memory\n");
+        return;
+    }
+    store->pool = WorkerPoolAcquire(world);
+    ecs_singleton_set(world, SyntaxModule, {store});
+    ecs_atfini(world, SyntaxFini, store);
+
+    ecs_system(world, {
+        .entity = ecs_entity(world, {
+            .name = "TextEditSystem",
+            .add = ecs_ids(ecs_dependson(EcsOnUpdate))
+        }),
+        .query.terms = {
+            { ecs_id(EditorState), .inout = EcsIn }
+        },
+        .callback = TextEditSystem,
+        .ctx = store
+    });
+
+    ecs_observer_desc_t reload_desc = {0};
+    reload_desc.query.terms[0].id = NeedsReload;
+    reload_desc.events[0] = EcsOnAdd;
+    reload_desc.callback = OnFileSyntaxReload;
+    ecs_observer_init(world, &reload_desc);
+
+    ecs_observer_desc_t removed_desc = {0};
+    removed_desc.query.terms[0].id = ecs_id(FileSyntax);
+    removed_desc.events[0] = EcsOnRemove;
+    removed_desc.callback = OnFileSyntaxRemoved;
+    removed_desc.ctx = store;
+    ecs_observer_init(world, &removed_desc);
+}
@@ -0,0 +1,102 @@
+#ifndef SYNTAX_H
+#define SYNTAX_H
+
+#include <flecs.h>
+#include <stdbool.h>
+#include "lexer.h"
+#include "text_buffer.h"
+#include "../components/spatial.h"
+
+// Syntax coloring of file containers.
+//
+// A file's whole text is lexed once when it is loaded, in parallel across
+// the syntax job pool (see lexer.h). The text (a piece table over the
+// mapped file, see text_buffer.h) and token spans live in a store owned by
+// this module; the file container only carries a FileSyntax
+// slot, and line phantoms find their spans through ChildOf and their line
+// number. Typing in Edit mode changes the focused line, and only that line
+// plus the lines whose start state changed are lexed again. Ctrl+Z / Ctrl+Y
+// undo and redo edits from the buffer's history and lex again only the
+// lines the step touched. A hot-reloaded file (NeedsReload) is read from
+// disk and lexed again as a whole.
+
+// Added to file containers whose text has been lexed
+typedef struct {
+    int32_t slot;             // Token buffer in the syntax store, -1 if none
+} FileSyntax;
+
+typedef struct {
+    bool enabled;             // Lex files on load and draw colored spans
+    int undo_memory_kb;       // Undo history cap per file, 0 = no undo
+} SyntaxSettings;
+
+// Totals over all files lexed so far
+typedef struct {
+    int32_t files;
+    int64_t bytes;
+    int64_t lines;
+    int64_t tokens;
+    int32_t chunks_relexed;   // Parallel chunks whose start state was guessed wrong
+    double lex_ms;
+    double last_mb_per_s;     // Throughput of the last file
+
+    int32_t edits;
+    int64_t edit_lines_relexed;
+    int32_t last_edit_lines;  // Lines lexed again for the last edit
+    double last_edit_us;
+    int32_t undos;            // Undo and redo steps applied
+} SyntaxStats;
+
+extern ECS_COMPONENT_DECLARE(FileSyntax);
+extern ECS_COMPONENT_DECLARE(SyntaxSettings);
+extern ECS_COMPONENT_DECLARE(SyntaxStats);
+
+// Lex the text of a file and attach the spans to its container. Returns
+// false if syntax coloring is disabled.
+bool AttachFileSyntax(ecs_world_t *world, ecs_entity_t file, const char *text, size_t length);
+
+// Same, taking ownership of a loaded buffer (freed if it is not attached)
+bool AttachFileSyntaxBuffer(ecs_world_t *world, ecs_entity_t file, TextBuffer *buffer);
+
+// Replace the content of one line (without terminator) and re-lex from its
+// checkpoint. Returns the number of lines lexed, -1 if the file has no
+// syntax or the line does not exist.
+int EditFileSyntaxLine(ecs_world_t *world, ecs_entity_t file, int line, const char *text);
+
+// Undo (or redo) the last edit step of a file and re-lex the lines it
+// changed. Line phantoms of those lines show the restored text. Returns the
+// number of lines lexed, -1 if the file has no syntax or nothing to undo.
+int UndoFileSyntax(ecs_world_t *world, ecs_entity_t file, bool redo);
+
+// Token spans of a file container, NULL if it has none
+const TokenBuffer *GetFileSyntax(const ecs_world_t *world, const FileSyntax *syntax);
+
+// Text last lexed for a file container (including edits), NULL if none.
+// After an edit the text is flattened again on the next call.
+const char *GetFileSyntaxText(const ecs_world_t *world, const FileSyntax *syntax, size_t *length);
+
+// Piece table of a file container, NULL if none. Its edit count tells
+// whether the text changed since it was last read.
+const TextBuffer *GetFileSyntaxBuffer(const ecs_world_t *world, const FileSyntax *syntax);
+
+// Copy one line without its terminator into out (truncated to capacity - 1
+// bytes). Returns the bytes copied.
+size_t GetFileSyntaxLine(const ecs_world_t *world, const FileSyntax *syntax, int line, char *out,
+                         size_t capacity);
+
+// Color of a token kind, also used for the text_lod silhouettes
+Color TokenKindColor(TokenKind kind);
+
+// Draw one line of text with its token spans colored. text is the line
+// content (it may be truncated; spans past its end are clipped).
+void DrawSyntaxLine(const TokenBuffer *tokens, int line, const char *text, Font font,
+                    Vector2 position, float font_size, float spacing);
+
+// Systems and observers
+void TextEditSystem(ecs_iter_t *it);
+void OnFileSyntaxReload(ecs_iter_t *it);
+void OnFileSyntaxRemoved(ecs_iter_t *it);
+
+void RegisterSyntaxSystems(ecs_world_t *world);
+
+#endif // SYNTAX_H
@@ -0,0 +1,803 @@
+#define _POSIX_C_SOURCE 200809L  // mmap, open, fstat
+#include "text_buffer.h"
+#include "memory_tracker.h"
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEXT_BUFFER_MAX_LENGTH 0xffffffffu
+
+struct TextBlock {
+    atomic_int references;
+    char *bytes;
+    size_t mapped_length;     // munmap on release if > 0, otherwise free
+};
+
+// Sorted positions of the newlines in text
+static uint32_t *IndexNewlines(const char *text, uint32_t length, int *out_count) {
+    int count = 0;
+    for (const char *p = text, *end = text + length; (p = memchr(p, '\n', (size_t)(end - p))) != NULL; p++) {
+        count++;
+    }
+    uint32_t *positions = TrackedMalloc(MEMORY_TAG_TEXT, sizeof(uint32_t) * (count > 0 ? count : 1));
+    if (!positions) {
+        return NULL;
+    }
+    int i = 0;
+    for (const char *p = text, *end = text + length; (p = memchr(p, '\n', (size_t)(end - p))) != NULL; p++) {
+        positions[i++] = (uint32_t)(p - text);
+    }
+    *out_count = count;
+    return positions;
+}
+
+// First index whose position is >= value
+static int LowerBound(const uint32_t *positions, int count, uint32_t value) {
+    int low = 0;
+    int high = count;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (positions[mid] < value) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static const char *BufferBytes(const TextBuffer *b, uint8_t which) {
+    return which == TEXT_BUFFER_ADD ? b->add : b->original;
+}
+
+static const uint32_t *BufferNewlines(const TextBuffer *b, uint8_t which, int *count) {
+    *count = which == TEXT_BUFFER_ADD ? b->add_newline_count : b->original_newline_count;
+    return which == TEXT_BUFFER_ADD ? b->add_newlines : b->original_newlines;
+}
+
+// Newlines in [begin, end) of one buffer
+static uint32_t CountNewlines(const TextBuffer *b, uint8_t which, uint32_t begin, uint32_t end) {
+    int count;
+    const uint32_t *positions = BufferNewlines(b, which, &count);
+    return (uint32_t)(LowerBound(positions, count, end) - LowerBound(positions, count, begin));
+}
+
+static uint32_t NextPriority(TextBuffer *b) {
+    uint32_t x = b->random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    b->random = x;
+    return x;
+}
+
+// Tree
+
+static inline uint32_t SubtreeLength(const TextBuffer *b, uint32_t node) {
+    return node ? b->pieces[node].subtree_length : 0;
+}
+
+static inline uint32_t SubtreeNewlines(const TextBuffer *b, uint32_t node) {
+    return node ? b->pieces[node].subtree_newlines : 0;
+}
+
+static inline uint32_t SubtreePieces(const TextBuffer *b, uint32_t node) {
+    return node ? b->pieces[node].subtree_pieces : 0;
+}
+
+static inline void Update(TextBuffer *b, uint32_t node) {
+    TextPiece *n = &b->pieces[node];
+    n->subtree_length = n->length + SubtreeLength(b, n->left) + SubtreeLength(b, n->right);
+    n->subtree_newlines = n->newlines + SubtreeNewlines(b, n->left) + SubtreeNewlines(b, n->right);
+    n->subtree_pieces = 1 + SubtreePieces(b, n->left) + SubtreePieces(b, n->right);
+}
+
+// Every edit allocates at most two nodes; reserving them up front keeps
+// node pointers valid through the recursive split
+static bool ReservePieces(TextBuffer *b, int extra) {
+    return GrowArray(MEMORY_TAG_TEXT, (void**)&b->pieces, &b->piece_capacity, b->piece_count + extra,
+                     sizeof(TextPiece));
+}
+
+static uint32_t AllocatePiece(TextBuffer *b) {
+    uint32_t node = b->free_count > 0 ? b->free_pieces[--b->free_count] : (uint32_t)b->piece_count++;
+    memset(&b->pieces[node], 0, sizeof(TextPiece));
+    return node;
+}
+
+// Splits the subtree at node into the first offset bytes and the rest. A
+// piece that straddles offset is cut in two; the tail keeps the piece's
+// priority, so it can sit on top of the piece's right subtree.
+static void Split(TextBuffer *b, uint32_t node, uint32_t offset, uint32_t *left, uint32_t *right) {
+    if (!node) {
+        *left = 0;
+        *right = 0;
+        return;
+    }
+    TextPiece *n = &b->pieces[node];
+    uint32_t left_length = SubtreeLength(b, n->left);
+    if (offset <= left_length) {
+        Split(b, n->left, offset, left, &n->left);
+        *right = node;
+    } else if (offset >= left_length + n->length) {
+        Split(b, n->right, offset - left_length - n->length, &n->right, right);
+        *left = node;
+    } else {
+        uint32_t cut = offset - left_length;
+        uint32_t tail = AllocatePiece(b);
+        TextPiece *t = &b->pieces[tail];
+        t->buffer = n->buffer;
+        t->start = n->start + cut;
+        t->length = n->length - cut;
+        t->newlines = CountNewlines(b, n->buffer, t->start, t->start + t->length);
+        t->right = n->right;
+        t->priority = n->priority;
+        n->length = cut;
+        n->newlines -= t->newlines;
+        n->right = 0;
+        Update(b, tail);
+        *left = node;
+        *right = tail;
+    }
+    Update(b, node);
+}
+
+static uint32_t Merge(TextBuffer *b, uint32_t left, uint32_t right) {
+    if (!left || !right) {
+        return left ? left : right;
+    }
+    if (b->pieces[left].priority >= b->pieces[right].priority) {
+        uint32_t merged = Merge(b, b->pieces[left].right, right);
+        b->pieces[left].right = merged;
+        Update(b, left);
+        return left;
+    }
+    uint32_t merged = Merge(b, left, b->pieces[right].left);
+    b->pieces[right].left = merged;
+    Update(b, right);
+    return right;
+}
+
+// Typing appends to the add buffer right after the previous insert: the
+// last piece of the left part then grows instead of a new piece
+static bool ExtendLastPiece(TextBuffer *b, uint32_t left, uint32_t start, uint32_t length, uint32_t newlines) {
+    uint32_t last = left;
+    while (last && b->pieces[last].right) {
+        last = b->pieces[last].right;
+    }
+    if (!last || b->pieces[last].buffer != TEXT_BUFFER_ADD ||
+        b->pieces[last].start + b->pieces[last].length != start) {
+        return false;
+    }
+    b->pieces[last].length += length;
+    b->pieces[last].newlines += newlines;
+    for (uint32_t node = left; node; node = b->pieces[node].right) {
+        b->pieces[node].subtree_length += length;
+        b->pieces[node].subtree_newlines += newlines;
+    }
+    return true;
+}
+
+// Released nodes go on the free list, which doubles as the work queue for
+// their children
+static void FreeSubtree(TextBuffer *b, uint32_t node) {
+    if (!node || !GrowArray(MEMORY_TAG_TEXT, (void**)&b->free_pieces, &b->free_capacity, b->free_count + 1,
+                            sizeof(uint32_t))) {
+        return;
+    }
+    int next = b->free_count;
+    b->free_pieces[b->free_count++] = node;
+    while (next < b->free_count) {
+        TextPiece *n = &b->pieces[b->free_pieces[next++]];
+        uint32_t children[2] = {n->left, n->right};
+        for (int c = 0; c < 2; c++) {
+            if (children[c] &&
+                GrowArray(MEMORY_TAG_TEXT, (void**)&b->free_pieces, &b->free_capacity, b->free_count + 1,
+                          sizeof(uint32_t))) {
+                b->free_pieces[b->free_count++] = children[c];
+            }
+        }
+    }
+}
+
+static size_t ReadSubtree(const TextBuffer *b, uint32_t node, uint32_t from, uint32_t to, char *out) {
+    if (!node || from >= to) {
+        return 0;
+    }
+    const TextPiece *n = &b->pieces[node];
+    uint32_t piece_begin = SubtreeLength(b, n->left);
+    uint32_t piece_end = piece_begin + n->length;
+    size_t copied = 0;
+    if (from < piece_begin) {
+        copied += ReadSubtree(b, n->left, from, to < piece_begin ? to : piece_begin, out);
+    }
+    if (from < piece_end && to > piece_begin) {
+        uint32_t begin = from > piece_begin ? from : piece_begin;
+        uint32_t end = to < piece_end ? to : piece_end;
+        memcpy(out + copied, BufferBytes(b, n->buffer) + n->start + (begin - piece_begin), end - begin);
+        copied += end - begin;
+    }
+    if (to > piece_end) {
+        copied += ReadSubtree(b, n->right, from > piece_end ? from - piece_end : 0, to - piece_end, out + copied);
+    }
+    return copied;
+}
+
+// Blocks
+
+static TextBlock *NewBlock(char *bytes, size_t mapped_length) {
+    TextBlock *block = TrackedMalloc(MEMORY_TAG_TEXT, sizeof(TextBlock));
+    if (block) {
+        atomic_init(&block->references, 1);
+        block->bytes = bytes;
+        block->mapped_length = mapped_length;
+        MemoryTrackExternal(MEMORY_TAG_FILES, (int64_t)mapped_length);
+    }
+    return block;
+}
+
+static void ReleaseBlock(TextBlock *block) {
+    if (!block || atomic_fetch_sub(&block->references, 1) != 1) {
+        return;
+    }
+    if (block->mapped_length > 0) {
+        munmap(block->bytes, block->mapped_length);
+        MemoryTrackExternal(MEMORY_TAG_FILES, -(int64_t)block->mapped_length);
+    } else {
+        TrackedFree(MEMORY_TAG_TEXT, block->bytes);
+    }
+    TrackedFree(MEMORY_TAG_TEXT, block);
+}
+
+// Buffer
+
+static bool InitPieces(TextBuffer *b) {
+    b->piece_count = 1;
+    b->random = 0x9e3779b9u;
+    if (!ReservePieces(b, 1)) {
+        return false;
+    }
+    if (b->original_length > 0) {
+        b->root = AllocatePiece(b);
+        TextPiece *n = &b->pieces[b->root];
+        n->buffer = TEXT_BUFFER_ORIGINAL;
+        n->length = b->original_length;
+        n->newlines = (uint32_t)b->original_newline_count;
+        n->priority = NextPriority(b);
+        Update(b, b->root);
+    }
+    return true;
+}
+
+bool TextBufferInit(TextBuffer *buffer, const char *text, size_t length) {
+    memset(buffer, 0, sizeof(*buffer));
+    if (length > TEXT_BUFFER_MAX_LENGTH) {
+        return false;
+    }
+    if (text && length > 0) {
+        char *copy = TrackedMalloc(MEMORY_TAG_TEXT, length);
+        if (!copy) {
+            return false;
+        }
+        memcpy(copy, text, length);
+        buffer->original_block = NewBlock(copy, 0);
+        if (!buffer->original_block) {
+            TrackedFree(MEMORY_TAG_TEXT, copy);
+            return false;
+        }
+        buffer->original = copy;
+        buffer->original_length = (uint32_t)length;
+        buffer->original_newlines = IndexNewlines(copy, (uint32_t)length, &buffer->original_newline_count);
+        if (!buffer->original_newlines) {
+            TextBufferFree(buffer);
+            return false;
+        }
+    }
+    if (!InitPieces(buffer)) {
+        TextBufferFree(buffer);
+        return false;
+    }
+    return true;
+}
+
+bool TextBufferInitMapped(TextBuffer *buffer, const char *path) {
+    memset(buffer, 0, sizeof(*buffer));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 0 || (uint64_t)st.st_size > TEXT_BUFFER_MAX_LENGTH) {
+        close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return TextBufferInit(buffer, NULL, 0);
+    }
+
+    size_t length = (size_t)st.st_size;
+    void *mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+        // Not mappable (e.g. a pipe or special file system): read a copy
+        char *copy = TrackedMalloc(MEMORY_TAG_TEXT, length);
+        size_t read_length = 0;
+        while (copy && read_length < length) {
+            ssize_t n = read(fd, copy + read_length, length - read_length);
+            if (n <= 0) {
+                break;
+            }
+            read_length += (size_t)n;
+        }
+        close(fd);
+        bool ok = copy && TextBufferInit(buffer, copy, read_length);
+        TrackedFree(MEMORY_TAG_TEXT, copy);
+        return ok;
+    }
+    close(fd);
+
+    buffer->original_block = NewBlock(mapped, length);
+    if (!buffer->original_block) {
+        munmap(mapped, length);
+        return false;
+    }
+    buffer->original = mapped;
+    buffer->original_length = (uint32_t)length;
+    buffer->original_newlines = IndexNewlines(mapped, (uint32_t)length, &buffer->original_newline_count);
+    if (!buffer->original_newlines || !InitPieces(buffer)) {
+        TextBufferFree(buffer);
+        return false;
+    }
+    return true;
+}
+
+void TextBufferFree(TextBuffer *buffer) {
+    ReleaseBlock(buffer->original_block);
+    ReleaseBlock(buffer->add_block);
+    TrackedFree(MEMORY_TAG_TEXT, buffer->original_newlines);
+    TrackedFree(MEMORY_TAG_TEXT, buffer->add_newlines);
+    TrackedFree(MEMORY_TAG_TEXT, buffer->pieces);
+    TrackedFree(MEMORY_TAG_TEXT, buffer->free_pieces);
+    TrackedFree(MEMORY_TAG_TEXT, buffer->journal.records);
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+size_t TextBufferLength(const TextBuffer *buffer) {
+    return SubtreeLength(buffer, buffer->root);
+}
+
+size_t TextBufferNewlines(const TextBuffer *buffer) {
+    return SubtreeNewlines(buffer, buffer->root);
+}
+
+int TextBufferPieceCount(const TextBuffer *buffer) {
+    return buffer->piece_count - 1 - buffer->free_count;
+}
+
+size_t TextBufferMemory(const TextBuffer *buffer) {
+    size_t bytes = (size_t)buffer->add_capacity;
+    bytes += sizeof(TextPiece) * (size_t)buffer->piece_capacity;
+    bytes += sizeof(TextEditRecord) * (size_t)buffer->journal.capacity;
+    bytes += sizeof(uint32_t) * ((size_t)buffer->free_capacity + (size_t)buffer->add_newline_capacity +
+                                 (size_t)buffer->original_newline_count);
+    if (buffer->original_block && buffer->original_block->mapped_length == 0) {
+        bytes += buffer->original_length;
+    }
+    return bytes;
+}
+
+static bool AppendAdd(TextBuffer *b, const char *text, uint32_t length) {
+    if (b->add_length + length > b->add_capacity) {
+        uint64_t capacity = b->add_capacity > 0 ? b->add_capacity : 4096;
+        while (capacity < (uint64_t)b->add_length + length) {
+            capacity *= 2;
+        }
+        capacity = capacity > TEXT_BUFFER_MAX_LENGTH ? TEXT_BUFFER_MAX_LENGTH : capacity;
+        // A snapshot still reading the add buffer keeps the old block: the
+        // bytes move to a new one
+        bool shared = b->add_block && atomic_load(&b->add_block->references) > 1;
+        bool fresh = shared || !b->add_block;
+        char *grown = shared ? TrackedMalloc(MEMORY_TAG_TEXT, (size_t)capacity)
+                             : TrackedRealloc(MEMORY_TAG_TEXT, b->add, (size_t)capacity);
+        TextBlock *block = grown && fresh ? NewBlock(grown, 0) : b->add_block;
+        if (!grown || !block) {
+            printf("TextBuffer: out of memory growing the add buffer to %llu bytes\n", (unsigned long long)capacity);
+            TrackedFree(MEMORY_TAG_TEXT, grown);  // Only set when its new block failed
+            return false;
+        }
+        if (shared) {
+            memcpy(grown, b->add, b->add_length);
+            ReleaseBlock(b->add_block);
+        }
+        block->bytes = grown;
+        b->add_block = block;
+        b->add = grown;
+        b->add_capacity = (uint32_t)capacity;
+    }
+    for (uint32_t i = 0; i < length; i++) {
+        if (text[i] == '\n') {
+            if (!GrowArray(MEMORY_TAG_TEXT, (void**)&b->add_newlines, &b->add_newline_capacity,
+                           b->add_newline_count + 1, sizeof(uint32_t))) {
+                return false;
+            }
+            b->add_newlines[b->add_newline_count++] = b->add_length + i;
+        }
+    }
+    memcpy(b->add + b->add_length, text, length);
+    b->add_length += length;
+    return true;
+}
+
+// History
+
+static size_t RecordMemory(const TextBuffer *b, const TextEditRecord *record) {
+    return sizeof(TextEditRecord) + sizeof(TextPiece) * SubtreePieces(b, record->detached);
+}
+
+static void ReleaseRecords(TextBuffer *b, int begin, int end) {
+    TextJournal *j = &b->journal;
+    for (int i = begin; i < end; i++) {
+        j->memory -= RecordMemory(b, &j->records[i]);
+        FreeSubtree(b, j->records[i].detached);
+    }
+}
+
+// Merges the oldest steps into the base text until the history fits the
+// cap, then drops the steps furthest down the redo side. A single step is
+// kept whatever its size.
+static void TrimHistory(TextBuffer *b) {
+    TextJournal *j = &b->journal;
+    while (j->memory_cap > 0 && j->memory > j->memory_cap) {
+        int end = 1;
+        while (end < j->count && !j->records[end].step_start) {
+            end++;
+        }
+        if (end >= j->count) {
+            return;
+        }
+        if (end <= j->done) {
+            ReleaseRecords(b, 0, end);
+            memmove(j->records, j->records + end, sizeof(TextEditRecord) * (size_t)(j->count - end));
+            j->count -= end;
+            j->done -= end;
+            j->steps_merged++;
+            continue;
+        }
+        int begin = j->count - 1;
+        while (!j->records[begin].step_start) {
+            begin--;
+        }
+        ReleaseRecords(b, begin, j->count);
+        j->count = begin;
+    }
+}
+
+// Logs an edit, or frees the deleted pieces when there is no history. An
+// edit that continues the open step's last record (typing on, backspacing
+// or deleting forward) grows that record instead.
+static void RecordEdit(TextBuffer *b, uint8_t kind, size_t offset, size_t length, uint32_t detached) {
+    TextJournal *j = &b->journal;
+    if (!j->enabled) {
+        FreeSubtree(b, detached);
+        return;
+    }
+    ReleaseRecords(b, j->done, j->count);
+    j->count = j->done;
+
+    TextEditRecord *last = j->open && j->count > 0 ? &j->records[j->count - 1] : NULL;
+    if (last && last->kind == kind) {
+        if (kind == TEXT_EDIT_INSERT && offset == (size_t)last->offset + last->length) {
+            last->length += (uint32_t)length;
+            return;
+        }
+        if (kind == TEXT_EDIT_DELETE && (offset + length == last->offset || offset == last->offset)) {
+            j->memory -= RecordMemory(b, last);
+            last->detached = offset == last->offset ? Merge(b, last->detached, detached)
+                                                    : Merge(b, detached, last->detached);
+            last->offset = (uint32_t)offset;
+            last->length += (uint32_t)length;
+            j->memory += RecordMemory(b, last);
+            TrimHistory(b);
+            return;
+        }
+    }
+
+    if (!GrowArray(MEMORY_TAG_TEXT, (void**)&j->records, &j->capacity, j->count + 1, sizeof(TextEditRecord))) {
+        // History is lost rather than the edit
+        ReleaseRecords(b, 0, j->count);
+        j->count = 0;
+        j->done = 0;
+        j->open = false;
+        FreeSubtree(b, detached);
+        return;
+    }
+    TextEditRecord *record = &j->records[j->count++];
+    *record = (TextEditRecord){(uint32_t)offset, (uint32_t)length, detached, kind, !j->open};
+    j->done = j->count;
+    j->open = true;
+    j->memory += RecordMemory(b, record);
+    TrimHistory(b);
+}
+
+// Grows change, which maps the text before the step to the text now, by
+// one edit replacing [offset, offset + removed) of the current text
+static void AddChange(TextChange *change, size_t offset, size_t removed, size_t inserted) {
+    if (change->removed == 0 && change->inserted == 0) {
+        *change = (TextChange){offset, removed, inserted};
+        return;
+    }
+    size_t changed_end = change->offset + change->inserted;
+    size_t end = offset + removed > changed_end ? offset + removed : changed_end;
+    size_t begin = offset < change->offset ? offset : change->offset;
+    size_t before_end = end - change->inserted + change->removed;  // Past changed_end text only shifts
+    change->offset = begin;
+    change->removed = before_end - begin;
+    change->inserted = end - removed + inserted - begin;
+}
+
+// Takes the record's text out of the tree into its detached subtree, or
+// puts its detached subtree back
+static bool ApplyRecord(TextBuffer *b, TextEditRecord *record, bool text_in, TextChange *change) {
+    if (!ReservePieces(b, 2)) {
+        return false;
+    }
+    TextJournal *j = &b->journal;
+    j->memory -= RecordMemory(b, record);
+    uint32_t left, middle, right;
+    Split(b, b->root, record->offset, &left, &right);
+    if (text_in) {
+        b->root = Merge(b, Merge(b, left, record->detached), right);
+        record->detached = 0;
+        AddChange(change, record->offset, 0, record->length);
+    } else {
+        Split(b, right, record->length, &middle, &right);
+        b->root = Merge(b, left, right);
+        record->detached = middle;
+        AddChange(change, record->offset, record->length, 0);
+    }
+    j->memory += RecordMemory(b, record);
+    b->edits++;
+    return true;
+}
+
+void TextBufferEnableHistory(TextBuffer *buffer, size_t memory_cap) {
+    buffer->journal.enabled = true;
+    buffer->journal.memory_cap = memory_cap;
+    TrimHistory(buffer);
+}
+
+void TextBufferCheckpoint(TextBuffer *buffer) {
+    buffer->journal.open = false;
+}
+
+bool TextBufferUndo(TextBuffer *buffer, TextChange *change) {
+    TextJournal *j = &buffer->journal;
+    *change = (TextChange){0, 0, 0};
+    j->open = false;
+    if (j->done == 0) {
+        return false;
+    }
+    do {
+        TextEditRecord *record = &j->records[j->done - 1];
+        if (!ApplyRecord(buffer, record, record->kind == TEXT_EDIT_DELETE, change)) {
+            return false;
+        }
+        j->done--;
+    } while (j->done > 0 && !j->records[j->done].step_start);
+    TrimHistory(buffer);
+    return true;
+}
+
+bool TextBufferRedo(TextBuffer *buffer, TextChange *change) {
+    TextJournal *j = &buffer->journal;
+    *change = (TextChange){0, 0, 0};
+    j->open = false;
+    if (j->done == j->count) {
+        return false;
+    }
+    do {
+        TextEditRecord *record = &j->records[j->done];
+        if (!ApplyRecord(buffer, record, record->kind == TEXT_EDIT_INSERT, change)) {
+            return false;
+        }
+        j->done++;
+    } while (j->done < j->count && !j->records[j->done].step_start);
+    TrimHistory(buffer);
+    return true;
+}
+
+static int CountSteps(const TextJournal *j, int begin, int end) {
+    int steps = 0;
+    for (int i = begin; i < end; i++) {
+        steps += j->records[i].step_start;
+    }
+    return steps;
+}
+
+int TextBufferUndoSteps(const TextBuffer *buffer) {
+    return CountSteps(&buffer->journal, 0, buffer->journal.done);
+}
+
+int TextBufferRedoSteps(const TextBuffer *buffer) {
+    return CountSteps(&buffer->journal, buffer->journal.done, buffer->journal.count);
+}
+
+bool TextBufferInsert(TextBuffer *buffer, size_t offset, const char *text, size_t length) {
+    size_t total = TextBufferLength(buffer);
+    if (length == 0) {
+        return offset <= total;
+    }
+    if (offset > total || length > TEXT_BUFFER_MAX_LENGTH - total ||
+        length > TEXT_BUFFER_MAX_LENGTH - buffer->add_length || !ReservePieces(buffer, 2)) {
+        return false;
+    }
+    int first_newline = buffer->add_newline_count;
+    if (!AppendAdd(buffer, text, (uint32_t)length)) {
+        return false;
+    }
+    uint32_t start = buffer->add_length - (uint32_t)length;
+    uint32_t newlines = (uint32_t)(buffer->add_newline_count - first_newline);
+
+    uint32_t left, right;
+    Split(buffer, buffer->root, (uint32_t)offset, &left, &right);
+    if (!ExtendLastPiece(buffer, left, start, (uint32_t)length, newlines)) {
+        uint32_t node = AllocatePiece(buffer);
+        TextPiece *n = &buffer->pieces[node];
+        n->buffer = TEXT_BUFFER_ADD;
+        n->start = start;
+        n->length = (uint32_t)length;
+        n->newlines = newlines;
+        n->priority = NextPriority(buffer);
+        Update(buffer, node);
+        left = Merge(buffer, left, node);
+    }
+    buffer->root = Merge(buffer, left, right);
+    buffer->edits++;
+    RecordEdit(buffer, TEXT_EDIT_INSERT, offset, length, 0);
+    return true;
+}
+
+bool TextBufferDelete(TextBuffer *buffer, size_t offset, size_t length) {
+    size_t total = TextBufferLength(buffer);
+    if (offset > total || length > total - offset) {
+        return false;
+    }
+    if (length == 0) {
+        return true;
+    }
+    if (!ReservePieces(buffer, 2)) {
+        return false;
+    }
+    uint32_t left, middle, right;
+    Split(buffer, buffer->root, (uint32_t)offset, &left, &middle);
+    Split(buffer, middle, (uint32_t)length, &middle, &right);
+    buffer->root = Merge(buffer, left, right);
+    buffer->edits++;
+    RecordEdit(buffer, TEXT_EDIT_DELETE, offset, length, middle);
+    return true;
+}
+
+int TextBufferLineOf(const TextBuffer *buffer, size_t offset) {
+    uint32_t node = buffer->root;
+    size_t base = 0;
+    size_t lines = 0;
+    while (node) {
+        const TextPiece *n = &buffer->pieces[node];
+        size_t left_length = SubtreeLength(buffer, n->left);
+        if (offset < base + left_length) {
+            node = n->left;
+            continue;
+        }
+        base += left_length;
+        lines += SubtreeNewlines(buffer, n->left);
+        if (offset < base + n->length) {
+            return (int)(lines + CountNewlines(buffer, n->buffer, n->start, n->start + (uint32_t)(offset - base)));
+        }
+        base += n->length;
+        lines += n->newlines;
+        node = n->right;
+    }
+    return (int)lines;
+}
+
+// Descends by newline counts to the piece holding the line-th newline
+size_t TextBufferLineStart(const TextBuffer *buffer, int line) {
+    if (line <= 0) {
+        return 0;
+    }
+    uint32_t k = (uint32_t)line;
+    if (k > SubtreeNewlines(buffer, buffer->root)) {
+        return TextBufferLength(buffer);
+    }
+    size_t base = 0;
+    uint32_t node = buffer->root;
+    while (node) {
+        const TextPiece *n = &buffer->pieces[node];
+        uint32_t left_newlines = SubtreeNewlines(buffer, n->left);
+        if (k <= left_newlines) {
+            node = n->left;
+            continue;
+        }
+        k -= left_newlines;
+        base += SubtreeLength(buffer, n->left);
+        if (k <= n->newlines) {
+            int count;
+            const uint32_t *positions = BufferNewlines(buffer, n->buffer, &count);
+            uint32_t position = positions[LowerBound(positions, count, n->start) + (int)k - 1];
+            return base + (position - n->start) + 1;
+        }
+        k -= n->newlines;
+        base += n->length;
+        node = n->right;
+    }
+    return TextBufferLength(buffer);
+}
+
+size_t TextBufferRead(const TextBuffer *buffer, size_t offset, char *out, size_t length) {
+    size_t total = TextBufferLength(buffer);
+    if (offset >= total) {
+        return 0;
+    }
+    size_t end = length > total - offset ? total : offset + length;
+    return ReadSubtree(buffer, buffer->root, (uint32_t)offset, (uint32_t)end, out);
+}
+
+const char *TextBufferContiguous(const TextBuffer *buffer, size_t *length) {
+    const TextPiece *root = buffer->root ? &buffer->pieces[buffer->root] : NULL;
+    if (!root) {
+        *length = 0;
+        return "";
+    }
+    if (root->left || root->right) {
+        *length = 0;
+        return NULL;
+    }
+    *length = root->length;
+    return BufferBytes(buffer, root->buffer) + root->start;
+}
+
+// Snapshots
+
+static int CollectSpans(const TextBuffer *b, uint32_t node, TextSnapshotSpan *spans, int count) {
+    if (node == 0) {
+        return count;
+    }
+    const TextPiece *n = &b->pieces[node];
+    count = CollectSpans(b, n->left, spans, count);
+    if (n->length > 0) {
+        spans[count++] = (TextSnapshotSpan){BufferBytes(b, n->buffer) + n->start, n->length};
+    }
+    return CollectSpans(b, n->right, spans, count);
+}
+
+bool TextBufferSnapshot(const TextBuffer *buffer, TextSnapshot *snapshot) {
+    memset(snapshot, 0, sizeof(*snapshot));
+    uint32_t pieces = SubtreePieces(buffer, buffer->root);
+    snapshot->spans = TrackedMalloc(MEMORY_TAG_TEXT, sizeof(TextSnapshotSpan) * (pieces > 0 ? pieces : 1));
+    if (!snapshot->spans) {
+        printf("TextBuffer: out of memory taking a snapshot of %u pieces\n", pieces);
+        return false;
+    }
+    snapshot->span_count = CollectSpans(buffer, buffer->root, snapshot->spans, 0);
+    snapshot->length = TextBufferLength(buffer);
+    snapshot->blocks[0] = buffer->original_block;
+    snapshot->blocks[1] = buffer->add_block;
+    for (int i = 0; i < 2; i++) {
+        if (snapshot->blocks[i]) {
+            atomic_fetch_add(&snapshot->blocks[i]->references, 1);
+        }
+    }
+    return true;
+}
+
+void TextSnapshotFree(TextSnapshot *snapshot) {
+    ReleaseBlock(snapshot->blocks[0]);
+    ReleaseBlock(snapshot->blocks[1]);
+    TrackedFree(MEMORY_TAG_TEXT, snapshot->spans);
+    memset(snapshot, 0, sizeof(*snapshot));
+}
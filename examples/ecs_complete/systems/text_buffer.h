@@ -0,0 +1,192 @@
+#ifndef TEXT_BUFFER_H
+#define TEXT_BUFFER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Piece table holding the text of one file.
+//
+// The text is a sequence of pieces, each a span of one of two buffers: the
+// original file contents (memory-mapped read-only when loaded from disk)
+// and an append-only add buffer that receives every inserted byte. Edits
+// never move text; they only split, drop and add pieces.
+//
+// Pieces are the nodes of a treap ordered by text position. Each node
+// keeps the byte and newline totals of its subtree, so insert, delete,
+// offset lookup and line lookup are O(log pieces). Both buffers keep the
+// sorted positions of their newlines, which gives the newline count of any
+// span (and of each half of a split piece) by binary search instead of a
+// scan.
+//
+// Offsets are 32-bit: a buffer holds up to 4 GB.
+//
+// Undo history (when enabled) is a log of edit records. A record keeps the
+// pieces an edit took out of the tree (a delete's text, or an undone
+// insert's) as a detached subtree that shares the buffers' bytes, so undo
+// and redo split and merge the tree in O(log pieces) however large the
+// edit was. Records between checkpoints form one undo step; a step keeps
+// absorbing an edit that continues its last record (typing, backspacing).
+// Past the memory cap the oldest steps are merged into the base text.
+//
+// Both buffers are reference-counted blocks. A snapshot copies the piece
+// list in order and takes a reference to each block, so another thread
+// can write the text out while the buffer keeps changing: add buffer bytes
+// below the snapshot's end never change, and a growing add buffer that a
+// snapshot still holds moves to a new block instead of being reallocated.
+
+// One span of a buffer, and a treap node
+typedef struct {
+    uint32_t start;           // Offset in its buffer
+    uint32_t length;
+    uint32_t newlines;        // '\n' bytes in the span
+    uint32_t left;            // Node indices, 0 = none
+    uint32_t right;
+    uint32_t priority;        // Heap order: a parent's is never lower
+    uint32_t subtree_length;  // Bytes in the subtree
+    uint32_t subtree_newlines;
+    uint32_t subtree_pieces;
+    uint8_t buffer;           // TEXT_BUFFER_ORIGINAL or TEXT_BUFFER_ADD
+} TextPiece;
+
+enum {
+    TEXT_BUFFER_ORIGINAL = 0,
+    TEXT_BUFFER_ADD = 1
+};
+
+enum {
+    TEXT_EDIT_INSERT = 0,
+    TEXT_EDIT_DELETE = 1
+};
+
+// One insert or delete of length bytes at offset
+typedef struct {
+    uint32_t offset;
+    uint32_t length;
+    uint32_t detached;        // Subtree held by the record, 0 if none
+    uint8_t kind;             // TEXT_EDIT_*
+    bool step_start;          // First record of an undo step
+} TextEditRecord;
+
+typedef struct {
+    TextEditRecord *records;
+    int count;                // Records, done and undone
+    int done;                 // [0, done) applied, [done, count) can be redone
+    int capacity;
+    bool enabled;
+    bool open;                // The last step takes more records
+    size_t memory;            // Records and held pieces, bytes
+    size_t memory_cap;        // 0 = unbounded
+    int steps_merged;         // Oldest steps merged into the base so far
+} TextJournal;
+
+// Bytes [offset, offset + removed) of the text before an undo or redo are
+// [offset, offset + inserted) after it
+typedef struct {
+    size_t offset;
+    size_t removed;
+    size_t inserted;
+} TextChange;
+
+// Bytes of one buffer, freed (or unmapped) with the last reference
+typedef struct TextBlock TextBlock;
+
+typedef struct {
+    const char *original;
+    uint32_t original_length;
+    TextBlock *original_block;  // NULL while empty
+    uint32_t *original_newlines;  // Sorted newline positions
+    int original_newline_count;
+
+    char *add;
+    uint32_t add_length;
+    uint32_t add_capacity;
+    TextBlock *add_block;
+    uint32_t *add_newlines;
+    int add_newline_count;
+    int add_newline_capacity;
+
+    TextPiece *pieces;        // pieces[0] is unused (0 = no node)
+    int piece_count;          // Nodes allocated, including free ones
+    int piece_capacity;
+    uint32_t *free_pieces;
+    int free_count;
+    int free_capacity;
+    uint32_t root;
+    uint32_t random;          // Priority generator state
+    uint32_t edits;           // Inserts and deletes since init
+    TextJournal journal;
+} TextBuffer;
+
+// Init from a copy of text, or empty (text NULL)
+bool TextBufferInit(TextBuffer *buffer, const char *text, size_t length);
+
+// Init from a file mapped read-only as the original buffer. Returns false
+// if the file cannot be opened or read.
+bool TextBufferInitMapped(TextBuffer *buffer, const char *path);
+
+void TextBufferFree(TextBuffer *buffer);
+
+size_t TextBufferLength(const TextBuffer *buffer);
+size_t TextBufferNewlines(const TextBuffer *buffer);
+int TextBufferPieceCount(const TextBuffer *buffer);
+
+// Bytes held by the buffer: add buffer, pieces and newline tables (the
+// original mapping is not counted when it is mapped)
+size_t TextBufferMemory(const TextBuffer *buffer);
+
+bool TextBufferInsert(TextBuffer *buffer, size_t offset, const char *text, size_t length);
+bool TextBufferDelete(TextBuffer *buffer, size_t offset, size_t length);
+
+// Line holding offset (newlines before it)
+int TextBufferLineOf(const TextBuffer *buffer, size_t offset);
+
+// Offset of the first byte of line `line` (lines are separated by '\n').
+// Lines past the last newline start at the end of the text.
+size_t TextBufferLineStart(const TextBuffer *buffer, int line);
+
+// Copy [offset, offset + length) into out; returns the bytes copied
+size_t TextBufferRead(const TextBuffer *buffer, size_t offset, char *out, size_t length);
+
+// The whole text if it is one contiguous span (unedited, or an edit that
+// left a single piece), NULL otherwise
+const char *TextBufferContiguous(const TextBuffer *buffer, size_t *length);
+
+// Start recording undo history, keeping it under memory_cap bytes (0 =
+// unbounded)
+void TextBufferEnableHistory(TextBuffer *buffer, size_t memory_cap);
+
+// Close the current undo step: the next edit starts a new one
+void TextBufferCheckpoint(TextBuffer *buffer);
+
+// Undo or redo one step. Returns false if there is none; change receives
+// the span of text that differs.
+bool TextBufferUndo(TextBuffer *buffer, TextChange *change);
+bool TextBufferRedo(TextBuffer *buffer, TextChange *change);
+
+// Steps that can be undone / redone
+int TextBufferUndoSteps(const TextBuffer *buffer);
+int TextBufferRedoSteps(const TextBuffer *buffer);
+
+// One span of a snapshot's text
+typedef struct {
+    const char *bytes;
+    uint32_t length;
+} TextSnapshotSpan;
+
+// The text of a buffer at one moment, readable from any thread
+typedef struct {
+    TextSnapshotSpan *spans;  // In text order
+    int span_count;
+    size_t length;
+    TextBlock *blocks[2];     // References held on the original and add bytes
+} TextSnapshot;
+
+// Capture the current text in O(pieces) without copying it. Returns false
+// if out of memory.
+bool TextBufferSnapshot(const TextBuffer *buffer, TextSnapshot *snapshot);
+
+// Release a snapshot (on any thread)
+void TextSnapshotFree(TextSnapshot *snapshot);
+
+#endif // TEXT_BUFFER_H
@@ -0,0 +1,214 @@
+#include "text_lod.h"
+#include "impostor.h"
+#include "profiler.h"
+#include "syntax.h"
+#include <raylib.h>
+#include <raymath.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <float.h>
+
+ECS_COMPONENT_DECLARE(TextLOD);
+ECS_COMPONENT_DECLARE(TextLODSettings);
+ECS_COMPONENT_DECLARE(TextLODStats);
+
+#define TEXT_LOD_TAB_WIDTH 4
+#define TEXT_LOD_COLUMNS_PER_LINE 3.0f  // Column width relative to line height
+
+// Token kind covering most of a line's columns. A line without spans
+// takes the state it starts in, so a blank line inside a block comment
+// stays a comment.
+static TokenKind DominantTokenKind(const TokenBuffer *tokens, int line) {
+    if (!tokens || line < 0 || line >= tokens->line_count) {
+        return TOKEN_IDENTIFIER;
+    }
+
+    uint32_t first = tokens->line_first[line];
+    uint32_t end = tokens->line_first[line + 1];
+    if (first == end) {
+        uint8_t state = tokens->line_state[line];
+        switch (state & LEX_STATE_MODE_MASK) {
+            case LEX_STATE_BLOCK_COMMENT:
+            case LEX_STATE_LINE_COMMENT:
+                return TOKEN_COMMENT;
+            case LEX_STATE_STRING:
+                return TOKEN_STRING;
+            default:
+                return (state & LEX_STATE_DIRECTIVE) ? TOKEN_DIRECTIVE : TOKEN_IDENTIFIER;
+        }
+    }
+
+    int columns[TOKEN_KIND_COUNT] = {0};
+    TokenKind dominant = (TokenKind)tokens->token_kind[first];
+    for (uint32_t t = first; t < end; t++) {
+        TokenKind kind = (TokenKind)tokens->token_kind[t];
+        columns[kind] += tokens->token_length[t];
+        if (columns[kind] > columns[dominant]) {
+            dominant = kind;
+        }
+    }
+    return dominant;
+}
+
+void UpdateTextSilhouette(const char *text, TextLOD *lod) {
+    int column = 0;
+    const char *c = text;
+
+    // Leading whitespace becomes the bar's indent
+    for (; *c == ' ' || *c == '\t'; c++) {
+        column += (*c == '\t') ? TEXT_LOD_TAB_WIDTH - (column % TEXT_LOD_TAB_WIDTH) : 1;
+    }
+    int indent = column;
+
+    // Visible extent excludes trailing whitespace
+    int visible_end = column;
+    for (; *c; c++) {
+        column += (*c == '\t') ? TEXT_LOD_TAB_WIDTH - (column % TEXT_LOD_TAB_WIDTH) : 1;
+        if (*c != ' ' && *c != '\t') {
+            visible_end = column;
+        }
+    }
+
+    lod->indent = (uint8_t)(indent > 255 ? 255 : indent);
+    int length = visible_end - indent;
+    lod->length = (uint16_t)(length > 65535 ? 65535 : length);
+}
+
+uint8_t SelectTextLODTier(float projected_px, uint8_t current_tier, const TextLODSettings *settings) {
+    float up = 1.0f + settings->hysteresis;
+
+    switch (current_tier) {
+        case TEXT_LOD_GLYPHS:
+            if (projected_px >= settings->glyph_px) {
+                return TEXT_LOD_GLYPHS;
+            }
+            return projected_px >= settings->hidden_px ? TEXT_LOD_SILHOUETTE : TEXT_LOD_HIDDEN;
+
+        case TEXT_LOD_SILHOUETTE:
+            if (projected_px >= settings->glyph_px * up) {
+                return TEXT_LOD_GLYPHS;
+            }
+            return projected_px >= settings->hidden_px ? TEXT_LOD_SILHOUETTE : TEXT_LOD_HIDDEN;
+
+        default:
+            if (projected_px >= settings->glyph_px * up) {
+                return TEXT_LOD_GLYPHS;
+            }
+            return projected_px >= settings->hidden_px * up ? TEXT_LOD_SILHOUETTE : TEXT_LOD_HIDDEN;
+    }
+}
+
+void DrawTextSilhouette(const TextLOD *lod, const TokenBuffer *tokens, int line, Vector2 screen_pos) {
+    float column_px = lod->projected_px / TEXT_LOD_COLUMNS_PER_LINE;
+    float bar_height = fmaxf(1.0f, lod->projected_px * 0.6f);
+    float total_width = (lod->indent + lod->length) * column_px;
+
+    // Same anchor as glyph rendering (text centered on the phantom)
+    float x = screen_pos.x - total_width * 0.5f + lod->indent * column_px;
+    float y = screen_pos.y - bar_height * 0.5f;
+    DrawRectangleV((Vector2){x, y}, (Vector2){fmaxf(1.0f, lod->length * column_px), bar_height},
+                   TokenKindColor(DominantTokenKind(tokens, line)));
+}
+
+// Assigns LOD tiers to every text phantom. Runs as a custom run callback so
+// the frame statistics can be reset once before iterating all tables.
+void TextLODSystem(ecs_iter_t *it) {
+    const ViewState *view = ecs_singleton_get(it->world, ViewState);
+    const TextLODSettings *settings = ecs_singleton_get(it->world, TextLODSettings);
+    TextLODStats *stats = ecs_singleton_get_mut(it->world, TextLODStats);
+    if (!view || !settings || !stats || view->viewport_height <= 0.0f) {
+        ecs_iter_fini(it);
+        return;
+    }
+
+    PROFILE_ZONE_BEGIN(TextLODSystem);
+    memset(stats, 0, sizeof(*stats));
+    float focal_px = view->viewport_height * 0.5f / tanf(view->fovy * 0.5f * DEG2RAD);
+    float line_px_at_unit = settings->line_height * focal_px;
+
+    while (ecs_iter_next(it)) {
+        Position *positions = ecs_field(it, Position, 0);
+        TextLOD *lods = ecs_field(it, TextLOD, 1);
+        FileImpostor *file_block = ecs_field(it, FileImpostor, 2);  // Shared, may be NULL
+        bool collapsed = ecs_field_is_set(it, 3);
+
+        // Whole file drawn as an impostor: no per-line work at all
+        if (collapsed) {
+            stats->tier_counts[TEXT_LOD_HIDDEN] += it->count;
+            continue;
+        }
+
+        int hidden = 0;
+        for (int i = 0; i < it->count; i++) {
+            Vector3 position = {positions[i].x, positions[i].y, positions[i].z};
+            float distance = Vector3Distance(view->camera_position, position);
+            float projected_px = distance > 0.001f ? line_px_at_unit / distance : FLT_MAX;
+
+            uint8_t tier = SelectTextLODTier(projected_px, lods[i].tier, settings);
+            if (tier != lods[i].tier) {
+                stats->transitions++;
+                lods[i].tier = tier;
+            }
+            lods[i].projected_px = projected_px;
+            stats->tier_counts[tier]++;
+            hidden += (tier == TEXT_LOD_HIDDEN);
+        }
+
+        // Lines in the hidden tier are represented by their file block
+        if (file_block && hidden > 0) {
+            file_block->hidden_lines += hidden;
+        }
+    }
+    PROFILE_ZONE_END(TextLODSystem);
+}
+
+// Keeps the cached silhouette in sync with the text
+void OnTextContentSet(ecs_iter_t *it) {
+    TextContent *texts = ecs_field(it, TextContent, 0);
+
+    for (int i = 0; i < it->count; i++) {
+        TextLOD *lod = ecs_get_mut(it->world, it->entities[i], TextLOD);
+        if (lod) {
+            UpdateTextSilhouette(texts[i].text, lod);
+        }
+    }
+}
+
+void RegisterTextLODSystems(ecs_world_t *world) {
+    ECS_COMPONENT_DEFINE(world, TextLOD);
+    ECS_COMPONENT_DEFINE(world, TextLODSettings);
+    ECS_COMPONENT_DEFINE(world, TextLODStats);
+
+    // Every text phantom gets LOD state automatically
+    ecs_add_pair(world, ecs_id(TextContent), EcsWith, ecs_id(TextLOD));
+
+    ecs_singleton_set(world, TextLODSettings, {
+        .line_height = 1.5f,
+        .glyph_px = 9.0f,
+        .hidden_px = 2.0f,
+        .hysteresis = 0.2f
+    });
+    ecs_singleton_set(world, TextLODStats, {0});
+
+    // Registered after the impostor systems so collapse state is current
+    ecs_system(world, {
+        .entity = ecs_entity(world, {
+            .name = "TextLODSystem",
+            .add = ecs_ids(ecs_dependson(EcsOnUpdate))
+        }),
+        .query.terms = {
+            { ecs_id(Position), .inout = EcsIn },
+            { ecs_id(TextLOD) },
+            { ecs_id(FileImpostor), .src.id = EcsUp, .trav = EcsChildOf, .oper = EcsOptional },
+            { ImpostorActive, .src.id = EcsUp, .trav = EcsChildOf, .oper = EcsOptional }
+        },
+        .run = TextLODSystem
+    });
+
+    ecs_observer_desc_t text_observer_desc = {0};
+    text_observer_desc.query.terms[0].id = ecs_id(TextContent);
+    text_observer_desc.events[0] = EcsOnSet;
+    text_observer_desc.callback = OnTextContentSet;
+    ecs_observer_init(world, &text_observer_desc);
+}
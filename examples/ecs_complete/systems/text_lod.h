@@ -0,0 +1,60 @@
+#ifndef TEXT_LOD_H
+#define TEXT_LOD_H
+
+#include <flecs.h>
+#include "lexer.h"
+#include "../components/spatial.h"
+
+// Level-of-detail tiers for text phantoms, chosen by projected line height
+typedef enum {
+    TEXT_LOD_GLYPHS = 0,      // Full text rendering
+    TEXT_LOD_SILHOUETTE = 1,  // One bar per line, colored by its dominant token kind
+    TEXT_LOD_HIDDEN = 2,      // Covered by the parent file block
+    TEXT_LOD_TIER_COUNT
+} TextLODTier;
+
+// Per-phantom LOD state plus the cached silhouette layout, so the bar tier
+// never has to measure text. Added automatically alongside TextContent.
+typedef struct {
+    uint8_t tier;
+    uint8_t indent;           // Leading whitespace in columns
+    uint16_t length;          // Visible length in columns
+    float projected_px;       // Projected line height from the last update
+} TextLOD;
+
+typedef struct {
+    float line_height;        // World units covered by one line of text
+    float glyph_px;           // Below this projected height glyphs become bars
+    float hidden_px;          // Below this bars are folded into the file block
+    float hysteresis;         // Fraction above a threshold required to move up a tier
+} TextLODSettings;
+
+// Frame statistics, rebuilt by TextLODSystem every frame
+typedef struct {
+    int tier_counts[TEXT_LOD_TIER_COUNT];
+    int transitions;          // Phantoms that changed tier this frame
+} TextLODStats;
+
+extern ECS_COMPONENT_DECLARE(TextLOD);
+extern ECS_COMPONENT_DECLARE(TextLODSettings);
+extern ECS_COMPONENT_DECLARE(TextLODStats);
+
+// Tier selection with hysteresis (exposed for headless checks)
+uint8_t SelectTextLODTier(float projected_px, uint8_t current_tier, const TextLODSettings *settings);
+
+// Recompute the cached silhouette layout (indent and visible length)
+void UpdateTextSilhouette(const char *text, TextLOD *lod);
+
+// Draw a line as a silhouette bar at a screen position, colored by the
+// token kind covering most of line `line` of tokens (default color if
+// tokens is NULL). The color is read from the spans on every draw, so it
+// follows edits that relex neighbouring lines.
+void DrawTextSilhouette(const TextLOD *lod, const TokenBuffer *tokens, int line, Vector2 screen_pos);
+
+// Systems
+void TextLODSystem(ecs_iter_t *it);
+void OnTextContentSet(ecs_iter_t *it);
+
+void RegisterTextLODSystems(ecs_world_t *world);
+
+#endif // TEXT_LOD_H
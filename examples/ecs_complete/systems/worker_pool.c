@@ -0,0 +1,37 @@
+#include "worker_pool.h"
+#include <stdio.h>
+
+typedef struct {
+    JobPool *pool;
+    int32_t users;            // Modules holding the pool
+} WorkerPool;
+
+static ECS_COMPONENT_DECLARE(WorkerPool);
+
+JobPool *WorkerPoolAcquire(ecs_world_t *world) {
+    ECS_COMPONENT_DEFINE(world, WorkerPool);
+    WorkerPool *shared = ecs_singleton_get_mut(world, WorkerPool);
+    if (!shared) {
+        ecs_singleton_set(world, WorkerPool, {0});
+        shared = ecs_singleton_get_mut(world, WorkerPool);
+    }
+    if (!shared->pool) {
+        shared->pool = JobPoolCreate(JobPoolDefaultThreads());
+        if (!shared->pool) {
+            printf("WorkerPool: cannot create the job pool, jobs run inline\n");
+        }
+    }
+    shared->users++;
+    return shared->pool;
+}
+
+void WorkerPoolRelease(ecs_world_t *world) {
+    WorkerPool *shared = ecs_singleton_get_mut(world, WorkerPool);
+    if (!shared || shared->users <= 0) {
+        return;
+    }
+    if (--shared->users == 0) {
+        JobPoolDestroy(shared->pool);
+        shared->pool = NULL;
+    }
+}
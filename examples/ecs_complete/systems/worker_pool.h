@@ -0,0 +1,22 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <flecs.h>
+#include "job_pool.h"
+
+// The job pool of a world, shared by every module that splits work across
+// threads (layout, lexing, include and symbol scans, search builds, fuzzy
+// scoring), so a world starts one worker per spare CPU rather than one per
+// module. A job submitted while the workers run another thread's job runs
+// inline on its caller (see JobPoolParallelFor).
+//
+// The first acquire creates the pool. Each module releases it from its own
+// fini action, after its last job, and the last release destroys it.
+
+// Returns the world's pool (NULL if it could not be created, which
+// JobPoolParallelFor treats as "run inline")
+JobPool *WorkerPoolAcquire(ecs_world_t *world);
+
+void WorkerPoolRelease(ecs_world_t *world);
+
+#endif // WORKER_POOL_H
@@ -0,0 +1,854 @@
+#define _POSIX_C_SOURCE 200809L  // fstat, mmap
+#include "workspace.h"
+#include "file_loader.h"
+#include "impostor.h"
+#include "layout.h"
+#include "memory_tracker.h"
+#include "syntax.h"
+#include "text_buffer.h"
+#include "profiler.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+ECS_COMPONENT_DECLARE(WorkspaceSettings);
+ECS_COMPONENT_DECLARE(WorkspaceStats);
+
+#define WORKSPACE_MAGIC "PVWS"
+#define WORKSPACE_BYTE_ORDER 0x01020304u
+#define WORKSPACE_RELATIONS 4
+
+enum {
+    WORKSPACE_FILE_PENDING,
+    WORKSPACE_FILE_FRESH,     // Hash matches: the validator mapped its text
+    WORKSPACE_FILE_STALE      // Changed, missing or edited when saved
+};
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t file_count;
+    uint32_t phantom_count;
+    uint32_t edge_count;
+    uint64_t string_bytes;
+    uint64_t total_bytes;     // Checked against the file size
+} SnapshotHeader;
+
+typedef struct {
+    uint64_t hash;            // Of the text the phantoms show, 0 = load again
+    uint64_t size;
+    Position position;
+    float mass;
+    uint32_t path;            // Offset in the strings
+    uint32_t first_phantom;
+    uint32_t phantom_count;
+    uint32_t reserved;
+} SnapshotFile;
+
+typedef struct {
+    uint32_t relation;        // Index in WorkspaceRelations
+    uint32_t source;          // Files first, then phantoms
+    uint32_t target;
+} SnapshotEdge;
+
+// A snapshot being written
+typedef struct {
+    SnapshotFile *files;
+    int file_count;
+    int file_capacity;
+    ecs_entity_t *file_entities;
+    int file_entity_capacity;
+    Position *positions;
+    int position_capacity;
+    int32_t *lines;
+    int line_capacity;
+    uint32_t *texts;
+    int text_capacity;
+    ecs_entity_t *phantom_entities;
+    int phantom_entity_capacity;
+    int phantom_count;
+    SnapshotEdge *edges;
+    int edge_count;
+    int edge_capacity;
+    char *strings;
+    int string_count;
+    int string_capacity;
+    uint64_t *order;          // Sorted entity index << 32 | snapshot index
+    int order_capacity;
+} SnapshotWriter;
+
+// One restored file on its way through validation
+typedef struct {
+    ecs_entity_t file;
+    const char *path;         // In the snapshot mapping
+    uint64_t hash;
+    TextBuffer buffer;        // Mapped by the validator when fresh
+    uint64_t validate_ns;
+    uint8_t state;            // WORKSPACE_FILE_*
+} WorkspaceFile;
+
+typedef struct {
+    const char *mapping;      // Snapshot being validated, NULL if none
+    size_t mapping_size;
+    WorkspaceFile *files;
+    int file_count;
+    int installed;
+    pthread_t validator;
+    bool validator_started;
+    atomic_int validated;
+    atomic_int cancel;
+} Workspace;
+
+// The load state belongs to the world that registered the module: the
+// system gets it as ctx, API calls find it through this singleton
+typedef struct {
+    Workspace *workspace;
+} WorkspaceModule;
+
+static ECS_COMPONENT_DECLARE(WorkspaceModule);
+
+static Workspace *GetWorkspace(const ecs_world_t *world) {
+    const WorkspaceModule *module = ecs_singleton_get(world, WorkspaceModule);
+    return module ? module->workspace : NULL;
+}
+
+static void WorkspaceRelations(ecs_entity_t relations[WORKSPACE_RELATIONS]) {
+    relations[0] = References;
+    relations[1] = Includes;
+    relations[2] = Imports;
+    relations[3] = Contains;
+}
+
+static uint64_t Mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ull;
+    x ^= x >> 33;
+    return x;
+}
+
+// Eight bytes per step; never 0, which marks a file to load again
+static uint64_t HashText(const char *text, size_t length) {
+    uint64_t hash = 0x9e3779b97f4a7c15ull ^ (uint64_t)length;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        uint64_t word;
+        memcpy(&word, text + i, 8);
+        hash = (hash ^ word) * 0x100000001b3ull;
+        hash ^= hash >> 29;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, text + i, length - i);
+    hash = Mix64(hash ^ tail);
+    return hash ? hash : 1;
+}
+
+// Hash of a freshly mapped file: one contiguous piece, or empty
+static uint64_t HashBuffer(const TextBuffer *buffer) {
+    size_t length;
+    const char *text = TextBufferContiguous(buffer, &length);
+    return HashText(text ? text : "", text ? length : 0);
+}
+
+// Saving
+
+static uint32_t AddString(SnapshotWriter *w, const char *text) {
+    int length = (int)strlen(text) + 1;
+    if (!GrowArray(MEMORY_TAG_IO, (void**)&w->strings, &w->string_capacity, w->string_count + length, 1)) {
+        return UINT32_MAX;
+    }
+    uint32_t offset = (uint32_t)w->string_count;
+    memcpy(w->strings + offset, text, (size_t)length);
+    w->string_count += length;
+    return offset;
+}
+
+static bool AddPhantom(SnapshotWriter *w, ecs_entity_t phantom, const Position *position,
+                       const TextContent *text, const FileReference *ref) {
+    int needed = w->phantom_count + 1;
+    uint32_t offset = AddString(w, text->text);
+    if (offset == UINT32_MAX ||
+        !GrowArray(MEMORY_TAG_IO, (void**)&w->positions, &w->position_capacity, needed, sizeof(Position)) ||
+        !GrowArray(MEMORY_TAG_IO, (void**)&w->lines, &w->line_capacity, needed, sizeof(int32_t)) ||
+        !GrowArray(MEMORY_TAG_IO, (void**)&w->texts, &w->text_capacity, needed, sizeof(uint32_t)) ||
+        !GrowArray(MEMORY_TAG_IO, (void**)&w->phantom_entities, &w->phantom_entity_capacity, needed,
+                   sizeof(ecs_entity_t))) {
+        return false;
+    }
+    w->positions[w->phantom_count] = *position;
+    w->lines[w->phantom_count] = ref->line_number;
+    w->texts[w->phantom_count] = offset;
+    w->phantom_entities[w->phantom_count] = phantom;
+    w->phantom_count++;
+    return true;
+}
+
+// The hash of the file on disk, or 0 when the phantoms show text that is
+// not on disk (unsaved edits)
+static uint64_t SavedFileHash(ecs_world_t *world, ecs_entity_t file, const char *path, uint64_t *size) {
+    TextBuffer disk;
+    *size = 0;
+    if (!TextBufferInitMapped(&disk, path)) {
+        return 0;
+    }
+    uint64_t hash = HashBuffer(&disk);
+    *size = TextBufferLength(&disk);
+    TextBufferFree(&disk);
+
+    size_t length;
+    const char *text = GetFileSyntaxText(world, ecs_get(world, file, FileSyntax), &length);
+    if (text && (length != *size || HashText(text, length) != hash)) {
+        return 0;
+    }
+    return hash;
+}
+
+static int CompareKeys(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+// Saved entities sorted by id (entity index in the high bits, snapshot
+// index in the low 32), so pair targets are found by binary search
+static bool BuildEntityOrder(SnapshotWriter *w) {
+    int count = w->file_count + w->phantom_count;
+    if (!GrowArray(MEMORY_TAG_IO, (void**)&w->order, &w->order_capacity, count, sizeof(uint64_t))) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        ecs_entity_t entity = i < w->file_count ? w->file_entities[i] : w->phantom_entities[i - w->file_count];
+        w->order[i] = ((uint64_t)(uint32_t)entity << 32) | (uint32_t)i;
+    }
+    qsort(w->order, (size_t)count, sizeof(uint64_t), CompareKeys);
+    return true;
+}
+
+static int64_t FindEntity(const SnapshotWriter *w, ecs_entity_t entity) {
+    int count = w->file_count + w->phantom_count;
+    int low = 0;
+    int high = count;
+    uint64_t key = (uint64_t)(uint32_t)entity << 32;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (w->order[mid] < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == count || (w->order[low] >> 32) != (uint32_t)entity) {
+        return -1;
+    }
+    // Ids are compared by index; the generation must match too
+    uint32_t index = (uint32_t)w->order[low];
+    ecs_entity_t found = (int)index < w->file_count ? w->file_entities[index]
+                                                    : w->phantom_entities[index - w->file_count];
+    return found == entity ? (int64_t)index : -1;
+}
+
+static bool CollectEdges(ecs_world_t *world, SnapshotWriter *w) {
+    ecs_entity_t relations[WORKSPACE_RELATIONS];
+    WorkspaceRelations(relations);
+    int count = w->file_count + w->phantom_count;
+    for (int i = 0; i < count; i++) {
+        ecs_entity_t source = i < w->file_count ? w->file_entities[i] : w->phantom_entities[i - w->file_count];
+        for (int r = 0; r < WORKSPACE_RELATIONS; r++) {
+            ecs_entity_t target;
+            for (int t = 0; (target = ecs_get_target(world, source, relations[r], t)) != 0; t++) {
+                int64_t index = FindEntity(w, target);
+                if (index < 0) {
+                    continue;  // Header entities and examples are rebuilt, not saved
+                }
+                if (!GrowArray(MEMORY_TAG_IO, (void**)&w->edges, &w->edge_capacity, w->edge_count + 1,
+                               sizeof(SnapshotEdge))) {
+                    return false;
+                }
+                w->edges[w->edge_count++] = (SnapshotEdge){(uint32_t)r, (uint32_t)i, (uint32_t)index};
+            }
+        }
+    }
+    return true;
+}
+
+static bool CollectWorkspace(ecs_world_t *world, SnapshotWriter *w) {
+    ecs_query_t *containers = ecs_query(world, {
+        .terms = {
+            { ecs_id(FileImpostor), .inout = EcsInOutNone },
+            { ecs_id(FileReference), .inout = EcsIn },
+            { ecs_id(Position), .inout = EcsIn },
+            { ecs_id(LayoutNode), .inout = EcsIn }
+        }
+    });
+    bool ok = true;
+    ecs_iter_t it = ecs_query_iter(world, containers);
+    while (ecs_query_next(&it)) {
+        const FileReference *refs = ecs_field(&it, FileReference, 1);
+        const Position *positions = ecs_field(&it, Position, 2);
+        const LayoutNode *nodes = ecs_field(&it, LayoutNode, 3);
+        for (int i = 0; i < it.count && ok; i++) {
+            ok = GrowArray(MEMORY_TAG_IO, (void**)&w->files, &w->file_capacity, w->file_count + 1,
+                           sizeof(SnapshotFile)) &&
+                 GrowArray(MEMORY_TAG_IO, (void**)&w->file_entities, &w->file_entity_capacity, w->file_count + 1,
+                           sizeof(ecs_entity_t));
+            uint32_t path = ok ? AddString(w, refs[i].filepath) : UINT32_MAX;
+            if (path == UINT32_MAX) {
+                ok = false;
+                break;
+            }
+
+            SnapshotFile *file = &w->files[w->file_count];
+            memset(file, 0, sizeof(*file));
+            file->hash = SavedFileHash(world, it.entities[i], refs[i].filepath, &file->size);
+            file->position = positions[i];
+            file->mass = nodes[i].mass;
+            file->path = path;
+            file->first_phantom = (uint32_t)w->phantom_count;
+            w->file_entities[w->file_count++] = it.entities[i];
+
+            ecs_iter_t children = ecs_children(world, it.entities[i]);
+            while (ecs_children_next(&children)) {
+                for (int c = 0; c < children.count && ok; c++) {
+                    ecs_entity_t phantom = children.entities[c];
+                    const Position *position = ecs_get(world, phantom, Position);
+                    const TextContent *text = ecs_get(world, phantom, TextContent);
+                    const FileReference *ref = ecs_get(world, phantom, FileReference);
+                    if (position && text && ref) {
+                        ok = AddPhantom(w, phantom, position, text, ref);
+                    }
+                }
+            }
+            file = &w->files[w->file_count - 1];
+            file->phantom_count = (uint32_t)w->phantom_count - file->first_phantom;
+        }
+    }
+    ecs_query_fini(containers);
+    return ok && BuildEntityOrder(w) && CollectEdges(world, w);
+}
+
+static void FreeWriter(SnapshotWriter *w) {
+    TrackedFree(MEMORY_TAG_IO, w->files);
+    TrackedFree(MEMORY_TAG_IO, w->file_entities);
+    TrackedFree(MEMORY_TAG_IO, w->positions);
+    TrackedFree(MEMORY_TAG_IO, w->lines);
+    TrackedFree(MEMORY_TAG_IO, w->texts);
+    TrackedFree(MEMORY_TAG_IO, w->phantom_entities);
+    TrackedFree(MEMORY_TAG_IO, w->edges);
+    TrackedFree(MEMORY_TAG_IO, w->strings);
+    TrackedFree(MEMORY_TAG_IO, w->order);
+}
+
+static bool WriteWorkspace(const SnapshotWriter *w, const char *path) {
+    SnapshotHeader header = {
+        .magic = {'P', 'V', 'W', 'S'},
+        .version = WORKSPACE_VERSION,
+        .byte_order = WORKSPACE_BYTE_ORDER,
+        .file_count = (uint32_t)w->file_count,
+        .phantom_count = (uint32_t)w->phantom_count,
+        .edge_count = (uint32_t)w->edge_count,
+        .string_bytes = (uint64_t)w->string_count
+    };
+    size_t phantoms = (size_t)w->phantom_count;
+    header.total_bytes = sizeof(header) + sizeof(SnapshotFile) * (size_t)w->file_count +
+                         (sizeof(Position) + sizeof(int32_t) + sizeof(uint32_t)) * phantoms +
+                         sizeof(SnapshotEdge) * (size_t)w->edge_count + (size_t)w->string_count;
+
+    char temp_path[1024];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    FILE *file = fopen(temp_path, "wb");
+    if (!file) {
+        printf("Workspace: cannot write %s\n", temp_path);
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   fwrite(w->files, sizeof(SnapshotFile), (size_t)w->file_count, file) == (size_t)w->file_count &&
+                   fwrite(w->positions, sizeof(Position), phantoms, file) == phantoms &&
+                   fwrite(w->lines, sizeof(int32_t), phantoms, file) == phantoms &&
+                   fwrite(w->texts, sizeof(uint32_t), phantoms, file) == phantoms &&
+                   fwrite(w->edges, sizeof(SnapshotEdge), (size_t)w->edge_count, file) == (size_t)w->edge_count &&
+                   fwrite(w->strings, 1, (size_t)w->string_count, file) == (size_t)w->string_count;
+    written = fclose(file) == 0 && written;
+    if (!written || rename(temp_path, path) != 0) {
+        printf("Workspace: failed writing %s\n", path);
+        remove(temp_path);
+        return false;
+    }
+    return true;
+}
+
+bool SaveWorkspaceSnapshot(ecs_world_t *world, const char *path) {
+    PROFILE_ZONE_BEGIN(SaveWorkspace);
+    uint64_t start = ProfilerNow();
+
+    // Restored files must be validated first: the hash of one that is not
+    // says nothing about its phantoms
+    WaitWorkspace(world);
+
+    SnapshotWriter w = {0};
+    bool saved = CollectWorkspace(world, &w) && WriteWorkspace(&w, path);
+    if (saved) {
+        printf("Workspace: saved %d files, %d phantoms, %d edges to %s\n",
+               w.file_count, w.phantom_count, w.edge_count, path);
+    }
+    FreeWriter(&w);
+
+    WorkspaceStats *stats = ecs_singleton_get_mut(world, WorkspaceStats);
+    if (stats) {
+        stats->save_ms = (double)(ProfilerNow() - start) / 1e6;
+    }
+    PROFILE_ZONE_END(SaveWorkspace);
+    return saved;
+}
+
+// Loading
+
+// Views of the sections of a mapped snapshot
+typedef struct {
+    const SnapshotHeader *header;
+    const SnapshotFile *files;
+    const Position *positions;
+    const int32_t *lines;
+    const uint32_t *texts;
+    const SnapshotEdge *edges;
+    const char *strings;
+} SnapshotView;
+
+// Every count, offset and index is checked before anything is created
+static bool ViewSnapshot(const char *data, size_t size, SnapshotView *view) {
+    if (size < sizeof(SnapshotHeader)) {
+        return false;
+    }
+    const SnapshotHeader *header = (const SnapshotHeader*)data;
+    if (memcmp(header->magic, WORKSPACE_MAGIC, 4) != 0 || header->version != WORKSPACE_VERSION ||
+        header->byte_order != WORKSPACE_BYTE_ORDER || header->total_bytes != size ||
+        header->file_count > size || header->phantom_count > size || header->edge_count > size) {
+        return false;
+    }
+    size_t phantoms = header->phantom_count;
+    size_t files_offset = sizeof(SnapshotHeader);
+    size_t positions_offset = files_offset + sizeof(SnapshotFile) * header->file_count;
+    size_t lines_offset = positions_offset + sizeof(Position) * phantoms;
+    size_t texts_offset = lines_offset + sizeof(int32_t) * phantoms;
+    size_t edges_offset = texts_offset + sizeof(uint32_t) * phantoms;
+    size_t strings_offset = edges_offset + sizeof(SnapshotEdge) * header->edge_count;
+    if (strings_offset > size || size - strings_offset != header->string_bytes ||
+        (header->string_bytes > 0 && data[size - 1] != '\0')) {
+        return false;
+    }
+
+    view->header = header;
+    view->files = (const SnapshotFile*)(data + files_offset);
+    view->positions = (const Position*)(data + positions_offset);
+    view->lines = (const int32_t*)(data + lines_offset);
+    view->texts = (const uint32_t*)(data + texts_offset);
+    view->edges = (const SnapshotEdge*)(data + edges_offset);
+    view->strings = data + strings_offset;
+
+    uint64_t strings = header->string_bytes;
+    for (uint32_t f = 0; f < header->file_count; f++) {
+        const SnapshotFile *file = &view->files[f];
+        if (file->path >= strings || file->first_phantom > phantoms ||
+            file->phantom_count > phantoms - file->first_phantom) {
+            return false;
+        }
+    }
+    for (size_t p = 0; p < phantoms; p++) {
+        if (view->texts[p] >= strings) {
+            return false;
+        }
+    }
+    uint64_t entities = (uint64_t)header->file_count + phantoms;
+    for (uint32_t e = 0; e < header->edge_count; e++) {
+        const SnapshotEdge *edge = &view->edges[e];
+        if (edge->relation >= WORKSPACE_RELATIONS || edge->source >= entities || edge->target >= entities) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Component arrays for one bulk insert, grown to the largest file
+typedef struct {
+    Rotation *rotations;
+    Scale *scales;
+    EcsTransform *transforms;
+    BoundingSphere *spheres;
+    TextContent *texts;
+    FileReference *refs;
+    int capacity;
+} PhantomBatch;
+
+static bool GrowBatch(PhantomBatch *batch, int count) {
+    if (count <= batch->capacity) {
+        return true;
+    }
+    int old = batch->capacity;
+    int capacity = old;
+    if (!GrowArray(MEMORY_TAG_IO, (void**)&batch->rotations, &capacity, count, sizeof(Rotation))) {
+        return false;
+    }
+    // The other arrays follow the first one's capacity. Each one is stored
+    // back as soon as it moves, so a later failure leaves the batch valid.
+    void **arrays[] = {
+        (void**)&batch->scales, (void**)&batch->transforms, (void**)&batch->spheres,
+        (void**)&batch->texts, (void**)&batch->refs
+    };
+    size_t sizes[] = {sizeof(Scale), sizeof(EcsTransform), sizeof(BoundingSphere), sizeof(TextContent), sizeof(FileReference)};
+    for (int a = 0; a < 5; a++) {
+        void *grown = TrackedRealloc(MEMORY_TAG_IO, *arrays[a], sizes[a] * (size_t)capacity);
+        if (!grown) {
+            printf("Workspace: out of memory growing to %d elements\n", capacity);
+            return false;
+        }
+        *arrays[a] = grown;
+    }
+
+    // The same values CreatePhantomFromLine sets
+    for (int i = old; i < capacity; i++) {
+        batch->rotations[i] = (Rotation){0.0f, 0.0f, 0.0f, 1.0f};
+        batch->scales[i] = (Scale){1.0f, 1.0f, 1.0f};
+        batch->transforms[i] = (EcsTransform){.needs_update = true};
+        batch->spheres[i] = (BoundingSphere){0.5f, {0.0f, 0.0f, 0.0f}};
+    }
+    batch->capacity = capacity;
+    return true;
+}
+
+static void FreeBatch(PhantomBatch *batch) {
+    TrackedFree(MEMORY_TAG_IO, batch->rotations);
+    TrackedFree(MEMORY_TAG_IO, batch->scales);
+    TrackedFree(MEMORY_TAG_IO, batch->transforms);
+    TrackedFree(MEMORY_TAG_IO, batch->spheres);
+    TrackedFree(MEMORY_TAG_IO, batch->texts);
+    TrackedFree(MEMORY_TAG_IO, batch->refs);
+}
+
+// The phantoms of one file in one bulk insert. Positions are read from the
+// mapping as they are.
+static bool InsertPhantoms(ecs_world_t *world, const SnapshotView *view, const SnapshotFile *file,
+                           ecs_entity_t container, PhantomBatch *batch, ecs_entity_t *out) {
+    int count = (int)file->phantom_count;
+    if (count == 0) {
+        return true;
+    }
+    if (!GrowBatch(batch, count)) {
+        return false;
+    }
+    const char *path = view->strings + file->path;
+    time_t now = time(NULL);
+    for (int i = 0; i < count; i++) {
+        uint32_t p = file->first_phantom + (uint32_t)i;
+        TextContent *text = &batch->texts[i];
+        text->font_size = 1.0f;
+        text->color = WHITE;
+        text->billboard_mode = false;
+        strncpy(text->text, view->strings + view->texts[p], sizeof(text->text) - 1);
+        text->text[sizeof(text->text) - 1] = '\0';
+
+        FileReference *ref = &batch->refs[i];
+        ref->line_number = view->lines[p];
+        ref->last_modified = now;
+        strncpy(ref->filepath, path, sizeof(ref->filepath) - 1);
+        ref->filepath[sizeof(ref->filepath) - 1] = '\0';
+    }
+
+    void *data[] = {
+        NULL,
+        (void*)(view->positions + file->first_phantom),
+        batch->rotations,
+        batch->scales,
+        batch->transforms,
+        batch->texts,
+        batch->refs,
+        batch->spheres,
+        NULL
+    };
+    const ecs_entity_t *created = ecs_bulk_init(world, &(ecs_bulk_desc_t){
+        .count = count,
+        .ids = {
+            ecs_childof(container),
+            ecs_id(Position),
+            ecs_id(Rotation),
+            ecs_id(Scale),
+            ecs_id(EcsTransform),
+            ecs_id(TextContent),
+            ecs_id(FileReference),
+            ecs_id(BoundingSphere),
+            Visible
+        },
+        .data = data
+    });
+    if (!created) {
+        return false;
+    }
+    memcpy(out, created, sizeof(ecs_entity_t) * (size_t)count);
+    return true;
+}
+
+// Background validation
+
+static void *WorkspaceValidatorMain(void *arg) {
+    Workspace *workspace = arg;
+    for (int i = 0; i < workspace->file_count && !atomic_load(&workspace->cancel); i++) {
+        WorkspaceFile *file = &workspace->files[i];
+        uint64_t start = ProfilerNow();
+        bool fresh = false;
+        if (file->hash != 0 && TextBufferInitMapped(&file->buffer, file->path)) {
+            fresh = HashBuffer(&file->buffer) == file->hash;
+            if (!fresh) {
+                TextBufferFree(&file->buffer);
+            }
+        }
+        file->state = fresh ? WORKSPACE_FILE_FRESH : WORKSPACE_FILE_STALE;
+        file->validate_ns = ProfilerNow() - start;
+        atomic_store(&workspace->validated, i + 1);
+    }
+    return NULL;
+}
+
+static void ReleaseWorkspace(Workspace *workspace) {
+    if (workspace->validator_started) {
+        atomic_store(&workspace->cancel, 1);
+        pthread_join(workspace->validator, NULL);
+        workspace->validator_started = false;
+    }
+    for (int i = 0; i < workspace->file_count; i++) {
+        TextBufferFree(&workspace->files[i].buffer);
+    }
+    TrackedFree(MEMORY_TAG_IO, workspace->files);
+    if (workspace->mapping) {
+        munmap((void*)workspace->mapping, workspace->mapping_size);
+        MemoryTrackExternal(MEMORY_TAG_FILES, -(int64_t)workspace->mapping_size);
+    }
+    memset(workspace, 0, sizeof(*workspace));
+}
+
+// A fresh file takes the validated mapping as its text; a stale one is
+// loaded from disk again where its container is now
+static void InstallFile(ecs_world_t *world, WorkspaceFile *file, WorkspaceStats *stats) {
+    stats->validate_ms += (double)file->validate_ns / 1e6;
+    if (!ecs_is_alive(world, file->file)) {
+        TextBufferFree(&file->buffer);
+        return;
+    }
+    if (file->state == WORKSPACE_FILE_FRESH) {
+        AttachFileSyntaxBuffer(world, file->file, &file->buffer);
+        return;
+    }
+    const Position *position = ecs_get(world, file->file, Position);
+    Vector3 start = position ? (Vector3){position->x, position->y, position->z} : (Vector3){0.0f, 0.0f, 0.0f};
+    ecs_delete(world, file->file);
+    LoadFileAsPhantoms(world, file->path, start);
+    stats->stale++;
+}
+
+static void InstallValidated(ecs_world_t *world, Workspace *workspace, double budget_ms) {
+    if (!workspace->files) {
+        return;
+    }
+    PROFILE_ZONE_BEGIN(InstallWorkspace);
+    uint64_t start = ProfilerNow();
+    WorkspaceStats *stats = ecs_singleton_get_mut(world, WorkspaceStats);
+    int validated = atomic_load(&workspace->validated);
+    int installed = 0;
+    while (workspace->installed < validated) {
+        if (installed > 0 && budget_ms >= 0.0 && (double)(ProfilerNow() - start) / 1e6 > budget_ms) {
+            break;
+        }
+        InstallFile(world, &workspace->files[workspace->installed++], stats);
+        installed++;
+    }
+    stats->validated = validated;
+    stats->installed = workspace->installed;
+    if (workspace->installed == workspace->file_count) {
+        ReleaseWorkspace(workspace);
+        stats->validating = false;
+        printf("Workspace: validated %d files, %d loaded again\n", stats->installed, stats->stale);
+    }
+    PROFILE_ZONE_END(InstallWorkspace);
+}
+
+void UpdateWorkspace(ecs_world_t *world) {
+    Workspace *workspace = GetWorkspace(world);
+    const WorkspaceSettings *settings = ecs_singleton_get(world, WorkspaceSettings);
+    if (workspace) {
+        InstallValidated(world, workspace, settings ? settings->install_budget_ms : 0.0);
+    }
+}
+
+void WaitWorkspace(ecs_world_t *world) {
+    Workspace *workspace = GetWorkspace(world);
+    if (!workspace) {
+        return;
+    }
+    if (workspace->validator_started) {
+        pthread_join(workspace->validator, NULL);
+        workspace->validator_started = false;
+    }
+    InstallValidated(world, workspace, -1.0);
+}
+
+int LoadWorkspaceSnapshot(ecs_world_t *world, const char *path) {
+    Workspace *workspace = GetWorkspace(world);
+    if (!workspace) {
+        return -1;
+    }
+    WaitWorkspace(world);
+    PROFILE_ZONE_BEGIN(LoadWorkspace);
+    uint64_t start = ProfilerNow();
+
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size <= 0) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        PROFILE_ZONE_END(LoadWorkspace);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    void *mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    SnapshotView view;
+    if (mapped == MAP_FAILED || !ViewSnapshot(mapped, size, &view)) {
+        printf("Workspace: %s is not a valid snapshot\n", path);
+        if (mapped != MAP_FAILED) {
+            munmap(mapped, size);
+        }
+        PROFILE_ZONE_END(LoadWorkspace);
+        return -1;
+    }
+    double map_ms = (double)(ProfilerNow() - start) / 1e6;
+
+    int file_count = (int)view.header->file_count;
+    size_t entity_count = (size_t)file_count + view.header->phantom_count;
+    ecs_entity_t *entities = TrackedMalloc(MEMORY_TAG_IO, sizeof(ecs_entity_t) * (entity_count > 0 ? entity_count : 1));
+    workspace->files = TrackedCalloc(MEMORY_TAG_IO, (size_t)(file_count > 0 ? file_count : 1), sizeof(WorkspaceFile));
+    if (!entities || !workspace->files) {
+        printf("Workspace: out of memory restoring %zu entities\n", entity_count);
+        TrackedFree(MEMORY_TAG_IO, entities);
+        TrackedFree(MEMORY_TAG_IO, workspace->files);
+        workspace->files = NULL;
+        munmap(mapped, size);
+        PROFILE_ZONE_END(LoadWorkspace);
+        return -1;
+    }
+    workspace->mapping = mapped;
+    workspace->mapping_size = size;
+    MemoryTrackExternal(MEMORY_TAG_FILES, (int64_t)size);
+    workspace->file_count = file_count;
+
+    // Containers are few and keep their usual setup; their phantoms go in
+    // one bulk insert each
+    uint64_t insert_start = ProfilerNow();
+    PhantomBatch batch = {0};
+    int phantoms = 0;
+    for (int f = 0; f < file_count; f++) {
+        const SnapshotFile *file = &view.files[f];
+        const char *file_path = view.strings + file->path;
+        Vector3 position = {file->position.x, file->position.y, file->position.z};
+        ecs_entity_t container = CreateFileContainer(world, file_path, position);
+        if (file->mass != 0.0f) {
+            ecs_set(world, container, LayoutNode, {file->mass});
+        }
+        entities[f] = container;
+        workspace->files[f] = (WorkspaceFile){.file = container, .path = file_path, .hash = file->hash};
+        if (InsertPhantoms(world, &view, file, container, &batch, entities + file_count + file->first_phantom)) {
+            phantoms += (int)file->phantom_count;
+        } else {
+            // The file is loaded again from disk instead
+            printf("Workspace: could not restore the phantoms of %s\n", file_path);
+            workspace->files[f].hash = 0;
+            for (uint32_t p = 0; p < file->phantom_count; p++) {
+                entities[file_count + file->first_phantom + p] = 0;
+            }
+        }
+    }
+    FreeBatch(&batch);
+
+    ecs_entity_t relations[WORKSPACE_RELATIONS];
+    WorkspaceRelations(relations);
+    for (uint32_t e = 0; e < view.header->edge_count; e++) {
+        const SnapshotEdge *edge = &view.edges[e];
+        if (entities[edge->source] && entities[edge->target]) {
+            ecs_add_pair(world, entities[edge->source], relations[edge->relation], entities[edge->target]);
+        }
+    }
+    TrackedFree(MEMORY_TAG_IO, entities);
+    double insert_ms = (double)(ProfilerNow() - insert_start) / 1e6;
+
+    atomic_store(&workspace->validated, 0);
+    atomic_store(&workspace->cancel, 0);
+    workspace->validator_started = pthread_create(&workspace->validator, NULL, WorkspaceValidatorMain, workspace) == 0;
+    if (!workspace->validator_started) {
+        printf("Workspace: no validator thread, validating %d files inline\n", file_count);
+        WorkspaceValidatorMain(workspace);
+    }
+
+    WorkspaceStats *stats = ecs_singleton_get_mut(world, WorkspaceStats);
+    stats->files = file_count;
+    stats->phantoms = phantoms;
+    stats->edges = (int32_t)view.header->edge_count;
+    stats->bytes = (int64_t)size;
+    stats->map_ms = map_ms;
+    stats->insert_ms = insert_ms;
+    stats->validated = 0;
+    stats->installed = 0;
+    stats->stale = 0;
+    stats->validate_ms = 0.0;
+    stats->validating = true;
+    printf("Workspace: restored %d files, %d phantoms from %s in %.1f ms\n",
+           file_count, phantoms, path, map_ms + insert_ms);
+    PROFILE_ZONE_END(LoadWorkspace);
+    return phantoms;
+}
+
+// Validated files are installed at the start of the frame
+void WorkspaceSystem(ecs_iter_t *it) {
+    const WorkspaceSettings *settings = ecs_singleton_get(it->world, WorkspaceSettings);
+    InstallValidated(it->world, it->ctx, settings ? settings->install_budget_ms : 0.0);
+}
+
+static void WorkspaceFini(ecs_world_t *world, void *ctx) {
+    (void)world;
+    Workspace *workspace = ctx;
+    ReleaseWorkspace(workspace);
+    TrackedFree(MEMORY_TAG_IO, workspace);
+}
+
+void RegisterWorkspace(ecs_world_t *world) {
+    ECS_COMPONENT_DEFINE(world, WorkspaceSettings);
+    ECS_COMPONENT_DEFINE(world, WorkspaceStats);
+    ECS_COMPONENT_DEFINE(world, WorkspaceModule);
+
+    ecs_singleton_set(world, WorkspaceSettings, {
+        .install_budget_ms = 4.0f
+    });
+    ecs_singleton_set(world, WorkspaceStats, {0});
+
+    Workspace *workspace = TrackedCalloc(MEMORY_TAG_IO, 1, sizeof(Workspace));
+    if (!workspace) {
+        printf("Workspace: out of memory\n");
+        return;
+    }
+    ecs_singleton_set(world, WorkspaceModule, {workspace});
+    ecs_atfini(world, WorkspaceFini, workspace);
+
+    ecs_system(world, {
+        .entity = ecs_entity(world, {
+            .name = "WorkspaceSystem",
+            .add = ecs_ids(ecs_dependson(EcsPostLoad))
+        }),
+        .callback = WorkspaceSystem,
+        .ctx = workspace
+    });
+}
@@ -0,0 +1,74 @@
+#ifndef WORKSPACE_H
+#define WORKSPACE_H
+
+#include <flecs.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "../components/spatial.h"
+
+// Binary workspace snapshot for instant reopen.
+//
+// A snapshot holds what loading a project rebuilds from scratch: the file
+// containers (path, laid-out position, layout mass, content hash), their
+// line phantoms (position, line number, displayed text) and the
+// References / Includes / Imports / Contains pairs between them. Phantoms
+// are stored as arrays, so reopening maps the file and creates each
+// file's phantoms with one bulk insert instead of one CreatePhantomFromLine
+// per line.
+//
+// Restored files have no text yet. A background thread maps each file and
+// hashes it: a file whose hash still matches gets the mapping as its text
+// (and is lexed, which fills in spans, symbols and search), a changed or
+// missing file is loaded again from disk. Results are installed a few
+// files per frame under a time budget.
+//
+// File layout (native byte order, rejected if it differs):
+//     header, file records, phantom positions, phantom lines, phantom text
+//     offsets, edges, string bytes (NUL-terminated paths and line texts)
+
+#define WORKSPACE_VERSION 1
+
+typedef struct {
+    float install_budget_ms;  // Validated files installed per frame (at least one)
+} WorkspaceSettings;
+
+typedef struct {
+    int32_t files;            // Restored from the last snapshot
+    int32_t phantoms;
+    int32_t edges;
+    int64_t bytes;            // Snapshot size
+    double map_ms;            // Open, map and check the snapshot
+    double insert_ms;         // Create containers, phantoms and pairs
+    double save_ms;           // Last save
+
+    int32_t validated;        // Files hashed by the background thread
+    int32_t installed;        // Validated files whose result is applied
+    int32_t stale;            // Files changed since the snapshot, loaded again
+    double validate_ms;       // Background hashing time so far
+    bool validating;
+} WorkspaceStats;
+
+extern ECS_COMPONENT_DECLARE(WorkspaceSettings);
+extern ECS_COMPONENT_DECLARE(WorkspaceStats);
+
+// Write the file containers and line phantoms of the world to path
+// (through a temporary file renamed over it). Returns false on failure.
+bool SaveWorkspaceSnapshot(ecs_world_t *world, const char *path);
+
+// Restore a snapshot into the world and start validating its files.
+// Returns the number of phantoms restored, -1 if the file is missing or
+// not a valid snapshot (nothing is created then).
+int LoadWorkspaceSnapshot(ecs_world_t *world, const char *path);
+
+// Install validated files within the frame budget
+void UpdateWorkspace(ecs_world_t *world);
+
+// Block until every restored file is validated and installed
+void WaitWorkspace(ecs_world_t *world);
+
+// Systems
+void WorkspaceSystem(ecs_iter_t *it);
+
+void RegisterWorkspace(ecs_world_t *world);
+
+#endif // WORKSPACE_H
@@ -0,0 +1,41 @@
+#include "world_stats.h"
+#include <stddef.h>
+#include <stdio.h>
+
+ECS_COMPONENT_DECLARE(WorldStats);
+
+void OnWorldStatsCounter(ecs_iter_t *it) {
+    WorldStats *stats = ecs_singleton_get_mut(it->world, WorldStats);
+    if (!stats) {
+        return; // Singleton already gone during world teardown
+    }
+
+    int32_t *counter = (int32_t*)((char*)stats + (size_t)it->ctx);
+    if (it->event == EcsOnAdd) {
+        *counter += it->count;
+    } else {
+        *counter -= it->count;
+    }
+}
+
+static void ObserveCounter(ecs_world_t *world, ecs_id_t id, size_t counter_offset) {
+    ecs_observer_desc_t desc = {0};
+    desc.query.terms[0].id = id;
+    desc.query.terms[0].src.id = EcsSelf;  // Inherited prefab data is not counted
+    desc.events[0] = EcsOnAdd;
+    desc.events[1] = EcsOnRemove;
+    desc.callback = OnWorldStatsCounter;
+    desc.ctx = (void*)counter_offset;
+    desc.yield_existing = true;
+    ecs_observer_init(world, &desc);
+}
+
+void RegisterWorldStats(ecs_world_t *world) {
+    ECS_COMPONENT_DEFINE(world, WorldStats);
+    ecs_singleton_set(world, WorldStats, {0});
+
+    ObserveCounter(world, ecs_id(Position), offsetof(WorldStats, spatial_count));
+    ObserveCounter(world, ecs_id(TextContent), offsetof(WorldStats, text_count));
+    ObserveCounter(world, Visible, offsetof(WorldStats, visible_count));
+    ObserveCounter(world, ecs_id(Selected), offsetof(WorldStats, selected_count));
+}
@@ -0,0 +1,24 @@
+#ifndef WORLD_STATS_H
+#define WORLD_STATS_H
+
+#include <flecs.h>
+#include "../components/spatial.h"
+
+// Incrementally maintained world counters. Observers update them on
+// add/remove, so reading them costs O(1) regardless of world size.
+typedef struct {
+    int32_t spatial_count;   // Entities owning a Position
+    int32_t text_count;      // Entities owning a TextContent (phantoms, labels)
+    int32_t visible_count;   // Entities tagged Visible by the culling output
+    int32_t selected_count;  // Entities owning a Selected component
+} WorldStats;
+
+extern ECS_COMPONENT_DECLARE(WorldStats);
+
+// Observer callback shared by all counters (counter offset passed as ctx)
+void OnWorldStatsCounter(ecs_iter_t *it);
+
+// Must be called before entities are created so no add is missed
+void RegisterWorldStats(ecs_world_t *world);
+
+#endif // WORLD_STATS_H
@@ -1,42 +1,291 @@
+#define _POSIX_C_SOURCE 200809L  // uv.h needs pthread_rwlock_t
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
 #include <uv.h>
 
+// Echo server with pooled buffers and batched writes, plus a loopback load
+// test.
+//
+//     libuv_example                                  echo server on port 8000
+//     libuv_example --load [CONNECTIONS] [SECONDS] [DEPTH] [--naive]
+//
+// Read buffers, write requests and clients come from slab pools, so a
+// connected client costs no malloc per message. Data read from a client is
+// queued and written back once per loop iteration: small reads are copied
+// into the last queued buffer, and one uv_write carries up to
+// MAX_WRITE_BUFS buffers. --naive switches to a malloc per read and per
+// write, for comparison.
+
 #define DEFAULT_PORT 8000
-#define DEFAULT_BACKLOG 128
+#define DEFAULT_BACKLOG 1024
+
+#define BUFFER_SIZE 16384         // Bytes per pooled read buffer
+#define BUFFERS_PER_SLAB 64
+#define REQUESTS_PER_SLAB 64
+#define CLIENTS_PER_SLAB 64
+#define MAX_WRITE_BUFS 4          // libuv keeps up to 4 buffers inside the request; more are malloc'd
+
+#define LOAD_CONNECTIONS 1000
+#define LOAD_SECONDS 5
+#define LOAD_WARMUP_MS 1000
+#define LOAD_DEPTH 4              // Messages in flight per connection
+#define LOAD_MAX_DEPTH 64
+#define LOAD_MESSAGE_SIZE 64
+#define LOAD_MAX_SAMPLES (1 << 22)
 
 uv_loop_t *loop;
 struct sockaddr_in addr;
 
+// Fixed-size objects carved from slabs; slabs are kept until the pool is
+// destroyed, so a warmed-up pool never calls malloc
+typedef struct pool_item {
+    struct pool_item *next;
+} pool_item;
+
+typedef struct {
+    size_t item_size;
+    int items_per_slab;
+    pool_item *free_list;
+    void **slabs;
+    int slab_count;
+    int slab_capacity;
+    int in_use;
+    int peak;
+} pool;
+
+typedef struct client {
+    uv_tcp_t handle;              // First member: a handle pointer is its client
+    uv_buf_t pending[MAX_WRITE_BUFS];
+    int pending_count;
+    struct client *next_dirty;
+    bool dirty;                   // In the dirty list, flushed by the check handle
+} client;
+
+typedef struct {
+    uv_write_t req;
+    uv_buf_t bufs[MAX_WRITE_BUFS];
+    int count;
+} write_batch;
+
+typedef struct {
+    uint64_t reads;
+    uint64_t bytes;
+    uint64_t writes;              // uv_write calls
+    uint64_t write_bufs;          // Buffers passed to them
+    uint64_t mallocs;             // Per-message mallocs (naive) or slab growths (pooled)
+    int clients;
+} server_stats;
+
+static bool naive = false;
+static pool buffer_pool;
+static pool request_pool;
+static pool client_pool;
+static client *dirty_clients = NULL;
+static uv_check_t flush_check;
+static server_stats stats;
+
+void pool_init(pool *p, size_t item_size, int items_per_slab) {
+    memset(p, 0, sizeof(*p));
+    p->item_size = item_size < sizeof(pool_item) ? sizeof(pool_item) : item_size;
+    p->items_per_slab = items_per_slab;
+}
+
+void *pool_get(pool *p) {
+    if (!p->free_list) {
+        if (p->slab_count == p->slab_capacity) {
+            int capacity = p->slab_capacity > 0 ? p->slab_capacity * 2 : 16;
+            void **slabs = realloc(p->slabs, sizeof(void*) * capacity);
+            if (!slabs) {
+                return NULL;
+            }
+            p->slabs = slabs;
+            p->slab_capacity = capacity;
+        }
+        char *slab = malloc(p->item_size * p->items_per_slab);
+        if (!slab) {
+            return NULL;
+        }
+        p->slabs[p->slab_count++] = slab;
+        stats.mallocs++;
+        for (int i = p->items_per_slab - 1; i >= 0; i--) {
+            pool_item *item = (pool_item*)(slab + p->item_size * i);
+            item->next = p->free_list;
+            p->free_list = item;
+        }
+    }
+    pool_item *item = p->free_list;
+    p->free_list = item->next;
+    if (++p->in_use > p->peak) {
+        p->peak = p->in_use;
+    }
+    return item;
+}
+
+void pool_put(pool *p, void *ptr) {
+    pool_item *item = ptr;
+    item->next = p->free_list;
+    p->free_list = item;
+    p->in_use--;
+}
+
+void pool_destroy(pool *p) {
+    for (int i = 0; i < p->slab_count; i++) {
+        free(p->slabs[i]);
+    }
+    free(p->slabs);
+    memset(p, 0, sizeof(*p));
+}
+
 void on_close(uv_handle_t* handle) {
+    client *c = (client*)handle;
+    for (int i = 0; i < c->pending_count; i++) {
+        pool_put(&buffer_pool, c->pending[i].base);
+    }
+    stats.clients--;
+    pool_put(&client_pool, c);
+}
+
+void on_close_naive(uv_handle_t* handle) {
+    stats.clients--;
     free(handle);
 }
 
 void alloc_buffer(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf) {
-    buf->base = malloc(suggested_size);
-    buf->len = suggested_size;
+    if (naive) {
+        buf->base = malloc(suggested_size);
+        buf->len = buf->base ? suggested_size : 0;
+        stats.mallocs++;
+        return;
+    }
+    buf->base = pool_get(&buffer_pool);
+    buf->len = buf->base ? BUFFER_SIZE : 0;
 }
 
 void echo_write(uv_write_t *req, int status) {
-    if (status) {
+    if (status && status != UV_ECANCELED) {
         fprintf(stderr, "Write error %s\n", uv_strerror(status));
     }
-    free(req);
+    if (naive) {
+        free(req->data);
+        free(req);
+        return;
+    }
+    write_batch *batch = (write_batch*)req;
+    for (int i = 0; i < batch->count; i++) {
+        pool_put(&buffer_pool, batch->bufs[i].base);
+    }
+    pool_put(&request_pool, batch);
 }
 
-void echo_read(uv_stream_t *client, ssize_t nread, const uv_buf_t *buf) {
-    if (nread < 0) {
-        if (nread != UV_EOF)
-            fprintf(stderr, "Read error %s\n", uv_err_name(nread));
-        uv_close((uv_handle_t*) client, on_close);
-    } else if (nread > 0) {
-        uv_write_t *req = malloc(sizeof(uv_write_t));
-        uv_buf_t wrbuf = uv_buf_init(buf->base, nread);
-        uv_write(req, client, &wrbuf, 1, echo_write);
+// One uv_write with everything queued for the client
+void flush_client(client *c) {
+    if (c->pending_count == 0) {
+        return;
+    }
+    write_batch *batch = pool_get(&request_pool);
+    if (!batch) {
+        // Drop the queued echo so pending never stays full
+        for (int i = 0; i < c->pending_count; i++) {
+            pool_put(&buffer_pool, c->pending[i].base);
+        }
+        c->pending_count = 0;
+        uv_close((uv_handle_t*)c, on_close);
+        return;
+    }
+    memcpy(batch->bufs, c->pending, sizeof(uv_buf_t) * c->pending_count);
+    batch->count = c->pending_count;
+    c->pending_count = 0;
+    stats.writes++;
+    stats.write_bufs += batch->count;
+    if (uv_write(&batch->req, (uv_stream_t*)c, batch->bufs, batch->count, echo_write) < 0) {
+        echo_write(&batch->req, UV_ECANCELED);
+        uv_close((uv_handle_t*)c, on_close);
+    }
+}
+
+// Runs after the poll phase: every client read from in this iteration gets
+// one write. Clients closed meanwhile are only closed once callbacks of
+// this phase are done, so they are still valid here.
+void flush_dirty_clients(uv_check_t *handle) {
+    client *c = dirty_clients;
+    dirty_clients = NULL;
+    while (c) {
+        client *next = c->next_dirty;
+        c->dirty = false;
+        c->next_dirty = NULL;
+        if (!uv_is_closing((uv_handle_t*)c)) {
+            flush_client(c);
+        }
+        c = next;
     }
+}
 
-    if (buf->base)
+// Small reads are appended to the last queued buffer; a read that does not
+// fit is queued as it is, without a copy
+void queue_echo(client *c, const uv_buf_t *buf, size_t nread) {
+    uv_buf_t *last = c->pending_count > 0 ? &c->pending[c->pending_count - 1] : NULL;
+    if (last && last->len + nread <= BUFFER_SIZE) {
+        memcpy(last->base + last->len, buf->base, nread);
+        last->len += nread;
+        pool_put(&buffer_pool, buf->base);
+    } else {
+        if (c->pending_count == MAX_WRITE_BUFS) {
+            flush_client(c);
+        }
+        if (uv_is_closing((uv_handle_t*)c)) {
+            pool_put(&buffer_pool, buf->base);
+            return;
+        }
+        c->pending[c->pending_count++] = uv_buf_init(buf->base, (unsigned int)nread);
+    }
+    if (!c->dirty) {
+        c->dirty = true;
+        c->next_dirty = dirty_clients;
+        dirty_clients = c;
+    }
+}
+
+void echo_read(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
+    if (nread > 0) {
+        stats.reads++;
+        stats.bytes += (uint64_t)nread;
+    }
+    if (naive) {
+        if (nread < 0) {
+            if (nread != UV_EOF && nread != UV_ECONNRESET)
+                fprintf(stderr, "Read error %s\n", uv_err_name(nread));
+            uv_close((uv_handle_t*) stream, on_close_naive);
+        } else if (nread > 0) {
+            uv_write_t *req = malloc(sizeof(uv_write_t));
+            stats.mallocs++;
+            req->data = buf->base;  // Freed once written
+            uv_buf_t wrbuf = uv_buf_init(buf->base, nread);
+            stats.writes++;
+            stats.write_bufs++;
+            uv_write(req, stream, &wrbuf, 1, echo_write);
+            return;
+        }
         free(buf->base);
+        return;
+    }
+
+    client *c = (client*)stream;
+    if (nread > 0) {
+        queue_echo(c, buf, (size_t)nread);
+        return;
+    }
+    if (buf->base) {
+        pool_put(&buffer_pool, buf->base);
+    }
+    if (nread < 0) {
+        if (nread != UV_EOF && nread != UV_ECONNRESET)
+            fprintf(stderr, "Read error %s\n", uv_err_name(nread));
+        uv_close((uv_handle_t*) stream, on_close);
+    }
 }
 
 void on_new_connection(uv_stream_t *server, int status) {
@@ -45,17 +294,343 @@ void on_new_connection(uv_stream_t *server, int status) {
         return;
     }
 
-    uv_tcp_t *client = malloc(sizeof(uv_tcp_t));
-    uv_tcp_init(loop, client);
-    if (uv_accept(server, (uv_stream_t*) client) == 0) {
-        uv_read_start((uv_stream_t*) client, alloc_buffer, echo_read);
+    uv_tcp_t *handle;
+    if (naive) {
+        handle = calloc(1, sizeof(uv_tcp_t));
+        stats.mallocs++;
+    } else {
+        client *c = pool_get(&client_pool);
+        if (c) {
+            memset(c, 0, sizeof(*c));
+        }
+        handle = (uv_tcp_t*)c;
+    }
+    if (!handle) {
+        return;
+    }
+    stats.clients++;
+    uv_tcp_init(server->loop, handle);
+    uv_tcp_nodelay(handle, 1);
+    if (uv_accept(server, (uv_stream_t*) handle) == 0) {
+        uv_read_start((uv_stream_t*) handle, alloc_buffer, echo_read);
     } else {
-        uv_close((uv_handle_t*) client, on_close);
+        uv_close((uv_handle_t*) handle, naive ? on_close_naive : on_close);
     }
 }
 
-int main() {
+void server_init(uv_loop_t *server_loop) {
+    pool_init(&buffer_pool, BUFFER_SIZE, BUFFERS_PER_SLAB);
+    pool_init(&request_pool, sizeof(write_batch), REQUESTS_PER_SLAB);
+    pool_init(&client_pool, sizeof(client), CLIENTS_PER_SLAB);
+    uv_check_init(server_loop, &flush_check);
+    uv_check_start(&flush_check, flush_dirty_clients);
+}
+
+void server_destroy(void) {
+    pool_destroy(&buffer_pool);
+    pool_destroy(&request_pool);
+    pool_destroy(&client_pool);
+}
+
+// Load test
+
+// One connection of the load generator; every slot is a message in flight
+typedef struct {
+    uv_tcp_t handle;
+    uv_connect_t connect;
+    uv_write_t writes[LOAD_MAX_DEPTH];
+    char messages[LOAD_MAX_DEPTH][LOAD_MESSAGE_SIZE];
+    bool writing[LOAD_MAX_DEPTH];   // uv_write of the slot not completed yet
+    bool echoed[LOAD_MAX_DEPTH];    // Echo arrived before the write completed
+    char received[LOAD_MESSAGE_SIZE];
+    size_t received_length;
+    uint32_t next_slot;             // Slot of the next echo to arrive
+    bool connected;
+} load_connection;
+
+typedef struct {
+    uv_loop_t loop;
+    uv_tcp_t server;
+    uv_async_t stop;
+    uv_thread_t thread;
+    int port;
+} load_server;
+
+static struct {
+    load_connection *connections;
+    int connection_count;
+    int depth;
+    int connected;
+    int closed;
+    bool sending;
+    bool measuring;
+    uint64_t received;             // Echoes in the measured window
+    uint64_t *samples;             // Round trip times in ns
+    int sample_count;
+    uint64_t errors;
+    uint64_t mallocs_before;       // Server mallocs when measuring started
+} load;
+
+static void load_send(load_connection *conn, int slot);
+
+static void load_on_write(uv_write_t *req, int status) {
+    load_connection *conn = req->data;
+    int slot = (int)(req - conn->writes);
+    conn->writing[slot] = false;
+    if (status < 0) {
+        load.errors++;
+        return;
+    }
+    if (conn->echoed[slot]) {
+        conn->echoed[slot] = false;
+        load_send(conn, slot);
+    }
+}
+
+static void load_send(load_connection *conn, int slot) {
+    if (!load.sending) {
+        return;
+    }
+    uint64_t now = uv_hrtime();
+    memcpy(conn->messages[slot], &now, sizeof(now));
+    uv_buf_t buf = uv_buf_init(conn->messages[slot], LOAD_MESSAGE_SIZE);
+    conn->writes[slot].data = conn;
+    conn->writing[slot] = true;
+    if (uv_write(&conn->writes[slot], (uv_stream_t*)&conn->handle, &buf, 1, load_on_write) < 0) {
+        conn->writing[slot] = false;
+        load.errors++;
+    }
+}
+
+static void load_alloc(uv_handle_t *handle, size_t suggested_size, uv_buf_t *buf) {
+    load_connection *conn = (load_connection*)handle;
+    buf->base = conn->received + conn->received_length;
+    buf->len = LOAD_MESSAGE_SIZE - conn->received_length;
+}
+
+static void load_on_read(uv_stream_t *stream, ssize_t nread, const uv_buf_t *buf) {
+    load_connection *conn = (load_connection*)stream;
+    if (nread < 0) {
+        if (nread != UV_EOF) {
+            load.errors++;
+        }
+        uv_read_stop(stream);
+        return;
+    }
+    conn->received_length += (size_t)nread;
+    if (conn->received_length < LOAD_MESSAGE_SIZE) {
+        return;
+    }
+    conn->received_length = 0;
+
+    uint64_t sent;
+    memcpy(&sent, conn->received, sizeof(sent));
+    if (load.measuring) {
+        load.received++;
+        if (load.sample_count < LOAD_MAX_SAMPLES) {
+            load.samples[load.sample_count++] = uv_hrtime() - sent;
+        }
+    }
+
+    // Echoes come back in order, so this one frees the oldest slot
+    int slot = (int)conn->next_slot;
+    conn->next_slot = (conn->next_slot + 1) % (uint32_t)load.depth;
+    if (conn->writing[slot]) {
+        conn->echoed[slot] = true;
+    } else {
+        load_send(conn, slot);
+    }
+}
+
+static void load_on_connect(uv_connect_t *req, int status) {
+    load_connection *conn = req->data;
+    if (status < 0) {
+        fprintf(stderr, "Connect error %s\n", uv_strerror(status));
+        load.errors++;
+        return;
+    }
+    conn->connected = true;
+    load.connected++;
+    uv_tcp_nodelay(&conn->handle, 1);
+    uv_read_start((uv_stream_t*)&conn->handle, load_alloc, load_on_read);
+    if (load.connected == load.connection_count) {
+        load.sending = true;
+        for (int c = 0; c < load.connection_count; c++) {
+            for (int slot = 0; slot < load.depth; slot++) {
+                load_send(&load.connections[c], slot);
+            }
+        }
+    }
+}
+
+static void load_on_close(uv_handle_t *handle) {
+    load.closed++;
+}
+
+static void load_server_close(uv_handle_t *handle, void *arg) {
+    if (!uv_is_closing(handle)) {
+        uv_close(handle, handle == (uv_handle_t*)&flush_check || handle->data == arg ? NULL :
+                 (naive ? on_close_naive : on_close));
+    }
+}
+
+// Closes the listener, the flush handle and every client, then lets the
+// loop run out
+static void load_server_stop(uv_async_t *async) {
+    uv_walk(async->loop, load_server_close, async);
+}
+
+static void load_server_run(void *arg) {
+    load_server *server = arg;
+    uv_run(&server->loop, UV_RUN_DEFAULT);
+}
+
+static bool load_server_start(load_server *server) {
+    uv_loop_init(&server->loop);
+    server_init(&server->loop);
+    uv_tcp_init(&server->loop, &server->server);
+    uv_async_init(&server->loop, &server->stop, load_server_stop);
+    server->server.data = &server->stop;
+    server->stop.data = &server->stop;
+
+    struct sockaddr_in bind_addr;
+    uv_ip4_addr("127.0.0.1", 0, &bind_addr);
+    int r = uv_tcp_bind(&server->server, (const struct sockaddr*)&bind_addr, 0);
+    if (!r) {
+        r = uv_listen((uv_stream_t*)&server->server, DEFAULT_BACKLOG, on_new_connection);
+    }
+    if (r) {
+        fprintf(stderr, "Listen error %s\n", uv_strerror(r));
+        return false;
+    }
+    struct sockaddr_in bound;
+    int length = sizeof(bound);
+    uv_tcp_getsockname(&server->server, (struct sockaddr*)&bound, &length);
+    server->port = ntohs(bound.sin_port);
+    return uv_thread_create(&server->thread, load_server_run, server) == 0;
+}
+
+static void load_on_warmup(uv_timer_t *timer) {
+    load.measuring = true;
+    load.mallocs_before = stats.mallocs;  // Read across threads; only for the report
+    uv_close((uv_handle_t*)timer, NULL);
+}
+
+static void load_on_finish(uv_timer_t *timer) {
+    load.measuring = false;
+    load.sending = false;
+    for (int c = 0; c < load.connection_count; c++) {
+        uv_close((uv_handle_t*)&load.connections[c].handle, load_on_close);
+    }
+    uv_close((uv_handle_t*)timer, NULL);
+}
+
+static int compare_samples(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Raise the descriptor limit: client and server ends share the process
+static void raise_fd_limit(int needed) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < (rlim_t)needed) {
+        limit.rlim_cur = limit.rlim_max < (rlim_t)needed ? limit.rlim_max : (rlim_t)needed;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+int run_load_test(int connections, int seconds, int depth) {
+    raise_fd_limit(connections * 2 + 64);
+    load.connection_count = connections;
+    load.depth = depth;
+    load.connections = calloc((size_t)connections, sizeof(load_connection));
+    load.samples = malloc(sizeof(uint64_t) * LOAD_MAX_SAMPLES);
+    if (!load.connections || !load.samples) {
+        fprintf(stderr, "Out of memory for %d connections\n", connections);
+        return 1;
+    }
+
+    static load_server server;
+    if (!load_server_start(&server)) {
+        return 1;
+    }
+
+    uv_loop_t *client_loop = uv_default_loop();
+    struct sockaddr_in server_addr;
+    uv_ip4_addr("127.0.0.1", server.port, &server_addr);
+    for (int c = 0; c < connections; c++) {
+        load_connection *conn = &load.connections[c];
+        uv_tcp_init(client_loop, &conn->handle);
+        conn->connect.data = conn;
+        uv_tcp_connect(&conn->connect, &conn->handle, (const struct sockaddr*)&server_addr, load_on_connect);
+    }
+
+    // Timers start once every connection is up
+    while (load.connected + (int)load.errors < connections && uv_run(client_loop, UV_RUN_ONCE)) {
+    }
+    uv_timer_t warmup;
+    uv_timer_t finish;
+    uv_timer_init(client_loop, &warmup);
+    uv_timer_init(client_loop, &finish);
+    uv_timer_start(&warmup, load_on_warmup, LOAD_WARMUP_MS, 0);
+    uv_timer_start(&finish, load_on_finish, LOAD_WARMUP_MS + (uint64_t)seconds * 1000, 0);
+    uv_run(client_loop, UV_RUN_DEFAULT);
+
+    uv_async_send(&server.stop);
+    uv_thread_join(&server.thread);
+    uv_loop_close(&server.loop);
+    uint64_t steady_mallocs = stats.mallocs - load.mallocs_before;
+
+    qsort(load.samples, (size_t)load.sample_count, sizeof(uint64_t), compare_samples);
+    double p50 = load.sample_count ? load.samples[load.sample_count / 2] / 1e3 : 0.0;
+    double p99 = load.sample_count ? load.samples[(int)(load.sample_count * 0.99)] / 1e3 : 0.0;
+    double max = load.sample_count ? load.samples[load.sample_count - 1] / 1e3 : 0.0;
+
+    printf("Mode:            %s\n", naive ? "naive (malloc per read and write)" : "pooled, batched writes");
+    printf("Connections:     %d (%d connected), %d messages in flight each\n",
+           connections, load.connected, depth);
+    printf("Messages/s:      %.0f\n", load.received / (double)seconds);
+    printf("Round trip:      p50 %.1f us, p99 %.1f us, max %.1f us (%d samples)\n",
+           p50, p99, max, load.sample_count);
+    printf("Server writes:   %llu for %llu reads, %.2f buffers per write\n",
+           (unsigned long long)stats.writes, (unsigned long long)stats.reads,
+           stats.writes ? (double)stats.write_bufs / stats.writes : 0.0);
+    printf("Server mallocs:  %llu after warm-up, %llu in total\n",
+           (unsigned long long)steady_mallocs, (unsigned long long)stats.mallocs);
+    if (!naive) {
+        printf("Pools (peak):    %d buffers, %d write requests, %d clients\n",
+               buffer_pool.peak, request_pool.peak, client_pool.peak);
+    }
+    printf("Errors:          %llu\n", (unsigned long long)load.errors);
+
+    server_destroy();
+    uv_loop_close(client_loop);
+    free(load.connections);
+    free(load.samples);
+    return load.errors == 0 && load.connected == connections ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+    int positional[3] = {LOAD_CONNECTIONS, LOAD_SECONDS, LOAD_DEPTH};
+    int positional_count = 0;
+    bool load_test = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--load") == 0) {
+            load_test = true;
+        } else if (strcmp(argv[i], "--naive") == 0) {
+            naive = true;
+        } else if (positional_count < 3 && atoi(argv[i]) > 0) {
+            positional[positional_count++] = atoi(argv[i]);
+        }
+    }
+    if (load_test) {
+        int depth = positional[2] < LOAD_MAX_DEPTH ? positional[2] : LOAD_MAX_DEPTH;
+        return run_load_test(positional[0], positional[1], depth);
+    }
+
     loop = uv_default_loop();
+    server_init(loop);
 
     uv_tcp_t server;
     uv_tcp_init(loop, &server);
@@ -69,6 +644,6 @@ int main() {
         return 1;
     }
 
-    printf("Server running on port %d\n", DEFAULT_PORT);
+    printf("Server running on port %d%s\n", DEFAULT_PORT, naive ? " (naive buffers)" : "");
     return uv_run(loop, UV_RUN_DEFAULT);
 }